@@ -18,9 +18,14 @@
 #include "zbxjson.h"
 #include "module.h"
 
+#define ZBX_AGENT_CAPABILITY_BATCH	0x01
+
 int	zbx_get_agent_protocol_version_int(const char *version_str);
 void	zbx_agent_prepare_request(struct zbx_json *j, const char *key, int timeout);
+void	zbx_agent_request_add_key(struct zbx_json *j, const char *key, int timeout);
 int	zbx_agent_handle_response(char *buffer, size_t read_bytes, ssize_t received_len, const char *addr,
 		AGENT_RESULT *result, int *version);
+int	zbx_agent_handle_batch_response(char *buffer, ssize_t received_len, const char *addr, AGENT_RESULT **results,
+		int *errcodes, unsigned char *deferred, int num, int *version, unsigned char *capabilities);
 
 #endif
@@ -921,6 +921,8 @@ void	zbx_dc_config_delete_autoreg_host(const zbx_vector_str_t *autoreg_hosts);
 void	zbx_dc_requeue_items(const zbx_uint64_t *itemids, const int *lastclocks, const int *errcodes, size_t num);
 void	zbx_dc_poller_requeue_items(const zbx_uint64_t *itemids, const int *lastclocks,
 		const int *errcodes, size_t num, unsigned char poller_type, int *nextcheck);
+void	zbx_dc_poller_requeue_items_at(const zbx_uint64_t *itemids, const int *nextchecks, size_t num,
+		unsigned char poller_type, int *nextcheck);
 #ifdef HAVE_OPENIPMI
 void	zbx_dc_requeue_unreachable_items(zbx_uint64_t *itemids, size_t itemids_num);
 #endif
@@ -946,6 +948,32 @@ int	zbx_dc_get_host_inventory_value_by_hostid(zbx_uint64_t hostid, char **replac
 void	*zbx_dc_config_get_stats(int request);
 
 int	zbx_dc_config_get_last_sync_time(void);
+
+/* configuration cache sync stages applied under configuration cache write lock */
+typedef enum
+{
+	ZBX_DC_SYNC_STAGE_CONFIG = 0,
+	ZBX_DC_SYNC_STAGE_MACROS,
+	ZBX_DC_SYNC_STAGE_HOSTS,
+	ZBX_DC_SYNC_STAGE_ITEMS,
+	ZBX_DC_SYNC_STAGE_TRIGGERS,
+	ZBX_DC_SYNC_STAGE_FINISH,
+	ZBX_DC_SYNC_STAGE_COUNT
+}
+zbx_dc_sync_stage_t;
+
+typedef struct
+{
+	zbx_uint64_t	syncs;		/* number of configuration syncs passing the stage           */
+	zbx_uint64_t	locks;		/* number of write lock acquisitions, including lock slices  */
+	double		last;		/* write lock hold time of the stage during the last sync    */
+	double		max;		/* the longest single write lock hold                        */
+	double		total;		/* total write lock hold time                                */
+}
+zbx_dc_sync_lock_stats_t;
+
+const char	*zbx_dc_sync_stage_string(zbx_dc_sync_stage_t stage);
+void	zbx_dc_get_sync_lock_stats(zbx_dc_sync_lock_stats_t *stats);
 int	zbx_dc_config_get_proxypoller_hosts(zbx_dc_proxy_t *proxies, int max_hosts);
 int	zbx_dc_config_get_proxypoller_nextcheck(void);
 
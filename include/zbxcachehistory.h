@@ -20,6 +20,7 @@
 #include "zbxcacheconfig.h"
 #include "zbxshmem.h"
 #include "zbxipcservice.h"
+#include "zbxmutexs.h"
 
 #define ZBX_HC_PROXYQUEUE_STATE_NORMAL 0
 #define ZBX_HC_PROXYQUEUE_STATE_WAIT 1
@@ -32,6 +33,9 @@
 #define ZBX_HC_TIMER_MAX	(ZBX_HC_SYNC_MAX / 2)
 #define ZBX_HC_TIMER_SOFT_MAX	(ZBX_HC_TIMER_MAX - 10)
 
+/* the maximum number of history cache shards, the first shard uses ZBX_MUTEX_CACHE lock */
+#define ZBX_HC_SHARDS_MAX	(ZBX_MUTEX_CACHE_SHARDS + 1)
+
 #define ZBX_SYNC_DONE		0
 #define	ZBX_SYNC_MORE		1
 
@@ -48,16 +52,28 @@ typedef struct
 }
 zbx_dc_stats_t;
 
+/* the history cache shard statistics */
+typedef struct
+{
+	zbx_uint64_t	lock_num;	/* the number of times shard lock was acquired */
+	double		lock_wait;	/* the total time spent waiting for shard lock, in seconds */
+	int		history_num;	/* the number of cached values */
+}
+zbx_hc_shard_stats_t;
+
 /* the write cache statistics */
 typedef struct
 {
-	zbx_dc_stats_t	stats;
-	zbx_uint64_t	history_free;
-	zbx_uint64_t	history_total;
-	zbx_uint64_t	index_free;
-	zbx_uint64_t	index_total;
-	zbx_uint64_t	trend_free;
-	zbx_uint64_t	trend_total;
+	zbx_dc_stats_t		stats;
+	zbx_uint64_t		history_free;
+	zbx_uint64_t		history_total;
+	zbx_uint64_t		index_free;
+	zbx_uint64_t		index_total;
+	zbx_uint64_t		trend_free;
+	zbx_uint64_t		trend_total;
+	double			lock_wait;
+	int			shards_num;
+	zbx_hc_shard_stats_t	shards[ZBX_HC_SHARDS_MAX];
 }
 zbx_wcache_info_t;
 
@@ -87,6 +103,9 @@ zbx_wcache_info_t;
 #define ZBX_STATS_HISTORY_INDEX_PUSED	20
 #define ZBX_STATS_HISTORY_INDEX_PFREE	21
 #define ZBX_STATS_HISTORY_BIN_COUNTER	22
+#define ZBX_STATS_HISTORY_LOCK_WAIT	23
+/* lock wait time of the n-th shard is requested with ZBX_STATS_HISTORY_SHARD_LOCK_WAIT + n */
+#define ZBX_STATS_HISTORY_SHARD_LOCK_WAIT	100
 
 /* 'zbx_pp_value_opt_t' element 'flags' values */
 #define ZBX_PP_VALUE_OPT_NONE		0x0000	/* 'zbx_pp_value_opt_t' has no data */
@@ -114,6 +133,8 @@ zbx_pp_value_opt_t;
 void	zbx_pp_value_opt_clear(zbx_pp_value_opt_t *opt);
 void	zbx_dc_get_stats_all(zbx_wcache_info_t *wcache_info);
 void	*zbx_dc_get_stats(int request);
+void	zbx_dc_add_history_storage_stats(const zbx_history_storage_stats_t *stats);
+void	zbx_dc_get_history_storage_stats(zbx_history_storage_stats_t *stats);
 void	zbx_trend_add_new_items(const zbx_vector_uint64_t *itemids);
 void	zbx_dc_update_trends(zbx_vector_uint64_pair_t *trends_diff);
 void	zbx_db_flush_trends(ZBX_DC_TREND *trends, int *trends_num, zbx_vector_uint64_pair_t *trends_diff);
@@ -137,9 +158,10 @@ void	zbx_dc_add_history(zbx_uint64_t itemid, unsigned char item_value_type, unsi
 void	zbx_dc_add_history_variant(zbx_uint64_t itemid, unsigned char value_type, unsigned char item_flags,
 		zbx_variant_t *value, zbx_timespec_t ts, const zbx_pp_value_opt_t *value_opt);
 size_t	zbx_dc_flush_history(void);
+void	zbx_hc_set_preferred_shard(int process_num);
 void	zbx_hc_pop_items(zbx_vector_hc_item_ptr_t *history_items);
 void	zbx_hc_get_item_values(zbx_dc_history_t *history, zbx_vector_hc_item_ptr_t *history_items);
-void	zbx_hc_push_items(zbx_vector_hc_item_ptr_t *history_items);
+void	zbx_hc_push_items(zbx_vector_hc_item_ptr_t *history_items, int history_num);
 int	zbx_hc_queue_get_size(void);
 int	zbx_hc_get_history_compression_age(void);
 double	zbx_hc_mem_pused(void);
@@ -149,8 +171,8 @@ typedef void (*zbx_history_sync_f)(int *values_num, int *triggers_num, const zbx
 		zbx_ipc_async_socket_t *rtc, int config_history_storage_pipelines, int *more);
 
 int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history_sync_f sync_history,
-		zbx_uint64_t history_cache_size, zbx_uint64_t history_index_cache_size, zbx_uint64_t *trends_cache_size,
-		char **error);
+		zbx_uint64_t history_cache_size, zbx_uint64_t history_index_cache_size, int history_cache_shards,
+		zbx_uint64_t *trends_cache_size, char **error);
 
 void	zbx_free_database_cache(int sync, const zbx_events_funcs_t *events_cbs, int config_history_storage_pipelines);
 
@@ -168,11 +190,6 @@ int	zbx_hc_proxyqueue_dequeue(zbx_uint64_t proxyid);
 void	zbx_hc_proxyqueue_clear(void);
 void	zbx_dbcache_lock(void);
 void	zbx_dbcache_unlock(void);
-void	zbx_dbcache_set_history_num(int num);
-int	zbx_dbcache_get_history_num(void);
-
-zbx_shmem_info_t	*zbx_dbcache_get_hc_mem(void);
-
 void	zbx_dbcache_setproxyqueue_state(int proxyqueue_state);
 int	zbx_dbcache_getproxyqueue_state(void);
 #endif
@@ -45,6 +45,9 @@
  *   either zbx_history_record_vector_destroy() function (free the zbx_vc_get_values()
  *   call output) or zbx_history_record_clear() function (free the zbx_vc_get_value() call output).
  *
+ *   Aggregates of numeric items (count, sum, avg, min, max) can be calculated with
+ *   zbx_vc_get_aggregate() function directly over cached data, without copying the values.
+ *
  * Locking
  *
  *   The cache ensures synchronization between processes by using automatic locks whenever
@@ -59,6 +62,13 @@
 /* indicates that all values from database are cached */
 #define ZBX_ITEM_STATUS_CACHED_ALL	1
 
+/* aggregate functions calculated by zbx_vc_get_aggregate() */
+#define ZBX_VC_AGGR_COUNT	0
+#define ZBX_VC_AGGR_SUM		1
+#define ZBX_VC_AGGR_AVG		2
+#define ZBX_VC_AGGR_MIN		3
+#define ZBX_VC_AGGR_MAX		4
+
 /* the cache statistics */
 typedef struct
 {
@@ -73,6 +83,14 @@ typedef struct
 	zbx_uint64_t	total_size;
 	zbx_uint64_t	free_size;
 
+	/* the number of values stored in compressed chunks and the memory used by these chunks */
+	zbx_uint64_t	compressed_values;
+	zbx_uint64_t	compressed_size;
+
+	/* the ratio of the memory required to store compressed values uncompressed against   */
+	/* compressed_size, 0 if there are no compressed values                               */
+	double		compression_ratio;
+
 	/* value cache operating mode - see ZBX_VC_MODE_* defines */
 	int		mode;
 }
@@ -107,6 +125,12 @@ int	zbx_vc_get_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_
 int	zbx_vc_get_value(zbx_uint64_t itemid, unsigned char value_type, const zbx_timespec_t *ts,
 		zbx_history_record_t *value);
 
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, unsigned char value_type, int seconds, int count,
+		const zbx_timespec_t *ts, int func, zbx_history_value_t *value, int *values_num);
+
+int	zbx_vc_get_values_dbl(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_dbl_t *values, int seconds,
+		int count, const zbx_timespec_t *ts);
+
 int	zbx_vc_add_values(zbx_vector_dc_history_ptr_t *history, int *ret_flush, int config_history_storage_pipelines);
 
 int	zbx_vc_get_statistics(zbx_vc_stats_t *stats);
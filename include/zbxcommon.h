@@ -250,6 +250,9 @@ const char	*get_program_type_string(unsigned char program_type);
 #define ZBX_PROGRAM_VARIANT_AGENT	1
 #define ZBX_PROGRAM_VARIANT_AGENT2	2
 
+/* the maximum sum of key timeouts in one passive checks request, agents defer keys exceeding it */
+#define ZBX_AGENT_BATCH_TIMEOUT_MAX	SEC_PER_MIN
+
 /* process type */
 #define ZBX_PROCESS_TYPE_POLLER			0
 #define ZBX_PROCESS_TYPE_UNREACHABLE		1
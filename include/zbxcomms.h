@@ -17,6 +17,7 @@
 
 #include "zbxalgo.h"
 #include "zbxtime.h"
+#include "zbxcompress.h"
 
 #define ZBX_IPV4_MAX_CIDR_PREFIX	32	/* max number of bits in IPv4 CIDR prefix */
 #define ZBX_IPV6_MAX_CIDR_PREFIX	128	/* max number of bits in IPv6 CIDR prefix */
@@ -217,6 +218,7 @@ typedef struct
 	unsigned char	expect;
 	int		protocol_version;
 	size_t		allocated;
+	zbx_uncompress_stream_t	*stream;
 }
 zbx_tcp_recv_context_t;
 
@@ -259,6 +261,9 @@ int	zbx_socket_tls_connect(zbx_socket_t *s, unsigned int tls_connect, const char
 #define ZBX_TCP_PROTOCOL		0x01
 #define ZBX_TCP_COMPRESS		0x02
 #define ZBX_TCP_LARGE			0x04
+#define ZBX_TCP_COMPRESS_ZSTD		0x08	/* compressed data uses zstd, valid only with ZBX_TCP_COMPRESS */
+
+#define ZBX_TCP_COMPRESS_FLAGS		(ZBX_TCP_COMPRESS | ZBX_TCP_COMPRESS_ZSTD)
 
 #define ZBX_TCP_SEC_UNENCRYPTED		1		/* do not use encryption with this socket */
 #define ZBX_TCP_SEC_TLS_PSK		2		/* use TLS with pre-shared key (PSK) with this socket */
@@ -275,6 +280,9 @@ const char	*zbx_tcp_connection_type_name(unsigned int type);
 #define zbx_tcp_send_bytes_to(s, d, len, timeout)	zbx_tcp_send_ext((s), (d), len, 0, ZBX_TCP_PROTOCOL, timeout)
 #define zbx_tcp_send_raw(s, d)				zbx_tcp_send_ext((s), (d), strlen(d), 0, 0, 0)
 
+unsigned char	zbx_tcp_compress_flags(int peer_zstd);
+int	zbx_tcp_compress(unsigned char flags, const char *in, size_t size_in, char **out, size_t *size_out);
+
 int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, size_t reserved, unsigned char flags,
 		int timeout);
 int	zbx_tcp_send_context_init(const char *data, size_t len, size_t reserved, unsigned char flags,
@@ -24,7 +24,8 @@ int	zbx_connect_to_server(zbx_socket_t *sock, const char *source_ip, zbx_vector_
 void	zbx_disconnect_from_server(zbx_socket_t *sock);
 
 int	zbx_get_data_from_server(zbx_socket_t *sock, char **buffer, size_t buffer_size, size_t reserved, char **error);
-int	zbx_put_data_to_server(zbx_socket_t *sock, char **buffer, size_t buffer_size, size_t reserved, char **error);
+int	zbx_put_data_to_server(zbx_socket_t *sock, char **buffer, size_t buffer_size, size_t reserved,
+		unsigned char compress_flags, char **error);
 
 int	zbx_send_response_ext(zbx_socket_t *sock, int result, const char *info, const char *version, int protocol,
 		int timeout);
@@ -53,4 +54,7 @@ int	zbx_comms_exchange_with_redirect(const char *source_ip, zbx_vector_addr_ptr_
 
 void	zbx_addrs_failover(zbx_vector_addr_ptr_t *addrs);
 
+void	zbx_tcp_zstd_advertise(struct zbx_json *j);
+int	zbx_tcp_zstd_accepted(const struct zbx_json_parse *jp);
+
 #endif // ZABBIX_COMMSHIGH_H
@@ -277,6 +277,8 @@ typedef struct
 	int				batch_size;
 	/* the last id assigned by autoincrement */
 	zbx_uint64_t			lastid;
+	/* 1 - rows are loaded with native bulk load protocol instead of insert statements */
+	int				bulk_load;
 }
 zbx_db_insert_t;
 
@@ -321,6 +323,27 @@ void	zbx_db_insert_autoincrement(zbx_db_insert_t *db_insert, const char *field_n
 zbx_uint64_t	zbx_db_insert_get_lastid(zbx_db_insert_t *self);
 void	zbx_db_insert_clean(zbx_db_insert_t *db_insert);
 void	zbx_db_insert_set_batch_size(zbx_db_insert_t *self, int batch_size);
+void	zbx_db_insert_set_bulk_load(zbx_db_insert_t *self);
+
+/* prepared statement support */
+typedef struct zbx_db_stmt	zbx_db_stmt_t;
+
+typedef struct
+{
+	zbx_uint64_t	hits;		/* statements found in connection cache */
+	zbx_uint64_t	misses;		/* statements added to connection cache */
+	zbx_uint64_t	evictions;	/* least recently used statements removed from full cache */
+	zbx_uint64_t	prepares;	/* statements prepared by database server */
+	zbx_uint64_t	executions;	/* prepared statement executions */
+}
+zbx_db_stmt_stats_t;
+
+zbx_db_stmt_t	*zbx_dbconn_prepare(zbx_dbconn_t *db, const char *sql, ...);
+zbx_db_stmt_t	*zbx_dbconn_vprepare(zbx_dbconn_t *db, const char *sql, va_list args);
+void	zbx_db_stmt_bind(zbx_db_stmt_t *stmt, ...);
+int	zbx_db_stmt_execute(zbx_db_stmt_t *stmt);
+zbx_db_result_t	zbx_db_stmt_select(zbx_db_stmt_t *stmt);
+void	zbx_db_get_stmt_stats(zbx_db_stmt_stats_t *stats);
 
 void	zbx_dbconn_extract_version_info(zbx_dbconn_t *db, struct zbx_db_version_info_t *version_info);
 
@@ -451,6 +474,7 @@ int	zbx_db_execute_once(const char *fmt, ...);
 zbx_db_result_t	zbx_db_select(const char *fmt, ...);
 zbx_db_result_t	zbx_db_vselect(const char *fmt, va_list args);
 zbx_db_result_t	zbx_db_select_n(const char *query, int n);
+zbx_db_stmt_t	*zbx_db_prepare(const char *sql, ...);
 void	zbx_db_insert_prepare_dyn(zbx_db_insert_t *db_insert, const zbx_db_table_t *table,
 		const zbx_db_field_t **fields, int fields_num);
 void	zbx_db_insert_prepare(zbx_db_insert_t *self, const char *table, ...);
@@ -59,6 +59,14 @@ int	zbx_proxy_get_host_active_availability(struct zbx_json *j);
 
 int	zbx_proxy_get_delay(zbx_uint64_t lastid);
 
+typedef struct zbx_history_columns zbx_history_columns_t;
+
+zbx_history_columns_t	*zbx_history_columns_create(void);
+void	zbx_history_columns_free(zbx_history_columns_t *columns);
+void	zbx_history_columns_append(zbx_history_columns_t *columns, zbx_uint64_t itemid, const zbx_agent_value_t *value);
+size_t	zbx_history_columns_size(const zbx_history_columns_t *columns);
+void	zbx_history_columns_export(const zbx_history_columns_t *columns, const char *tag, struct zbx_json *j);
+
 int	zbx_process_history_data(zbx_history_recv_item_t *items, zbx_agent_value_t *values, int *errcodes,
 		size_t values_num, zbx_proxy_suppress_t *nodata_win);
 
@@ -26,6 +26,12 @@ typedef struct
 	char	*name;
 	FILE	*file;
 	int	missing;
+
+	/* records buffered for the background export writer */
+	char	*batch;
+	size_t	batch_alloc;
+	size_t	batch_offset;
+	int	batch_records;
 }
 zbx_export_file_t;
 
@@ -36,8 +42,24 @@ typedef struct
 	char		*dir;
 	char		*type;
 	zbx_uint64_t	file_size;
+	int		writer;		/* 1 - records are written by background writer thread */
+	zbx_uint64_t	queue_size;	/* maximum size of data queued for background writer per process */
+	int		compression;	/* 1 - gzip compress export files */
 } zbx_config_export_t;
 
+/* background export writer statistics */
+typedef struct
+{
+	zbx_uint64_t	written_records;
+	zbx_uint64_t	written_bytes;
+	zbx_uint64_t	dropped_records;
+	zbx_uint64_t	dropped_bytes;
+	zbx_uint64_t	waits;		/* the number of times exporting process waited for free queue space */
+	double		wait_time;	/* the total time spent waiting for free queue space, in seconds */
+	zbx_uint64_t	queued_bytes;	/* the size of currently queued data */
+}
+zbx_export_stats_t;
+
 int	zbx_init_library_export(zbx_config_export_t *zbx_config_export, char **error);
 void	zbx_deinit_library_export(void);
 
@@ -45,6 +67,7 @@ int	zbx_validate_export_type(char *export_type, uint32_t *export_mask);
 int	zbx_is_export_enabled(uint32_t flags);
 int	zbx_has_export_dir(void);
 void	zbx_export_deinit(zbx_export_file_t *file);
+int	zbx_export_get_stats(zbx_export_stats_t *stats);
 
 zbx_export_file_t	*zbx_problems_export_init(zbx_get_export_file_f get_export_file_cb, const char *process_name,
 		int process_num);
@@ -48,9 +48,24 @@ void	zbx_history_value2variant(const zbx_history_value_t *value, unsigned char v
 #define zbx_history_record_vector_create(vector)	zbx_vector_history_record_create(vector)
 
 int	zbx_history_init(const char *config_history_storage_url, const char *config_history_storage_opts,
-		int config_log_slow_queries, char **error);
+		int config_log_slow_queries, int config_history_storage_streams, int config_history_storage_compression,
+		char **error);
 void	zbx_history_destroy(void);
 
+/* history storage (Elasticsearch) write statistics */
+typedef struct
+{
+	zbx_uint64_t	requests;	/* the number of sent bulk requests */
+	zbx_uint64_t	documents;	/* the number of written documents */
+	zbx_uint64_t	bytes;		/* the number of sent request body bytes */
+	zbx_uint64_t	retried;	/* the number of resent documents */
+	zbx_uint64_t	failed;		/* the number of documents rejected by history storage */
+	double		time;		/* the total time of bulk requests, in seconds */
+}
+zbx_history_storage_stats_t;
+
+int	zbx_history_get_storage_stats(zbx_history_storage_stats_t *stats);
+
 typedef struct
 {
 	zbx_uint64_t		itemid;
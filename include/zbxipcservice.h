@@ -26,6 +26,12 @@
 
 #define ZBX_IPC_WAIT_FOREVER	-1
 
+typedef struct zbx_ipc_rx_pool zbx_ipc_rx_pool_t;
+typedef struct zbx_ipc_shm_ring zbx_ipc_shm_ring_t;
+
+/* the default size of shared memory ring used to send client messages, see zbx_ipc_service_enable_shm() */
+#define ZBX_IPC_SHM_RING_SIZE_DEFAULT	(256 * ZBX_KIBIBYTE)
+
 typedef struct
 {
 	/* the message code */
@@ -36,6 +42,9 @@ typedef struct
 
 	/* the data */
 	unsigned char	*data;
+
+	/* the pooled receive buffer holding data, NULL if data is allocated separately */
+	zbx_ipc_rx_pool_t	*pool;
 }
 zbx_ipc_message_t;
 
@@ -50,6 +59,9 @@ typedef struct
 	unsigned char	rx_buffer[ZBX_IPC_SOCKET_BUFFER_SIZE];
 	zbx_uint32_t	rx_buffer_bytes;
 	zbx_uint32_t	rx_buffer_offset;
+
+	/* shared memory ring for outgoing messages, NULL if messages are written to socket */
+	zbx_ipc_shm_ring_t	*tx_ring;
 }
 zbx_ipc_socket_t;
 
@@ -76,6 +88,12 @@ typedef struct
 
 	/* the clients with messages */
 	zbx_queue_ptr_t			clients_recv;
+
+	/* receive client messages into pooled buffers, see zbx_ipc_service_enable_rx_pool() */
+	unsigned char			rx_pool;
+
+	/* the size of shared memory rings offered to clients, 0 if disabled (see zbx_ipc_service_enable_shm()) */
+	zbx_uint32_t			shm_ring_size;
 }
 zbx_ipc_service_t;
 
@@ -97,6 +115,8 @@ int	zbx_ipc_service_recv(zbx_ipc_service_t *service, const zbx_timespec_t *timeo
 		zbx_ipc_message_t **message);
 void	zbx_ipc_service_alert(zbx_ipc_service_t *service);
 void	zbx_ipc_service_close(zbx_ipc_service_t *service);
+void	zbx_ipc_service_enable_rx_pool(zbx_ipc_service_t *service);
+void	zbx_ipc_service_enable_shm(zbx_ipc_service_t *service, zbx_uint32_t ring_size);
 
 int	zbx_ipc_client_send(zbx_ipc_client_t *client, zbx_uint32_t code, const unsigned char *data, zbx_uint32_t size);
 void	zbx_ipc_client_close(zbx_ipc_client_t *client);
@@ -116,6 +136,7 @@ int	zbx_ipc_socket_write(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const uns
 		zbx_uint32_t size);
 int	zbx_ipc_socket_read(zbx_ipc_socket_t *csocket, zbx_ipc_message_t *message);
 int	zbx_ipc_socket_connected(const zbx_ipc_socket_t *csocket);
+int	zbx_ipc_socket_enable_shm(zbx_ipc_socket_t *csocket);
 
 int	zbx_ipc_async_socket_open(zbx_ipc_async_socket_t *asocket, const char *service_name, int timeout, char **error);
 void	zbx_ipc_async_socket_close(zbx_ipc_async_socket_t *asocket);
@@ -63,6 +63,7 @@
 #define ZBX_PROTO_TAG_VERSION			"version"
 #define ZBX_PROTO_TAG_INTERFACE_AVAILABILITY	"interface availability"
 #define ZBX_PROTO_TAG_HISTORY_DATA		"history data"
+#define ZBX_PROTO_TAG_HISTORY_COLUMNS		"history columns"
 #define ZBX_PROTO_TAG_DISCOVERY_DATA		"discovery data"
 #define ZBX_PROTO_TAG_AUTOREGISTRATION		"auto registration"
 #define ZBX_PROTO_TAG_MORE			"more"
@@ -168,6 +169,8 @@
 #define ZBX_PROTO_TAG_CLIENTIP			"clientip"
 #define ZBX_PROTO_TAG_ITEM_TAGS			"item_tags"
 #define ZBX_PROTO_TAG_HISTORY_UPLOAD		"upload"
+#define ZBX_PROTO_TAG_HISTORY_FORMAT		"history_format"
+#define ZBX_PROTO_TAG_ZSTD			"zstd"
 #define ZBX_PROTO_TAG_DASHBOARDID		"dashboardid"
 #define ZBX_PROTO_TAG_USERID			"userid"
 #define ZBX_PROTO_TAG_PERIOD			"period"
@@ -227,11 +230,14 @@
 #define ZBX_PROTO_TAG_AUTH			"auth"
 #define ZBX_PROTO_TAG_LEASE_DURATION		"lease_duration"
 #define ZBX_PROTO_TAG_PREPROC			"preproc"
+#define ZBX_PROTO_TAG_CAPABILITIES		"capabilities"
+#define ZBX_PROTO_TAG_DEFERRED			"deferred"
 
 #define ZBX_PROTO_VALUE_FAILED		"failed"
 #define ZBX_PROTO_VALUE_SUCCESS		"success"
 
 #define ZBX_PROTO_VALUE_GET_PASSIVE_CHECKS	"passive checks"
+#define ZBX_PROTO_VALUE_CAPABILITY_BATCH	"batch"
 #define ZBX_PROTO_VALUE_GET_ACTIVE_CHECKS	"active checks"
 #define ZBX_PROTO_VALUE_PROXY_CONFIG		"proxy config"
 #define ZBX_PROTO_VALUE_PROXY_HEARTBEAT		"proxy heartbeat"
@@ -263,6 +269,8 @@
 #define ZBX_PROTO_VALUE_HISTORY_UPLOAD_ENABLED	"enabled"
 #define ZBX_PROTO_VALUE_HISTORY_UPLOAD_DISABLED	"disabled"
 
+#define ZBX_PROTO_VALUE_HISTORY_FORMAT_COLUMNS	"columns"
+
 #define ZBX_PROTO_VALUE_REPORT_TEST		"report.test"
 
 #define ZBX_PROTO_VALUE_HISTORY_PUSH		"history.push"
@@ -406,6 +414,8 @@ typedef struct zbx_jsonpath_index zbx_jsonpath_index_t;
 int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath);
 int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output);
 int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const char *path, char **output);
+int	zbx_jsonobj_query_path(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const zbx_jsonpath_t *jsonpath,
+		char **output);
 void	zbx_jsonpath_clear(zbx_jsonpath_t *jsonpath);
 
 zbx_jsonpath_index_t	*zbx_jsonpath_index_create(char **error);
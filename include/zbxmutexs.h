@@ -30,6 +30,9 @@ typedef HANDLE zbx_mutex_t;
 #	define zbx_mutex_lock(mutex)		__zbx_mutex_lock(__FILE__, __LINE__, mutex)
 #	define zbx_mutex_unlock(mutex)		__zbx_mutex_unlock(__FILE__, __LINE__, mutex)
 #else	/* not _WINDOWS */
+/* the number of mutexes reserved for history cache shards (except the first one using ZBX_MUTEX_CACHE) */
+#define ZBX_MUTEX_CACHE_SHARDS	15
+
 typedef enum
 {
 	ZBX_MUTEX_LOG = 0,
@@ -53,6 +56,8 @@ typedef enum
 	ZBX_MUTEX_PROXY_BUFFER,
 	ZBX_MUTEX_VPS_MONITOR,
 	/* NOTE: Do not forget to sync changes here with mutex names in diag_add_locks_info()! */
+	ZBX_MUTEX_CACHE_SHARD,
+	ZBX_MUTEX_CACHE_SHARD_LAST = ZBX_MUTEX_CACHE_SHARD + ZBX_MUTEX_CACHE_SHARDS - 1,
 	ZBX_MUTEX_COUNT
 }
 zbx_mutex_name_t;
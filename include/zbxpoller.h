@@ -99,16 +99,22 @@ typedef struct zbx_snmp_context	zbx_snmp_context_t;
 void	*zbx_async_check_snmp_get_arg(zbx_snmp_context_t *snmp_context);
 
 zbx_dc_item_context_t	*zbx_async_check_snmp_get_item_context(zbx_snmp_context_t *snmp_context);
+zbx_dc_item_context_t	*zbx_async_check_snmp_get_batch_items(zbx_snmp_context_t *snmp_context, int *num);
 
 char	*zbx_async_check_snmp_get_reverse_dns(zbx_snmp_context_t *snmp_context);
 void	zbx_async_check_snmp_clean(zbx_snmp_context_t *snmp_context);
 int	zbx_async_check_snmp(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_async_task_clear_cb_t clear_cb,
 		void *arg, void *arg_action, struct event_base *base, struct evdns_base *dnsbase,
 		const char *config_source_ip, zbx_async_resolve_reverse_dns_t resolve_reverse_dns, int retries);
+int	zbx_async_check_snmp_get_values(zbx_dc_item_t **items, AGENT_RESULT **results, int *errcodes, int num,
+		zbx_async_task_clear_cb_t clear_cb, void *arg, void *arg_action, struct event_base *base,
+		struct evdns_base *dnsbase, const char *config_source_ip, int retries);
 
 void	zbx_set_snmp_bulkwalk_options(const char *progname);
 #endif
 
+#define ZBX_MAX_AGENT_BATCH_ITEMS	32
+
 typedef struct
 {
 	zbx_dc_item_context_t		item;
@@ -128,6 +134,10 @@ typedef struct
 	zbx_async_rdns_step_t		rdns_step;
 	char				*reverse_dns;
 	struct zbx_json			j;
+	zbx_dc_item_context_t		*batch_items;	/* items requested together with the first item */
+	unsigned char			*batch_deferred;	/* flags of batch items deferred by agent */
+	int				batch_items_num;
+	unsigned char			capabilities;	/* ZBX_AGENT_CAPABILITY_* reported by agent */
 }
 zbx_agent_context;
 
@@ -136,6 +146,9 @@ void	zbx_async_check_agent_clean(zbx_agent_context *agent_context);
 int	zbx_async_check_agent(zbx_dc_item_t *item, AGENT_RESULT *result,  zbx_async_task_clear_cb_t clear_cb,
 		void *arg, void *arg_action, struct event_base *base, struct evdns_base *dnsbase,
 		const char *config_source_ip, zbx_async_resolve_reverse_dns_t resolve_reverse_dns);
+int	zbx_async_check_agent_batch(zbx_dc_item_t **items, AGENT_RESULT **results, int num,
+		zbx_async_task_clear_cb_t clear_cb, void *arg, void *arg_action, struct event_base *base,
+		struct evdns_base *dnsbase, const char *config_source_ip);
 
 typedef struct zbx_async_manager	zbx_async_manager_t;
 
@@ -164,8 +177,16 @@ typedef struct
 	struct event_base	*base;
 	struct evdns_base	*dnsbase;
 	zbx_hashset_t		interfaces;
+	zbx_hashset_t		batch_interfaces;	/* interfaces of agents supporting batch requests */
+	zbx_hashset_t		deferred_items;		/* items deferred by agent, to be checked one by one */
+#ifdef HAVE_NETSNMP
+	zbx_hashset_t		snmp_batches;		/* SNMP batch requests in flight per interface */
+#endif
 #ifdef HAVE_LIBCURL
 	CURLM			*curl_handle;
+	CURLSH			*curl_share;
+	int			connections_new;	/* connections opened by HTTP agent checks */
+	int			connections_reused;	/* HTTP agent checks over cached connections */
 #endif
 }
 zbx_poller_config_t;
@@ -77,6 +77,11 @@ void	zbx_pp_step_free(zbx_pp_step_t *step);
 
 ZBX_PTR_VECTOR_DECL(pp_step_ptr, zbx_pp_step_t *)
 
+/* compiled preprocessing steps, the contents are private to preprocessing manager */
+typedef struct zbx_pp_pipeline zbx_pp_pipeline_t;
+
+typedef void (*zbx_pp_pipeline_free_t)(zbx_pp_pipeline_t *pipeline);
+
 typedef struct
 {
 	zbx_uint32_t		refcount;
@@ -97,6 +102,9 @@ typedef struct
 	zbx_pp_process_mode_t	mode;
 	int			history_num;	/* the number of preprocessing steps requiring history */
 	zbx_pp_history_cache_t	*history_cache;	/* the preprocessing history */
+
+	zbx_pp_pipeline_t	*pipeline;	/* compiled steps, NULL if not compiled */
+	zbx_pp_pipeline_free_t	pipeline_free;
 }
 zbx_pp_item_preproc_t;
 
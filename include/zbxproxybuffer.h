@@ -39,7 +39,8 @@ zbx_pb_state_info_t;
 #define ZBX_PB_MODE_HYBRID	2
 
 int	zbx_pb_parse_mode(const char *str, int *mode);
-int	zbx_pb_create(int mode, zbx_uint64_t size, int age, int offline_buffer, char **error);
+int	zbx_pb_create(int mode, zbx_uint64_t size, int age, int offline_buffer, const char *segment_dir,
+		zbx_uint64_t segment_size, zbx_uint64_t segment_total_size, char **error);
 void	zbx_pb_init(void);
 void	zbx_pb_destroy(void);
 
@@ -94,9 +95,14 @@ void	zbx_pb_history_write_meta_value(zbx_pb_history_data_t *data, zbx_uint64_t i
 		const char *value, const zbx_timespec_t *ts, int flags, zbx_uint64_t lastlogsize, int mtime,
 		int timestamp, int logeventid, int severity, const char *source, time_t now);
 
-int	zbx_pb_history_get_rows(struct zbx_json *j, zbx_uint64_t *lastid, int *more);
+#define ZBX_PB_HISTORY_FORMAT_JSON	0
+#define ZBX_PB_HISTORY_FORMAT_COLUMNS	1
+
+int	zbx_pb_history_get_format(const struct zbx_json_parse *jp);
+int	zbx_pb_history_get_rows(struct zbx_json *j, int format, zbx_uint64_t *lastid, int *more);
 
 void	zbx_pb_set_history_lastid(const zbx_uint64_t lastid);
+int	zbx_pb_history_housekeep(int now);
 
 zbx_uint64_t	zbx_pb_history_get_unsent_num(void);
 
@@ -23,6 +23,12 @@
 #define SHMEM_MAX_BUCKET_SIZE		256 /* starting from this size all free chunks are put into the same bucket */
 #define ZBX_SHMEM_BUCKET_COUNT		((SHMEM_MAX_BUCKET_SIZE - ZBX_SHMEM_MIN_BUCKET_SIZE) / 8 + 1)
 
+/* in slab mode objects up to this size are allocated from per size class slabs */
+#define ZBX_SHMEM_SLAB_MAX_OBJECT_SIZE	256
+#define ZBX_SHMEM_SLAB_CLASS_COUNT	(ZBX_SHMEM_SLAB_MAX_OBJECT_SIZE / 8)
+
+typedef struct zbx_shmem_slab_class	zbx_shmem_slab_class_t;
+
 typedef struct
 {
 	void		*base;
@@ -42,6 +48,9 @@ typedef struct
 
 	const char	*mem_descr;
 	const char	*mem_param;
+
+	/* small object size classes, NULL unless slab mode is enabled */
+	zbx_shmem_slab_class_t	*slab_classes;
 }
 zbx_shmem_info_t;
 
@@ -55,6 +64,13 @@ typedef struct
 	unsigned int	chunks_num[ZBX_SHMEM_BUCKET_COUNT];
 	unsigned int	free_chunks;
 	unsigned int	used_chunks;
+
+	/* slab mode statistics, slabs are accounted as used chunks in the above fields */
+	zbx_uint64_t	slabs_size;
+	zbx_uint64_t	slab_objects_size;
+	unsigned int	slabs_num;
+	unsigned int	slab_objects_num;
+	unsigned int	slab_objects_free;
 }
 zbx_shmem_stats_t;
 
@@ -63,6 +79,7 @@ int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *des
 int	zbx_shmem_create_min(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
 		int allow_oom, char **error);
 void	zbx_shmem_destroy(zbx_shmem_info_t *info);
+void	zbx_shmem_slab_enable(zbx_shmem_info_t *info);
 
 #define	zbx_shmem_malloc(info, old, size) __zbx_shmem_malloc(__FILE__, __LINE__, info, old, size)
 #define	zbx_shmem_realloc(info, old, size) __zbx_shmem_realloc(__FILE__, __LINE__, info, old, size)
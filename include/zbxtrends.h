@@ -70,6 +70,8 @@ typedef struct
 	zbx_uint64_t	misses;
 	zbx_uint64_t	items_num;
 	zbx_uint64_t	requests_num;
+	zbx_uint64_t	rollups_num;	/* the number of cached day and month rollups */
+	zbx_uint64_t	rollup_hits;	/* the number of requests calculated from cached rollups */
 }
 zbx_tfc_stats_t;
 
@@ -77,6 +79,7 @@ int	zbx_tfc_init(zbx_uint64_t cache_size, char **error);
 void	zbx_tfc_destroy(void);
 int	zbx_tfc_get_stats(zbx_tfc_stats_t *stats, char **error);
 void	zbx_tfc_invalidate_trends(ZBX_DC_TREND *trends, int trends_num);
+void	zbx_tfc_trends_flushed(void);
 
 int	zbx_baseline_get_data(zbx_uint64_t itemid, unsigned char value_type, time_t now, const char *period,
 		int season_num, zbx_time_unit_t season_unit, int skip, zbx_vector_dbl_t *values,
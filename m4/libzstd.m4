@@ -0,0 +1,100 @@
+# LIBZSTD_CHECK_CONFIG ([DEFAULT-ACTION])
+# ----------------------------------------------------------
+#
+# Checks for zstd.
+#
+# This macro #defines HAVE_ZSTD if required header files are
+# found, and sets @LIBZSTD_LDFLAGS@, @LIBZSTD_CFLAGS@ and
+# @LIBZSTD_LIBS@ to the necessary values.
+#
+# This macro is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+AC_DEFUN([LIBZSTD_TRY_LINK],
+[
+found_libzstd=$1
+AC_LINK_IFELSE([AC_LANG_PROGRAM([[
+#include <zstd.h>
+]], [[
+	ZSTD_CCtx	*cctx;
+
+	cctx = ZSTD_createCCtx();
+	ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+	ZSTD_freeCCtx(cctx);
+]])],[found_libzstd="yes"],[])
+])dnl
+
+AC_DEFUN([LIBZSTD_CHECK_CONFIG],
+[
+	AC_ARG_WITH([libzstd],[
+If you want to use zstd compression in server-proxy communications:
+AS_HELP_STRING([--with-libzstd@<:@=DIR@:>@], [use zstd library @<:@default=no@:>@, DIR is the zstd library install directory.])],
+		[
+			if test "x$withval" = "xno"; then
+				want_libzstd="no"
+			elif test "x$withval" = "xyes"; then
+				want_libzstd="yes"
+			else
+				want_libzstd="yes"
+				LIBZSTD_CFLAGS="-I$withval/include"
+				LIBZSTD_LDFLAGS="-L$withval/lib"
+				_libzstd_dir_set="yes"
+			fi
+		],
+		[want_libzstd=ifelse([$1],,[no],[$1])]
+	)
+
+	if test "x$want_libzstd" = "xyes"; then
+		AC_MSG_CHECKING(for zstd support)
+
+		LIBZSTD_LIBS="-lzstd"
+
+		if test -n "$_libzstd_dir_set" -o -f /usr/include/zstd.h; then
+			found_libzstd="yes"
+		elif test -f /usr/local/include/zstd.h; then
+			LIBZSTD_CFLAGS="-I/usr/local/include"
+			LIBZSTD_LDFLAGS="-L/usr/local/lib"
+			found_libzstd="yes"
+		elif test -f /usr/pkg/include/zstd.h; then
+			LIBZSTD_CFLAGS="-I/usr/pkg/include"
+			LIBZSTD_LDFLAGS="-L/usr/pkg/lib"
+			found_libzstd="yes"
+		else
+			found_libzstd="no"
+		fi
+
+		if test "x$found_libzstd" = "xyes"; then
+			am_save_CFLAGS="$CFLAGS"
+			am_save_LDFLAGS="$LDFLAGS"
+			am_save_LIBS="$LIBS"
+
+			CFLAGS="$CFLAGS $LIBZSTD_CFLAGS"
+			LDFLAGS="$LDFLAGS $LIBZSTD_LDFLAGS"
+			LIBS="$LIBS $LIBZSTD_LIBS"
+
+			LIBZSTD_TRY_LINK([no])
+
+			CFLAGS="$am_save_CFLAGS"
+			LDFLAGS="$am_save_LDFLAGS"
+			LIBS="$am_save_LIBS"
+		fi
+
+		if test "x$found_libzstd" = "xyes"; then
+			AC_DEFINE([HAVE_ZSTD], 1, [Define to 1 if you have the 'zstd' library (-lzstd)])
+			AC_MSG_RESULT(yes)
+		else
+			AC_MSG_RESULT(no)
+		fi
+	fi
+
+	if test "x$found_libzstd" != "xyes"; then
+		LIBZSTD_CFLAGS=""
+		LIBZSTD_LDFLAGS=""
+		LIBZSTD_LIBS=""
+	fi
+
+	AC_SUBST(LIBZSTD_CFLAGS)
+	AC_SUBST(LIBZSTD_LDFLAGS)
+	AC_SUBST(LIBZSTD_LIBS)
+])dnl
@@ -17,6 +17,7 @@ package serverlistener
 import (
 	"encoding/json"
 	"fmt"
+	"sync"
 	"time"
 
 	"golang.zabbix.com/agent2/internal/agent"
@@ -25,7 +26,18 @@ import (
 	"golang.zabbix.com/sdk/log"
 )
 
-const notsupported = "ZBX_NOTSUPPORTED"
+const (
+	notsupported = "ZBX_NOTSUPPORTED"
+
+	// capabilityBatch is reported to servers to announce that multiple keys
+	// can be requested in a single passive checks request.
+	capabilityBatch = "batch"
+
+	// batchTimeoutMax is the maximum sum of key timeouts in a single passive
+	// checks request, keys exceeding it are deferred and must be requested
+	// again by server.
+	batchTimeoutMax = 60
+)
 
 type passiveCheckRequestData struct {
 	Key     string `json:"key"`
@@ -45,11 +57,16 @@ type passiveChecksErrorResponseData struct {
 	Error *string `json:"error"`
 }
 
+type passiveChecksDeferredResponseData struct {
+	Deferred bool `json:"deferred"`
+}
+
 type passiveChecksResponse struct {
-	Version string  `json:"version"`
-	Variant int     `json:"variant"`
-	Data    []any   `json:"data,omitempty"`
-	Error   *string `json:"error,omitempty"`
+	Version      string   `json:"version"`
+	Variant      int      `json:"variant"`
+	Capabilities []string `json:"capabilities"`
+	Data         []any    `json:"data,omitempty"`
+	Error        *string  `json:"error,omitempty"`
 }
 
 type passiveCheck struct {
@@ -69,7 +86,6 @@ func (pc *passiveCheck) formatError(msg string) (data []byte) {
 // be treated as plain text format request.
 func (pc *passiveCheck) handleCheckJSON(data []byte) (errJson error) {
 	var request passiveChecksRequest
-	var timeout int
 	var err error
 
 	errJson = json.Unmarshal(data, &request)
@@ -83,37 +99,17 @@ func (pc *passiveCheck) handleCheckJSON(data []byte) (errJson error) {
 		err = fmt.Errorf("unknown request \"%s\"", request.Request)
 	}
 
-	var response passiveChecksResponse
+	response := passiveChecksResponse{
+		Version:      version.Long(),
+		Variant:      agent.Variant,
+		Capabilities: []string{capabilityBatch},
+	}
 
 	if err != nil {
 		errString := err.Error()
-		response = passiveChecksResponse{
-			Version: version.Long(),
-			Variant: agent.Variant,
-			Error:   &errString,
-		}
+		response.Error = &errString
 	} else {
-		var value *string
-
-		if timeout, err = scheduler.ParseItemTimeoutAny(request.Data[0].Timeout); err == nil {
-			// direct passive check timeout is handled by the scheduler
-			value, err = pc.scheduler.PerformTask(request.Data[0].Key, time.Second*time.Duration(timeout), agent.PassiveChecksClientID)
-		}
-
-		if err != nil {
-			errString := err.Error()
-			response = passiveChecksResponse{
-				Version: version.Long(),
-				Variant: agent.Variant,
-				Data:    []any{passiveChecksErrorResponseData{Error: &errString}},
-			}
-		} else {
-			response = passiveChecksResponse{
-				Version: version.Long(),
-				Variant: agent.Variant,
-				Data:    []any{passiveChecksResponseData{Value: value}},
-			}
-		}
+		response.Data = pc.performChecks(request.Data)
 	}
 
 	out, err := json.Marshal(response)
@@ -129,6 +125,62 @@ func (pc *passiveCheck) handleCheckJSON(data []byte) (errJson error) {
 	return nil
 }
 
+// performChecks executes the requested checks concurrently and returns the
+// response data rows in the order of requested keys. Once the sum of key
+// timeouts exceeds batchTimeoutMax the rest of keys are deferred, as server
+// waits for the response no longer than the sum of timeouts.
+func (pc *passiveCheck) performChecks(requests []passiveCheckRequestData) []any {
+	data := make([]any, len(requests))
+
+	var wg sync.WaitGroup
+
+	timeoutSum := 0
+
+	for i := range requests {
+		timeout, err := scheduler.ParseItemTimeoutAny(requests[i].Timeout)
+		if err != nil {
+			errString := err.Error()
+			data[i] = passiveChecksErrorResponseData{Error: &errString}
+
+			continue
+		}
+
+		if i != 0 && timeoutSum+timeout > batchTimeoutMax {
+			timeoutSum = batchTimeoutMax
+			data[i] = passiveChecksDeferredResponseData{Deferred: true}
+
+			continue
+		}
+
+		timeoutSum += timeout
+
+		wg.Add(1)
+
+		go func(i int, timeout int) {
+			defer wg.Done()
+
+			data[i] = pc.performCheck(&requests[i], timeout)
+		}(i, timeout)
+	}
+
+	wg.Wait()
+
+	return data
+}
+
+func (pc *passiveCheck) performCheck(request *passiveCheckRequestData, timeout int) any {
+	// direct passive check timeout is handled by the scheduler
+	value, err := pc.scheduler.PerformTask(request.Key, time.Second*time.Duration(timeout),
+		agent.PassiveChecksClientID)
+	if err != nil {
+		errString := err.Error()
+
+		return passiveChecksErrorResponseData{Error: &errString}
+	}
+
+	return passiveChecksResponseData{Value: value}
+}
+
 func (pc *passiveCheck) handleCheck(data []byte) {
 	// the timeout is one minute to allow see any timeout problem with passive checks
 	const timeoutForSinglePassiveChecks = time.Minute
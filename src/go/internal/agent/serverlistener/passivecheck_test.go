@@ -15,9 +15,40 @@
 package serverlistener
 
 import (
+	"errors"
+	"sync"
 	"testing"
+	"time"
+
+	"golang.zabbix.com/agent2/internal/agent/scheduler"
 )
 
+// mockScheduler performs passive checks by returning the requested key as
+// value, after the configured delay to make checks finish out of order.
+type mockScheduler struct {
+	scheduler.Scheduler
+	delays   map[string]time.Duration
+	errs     map[string]string
+	mu       sync.Mutex
+	timeouts map[string]time.Duration
+}
+
+func (s *mockScheduler) PerformTask(key string, timeout time.Duration, clientID uint64) (*string, error) {
+	s.mu.Lock()
+	s.timeouts[key] = timeout
+	s.mu.Unlock()
+
+	time.Sleep(s.delays[key])
+
+	if msg, ok := s.errs[key]; ok {
+		return nil, errors.New(msg)
+	}
+
+	value := key
+
+	return &value, nil
+}
+
 func TestFormatError(t *testing.T) {
 	const notsupported = "ZBX_NOTSUPPORTED"
 	const message = "error message"
@@ -39,3 +70,139 @@ func TestFormatError(t *testing.T) {
 		return
 	}
 }
+
+func TestPerformChecks(t *testing.T) {
+	type row struct {
+		value    string
+		err      string
+		deferred bool
+	}
+
+	_, errTimeout := scheduler.ParseItemTimeoutAny(float64(601))
+	if errTimeout == nil {
+		t.Fatalf("expected timeout 601 to be rejected")
+	}
+
+	tests := []struct {
+		name     string
+		requests []passiveCheckRequestData
+		delays   map[string]time.Duration
+		errs     map[string]string
+		want     []row
+		wantRun  map[string]time.Duration
+	}{
+		{
+			"+single key",
+			[]passiveCheckRequestData{{"k1", float64(3)}},
+			nil,
+			nil,
+			[]row{{value: "k1"}},
+			map[string]time.Duration{"k1": 3 * time.Second},
+		},
+		{
+			"+timeout sum equal to limit",
+			[]passiveCheckRequestData{{"k1", float64(20)}, {"k2", "20s"}, {"k3", float64(20)}},
+			nil,
+			nil,
+			[]row{{value: "k1"}, {value: "k2"}, {value: "k3"}},
+			map[string]time.Duration{"k1": 20 * time.Second, "k2": 20 * time.Second, "k3": 20 * time.Second},
+		},
+		{
+			"+keys after exceeded limit are deferred",
+			[]passiveCheckRequestData{{"k1", float64(30)}, {"k2", float64(30)}, {"k3", float64(1)}, {"k4", float64(1)}},
+			nil,
+			nil,
+			[]row{{value: "k1"}, {value: "k2"}, {deferred: true}, {deferred: true}},
+			map[string]time.Duration{"k1": 30 * time.Second, "k2": 30 * time.Second},
+		},
+		{
+			"+key after reached limit is deferred",
+			[]passiveCheckRequestData{{"k1", "1m"}, {"k2", float64(1)}},
+			nil,
+			nil,
+			[]row{{value: "k1"}, {deferred: true}},
+			map[string]time.Duration{"k1": time.Minute},
+		},
+		{
+			"+first key exceeding limit is performed",
+			[]passiveCheckRequestData{{"k1", float64(600)}, {"k2", float64(1)}},
+			nil,
+			nil,
+			[]row{{value: "k1"}, {deferred: true}},
+			map[string]time.Duration{"k1": 600 * time.Second},
+		},
+		{
+			"+invalid timeout is not counted",
+			[]passiveCheckRequestData{{"k1", float64(601)}, {"k2", float64(60)}},
+			nil,
+			nil,
+			[]row{{err: errTimeout.Error()}, {value: "k2"}},
+			map[string]time.Duration{"k2": 60 * time.Second},
+		},
+		{
+			"+check error",
+			[]passiveCheckRequestData{{"k1", float64(3)}, {"k2", float64(3)}},
+			nil,
+			map[string]string{"k1": "Unsupported item key."},
+			[]row{{err: "Unsupported item key."}, {value: "k2"}},
+			map[string]time.Duration{"k1": 3 * time.Second, "k2": 3 * time.Second},
+		},
+		{
+			"+rows are in request order",
+			[]passiveCheckRequestData{{"k1", float64(1)}, {"k2", float64(1)}, {"k3", float64(1)}},
+			map[string]time.Duration{"k1": 60 * time.Millisecond, "k2": 30 * time.Millisecond},
+			nil,
+			[]row{{value: "k1"}, {value: "k2"}, {value: "k3"}},
+			map[string]time.Duration{"k1": time.Second, "k2": time.Second, "k3": time.Second},
+		},
+		{
+			"+deferred rows keep request order",
+			[]passiveCheckRequestData{{"k1", float64(59)}, {"k2", float64(2)}, {"k3", float64(1)}},
+			map[string]time.Duration{"k1": 30 * time.Millisecond},
+			nil,
+			[]row{{value: "k1"}, {deferred: true}, {deferred: true}},
+			map[string]time.Duration{"k1": 59 * time.Second},
+		},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			s := &mockScheduler{delays: tt.delays, errs: tt.errs, timeouts: make(map[string]time.Duration)}
+			pc := &passiveCheck{scheduler: s}
+
+			got := pc.performChecks(tt.requests)
+
+			if len(got) != len(tt.want) {
+				t.Fatalf("performChecks() returned %d rows, want %d", len(got), len(tt.want))
+			}
+
+			for i, want := range tt.want {
+				switch v := got[i].(type) {
+				case passiveChecksResponseData:
+					if v.Value == nil || *v.Value != want.value || want.value == "" {
+						t.Errorf("performChecks() row %d = value %v, want %+v", i, v.Value, want)
+					}
+				case passiveChecksErrorResponseData:
+					if v.Error == nil || *v.Error != want.err || want.err == "" {
+						t.Errorf("performChecks() row %d = error %v, want %+v", i, v.Error, want)
+					}
+				case passiveChecksDeferredResponseData:
+					if !v.Deferred || !want.deferred {
+						t.Errorf("performChecks() row %d = deferred %v, want %+v", i, v.Deferred, want)
+					}
+				default:
+					t.Errorf("performChecks() row %d has unexpected type %T", i, got[i])
+				}
+			}
+
+			if len(s.timeouts) != len(tt.wantRun) {
+				t.Errorf("performChecks() performed %d checks, want %d", len(s.timeouts), len(tt.wantRun))
+			}
+
+			for key, timeout := range tt.wantRun {
+				if got, ok := s.timeouts[key]; !ok || got != timeout {
+					t.Errorf("performChecks() performed %q with timeout %v, want %v", key, got, timeout)
+				}
+			}
+		})
+	}
+}
@@ -38,100 +38,216 @@ void	zbx_agent_prepare_request(struct zbx_json *j, const char *key, int timeout)
 	zbx_json_addstring(j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_GET_PASSIVE_CHECKS, ZBX_JSON_TYPE_STRING);
 	zbx_json_addarray(j, ZBX_PROTO_TAG_DATA);
 
+	zbx_agent_request_add_key(j, key, timeout);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds key to passive checks request prepared by                    *
+ *          zbx_agent_prepare_request()                                       *
+ *                                                                            *
+ * Comments: Only agents reporting ZBX_AGENT_CAPABILITY_BATCH capability can  *
+ *           process requests with more than one key.                         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_agent_request_add_key(struct zbx_json *j, const char *key, int timeout)
+{
 	zbx_json_addobject(j, NULL);
 	zbx_json_addstring(j, ZBX_PROTO_TAG_KEY, key, ZBX_JSON_TYPE_STRING);
 	zbx_json_addint64(j, ZBX_PROTO_TAG_TIMEOUT, (zbx_int64_t)timeout);
 	zbx_json_close(j);
 }
 
-int	zbx_agent_handle_response(char *buffer, size_t read_bytes, ssize_t received_len, const char *addr,
-		AGENT_RESULT *result, int *version)
+static void	agent_set_results_error(AGENT_RESULT **results, int *errcodes, int num, const char *error)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", buffer);
+	for (int i = 0; i < num; i++)
+	{
+		SET_MSG_RESULT(results[i], zbx_strdup(NULL, error));
+		errcodes[i] = NETWORK_ERROR;
+	}
+}
 
-	if (0 == received_len)
+static unsigned char	agent_parse_capabilities(const struct zbx_json_parse *jp)
+{
+	struct zbx_json_parse	jp_capabilities;
+	const char		*p = NULL;
+	char			tmp[MAX_STRING_LEN];
+	unsigned char		capabilities = 0;
+
+	if (FAIL == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_CAPABILITIES, &jp_capabilities))
+		return capabilities;
+
+	while (NULL != (p = zbx_json_next_value(&jp_capabilities, p, tmp, sizeof(tmp), NULL)))
 	{
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
-				" Assuming that agent dropped connection because of access permissions.",
-				addr));
+		if (0 == strcmp(tmp, ZBX_PROTO_VALUE_CAPABILITY_BATCH))
+			capabilities |= ZBX_AGENT_CAPABILITY_BATCH;
+	}
+
+	return capabilities;
+}
+
+static int	agent_handle_response_row(const char *p, AGENT_RESULT *result, unsigned char *deferred)
+{
+	struct zbx_json_parse	jp_row;
+	size_t			value_alloc = 0;
+	char			*value = NULL, tmp[MAX_STRING_LEN];
+	zbx_json_type_t		value_type;
+
+	if (FAIL == zbx_json_brackets_open(p, &jp_row))
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "cannot parse response: %s", zbx_json_strerror()));
 		return NETWORK_ERROR;
 	}
 
-	if (ZBX_COMPONENT_VERSION(7, 0, 0) <= *version)
+	if (SUCCEED == zbx_json_value_by_name(&jp_row, ZBX_PROTO_TAG_DEFERRED, tmp, sizeof(tmp), NULL) &&
+			0 == strcmp(tmp, "true"))
 	{
-		struct zbx_json_parse	jp, jp_data, jp_row;
-		const char		*p = NULL;
-		size_t			value_alloc = 0;
-		char			*value = NULL, tmp[MAX_STRING_LEN];
-		zbx_json_type_t		value_type;
+		*deferred = 1;
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Key was deferred by agent: timeouts of the request keys"
+				" exceed the limit."));
+		return AGENT_ERROR;
+	}
 
-		if (FAIL == zbx_json_open(buffer, &jp))
-		{
-			*version = 0;
-			return FAIL;
-		}
+	if (SUCCEED == zbx_json_value_by_name(&jp_row, ZBX_PROTO_TAG_ERROR, tmp, sizeof(tmp), NULL))
+	{
+		zbx_replace_invalid_utf8(tmp);
+		SET_MSG_RESULT(result, zbx_strdup(NULL, tmp));
+		return NOTSUPPORTED;
+	}
 
-		if (FAIL == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_VERSION, tmp, sizeof(tmp), NULL))
-		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "cannot find the \"%s\" object in the received JSON"
-					" object.", ZBX_PROTO_TAG_VERSION));
-			return NETWORK_ERROR;
-		}
+	if (FAIL == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_VALUE, &value, &value_alloc, &value_type))
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "cannot parse response: %s", zbx_json_strerror()));
+		return NETWORK_ERROR;
+	}
 
-		*version = zbx_get_agent_protocol_version_int(tmp);
+	if (ZBX_JSON_TYPE_NULL != value_type)
+	{
+		zbx_replace_invalid_utf8(value);
+		SET_TEXT_RESULT(result, zbx_strdup(NULL, value));
+	}
+	else
+		zbx_free_agent_result(result);
 
-		if (SUCCEED == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_ERROR, tmp, sizeof(tmp), NULL))
-		{
-			zbx_replace_invalid_utf8(tmp);
-			SET_MSG_RESULT(result, zbx_strdup(NULL, tmp));
-			return NETWORK_ERROR;
-		}
+	zbx_free(value);
 
-		if (FAIL == zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_data))
-		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "cannot find the \"%s\" object in the received JSON"
-					" object.", ZBX_PROTO_TAG_DATA));
-			return NETWORK_ERROR;
-		}
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses JSON passive checks response                               *
+ *                                                                            *
+ * Parameters: buffer       - [IN] response                                   *
+ *             received_len - [IN] number of received bytes                   *
+ *             addr         - [IN] agent address                              *
+ *             results      - [OUT] results of requested keys                 *
+ *             errcodes     - [OUT] result codes of requested keys            *
+ *             deferred     - [OUT] flags of keys deferred by agent because   *
+ *                                  of too long request processing, such keys *
+ *                                  must be requested again                   *
+ *             num          - [IN] number of requested keys                   *
+ *             version      - [IN/OUT] agent protocol version                 *
+ *             capabilities - [OUT] agent capabilities                        *
+ *                                                                            *
+ * Return value: SUCCEED       - response was parsed, results are set         *
+ *                               according to errcodes                        *
+ *               NETWORK_ERROR - invalid response, all results are set to     *
+ *                               error                                        *
+ *               FAIL          - response is not JSON, version is reset and   *
+ *                               request must be repeated with plain protocol *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_agent_handle_batch_response(char *buffer, ssize_t received_len, const char *addr, AGENT_RESULT **results,
+		int *errcodes, unsigned char *deferred, int num, int *version, unsigned char *capabilities)
+{
+	struct zbx_json_parse	jp, jp_data;
+	const char		*p = NULL;
+	char			tmp[MAX_STRING_LEN];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "get values from agent result: '%s'", buffer);
+
+	*capabilities = 0;
+	memset(deferred, 0, sizeof(unsigned char) * (size_t)num);
 
+	if (0 == received_len)
+	{
+		zbx_snprintf(tmp, sizeof(tmp), "Received empty response from Zabbix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.", addr);
+		agent_set_results_error(results, errcodes, num, tmp);
+		return NETWORK_ERROR;
+	}
+
+	if (FAIL == zbx_json_open(buffer, &jp))
+	{
+		*version = 0;
+		return FAIL;
+	}
+
+	if (FAIL == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_VERSION, tmp, sizeof(tmp), NULL))
+	{
+		agent_set_results_error(results, errcodes, num, "cannot find the \"" ZBX_PROTO_TAG_VERSION "\" object"
+				" in the received JSON object.");
+		return NETWORK_ERROR;
+	}
+
+	*version = zbx_get_agent_protocol_version_int(tmp);
+	*capabilities = agent_parse_capabilities(&jp);
+
+	if (SUCCEED == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_ERROR, tmp, sizeof(tmp), NULL))
+	{
+		zbx_replace_invalid_utf8(tmp);
+		agent_set_results_error(results, errcodes, num, tmp);
+		return NETWORK_ERROR;
+	}
+
+	if (FAIL == zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		agent_set_results_error(results, errcodes, num, "cannot find the \"" ZBX_PROTO_TAG_DATA "\" object"
+				" in the received JSON object.");
+		return NETWORK_ERROR;
+	}
+
+	for (int i = 0; i < num; i++)
+	{
 		if (NULL == (p = zbx_json_next(&jp_data, p)))
 		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "received empty data response"));
-			return NETWORK_ERROR;
+			agent_set_results_error(results + i, errcodes + i, num - i, 0 == i ?
+					"received empty data response" : "received incomplete data response");
+			break;
 		}
 
-		if (FAIL == zbx_json_brackets_open(p, &jp_row))
-		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "cannot parse response: %s", zbx_json_strerror()));
-			return NETWORK_ERROR;
-		}
+		errcodes[i] = agent_handle_response_row(p, results[i], &deferred[i]);
+	}
 
-		if (SUCCEED == zbx_json_value_by_name(&jp_row, ZBX_PROTO_TAG_ERROR, tmp, sizeof(tmp), NULL))
-		{
-			zbx_replace_invalid_utf8(tmp);
-			SET_MSG_RESULT(result, zbx_strdup(NULL, tmp));
-			return NOTSUPPORTED;
-		}
+	return SUCCEED;
+}
 
-		if (FAIL == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_VALUE, &value, &value_alloc,
-				&value_type))
-		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "cannot parse response: %s",
-					zbx_json_strerror()));
-			return NETWORK_ERROR;
-		}
+int	zbx_agent_handle_response(char *buffer, size_t read_bytes, ssize_t received_len, const char *addr,
+		AGENT_RESULT *result, int *version)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", buffer);
+
+	if (0 == received_len)
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.",
+				addr));
+		return NETWORK_ERROR;
+	}
 
-		if (ZBX_JSON_TYPE_NULL != value_type)
+	if (ZBX_COMPONENT_VERSION(7, 0, 0) <= *version)
+	{
+		int		errcode, ret;
+		unsigned char	capabilities, deferred;
+
+		if (SUCCEED == (ret = zbx_agent_handle_batch_response(buffer, received_len, addr, &result, &errcode,
+				&deferred, 1, version, &capabilities)))
 		{
-			zbx_replace_invalid_utf8(value);
-			SET_TEXT_RESULT(result, zbx_strdup(NULL, value));
+			ret = errcode;
 		}
-		else
-			zbx_free_agent_result(result);
-
-		zbx_free(value);
 
-		return SUCCEED;
+		return ret;
 	}
 
 	if (0 == strcmp(buffer, ZBX_NOTSUPPORTED))
@@ -18,6 +18,9 @@
 
 #include "zbxasynchttppoller.h"
 
+/* maximum number of simultaneous connections to a single host, transfers over the limit are queued by cURL */
+#define ZBX_ASYNC_HTTPAGENT_MAX_HOST_CONNECTIONS	64L
+
 typedef struct
 {
 	struct event			*event;
@@ -216,12 +219,14 @@ zbx_asynchttppoller_config	*zbx_async_httpagent_create(struct event_base *ev,
 		httpagent_action_callback_fn httpagent_action_callback, void *arg, char **error)
 {
 	CURLMcode			merr;
+	CURLSHcode			serr;
 	zbx_asynchttppoller_config	*asynchttppoller_config = zbx_malloc(NULL ,sizeof(zbx_asynchttppoller_config));
 
 	asynchttppoller_config->process_httpagent_result = process_httpagent_result_callback;
 	asynchttppoller_config->http_agent_action = httpagent_action_callback;
 	asynchttppoller_config->http_agent_arg = arg;
 	asynchttppoller_config->ev = ev;
+	asynchttppoller_config->curl_share = NULL;
 
 	if (NULL == (asynchttppoller_config->curl_handle = curl_multi_init()))
 	{
@@ -257,6 +262,41 @@ zbx_asynchttppoller_config	*zbx_async_httpagent_create(struct event_base *ev,
 		goto err;
 	}
 
+	/* connections are cached by the multi handle and reused by transfers to the same scheme, host and port */
+#if LIBCURL_VERSION_NUM >= 0x071e00
+	/* CURLMOPT_MAX_HOST_CONNECTIONS is supported starting with version 7.30.0 (0x071e00) */
+	if (CURLM_OK != (merr = curl_multi_setopt(asynchttppoller_config->curl_handle,
+			CURLMOPT_MAX_HOST_CONNECTIONS, ZBX_ASYNC_HTTPAGENT_MAX_HOST_CONNECTIONS)))
+	{
+		*error = zbx_dsprintf(*error, "cannot set CURLMOPT_MAX_HOST_CONNECTIONS: %s",
+				curl_multi_strerror(merr));
+		goto err;
+	}
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072b00
+	/* CURLPIPE_MULTIPLEX is supported starting with version 7.43.0 (0x072b00) */
+	if (CURLM_OK != (merr = curl_multi_setopt(asynchttppoller_config->curl_handle, CURLMOPT_PIPELINING,
+			CURLPIPE_MULTIPLEX)))
+	{
+		*error = zbx_dsprintf(*error, "cannot set CURLMOPT_PIPELINING: %s", curl_multi_strerror(merr));
+		goto err;
+	}
+#endif
+	/* easy handles are freed after each check, so TLS sessions must be kept in a share handle to be resumed */
+	if (NULL == (asynchttppoller_config->curl_share = curl_share_init()))
+	{
+		*error = zbx_strdup(*error, "cannot initialize cURL share handle");
+		goto err;
+	}
+
+	if (CURLSHE_OK != (serr = curl_share_setopt(asynchttppoller_config->curl_share, CURLSHOPT_SHARE,
+			CURL_LOCK_DATA_DNS)) || CURLSHE_OK != (serr = curl_share_setopt(
+			asynchttppoller_config->curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION)))
+	{
+		*error = zbx_dsprintf(*error, "cannot set CURLSHOPT_SHARE: %s", curl_share_strerror(serr));
+		goto err;
+	}
+
 	if (NULL == (asynchttppoller_config->curl_timeout = evtimer_new(ev, on_timeout, asynchttppoller_config)))
 	{
 		*error = zbx_strdup(*error, "cannot create timer event");
@@ -268,6 +308,9 @@ err:
 	if (NULL != asynchttppoller_config->curl_handle)
 		curl_multi_cleanup(asynchttppoller_config->curl_handle);
 
+	if (NULL != asynchttppoller_config->curl_share)
+		curl_share_cleanup(asynchttppoller_config->curl_share);
+
 	zbx_free(asynchttppoller_config);
 
 	return NULL;
@@ -278,6 +321,10 @@ void	zbx_async_httpagent_clean(zbx_asynchttppoller_config *asynchttppoller_confi
 	if (NULL != asynchttppoller_config->curl_handle)
 		curl_multi_cleanup(asynchttppoller_config->curl_handle);
 
+	/* share handle can be cleaned up only after all easy handles using it are removed */
+	if (NULL != asynchttppoller_config->curl_share)
+		curl_share_cleanup(asynchttppoller_config->curl_share);
+
 	if (NULL != asynchttppoller_config->curl_timeout)
 		event_free(asynchttppoller_config->curl_timeout);
 }
@@ -158,6 +158,14 @@ int	zbx_get_sync_in_progress(void)
 #define START_SYNC	do { WRLOCK_CACHE_CONFIG_HISTORY; WRLOCK_CACHE; sync_in_progress = 1; } while(0)
 #define FINISH_SYNC	do { sync_in_progress = 0; UNLOCK_CACHE; UNLOCK_CACHE_CONFIG_HISTORY; } while(0)
 
+/* the write lock is released and reacquired during long sync stages to let readers progress */
+#define ZBX_DC_SYNC_LOCK_SLICE_SEC	0.1
+#define ZBX_DC_SYNC_LOCK_SLICE_ROWS	1000
+
+static zbx_dc_sync_stage_t	sync_stage;
+static double			sync_lock_sec, sync_stage_sec;
+static zbx_uint64_t		sync_stage_rows;
+
 #define ZBX_SNMP_OID_TYPE_NORMAL	0
 #define ZBX_SNMP_OID_TYPE_DYNAMIC	1
 #define ZBX_SNMP_OID_TYPE_MACRO		2
@@ -237,6 +245,89 @@ zbx_rwlock_t	zbx_get_config_history_lock(void)
 	return config_history_lock;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: update write lock statistics of the current sync stage with the   *
+ *          time the lock has been held since it was acquired                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_lock_stats_update(void)
+{
+	zbx_dc_sync_lock_stats_t	*stats = &config->sync_lock_stats[sync_stage];
+	double				hold_sec;
+
+	hold_sec = zbx_time() - sync_lock_sec;
+
+	if (hold_sec > stats->max)
+		stats->max = hold_sec;
+
+	stats->total += hold_sec;
+	sync_stage_sec += hold_sec;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: lock configuration cache for applying changes of the specified    *
+ *          sync stage                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_stage_lock(zbx_dc_sync_stage_t stage)
+{
+	START_SYNC;
+
+	sync_stage = stage;
+	sync_stage_sec = 0;
+	sync_stage_rows = 0;
+	sync_lock_sec = zbx_time();
+
+	config->sync_lock_stats[stage].locks++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unlock configuration cache after applying changes of the current  *
+ *          sync stage                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_stage_unlock(void)
+{
+	dc_sync_lock_stats_update();
+
+	config->sync_lock_stats[sync_stage].last = sync_stage_sec;
+	config->sync_lock_stats[sync_stage].syncs++;
+
+	FINISH_SYNC;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: briefly release configuration cache write lock if it has been     *
+ *          held for too long by the current sync stage                       *
+ *                                                                            *
+ * Comments: Must be called only between rows when the cached objects are in  *
+ *           consistent state. The changes are published to readers row by    *
+ *           row while the revision based consumers (preprocessing, history   *
+ *           syncers) pick them up only after configuration revision is       *
+ *           updated at the end of sync.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_stage_yield(void)
+{
+	if (0 == sync_in_progress || 0 != ++sync_stage_rows % ZBX_DC_SYNC_LOCK_SLICE_ROWS)
+		return;
+
+	if (ZBX_DC_SYNC_LOCK_SLICE_SEC > zbx_time() - sync_lock_sec)
+		return;
+
+	dc_sync_lock_stats_update();
+
+	FINISH_SYNC;
+	START_SYNC;
+
+	sync_lock_sec = zbx_time();
+	config->sync_lock_stats[sync_stage].locks++;
+}
+
 static zbx_shmem_info_t	*config_mem;
 
 ZBX_SHMEM_FUNC_IMPL(__config, config_mem)
@@ -446,7 +537,8 @@ static int	cmp_key_id(const char *key_1, const char *key_2)
 	return ('\0' == *p || '[' == *p) && ('\0' == *q || '[' == *q) ? SUCCEED : FAIL;
 }
 
-static unsigned char	poller_by_item(unsigned char type, const char *key, unsigned char snmp_oid_type)
+static unsigned char	poller_by_item(unsigned char type, const char *key, unsigned char flags,
+		unsigned char snmp_oid_type)
 {
 	switch (type)
 	{
@@ -507,12 +599,17 @@ static unsigned char	poller_by_item(unsigned char type, const char *key, unsigne
 
 			return ZBX_POLLER_TYPE_AGENT;
 		case ITEM_TYPE_SNMP:
-			if (ZBX_SNMP_OID_TYPE_WALK == snmp_oid_type || ZBX_SNMP_OID_TYPE_GET == snmp_oid_type)
+			/* plain OIDs are requested in batches by asynchronous pollers, while OIDs with dynamic */
+			/* indexes and discovery rules are left to synchronous pollers                          */
+			if (ZBX_SNMP_OID_TYPE_WALK == snmp_oid_type || ZBX_SNMP_OID_TYPE_GET == snmp_oid_type ||
+					(ZBX_SNMP_OID_TYPE_NORMAL == snmp_oid_type &&
+					0 == (ZBX_FLAG_DISCOVERY_RULE & flags)))
 			{
-				if (0 == get_config_forks_cb(ZBX_PROCESS_TYPE_SNMP_POLLER))
-					break;
+				if (0 != get_config_forks_cb(ZBX_PROCESS_TYPE_SNMP_POLLER))
+					return ZBX_POLLER_TYPE_SNMP;
 
-				return ZBX_POLLER_TYPE_SNMP;
+				if (ZBX_SNMP_OID_TYPE_NORMAL != snmp_oid_type)
+					break;
 			}
 
 			if (0 == get_config_forks_cb(ZBX_PROCESS_TYPE_POLLER))
@@ -770,7 +867,7 @@ static void	DCitem_poller_type_update(ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *d
 	if (ITEM_TYPE_SNMP == dc_item->type)
 		snmp_oid_type = dc_item->itemtype.snmpitem->snmp_oid_type;
 
-	poller_type = poller_by_item(dc_item->type, dc_item->key, snmp_oid_type);
+	poller_type = poller_by_item(dc_item->type, dc_item->key, dc_item->flags, snmp_oid_type);
 
 	if (0 != (flags & ZBX_HOST_UNREACHABLE))
 	{
@@ -3671,6 +3768,8 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 		if (ZBX_DBSYNC_ROW_REMOVE == tag)
 			break;
 
+		dc_sync_stage_yield();
+
 		ZBX_STR2UINT64(itemid, row[0]);
 		ZBX_STR2UINT64(hostid, row[1]);
 		ZBX_STR2UCHAR(status, row[2]);
@@ -3968,6 +4067,8 @@ static void	DCsync_items(zbx_dbsync_t *sync, zbx_uint64_t revision, int flags, z
 	/* remove deleted items from cache */
 	for (; SUCCEED == ret; ret = zbx_dbsync_next(sync, &rowid, &row, &tag))
 	{
+		dc_sync_stage_yield();
+
 		if (NULL != (template_item = (ZBX_DC_TEMPLATE_ITEM *)zbx_hashset_search(&config->template_items,
 				&rowid)))
 		{
@@ -8011,7 +8112,7 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 		goto out;
 
 	/* sync global configuration settings */
-	START_SYNC;
+	dc_sync_stage_lock(ZBX_DC_SYNC_STAGE_CONFIG);
 
 	DCsync_config(&config_sync, new_revision, &flags);
 
@@ -8022,7 +8123,7 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 
 	dc_sync_proxy_group(&proxy_group_sync, new_revision);
 
-	FINISH_SYNC;
+	dc_sync_stage_unlock();
 
 	/* sync macro related data, to support macro resolving during configuration sync */
 
@@ -8038,14 +8139,14 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 	if (FAIL == zbx_dbsync_compare_host_tags(&host_tag_sync))
 		goto out;
 
-	START_SYNC;
+	dc_sync_stage_lock(ZBX_DC_SYNC_STAGE_MACROS);
 
 	config->um_cache = um_cache_sync(config->um_cache, new_revision, &gmacro_sync, &hmacro_sync, &htmpl_sync,
 			config_vault, get_program_type_cb());
 
 	DCsync_host_tags(&host_tag_sync);
 
-	FINISH_SYNC;
+	dc_sync_stage_unlock();
 
 	/* postpone configuration sync until macro secrets are received from Zabbix server */
 	if (0 == (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER) && 0 != config->kvs_paths.values_num &&
@@ -8104,7 +8205,7 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 
 	zbx_hashset_create(&psk_owners, 0, ZBX_DEFAULT_PTR_HASH_FUNC, ZBX_DEFAULT_PTR_COMPARE_FUNC);
 
-	START_SYNC;
+	dc_sync_stage_lock(ZBX_DC_SYNC_STAGE_HOSTS);
 
 	DCsync_proxies(&proxy_sync, new_revision, config_vault, proxyconfig_frequency, &psk_owners);
 
@@ -8142,7 +8243,7 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 
 	dc_sync_host_proxy(&hp_sync, new_revision);
 
-	FINISH_SYNC;
+	dc_sync_stage_unlock();
 
 	zbx_hashset_destroy(&psk_owners);
 
@@ -8169,7 +8270,7 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 	if (FAIL == zbx_dbsync_compare_functions(&func_sync))
 		goto out;
 
-	START_SYNC;
+	dc_sync_stage_lock(ZBX_DC_SYNC_STAGE_ITEMS);
 
 	/* resolves macros for interface_snmpaddrs, must be after DCsync_hmacros() */
 	DCsync_interfaces(&if_sync, new_revision);
@@ -8186,7 +8287,7 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 
 	DCsync_functions(&func_sync, new_revision);
 
-	FINISH_SYNC;
+	dc_sync_stage_unlock();
 
 	if (NULL != pnew_items)
 	{
@@ -8231,7 +8332,7 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 	if (FAIL == zbx_dbsync_compare_corr_operations(&corr_operation_sync))
 		goto out;
 
-	START_SYNC;
+	dc_sync_stage_lock(ZBX_DC_SYNC_STAGE_TRIGGERS);
 
 	DCsync_triggers(&triggers_sync, new_revision);
 	DCsync_trigdeps(&tdep_sync);
@@ -8450,7 +8551,7 @@ zbx_uint64_t	zbx_dc_sync_configuration(unsigned char mode, zbx_synced_new_config
 	dberr = ZBX_DB_OK;
 out:
 	if (0 == sync_in_progress)
-		START_SYNC;
+		dc_sync_stage_lock(ZBX_DC_SYNC_STAGE_FINISH);
 
 	config->status->last_update = 0;
 	config->sync_ts = time(NULL);
@@ -8458,7 +8559,7 @@ out:
 	if (0 == (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 		dc_update_proxy_failover_delay();
 
-	FINISH_SYNC;
+	dc_sync_stage_unlock();
 
 	switch (dberr)
 	{
@@ -9116,6 +9217,7 @@ int	zbx_init_configuration_cache(zbx_get_program_type_f get_program_type, zbx_ge
 	config->auto_registration_actions = 0;
 
 	memset(&config->revision, 0, sizeof(config->revision));
+	memset(config->sync_lock_stats, 0, sizeof(config->sync_lock_stats));
 
 	config->um_cache = um_cache_create();
 
@@ -12029,6 +12131,56 @@ void	zbx_dc_poller_requeue_items(const zbx_uint64_t *itemids, const int *lastclo
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: requeues items taken by poller to be polled at the specified time *
+ *                                                                            *
+ * Parameters: itemids     - [IN] the item id array                           *
+ *             nextchecks  - [IN] the times to poll items at                  *
+ *             num         - [IN] the number of values in itemids array       *
+ *             poller_type - [IN] poller type                                 *
+ *             nextcheck   - [OUT] the nextcheck of poller queue              *
+ *                                                                            *
+ * Comments: This function is used when items were not checked, for example   *
+ *           when agent deferred them because the batch timeout was exceeded. *
+ *           The items are returned with high priority without updating their *
+ *           state or interface availability.                                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_poller_requeue_items_at(const zbx_uint64_t *itemids, const int *nextchecks, size_t num,
+		unsigned char poller_type, int *nextcheck)
+{
+	size_t		i;
+	ZBX_DC_ITEM	*dc_item;
+	ZBX_DC_HOST	*dc_host;
+
+	WRLOCK_CACHE;
+
+	for (i = 0; i < num; i++)
+	{
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])))
+			continue;
+
+		if (ZBX_LOC_POLLER == dc_item->location)
+			dc_item->location = ZBX_LOC_NOWHERE;
+
+		if (ITEM_STATUS_ACTIVE != dc_item->status)
+			continue;
+
+		if (NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
+			continue;
+
+		if (HOST_STATUS_MONITORED != dc_host->status)
+			continue;
+
+		dc_requeue_item_at(dc_item, dc_host, nextchecks[i]);
+	}
+
+	*nextcheck = dc_config_get_queue_nextcheck(&config->queues[poller_type]);
+
+	UNLOCK_CACHE;
+}
+
 #ifdef HAVE_OPENIPMI
 /******************************************************************************
  *                                                                            *
@@ -12770,6 +12922,43 @@ int	zbx_dc_config_get_last_sync_time(void)
 	return config->sync_ts;
 }
 
+const char	*zbx_dc_sync_stage_string(zbx_dc_sync_stage_t stage)
+{
+	switch (stage)
+	{
+		case ZBX_DC_SYNC_STAGE_CONFIG:
+			return "config";
+		case ZBX_DC_SYNC_STAGE_MACROS:
+			return "macros";
+		case ZBX_DC_SYNC_STAGE_HOSTS:
+			return "hosts";
+		case ZBX_DC_SYNC_STAGE_ITEMS:
+			return "items";
+		case ZBX_DC_SYNC_STAGE_TRIGGERS:
+			return "triggers";
+		case ZBX_DC_SYNC_STAGE_FINISH:
+			return "finish";
+		default:
+			return "unknown";
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get configuration cache write lock statistics per sync stage      *
+ *                                                                            *
+ * Parameters: stats - [OUT] array of ZBX_DC_SYNC_STAGE_COUNT elements        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_get_sync_lock_stats(zbx_dc_sync_lock_stats_t *stats)
+{
+	RDLOCK_CACHE;
+
+	memcpy(stats, config->sync_lock_stats, sizeof(config->sync_lock_stats));
+
+	UNLOCK_CACHE;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Get array of proxies for proxy poller                             *
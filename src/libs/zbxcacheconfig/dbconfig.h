@@ -1058,6 +1058,7 @@ typedef struct
 	char			autoreg_psk_identity[HOST_TLS_PSK_IDENTITY_LEN_MAX];	/* autoregistration PSK */
 	char			autoreg_psk[HOST_TLS_PSK_LEN_MAX];
 	zbx_vps_monitor_t	vps_monitor;
+	zbx_dc_sync_lock_stats_t	sync_lock_stats[ZBX_DC_SYNC_STAGE_COUNT];
 	char			*proxy_hostname;	/* hostname - proxy only */
 	int			proxy_failover_delay;		/* proxy group failover delay - proxy only    */
 	const char		*proxy_failover_delay_raw;	/* raw failover delay value - proxy only      */
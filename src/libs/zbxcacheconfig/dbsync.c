@@ -462,7 +462,11 @@ int	zbx_dbsync_env_prepare(unsigned char mode)
 	}
 	else
 	{
-		result = zbx_db_select("select changelogid,object,objectid,operation,clock from changelog");
+		zbx_db_stmt_t	*stmt;
+
+		/* changelog is read on every configuration sync, keep the statement prepared on connection */
+		stmt = zbx_db_prepare("select changelogid,object,objectid,operation,clock from changelog");
+		result = zbx_db_stmt_select(stmt);
 
 		while (NULL != (row = zbx_db_fetch(result)))
 		{
@@ -38,18 +38,27 @@
 #include "zbxvariant.h"
 #include "zbxipcservice.h"
 
+/* history and history index memory of the currently locked history cache shard, */
+/* the first shard memory is used by default as it also holds global cache data   */
 static zbx_shmem_info_t	*hc_index_mem = NULL;
 static zbx_shmem_info_t	*hc_mem = NULL;
 static zbx_shmem_info_t	*trend_mem = NULL;
 
-#define	LOCK_CACHE	zbx_mutex_lock(cache_lock)
-#define	UNLOCK_CACHE	zbx_mutex_unlock(cache_lock)
+static zbx_shmem_info_t	*hc_shard_index_mem[ZBX_HC_SHARDS_MAX];
+static zbx_shmem_info_t	*hc_shard_mem[ZBX_HC_SHARDS_MAX];
+static zbx_mutex_t	hc_shard_locks[ZBX_HC_SHARDS_MAX];
+
+/* the shard history syncer starts looking for data from */
+static int		hc_shard_preferred = 0;
+
+/* the global cache data is protected by the first shard lock */
+#define	LOCK_CACHE	hc_shard_lock(0)
+#define	UNLOCK_CACHE	hc_shard_unlock(0)
 #define	LOCK_TRENDS	zbx_mutex_lock(trends_lock)
 #define	UNLOCK_TRENDS	zbx_mutex_unlock(trends_lock)
 #define	LOCK_CACHE_IDS		zbx_mutex_lock(cache_ids_lock)
 #define	UNLOCK_CACHE_IDS	zbx_mutex_unlock(cache_ids_lock)
 
-static zbx_mutex_t	cache_lock = ZBX_MUTEX_NULL;
 static zbx_mutex_t	trends_lock = ZBX_MUTEX_NULL;
 static zbx_mutex_t	cache_ids_lock = ZBX_MUTEX_NULL;
 
@@ -91,15 +100,29 @@ typedef struct
 }
 zbx_hc_proxyqueue_t;
 
+/* history cache shard, items are distributed between shards by itemid */
 typedef struct
 {
-	zbx_hashset_t		trends;
 	zbx_dc_stats_t		stats;
 
 	zbx_hashset_t		history_items;
 	zbx_binary_heap_t	history_queue;
 
 	int			history_num;
+	int			processing_num;
+
+	zbx_uint64_t		lock_num;	/* the number of times shard lock was acquired */
+	double			lock_wait;	/* the time spent waiting for shard lock */
+}
+zbx_hc_shard_t;
+
+typedef struct
+{
+	zbx_hashset_t		trends;
+
+	zbx_hc_shard_t		shards[ZBX_HC_SHARDS_MAX];
+	int			shards_num;
+
 	int			trends_num;
 	int			trends_last_cleanup_hour;
 	int			history_num_total;
@@ -108,12 +131,16 @@ typedef struct
 	unsigned char		db_trigger_queue_lock;
 
 	zbx_hc_proxyqueue_t	proxyqueue;
-	int			processing_num;
+
+	zbx_history_storage_stats_t	storage_stats;	/* history storage write statistics of all syncers */
 }
 ZBX_DC_CACHE;
 
 static ZBX_DC_CACHE	*cache = NULL;
 
+/* the currently locked history cache shard */
+static zbx_hc_shard_t	*hc_shard = NULL;
+
 /* local history cache */
 #define ZBX_MAX_VALUES_LOCAL	256
 #define ZBX_STRUCT_REALLOC_STEP	8
@@ -157,10 +184,92 @@ static size_t		string_values_alloc = 0, string_values_offset = 0;
 static dc_item_value_t	*item_values = NULL;
 static size_t		item_values_alloc = 0, item_values_num = 0;
 
-static void	hc_add_item_values(dc_item_value_t *values, int values_num);
+static void	hc_add_item_values(dc_item_value_t *values, int values_num, int shardid);
 static void	hc_queue_item(zbx_hc_item_t *item);
 static int	hc_queue_elem_compare_func(const void *d1, const void *d2);
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: locks history cache shard and makes its memory current            *
+ *                                                                            *
+ * Parameters: shardid - [IN] shard index                                     *
+ *                                                                            *
+ * Comments: The time spent waiting for the lock is accumulated in shard      *
+ *           statistics to help sizing the number of shards.                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_shard_lock(int shardid)
+{
+	double	time_start;
+
+	time_start = zbx_time();
+	zbx_mutex_lock(hc_shard_locks[shardid]);
+
+	hc_shard = &cache->shards[shardid];
+	hc_shard->lock_wait += zbx_time() - time_start;
+	hc_shard->lock_num++;
+
+	hc_mem = hc_shard_mem[shardid];
+	hc_index_mem = hc_shard_index_mem[shardid];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unlocks history cache shard and restores default shard memory     *
+ *                                                                            *
+ * Parameters: shardid - [IN] shard index                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_shard_unlock(int shardid)
+{
+	hc_shard = &cache->shards[0];
+	hc_mem = hc_shard_mem[0];
+	hc_index_mem = hc_shard_index_mem[0];
+
+	zbx_mutex_unlock(hc_shard_locks[shardid]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns index of history cache shard storing the item values      *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_shard_by_itemid(zbx_uint64_t itemid)
+{
+	return (int)(itemid % (zbx_uint64_t)cache->shards_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns the number of values in history cache                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_history_num(void)
+{
+	int	history_num = 0;
+
+	for (int i = 0; i < cache->shards_num; i++)
+	{
+		hc_shard_lock(i);
+		history_num += hc_shard->history_num;
+		hc_shard_unlock(i);
+	}
+
+	return history_num;
+}
+
+static void	hc_stats_add(zbx_dc_stats_t *dst, const zbx_dc_stats_t *src)
+{
+	dst->history_counter += src->history_counter;
+	dst->history_float_counter += src->history_float_counter;
+	dst->history_uint_counter += src->history_uint_counter;
+	dst->history_str_counter += src->history_str_counter;
+	dst->history_log_counter += src->history_log_counter;
+	dst->history_text_counter += src->history_text_counter;
+	dst->history_bin_counter += src->history_bin_counter;
+	dst->notsupported_counter += src->notsupported_counter;
+}
+
 void	zbx_pp_value_opt_clear(zbx_pp_value_opt_t *opt)
 {
 	if (0 != (opt->flags & ZBX_PP_VALUE_OPT_LOG))
@@ -176,21 +285,37 @@ void	zbx_pp_value_opt_clear(zbx_pp_value_opt_t *opt)
  ******************************************************************************/
 void	zbx_dc_get_stats_all(zbx_wcache_info_t *wcache_info)
 {
-	LOCK_CACHE;
+	memset(wcache_info, 0, sizeof(zbx_wcache_info_t));
 
-	wcache_info->stats = cache->stats;
-	wcache_info->history_free = hc_mem->free_size;
-	wcache_info->history_total = hc_mem->total_size;
-	wcache_info->index_free = hc_index_mem->free_size;
-	wcache_info->index_total = hc_index_mem->total_size;
+	for (int i = 0; i < cache->shards_num; i++)
+	{
+		hc_shard_lock(i);
+
+		hc_stats_add(&wcache_info->stats, &hc_shard->stats);
+		wcache_info->history_free += hc_mem->free_size;
+		wcache_info->history_total += hc_mem->total_size;
+		wcache_info->index_free += hc_index_mem->free_size;
+		wcache_info->index_total += hc_index_mem->total_size;
+
+		wcache_info->shards[i].lock_num = hc_shard->lock_num;
+		wcache_info->shards[i].lock_wait = hc_shard->lock_wait;
+		wcache_info->shards[i].history_num = hc_shard->history_num;
+		wcache_info->lock_wait += hc_shard->lock_wait;
+
+		hc_shard_unlock(i);
+	}
+
+	wcache_info->shards_num = cache->shards_num;
 
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 	{
+		LOCK_CACHE;
+
 		wcache_info->trend_free = trend_mem->free_size;
 		wcache_info->trend_total = trend_mem->orig_size;
-	}
 
-	UNLOCK_CACHE;
+		UNLOCK_CACHE;
+	}
 }
 
 /******************************************************************************
@@ -203,112 +328,155 @@ void	*zbx_dc_get_stats(int request)
 	static zbx_uint64_t	value_uint;
 	static double		value_double;
 	void			*ret;
+	zbx_wcache_info_t	wcache_info;
 
-	LOCK_CACHE;
+	zbx_dc_get_stats_all(&wcache_info);
 
 	switch (request)
 	{
 		case ZBX_STATS_HISTORY_COUNTER:
-			value_uint = cache->stats.history_counter;
+			value_uint = wcache_info.stats.history_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FLOAT_COUNTER:
-			value_uint = cache->stats.history_float_counter;
+			value_uint = wcache_info.stats.history_float_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_UINT_COUNTER:
-			value_uint = cache->stats.history_uint_counter;
+			value_uint = wcache_info.stats.history_uint_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_STR_COUNTER:
-			value_uint = cache->stats.history_str_counter;
+			value_uint = wcache_info.stats.history_str_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_LOG_COUNTER:
-			value_uint = cache->stats.history_log_counter;
+			value_uint = wcache_info.stats.history_log_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TEXT_COUNTER:
-			value_uint = cache->stats.history_text_counter;
+			value_uint = wcache_info.stats.history_text_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_NOTSUPPORTED_COUNTER:
-			value_uint = cache->stats.notsupported_counter;
+			value_uint = wcache_info.stats.notsupported_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TOTAL:
-			value_uint = hc_mem->total_size;
+			value_uint = wcache_info.history_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_USED:
-			value_uint = hc_mem->total_size - hc_mem->free_size;
+			value_uint = wcache_info.history_total - wcache_info.history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FREE:
-			value_uint = hc_mem->free_size;
+			value_uint = wcache_info.history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_PUSED:
-			value_double = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+			value_double = 100 * (double)(wcache_info.history_total - wcache_info.history_free) /
+					wcache_info.history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_PFREE:
-			value_double = 100 * (double)hc_mem->free_size / hc_mem->total_size;
+			value_double = 100 * (double)wcache_info.history_free / wcache_info.history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_TREND_TOTAL:
-			value_uint = trend_mem->orig_size;
+			value_uint = wcache_info.trend_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_TREND_USED:
-			value_uint = trend_mem->orig_size - trend_mem->free_size;
+			value_uint = wcache_info.trend_total - wcache_info.trend_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_TREND_FREE:
-			value_uint = trend_mem->free_size;
+			value_uint = wcache_info.trend_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_TREND_PUSED:
-			value_double = 100 * (double)(trend_mem->orig_size - trend_mem->free_size) /
-					trend_mem->orig_size;
+			value_double = 100 * (double)(wcache_info.trend_total - wcache_info.trend_free) /
+					wcache_info.trend_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_TREND_PFREE:
-			value_double = 100 * (double)trend_mem->free_size / trend_mem->orig_size;
+			value_double = 100 * (double)wcache_info.trend_free / wcache_info.trend_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_TOTAL:
-			value_uint = hc_index_mem->total_size;
+			value_uint = wcache_info.index_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_USED:
-			value_uint = hc_index_mem->total_size - hc_index_mem->free_size;
+			value_uint = wcache_info.index_total - wcache_info.index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_FREE:
-			value_uint = hc_index_mem->free_size;
+			value_uint = wcache_info.index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PUSED:
-			value_double = 100 * (double)(hc_index_mem->total_size - hc_index_mem->free_size) /
-					hc_index_mem->total_size;
+			value_double = 100 * (double)(wcache_info.index_total - wcache_info.index_free) /
+					wcache_info.index_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PFREE:
-			value_double = 100 * (double)hc_index_mem->free_size / hc_index_mem->total_size;
+			value_double = 100 * (double)wcache_info.index_free / wcache_info.index_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_BIN_COUNTER:
-			value_uint = cache->stats.history_bin_counter;
+			value_uint = wcache_info.stats.history_bin_counter;
 			ret = (void *)&value_uint;
 			break;
+		case ZBX_STATS_HISTORY_LOCK_WAIT:
+			value_double = wcache_info.lock_wait;
+			ret = (void *)&value_double;
+			break;
 		default:
-			ret = NULL;
+			if (ZBX_STATS_HISTORY_SHARD_LOCK_WAIT <= request &&
+					ZBX_STATS_HISTORY_SHARD_LOCK_WAIT + wcache_info.shards_num > request)
+			{
+				value_double = wcache_info.shards[request - ZBX_STATS_HISTORY_SHARD_LOCK_WAIT].lock_wait;
+				ret = (void *)&value_double;
+			}
+			else
+				ret = NULL;
 	}
 
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds history storage write statistics collected by the current    *
+ *          history syncer to the totals                                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_add_history_storage_stats(const zbx_history_storage_stats_t *stats)
+{
+	LOCK_CACHE;
+
+	cache->storage_stats.requests += stats->requests;
+	cache->storage_stats.documents += stats->documents;
+	cache->storage_stats.bytes += stats->bytes;
+	cache->storage_stats.retried += stats->retried;
+	cache->storage_stats.failed += stats->failed;
+	cache->storage_stats.time += stats->time;
+
 	UNLOCK_CACHE;
+}
 
-	return ret;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets history storage write statistics                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_get_history_storage_stats(zbx_history_storage_stats_t *stats)
+{
+	LOCK_CACHE;
+	*stats = cache->storage_stats;
+	UNLOCK_CACHE;
 }
 
 /******************************************************************************
@@ -1793,12 +1961,14 @@ void	zbx_db_mass_update_items(const zbx_vector_item_diff_ptr_t *item_diff,
  ******************************************************************************/
 static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs, int config_history_storage_pipelines)
 {
-	int			values_num = 0, triggers_num = 0, more;
+	int			values_num = 0, triggers_num = 0, more, history_num;
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
-	zbx_binary_heap_t	tmp_history_queue;
+	zbx_binary_heap_t	tmp_history_queue[ZBX_HC_SHARDS_MAX];
+
+	history_num = hc_get_history_num();
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, history_num);
 
 	/* History index cache might be full without any space left for queueing items from history index to  */
 	/* history queue. The solution: replace the shared-memory history queue with heap-allocated one. Add  */
@@ -1817,19 +1987,27 @@ static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs, int co
 		zbx_dc_config_unlock_all_triggers();
 	}
 
-	tmp_history_queue = cache->history_queue;
+	for (int i = 0; i < cache->shards_num; i++)
+	{
+		hc_shard_lock(i);
 
-	zbx_binary_heap_create(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
+		tmp_history_queue[i] = hc_shard->history_queue;
 
-	/* add all items from history index to the new history queue */
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL != item->tail)
+		zbx_binary_heap_create(&hc_shard->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY);
+		zbx_hashset_iter_reset(&hc_shard->history_items, &iter);
+
+		/* add all items from history index to the new history queue */
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
 		{
-			item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-			hc_queue_item(item);
+			if (NULL != item->tail)
+			{
+				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+				hc_queue_item(item);
+			}
 		}
+
+		hc_shard_unlock(i);
 	}
 
 	if (0 != zbx_hc_queue_get_size())
@@ -1842,15 +2020,18 @@ static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs, int co
 					&more);
 
 			zabbix_log(LOG_LEVEL_WARNING, "syncing history data... " ZBX_FS_DBL "%%",
-					(double)values_num / (cache->history_num + values_num) * 100);
+					(double)values_num / (hc_get_history_num() + values_num) * 100);
 		}
 		while (0 != zbx_hc_queue_get_size());
 
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data done");
 	}
 
-	zbx_binary_heap_destroy(&cache->history_queue);
-	cache->history_queue = tmp_history_queue;
+	for (int i = 0; i < cache->shards_num; i++)
+	{
+		zbx_binary_heap_destroy(&cache->shards[i].history_queue);
+		cache->shards[i].history_queue = tmp_history_queue[i];
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -1863,7 +2044,9 @@ static void	sync_history_cache_full(const zbx_events_funcs_t *events_cbs, int co
 void	zbx_log_sync_history_cache_progress(void)
 {
 	double		pcnt = -1.0;
-	int		ts_last, ts_next, sec;
+	int		ts_last, ts_next, sec, history_num;
+
+	history_num = hc_get_history_num();
 
 	LOCK_CACHE;
 
@@ -1878,16 +2061,16 @@ void	zbx_log_sync_history_cache_progress(void)
 
 	if (0 == cache->history_progress_ts)
 	{
-		cache->history_num_total = cache->history_num;
+		cache->history_num_total = history_num;
 		cache->history_progress_ts = sec;
 	}
 
-	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == cache->history_num)
+	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == history_num)
 	{
 		if (0 != cache->history_num_total)
-			pcnt = 100 * (double)(cache->history_num_total - cache->history_num) / cache->history_num_total;
+			pcnt = 100 * (double)(cache->history_num_total - history_num) / cache->history_num_total;
 
-		cache->history_progress_ts = (0 == cache->history_num ? INT_MAX : sec);
+		cache->history_progress_ts = (0 == history_num ? INT_MAX : sec);
 	}
 
 	ts_next = cache->history_progress_ts;
@@ -1922,7 +2105,7 @@ void	zbx_log_sync_history_cache_progress(void)
 void	zbx_sync_history_cache(const zbx_events_funcs_t *events_cbs, zbx_ipc_async_socket_t *rtc,
 		int config_history_storage_pipelines, int *values_num, int *triggers_num, int *more)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	*values_num = 0;
 	*triggers_num = 0;
@@ -2431,19 +2614,28 @@ void	zbx_dc_add_history_variant(zbx_uint64_t itemid, unsigned char value_type, u
 
 size_t	zbx_dc_flush_history(void)
 {
-	int	processing_num;
+	int	processing_num = 0, shard_values_num[ZBX_HC_SHARDS_MAX] = {0};
 
 	if (0 == item_values_num)
 		return 0;
 
-	LOCK_CACHE;
+	for (size_t i = 0; i < item_values_num; i++)
+		shard_values_num[hc_shard_by_itemid(item_values[i].itemid)]++;
 
-	hc_add_item_values(item_values, item_values_num);
+	for (int i = 0; i < cache->shards_num; i++)
+	{
+		if (0 == shard_values_num[i])
+			continue;
 
-	cache->history_num += item_values_num;
-	processing_num = cache->processing_num;
+		hc_shard_lock(i);
 
-	UNLOCK_CACHE;
+		hc_add_item_values(item_values, item_values_num, i);
+
+		hc_shard->history_num += shard_values_num[i];
+		processing_num += hc_shard->processing_num;
+
+		hc_shard_unlock(i);
+	}
 
 	zbx_vps_monitor_add_collected((zbx_uint64_t)item_values_num);
 
@@ -2540,7 +2732,7 @@ static void	hc_queue_item(zbx_hc_item_t *item)
 {
 	zbx_binary_heap_elem_t	elem = {item->itemid, (void *)item};
 
-	zbx_binary_heap_insert(&cache->history_queue, &elem);
+	zbx_binary_heap_insert(&hc_shard->history_queue, &elem);
 }
 
 /******************************************************************************
@@ -2555,7 +2747,7 @@ static void	hc_queue_item(zbx_hc_item_t *item)
  ******************************************************************************/
 static zbx_hc_item_t	*hc_get_item(zbx_uint64_t itemid)
 {
-	return (zbx_hc_item_t *)zbx_hashset_search(&cache->history_items, &itemid);
+	return (zbx_hc_item_t *)zbx_hashset_search(&hc_shard->history_items, &itemid);
 }
 
 /******************************************************************************
@@ -2572,7 +2764,7 @@ static zbx_hc_item_t	*hc_add_item(zbx_uint64_t itemid, zbx_hc_data_t *data)
 {
 	zbx_hc_item_t	item_local = {itemid, ZBX_HC_ITEM_STATUS_NORMAL, 0, data, data};
 
-	return (zbx_hc_item_t *)zbx_hashset_insert(&cache->history_items, &item_local, sizeof(item_local));
+	return (zbx_hc_item_t *)zbx_hashset_insert(&hc_shard->history_items, &item_local, sizeof(item_local));
 }
 
 /******************************************************************************
@@ -2705,7 +2897,7 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 			return FAIL;
 
 		(*data)->value_type = item_value->value_type;
-		cache->stats.notsupported_counter++;
+		hc_shard->stats.notsupported_counter++;
 
 		return SUCCEED;
 	}
@@ -2717,8 +2909,8 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 		(*data)->value_type = ITEM_VALUE_TYPE_TEXT;
 
-		cache->stats.history_text_counter++;
-		cache->stats.history_counter++;
+		hc_shard->stats.history_text_counter++;
+		hc_shard->stats.history_counter++;
 
 		return SUCCEED;
 	}
@@ -2755,22 +2947,22 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 		switch (item_value->item_value_type)
 		{
 			case ITEM_VALUE_TYPE_FLOAT:
-				cache->stats.history_float_counter++;
+				hc_shard->stats.history_float_counter++;
 				break;
 			case ITEM_VALUE_TYPE_UINT64:
-				cache->stats.history_uint_counter++;
+				hc_shard->stats.history_uint_counter++;
 				break;
 			case ITEM_VALUE_TYPE_STR:
-				cache->stats.history_str_counter++;
+				hc_shard->stats.history_str_counter++;
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
-				cache->stats.history_text_counter++;
+				hc_shard->stats.history_text_counter++;
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				cache->stats.history_log_counter++;
+				hc_shard->stats.history_log_counter++;
 				break;
 			case ITEM_VALUE_TYPE_BIN:
-				cache->stats.history_bin_counter++;
+				hc_shard->stats.history_bin_counter++;
 				break;
 			case ITEM_VALUE_TYPE_NONE:
 			default:
@@ -2778,7 +2970,7 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 				exit(EXIT_FAILURE);
 		}
 
-		cache->stats.history_counter++;
+		hc_shard->stats.history_counter++;
 	}
 
 	(*data)->value_type = item_value->value_type;
@@ -2788,17 +2980,19 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds item values to the history cache                             *
+ * Purpose: adds item values to the history cache shard                       *
  *                                                                            *
  * Parameters: values     - [IN] the item values to add                       *
  *             values_num - [IN] the number of item values to add             *
+ *             shardid    - [IN] the locked shard, values of items belonging  *
+ *                               to other shards are skipped                  *
  *                                                                            *
  * Comments: If the history cache is full this function will wait until       *
  *           history syncers processes values freeing enough space to store   *
  *           the new value.                                                   *
  *                                                                            *
  ******************************************************************************/
-static void	hc_add_item_values(dc_item_value_t *values, int values_num)
+static void	hc_add_item_values(dc_item_value_t *values, int values_num, int shardid)
 {
 	dc_item_value_t	*item_value;
 	int		i;
@@ -2810,6 +3004,9 @@ static void	hc_add_item_values(dc_item_value_t *values, int values_num)
 
 		item_value = &values[i];
 
+		if (shardid != hc_shard_by_itemid(item_value->itemid))
+			continue;
+
 		/* a record with metadata and no value can be dropped if  */
 		/* the metadata update is copied to the last queued value */
 		if (NULL != (item = hc_get_item(item_value->itemid)) && 0 != (item_value->flags & ZBX_DC_FLAG_NOVALUE))
@@ -2833,12 +3030,12 @@ static void	hc_add_item_values(dc_item_value_t *values, int values_num)
 		{
 			do
 			{
-				UNLOCK_CACHE;
+				hc_shard_unlock(shardid);
 
 				zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
 				sleep(1);
 
-				LOCK_CACHE;
+				hc_shard_lock(shardid);
 			}
 			while (SUCCEED != hc_clone_history_data(&data, item_value));
 
@@ -2926,6 +3123,22 @@ static void	hc_copy_history_data(zbx_dc_history_t *history, zbx_uint64_t itemid,
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets history cache shard the calling history syncer process       *
+ *          starts looking for data from                                      *
+ *                                                                            *
+ * Parameters: process_num - [IN] the history syncer process number           *
+ *                                                                            *
+ * Comments: Spreading history syncers between shards allows them to pop and  *
+ *           push items without waiting on each other's locks.                *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hc_set_preferred_shard(int process_num)
+{
+	hc_shard_preferred = (process_num - 1) % cache->shards_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: pops the next batch of history items from cache for processing    *
@@ -2933,7 +3146,9 @@ static void	hc_copy_history_data(zbx_dc_history_t *history, zbx_uint64_t itemid,
  * Parameters: history_items - [OUT] the locked history items                 *
  *                                                                            *
  * Comments: The history_items must be returned back to history cache with    *
- *           zbx_hc_push_items() function after they have been processed.         *
+ *           zbx_hc_push_items() function after they have been processed.     *
+ *           All items of a batch are popped from the same shard, starting    *
+ *           with the preferred shard of the calling process.                 *
  *                                                                            *
  ******************************************************************************/
 void	zbx_hc_pop_items(zbx_vector_hc_item_ptr_t *history_items)
@@ -2941,17 +3156,35 @@ void	zbx_hc_pop_items(zbx_vector_hc_item_ptr_t *history_items)
 	zbx_binary_heap_elem_t	*elem;
 	zbx_hc_item_t		*item;
 
-	while (ZBX_HC_SYNC_MAX > history_items->values_num && FAIL == zbx_binary_heap_empty(&cache->history_queue))
+	for (int i = 0; i < cache->shards_num; i++)
 	{
-		elem = zbx_binary_heap_find_min(&cache->history_queue);
-		item = elem->data;
-		zbx_vector_hc_item_ptr_append(history_items, item);
+		int	shardid = (hc_shard_preferred + i) % cache->shards_num;
 
-		zbx_binary_heap_remove_min(&cache->history_queue);
-	}
+		/* skip empty shards without locking them, an item queued meanwhile */
+		/* will be picked up during the next sync                           */
+		if (0 == cache->shards[shardid].history_queue.elems_num)
+			continue;
+
+		hc_shard_lock(shardid);
 
-	if (0 != history_items->values_num)
-		cache->processing_num++;
+		while (ZBX_HC_SYNC_MAX > history_items->values_num &&
+				FAIL == zbx_binary_heap_empty(&hc_shard->history_queue))
+		{
+			elem = zbx_binary_heap_find_min(&hc_shard->history_queue);
+			item = elem->data;
+			zbx_vector_hc_item_ptr_append(history_items, item);
+
+			zbx_binary_heap_remove_min(&hc_shard->history_queue);
+		}
+
+		if (0 != history_items->values_num)
+			hc_shard->processing_num++;
+
+		hc_shard_unlock(shardid);
+
+		if (0 != history_items->values_num)
+			break;
+	}
 }
 
 /******************************************************************************
@@ -2986,18 +3219,27 @@ void	zbx_hc_get_item_values(zbx_dc_history_t *history, zbx_vector_hc_item_ptr_t
  *                                                                            *
  * Parameters: history_items - [IN] the history items containing processed    *
  *                                  (available) and busy items                *
+ *             history_num   - [IN] the number of synced values               *
  *                                                                            *
  * Comments: This function removes processed value from history cache.        *
  *           If there is no more data for this item, then the item itself is  *
  *           removed from history index.                                      *
  *                                                                            *
  ******************************************************************************/
-void	zbx_hc_push_items(zbx_vector_hc_item_ptr_t *history_items)
+void	zbx_hc_push_items(zbx_vector_hc_item_ptr_t *history_items, int history_num)
 {
-	int		i;
+	int		i, shardid;
 	zbx_hc_item_t	*item;
 	zbx_hc_data_t	*data_free;
 
+	if (0 == history_items->values_num)
+		return;
+
+	/* all items are popped from the same shard */
+	shardid = hc_shard_by_itemid(history_items->values[0]->itemid);
+
+	hc_shard_lock(shardid);
+
 	for (i = 0; i < history_items->values_num; i++)
 	{
 		item = history_items->values[i];
@@ -3015,24 +3257,35 @@ void	zbx_hc_push_items(zbx_vector_hc_item_ptr_t *history_items)
 				item->tail = item->tail->next;
 				hc_free_data(data_free);
 				if (NULL == item->tail)
-					zbx_hashset_remove(&cache->history_items, item);
+					zbx_hashset_remove(&hc_shard->history_items, item);
 				else
 					hc_queue_item(item);
 				break;
 		}
 	}
 
-	cache->processing_num--;
+	hc_shard->history_num -= history_num;
+	hc_shard->processing_num--;
+
+	hc_shard_unlock(shardid);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieve the size of history queue                                *
  *                                                                            *
+ * Comments: Shards are not locked, so the returned size must be used only as *
+ *           a hint whether there is more data to sync.                       *
+ *                                                                            *
  ******************************************************************************/
 int	zbx_hc_queue_get_size(void)
 {
-	return cache->history_queue.elems_num;
+	int	size = 0;
+
+	for (int i = 0; i < cache->shards_num; i++)
+		size += cache->shards[i].history_queue.elems_num;
+
+	return size;
 }
 
 int	zbx_hc_get_history_compression_age(void)
@@ -3063,8 +3316,16 @@ int	zbx_hc_get_history_compression_age(void)
  ******************************************************************************/
 double	zbx_hc_mem_pused(void)
 {
-	return 100 * (double)(zbx_dbcache_get_hc_mem()->total_size - zbx_dbcache_get_hc_mem()->free_size) /
-			zbx_dbcache_get_hc_mem()->total_size;
+	zbx_uint64_t	total_size = 0, free_size = 0;
+
+	/* other shards are not locked, the usage is an estimate for throttling purposes */
+	for (int i = 0; i < cache->shards_num; i++)
+	{
+		total_size += hc_shard_mem[i]->total_size;
+		free_size += hc_shard_mem[i]->free_size;
+	}
+
+	return 100 * (double)(total_size - free_size) / total_size;
 }
 
 double	zbx_hc_mem_pused_lock(void)
@@ -3133,12 +3394,12 @@ out:
  *                                                                            *
  ******************************************************************************/
 int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history_sync_f sync_history,
-		zbx_uint64_t history_cache_size, zbx_uint64_t history_index_cache_size,zbx_uint64_t *trends_cache_size,
-		char **error)
+		zbx_uint64_t history_cache_size, zbx_uint64_t history_index_cache_size, int history_cache_shards,
+		zbx_uint64_t *trends_cache_size, char **error)
 {
 	int	ret;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() shards:%d", __func__, history_cache_shards);
 
 	get_program_type_cb = get_program_type;
 	sync_history_cb = sync_history;
@@ -3149,36 +3410,63 @@ int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history
 		goto out;
 	}
 
-	if (SUCCEED != (ret = zbx_mutex_create(&cache_lock, ZBX_MUTEX_CACHE, error)))
+	if (SUCCEED != (ret = zbx_mutex_create(&hc_shard_locks[0], ZBX_MUTEX_CACHE, error)))
 		goto out;
 
 	if (SUCCEED != (ret = zbx_mutex_create(&cache_ids_lock, ZBX_MUTEX_CACHE_IDS, error)))
 		goto out;
 
-	if (SUCCEED != (ret = zbx_shmem_create(&hc_mem, history_cache_size, "history cache",
-			"HistoryCacheSize", 1, error)))
+	/* the memory is split evenly between shards, the first shard also holds global cache data */
+	for (int i = 0; i < history_cache_shards; i++)
 	{
-		goto out;
-	}
+		if (0 != i && SUCCEED != (ret = zbx_mutex_create(&hc_shard_locks[i], ZBX_MUTEX_CACHE_SHARD + i - 1,
+				error)))
+		{
+			goto out;
+		}
 
-	if (SUCCEED != (ret = zbx_shmem_create(&hc_index_mem, history_index_cache_size, "history index cache",
-			"HistoryIndexCacheSize", 0, error)))
-	{
-		goto out;
+		if (SUCCEED != (ret = zbx_shmem_create(&hc_shard_mem[i], history_cache_size / history_cache_shards,
+				"history cache", "HistoryCacheSize", 1, error)))
+		{
+			goto out;
+		}
+
+		if (SUCCEED != (ret = zbx_shmem_create(&hc_shard_index_mem[i],
+				history_index_cache_size / history_cache_shards, "history index cache",
+				"HistoryIndexCacheSize", 0, error)))
+		{
+			goto out;
+		}
+
+		/* history items and values are small fixed size objects allocated and freed at high rate */
+		zbx_shmem_slab_enable(hc_shard_mem[i]);
+		zbx_shmem_slab_enable(hc_shard_index_mem[i]);
 	}
 
+	hc_mem = hc_shard_mem[0];
+	hc_index_mem = hc_shard_index_mem[0];
+
 	cache = (ZBX_DC_CACHE *)__hc_index_shmem_malloc_func(NULL, sizeof(ZBX_DC_CACHE));
 	memset(cache, 0, sizeof(ZBX_DC_CACHE));
+	cache->shards_num = history_cache_shards;
 
 	ids = (ZBX_DC_IDS *)__hc_index_shmem_malloc_func(NULL, sizeof(ZBX_DC_IDS));
 	memset(ids, 0, sizeof(ZBX_DC_IDS));
 
-	zbx_hashset_create_ext(&cache->history_items, ZBX_HC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+	for (int i = 0; i < cache->shards_num; i++)
+	{
+		hc_shard_lock(i);
 
-	zbx_binary_heap_create_ext(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY,
-			__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+		zbx_hashset_create_ext(&hc_shard->history_items, ZBX_HC_ITEMS_INIT_SIZE / cache->shards_num,
+				ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+				__hc_index_shmem_malloc_func, __hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+
+		zbx_binary_heap_create_ext(&hc_shard->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY, __hc_index_shmem_malloc_func,
+				__hc_index_shmem_realloc_func, __hc_index_shmem_free_func);
+
+		hc_shard_unlock(i);
+	}
 
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
 	{
@@ -3195,7 +3483,6 @@ int	zbx_init_database_cache(zbx_get_program_type_f get_program_type, zbx_history
 			goto out;
 	}
 
-	cache->processing_num = 0;
 	cache->history_num_total = 0;
 	cache->history_progress_ts = 0;
 
@@ -3233,19 +3520,31 @@ static void	DCsync_all(const zbx_events_funcs_t *events_cbs, int config_history_
  ******************************************************************************/
 void	zbx_free_database_cache(int sync, const zbx_events_funcs_t *events_cbs, int config_history_storage_pipelines)
 {
+	int	shards_num;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	if (ZBX_SYNC_ALL == sync)
 		DCsync_all(events_cbs, config_history_storage_pipelines);
 
-	cache = NULL;
+	/* cache is located in the first shard index segment and is unmapped with it */
+	shards_num = cache->shards_num;
+
+	for (int i = 0; i < shards_num; i++)
+	{
+		zbx_shmem_destroy(hc_shard_mem[i]);
+		hc_shard_mem[i] = NULL;
+		zbx_shmem_destroy(hc_shard_index_mem[i]);
+		hc_shard_index_mem[i] = NULL;
 
-	zbx_shmem_destroy(hc_mem);
+		zbx_mutex_destroy(&hc_shard_locks[i]);
+	}
+
+	cache = NULL;
+	hc_shard = NULL;
 	hc_mem = NULL;
-	zbx_shmem_destroy(hc_index_mem);
 	hc_index_mem = NULL;
 
-	zbx_mutex_destroy(&cache_lock);
 	zbx_mutex_destroy(&cache_ids_lock);
 
 	if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_SERVER))
@@ -3366,12 +3665,53 @@ out:
  ******************************************************************************/
 void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
 {
-	LOCK_CACHE;
+	*values_num = 0;
+	*items_num = 0;
 
-	*values_num = cache->history_num;
-	*items_num = cache->history_items.num_data;
+	for (int i = 0; i < cache->shards_num; i++)
+	{
+		hc_shard_lock(i);
 
-	UNLOCK_CACHE;
+		*values_num += hc_shard->history_num;
+		*items_num += hc_shard->history_items.num_data;
+
+		hc_shard_unlock(i);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: merges shared memory allocator statistics of history cache shards *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_shmem_stats_add(zbx_shmem_stats_t *dst, const zbx_shmem_stats_t *src, int shardid)
+{
+	if (0 == shardid)
+	{
+		*dst = *src;
+		return;
+	}
+
+	dst->free_size += src->free_size;
+	dst->used_size += src->used_size;
+	dst->overhead += src->overhead;
+	dst->free_chunks += src->free_chunks;
+	dst->used_chunks += src->used_chunks;
+
+	if (src->min_chunk_size < dst->min_chunk_size)
+		dst->min_chunk_size = src->min_chunk_size;
+
+	if (src->max_chunk_size > dst->max_chunk_size)
+		dst->max_chunk_size = src->max_chunk_size;
+
+	for (int i = 0; i < ZBX_SHMEM_BUCKET_COUNT; i++)
+		dst->chunks_num[i] += src->chunks_num[i];
+
+	dst->slabs_size += src->slabs_size;
+	dst->slab_objects_size += src->slab_objects_size;
+	dst->slabs_num += src->slabs_num;
+	dst->slab_objects_num += src->slab_objects_num;
+	dst->slab_objects_free += src->slab_objects_free;
 }
 
 /******************************************************************************
@@ -3381,15 +3721,26 @@ void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
  ******************************************************************************/
 void	zbx_hc_get_mem_stats(zbx_shmem_stats_t *data, zbx_shmem_stats_t *index)
 {
-	LOCK_CACHE;
+	for (int i = 0; i < cache->shards_num; i++)
+	{
+		zbx_shmem_stats_t	stats;
 
-	if (NULL != data)
-		zbx_shmem_get_stats(hc_mem, data);
+		hc_shard_lock(i);
 
-	if (NULL != index)
-		zbx_shmem_get_stats(hc_index_mem, index);
+		if (NULL != data)
+		{
+			zbx_shmem_get_stats(hc_mem, &stats);
+			hc_shmem_stats_add(data, &stats, i);
+		}
 
-	UNLOCK_CACHE;
+		if (NULL != index)
+		{
+			zbx_shmem_get_stats(hc_index_mem, &stats);
+			hc_shmem_stats_add(index, &stats, i);
+		}
+
+		hc_shard_unlock(i);
+	}
 }
 
 /******************************************************************************
@@ -3402,18 +3753,21 @@ void	zbx_hc_get_items(zbx_vector_uint64_pair_t *items)
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
 
-	LOCK_CACHE;
+	for (int i = 0; i < cache->shards_num; i++)
+	{
+		hc_shard_lock(i);
 
-	zbx_vector_uint64_pair_reserve(items, cache->history_items.num_data);
+		zbx_vector_uint64_pair_reserve(items, (size_t)items->values_num + hc_shard->history_items.num_data);
 
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
-		zbx_vector_uint64_pair_append_ptr(items, &pair);
-	}
+		zbx_hashset_iter_reset(&hc_shard->history_items, &iter);
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
+			zbx_vector_uint64_pair_append_ptr(items, &pair);
+		}
 
-	UNLOCK_CACHE;
+		hc_shard_unlock(i);
+	}
 }
 
 /******************************************************************************
@@ -3523,21 +3877,6 @@ void	zbx_dbcache_unlock(void)
 	UNLOCK_CACHE;
 }
 
-void	zbx_dbcache_set_history_num(int num)
-{
-	cache->history_num = num;
-}
-
-int	zbx_dbcache_get_history_num(void)
-{
-	return cache->history_num;
-}
-
-zbx_shmem_info_t	*zbx_dbcache_get_hc_mem(void)
-{
-	return hc_mem;
-}
-
 void	zbx_dbcache_setproxyqueue_state(int proxyqueue_state)
 {
 	cache->proxyqueue.state = proxyqueue_state;
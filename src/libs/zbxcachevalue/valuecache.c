@@ -21,6 +21,12 @@
 #include "zbxhistory.h"
 #include "zbxshmem.h"
 
+#if defined(__AVX2__)
+#	include <immintrin.h>
+#elif defined(__SSE2__)
+#	include <emmintrin.h>
+#endif
+
 /*
  * The cache (zbx_vc_cache_t) is organized as a hashset of item records (zbx_vc_item_t).
  *
@@ -105,11 +111,44 @@ typedef struct zbx_vc_chunk
 	/* the number of item value slots in chunk */
 	int			slots_num;
 
+	/* The size of compressed value data in bytes or 0 if the chunk stores */
+	/* plain history records. Compressed chunks have no free slots - the   */
+	/* first_value is always 0 and slots_num matches the number of values. */
+	/* Their value data starts with zbx_vc_pack_t header followed by the   */
+	/* encoded bit stream (see vch_item_pack_chunk()).                     */
+	int			packed_size;
+
 	/* the item value data */
 	zbx_history_record_t	slots[1];
 }
 zbx_vc_chunk_t;
 
+/* the compressed chunk data header */
+typedef struct
+{
+	/* the first (oldest) value timestamp */
+	zbx_timespec_t	first;
+
+	/* the last (newest) value timestamp */
+	zbx_timespec_t	last;
+}
+zbx_vc_pack_t;
+
+/* the buffer for values decoded from compressed chunks during cache reads */
+typedef struct
+{
+	/* the chunk currently decoded in buffer */
+	const zbx_vc_chunk_t	*chunk;
+
+	zbx_history_record_t	*values;
+	int			values_alloc;
+}
+zbx_vc_unpack_buf_t;
+
+/* the callback to process values read from cache, see vch_item_read_values() */
+typedef void	(*zbx_vc_span_func_t)(const zbx_history_record_t *values, int values_num, unsigned char value_type,
+		void *data);
+
 /* min/max number of item history values to store in chunk */
 
 #define ZBX_VC_MIN_CHUNK_RECORDS	2
@@ -204,6 +243,10 @@ typedef struct
 	/* the minimum number of bytes to be freed when cache runs out of space */
 	size_t		min_free_request;
 
+	/* the number of values and allocated bytes in compressed chunks, used for statistics */
+	zbx_uint64_t	packed_values;
+	zbx_uint64_t	packed_size;
+
 	/* the cached items */
 	zbx_hashset_t	items;
 
@@ -917,7 +960,7 @@ static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_
  *                                                                            *
  ******************************************************************************/
 static void	vc_history_record_vector_append(zbx_vector_history_record_t *vector, int value_type,
-		zbx_history_record_t *value)
+		const zbx_history_record_t *value)
 {
 	zbx_history_record_t	record;
 
@@ -1398,527 +1441,1532 @@ static int	vch_item_add_chunk(zbx_vc_item_t *item, int nslots, zbx_vc_chunk_t *i
 
 /******************************************************************************
  *                                                                            *
- * Purpose: find the index of the last value in chunk with timestamp less or  *
- *          equal to the specified timestamp.                                 *
- *                                                                            *
- * Parameters:  chunk - [IN] the chunk                                        *
- *              ts    - [IN] the target timestamp                             *
+ * Compressed chunks                                                          *
  *                                                                            *
- * Return value: The index of the last value in chunk with timestamp less or  *
- *               equal to the specified timestamp.                            *
- *               -1 is returned in the case of failure (meaning that all      *
- *               values have timestamps greater than the target timestamp).   *
+ * When a chunk of float or unsigned item is no longer the head chunk (no new *
+ * values are appended to it) it is replaced with compressed chunk. Values    *
+ * are encoded in Gorilla style bit stream:                                   *
+ *   - timestamp seconds as delta-of-delta with variable length encoding,     *
+ *   - timestamp nanoseconds as a flag bit if matching previous value,        *
+ *   - value bits XOR with the previous value, storing only the meaningful    *
+ *     (non zero) bits.                                                       *
+ * Compressed chunks are decoded by readers. If a compressed chunk must be    *
+ * modified (out of order value inserted, old values removed) it is unpacked  *
+ * back into plain chunk.                                                     *
  *                                                                            *
  ******************************************************************************/
-static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_timespec_t *ts)
-{
-	int	start = chunk->first_value, end = chunk->last_value, middle;
 
-	/* check if the last value timestamp is already greater or equal to the specified timestamp */
-	if (0 >= zbx_timespec_compare(&chunk->slots[end].timestamp, ts))
-		return end;
+/* the worst case number of bytes required to encode one value */
+#define VC_PACK_VALUE_SIZE_MAX	18
 
-	/* chunk contains only one value, which did not pass the above check, return failure */
-	if (start == end)
-		return -1;
+typedef struct
+{
+	unsigned char	*data;
+	size_t		offset;
+}
+zbx_vc_bitwriter_t;
 
-	/* perform value lookup using binary search */
-	while (start != end)
+typedef struct
+{
+	const unsigned char	*data;
+	size_t			offset;
+}
+zbx_vc_bitreader_t;
+
+static void	vc_bits_write(zbx_vc_bitwriter_t *writer, zbx_uint64_t value, int bits)
+{
+	while (0 < bits)
 	{
-		middle = start + (end - start) / 2;
+		int	free_bits = 8 - (int)(writer->offset & 7), n = MIN(free_bits, bits);
 
-		if (0 < zbx_timespec_compare(&chunk->slots[middle].timestamp, ts))
-		{
-			end = middle;
-			continue;
-		}
+		writer->data[writer->offset >> 3] |= (unsigned char)(((value >> (bits - n)) & ((1u << n) - 1)) <<
+				(free_bits - n));
+		writer->offset += (size_t)n;
+		bits -= n;
+	}
+}
 
-		if (0 >= zbx_timespec_compare(&chunk->slots[middle + 1].timestamp, ts))
-		{
-			start = middle;
-			continue;
-		}
+static zbx_uint64_t	vc_bits_read(zbx_vc_bitreader_t *reader, int bits)
+{
+	zbx_uint64_t	value = 0;
 
-		return middle;
+	while (0 < bits)
+	{
+		int	left_bits = 8 - (int)(reader->offset & 7), n = MIN(left_bits, bits);
+
+		value = (value << n) | ((reader->data[reader->offset >> 3] >> (left_bits - n)) & ((1u << n) - 1));
+		reader->offset += (size_t)n;
+		bits -= n;
 	}
 
-	return -1;
+	return value;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: gets the chunk and index of the last value with a timestamp less  *
- *          or equal to the specified timestamp                               *
- *                                                                            *
- * Parameters:  item          - [IN] the item                                 *
- *              ts            - [IN] the target timestamp                     *
- *                                   (NULL - current time)                    *
- *              pchunk        - [OUT] the chunk containing the target value   *
- *              pindex        - [OUT] the index of the target value           *
- *                                                                            *
- * Return value: SUCCEED - the last value was found successfully              *
- *               FAIL - all values in cache have timestamps greater than the  *
- *                      target (timeshift) timestamp.                         *
- *                                                                            *
- * Comments: If end_timestamp value is 0, then simply the last item value in  *
- *           cache is returned.                                               *
- *                                                                            *
- ******************************************************************************/
-static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec_t *ts, zbx_vc_chunk_t **pchunk,
-		int *pindex)
+static int	vc_bits_leading_zeros(zbx_uint64_t value)
 {
-	zbx_vc_chunk_t	*chunk = item->head;
-	int		index;
+	int	n = 0;
 
-	if (NULL == chunk)
-		return FAIL;
+	while (0 == (value & __UINT64_C(0x8000000000000000)))
+	{
+		value <<= 1;
+		n++;
+	}
 
-	index = chunk->last_value;
+	return n;
+}
+
+static int	vc_bits_trailing_zeros(zbx_uint64_t value)
+{
+	int	n = 0;
 
-	if (0 < zbx_timespec_compare(&chunk->slots[index].timestamp, ts))
+	while (0 == (value & 1))
 	{
-		while (0 < zbx_timespec_compare(&chunk->slots[chunk->first_value].timestamp, ts))
-		{
-			chunk = chunk->prev;
-			/* there are no values for requested range, return failure */
-			if (NULL == chunk)
-				return FAIL;
-		}
-		index = vch_chunk_find_last_value_before(chunk, ts);
+		value >>= 1;
+		n++;
 	}
 
-	*pchunk = chunk;
-	*pindex = index;
+	return n;
+}
 
-	return SUCCEED;
+static zbx_uint64_t	vc_value_bits(const zbx_history_value_t *value, unsigned char value_type)
+{
+	zbx_uint64_t	bits;
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		memcpy(&bits, &value->dbl, sizeof(bits));
+	else
+		bits = value->ui64;
+
+	return bits;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: copies value in the specified item's chunk slot                   *
- *                                                                            *
- * Parameters: chunk        - [IN/OUT] the target chunk                       *
- *             index        - [IN] the target slot                            *
- *             source_value - [IN] the value to copy                          *
+ * Purpose: returns compressed chunk data header                              *
  *                                                                            *
- * Return value: SUCCEED - the value was copied successfully                  *
- *               FAIL    - the value copying failed (not enough space for     *
- *                         string, text or log type data)                     *
+ ******************************************************************************/
+static const zbx_vc_pack_t	*vch_chunk_pack(const zbx_vc_chunk_t *chunk)
+{
+	return (const zbx_vc_pack_t *)((const unsigned char *)chunk + offsetof(zbx_vc_chunk_t, slots));
+}
+
+/******************************************************************************
  *                                                                            *
- * Comments: This function is used to copy data to cache. The contents of     *
- *           str, text and log type values are stored in cache string pool.   *
+ * Purpose: returns timestamp of the first (oldest) value in chunk            *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_copy_value(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, int index,
-		const zbx_history_record_t *source_value)
+static const zbx_timespec_t	*vch_chunk_first_ts(const zbx_vc_chunk_t *chunk)
 {
-	zbx_history_record_t	*value;
-	int			ret = FAIL;
+	if (0 != chunk->packed_size)
+		return &vch_chunk_pack(chunk)->first;
 
-	value = &chunk->slots[index];
+	return &chunk->slots[chunk->first_value].timestamp;
+}
 
-	switch (item->value_type)
-	{
-		case ITEM_VALUE_TYPE_STR:
-		case ITEM_VALUE_TYPE_TEXT:
-			if (NULL == (value->value.str = vc_item_strdup(item, source_value->value.str)))
-				goto out;
-			break;
-		case ITEM_VALUE_TYPE_LOG:
-			if (NULL == (value->value.log = vc_item_logdup(item, source_value->value.log)))
-				goto out;
-			break;
-		default:
-			value->value = source_value->value;
-	}
-	value->timestamp = source_value->timestamp;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns timestamp of the last (newest) value in chunk             *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_timespec_t	*vch_chunk_last_ts(const zbx_vc_chunk_t *chunk)
+{
+	if (0 != chunk->packed_size)
+		return &vch_chunk_pack(chunk)->last;
 
-	ret = SUCCEED;
-out:
-	return ret;
+	return &chunk->slots[chunk->last_value].timestamp;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: copies values at the beginning of item tail chunk                 *
+ * Purpose: returns the number of bytes allocated for chunk                   *
  *                                                                            *
- * Parameters: item       - [IN/OUT] the target item                          *
- *             values     - [IN] the values to copy                           *
- *             values_num - [IN] the number of values to copy                 *
+ ******************************************************************************/
+static size_t	vch_chunk_size(const zbx_vc_chunk_t *chunk)
+{
+	if (0 != chunk->packed_size)
+		return offsetof(zbx_vc_chunk_t, slots) + sizeof(zbx_vc_pack_t) + (size_t)chunk->packed_size;
+
+	return sizeof(zbx_vc_chunk_t) + (size_t)(chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+}
+
+/******************************************************************************
  *                                                                            *
- * Return value: SUCCEED - the values were copied successfully                *
- *               FAIL    - the value copying failed (not enough space for     *
- *                         string, text or log type data)                     *
+ * Purpose: encodes history values into compressed bit stream                 *
  *                                                                            *
- * Comments: This function is used to copy data to cache. The contents of     *
- *           str, text and log type values are stored in cache string pool.   *
+ * Parameters: values     - [IN] the values to encode                         *
+ *             values_num - [IN] the number of values                         *
+ *             value_type - [IN] the value type (float or unsigned)           *
+ *             data       - [OUT] the encoded data, must be zero initialized  *
+ *                          and have at least                                 *
+ *                          values_num * VC_PACK_VALUE_SIZE_MAX bytes         *
+ *                                                                            *
+ * Return value: the encoded data size in bytes                               *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_copy_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+static size_t	vc_pack_values(const zbx_history_record_t *values, int values_num, unsigned char value_type,
+		unsigned char *data)
 {
-	int	i, ret = FAIL, first_value = item->tail->first_value;
+	zbx_vc_bitwriter_t	writer = {data, 0};
+	zbx_uint64_t		prev_bits, bits, xor;
+	int			i, delta, prev_delta = 0, dod, leading, trailing, prev_leading = -1, prev_trailing = 0;
 
-	switch (item->value_type)
+	vc_bits_write(&writer, (zbx_uint64_t)(zbx_uint32_t)values[0].timestamp.sec, 32);
+	vc_bits_write(&writer, (zbx_uint64_t)values[0].timestamp.ns, 30);
+	prev_bits = vc_value_bits(&values[0].value, value_type);
+	vc_bits_write(&writer, prev_bits, 64);
+
+	for (i = 1; i < values_num; i++)
 	{
-		case ITEM_VALUE_TYPE_STR:
-		case ITEM_VALUE_TYPE_TEXT:
-			for (i = values_num - 1; i >= 0; i--)
-			{
-				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+		delta = values[i].timestamp.sec - values[i - 1].timestamp.sec;
+		dod = delta - prev_delta;
+		prev_delta = delta;
+
+		if (0 == dod)
+			vc_bits_write(&writer, 0, 1);
+		else if (-63 <= dod && dod <= 64)
+			vc_bits_write(&writer, (__UINT64_C(2) << 7) | (zbx_uint64_t)(dod + 63), 2 + 7);
+		else if (-255 <= dod && dod <= 256)
+			vc_bits_write(&writer, (__UINT64_C(6) << 9) | (zbx_uint64_t)(dod + 255), 3 + 9);
+		else if (-2047 <= dod && dod <= 2048)
+			vc_bits_write(&writer, (__UINT64_C(14) << 12) | (zbx_uint64_t)(dod + 2047), 4 + 12);
+		else
+		{
+			vc_bits_write(&writer, 15, 4);
+			vc_bits_write(&writer, (zbx_uint64_t)(zbx_uint32_t)dod, 32);
+		}
 
-				if (NULL == (value->value.str = vc_item_strdup(item, values[i].value.str)))
-					goto out;
+		if (values[i].timestamp.ns == values[i - 1].timestamp.ns)
+			vc_bits_write(&writer, 0, 1);
+		else
+			vc_bits_write(&writer, (__UINT64_C(1) << 30) | (zbx_uint64_t)values[i].timestamp.ns, 1 + 30);
 
-				value->timestamp = values[i].timestamp;
-				item->tail->first_value--;
-			}
-			ret = SUCCEED;
+		bits = vc_value_bits(&values[i].value, value_type);
 
-			break;
-		case ITEM_VALUE_TYPE_LOG:
-			for (i = values_num - 1; i >= 0; i--)
-			{
-				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+		if (0 == (xor = bits ^ prev_bits))
+		{
+			vc_bits_write(&writer, 0, 1);
+		}
+		else
+		{
+			if (31 < (leading = vc_bits_leading_zeros(xor)))
+				leading = 31;
 
-				if (NULL == (value->value.log = vc_item_logdup(item, values[i].value.log)))
-					goto out;
+			trailing = vc_bits_trailing_zeros(xor);
 
-				value->timestamp = values[i].timestamp;
-				item->tail->first_value--;
+			if (-1 != prev_leading && leading >= prev_leading && trailing >= prev_trailing)
+			{
+				/* meaningful bits fit into the previous window */
+				vc_bits_write(&writer, 2, 2);
+				vc_bits_write(&writer, xor >> prev_trailing, 64 - prev_leading - prev_trailing);
 			}
-			ret = SUCCEED;
+			else
+			{
+				vc_bits_write(&writer, 3, 2);
+				vc_bits_write(&writer, (zbx_uint64_t)leading, 5);
+				vc_bits_write(&writer, (zbx_uint64_t)(64 - leading - trailing - 1), 6);
+				vc_bits_write(&writer, xor >> trailing, 64 - leading - trailing);
 
-			break;
-		default:
-			memcpy(&item->tail->slots[item->tail->first_value - values_num], values,
-					(size_t)values_num * sizeof(zbx_history_record_t));
-			item->tail->first_value -= values_num;
-			ret = SUCCEED;
+				prev_leading = leading;
+				prev_trailing = trailing;
+			}
+		}
+
+		prev_bits = bits;
 	}
-out:
-	item->values_total += first_value - item->tail->first_value;
 
-	return ret;
+	return (writer.offset + 7) >> 3;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: frees chunk and all resources allocated to store its values       *
- *                                                                            *
- * Parameters: item    - [IN] the chunk owner item                            *
- *             chunk   - [IN] the chunk to free                               *
+ * Purpose: decodes values of compressed chunk                                *
  *                                                                            *
- * Return value: the number of bytes freed                                    *
+ * Parameters: chunk      - [IN] the compressed chunk                         *
+ *             value_type - [IN] the value type (float or unsigned)           *
+ *             values     - [OUT] the decoded values, must have space for at  *
+ *                          least chunk->slots_num values                     *
  *                                                                            *
  ******************************************************************************/
-static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+static void	vc_unpack_values(const zbx_vc_chunk_t *chunk, unsigned char value_type, zbx_history_record_t *values)
 {
-	size_t	freed;
+	zbx_vc_bitreader_t	reader = {(const unsigned char *)(vch_chunk_pack(chunk) + 1), 0};
+	zbx_uint64_t		bits = 0;
+	int			i, delta = 0, dod, leading = 0, trailing = 0;
 
-	freed = sizeof(zbx_vc_chunk_t) + (size_t)(chunk->slots_num - 1) * sizeof(zbx_history_record_t);
-	freed += vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
+	for (i = 0; i < chunk->slots_num; i++)
+	{
+		if (0 == i)
+		{
+			values[i].timestamp.sec = (int)(zbx_uint32_t)vc_bits_read(&reader, 32);
+			values[i].timestamp.ns = (int)vc_bits_read(&reader, 30);
+			bits = vc_bits_read(&reader, 64);
+		}
+		else
+		{
+			if (0 == vc_bits_read(&reader, 1))
+				dod = 0;
+			else if (0 == vc_bits_read(&reader, 1))
+				dod = (int)vc_bits_read(&reader, 7) - 63;
+			else if (0 == vc_bits_read(&reader, 1))
+				dod = (int)vc_bits_read(&reader, 9) - 255;
+			else if (0 == vc_bits_read(&reader, 1))
+				dod = (int)vc_bits_read(&reader, 12) - 2047;
+			else
+				dod = (int)(zbx_uint32_t)vc_bits_read(&reader, 32);
 
-	__vc_shmem_free_func(chunk);
+			delta += dod;
+			values[i].timestamp.sec = values[i - 1].timestamp.sec + delta;
 
-	return freed;
+			if (0 == vc_bits_read(&reader, 1))
+				values[i].timestamp.ns = values[i - 1].timestamp.ns;
+			else
+				values[i].timestamp.ns = (int)vc_bits_read(&reader, 30);
+
+			if (0 != vc_bits_read(&reader, 1))
+			{
+				if (0 != vc_bits_read(&reader, 1))
+				{
+					leading = (int)vc_bits_read(&reader, 5);
+					trailing = 64 - leading - (int)vc_bits_read(&reader, 6) - 1;
+				}
+
+				bits ^= vc_bits_read(&reader, 64 - leading - trailing) << trailing;
+			}
+		}
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+			memcpy(&values[i].value.dbl, &bits, sizeof(bits));
+		else
+			values[i].value.ui64 = bits;
+	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: removes item history data chunk                                   *
+ * Purpose: replaces chunk in item chunk list with its copy                   *
  *                                                                            *
- * Parameters: item    - [IN ] the chunk owner item                           *
- *             chunk   - [IN] the chunk to remove                             *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the chunk to replace, freed afterwards            *
+ *             copy  - [IN] the new chunk                                     *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_remove_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+static void	vch_item_replace_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, zbx_vc_chunk_t *copy)
 {
-	if (NULL != chunk->next)
-		chunk->next->prev = chunk->prev;
+	copy->prev = chunk->prev;
+	copy->next = chunk->next;
 
 	if (NULL != chunk->prev)
-		chunk->prev->next = chunk->next;
-
-	if (chunk == item->head)
-		item->head = chunk->prev;
+		chunk->prev->next = copy;
+	else
+		item->tail = copy;
 
-	if (chunk == item->tail)
-		item->tail = chunk->next;
+	if (NULL != chunk->next)
+		chunk->next->prev = copy;
+	else
+		item->head = copy;
 
-	vch_item_free_chunk(item, chunk);
+	__vc_shmem_free_func(chunk);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: removes item history data that are outside (older) the maximum    *
- *          request range                                                     *
+ * Purpose: replaces plain chunk with compressed chunk                        *
  *                                                                            *
- * Parameters:  item      - [IN] the target item                              *
- *              timestamp - [IN] last timestamp in active range               *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the chunk to compress                             *
+ *                                                                            *
+ * Return value: SUCCEED - the chunk was compressed                           *
+ *               FAIL    - the chunk was left as it is - either compression   *
+ *                         would not save space or there was not enough       *
+ *                         memory to allocate compressed chunk                *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
+static int	vch_item_pack_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
 {
-	zbx_vc_chunk_t	*next;
-
-	if (0 != item->active_range)
+	unsigned char	*data;
+	zbx_vc_chunk_t	*packed;
+	zbx_vc_pack_t	*pack;
+	size_t		data_size, packed_chunk_size;
+	int		values_num = chunk->last_value - chunk->first_value + 1, ret = FAIL;
+
+	data = (unsigned char *)zbx_calloc(NULL, (size_t)values_num, VC_PACK_VALUE_SIZE_MAX);
+	data_size = vc_pack_values(&chunk->slots[chunk->first_value], values_num, item->value_type, data);
+	packed_chunk_size = offsetof(zbx_vc_chunk_t, slots) + sizeof(zbx_vc_pack_t) + data_size;
+
+	/* compression is opportunistic, don't release other items to make space for it */
+	if (packed_chunk_size >= vch_chunk_size(chunk) ||
+			NULL == (packed = (zbx_vc_chunk_t *)__vc_shmem_malloc_func(NULL, packed_chunk_size)))
 	{
-		zbx_vc_chunk_t	*tail = item->tail;
-		zbx_vc_chunk_t	*chunk = tail;
+		goto out;
+	}
 
-		timestamp -= item->active_range;
+	packed->first_value = 0;
+	packed->last_value = values_num - 1;
+	packed->slots_num = values_num;
+	packed->packed_size = (int)data_size;
 
-		/* Try to remove chunks with all history values older than maximum request range, maximum */
-		/* request range should be calculated from last received value with which active range    */
-		/* was calculated to avoid dropping of chunks that might be still used in count request.  */
-		while (NULL != chunk && chunk->slots[chunk->last_value].timestamp.sec < timestamp &&
-				chunk->slots[chunk->last_value].timestamp.sec !=
-						item->head->slots[item->head->last_value].timestamp.sec)
-		{
-			/* don't remove the head chunk */
-			if (NULL == (next = chunk->next))
-				break;
+	pack = (zbx_vc_pack_t *)((unsigned char *)packed + offsetof(zbx_vc_chunk_t, slots));
+	pack->first = chunk->slots[chunk->first_value].timestamp;
+	pack->last = chunk->slots[chunk->last_value].timestamp;
+	memcpy(pack + 1, data, data_size);
 
-			/* Values with the same timestamps (seconds resolution) always should be either   */
-			/* kept in cache or removed together. There should not be a case when one of them */
-			/* is in cache and the second is dropped.                                         */
-			/* Here we are handling rare case, when the last value of first chunk has the     */
-			/* same timestamp (seconds resolution) as the first value in the second chunk.    */
-			/* In this case increase the first value index of the next chunk until the first  */
-			/* value timestamp is greater.                                                    */
+	vch_item_replace_chunk(item, chunk, packed);
 
-			if (next->slots[next->first_value].timestamp.sec != next->slots[next->last_value].timestamp.sec)
-			{
-				while (next->slots[next->first_value].timestamp.sec ==
-						chunk->slots[chunk->last_value].timestamp.sec)
-				{
-					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
-					next->first_value++;
-				}
-			}
+	vc_cache->packed_values += (zbx_uint64_t)values_num;
+	vc_cache->packed_size += packed_chunk_size;
 
-			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
-			item->db_cached_from = chunk->slots[chunk->last_value].timestamp.sec + 1;
+	ret = SUCCEED;
+out:
+	zbx_free(data);
 
-			vch_item_remove_chunk(item, chunk);
+	return ret;
+}
 
-			chunk = next;
-		}
+/******************************************************************************
+ *                                                                            *
+ * Purpose: replaces compressed chunk with plain chunk                        *
+ *                                                                            *
+ * Parameters: item   - [IN/OUT] the chunk owner item                         *
+ *             pchunk - [IN/OUT] the chunk to uncompress, replaced with the   *
+ *                               plain chunk on success                       *
+ *                                                                            *
+ * Return value: SUCCEED - the chunk was uncompressed                         *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_unpack_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t **pchunk)
+{
+	zbx_vc_chunk_t	*chunk = *pchunk, *plain;
 
-		/* reset the status flags if data was removed from cache */
-		if (tail != item->tail)
-			item->status = 0;
+	if (NULL == (plain = (zbx_vc_chunk_t *)vc_item_malloc(item, sizeof(zbx_vc_chunk_t) +
+			sizeof(zbx_history_record_t) * (size_t)(chunk->slots_num - 1))))
+	{
+		return FAIL;
 	}
+
+	plain->first_value = 0;
+	plain->last_value = chunk->last_value;
+	plain->slots_num = chunk->slots_num;
+	plain->packed_size = 0;
+	vc_unpack_values(chunk, item->value_type, plain->slots);
+
+	vc_cache->packed_values -= (zbx_uint64_t)chunk->slots_num;
+	vc_cache->packed_size -= vch_chunk_size(chunk);
+
+	vch_item_replace_chunk(item, chunk, plain);
+	*pchunk = plain;
+
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: removes item history data that are older than the specified       *
- *          timestamp                                                         *
+ * Purpose: compresses item chunks that are not expected to be modified       *
  *                                                                            *
- * Parameters:  item      - [IN] the target item                              *
- *              timestamp - [IN] the timestamp (number of seconds since the   *
- *                               Epoch)                                       *
+ * Parameters: item - [IN/OUT] the item                                       *
+ *                                                                            *
+ * Comments: All chunks except the head chunk are compressed. Chunks are      *
+ *           checked from both list ends until the first already compressed   *
+ *           chunk, as new plain chunks are added either at the head or at    *
+ *           the tail, or unpacked near the head by out of order values.      *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
+static void	vch_item_pack_chunks(zbx_vc_item_t *item)
 {
-	zbx_vc_chunk_t	*chunk = item->tail;
-
-	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
-		item->status = 0;
+	zbx_vc_chunk_t	*chunk, *next;
 
-	/* try to remove chunks with all history values older than the timestamp */
-	while (NULL != chunk && chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+	if ((ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type) ||
+			NULL == item->head)
 	{
-		zbx_vc_chunk_t	*next;
+		return;
+	}
 
-		/* If chunk contains values with timestamp greater or equal - remove */
-		/* only the values with less timestamp. Otherwise remove the while   */
-		/* chunk and check next one.                                         */
-		if (chunk->slots[chunk->last_value].timestamp.sec >= timestamp)
-		{
-			while (chunk->slots[chunk->first_value].timestamp.sec < timestamp)
-			{
-				vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->first_value);
-				chunk->first_value++;
-			}
+	for (chunk = item->head->prev; NULL != chunk && 0 == chunk->packed_size; chunk = next)
+	{
+		next = chunk->prev;
 
-			break;
-		}
+		if (SUCCEED != vch_item_pack_chunk(item, chunk))
+			return;
+	}
 
+	for (chunk = item->tail; chunk != item->head && 0 == chunk->packed_size; chunk = next)
+	{
 		next = chunk->next;
-		vch_item_remove_chunk(item, chunk);
-		chunk = next;
+
+		if (SUCCEED != vch_item_pack_chunk(item, chunk))
+			return;
 	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds one item history value at the end of current item's history  *
- *          data                                                              *
+ * Purpose: uncompresses chunks containing values newer than the specified    *
+ *          timestamp and the chunk before them                               *
  *                                                                            *
- * Parameters:  item   - [IN] the item to add history data to                 *
- *              value  - [IN] the item history data value                     *
+ * Parameters: item - [IN/OUT] the item                                       *
+ *             ts   - [IN] the timestamp                                      *
  *                                                                            *
- * Return value: SUCCEED - the history data value was added successfully      *
- *               FAIL - failed to add history data value (not enough memory)  *
+ * Return value: SUCCEED - the chunks were uncompressed                       *
+ *               FAIL    - not enough memory                                  *
  *                                                                            *
- * Comments: In the case of failure the item will be removed from cache       *
- *           later.                                                           *
+ * Comments: Used before inserting out of order value, which shifts newer     *
+ *           values forward.                                                  *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_record_t *value)
+static int	vch_item_unpack_chunks_after(zbx_vc_item_t *item, const zbx_timespec_t *ts)
 {
-	int		ret = FAIL, index, sindex, nslots = 0;
-	zbx_vc_chunk_t	*chunk, *schunk;
+	zbx_vc_chunk_t	*chunk;
 
-	if (NULL != item->head &&
-			0 < zbx_history_record_compare_asc_func(&item->head->slots[item->head->last_value], value))
+	for (chunk = item->head; NULL != chunk; chunk = chunk->prev)
 	{
-		if (0 < zbx_history_record_compare_asc_func(&item->tail->slots[item->tail->first_value], value))
-		{
-			/* If the added value has the same or older timestamp as the first value in cache */
-			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
-			/* values with matching timestamp seconds are kept in cache.                      */
-			vch_item_remove_values(item, value->timestamp.sec + 1);
-
-			/* empty items must be removed to avoid situation when a new value is added to cache */
-			/* while other values with matching timestamp seconds are not cached                 */
-			if (NULL == item->head)
-				goto out;
+		if (0 != chunk->packed_size && SUCCEED != vch_item_unpack_chunk(item, &chunk))
+			return FAIL;
 
-			/* if the value is newer than the database cached from timestamp we must */
-			/* adjust the cached from timestamp to exclude this value                */
-			if (item->db_cached_from <= value->timestamp.sec)
-				item->db_cached_from = value->timestamp.sec + 1;
+		if (0 >= zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, ts))
+			break;
+	}
 
-			ret = SUCCEED;
-			goto out;
-		}
+	return SUCCEED;
+}
 
-		sindex = item->head->last_value;
-		schunk = item->head;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns chunk values for reading, decoding compressed chunks      *
+ *                                                                            *
+ * Parameters: item  - [IN] the chunk owner item                              *
+ *             chunk - [IN] the chunk                                         *
+ *             buf   - [IN/OUT] the buffer for decoded values                 *
+ *                                                                            *
+ * Return value: the chunk value slots, indexed by chunk value indexes        *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_history_record_t	*vch_chunk_get_slots(const zbx_vc_item_t *item, const zbx_vc_chunk_t *chunk,
+		zbx_vc_unpack_buf_t *buf)
+{
+	if (0 == chunk->packed_size)
+		return chunk->slots;
 
-		if (0 == item->head->slots_num - item->head->last_value - 1)
+	if (buf->chunk != chunk)
+	{
+		if (buf->values_alloc < chunk->slots_num)
 		{
-			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
-				goto out;
+			buf->values_alloc = chunk->slots_num;
+			buf->values = (zbx_history_record_t *)zbx_realloc(buf->values,
+					sizeof(zbx_history_record_t) * (size_t)buf->values_alloc);
 		}
-		else
-			item->head->last_value++;
 
-		item->values_total++;
+		vc_unpack_values(chunk, item->value_type, buf->values);
+		buf->chunk = chunk;
+	}
 
-		chunk = item->head;
-		index = item->head->last_value;
+	return buf->values;
+}
 
-		do
-		{
-			chunk->slots[index] = schunk->slots[sindex];
+/******************************************************************************
+ *                                                                            *
+ * Purpose: find the index of the last value in chunk with timestamp less or  *
+ *          equal to the specified timestamp.                                 *
+ *                                                                            *
+ * Parameters:  chunk - [IN] the chunk                                        *
+ *              slots - [IN] the chunk value slots (decoded values for        *
+ *                           compressed chunks)                               *
+ *              ts    - [IN] the target timestamp                             *
+ *                                                                            *
+ * Return value: The index of the last value in chunk with timestamp less or  *
+ *               equal to the specified timestamp.                            *
+ *               -1 is returned in the case of failure (meaning that all      *
+ *               values have timestamps greater than the target timestamp).   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_history_record_t *slots,
+		const zbx_timespec_t *ts)
+{
+	int	start = chunk->first_value, end = chunk->last_value, middle;
 
-			chunk = schunk;
-			index = sindex;
+	/* check if the last value timestamp is already greater or equal to the specified timestamp */
+	if (0 >= zbx_timespec_compare(&slots[end].timestamp, ts))
+		return end;
 
-			if (--sindex < schunk->first_value)
-			{
-				if (NULL == (schunk = schunk->prev))
-				{
-					memset(&chunk->slots[index], 0, sizeof(zbx_vc_chunk_t));
-					THIS_SHOULD_NEVER_HAPPEN;
+	/* chunk contains only one value, which did not pass the above check, return failure */
+	if (start == end)
+		return -1;
 
-					goto out;
-				}
+	/* perform value lookup using binary search */
+	while (start != end)
+	{
+		middle = start + (end - start) / 2;
 
-				sindex = schunk->last_value;
-			}
+		if (0 < zbx_timespec_compare(&slots[middle].timestamp, ts))
+		{
+			end = middle;
+			continue;
 		}
-		while (0 < zbx_timespec_compare(&schunk->slots[sindex].timestamp, &value->timestamp));
-	}
-	else
-	{
-		/* find the number of free slots on the right side in last (head) chunk */
-		if (NULL != item->head)
-			nslots = item->head->slots_num - item->head->last_value - 1;
 
-		if (0 == nslots)
+		if (0 >= zbx_timespec_compare(&slots[middle + 1].timestamp, ts))
 		{
-			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
-				goto out;
+			start = middle;
+			continue;
 		}
-		else
-			item->head->last_value++;
 
-		item->values_total++;
+		return middle;
+	}
 
-		chunk = item->head;
-		index = item->head->last_value;
+	return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets the chunk and index of the last value with a timestamp less  *
+ *          or equal to the specified timestamp                               *
+ *                                                                            *
+ * Parameters:  item          - [IN] the item                                 *
+ *              ts            - [IN] the target timestamp                     *
+ *                                   (NULL - current time)                    *
+ *              pchunk        - [OUT] the chunk containing the target value   *
+ *              pindex        - [OUT] the index of the target value           *
+ *              buf           - [IN/OUT] the buffer for values decoded from   *
+ *                                       compressed chunks                    *
+ *                                                                            *
+ * Return value: SUCCEED - the last value was found successfully              *
+ *               FAIL - all values in cache have timestamps greater than the  *
+ *                      target (timeshift) timestamp.                         *
+ *                                                                            *
+ * Comments: If end_timestamp value is 0, then simply the last item value in  *
+ *           cache is returned.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec_t *ts, zbx_vc_chunk_t **pchunk,
+		int *pindex, zbx_vc_unpack_buf_t *buf)
+{
+	zbx_vc_chunk_t	*chunk = item->head;
+	int		index;
+
+	if (NULL == chunk)
+		return FAIL;
+
+	index = chunk->last_value;
+
+	if (0 < zbx_timespec_compare(vch_chunk_last_ts(chunk), ts))
+	{
+		while (0 < zbx_timespec_compare(vch_chunk_first_ts(chunk), ts))
+		{
+			chunk = chunk->prev;
+			/* there are no values for requested range, return failure */
+			if (NULL == chunk)
+				return FAIL;
+		}
+		index = vch_chunk_find_last_value_before(chunk, vch_chunk_get_slots(item, chunk, buf), ts);
 	}
 
-	if (SUCCEED != vch_item_copy_value(item, chunk, index, value))
-		goto out;
+	*pchunk = chunk;
+	*pindex = index;
 
-	ret = SUCCEED;
-out:
-	return ret;
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: adds item history values at the beginning of current item's       *
- *          history data                                                      *
+ * Purpose: copies value in the specified item's chunk slot                   *
+ *                                                                            *
+ * Parameters: chunk        - [IN/OUT] the target chunk                       *
+ *             index        - [IN] the target slot                            *
+ *             source_value - [IN] the value to copy                          *
+ *                                                                            *
+ * Return value: SUCCEED - the value was copied successfully                  *
+ *               FAIL    - the value copying failed (not enough space for     *
+ *                         string, text or log type data)                     *
+ *                                                                            *
+ * Comments: This function is used to copy data to cache. The contents of     *
+ *           str, text and log type values are stored in cache string pool.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_copy_value(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, int index,
+		const zbx_history_record_t *source_value)
+{
+	zbx_history_record_t	*value;
+	int			ret = FAIL;
+
+	value = &chunk->slots[index];
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			if (NULL == (value->value.str = vc_item_strdup(item, source_value->value.str)))
+				goto out;
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			if (NULL == (value->value.log = vc_item_logdup(item, source_value->value.log)))
+				goto out;
+			break;
+		default:
+			value->value = source_value->value;
+	}
+	value->timestamp = source_value->timestamp;
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copies values at the beginning of item tail chunk                 *
+ *                                                                            *
+ * Parameters: item       - [IN/OUT] the target item                          *
+ *             values     - [IN] the values to copy                           *
+ *             values_num - [IN] the number of values to copy                 *
+ *                                                                            *
+ * Return value: SUCCEED - the values were copied successfully                *
+ *               FAIL    - the value copying failed (not enough space for     *
+ *                         string, text or log type data)                     *
+ *                                                                            *
+ * Comments: This function is used to copy data to cache. The contents of     *
+ *           str, text and log type values are stored in cache string pool.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_copy_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+{
+	int	i, ret = FAIL, first_value = item->tail->first_value;
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			for (i = values_num - 1; i >= 0; i--)
+			{
+				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+
+				if (NULL == (value->value.str = vc_item_strdup(item, values[i].value.str)))
+					goto out;
+
+				value->timestamp = values[i].timestamp;
+				item->tail->first_value--;
+			}
+			ret = SUCCEED;
+
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			for (i = values_num - 1; i >= 0; i--)
+			{
+				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+
+				if (NULL == (value->value.log = vc_item_logdup(item, values[i].value.log)))
+					goto out;
+
+				value->timestamp = values[i].timestamp;
+				item->tail->first_value--;
+			}
+			ret = SUCCEED;
+
+			break;
+		default:
+			memcpy(&item->tail->slots[item->tail->first_value - values_num], values,
+					(size_t)values_num * sizeof(zbx_history_record_t));
+			item->tail->first_value -= values_num;
+			ret = SUCCEED;
+	}
+out:
+	item->values_total += first_value - item->tail->first_value;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees chunk and all resources allocated to store its values       *
+ *                                                                            *
+ * Parameters: item    - [IN] the chunk owner item                            *
+ *             chunk   - [IN] the chunk to free                               *
+ *                                                                            *
+ * Return value: the number of bytes freed                                    *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	size_t	freed;
+
+	freed = vch_chunk_size(chunk);
+
+	if (0 != chunk->packed_size)
+	{
+		/* compressed chunks hold only float or unsigned values without referenced resources */
+		item->values_total -= chunk->slots_num;
+		vc_cache->packed_values -= (zbx_uint64_t)chunk->slots_num;
+		vc_cache->packed_size -= freed;
+	}
+	else
+		freed += vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
+
+	__vc_shmem_free_func(chunk);
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes item history data chunk                                   *
+ *                                                                            *
+ * Parameters: item    - [IN ] the chunk owner item                           *
+ *             chunk   - [IN] the chunk to remove                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	if (NULL != chunk->next)
+		chunk->next->prev = chunk->prev;
+
+	if (NULL != chunk->prev)
+		chunk->prev->next = chunk->next;
+
+	if (chunk == item->head)
+		item->head = chunk->prev;
+
+	if (chunk == item->tail)
+		item->tail = chunk->next;
+
+	vch_item_free_chunk(item, chunk);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes item history data that are outside (older) the maximum    *
+ *          request range                                                     *
+ *                                                                            *
+ * Parameters:  item      - [IN] the target item                              *
+ *              timestamp - [IN] last timestamp in active range               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_clean_cache(zbx_vc_item_t *item, int timestamp)
+{
+	zbx_vc_chunk_t	*next;
+
+	if (0 != item->active_range)
+	{
+		zbx_vc_chunk_t	*tail = item->tail;
+		zbx_vc_chunk_t	*chunk = tail;
+
+		timestamp -= item->active_range;
+
+		/* Try to remove chunks with all history values older than maximum request range, maximum */
+		/* request range should be calculated from last received value with which active range    */
+		/* was calculated to avoid dropping of chunks that might be still used in count request.  */
+		while (NULL != chunk && vch_chunk_last_ts(chunk)->sec < timestamp &&
+				vch_chunk_last_ts(chunk)->sec != vch_chunk_last_ts(item->head)->sec)
+		{
+			/* don't remove the head chunk */
+			if (NULL == (next = chunk->next))
+				break;
+
+			/* Values with the same timestamps (seconds resolution) always should be either   */
+			/* kept in cache or removed together. There should not be a case when one of them */
+			/* is in cache and the second is dropped.                                         */
+			/* Here we are handling rare case, when the last value of first chunk has the     */
+			/* same timestamp (seconds resolution) as the first value in the second chunk.    */
+			/* In this case increase the first value index of the next chunk until the first  */
+			/* value timestamp is greater.                                                    */
+
+			if (vch_chunk_first_ts(next)->sec != vch_chunk_last_ts(next)->sec &&
+					vch_chunk_first_ts(next)->sec == vch_chunk_last_ts(chunk)->sec)
+			{
+				/* compressed chunk values cannot be removed in place */
+				if (0 != next->packed_size && SUCCEED != vch_item_unpack_chunk(item, &next))
+					break;
+
+				while (next->slots[next->first_value].timestamp.sec == vch_chunk_last_ts(chunk)->sec)
+				{
+					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
+					next->first_value++;
+				}
+			}
+
+			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
+			item->db_cached_from = vch_chunk_last_ts(chunk)->sec + 1;
+
+			vch_item_remove_chunk(item, chunk);
+
+			chunk = next;
+		}
+
+		/* reset the status flags if data was removed from cache */
+		if (tail != item->tail)
+			item->status = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes item history data that are older than the specified       *
+ *          timestamp                                                         *
+ *                                                                            *
+ * Parameters:  item      - [IN] the target item                              *
+ *              timestamp - [IN] the timestamp (number of seconds since the   *
+ *                               Epoch)                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
+{
+	zbx_vc_chunk_t	*chunk = item->tail;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
+		item->status = 0;
+
+	/* try to remove chunks with all history values older than the timestamp */
+	while (NULL != chunk && vch_chunk_first_ts(chunk)->sec < timestamp)
+	{
+		zbx_vc_chunk_t	*next;
+
+		/* If chunk contains values with timestamp greater or equal - remove */
+		/* only the values with less timestamp. Otherwise remove the while   */
+		/* chunk and check next one.                                         */
+		if (vch_chunk_last_ts(chunk)->sec >= timestamp)
+		{
+			/* compressed chunk values cannot be removed in place, if it can't be */
+			/* uncompressed drop all item values to keep the cache consistent     */
+			if (0 != chunk->packed_size && SUCCEED != vch_item_unpack_chunk(item, &chunk))
+			{
+				vch_item_free_cache(item);
+				break;
+			}
+
+			while (chunk->slots[chunk->first_value].timestamp.sec < timestamp)
+			{
+				vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->first_value);
+				chunk->first_value++;
+			}
+
+			break;
+		}
+
+		next = chunk->next;
+		vch_item_remove_chunk(item, chunk);
+		chunk = next;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds one item history value at the end of current item's history  *
+ *          data                                                              *
+ *                                                                            *
+ * Parameters:  item   - [IN] the item to add history data to                 *
+ *              value  - [IN] the item history data value                     *
+ *                                                                            *
+ * Return value: SUCCEED - the history data value was added successfully      *
+ *               FAIL - failed to add history data value (not enough memory)  *
+ *                                                                            *
+ * Comments: In the case of failure the item will be removed from cache       *
+ *           later.                                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_record_t *value)
+{
+	int		ret = FAIL, index, sindex, nslots = 0;
+	zbx_vc_chunk_t	*chunk, *schunk;
+
+	if (NULL != item->head && 0 < zbx_timespec_compare(vch_chunk_last_ts(item->head), &value->timestamp))
+	{
+		if (0 < zbx_timespec_compare(vch_chunk_first_ts(item->tail), &value->timestamp))
+		{
+			/* If the added value has the same or older timestamp as the first value in cache */
+			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
+			/* values with matching timestamp seconds are kept in cache.                      */
+			vch_item_remove_values(item, value->timestamp.sec + 1);
+
+			/* empty items must be removed to avoid situation when a new value is added to cache */
+			/* while other values with matching timestamp seconds are not cached                 */
+			if (NULL == item->head)
+				goto out;
+
+			/* if the value is newer than the database cached from timestamp we must */
+			/* adjust the cached from timestamp to exclude this value                */
+			if (item->db_cached_from <= value->timestamp.sec)
+				item->db_cached_from = value->timestamp.sec + 1;
+
+			ret = SUCCEED;
+			goto out;
+		}
+
+		if (SUCCEED != vch_item_unpack_chunks_after(item, &value->timestamp))
+			goto out;
+
+		sindex = item->head->last_value;
+		schunk = item->head;
+
+		if (0 == item->head->slots_num - item->head->last_value - 1)
+		{
+			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
+				goto out;
+		}
+		else
+			item->head->last_value++;
+
+		item->values_total++;
+
+		chunk = item->head;
+		index = item->head->last_value;
+
+		do
+		{
+			chunk->slots[index] = schunk->slots[sindex];
+
+			chunk = schunk;
+			index = sindex;
+
+			if (--sindex < schunk->first_value)
+			{
+				if (NULL == (schunk = schunk->prev))
+				{
+					memset(&chunk->slots[index], 0, sizeof(zbx_vc_chunk_t));
+					THIS_SHOULD_NEVER_HAPPEN;
+
+					goto out;
+				}
+
+				sindex = schunk->last_value;
+			}
+		}
+		while (0 < zbx_timespec_compare(&schunk->slots[sindex].timestamp, &value->timestamp));
+	}
+	else
+	{
+		/* find the number of free slots on the right side in last (head) chunk */
+		if (NULL != item->head)
+			nslots = item->head->slots_num - item->head->last_value - 1;
+
+		if (0 == nslots)
+		{
+			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
+				goto out;
+		}
+		else
+			item->head->last_value++;
+
+		item->values_total++;
+
+		chunk = item->head;
+		index = item->head->last_value;
+	}
+
+	if (SUCCEED != vch_item_copy_value(item, chunk, index, value))
+		goto out;
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds item history values at the beginning of current item's       *
+ *          history data                                                      *
+ *                                                                            *
+ * Parameters:  item   - [IN] the item to add history data to                 *
+ *              values - [IN] the item history data values                    *
+ *              num    - [IN] the number of history data values to add        *
+ *                                                                            *
+ * Return value: SUCCEED - the history data values were added successfully    *
+ *               FAIL - failed to add history data values (not enough memory) *
+ *                                                                            *
+ * Comments: In the case of failure the item is removed from cache.           *
+ *           Overlapping values (by timestamp seconds) are ignored.           *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+{
+	int 	count = values_num, ret = FAIL;
+
+	/* skip values already added to the item cache by another process */
+	if (NULL != item->tail)
+	{
+		int	sec = vch_chunk_first_ts(item->tail)->sec;
+
+		while (--count >= 0 && values[count].timestamp.sec >= sec)
+			;
+		++count;
+	}
+
+	while (0 != count)
+	{
+		int	copy_slots, nslots = 0;
+
+		/* find the number of free slots on the left side in first (tail) chunk */
+		if (NULL != item->tail)
+			nslots = item->tail->first_value;
+
+		if (0 == nslots)
+		{
+			nslots = vch_item_chunk_slot_count(item, count);
+
+			if (FAIL == vch_item_add_chunk(item, nslots, item->tail))
+				goto out;
+
+			item->tail->last_value = nslots - 1;
+			item->tail->first_value = nslots;
+		}
+
+		/* copy values to chunk */
+		copy_slots = MIN(nslots, count);
+		count -= copy_slots;
+
+		if (FAIL == vch_item_copy_values_at_tail(item, values + count, copy_slots))
+			goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache item history data for the specified time period             *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             range_start - [IN] the interval start time                     *
+ *                                                                            *
+ * Return value:  >=0    - the number of values read from database            *
+ *                FAIL   - an error occurred while trying to cache values     *
+ *                                                                            *
+ * Comments: This function checks if the requested value range is cached and  *
+ *           updates cache from database if necessary.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
+{
+	int				ret, range_end;
+	zbx_vector_history_record_t	records;
+	zbx_uint64_t			itemid;
+	unsigned char			value_type;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
+		return SUCCEED;
+
+	/* check if the requested period is in the cached range */
+	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
+		return SUCCEED;
+
+	/* find if the cache should be updated to cover the required range */
+	if (NULL != (*item)->tail)
+	{
+		/* we need to get item values before the first cached value, but not including it */
+		range_end = vch_chunk_first_ts((*item)->tail)->sec - 1;
+	}
+	else
+		range_end = ZBX_JAN_2038;
+
+	/* update cache if necessary */
+	if (range_start >= range_end)
+		return SUCCEED;
+
+	zbx_vector_history_record_create(&records);
+	itemid = (*item)->itemid;
+	value_type = (*item)->value_type;
+
+	UNLOCK_CACHE;
+
+	if (SUCCEED == (ret = vc_db_read_values_by_time(itemid, value_type, &records, range_start, range_end)))
+	{
+		zbx_vector_history_record_sort(&records,
+				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+	}
+
+	WRLOCK_CACHE;
+
+	if (SUCCEED != ret)
+		goto out;
+
+	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	{
+		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+
+		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item,
+				sizeof(new_item))))
+		{
+			ret = FAIL;
+			goto out;
+		}
+	}
+
+	/* when updating cache with time based request we can always reset status flags */
+	/* flag even if the requested period contains no data                           */
+	(*item)->status = 0;
+
+	if (0 < records.values_num)
+	{
+		if (SUCCEED != (ret = vch_item_add_values_at_tail(*item, records.values, records.values_num)))
+			goto out;
+
+		vch_item_pack_chunks(*item);
+	}
+
+	ret = records.values_num;
+	vc_item_update_db_cached_from(*item, range_start);
+out:
+	zbx_history_record_vector_destroy(&records, value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: cache the specified number of history data values for time period *
+ *          since timestamp                                                   *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             range_start - [IN] the interval start time                     *
+ *             count       - [IN] the number of history values to retrieve    *
+ *             ts          - [IN] the target timestamp                        *
+ *                                                                            *
+ * Return value:  >=0    - the number of values read from database            *
+ *                FAIL   - an error occurred while trying to cache values     *
+ *                                                                            *
+ * Comments: This function checks if the requested number of values is cached *
+ *           and updates cache from database if necessary.                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int range_start, int count,
+		const zbx_timespec_t *ts)
+{
+	int				ret = SUCCEED, cached_records = 0, range_end, records_offset;
+	zbx_vector_history_record_t	records;
+	zbx_uint64_t			itemid;
+	unsigned char			value_type;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
+		return SUCCEED;
+
+	/* check if the requested period is in the cached range */
+	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
+		return SUCCEED;
+
+	/* find if the cache should be updated to cover the required count */
+	if (0 != (*item)->db_cached_from && NULL != (*item)->head)
+	{
+		zbx_vc_chunk_t		*chunk;
+		int			index;
+		zbx_vc_unpack_buf_t	buf = {NULL, NULL, 0};
+
+		if (SUCCEED == vch_item_get_last_value(*item, ts, &chunk, &index, &buf))
+		{
+			cached_records = index - chunk->first_value + 1;
+
+			while (NULL != (chunk = chunk->prev) && cached_records < count)
+				cached_records += chunk->last_value - chunk->first_value + 1;
+		}
+
+		zbx_free(buf.values);
+	}
+
+	/* update cache if necessary */
+	if (cached_records >= count)
+		return SUCCEED;
+
+	/* get the end timestamp to which (including) the values should be cached */
+	if (0 != (*item)->db_cached_from && NULL != (*item)->head)
+		range_end = vch_chunk_first_ts((*item)->tail)->sec - 1;
+	else
+		range_end = ZBX_JAN_2038;
+
+	itemid = (*item)->itemid;
+	value_type = (*item)->value_type;
+	UNLOCK_CACHE;
+
+	zbx_vector_history_record_create(&records);
+
+	if (range_end > ts->sec)
+	{
+		ret = vc_db_read_values_by_time(itemid, value_type, &records, ts->sec + 1, range_end);
+		range_end = ts->sec;
+	}
+
+	records_offset = records.values_num;
+
+	if (SUCCEED == ret && SUCCEED == (ret = vc_db_read_values_by_time_and_count(itemid, value_type, &records,
+			range_start, count - cached_records, range_end, ts)))
+	{
+		zbx_vector_history_record_sort(&records,
+				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+	}
+
+	WRLOCK_CACHE;
+
+	if (SUCCEED != ret)
+		goto out;
+
+	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	{
+		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+
+		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(new_item))))
+		{
+			ret = FAIL;
+			goto out;
+		}
+	}
+
+	if (0 < records.values_num && SUCCEED == (ret = vch_item_add_values_at_tail(*item, records.values,
+			records.values_num)))
+	{
+		vch_item_pack_chunks(*item);
+	}
+
+	if (SUCCEED != ret)
+		goto out;
+
+	ret = records.values_num;
+
+	if (0 == range_start && count - cached_records > records.values_num - records_offset)
+	{
+		(*item)->active_range = 0;
+		(*item)->daily_range = 0;
+		(*item)->status = ZBX_ITEM_STATUS_CACHED_ALL;
+	}
+
+	if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
+	{
+		vc_item_update_db_cached_from(*item, vch_chunk_first_ts((*item)->tail)->sec);
+	}
+	else if (0 != range_start)
+		vc_item_update_db_cached_from(*item, range_start);
+
+out:
+	zbx_history_record_vector_destroy(&records, value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends value span to history record vector                      *
+ *                                                                            *
+ * Comments: The values within span are appended from the newest to oldest,   *
+ *           resulting in history records sorted in descending order.         *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_span_append(const zbx_history_record_t *values, int values_num, unsigned char value_type,
+		void *data)
+{
+	zbx_vector_history_record_t	*vector = (zbx_vector_history_record_t *)data;
+	int				i;
+
+	for (i = values_num - 1; i >= 0; i--)
+		vc_history_record_vector_append(vector, value_type, &values[i]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves item history data from cache                            *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             seconds   - [IN] the time period to retrieve data for          *
+ *             ts        - [IN] the requested period end timestamp            *
+ *             span_func - [IN] the callback to process retrieved values      *
+ *             data      - [IN] the callback data                             *
+ *                                                                            *
+ * Return value: the number of retrieved values                               *
+ *                                                                            *
+ * Comments: The values are passed to span_func in spans of continuous value  *
+ *           slots, starting with the newest span. Values within span are     *
+ *           sorted in ascending order.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_values_by_time(const zbx_vc_item_t *item, int seconds, const zbx_timespec_t *ts,
+		zbx_vc_span_func_t span_func, void *data)
+{
+	int			index, now, values_num = 0;
+	zbx_timespec_t		start = {ts->sec - seconds, ts->ns};
+	zbx_vc_chunk_t		*chunk;
+	zbx_vc_unpack_buf_t	buf = {NULL, NULL, 0};
+
+	now = (int)time(NULL);
+	/* add another second to include nanosecond shifts */
+	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, seconds + now - ts->sec + 1, now);
+
+	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index, &buf))
+	{
+		/* Cache does not contain records for the specified timeshift & seconds range. */
+		/* Return empty vector with success.                                           */
+		goto out;
+	}
+
+	/* pass item history values to callback until the start timestamp is reached */
+	while (0 < zbx_timespec_compare(vch_chunk_last_ts(chunk), &start))
+	{
+		const zbx_history_record_t	*slots = vch_chunk_get_slots(item, chunk, &buf);
+		int				last = index;
+
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start))
+			index--;
+
+		if (index != last)
+		{
+			span_func(&slots[index + 1], last - index, item->value_type, data);
+			values_num += last - index;
+		}
+
+		if (NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+	}
+out:
+	zbx_free(buf.values);
+
+	return values_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: retrieves item history data from cache                            *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             seconds   - [IN] the time period                               *
+ *             count     - [IN] the number of history values to retrieve      *
+ *             ts        - [IN] the target timestamp                          *
+ *             span_func - [IN] the callback to process retrieved values      *
+ *             data      - [IN] the callback data                             *
+ *                                                                            *
+ * Return value: the number of retrieved values                               *
+ *                                                                            *
+ * Comments: The values are passed to span_func in spans of continuous value  *
+ *           slots, starting with the newest span. Values within span are     *
+ *           sorted in ascending order.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_span_func_t span_func, void *data)
+{
+	int			index, now, range_timestamp, values_num = 0;
+	zbx_vc_chunk_t		*chunk;
+	zbx_timespec_t		start, oldest = {0, 0};
+	zbx_vc_unpack_buf_t	buf = {NULL, NULL, 0};
+
+	/* set start timestamp of the requested time period */
+	if (0 != seconds)
+	{
+		start.sec = ts->sec - seconds;
+		start.ns = ts->ns;
+	}
+	else
+	{
+		start.sec = 0;
+		start.ns = 0;
+	}
+
+	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index, &buf))
+	{
+		/* return empty vector with success */
+		goto out;
+	}
+
+	/* pass item history values to callback until the <count> values are read */
+	/* or no more values within specified time period                         */
+	while (0 < zbx_timespec_compare(vch_chunk_last_ts(chunk), &start))
+	{
+		const zbx_history_record_t	*slots = vch_chunk_get_slots(item, chunk, &buf);
+		int				last = index;
+
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start) &&
+				values_num + last - index < count)
+		{
+			index--;
+		}
+
+		if (index != last)
+		{
+			span_func(&slots[index + 1], last - index, item->value_type, data);
+			values_num += last - index;
+			oldest = slots[index + 1].timestamp;
+		}
+
+		if (values_num == count || NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+	}
+out:
+	zbx_free(buf.values);
+
+	if (count > values_num)
+	{
+		if (0 == seconds)
+			return values_num;
+
+		/* set the range equal to the period plus one second to include nanosecond shifts */
+		range_timestamp = ts->sec - seconds;
+	}
+	else
+	{
+		/* the requested number of values was retrieved, set the range to the oldest value timestamp */
+		range_timestamp = oldest.sec - 1;
+	}
+
+	now = (int)time(NULL);
+	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, now - range_timestamp, now);
+
+	return values_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads item values for the specified range                         *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             seconds   - [IN] the time period to retrieve data for          *
+ *             count     - [IN] the number of history values to retrieve      *
+ *             ts        - [IN] the target timestamp                          *
+ *             span_func - [IN] the callback to process retrieved values      *
+ *             data      - [IN] the callback data                             *
  *                                                                            *
- * Parameters:  item   - [IN] the item to add history data to                 *
- *              values - [IN] the item history data values                    *
- *              num    - [IN] the number of history data values to add        *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
  *                                                                            *
- * Return value: SUCCEED - the history data values were added successfully    *
- *               FAIL - failed to add history data values (not enough memory) *
+ * Comments: This function reads data from cache if necessary updating it     *
+ *           from DB. If cache update was required and failed (not enough     *
+ *           memory to cache DB values), then this function also fails.       *
  *                                                                            *
- * Comments: In the case of failure the item is removed from cache.           *
- *           Overlapping values (by timestamp seconds) are ignored.           *
+ *           If <count> is set then value range is defined as <count> values  *
+ *           before <timestamp>. Otherwise the range is defined as <seconds>  *
+ *           seconds before <timestamp>.                                      *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+static int	vch_item_read_values(zbx_vc_item_t *item, int seconds, int count, const zbx_timespec_t *ts,
+		zbx_vc_span_func_t span_func, void *data)
 {
-	int 	count = values_num, ret = FAIL;
+	int	ret, records_read, hits, misses, range_start, values_num;
 
-	/* skip values already added to the item cache by another process */
-	if (NULL != item->tail)
+	if (0 == count)
 	{
-		int	sec = item->tail->slots[item->tail->first_value].timestamp.sec;
+		if (0 > (range_start = ts->sec - seconds))
+			range_start = 0;
 
-		while (--count >= 0 && values[count].timestamp.sec >= sec)
-			;
-		++count;
-	}
+		if (FAIL == (ret = vch_item_cache_values_by_time(&item, range_start)))
+			goto out;
 
-	while (0 != count)
+		records_read = ret;
+
+		values_num = vch_item_get_values_by_time(item, seconds, ts, span_func, data);
+	}
+	else
 	{
-		int	copy_slots, nslots = 0;
+		range_start = (0 == seconds ? 0 : ts->sec - seconds);
 
-		/* find the number of free slots on the left side in first (tail) chunk */
-		if (NULL != item->tail)
-			nslots = item->tail->first_value;
+		if (FAIL == (ret = vch_item_cache_values_by_time_and_count(&item, range_start, count, ts)))
+			goto out;
 
-		if (0 == nslots)
-		{
-			nslots = vch_item_chunk_slot_count(item, count);
+		records_read = ret;
 
-			if (FAIL == vch_item_add_chunk(item, nslots, item->tail))
-				goto out;
+		values_num = vch_item_get_values_by_time_and_count(item, seconds, count, ts, span_func, data);
+	}
 
-			item->tail->last_value = nslots - 1;
-			item->tail->first_value = nslots;
-		}
+	if (records_read > values_num)
+		records_read = values_num;
 
-		/* copy values to chunk */
-		copy_slots = MIN(nslots, count);
-		count -= copy_slots;
+	hits = values_num - records_read;
+	misses = records_read;
 
-		if (FAIL == vch_item_copy_values_at_tail(item, values + count, copy_slots))
-			goto out;
-	}
+	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_STATS, hits, misses);
 
 	ret = SUCCEED;
 out:
@@ -1927,434 +2975,474 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Purpose: cache item history data for the specified time period             *
- *                                                                            *
- * Parameters: item        - [IN] the item                                    *
- *             range_start - [IN] the interval start time                     *
+ * Purpose: get item values for the specified range                           *
  *                                                                            *
- * Return value:  >=0    - the number of values read from database            *
- *                FAIL   - an error occurred while trying to cache values     *
+ * Parameters: item      - [IN] the item                                      *
+ *             values    - [OUT] the item history data stored time/value      *
+ *                         pairs in descending order                          *
+ *             seconds   - [IN] the time period to retrieve data for          *
+ *             count     - [IN] the number of history values to retrieve      *
+ *             ts        - [IN] the target timestamp                          *
  *                                                                            *
- * Comments: This function checks if the requested value range is cached and  *
- *           updates cache from database if necessary.                        *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_cache_values_by_time(zbx_vc_item_t **item, int range_start)
+static int	vch_item_get_values(zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
+		int count, const zbx_timespec_t *ts)
 {
-	int				ret, range_end;
-	zbx_vector_history_record_t	records;
-	zbx_uint64_t			itemid;
-	unsigned char			value_type;
+	zbx_vector_history_record_clear(values);
 
-	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
-		return SUCCEED;
+	return vch_item_read_values(item, seconds, count, ts, vc_span_append, values);
+}
 
-	/* check if the requested period is in the cached range */
-	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
-		return SUCCEED;
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees resources allocated for item history data                   *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_cache(zbx_vc_item_t *item)
+{
+	size_t	freed = 0;
 
-	/* find if the cache should be updated to cover the required range */
-	if (NULL != (*item)->tail)
-	{
-		/* we need to get item values before the first cached value, but not including it */
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
-	}
-	else
-		range_end = ZBX_JAN_2038;
+	zbx_vc_chunk_t	*chunk = item->tail;
 
-	/* update cache if necessary */
-	if (range_start >= range_end)
-		return SUCCEED;
+	while (NULL != chunk)
+	{
+		zbx_vc_chunk_t	*next = chunk->next;
 
-	zbx_vector_history_record_create(&records);
-	itemid = (*item)->itemid;
-	value_type = (*item)->value_type;
+		freed += vch_item_free_chunk(item, chunk);
+		chunk = next;
+	}
+	item->values_total = 0;
+	item->head = NULL;
+	item->tail = NULL;
 
-	UNLOCK_CACHE;
+	return freed;
+}
 
-	if (SUCCEED == (ret = vc_db_read_values_by_time(itemid, value_type, &records, range_start, range_end)))
-	{
-		zbx_vector_history_record_sort(&records,
-				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
-	}
+/******************************************************************************
+ *                                                                            *
+ * Aggregate kernels                                                          *
+ *                                                                            *
+ * The kernels process spans of history records directly in cache chunk      *
+ * storage. Numeric values are loaded from records with 16 byte stride and    *
+ * processed two (SSE2) or four (AVX2) at a time, depending on the target     *
+ * instruction set the server is built for. Scalar loops process the rest of  *
+ * values and are used on other platforms.                                    *
+ *                                                                            *
+ ******************************************************************************/
 
-	WRLOCK_CACHE;
+/* SIMD kernels require history record value to be the upper half of 16 byte record */
+#define VC_KERNEL_SIMD_LAYOUT	(16 == sizeof(zbx_history_record_t) && 8 == offsetof(zbx_history_record_t, value))
 
-	if (SUCCEED != ret)
-		goto out;
+static double	vc_kernel_sum_dbl(const zbx_history_record_t *v, int n)
+{
+	double	sum = 0;
+	int	i = 0;
 
-	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+#if defined(__AVX2__)
+	if (VC_KERNEL_SIMD_LAYOUT && 4 <= n)
 	{
-		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+		__m256d	acc = _mm256_setzero_pd();
+		double	lanes[4];
 
-		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item,
-				sizeof(new_item))))
+		for (; i + 4 <= n; i += 4)
 		{
-			ret = FAIL;
-			goto out;
+			acc = _mm256_add_pd(acc, _mm256_unpackhi_pd(_mm256_loadu_pd((const double *)(const void *)&v[i]),
+					_mm256_loadu_pd((const double *)(const void *)&v[i + 2])));
 		}
+
+		_mm256_storeu_pd(lanes, acc);
+		sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
 	}
+#elif defined(__SSE2__)
+	if (VC_KERNEL_SIMD_LAYOUT && 2 <= n)
+	{
+		__m128d	acc = _mm_setzero_pd();
+		double	lanes[2];
 
-	/* when updating cache with time based request we can always reset status flags */
-	/* flag even if the requested period contains no data                           */
-	(*item)->status = 0;
+		for (; i + 2 <= n; i += 2)
+		{
+			acc = _mm_add_pd(acc, _mm_unpackhi_pd(_mm_loadu_pd((const double *)(const void *)&v[i]),
+					_mm_loadu_pd((const double *)(const void *)&v[i + 1])));
+		}
 
-	if (0 < records.values_num)
-	{
-		if (SUCCEED != (ret = vch_item_add_values_at_tail(*item, records.values, records.values_num)))
-			goto out;
+		_mm_storeu_pd(lanes, acc);
+		sum = lanes[0] + lanes[1];
 	}
+#endif
+	for (; i < n; i++)
+		sum += v[i].value.dbl;
 
-	ret = records.values_num;
-	vc_item_update_db_cached_from(*item, range_start);
-out:
-	zbx_history_record_vector_destroy(&records, value_type);
-
-	return ret;
+	return sum;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: cache the specified number of history data values for time period *
- *          since timestamp                                                   *
- *                                                                            *
- * Parameters: item        - [IN] the item                                    *
- *             range_start - [IN] the interval start time                     *
- *             count       - [IN] the number of history values to retrieve    *
- *             ts          - [IN] the target timestamp                        *
- *                                                                            *
- * Return value:  >=0    - the number of values read from database            *
- *                FAIL   - an error occurred while trying to cache values     *
- *                                                                            *
- * Comments: This function checks if the requested number of values is cached *
- *           and updates cache from database if necessary.                    *
- *                                                                            *
- ******************************************************************************/
-static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t **item, int range_start, int count,
-		const zbx_timespec_t *ts)
+static zbx_uint64_t	vc_kernel_sum_ui64(const zbx_history_record_t *v, int n)
 {
-	int				ret = SUCCEED, cached_records = 0, range_end, records_offset;
-	zbx_vector_history_record_t	records;
-	zbx_uint64_t			itemid;
-	unsigned char			value_type;
-
-	if (ZBX_ITEM_STATUS_CACHED_ALL == (*item)->status)
-		return SUCCEED;
-
-	/* check if the requested period is in the cached range */
-	if (0 != (*item)->db_cached_from && range_start >= (*item)->db_cached_from)
-		return SUCCEED;
+	zbx_uint64_t	sum = 0;
+	int		i = 0;
 
-	/* find if the cache should be updated to cover the required count */
-	if (0 != (*item)->db_cached_from && NULL != (*item)->head)
+#if defined(__AVX2__)
+	if (VC_KERNEL_SIMD_LAYOUT && 4 <= n)
 	{
-		zbx_vc_chunk_t	*chunk;
-		int		index;
+		__m256i		acc = _mm256_setzero_si256();
+		zbx_uint64_t	lanes[4];
 
-		if (SUCCEED == vch_item_get_last_value(*item, ts, &chunk, &index))
+		for (; i + 4 <= n; i += 4)
 		{
-			cached_records = index - chunk->first_value + 1;
-
-			while (NULL != (chunk = chunk->prev) && cached_records < count)
-				cached_records += chunk->last_value - chunk->first_value + 1;
+			acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi64(
+					_mm256_loadu_si256((const __m256i *)(const void *)&v[i]),
+					_mm256_loadu_si256((const __m256i *)(const void *)&v[i + 2])));
 		}
+
+		_mm256_storeu_si256((__m256i *)(void *)lanes, acc);
+		sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
 	}
+#elif defined(__SSE2__)
+	if (VC_KERNEL_SIMD_LAYOUT && 2 <= n)
+	{
+		__m128i		acc = _mm_setzero_si128();
+		zbx_uint64_t	lanes[2];
 
-	/* update cache if necessary */
-	if (cached_records >= count)
-		return SUCCEED;
+		for (; i + 2 <= n; i += 2)
+		{
+			acc = _mm_add_epi64(acc, _mm_unpackhi_epi64(_mm_loadu_si128((const __m128i *)(const void *)&v[i]),
+					_mm_loadu_si128((const __m128i *)(const void *)&v[i + 1])));
+		}
 
-	/* get the end timestamp to which (including) the values should be cached */
-	if (0 != (*item)->db_cached_from && NULL != (*item)->head)
-		range_end = (*item)->tail->slots[(*item)->tail->first_value].timestamp.sec - 1;
-	else
-		range_end = ZBX_JAN_2038;
+		_mm_storeu_si128((__m128i *)(void *)lanes, acc);
+		sum = lanes[0] + lanes[1];
+	}
+#endif
+	for (; i < n; i++)
+		sum += v[i].value.ui64;
 
-	itemid = (*item)->itemid;
-	value_type = (*item)->value_type;
-	UNLOCK_CACHE;
+	return sum;
+}
 
-	zbx_vector_history_record_create(&records);
+static double	vc_kernel_sum_ui64_dbl(const zbx_history_record_t *v, int n)
+{
+	double	sum[4] = {0, 0, 0, 0};
+	int	i = 0;
 
-	if (range_end > ts->sec)
+	/* there is no unsigned 64 bit integer to double conversion in SSE2/AVX2, */
+	/* use independent accumulators to let the conversions pipeline          */
+	for (; i + 4 <= n; i += 4)
 	{
-		ret = vc_db_read_values_by_time(itemid, value_type, &records, ts->sec + 1, range_end);
-		range_end = ts->sec;
+		sum[0] += (double)v[i].value.ui64;
+		sum[1] += (double)v[i + 1].value.ui64;
+		sum[2] += (double)v[i + 2].value.ui64;
+		sum[3] += (double)v[i + 3].value.ui64;
 	}
 
-	records_offset = records.values_num;
+	for (; i < n; i++)
+		sum[0] += (double)v[i].value.ui64;
 
-	if (SUCCEED == ret && SUCCEED == (ret = vc_db_read_values_by_time_and_count(itemid, value_type, &records,
-			range_start, count - cached_records, range_end, ts)))
+	return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+static void	vc_kernel_minmax_dbl(const zbx_history_record_t *v, int n, double *min, double *max)
+{
+	double	vmin = v[0].value.dbl, vmax = v[0].value.dbl;
+	int	i = 1;
+
+#if defined(__AVX2__)
+	if (VC_KERNEL_SIMD_LAYOUT && 4 <= n)
 	{
-		zbx_vector_history_record_sort(&records,
-				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
-	}
+		__m256d	accmin = _mm256_set1_pd(vmin), accmax = accmin;
+		double	lanes[4];
 
-	WRLOCK_CACHE;
+		for (i = 0; i + 4 <= n; i += 4)
+		{
+			__m256d	x = _mm256_unpackhi_pd(_mm256_loadu_pd((const double *)(const void *)&v[i]),
+					_mm256_loadu_pd((const double *)(const void *)&v[i + 2]));
 
-	if (SUCCEED != ret)
-		goto out;
+			accmin = _mm256_min_pd(accmin, x);
+			accmax = _mm256_max_pd(accmax, x);
+		}
 
-	if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+		_mm256_storeu_pd(lanes, accmin);
+		vmin = MIN(MIN(lanes[0], lanes[1]), MIN(lanes[2], lanes[3]));
+		_mm256_storeu_pd(lanes, accmax);
+		vmax = MAX(MAX(lanes[0], lanes[1]), MAX(lanes[2], lanes[3]));
+	}
+#elif defined(__SSE2__)
+	if (VC_KERNEL_SIMD_LAYOUT && 2 <= n)
 	{
-		zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type};
+		__m128d	accmin = _mm_set1_pd(vmin), accmax = accmin;
+		double	lanes[2];
 
-		if (NULL == (*item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(new_item))))
+		for (i = 0; i + 2 <= n; i += 2)
 		{
-			ret = FAIL;
-			goto out;
+			__m128d	x = _mm_unpackhi_pd(_mm_loadu_pd((const double *)(const void *)&v[i]),
+					_mm_loadu_pd((const double *)(const void *)&v[i + 1]));
+
+			accmin = _mm_min_pd(accmin, x);
+			accmax = _mm_max_pd(accmax, x);
 		}
+
+		_mm_storeu_pd(lanes, accmin);
+		vmin = MIN(lanes[0], lanes[1]);
+		_mm_storeu_pd(lanes, accmax);
+		vmax = MAX(lanes[0], lanes[1]);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		if (v[i].value.dbl < vmin)
+			vmin = v[i].value.dbl;
+		if (v[i].value.dbl > vmax)
+			vmax = v[i].value.dbl;
 	}
 
-	if (0 < records.values_num)
-		ret = vch_item_add_values_at_tail(*item, records.values, records.values_num);
+	*min = vmin;
+	*max = vmax;
+}
 
-	if (SUCCEED != ret)
-		goto out;
+static void	vc_kernel_minmax_ui64(const zbx_history_record_t *v, int n, zbx_uint64_t *min, zbx_uint64_t *max)
+{
+	zbx_uint64_t	vmin = v[0].value.ui64, vmax = v[0].value.ui64;
+	int		i = 1;
 
-	ret = records.values_num;
+#if defined(__AVX2__)
+	if (VC_KERNEL_SIMD_LAYOUT && 4 <= n)
+	{
+		/* AVX2 has only signed 64 bit comparison, flip the sign bit to compare unsigned values */
+		__m256i		bias = _mm256_set1_epi64x((long long)__UINT64_C(0x8000000000000000));
+		__m256i		accmin = _mm256_set1_epi64x((long long)vmin), accmax = accmin;
+		zbx_uint64_t	lanes[4];
+		int		j;
+
+		for (i = 0; i + 4 <= n; i += 4)
+		{
+			__m256i	x = _mm256_unpackhi_epi64(_mm256_loadu_si256((const __m256i *)(const void *)&v[i]),
+					_mm256_loadu_si256((const __m256i *)(const void *)&v[i + 2]));
+			__m256i	xb = _mm256_xor_si256(x, bias);
+
+			accmin = _mm256_blendv_epi8(accmin, x,
+					_mm256_cmpgt_epi64(_mm256_xor_si256(accmin, bias), xb));
+			accmax = _mm256_blendv_epi8(accmax, x,
+					_mm256_cmpgt_epi64(xb, _mm256_xor_si256(accmax, bias)));
+		}
+
+		_mm256_storeu_si256((__m256i *)(void *)lanes, accmin);
+		for (vmin = lanes[0], j = 1; j < 4; j++)
+			vmin = MIN(vmin, lanes[j]);
 
-	if (0 == range_start && count - cached_records > records.values_num - records_offset)
-	{
-		(*item)->active_range = 0;
-		(*item)->daily_range = 0;
-		(*item)->status = ZBX_ITEM_STATUS_CACHED_ALL;
+		_mm256_storeu_si256((__m256i *)(void *)lanes, accmax);
+		for (vmax = lanes[0], j = 1; j < 4; j++)
+			vmax = MAX(vmax, lanes[j]);
 	}
-
-	if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
+#endif
+	for (; i < n; i++)
 	{
-		vc_item_update_db_cached_from(*item,
-				(*item)->tail->slots[(*item)->tail->first_value].timestamp.sec);
+		if (v[i].value.ui64 < vmin)
+			vmin = v[i].value.ui64;
+		if (v[i].value.ui64 > vmax)
+			vmax = v[i].value.ui64;
 	}
-	else if (0 != range_start)
-		vc_item_update_db_cached_from(*item, range_start);
 
-out:
-	zbx_history_record_vector_destroy(&records, value_type);
+	*min = vmin;
+	*max = vmax;
+}
 
-	return ret;
+/* the aggregate function calculation state */
+typedef struct
+{
+	int			func;
+	int			values_num;
+	zbx_history_value_t	value;
 }
+zbx_vc_aggregate_t;
 
 /******************************************************************************
  *                                                                            *
- * Purpose: retrieves item history data from cache                            *
- *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order                           *
- *             seconds   - [IN] the time period to retrieve data for          *
- *             ts        - [IN] the requested period end timestamp            *
+ * Purpose: updates aggregate function state with value span                  *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_get_values_by_time(const zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
-		const zbx_timespec_t *ts)
+static void	vc_span_aggregate(const zbx_history_record_t *values, int values_num, unsigned char value_type,
+		void *data)
 {
-	int		index, now;
-	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
-	zbx_vc_chunk_t	*chunk;
-
-	now = (int)time(NULL);
-	/* add another second to include nanosecond shifts */
-	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, seconds + now - ts->sec + 1, now);
+	zbx_vc_aggregate_t	*aggr = (zbx_vc_aggregate_t *)data;
+	zbx_history_value_t	min, max;
+	double			mean;
 
-	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
+	switch (aggr->func)
 	{
-		/* Cache does not contain records for the specified timeshift & seconds range. */
-		/* Return empty vector with success.                                           */
-		return;
-	}
+		case ZBX_VC_AGGR_COUNT:
+			break;
+		case ZBX_VC_AGGR_SUM:
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+				aggr->value.dbl += vc_kernel_sum_dbl(values, values_num);
+			else
+				aggr->value.ui64 += vc_kernel_sum_ui64(values, values_num);
+			break;
+		case ZBX_VC_AGGR_AVG:
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+			{
+				/* combine span mean with the current mean using weights to avoid */
+				/* overflow when summing values close to the double limits      */
+				if (0 == isfinite(mean = vc_kernel_sum_dbl(values, values_num) / values_num))
+				{
+					int	i;
 
-	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
-	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+					for (mean = 0, i = 0; i < values_num; i++)
+						mean += values[i].value.dbl / values_num;
+				}
 
-		if (NULL == (chunk = chunk->prev))
+				aggr->value.dbl = aggr->value.dbl * ((double)aggr->values_num /
+						(aggr->values_num + values_num)) +
+						mean * ((double)values_num / (aggr->values_num + values_num));
+			}
+			else
+				aggr->value.dbl += vc_kernel_sum_ui64_dbl(values, values_num);
 			break;
+		case ZBX_VC_AGGR_MIN:
+		case ZBX_VC_AGGR_MAX:
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+			{
+				vc_kernel_minmax_dbl(values, values_num, &min.dbl, &max.dbl);
 
-		index = chunk->last_value;
+				if (ZBX_VC_AGGR_MIN == aggr->func)
+				{
+					if (0 == aggr->values_num || min.dbl < aggr->value.dbl)
+						aggr->value.dbl = min.dbl;
+				}
+				else if (0 == aggr->values_num || max.dbl > aggr->value.dbl)
+					aggr->value.dbl = max.dbl;
+			}
+			else
+			{
+				vc_kernel_minmax_ui64(values, values_num, &min.ui64, &max.ui64);
+
+				if (ZBX_VC_AGGR_MIN == aggr->func)
+				{
+					if (0 == aggr->values_num || min.ui64 < aggr->value.ui64)
+						aggr->value.ui64 = min.ui64;
+				}
+				else if (0 == aggr->values_num || max.ui64 > aggr->value.ui64)
+					aggr->value.ui64 = max.ui64;
+			}
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
 	}
+
+	aggr->values_num += values_num;
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: retrieves item history data from cache                            *
+ * Purpose: appends value span to double vector                               *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order, optional                 *
- *                         If null then cache is updated if necessary, but no *
- *                         values are returned. Used to ensure that cache     *
- *                         contains a value of the specified timestamp.       *
- *             seconds   - [IN] the time period                               *
- *             count     - [IN] the number of history values to retrieve      *
- *             timestamp - [IN] the target timestamp                          *
+ * Comments: The values within span are appended from the newest to oldest.   *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vector_history_record_t *values,
-		int seconds, int count, const zbx_timespec_t *ts)
+static void	vc_span_append_dbl(const zbx_history_record_t *values, int values_num, unsigned char value_type,
+		void *data)
 {
-	int		index, now, range_timestamp;
-	zbx_vc_chunk_t	*chunk;
-	zbx_timespec_t	start;
-
-	/* set start timestamp of the requested time period */
-	if (0 != seconds)
-	{
-		start.sec = ts->sec - seconds;
-		start.ns = ts->ns;
-	}
-	else
-	{
-		start.sec = 0;
-		start.ns = 0;
-	}
-
-	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
-	{
-		/* return empty vector with success */
-		goto out;
-	}
-
-	/* fill the values vector with item history values until the <count> values are read    */
-	/* or no more values within specified time period                                       */
-	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
-	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-		{
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
-
-			if (values->values_num == count)
-				goto out;
-		}
+	zbx_vector_dbl_t	*vector = (zbx_vector_dbl_t *)data;
+	int			i;
 
-		if (NULL == (chunk = chunk->prev))
-			break;
+	zbx_vector_dbl_reserve(vector, (size_t)(vector->values_num + values_num));
 
-		index = chunk->last_value;
-	}
-out:
-	if (count > values->values_num)
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
 	{
-		if (0 == seconds)
-			return;
-
-		/* set the range equal to the period plus one second to include nanosecond shifts */
-		range_timestamp = ts->sec - seconds;
+		for (i = values_num - 1; i >= 0; i--)
+			vector->values[vector->values_num++] = values[i].value.dbl;
 	}
 	else
 	{
-		/* the requested number of values was retrieved, set the range to the oldest value timestamp */
-		range_timestamp = values->values[values->values_num - 1].timestamp.sec - 1;
+		for (i = values_num - 1; i >= 0; i--)
+			vector->values[vector->values_num++] = (double)values[i].value.ui64;
 	}
-
-	now = (int)time(NULL);
-	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_RANGE, now - range_timestamp, now);
 }
 
 /******************************************************************************
  *                                                                            *
- * Purpose: get item values for the specified range                           *
+ * Purpose: reads item values for the specified range, passing them to        *
+ *          callback instead of returning history record vector               *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order, optional                 *
- *                         If null then cache is updated if necessary, but no *
- *                         values are returned. Used to ensure that cache     *
- *                         contains a value of the specified timestamp.       *
- *             seconds   - [IN] the time period to retrieve data for          *
- *             count     - [IN] the number of history values to retrieve      *
- *             ts        - [IN] the target timestamp                          *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
+ *             span_func  - [IN] the callback to process retrieved values     *
+ *             data       - [IN] the callback data                            *
  *                                                                            *
  * Return value:  SUCCEED - the item history data was retrieved successfully  *
  *                FAIL    - the item history data was not retrieved           *
  *                                                                            *
- * Comments: This function returns data from cache if necessary updating it   *
- *           from DB. If cache update was required and failed (not enough     *
- *           memory to cache DB values), then this function also fails.       *
- *                                                                            *
- *           If <count> is set then value range is defined as <count> values  *
- *           before <timestamp>. Otherwise the range is defined as <seconds>  *
- *           seconds before <timestamp>.                                      *
+ * Comments: If the values cannot be read from cache they are read from       *
+ *           database and passed to callback one by one, starting with the    *
+ *           newest value.                                                    *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_get_values(zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
-		int count, const zbx_timespec_t *ts)
+static int	vc_read_values(zbx_uint64_t itemid, unsigned char value_type, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_span_func_t span_func, void *data)
 {
-	int	ret, records_read, hits, misses, range_start;
-
-	zbx_vector_history_record_clear(values);
-
-	if (0 == count)
-	{
-		if (0 > (range_start = ts->sec - seconds))
-			range_start = 0;
+	zbx_vc_item_t	*item, new_item;
+	int 		ret = FAIL;
 
-		if (FAIL == (ret = vch_item_cache_values_by_time(&item, range_start)))
-			goto out;
+	RDLOCK_CACHE;
 
-		records_read = ret;
+	if (ZBX_VC_DISABLED == vc_state)
+		goto out;
 
-		vch_item_get_values_by_time(item, values, seconds, ts);
+	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+		vc_warn_low_memory();
 
-		if (records_read > values->values_num)
-			records_read = values->values_num;
-	}
-	else
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
 	{
-		range_start = (0 == seconds ? 0 : ts->sec - seconds);
-
-		if (FAIL == (ret = vch_item_cache_values_by_time_and_count(&item, range_start, count, ts)))
+		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
 			goto out;
 
-		records_read = ret;
+		memset(&new_item, 0, sizeof(new_item));
+		new_item.itemid = itemid;
+		new_item.value_type = value_type;
+		item = &new_item;
+	}
+	else if (item->value_type != value_type)
+		goto out;
 
-		vch_item_get_values_by_time_and_count(item, values, seconds, count, ts);
+	ret = vch_item_read_values(item, seconds, count, ts, span_func, data);
+out:
+	if (FAIL == ret)
+	{
+		zbx_vector_history_record_t	values;
 
-		if (records_read > values->values_num)
-			records_read = values->values_num;
-	}
+		zbx_history_record_vector_create(&values);
 
-	hits = values->values_num - records_read;
-	misses = records_read;
+		UNLOCK_CACHE;
 
-	vc_cache_item_update(item->itemid, ZBX_VC_UPDATE_STATS, hits, misses);
+		if (SUCCEED == (ret = vc_db_get_values(itemid, value_type, &values, seconds, count, ts)))
+		{
+			int	i;
 
-	ret = SUCCEED;
-out:
-	return ret;
-}
+			for (i = 0; i < values.values_num; i++)
+				span_func(&values.values[i], 1, value_type, data);
+		}
 
-/******************************************************************************
- *                                                                            *
- * Purpose: frees resources allocated for item history data                   *
- *                                                                            *
- * Parameters: item    - [IN] the item                                        *
- *                                                                            *
- * Return value: the size of freed memory (bytes)                             *
- *                                                                            *
- ******************************************************************************/
-static size_t	vch_item_free_cache(zbx_vc_item_t *item)
-{
-	size_t	freed = 0;
+		WRLOCK_CACHE;
 
-	zbx_vc_chunk_t	*chunk = item->tail;
+		if (ZBX_VC_DISABLED != vc_state)
+			vc_remove_item_by_id(itemid);
 
-	while (NULL != chunk)
-	{
-		zbx_vc_chunk_t	*next = chunk->next;
+		if (SUCCEED == ret)
+			vc_update_statistics(NULL, 0, values.values_num, (int)time(NULL));
 
-		freed += vch_item_free_chunk(item, chunk);
-		chunk = next;
+		zbx_history_record_vector_destroy(&values, value_type);
 	}
-	item->values_total = 0;
-	item->head = NULL;
-	item->tail = NULL;
 
-	return freed;
+	UNLOCK_CACHE;
+
+	return ret;
 }
 
 /******************************************************************************************************************
@@ -2389,6 +3477,8 @@ int	zbx_vc_init(zbx_uint64_t value_cache_size, char **error)
 		goto out;
 	}
 
+	zbx_shmem_slab_enable(vc_mem);
+
 	value_cache_size -= size_reserved;
 
 	vc_cache = (zbx_vc_cache_t *)__vc_shmem_malloc_func(vc_cache, sizeof(zbx_vc_cache_t));
@@ -2556,7 +3646,7 @@ int	zbx_vc_add_values(zbx_vector_dc_history_ptr_t *history, int *ret_flush, int
 			int			last_value_timestamp;
 
 			if (NULL != head)
-				last_value_timestamp = head->slots[head->last_value].timestamp.sec;
+				last_value_timestamp = vch_chunk_last_ts(head)->sec;
 			else
 				last_value_timestamp = (int)time(NULL);
 
@@ -2572,9 +3662,13 @@ int	zbx_vc_add_values(zbx_vector_dc_history_ptr_t *history, int *ret_flush, int
 				continue;
 			}
 
-			/* try to remove old (unused) chunks if a new chunk was added */
+			/* try to remove old (unused) chunks and compress the previous head chunk */
+			/* if a new chunk was added                                              */
 			if (head != item->head)
+			{
 				vch_item_clean_cache(item, last_value_timestamp);
+				vch_item_pack_chunks(item);
+			}
 		}
 	}
 
@@ -2705,6 +3799,98 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates aggregate function of item values for the specified    *
+ *          period without copying the values out of cache                    *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
+ *             func       - [IN] the aggregate function (ZBX_VC_AGGR_*)       *
+ *             value      - [OUT] the result - sum, minimum or maximum of the *
+ *                                item value type or average (dbl)            *
+ *             values_num - [OUT] the number of aggregated values             *
+ *                                                                            *
+ * Return value:  SUCCEED - the aggregate was calculated successfully         *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: Only ZBX_VC_AGGR_COUNT function supports non numeric items.      *
+ *           The value is not set if there were no values to aggregate,       *
+ *           except for sum, which is set to 0.                               *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, unsigned char value_type, int seconds, int count,
+		const zbx_timespec_t *ts, int func, zbx_history_value_t *value, int *values_num)
+{
+	zbx_vc_aggregate_t	aggr;
+	int			ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d func:%d count:%d period:%d"
+			" end_timestamp '%s'", __func__, itemid, value_type, func, count, seconds,
+			zbx_timespec_str(ts));
+
+	if (ITEM_VALUE_TYPE_BIN == value_type || (ZBX_VC_AGGR_COUNT != func &&
+			ITEM_VALUE_TYPE_FLOAT != value_type && ITEM_VALUE_TYPE_UINT64 != value_type))
+	{
+		return FAIL;
+	}
+
+	memset(&aggr, 0, sizeof(aggr));
+	aggr.func = func;
+
+	if (SUCCEED == (ret = vc_read_values(itemid, value_type, seconds, count, ts, vc_span_aggregate, &aggr)))
+	{
+		if (ZBX_VC_AGGR_AVG == func && ITEM_VALUE_TYPE_UINT64 == value_type && 0 != aggr.values_num)
+			aggr.value.dbl /= aggr.values_num;
+
+		if (ZBX_VC_AGGR_SUM == func || 0 != aggr.values_num)
+			*value = aggr.value;
+
+		*values_num = aggr.values_num;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d", __func__, zbx_result_string(ret), aggr.values_num);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get numeric item values for the specified period as doubles       *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type (float or unsigned)     *
+ *             values     - [OUT] the item values in descending order by      *
+ *                                timestamp                                   *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_get_values_dbl(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_dbl_t *values, int seconds,
+		int count, const zbx_timespec_t *ts)
+{
+	int	ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d count:%d period:%d end_timestamp"
+			" '%s'", __func__, itemid, value_type, count, seconds, zbx_timespec_str(ts));
+
+	if (ITEM_VALUE_TYPE_FLOAT != value_type && ITEM_VALUE_TYPE_UINT64 != value_type)
+		return FAIL;
+
+	ret = vc_read_values(itemid, value_type, seconds, count, ts, vc_span_append_dbl, values);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d", __func__, zbx_result_string(ret), values->values_num);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: retrieves usage cache statistics                                  *
@@ -2730,8 +3916,19 @@ int	zbx_vc_get_statistics(zbx_vc_stats_t *stats)
 	stats->total_size = vc_mem->total_size;
 	stats->free_size = vc_mem->free_size;
 
+	stats->compressed_values = vc_cache->packed_values;
+	stats->compressed_size = vc_cache->packed_size;
+
 	UNLOCK_CACHE;
 
+	if (0 != stats->compressed_size)
+	{
+		stats->compression_ratio = (double)(stats->compressed_values * sizeof(zbx_history_record_t)) /
+				stats->compressed_size;
+	}
+	else
+		stats->compression_ratio = 0;
+
 	return SUCCEED;
 }
 
@@ -803,6 +803,56 @@ ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len, short *event
 #define ZBX_TCP_HEADER_DATA	"ZBXD"
 #define ZBX_TCP_HEADER_LEN	ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA)
 
+#ifdef HAVE_ZSTD
+#	define ZBX_TCP_PROTOCOL_FLAGS	(ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS | ZBX_TCP_COMPRESS_ZSTD)
+#else
+#	define ZBX_TCP_PROTOCOL_FLAGS	(ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS)
+#endif
+
+static unsigned char	tcp_compress_method(int flags)
+{
+	return 0 != (flags & ZBX_TCP_COMPRESS_ZSTD) ? ZBX_COMPRESS_ZSTD : ZBX_COMPRESS_ZLIB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns compression flags to be used for sending data to peer     *
+ *                                                                            *
+ * Parameters: peer_zstd - [IN] SUCCEED - peer has advertised support of zstd *
+ *                                        with the same dictionary            *
+ *                              FAIL    - otherwise                           *
+ *                                                                            *
+ * Comments: Zstd is used only when it is configured for outgoing data and    *
+ *           peer has advertised it, otherwise data is compressed with zlib.  *
+ *                                                                            *
+ ******************************************************************************/
+unsigned char	zbx_tcp_compress_flags(int peer_zstd)
+{
+	if (SUCCEED == peer_zstd && ZBX_COMPRESS_ZSTD == zbx_compress_get_method())
+		return ZBX_TCP_COMPRESS | ZBX_TCP_COMPRESS_ZSTD;
+
+	return ZBX_TCP_COMPRESS;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compresses data with the method selected by protocol flags        *
+ *                                                                            *
+ * Parameters: flags    - [IN] protocol flags                                 *
+ *             in       - [IN] data to compress                               *
+ *             size_in  - [IN] input data size                                *
+ *             out      - [OUT] compressed data                               *
+ *             size_out - [OUT] compressed data size                          *
+ *                                                                            *
+ * Return value: SUCCEED - data was compressed successfully                   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_compress(unsigned char flags, const char *in, size_t size_in, char **out, size_t *size_out)
+{
+	return zbx_compress_ext(tcp_compress_method(flags), in, size_in, out, size_out);
+}
+
 int	zbx_tcp_send_context_init(const char *data, size_t len, size_t reserved, unsigned char flags,
 		zbx_tcp_send_context_t *context)
 {
@@ -839,7 +889,7 @@ int	zbx_tcp_send_context_init(const char *data, size_t len, size_t reserved, uns
 		/* compress if not compressed yet */
 		if (0 == reserved)
 		{
-			if (SUCCEED != zbx_compress(data, len, &context->compressed_data, &context->send_len))
+			if (SUCCEED != zbx_tcp_compress(flags, data, len, &context->compressed_data, &context->send_len))
 			{
 				zbx_set_socket_strerror("cannot compress data: %s", zbx_compress_strerror());
 
@@ -2008,6 +2058,7 @@ void	zbx_tcp_recv_context_init(zbx_socket_t *s, zbx_tcp_recv_context_t *tcp_recv
 #endif
 	zbx_socket_free(s);
 	tcp_recv_context->allocated = 0;
+	tcp_recv_context->stream = NULL;
 
 	s->buf_type = ZBX_BUF_TYPE_STAT;
 	s->buffer = s->buf_stat;
@@ -2031,7 +2082,21 @@ ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, u
 		else
 		{
 			if (context->buf_dyn_bytes + (size_t)nbytes <= context->expected_len)
-				memcpy(s->buffer + context->buf_dyn_bytes, s->buf_stat, (size_t)nbytes);
+			{
+				if (NULL != context->stream)
+				{
+					if (SUCCEED != zbx_uncompress_stream_write(context->stream, s->buf_stat,
+							(size_t)nbytes))
+					{
+						zbx_set_socket_strerror("cannot uncompress data: %s",
+								zbx_compress_strerror());
+						nbytes = ZBX_PROTO_ERROR;
+						goto out;
+					}
+				}
+				else
+					memcpy(s->buffer + context->buf_dyn_bytes, s->buf_stat, (size_t)nbytes);
+			}
 			context->buf_dyn_bytes += (size_t)nbytes;
 		}
 
@@ -2069,7 +2134,8 @@ ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, u
 			context->protocol_version = s->buf_stat[ZBX_TCP_HEADER_LEN];
 
 			if (0 == (context->protocol_version & ZBX_TCP_PROTOCOL) ||
-					context->protocol_version > (ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS | flags))
+					0 != (context->protocol_version & ~(ZBX_TCP_PROTOCOL_FLAGS | flags)) ||
+					ZBX_TCP_COMPRESS_ZSTD == (context->protocol_version & ZBX_TCP_COMPRESS_FLAGS))
 			{
 				/* invalid protocol version, abort receiving */
 				break;
@@ -2138,6 +2204,26 @@ ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, u
 				context->buf_stat_bytes -= context->offset;
 				memmove(s->buf_stat, s->buf_stat + context->offset, context->buf_stat_bytes);
 			}
+			else if (0 != (context->protocol_version & ZBX_TCP_COMPRESS) && NULL == events)
+			{
+				/* uncompress large message while receiving instead of buffering compressed data,  */
+				/* only in blocking mode as nonblocking receive can be abandoned by the caller     */
+				s->buf_type = ZBX_BUF_TYPE_DYN;
+				s->buffer = (char *)zbx_malloc(NULL, context->reserved + 1);
+				context->buf_dyn_bytes = context->buf_stat_bytes - context->offset;
+				context->buf_stat_bytes = 0;
+
+				context->stream = zbx_uncompress_stream_create(tcp_compress_method(context->protocol_version),
+						s->buffer, context->reserved);
+
+				if (NULL == context->stream || SUCCEED != zbx_uncompress_stream_write(context->stream,
+						s->buf_stat + context->offset, context->buf_dyn_bytes))
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+			}
 			else
 			{
 				s->buf_type = ZBX_BUF_TYPE_DYN;
@@ -2158,14 +2244,38 @@ ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, u
 	{
 		if (context->buf_stat_bytes + context->buf_dyn_bytes == context->expected_len)
 		{
-			if (0 != (context->protocol_version & ZBX_TCP_COMPRESS))
+			if (NULL != context->stream)
+			{
+				size_t	out_size;
+
+				if (SUCCEED != zbx_uncompress_stream_finish(context->stream, &out_size))
+				{
+					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+
+				if (out_size != context->reserved)
+				{
+					zbx_set_socket_strerror("size of uncompressed data is less than expected");
+					nbytes = ZBX_PROTO_ERROR;
+					goto out;
+				}
+
+				s->read_bytes = context->reserved;
+
+				zabbix_log(LOG_LEVEL_TRACE, "%s(): received " ZBX_FS_SIZE_T " bytes with"
+						" compression ratio %.1f", __func__, (zbx_fs_size_t)context->buf_dyn_bytes,
+						(double)context->reserved / (double)context->buf_dyn_bytes);
+			}
+			else if (0 != (context->protocol_version & ZBX_TCP_COMPRESS))
 			{
 				char	*out;
 				size_t	out_size = context->reserved;
 
 				out = (char *)zbx_malloc(NULL, context->reserved + 1);
-				if (FAIL == zbx_uncompress(s->buffer, context->buf_stat_bytes + context->buf_dyn_bytes,
-						out, &out_size))
+				if (FAIL == zbx_uncompress_ext(tcp_compress_method(context->protocol_version), s->buffer,
+						context->buf_stat_bytes + context->buf_dyn_bytes, out, &out_size))
 				{
 					zbx_free(out);
 					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
@@ -2250,6 +2360,12 @@ ssize_t	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context, u
 		s->buffer[s->read_bytes] = '\0';
 	}
 out:
+	if (NULL != context->stream)
+	{
+		zbx_uncompress_stream_free(context->stream);
+		context->stream = NULL;
+	}
+
 	return (ZBX_PROTO_ERROR == nbytes ? FAIL : (ssize_t)(s->read_bytes + context->offset));
 
 #undef ZBX_TCP_EXPECT_HEADER
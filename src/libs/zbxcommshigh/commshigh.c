@@ -187,17 +187,26 @@ exit:
  *                                                                            *
  * Purpose: send data to server                                               *
  *                                                                            *
+ * Parameters: sock           - [IN] connection socket                        *
+ *             buffer         - [IN/OUT] data to send, freed after sending    *
+ *             buffer_size    - [IN] data size                                *
+ *             reserved       - [IN] uncompressed data size if data is        *
+ *                                   already compressed                       *
+ *             compress_flags - [IN] protocol compression flags               *
+ *             error          - [OUT] error message                           *
+ *                                                                            *
  * Return value: SUCCEED - processed successfully                             *
  *               FAIL - an error occurred                                     *
  *                                                                            *
  ******************************************************************************/
-int	zbx_put_data_to_server(zbx_socket_t *sock, char **buffer, size_t buffer_size, size_t reserved, char **error)
+int	zbx_put_data_to_server(zbx_socket_t *sock, char **buffer, size_t buffer_size, size_t reserved,
+		unsigned char compress_flags, char **error)
 {
 	int	ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() datalen:" ZBX_FS_SIZE_T, __func__, (zbx_fs_size_t)buffer_size);
 
-	if (SUCCEED != zbx_tcp_send_ext(sock, *buffer, buffer_size, reserved, ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS, 0))
+	if (SUCCEED != zbx_tcp_send_ext(sock, *buffer, buffer_size, reserved, ZBX_TCP_PROTOCOL | compress_flags, 0))
 	{
 		*error = zbx_strdup(*error, zbx_socket_strerror());
 		goto out;
@@ -653,3 +662,49 @@ out:
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: advertises support of zstd compressed data to peer                *
+ *                                                                            *
+ * Comments: The advertised value is zstd dictionary identifier, peer sends   *
+ *           zstd compressed data only if its dictionary has the same         *
+ *           identifier.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tcp_zstd_advertise(struct zbx_json *j)
+{
+	unsigned int	dictid;
+
+	if (SUCCEED == zbx_compress_get_zstd_dictid(&dictid))
+		zbx_json_adduint64(j, ZBX_PROTO_TAG_ZSTD, dictid);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if peer has advertised support of zstd compressed data     *
+ *                                                                            *
+ * Parameters: jp - [IN] message received from peer                           *
+ *                                                                            *
+ * Return value: SUCCEED - peer can uncompress zstd data compressed with the  *
+ *                         local dictionary                                   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_zstd_accepted(const struct zbx_json_parse *jp)
+{
+	char		value[MAX_ID_LEN + 1];
+	unsigned int	dictid;
+	zbx_uint64_t	peer_dictid;
+
+	if (SUCCEED != zbx_compress_get_zstd_dictid(&dictid))
+		return FAIL;
+
+	if (SUCCEED != zbx_json_value_by_name(jp, ZBX_PROTO_TAG_ZSTD, value, sizeof(value), NULL))
+		return FAIL;
+
+	if (SUCCEED != zbx_is_uint64(value, &peer_dictid) || peer_dictid != dictid)
+		return FAIL;
+
+	return SUCCEED;
+}
@@ -19,9 +19,39 @@
 #ifdef HAVE_ZLIB
 #include "zlib.h"
 
+#ifdef HAVE_ZSTD
+#include "zstd.h"
+#endif
+
 #define ZBX_COMPRESS_STRERROR_LEN	512
 
-static int	zbx_zlib_errno = 0;
+static int		zbx_zlib_errno = 0;
+
+/* error of the last failed zstd or stream operation, NULL if the last error came from zlib */
+static const char	*zbx_compress_error = NULL;
+
+#ifdef HAVE_ZSTD
+#define ZBX_ZSTD_DICTIONARY_MAX	(16 * ZBX_MEBIBYTE)
+
+static int		zstd_level = 0;
+static ZSTD_CDict	*zstd_cdict = NULL;
+static ZSTD_DDict	*zstd_ddict = NULL;
+static ZSTD_CCtx	*zstd_cctx = NULL;
+static ZSTD_DCtx	*zstd_dctx = NULL;
+#endif
+
+struct zbx_uncompress_stream
+{
+	unsigned char	method;
+	unsigned char	finished;
+	char		*out;
+	size_t		out_size;
+	size_t		out_offset;
+	z_stream	zstream;
+#ifdef HAVE_ZSTD
+	ZSTD_DCtx	*dctx;
+#endif
+};
 
 /******************************************************************************
  *                                                                            *
@@ -32,6 +62,9 @@ const char	*zbx_compress_strerror(void)
 {
 	static char	message[ZBX_COMPRESS_STRERROR_LEN];
 
+	if (NULL != zbx_compress_error)
+		return zbx_compress_error;
+
 	switch (zbx_zlib_errno)
 	{
 		case Z_ERRNO:
@@ -54,6 +87,175 @@ const char	*zbx_compress_strerror(void)
 	return message;
 }
 
+#ifdef HAVE_ZSTD
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads zstd dictionary file                                        *
+ *                                                                            *
+ * Parameters: path  - [IN] dictionary file path                              *
+ *             data  - [OUT] dictionary contents                              *
+ *             size  - [OUT] dictionary size                                  *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the dictionary was read successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	zstd_read_dictionary(const char *path, char **data, size_t *size, char **error)
+{
+	int		fd, ret = FAIL;
+	struct stat	st;
+	ssize_t		nbytes;
+	size_t		offset = 0;
+
+	if (-1 == (fd = open(path, O_RDONLY)))
+	{
+		*error = zbx_dsprintf(NULL, "cannot open zstd dictionary \"%s\": %s", path, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if (0 != fstat(fd, &st))
+	{
+		*error = zbx_dsprintf(NULL, "cannot obtain zstd dictionary \"%s\" size: %s", path,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	if (0 == st.st_size || ZBX_ZSTD_DICTIONARY_MAX < st.st_size)
+	{
+		*error = zbx_dsprintf(NULL, "invalid zstd dictionary \"%s\" size " ZBX_FS_I64 " bytes", path,
+				(zbx_int64_t)st.st_size);
+		goto out;
+	}
+
+	*size = (size_t)st.st_size;
+	*data = (char *)zbx_malloc(NULL, *size);
+
+	while (offset < *size && 0 < (nbytes = read(fd, *data + offset, *size - offset)))
+		offset += (size_t)nbytes;
+
+	if (offset != *size)
+	{
+		*error = zbx_dsprintf(NULL, "cannot read zstd dictionary \"%s\"", path);
+		zbx_free(*data);
+		goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	close(fd);
+
+	return ret;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: configures zstd compression                                       *
+ *                                                                            *
+ * Parameters: level      - [IN] zstd compression level used for outgoing     *
+ *                               requests, 0 - outgoing requests use zlib     *
+ *             dictionary - [IN] path to zstd dictionary trained on the       *
+ *                               protocol data, can be NULL                   *
+ *             error      - [OUT] error message                               *
+ *                                                                            *
+ * Return value: SUCCEED - zstd compression was configured                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The dictionary must be the same on both ends of connection.      *
+ *           Data compressed with dictionary cannot be uncompressed by peer   *
+ *           without it.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_compress_init(int level, const char *dictionary, char **error)
+{
+#ifdef HAVE_ZSTD
+	char	*data;
+	size_t	size;
+	int	dict_level;
+
+	if (0 > level || ZSTD_maxCLevel() < level)
+	{
+		*error = zbx_dsprintf(NULL, "invalid zstd compression level %d", level);
+		return FAIL;
+	}
+
+	zstd_level = level;
+
+	if (NULL == dictionary || '\0' == *dictionary)
+		return SUCCEED;
+
+	if (SUCCEED != zstd_read_dictionary(dictionary, &data, &size, error))
+		return FAIL;
+
+	/* responses to zstd requests are compressed with default level if outgoing requests use zlib */
+	dict_level = (0 != zstd_level ? zstd_level : ZSTD_CLEVEL_DEFAULT);
+
+	zstd_cdict = ZSTD_createCDict(data, size, dict_level);
+	zstd_ddict = ZSTD_createDDict(data, size);
+	zbx_free(data);
+
+	if (NULL == zstd_cdict || NULL == zstd_ddict)
+	{
+		*error = zbx_dsprintf(NULL, "cannot load zstd dictionary \"%s\"", dictionary);
+		ZSTD_freeCDict(zstd_cdict);
+		ZSTD_freeDDict(zstd_ddict);
+		zstd_cdict = NULL;
+		zstd_ddict = NULL;
+
+		return FAIL;
+	}
+
+	return SUCCEED;
+#else
+	if (0 != level || (NULL != dictionary && '\0' != *dictionary))
+	{
+		*error = zbx_strdup(NULL, "zstd compression support is not compiled in");
+		return FAIL;
+	}
+
+	return SUCCEED;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns compression method configured for outgoing requests       *
+ *                                                                            *
+ ******************************************************************************/
+unsigned char	zbx_compress_get_method(void)
+{
+#ifdef HAVE_ZSTD
+	if (0 != zstd_level)
+		return ZBX_COMPRESS_ZSTD;
+#endif
+	return ZBX_COMPRESS_ZLIB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if zstd compressed data can be uncompressed                *
+ *                                                                            *
+ * Parameters: dictid - [OUT] identifier of the configured zstd dictionary,   *
+ *                            0 if dictionary is not used                     *
+ *                                                                            *
+ * Return value: SUCCEED - zstd support is compiled in                        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_compress_get_zstd_dictid(unsigned int *dictid)
+{
+#ifdef HAVE_ZSTD
+	*dictid = (NULL != zstd_ddict ? ZSTD_getDictID_fromDDict(zstd_ddict) : 0);
+
+	return SUCCEED;
+#else
+	ZBX_UNUSED(dictid);
+
+	return FAIL;
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: compress data                                                     *
@@ -75,6 +277,8 @@ int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
 	Bytef	*buf;
 	uLongf	buf_size;
 
+	zbx_compress_error = NULL;
+
 	buf_size = compressBound(size_in);
 	buf = (Bytef *)zbx_malloc(NULL, buf_size);
 
@@ -107,6 +311,8 @@ int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 {
 	uLongf	size_o = *size_out;
 
+	zbx_compress_error = NULL;
+
 	if (Z_OK != (zbx_zlib_errno = uncompress((Bytef *)out, &size_o, (const Bytef *)in, size_in)))
 		return FAIL;
 
@@ -115,8 +321,346 @@ int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 	return SUCCEED;
 }
 
+#ifdef HAVE_ZSTD
+static int	compress_zstd(const char *in, size_t size_in, char **out, size_t *size_out)
+{
+	char	*buf;
+	size_t	buf_size, ret;
+
+	if (NULL == zstd_cctx && NULL == (zstd_cctx = ZSTD_createCCtx()))
+	{
+		zbx_compress_error = "cannot create zstd compression context";
+		return FAIL;
+	}
+
+	buf_size = ZSTD_compressBound(size_in);
+	buf = (char *)zbx_malloc(NULL, buf_size);
+
+	if (NULL != zstd_cdict)
+		ret = ZSTD_compress_usingCDict(zstd_cctx, buf, buf_size, in, size_in, zstd_cdict);
+	else
+		ret = ZSTD_compressCCtx(zstd_cctx, buf, buf_size, in, size_in, 0 != zstd_level ? zstd_level :
+				ZSTD_CLEVEL_DEFAULT);
+
+	if (0 != ZSTD_isError(ret))
+	{
+		zbx_compress_error = ZSTD_getErrorName(ret);
+		zbx_free(buf);
+		return FAIL;
+	}
+
+	*out = buf;
+	*size_out = ret;
+
+	return SUCCEED;
+}
+
+static int	uncompress_zstd(const char *in, size_t size_in, char *out, size_t *size_out)
+{
+	size_t	ret;
+
+	if (NULL == zstd_dctx && NULL == (zstd_dctx = ZSTD_createDCtx()))
+	{
+		zbx_compress_error = "cannot create zstd decompression context";
+		return FAIL;
+	}
+
+	if (NULL != zstd_ddict)
+		ret = ZSTD_decompress_usingDDict(zstd_dctx, out, *size_out, in, size_in, zstd_ddict);
+	else
+		ret = ZSTD_decompressDCtx(zstd_dctx, out, *size_out, in, size_in);
+
+	if (0 != ZSTD_isError(ret))
+	{
+		zbx_compress_error = ZSTD_getErrorName(ret);
+		return FAIL;
+	}
+
+	*size_out = ret;
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compress data with the specified method                           *
+ *                                                                            *
+ * Parameters: method   - [IN] ZBX_COMPRESS_ZLIB or ZBX_COMPRESS_ZSTD         *
+ *             in       - [IN] the data to compress                           *
+ *             size_in  - [IN] the input data size                            *
+ *             out      - [OUT] the compressed data                           *
+ *             size_out - [OUT] the compressed data size                      *
+ *                                                                            *
+ * Return value: SUCCEED - the data was compressed successfully               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: In the case of success the output buffer must be freed by the    *
+ *           caller.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_compress_ext(unsigned char method, const char *in, size_t size_in, char **out, size_t *size_out)
+{
+	if (ZBX_COMPRESS_ZLIB == method)
+		return zbx_compress(in, size_in, out, size_out);
+#ifdef HAVE_ZSTD
+	if (ZBX_COMPRESS_ZSTD == method)
+		return compress_zstd(in, size_in, out, size_out);
+#endif
+	zbx_compress_error = "unsupported compression method";
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: uncompress data compressed with the specified method              *
+ *                                                                            *
+ * Parameters: method   - [IN] ZBX_COMPRESS_ZLIB or ZBX_COMPRESS_ZSTD         *
+ *             in       - [IN] the data to uncompress                         *
+ *             size_in  - [IN] the input data size                            *
+ *             out      - [OUT] the uncompressed data                         *
+ *             size_out - [IN/OUT] the buffer and uncompressed data size      *
+ *                                                                            *
+ * Return value: SUCCEED - the data was uncompressed successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_ext(unsigned char method, const char *in, size_t size_in, char *out, size_t *size_out)
+{
+	if (ZBX_COMPRESS_ZLIB == method)
+		return zbx_uncompress(in, size_in, out, size_out);
+#ifdef HAVE_ZSTD
+	if (ZBX_COMPRESS_ZSTD == method)
+		return uncompress_zstd(in, size_in, out, size_out);
+#endif
+	zbx_compress_error = "unsupported compression method";
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates stream uncompressing data into preallocated buffer        *
+ *                                                                            *
+ * Parameters: method   - [IN] ZBX_COMPRESS_ZLIB or ZBX_COMPRESS_ZSTD         *
+ *             out      - [IN] the output buffer                              *
+ *             out_size - [IN] the output buffer size                         *
+ *                                                                            *
+ * Return value: the created stream or NULL in the case of failure            *
+ *                                                                            *
+ * Comments: Allows to uncompress data as it is being received, without       *
+ *           buffering the whole compressed message.                          *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uncompress_stream_t	*zbx_uncompress_stream_create(unsigned char method, char *out, size_t out_size)
+{
+	zbx_uncompress_stream_t	*stream;
+
+	stream = (zbx_uncompress_stream_t *)zbx_malloc(NULL, sizeof(zbx_uncompress_stream_t));
+	memset(stream, 0, sizeof(zbx_uncompress_stream_t));
+
+	stream->method = method;
+	stream->out = out;
+	stream->out_size = out_size;
+
+	switch (method)
+	{
+		case ZBX_COMPRESS_ZLIB:
+			zbx_compress_error = NULL;
+
+			if (Z_OK != (zbx_zlib_errno = inflateInit(&stream->zstream)))
+				goto fail;
+			break;
+#ifdef HAVE_ZSTD
+		case ZBX_COMPRESS_ZSTD:
+			if (NULL == (stream->dctx = ZSTD_createDCtx()))
+			{
+				zbx_compress_error = "cannot create zstd decompression context";
+				goto fail;
+			}
+
+			if (NULL != zstd_ddict)
+				ZSTD_DCtx_refDDict(stream->dctx, zstd_ddict);
+			break;
+#endif
+		default:
+			zbx_compress_error = "unsupported compression method";
+			goto fail;
+	}
+
+	return stream;
+fail:
+	zbx_free(stream);
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: uncompresses next chunk of data                                   *
+ *                                                                            *
+ * Parameters: stream  - [IN] the uncompression stream                        *
+ *             in      - [IN] the compressed data chunk                       *
+ *             size_in - [IN] the chunk size                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the chunk was uncompressed successfully            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_stream_write(zbx_uncompress_stream_t *stream, const char *in, size_t size_in)
+{
+	if (0 == size_in)
+		return SUCCEED;
+
+	if (0 != stream->finished)
+	{
+		zbx_compress_error = "unexpected data after the end of compressed stream";
+		return FAIL;
+	}
+
+	if (ZBX_COMPRESS_ZLIB == stream->method)
+	{
+		int	ret;
+
+		zbx_compress_error = NULL;
+
+		stream->zstream.next_in = (Bytef *)in;
+		stream->zstream.avail_in = (uInt)size_in;
+		stream->zstream.next_out = (Bytef *)stream->out + stream->out_offset;
+		stream->zstream.avail_out = (uInt)(stream->out_size - stream->out_offset);
+
+		ret = inflate(&stream->zstream, Z_NO_FLUSH);
+		stream->out_offset = stream->out_size - stream->zstream.avail_out;
+
+		if (Z_STREAM_END == ret)
+		{
+			stream->finished = 1;
+
+			if (0 != stream->zstream.avail_in)
+			{
+				zbx_compress_error = "unexpected data after the end of compressed stream";
+				return FAIL;
+			}
+
+			return SUCCEED;
+		}
+
+		if (Z_OK != ret || 0 != stream->zstream.avail_in)
+		{
+			zbx_zlib_errno = (Z_OK == ret ? Z_BUF_ERROR : ret);
+			return FAIL;
+		}
+
+		return SUCCEED;
+	}
+#ifdef HAVE_ZSTD
+	else
+	{
+		ZSTD_inBuffer	input = {in, size_in, 0};
+		ZSTD_outBuffer	output = {stream->out, stream->out_size, stream->out_offset};
+		size_t		ret;
+
+		while (input.pos < input.size)
+		{
+			size_t	pos_in = input.pos, pos_out = output.pos;
+
+			ret = ZSTD_decompressStream(stream->dctx, &output, &input);
+			stream->out_offset = output.pos;
+
+			if (0 != ZSTD_isError(ret))
+			{
+				zbx_compress_error = ZSTD_getErrorName(ret);
+				return FAIL;
+			}
+
+			if (0 == ret)
+			{
+				stream->finished = 1;
+
+				if (input.pos < input.size)
+				{
+					zbx_compress_error = "unexpected data after the end of compressed stream";
+					return FAIL;
+				}
+			}
+			else if (pos_in == input.pos && pos_out == output.pos)
+			{
+				zbx_compress_error = "not enough space in output buffer";
+				return FAIL;
+			}
+		}
+
+		return SUCCEED;
+	}
+#else
+	zbx_compress_error = "unsupported compression method";
+
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks that the whole compressed stream has been uncompressed     *
+ *                                                                            *
+ * Parameters: stream   - [IN] the uncompression stream                       *
+ *             size_out - [OUT] the uncompressed data size                    *
+ *                                                                            *
+ * Return value: SUCCEED - the stream was uncompressed successfully           *
+ *               FAIL    - the compressed stream is incomplete                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_uncompress_stream_finish(zbx_uncompress_stream_t *stream, size_t *size_out)
+{
+	if (0 == stream->finished)
+	{
+		zbx_compress_error = "compressed stream is incomplete";
+		return FAIL;
+	}
+
+	*size_out = stream->out_offset;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: frees uncompression stream, the output buffer is not freed        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_uncompress_stream_free(zbx_uncompress_stream_t *stream)
+{
+	if (ZBX_COMPRESS_ZLIB == stream->method)
+		inflateEnd(&stream->zstream);
+#ifdef HAVE_ZSTD
+	else
+		ZSTD_freeDCtx(stream->dctx);
+#endif
+	zbx_free(stream);
+}
+
 #else
 
+int	zbx_compress_init(int level, const char *dictionary, char **error)
+{
+	ZBX_UNUSED(level);
+	ZBX_UNUSED(dictionary);
+	ZBX_UNUSED(error);
+	return SUCCEED;
+}
+
+unsigned char	zbx_compress_get_method(void)
+{
+	return ZBX_COMPRESS_ZLIB;
+}
+
+int	zbx_compress_get_zstd_dictid(unsigned int *dictid)
+{
+	ZBX_UNUSED(dictid);
+	return FAIL;
+}
+
 int	zbx_compress(const char *in, size_t size_in, char **out, size_t *size_out)
 {
 	ZBX_UNUSED(in);
@@ -135,6 +679,46 @@ int	zbx_uncompress(const char *in, size_t size_in, char *out, size_t *size_out)
 	return FAIL;
 }
 
+int	zbx_compress_ext(unsigned char method, const char *in, size_t size_in, char **out, size_t *size_out)
+{
+	ZBX_UNUSED(method);
+	return zbx_compress(in, size_in, out, size_out);
+}
+
+int	zbx_uncompress_ext(unsigned char method, const char *in, size_t size_in, char *out, size_t *size_out)
+{
+	ZBX_UNUSED(method);
+	return zbx_uncompress(in, size_in, out, size_out);
+}
+
+zbx_uncompress_stream_t	*zbx_uncompress_stream_create(unsigned char method, char *out, size_t out_size)
+{
+	ZBX_UNUSED(method);
+	ZBX_UNUSED(out);
+	ZBX_UNUSED(out_size);
+	return NULL;
+}
+
+int	zbx_uncompress_stream_write(zbx_uncompress_stream_t *stream, const char *in, size_t size_in)
+{
+	ZBX_UNUSED(stream);
+	ZBX_UNUSED(in);
+	ZBX_UNUSED(size_in);
+	return FAIL;
+}
+
+int	zbx_uncompress_stream_finish(zbx_uncompress_stream_t *stream, size_t *size_out)
+{
+	ZBX_UNUSED(stream);
+	ZBX_UNUSED(size_out);
+	return FAIL;
+}
+
+void	zbx_uncompress_stream_free(zbx_uncompress_stream_t *stream)
+{
+	ZBX_UNUSED(stream);
+}
+
 const char	*zbx_compress_strerror(void)
 {
 	return "";
@@ -63,6 +63,8 @@ void	zbx_connector_send(zbx_uint32_t code, unsigned char *data, zbx_uint32_t siz
 			zabbix_log(LOG_LEVEL_CRIT, "cannot connect to connector manager service: %s", error);
 			exit(EXIT_FAILURE);
 		}
+
+		(void)zbx_ipc_socket_enable_shm(&socket);
 	}
 
 	if (FAIL == zbx_ipc_socket_write(&socket, code, data, size))
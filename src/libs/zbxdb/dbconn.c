@@ -20,6 +20,8 @@
 #include "zbxnum.h"
 #include "zbxstr.h"
 #include "zbxtime.h"
+#include "zbxcrypto.h"
+#include "zbxshmem.h"
 
 #if defined(HAVE_POSTGRESQL)
 #	define ZBX_PG_READ_ONLY	"25006"
@@ -56,11 +58,18 @@ static zbx_mutex_t		db_sqlite_access = ZBX_MUTEX_NULL;
 
 #define ZBX_DB_WAIT_DOWN	10
 
+/* prepared statement cache statistics, shared by all processes */
+static zbx_shmem_info_t		*stmt_stats_mem = NULL;
+static zbx_db_stmt_stats_t	*stmt_stats = NULL;
+
 static int	dbconn_execute(zbx_dbconn_t *db, const char *fmt, ...);
 static zbx_db_result_t	dbconn_select(zbx_dbconn_t *db, const char *fmt, ...);
 static int	dbconn_open(zbx_dbconn_t *db);
 static void	dbconn_errlog(zbx_dbconn_t *db, zbx_err_codes_t zbx_errno, int db_errno, const char *db_error,
 		const char *context);
+static void	dbconn_stmts_create(zbx_dbconn_t *db);
+static void	dbconn_stmts_destroy(zbx_dbconn_t *db);
+static void	dbconn_stmts_reset(zbx_dbconn_t *db);
 
 /*
  * Private API
@@ -70,7 +79,16 @@ int	dbconn_init(char **error)
 {
 #if defined(HAVE_SQLITE3)
 	zbx_stat_t	buf;
+#endif
+	if (SUCCEED != zbx_shmem_create_min(&stmt_stats_mem, sizeof(zbx_db_stmt_stats_t),
+			"database statement statistics", NULL, 0, error))
+	{
+		return FAIL;
+	}
 
+	stmt_stats = (zbx_db_stmt_stats_t *)stmt_stats_mem->base;
+	memset(stmt_stats, 0, sizeof(zbx_db_stmt_stats_t));
+#if defined(HAVE_SQLITE3)
 	if (SUCCEED != zbx_mutex_create(&db_sqlite_access, ZBX_MUTEX_SQLITE3, error))
 		return FAIL;
 
@@ -114,6 +132,13 @@ void	dbconn_deinit(void)
 #if defined(HAVE_SQLITE3)
 	zbx_mutex_destroy(&db_sqlite_access);
 #endif
+	stmt_stats = NULL;
+
+	if (NULL != stmt_stats_mem)
+	{
+		zbx_shmem_destroy(stmt_stats_mem);
+		stmt_stats_mem = NULL;
+	}
 }
 
 /******************************************************************************
@@ -277,6 +302,38 @@ static void	db_get_postgresql_error(char **error, const PGresult *pg_result)
 		zbx_snprintf_alloc(error, &error_alloc, &error_offset, ":%s", result_error_msg);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: logs error of failed non-select statement                         *
+ *                                                                            *
+ * Parameters: db        - [IN] database connection                           *
+ *             pg_result - [IN] failed statement result                       *
+ *             sql       - [IN] statement for error message                   *
+ *                                                                            *
+ * Return value: ZBX_DB_DOWN - recoverable error                              *
+ *               ZBX_DB_FAIL - otherwise                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbconn_pg_execute_error(zbx_dbconn_t *db, const PGresult *pg_result, const char *sql)
+{
+	zbx_err_codes_t	errcode;
+	char		*error = NULL;
+
+	db_get_postgresql_error(&error, pg_result);
+
+	if (0 == zbx_strcmp_null(PQresultErrorField(pg_result, PG_DIAG_SQLSTATE), ZBX_PG_UNIQUE_VIOLATION))
+		errcode = ERR_Z3008;
+	else if (0 == zbx_strcmp_null(PQresultErrorField(pg_result, PG_DIAG_SQLSTATE), ZBX_PG_READ_ONLY))
+		errcode = ERR_Z3009;
+	else
+		errcode = ERR_Z3005;
+
+	dbconn_errlog(db, errcode, 0, error, sql);
+	zbx_free(error);
+
+	return SUCCEED == dbconn_is_recoverable_error(db, pg_result) ? ZBX_DB_DOWN : ZBX_DB_FAIL;
+}
+
 #endif
 
 /******************************************************************************
@@ -305,6 +362,7 @@ static void	dbconn_close(zbx_dbconn_t *db)
 		db->conn = NULL;
 	}
 #endif
+	dbconn_stmts_reset(db);
 }
 
 /******************************************************************************
@@ -737,7 +795,6 @@ static int	dbconn_vexecute(zbx_dbconn_t *db, const char *fmt, va_list args)
 	double		sec = 0;
 #if defined(HAVE_POSTGRESQL)
 	PGresult	*result;
-	char		*error = NULL;
 #elif defined(HAVE_SQLITE3)
 	int		err;
 	char		*error = NULL;
@@ -824,21 +881,7 @@ static int	dbconn_vexecute(zbx_dbconn_t *db, const char *fmt, va_list args)
 	}
 	else if (PGRES_COMMAND_OK != PQresultStatus(result))
 	{
-		zbx_err_codes_t	errcode;
-
-		db_get_postgresql_error(&error, result);
-
-		if (0 == zbx_strcmp_null(PQresultErrorField(result, PG_DIAG_SQLSTATE), ZBX_PG_UNIQUE_VIOLATION))
-			errcode = ERR_Z3008;
-		else if (0 == zbx_strcmp_null(PQresultErrorField(result, PG_DIAG_SQLSTATE), ZBX_PG_READ_ONLY))
-			errcode = ERR_Z3009;
-		else
-			errcode = ERR_Z3005;
-
-		dbconn_errlog(db, errcode, 0, error, sql);
-		zbx_free(error);
-
-		ret = (SUCCEED == dbconn_is_recoverable_error(db, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+		ret = dbconn_pg_execute_error(db, result, sql);
 	}
 
 	if (ZBX_DB_OK == ret)
@@ -1276,6 +1319,8 @@ zbx_dbconn_t	*zbx_dbconn_create(void)
 #if defined(HAVE_SQLITE3)
 	db->sqlite_access = &db_sqlite_access;
 #endif
+	dbconn_stmts_create(db);
+
 	return db;
 }
 
@@ -1287,6 +1332,7 @@ zbx_dbconn_t	*zbx_dbconn_create(void)
 void	zbx_dbconn_free(zbx_dbconn_t *db)
 {
 	dbconn_close(db);
+	dbconn_stmts_destroy(db);
 	zbx_free(db->last_db_strerror);
 
 	zbx_free(db);
@@ -1513,6 +1559,1296 @@ int	zbx_dbconn_execute(zbx_dbconn_t *db, const char *fmt, ...)
 	return rc;
 }
 
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+
+#define ZBX_DB_BULK_BUFFER_SIZE		(256 * ZBX_KIBIBYTE)
+#if defined(HAVE_MYSQL)
+#	define ZBX_DB_BULK_MAX_ROWS		1000
+#	define ZBX_DB_BULK_MAX_PARAMS		UINT16_MAX
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if field values can be passed with bulk load protocol      *
+ *                                                                            *
+ ******************************************************************************/
+int	dbconn_field_bulk_load_supported(const zbx_db_field_t *field)
+{
+	if (0 != (field->flags & ZBX_UPPER))
+		return FAIL;
+
+	switch (field->type)
+	{
+		case ZBX_TYPE_INT:
+		case ZBX_TYPE_FLOAT:
+		case ZBX_TYPE_UINT:
+		case ZBX_TYPE_ID:
+		case ZBX_TYPE_CHAR:
+		case ZBX_TYPE_TEXT:
+		case ZBX_TYPE_LONGTEXT:
+		case ZBX_TYPE_CUID:
+		case ZBX_TYPE_BLOB:
+			return SUCCEED;
+		default:
+			return FAIL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: decodes base64 encoded binary field value                         *
+ *                                                                            *
+ * Parameters: src  - [IN] base64 encoded value                               *
+ *             len  - [OUT] decoded value length                              *
+ *                                                                            *
+ * Return value: decoded value, must be freed by caller                       *
+ *                                                                            *
+ ******************************************************************************/
+static char	*dbconn_bulk_decode_blob(const char *src, size_t *len)
+{
+	size_t	size = strlen(src) * 3 / 4 + 1;
+	char	*dst;
+
+	dst = (char *)zbx_malloc(NULL, size);
+	zbx_base64_decode(src, dst, size, len);
+
+	return dst;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates bulk load statement prefix for logging and preparing      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbconn_bulk_fields(char **sql, size_t *sql_alloc, size_t *sql_offset, const zbx_db_table_t *table,
+		const zbx_vector_const_db_field_ptr_t *fields)
+{
+	zbx_strcpy_alloc(sql, sql_alloc, sql_offset, table->table);
+	zbx_strcpy_alloc(sql, sql_alloc, sql_offset, " (");
+
+	for (int i = 0; i < fields->values_num; i++)
+	{
+		if (0 != i)
+			zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, ',');
+
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, fields->values[i]->name);
+	}
+}
+
+#if defined(HAVE_POSTGRESQL)
+
+/* binary COPY format signature, followed by 32-bit flags and header extension length */
+static const char	copy_signature[] = {'P', 'G', 'C', 'O', 'P', 'Y', '\n', '\377', '\r', '\n', '\0'};
+
+static void	dbconn_copy_put(char **buf, size_t *alloc, size_t *offset, const void *data, size_t len)
+{
+	if (*alloc < *offset + len)
+	{
+		while (*alloc < *offset + len)
+			*alloc *= 2;
+
+		*buf = (char *)zbx_realloc(*buf, *alloc);
+	}
+
+	memcpy(*buf + *offset, data, len);
+	*offset += len;
+}
+
+static void	dbconn_copy_put_int16(char **buf, size_t *alloc, size_t *offset, int value)
+{
+	uint16_t	value_be = htons((uint16_t)value);
+
+	dbconn_copy_put(buf, alloc, offset, &value_be, sizeof(value_be));
+}
+
+static void	dbconn_copy_put_int32(char **buf, size_t *alloc, size_t *offset, int value)
+{
+	uint32_t	value_be = htonl((uint32_t)value);
+
+	dbconn_copy_put(buf, alloc, offset, &value_be, sizeof(value_be));
+}
+
+static void	dbconn_copy_put_int64(char **buf, size_t *alloc, size_t *offset, zbx_uint64_t value)
+{
+	dbconn_copy_put_int32(buf, alloc, offset, (int)(value >> 32));
+	dbconn_copy_put_int32(buf, alloc, offset, (int)(value & __UINT64_C(0xffffffff)));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes unsigned integer in binary numeric format                  *
+ *                                                                            *
+ * Comments: Numeric is sent as number of base 10000 digits, weight of the    *
+ *           first digit, sign and display scale followed by the digits with  *
+ *           trailing zero digits omitted.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbconn_copy_put_numeric(char **buf, size_t *alloc, size_t *offset, zbx_uint64_t value)
+{
+	int	digits[5], digits_num = 0, last = 0;
+
+	for (; 0 != value; value /= 10000)
+		digits[digits_num++] = (int)(value % 10000);
+
+	while (last < digits_num && 0 == digits[last])
+		last++;
+
+	dbconn_copy_put_int32(buf, alloc, offset, 8 + (digits_num - last) * 2);
+	dbconn_copy_put_int16(buf, alloc, offset, digits_num - last);
+	dbconn_copy_put_int16(buf, alloc, offset, 0 == digits_num ? 0 : digits_num - 1);
+	dbconn_copy_put_int16(buf, alloc, offset, 0);	/* positive sign */
+	dbconn_copy_put_int16(buf, alloc, offset, 0);	/* display scale */
+
+	while (digits_num-- > last)
+		dbconn_copy_put_int16(buf, alloc, offset, digits[digits_num]);
+}
+
+static void	dbconn_copy_put_str(char **buf, size_t *alloc, size_t *offset, const char *str, size_t len)
+{
+	dbconn_copy_put_int32(buf, alloc, offset, (int)len);
+	dbconn_copy_put(buf, alloc, offset, str, len);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes row in binary COPY format                                  *
+ *                                                                            *
+ * Comments: ZBX_TYPE_UINT fields are numeric(20) on PostgreSQL.              *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbconn_copy_put_row(char **buf, size_t *alloc, size_t *offset,
+		const zbx_vector_const_db_field_ptr_t *fields, const zbx_db_value_t *row)
+{
+	dbconn_copy_put_int16(buf, alloc, offset, fields->values_num);
+
+	for (int i = 0; i < fields->values_num; i++)
+	{
+		const zbx_db_value_t	*value = &row[i];
+		char			*bin;
+		size_t			bin_len;
+
+		switch (fields->values[i]->type)
+		{
+			case ZBX_TYPE_INT:
+				dbconn_copy_put_int32(buf, alloc, offset, (int)sizeof(uint32_t));
+				dbconn_copy_put_int32(buf, alloc, offset, value->i32);
+				break;
+			case ZBX_TYPE_FLOAT:
+				{
+					zbx_uint64_t	dbl_bits;
+
+					memcpy(&dbl_bits, &value->dbl, sizeof(dbl_bits));
+					dbconn_copy_put_int32(buf, alloc, offset, (int)sizeof(zbx_uint64_t));
+					dbconn_copy_put_int64(buf, alloc, offset, dbl_bits);
+				}
+				break;
+			case ZBX_TYPE_ID:
+				dbconn_copy_put_int32(buf, alloc, offset, (int)sizeof(zbx_uint64_t));
+				dbconn_copy_put_int64(buf, alloc, offset, value->ui64);
+				break;
+			case ZBX_TYPE_UINT:
+				dbconn_copy_put_numeric(buf, alloc, offset, value->ui64);
+				break;
+			case ZBX_TYPE_BLOB:
+				bin = dbconn_bulk_decode_blob(value->str, &bin_len);
+				dbconn_copy_put_str(buf, alloc, offset, bin, bin_len);
+				zbx_free(bin);
+				break;
+			default:
+				dbconn_copy_put_str(buf, alloc, offset, value->str, strlen(value->str));
+				break;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: streams rows into table with binary COPY FROM STDIN               *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows inserted (on success)                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbconn_copy(zbx_dbconn_t *db, const char *sql, const zbx_vector_const_db_field_ptr_t *fields,
+		const zbx_vector_db_value_ptr_t *rows)
+{
+	PGresult	*result;
+	char		*buf;
+	size_t		buf_alloc = ZBX_DB_BULK_BUFFER_SIZE, buf_offset = 0;
+	int		ret = ZBX_DB_OK;
+	const char	*error = NULL;
+
+	result = PQexec(db->conn, sql);
+
+	if (PGRES_COPY_IN != PQresultStatus(result))
+	{
+		if (NULL == result)
+		{
+			dbconn_errlog(db, ERR_Z3005, 0, "result is NULL", sql);
+			ret = (CONNECTION_OK == PQstatus(db->conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+		}
+		else
+			ret = dbconn_pg_execute_error(db, result, sql);
+
+		PQclear(result);
+
+		return ret;
+	}
+
+	PQclear(result);
+
+	buf = (char *)zbx_malloc(NULL, buf_alloc);
+
+	dbconn_copy_put(&buf, &buf_alloc, &buf_offset, copy_signature, sizeof(copy_signature));
+	dbconn_copy_put_int32(&buf, &buf_alloc, &buf_offset, 0);
+	dbconn_copy_put_int32(&buf, &buf_alloc, &buf_offset, 0);
+
+	for (int i = 0; i < rows->values_num; i++)
+	{
+		dbconn_copy_put_row(&buf, &buf_alloc, &buf_offset, fields, rows->values[i]);
+
+		if (ZBX_DB_BULK_BUFFER_SIZE > buf_offset)
+			continue;
+
+		if (1 != PQputCopyData(db->conn, buf, (int)buf_offset))
+		{
+			error = PQerrorMessage(db->conn);
+			break;
+		}
+
+		buf_offset = 0;
+	}
+
+	if (NULL == error)
+	{
+		/* file trailer */
+		dbconn_copy_put_int16(&buf, &buf_alloc, &buf_offset, -1);
+
+		if (1 != PQputCopyData(db->conn, buf, (int)buf_offset))
+			error = PQerrorMessage(db->conn);
+	}
+
+	zbx_free(buf);
+
+	if (1 != PQputCopyEnd(db->conn, NULL != error ? "cannot send data" : NULL) && NULL == error)
+		error = PQerrorMessage(db->conn);
+
+	while (NULL != (result = PQgetResult(db->conn)))
+	{
+		if (PGRES_COMMAND_OK != PQresultStatus(result))
+		{
+			if (NULL == error)
+				ret = dbconn_pg_execute_error(db, result, sql);
+		}
+		else if (ZBX_DB_OK == ret)
+			ret = atoi(PQcmdTuples(result));
+
+		PQclear(result);
+	}
+
+	if (NULL != error)
+	{
+		dbconn_errlog(db, ERR_Z3005, 0, error, sql);
+		ret = (CONNECTION_OK == PQstatus(db->conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+	}
+
+	return ret;
+}
+
+#elif defined(HAVE_MYSQL)
+
+static void	dbconn_stmt_error(zbx_dbconn_t *db, MYSQL_STMT *stmt, const char *sql, int *ret)
+{
+	int		err_no = (int)mysql_stmt_errno(stmt);
+	zbx_err_codes_t	errcode = (ER_DUP_ENTRY == err_no ? ERR_Z3008 : ERR_Z3005);
+
+	db->error_count++;
+
+	if (FAIL == dbconn_is_inhibited_error(db, err_no))
+		dbconn_errlog(db, errcode, err_no, mysql_stmt_error(stmt), sql);
+
+	*ret = (SUCCEED == dbconn_is_recoverable_error(db, err_no) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares multi-row insert statement for the specified number of   *
+ *          rows                                                              *
+ *                                                                            *
+ ******************************************************************************/
+static MYSQL_STMT	*dbconn_stmt_prepare(zbx_dbconn_t *db, const char *sql, const char *sql_row, int rows_num,
+		int *ret)
+{
+	MYSQL_STMT	*stmt;
+	char		*stmt_sql = NULL;
+	size_t		stmt_sql_alloc = 0, stmt_sql_offset = 0;
+
+	if (NULL == (stmt = mysql_stmt_init(db->conn)))
+	{
+		dbconn_errlog(db, ERR_Z3005, (int)mysql_errno(db->conn), mysql_error(db->conn), sql);
+		*ret = ZBX_DB_FAIL;
+		return NULL;
+	}
+
+	zbx_strcpy_alloc(&stmt_sql, &stmt_sql_alloc, &stmt_sql_offset, sql);
+
+	for (int i = 0; i < rows_num; i++)
+	{
+		if (0 != i)
+			zbx_chrcpy_alloc(&stmt_sql, &stmt_sql_alloc, &stmt_sql_offset, ',');
+
+		zbx_strcpy_alloc(&stmt_sql, &stmt_sql_alloc, &stmt_sql_offset, sql_row);
+	}
+
+	if (0 != mysql_stmt_prepare(stmt, stmt_sql, (unsigned long)stmt_sql_offset))
+	{
+		dbconn_stmt_error(db, stmt, sql, ret);
+		mysql_stmt_close(stmt);
+		stmt = NULL;
+	}
+
+	zbx_free(stmt_sql);
+
+	return stmt;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: binds row values to multi-row insert statement parameters         *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbconn_stmt_bind_row(MYSQL_BIND *bind, unsigned long *lengths, zbx_vector_ptr_t *blobs,
+		const zbx_vector_const_db_field_ptr_t *fields, zbx_db_value_t *row)
+{
+	for (int i = 0; i < fields->values_num; i++)
+	{
+		zbx_db_value_t	*value = &row[i];
+		size_t		len;
+
+		switch (fields->values[i]->type)
+		{
+			case ZBX_TYPE_INT:
+				bind[i].buffer_type = MYSQL_TYPE_LONG;
+				bind[i].buffer = &value->i32;
+				break;
+			case ZBX_TYPE_FLOAT:
+				bind[i].buffer_type = MYSQL_TYPE_DOUBLE;
+				bind[i].buffer = &value->dbl;
+				break;
+			case ZBX_TYPE_UINT:
+			case ZBX_TYPE_ID:
+				bind[i].buffer_type = MYSQL_TYPE_LONGLONG;
+				bind[i].buffer = &value->ui64;
+				bind[i].is_unsigned = 1;
+				break;
+			case ZBX_TYPE_BLOB:
+				bind[i].buffer_type = MYSQL_TYPE_BLOB;
+				bind[i].buffer = dbconn_bulk_decode_blob(value->str, &len);
+				zbx_vector_ptr_append(blobs, bind[i].buffer);
+				lengths[i] = (unsigned long)len;
+				bind[i].buffer_length = lengths[i];
+				bind[i].length = &lengths[i];
+				break;
+			default:
+				bind[i].buffer_type = MYSQL_TYPE_STRING;
+				bind[i].buffer = value->str;
+				lengths[i] = (unsigned long)strlen(value->str);
+				bind[i].buffer_length = lengths[i];
+				bind[i].length = &lengths[i];
+				break;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: inserts rows with prepared multi-row statements                   *
+ *                                                                            *
+ * Parameters: db      - [IN] database connection                             *
+ *             sql     - [IN] insert statement up to the values list          *
+ *             sql_row - [IN] placeholder list of single row                  *
+ *             fields  - [IN] inserted fields                                 *
+ *             rows    - [IN] rows to insert                                  *
+ *                                                                            *
+ * Comments: The statement is prepared once for the full batch size and       *
+ *           reused, the last partial batch uses a separate statement.        *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows inserted (on success)                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbconn_stmt_insert(zbx_dbconn_t *db, const char *sql, const char *sql_row,
+		const zbx_vector_const_db_field_ptr_t *fields, const zbx_vector_db_value_ptr_t *rows)
+{
+	MYSQL_STMT		*stmt = NULL;
+	MYSQL_BIND		*bind;
+	unsigned long		*lengths;
+	zbx_vector_ptr_t	blobs;
+	int			ret = ZBX_DB_OK, batch_max, stmt_rows = 0;
+
+	batch_max = MIN(ZBX_DB_BULK_MAX_ROWS, ZBX_DB_BULK_MAX_PARAMS / fields->values_num);
+
+	bind = (MYSQL_BIND *)zbx_malloc(NULL, sizeof(MYSQL_BIND) * (size_t)(batch_max * fields->values_num));
+	lengths = (unsigned long *)zbx_malloc(NULL, sizeof(unsigned long) * (size_t)(batch_max * fields->values_num));
+	zbx_vector_ptr_create(&blobs);
+
+	for (int i = 0; i < rows->values_num; i += batch_max)
+	{
+		int	batch_num = MIN(batch_max, rows->values_num - i);
+
+		if (stmt_rows != batch_num)
+		{
+			if (NULL != stmt)
+				mysql_stmt_close(stmt);
+
+			if (NULL == (stmt = dbconn_stmt_prepare(db, sql, sql_row, batch_num, &ret)))
+				break;
+
+			stmt_rows = batch_num;
+		}
+
+		memset(bind, 0, sizeof(MYSQL_BIND) * (size_t)(batch_num * fields->values_num));
+
+		for (int j = 0; j < batch_num; j++)
+		{
+			dbconn_stmt_bind_row(bind + j * fields->values_num, lengths + j * fields->values_num, &blobs,
+					fields, rows->values[i + j]);
+		}
+
+		if (0 != mysql_stmt_bind_param(stmt, bind) || 0 != mysql_stmt_execute(stmt))
+		{
+			dbconn_stmt_error(db, stmt, sql, &ret);
+			break;
+		}
+
+		ret += (int)mysql_stmt_affected_rows(stmt);
+
+		zbx_vector_ptr_clear_ext(&blobs, zbx_ptr_free);
+	}
+
+	if (NULL != stmt)
+		mysql_stmt_close(stmt);
+
+	zbx_vector_ptr_clear_ext(&blobs, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&blobs);
+	zbx_free(lengths);
+	zbx_free(bind);
+
+	return ret;
+}
+
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads rows into table with native database bulk load protocol     *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows inserted (on success)                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbconn_bulk_load_rows(zbx_dbconn_t *db, const zbx_db_table_t *table,
+		const zbx_vector_const_db_field_ptr_t *fields, const zbx_vector_db_value_ptr_t *rows)
+{
+	char	*sql = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	ret;
+	double	sec = 0;
+#if defined(HAVE_MYSQL)
+	char	*sql_row = NULL;
+	size_t	sql_row_alloc = 0, sql_row_offset = 0;
+#endif
+
+	if (0 != db->config->log_slow_queries)
+		sec = zbx_time();
+
+	if (0 == db->txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+#if defined(HAVE_POSTGRESQL)
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "copy ");
+	dbconn_bulk_fields(&sql, &sql_alloc, &sql_offset, table, fields);
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") from stdin with (format binary)");
+#else
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, "insert into ");
+	dbconn_bulk_fields(&sql, &sql_alloc, &sql_offset, table, fields);
+
+	for (int i = 0; i < fields->values_num; i++)
+		zbx_strcpy_alloc(&sql_row, &sql_row_alloc, &sql_row_offset, 0 == i ? "(?" : ",?");
+
+	/* MySQL workaround - explicitly add missing text fields with '' default value */
+	for (const zbx_db_field_t *field = table->fields; NULL != field->name; field++)
+	{
+		switch (field->type)
+		{
+			case ZBX_TYPE_BLOB:
+			case ZBX_TYPE_TEXT:
+			case ZBX_TYPE_LONGTEXT:
+			case ZBX_TYPE_CUID:
+				if (FAIL != zbx_vector_const_db_field_ptr_search(fields, field,
+						ZBX_DEFAULT_PTR_COMPARE_FUNC))
+				{
+					continue;
+				}
+
+				zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+				zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, field->name);
+				zbx_strcpy_alloc(&sql_row, &sql_row_alloc, &sql_row_offset, ",''");
+				break;
+		}
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") values ");
+	zbx_chrcpy_alloc(&sql_row, &sql_row_alloc, &sql_row_offset, ')');
+#endif
+
+	if (ZBX_DB_OK != db->txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring bulk load [txnlev:%d] [%s] within failed transaction",
+				db->txn_level, sql);
+		ret = ZBX_DB_FAIL;
+		goto clean;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "bulk load [txnlev:%d] [%s] rows:%d", db->txn_level, sql, rows->values_num);
+
+#if defined(HAVE_POSTGRESQL)
+	ret = dbconn_copy(db, sql, fields, rows);
+#else
+	if (NULL == db->conn)
+	{
+		dbconn_errlog(db, ERR_Z3003, 0, NULL, NULL);
+		ret = ZBX_DB_FAIL;
+	}
+	else
+		ret = dbconn_stmt_insert(db, sql, sql_row, fields, rows);
+#endif
+
+	if (0 != db->config->log_slow_queries)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)db->config->log_slow_queries / 1000.0)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\" rows:%d", sec, sql,
+					rows->values_num);
+		}
+	}
+
+	if (ZBX_DB_FAIL == ret && 0 < db->txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "bulk load [%s] failed, setting transaction as failed", sql);
+		db->txn_error = ZBX_DB_FAIL;
+	}
+clean:
+#if defined(HAVE_MYSQL)
+	zbx_free(sql_row);
+#endif
+	zbx_free(sql);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: loads rows into table with native database bulk load protocol     *
+ *                                                                            *
+ * Parameters: db     - [IN] database connection                              *
+ *             table  - [IN] target table                                     *
+ *             fields - [IN] inserted fields                                  *
+ *             rows   - [IN] rows to insert, string values must be unescaped  *
+ *                                                                            *
+ * Return value: SUCCEED - the rows were inserted                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: retry until DB is up                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	dbconn_bulk_load(zbx_dbconn_t *db, const zbx_db_table_t *table, const zbx_vector_const_db_field_ptr_t *fields,
+		const zbx_vector_db_value_ptr_t *rows)
+{
+	int	rc;
+
+	rc = dbconn_bulk_load_rows(db, table, fields, rows);
+
+	while (ZBX_DB_DOWN == rc && ZBX_DB_CONNECT_NORMAL == db->connect_options)
+	{
+		zbx_dbconn_close(db);
+		zbx_dbconn_open(db);
+
+		if (ZBX_DB_DOWN == (rc = dbconn_bulk_load_rows(db, table, fields, rows)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+			db->connection_failure = 1;
+			sleep(ZBX_DB_WAIT_DOWN);
+		}
+	}
+
+	return ZBX_DB_OK > rc ? FAIL : SUCCEED;
+}
+
+#endif	/* defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL) */
+
+/******************************************************************************
+ *                                                                            *
+ * prepared statement support                                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#define ZBX_DB_STMT_CACHE_MAX	256
+#define ZBX_DB_STMT_NUM_LEN	32
+
+struct zbx_db_stmt
+{
+	/* statement template with ? parameter placeholders, the cache key */
+	char			*sql;
+	zbx_dbconn_t		*db;
+
+	unsigned char		*types;
+	zbx_db_value_t		*values;
+	int			params_num;
+
+	zbx_uint64_t		lastuse;
+#if defined(HAVE_POSTGRESQL)
+	/* server side statement name, valid while prepared is set */
+	char			name[16];
+	int			prepared;
+
+	const char		**params;
+	char			*params_num_buf;
+#endif
+};
+
+#define DBCONN_STMT_STATS_INC(field)							\
+											\
+do											\
+{											\
+	if (NULL != stmt_stats)								\
+		__atomic_fetch_add(&stmt_stats->field, 1, __ATOMIC_RELAXED);		\
+}											\
+while (0)
+
+static zbx_hash_t	dbconn_stmt_hash(const void *data)
+{
+	const zbx_db_stmt_t	*stmt = *(const zbx_db_stmt_t * const *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(stmt->sql);
+}
+
+static int	dbconn_stmt_compare(const void *d1, const void *d2)
+{
+	const zbx_db_stmt_t	*stmt1 = *(const zbx_db_stmt_t * const *)d1;
+	const zbx_db_stmt_t	*stmt2 = *(const zbx_db_stmt_t * const *)d2;
+
+	return strcmp(stmt1->sql, stmt2->sql);
+}
+
+static void	dbconn_stmt_free(zbx_db_stmt_t *stmt)
+{
+#if defined(HAVE_POSTGRESQL)
+	zbx_free(stmt->params);
+	zbx_free(stmt->params_num_buf);
+#endif
+	zbx_free(stmt->values);
+	zbx_free(stmt->types);
+	zbx_free(stmt->sql);
+	zbx_free(stmt);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initializes prepared statement cache of a new connection          *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbconn_stmts_create(zbx_dbconn_t *db)
+{
+	zbx_hashset_create(&db->stmts, 0, dbconn_stmt_hash, dbconn_stmt_compare);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: releases prepared statement cache                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbconn_stmts_destroy(zbx_dbconn_t *db)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_db_stmt_t		**pstmt;
+
+	zbx_hashset_iter_reset(&db->stmts, &iter);
+
+	while (NULL != (pstmt = (zbx_db_stmt_t **)zbx_hashset_iter_next(&iter)))
+		dbconn_stmt_free(*pstmt);
+
+	zbx_hashset_destroy(&db->stmts);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: marks cached statements as not prepared after database session    *
+ *          was closed                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbconn_stmts_reset(zbx_dbconn_t *db)
+{
+#if defined(HAVE_POSTGRESQL)
+	zbx_hashset_iter_t	iter;
+	zbx_db_stmt_t		**pstmt;
+
+	zbx_hashset_iter_reset(&db->stmts, &iter);
+
+	while (NULL != (pstmt = (zbx_db_stmt_t **)zbx_hashset_iter_next(&iter)))
+		(*pstmt)->prepared = 0;
+#else
+	ZBX_UNUSED(db);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes least recently used statement from the cache              *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbconn_stmts_evict(zbx_dbconn_t *db)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_db_stmt_t		**pstmt, *stmt = NULL;
+
+	zbx_hashset_iter_reset(&db->stmts, &iter);
+
+	while (NULL != (pstmt = (zbx_db_stmt_t **)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL == stmt || (*pstmt)->lastuse < stmt->lastuse)
+			stmt = *pstmt;
+	}
+
+	if (NULL == stmt)
+		return;
+
+#if defined(HAVE_POSTGRESQL)
+	if (0 != stmt->prepared && ZBX_DB_OK == db->txn_error)
+		(void)dbconn_execute(db, "deallocate %s", stmt->name);
+#endif
+	zbx_hashset_remove(&db->stmts, &stmt);
+	dbconn_stmt_free(stmt);
+
+	DBCONN_STMT_STATS_INC(evictions);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets prepared statement from connection statement cache           *
+ *                                                                            *
+ * Parameters: db   - [IN] database connection                                *
+ *             sql  - [IN] statement template with ? parameter placeholders   *
+ *             args - [IN] parameter types (ZBX_TYPE_*), one for each         *
+ *                         placeholder                                        *
+ *                                                                            *
+ * Return value: cached statement                                             *
+ *                                                                            *
+ * Comments: Statement template must not contain ? characters other than the  *
+ *           parameter placeholders. Statements are owned by connection and   *
+ *           least recently used ones are removed when cache is full, so the  *
+ *           returned statement must be used before preparing other ones.     *
+ *                                                                            *
+ ******************************************************************************/
+zbx_db_stmt_t	*zbx_dbconn_vprepare(zbx_dbconn_t *db, const char *sql, va_list args)
+{
+	zbx_db_stmt_t	stmt_local, *stmt = &stmt_local, **pstmt;
+	const char	*ptr;
+
+	stmt_local.sql = (char *)sql;
+
+	if (NULL != (pstmt = (zbx_db_stmt_t **)zbx_hashset_search(&db->stmts, &stmt)))
+	{
+		(*pstmt)->lastuse = ++db->stmts_lastuse;
+		DBCONN_STMT_STATS_INC(hits);
+
+		return *pstmt;
+	}
+
+	DBCONN_STMT_STATS_INC(misses);
+
+	if (ZBX_DB_STMT_CACHE_MAX <= db->stmts.num_data)
+		dbconn_stmts_evict(db);
+
+	stmt = (zbx_db_stmt_t *)zbx_malloc(NULL, sizeof(zbx_db_stmt_t));
+	memset(stmt, 0, sizeof(zbx_db_stmt_t));
+
+	stmt->sql = zbx_strdup(NULL, sql);
+	stmt->db = db;
+	stmt->lastuse = ++db->stmts_lastuse;
+
+	for (ptr = sql; NULL != (ptr = strchr(ptr, '?')); ptr++)
+		stmt->params_num++;
+
+	if (0 != stmt->params_num)
+	{
+		stmt->types = (unsigned char *)zbx_malloc(NULL, (size_t)stmt->params_num);
+		stmt->values = (zbx_db_value_t *)zbx_malloc(NULL, sizeof(zbx_db_value_t) * (size_t)stmt->params_num);
+		memset(stmt->values, 0, sizeof(zbx_db_value_t) * (size_t)stmt->params_num);
+
+		for (int i = 0; i < stmt->params_num; i++)
+			stmt->types[i] = (unsigned char)va_arg(args, int);
+#if defined(HAVE_POSTGRESQL)
+		stmt->params = (const char **)zbx_malloc(NULL, sizeof(char *) * (size_t)stmt->params_num);
+		stmt->params_num_buf = (char *)zbx_malloc(NULL, ZBX_DB_STMT_NUM_LEN * (size_t)stmt->params_num);
+#endif
+	}
+
+#if defined(HAVE_POSTGRESQL)
+	zbx_snprintf(stmt->name, sizeof(stmt->name), "zbx_stmt_%d", ++db->stmts_nextid);
+#endif
+	zbx_hashset_insert(&db->stmts, &stmt, sizeof(stmt));
+
+	return stmt;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets prepared statement from connection statement cache           *
+ *                                                                            *
+ * Comments: Usage example:                                                   *
+ *             stmt = zbx_dbconn_prepare(db,                                  *
+ *                     "update hosts set name=? where hostid=?",              *
+ *                     ZBX_TYPE_CHAR, ZBX_TYPE_ID);                           *
+ *             zbx_db_stmt_bind(stmt, name, hostid);                          *
+ *             zbx_db_stmt_execute(stmt);                                     *
+ *                                                                            *
+ ******************************************************************************/
+zbx_db_stmt_t	*zbx_dbconn_prepare(zbx_dbconn_t *db, const char *sql, ...)
+{
+	va_list		args;
+	zbx_db_stmt_t	*stmt;
+
+	va_start(args, sql);
+	stmt = zbx_dbconn_vprepare(db, sql, args);
+	va_end(args);
+
+	return stmt;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: binds values to statement parameters                              *
+ *                                                                            *
+ * Parameters: stmt - [IN] prepared statement                                 *
+ *             ...  - [IN] parameter values in placeholder order, the value   *
+ *                         types must conform to the prepared parameter types *
+ *                                                                            *
+ * Comments: String values are not copied and must stay valid until the       *
+ *           statement is executed. Zero ZBX_TYPE_ID value is bound as NULL.  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_stmt_bind(zbx_db_stmt_t *stmt, ...)
+{
+	va_list	args;
+
+	va_start(args, stmt);
+
+	for (int i = 0; i < stmt->params_num; i++)
+	{
+		switch (stmt->types[i])
+		{
+			case ZBX_TYPE_CHAR:
+			case ZBX_TYPE_TEXT:
+			case ZBX_TYPE_LONGTEXT:
+			case ZBX_TYPE_CUID:
+				stmt->values[i].str = va_arg(args, char *);
+				break;
+			case ZBX_TYPE_INT:
+				stmt->values[i].i32 = va_arg(args, int);
+				break;
+			case ZBX_TYPE_FLOAT:
+				stmt->values[i].dbl = va_arg(args, double);
+				break;
+			case ZBX_TYPE_UINT:
+			case ZBX_TYPE_ID:
+				stmt->values[i].ui64 = va_arg(args, zbx_uint64_t);
+				break;
+			default:
+				THIS_SHOULD_NEVER_HAPPEN;
+				exit(EXIT_FAILURE);
+		}
+	}
+
+	va_end(args);
+}
+
+#if defined(HAVE_POSTGRESQL)
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: converts bound values to text parameters                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbconn_stmt_params(zbx_db_stmt_t *stmt)
+{
+	for (int i = 0; i < stmt->params_num; i++)
+	{
+		char		*buf = stmt->params_num_buf + i * ZBX_DB_STMT_NUM_LEN;
+		zbx_db_value_t	*value = &stmt->values[i];
+
+		stmt->params[i] = buf;
+
+		switch (stmt->types[i])
+		{
+			case ZBX_TYPE_INT:
+				zbx_snprintf(buf, ZBX_DB_STMT_NUM_LEN, "%d", value->i32);
+				break;
+			case ZBX_TYPE_FLOAT:
+				zbx_snprintf(buf, ZBX_DB_STMT_NUM_LEN, ZBX_FS_DBL64_SQL, value->dbl);
+				break;
+			case ZBX_TYPE_UINT:
+				zbx_snprintf(buf, ZBX_DB_STMT_NUM_LEN, ZBX_FS_UI64, value->ui64);
+				break;
+			case ZBX_TYPE_ID:
+				if (0 == value->ui64)
+					stmt->params[i] = NULL;
+				else
+					zbx_snprintf(buf, ZBX_DB_STMT_NUM_LEN, ZBX_FS_UI64, value->ui64);
+				break;
+			default:
+				stmt->params[i] = value->str;
+				break;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: prepares statement on database server if it is not prepared in    *
+ *          the current session                                               *
+ *                                                                            *
+ * Return value: ZBX_DB_OK, ZBX_DB_FAIL or ZBX_DB_DOWN                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbconn_stmt_prepare_server(zbx_db_stmt_t *stmt)
+{
+	zbx_dbconn_t	*db = stmt->db;
+	PGresult	*result;
+	char		*sql = NULL;
+	size_t		sql_alloc = 0, sql_offset = 0;
+	int		ret = ZBX_DB_OK, param = 0;
+
+	if (0 != stmt->prepared)
+		return ZBX_DB_OK;
+
+	/* PostgreSQL uses numbered $n parameter placeholders */
+	for (const char *ptr = stmt->sql; '\0' != *ptr; ptr++)
+	{
+		if ('?' == *ptr)
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "$%d", ++param);
+		else
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, *ptr);
+	}
+
+	result = PQprepare(db->conn, stmt->name, sql, stmt->params_num, NULL);
+
+	if (NULL == result)
+	{
+		dbconn_errlog(db, ERR_Z3005, 0, "result is NULL", stmt->sql);
+		ret = (CONNECTION_OK == PQstatus(db->conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+	}
+	else if (PGRES_COMMAND_OK != PQresultStatus(result))
+	{
+		ret = dbconn_pg_execute_error(db, result, stmt->sql);
+	}
+	else
+	{
+		stmt->prepared = 1;
+		DBCONN_STMT_STATS_INC(prepares);
+	}
+
+	PQclear(result);
+	zbx_free(sql);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes prepared statement                                       *
+ *                                                                            *
+ * Parameters: stmt   - [IN] prepared statement                               *
+ *             result - [OUT] the statement result                            *
+ *                                                                            *
+ * Return value: ZBX_DB_OK, ZBX_DB_FAIL or ZBX_DB_DOWN                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbconn_stmt_exec(zbx_db_stmt_t *stmt, PGresult **result)
+{
+	zbx_dbconn_t	*db = stmt->db;
+	int		ret;
+	double		sec = 0;
+
+	*result = NULL;
+
+	if (0 != db->config->log_slow_queries)
+		sec = zbx_time();
+
+	if (0 == db->txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+	if (ZBX_DB_OK != db->txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring prepared query [txnlev:%d] [%s] within failed transaction",
+				db->txn_level, stmt->sql);
+		return ZBX_DB_FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "prepared query [txnlev:%d] [%s]", db->txn_level, stmt->sql);
+
+	if (ZBX_DB_OK != (ret = dbconn_stmt_prepare_server(stmt)))
+		goto out;
+
+	dbconn_stmt_params(stmt);
+
+	if (NULL == (*result = PQexecPrepared(db->conn, stmt->name, stmt->params_num, stmt->params, NULL, NULL, 0)))
+	{
+		dbconn_errlog(db, ERR_Z3005, 0, "result is NULL", stmt->sql);
+		ret = (CONNECTION_OK == PQstatus(db->conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+		goto out;
+	}
+
+	DBCONN_STMT_STATS_INC(executions);
+
+	switch (PQresultStatus(*result))
+	{
+		case PGRES_COMMAND_OK:
+		case PGRES_TUPLES_OK:
+			break;
+		default:
+			ret = dbconn_pg_execute_error(db, *result, stmt->sql);
+			PQclear(*result);
+			*result = NULL;
+	}
+
+	if (0 != db->config->log_slow_queries)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)db->config->log_slow_queries / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, stmt->sql);
+	}
+out:
+	if (ZBX_DB_FAIL == ret && 0 < db->txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "prepared query [%s] failed, setting transaction as failed", stmt->sql);
+		db->txn_error = ZBX_DB_FAIL;
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes prepared non-select statement once                       *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL, ZBX_DB_DOWN or number of rows affected          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbconn_stmt_execute_rows(zbx_db_stmt_t *stmt)
+{
+	PGresult	*result;
+	int		rc;
+
+	if (ZBX_DB_OK == (rc = dbconn_stmt_exec(stmt, &result)))
+		rc = atoi(PQcmdTuples(result));
+
+	PQclear(result);
+
+	return rc;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes prepared select statement once                           *
+ *                                                                            *
+ * Return value: data, NULL (on error) or (zbx_db_result_t)ZBX_DB_DOWN        *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_db_result_t	dbconn_stmt_select_rows(zbx_db_stmt_t *stmt)
+{
+	PGresult	*pg_result;
+	zbx_db_result_t	result;
+	int		rc;
+
+	if (ZBX_DB_OK != (rc = dbconn_stmt_exec(stmt, &pg_result)))
+		return ZBX_DB_DOWN == rc ? (zbx_db_result_t)ZBX_DB_DOWN : NULL;
+
+	result = (zbx_db_result_t)zbx_malloc(NULL, sizeof(struct zbx_db_result));
+	result->pg_result = pg_result;
+	result->values = NULL;
+	result->cursor = 0;
+	result->row_num = PQntuples(pg_result);
+
+	return result;
+}
+
+#else
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates SQL statement text from template and bound values         *
+ *                                                                            *
+ * Comments: Used by databases without server side prepared statement         *
+ *           support in the connection layer, the template still avoids       *
+ *           formatting statement text in the caller.                         *
+ *                                                                            *
+ ******************************************************************************/
+static char	*dbconn_stmt_sql(const zbx_db_stmt_t *stmt)
+{
+	char	*sql = NULL, *str_esc;
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	param = 0;
+
+	for (const char *ptr = stmt->sql; '\0' != *ptr; ptr++)
+	{
+		const zbx_db_value_t	*value;
+
+		if ('?' != *ptr)
+		{
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, *ptr);
+			continue;
+		}
+
+		value = &stmt->values[param];
+
+		switch (stmt->types[param++])
+		{
+			case ZBX_TYPE_INT:
+				zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%d", value->i32);
+				break;
+			case ZBX_TYPE_FLOAT:
+				zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, ZBX_FS_DBL64_SQL, value->dbl);
+				break;
+			case ZBX_TYPE_UINT:
+				zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, ZBX_FS_UI64, value->ui64);
+				break;
+			case ZBX_TYPE_ID:
+				zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, zbx_db_sql_id_ins(value->ui64));
+				break;
+			default:
+				str_esc = zbx_db_dyn_escape_string(value->str);
+				zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, '\'');
+				zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, str_esc);
+				zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, '\'');
+				zbx_free(str_esc);
+				break;
+		}
+	}
+
+	return sql;
+}
+
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes prepared non-select statement with bound values          *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows affected (on success)                      *
+ *                                                                            *
+ * Comments: retry until DB is up                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_stmt_execute(zbx_db_stmt_t *stmt)
+{
+	zbx_dbconn_t	*db = stmt->db;
+	int		rc;
+#if defined(HAVE_POSTGRESQL)
+	rc = dbconn_stmt_execute_rows(stmt);
+
+	while (ZBX_DB_DOWN == rc && ZBX_DB_CONNECT_NORMAL == db->connect_options)
+	{
+		zbx_dbconn_close(db);
+		zbx_dbconn_open(db);
+
+		if (ZBX_DB_DOWN == (rc = dbconn_stmt_execute_rows(stmt)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+			db->connection_failure = 1;
+			sleep(ZBX_DB_WAIT_DOWN);
+		}
+	}
+#else
+	char	*sql;
+
+	sql = dbconn_stmt_sql(stmt);
+	rc = zbx_dbconn_execute(db, "%s", sql);
+	zbx_free(sql);
+
+	DBCONN_STMT_STATS_INC(executions);
+#endif
+	return rc;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes prepared select statement with bound values              *
+ *                                                                            *
+ * Return value: data, NULL (on error) or (zbx_db_result_t)ZBX_DB_DOWN        *
+ *                                                                            *
+ * Comments: retry until DB is up                                             *
+ *                                                                            *
+ ******************************************************************************/
+zbx_db_result_t	zbx_db_stmt_select(zbx_db_stmt_t *stmt)
+{
+	zbx_dbconn_t	*db = stmt->db;
+	zbx_db_result_t	result;
+#if defined(HAVE_POSTGRESQL)
+	result = dbconn_stmt_select_rows(stmt);
+
+	if (ZBX_DB_CONNECT_NORMAL != db->connect_options)
+		return result;
+
+	while ((zbx_db_result_t)ZBX_DB_DOWN == result)
+	{
+		zbx_dbconn_close(db);
+		zbx_dbconn_open(db);
+
+		if ((zbx_db_result_t)ZBX_DB_DOWN == (result = dbconn_stmt_select_rows(stmt)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+			db->connection_failure = 1;
+			sleep(ZBX_DB_WAIT_DOWN);
+		}
+	}
+
+	return result;
+#else
+	char	*sql;
+
+	sql = dbconn_stmt_sql(stmt);
+	result = zbx_dbconn_select(db, "%s", sql);
+	zbx_free(sql);
+
+	DBCONN_STMT_STATS_INC(executions);
+
+	return result;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets prepared statement cache statistics of all processes         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_get_stmt_stats(zbx_db_stmt_stats_t *stats)
+{
+	if (NULL == stmt_stats)
+	{
+		memset(stats, 0, sizeof(zbx_db_stmt_stats_t));
+		return;
+	}
+
+	stats->hits = __atomic_load_n(&stmt_stats->hits, __ATOMIC_RELAXED);
+	stats->misses = __atomic_load_n(&stmt_stats->misses, __ATOMIC_RELAXED);
+	stats->evictions = __atomic_load_n(&stmt_stats->evictions, __ATOMIC_RELAXED);
+	stats->prepares = __atomic_load_n(&stmt_stats->prepares, __ATOMIC_RELAXED);
+	stats->executions = __atomic_load_n(&stmt_stats->executions, __ATOMIC_RELAXED);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: execute a select statement                                        *
@@ -16,6 +16,7 @@
 #define ZABBIX_DBCONN_H
 
 #include "zbxcommon.h"
+#include "zbxalgo.h"
 #include "zbxdb.h"
 #include "zbxdbschema.h"
 #include "zbxtypes.h"
@@ -60,6 +61,10 @@ struct zbx_dbconn
 
 	const zbx_db_config_t	*config;
 
+	zbx_hashset_t		stmts;		/* prepared statement cache */
+	zbx_uint64_t		stmts_lastuse;	/* statement cache access counter for LRU eviction */
+	int			stmts_nextid;	/* identifier of the next server side prepared statement */
+
 #if defined(HAVE_MYSQL)
 	MYSQL			*conn;
 	int			error_count;
@@ -83,5 +88,11 @@ int	db_is_escape_sequence(char c);
 
 zbx_uint32_t	db_get_server_version(void);
 
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+int	dbconn_field_bulk_load_supported(const zbx_db_field_t *field);
+int	dbconn_bulk_load(zbx_dbconn_t *db, const zbx_db_table_t *table, const zbx_vector_const_db_field_ptr_t *fields,
+		const zbx_vector_db_value_ptr_t *rows);
+#endif
+
 #endif
 
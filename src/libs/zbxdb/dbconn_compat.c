@@ -262,6 +262,29 @@ zbx_db_result_t	zbx_db_select_n(const char *query, int n)
 	return zbx_dbconn_select_n(dbconn, query, n);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get prepared statement from connection statement cache            *
+ *                                                                            *
+ ******************************************************************************/
+zbx_db_stmt_t	*zbx_db_prepare(const char *sql, ...)
+{
+	va_list		args;
+	zbx_db_stmt_t	*stmt;
+
+	if (NULL == dbconn)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return NULL;
+	}
+
+	va_start(args, sql);
+	stmt = zbx_dbconn_vprepare(dbconn, sql, args);
+	va_end(args);
+
+	return stmt;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get next id for requested table                                   *
@@ -107,6 +107,7 @@ void	zbx_dbconn_prepare_insert_dyn(zbx_dbconn_t *db, zbx_db_insert_t *db_insert,
 	db_insert->autoincrement = -1;
 	db_insert->lastid = 0;
 	db_insert->batch_size = 0;
+	db_insert->bulk_load = 0;
 
 	zbx_vector_const_db_field_ptr_create(&db_insert->fields);
 	zbx_vector_db_value_ptr_create(&db_insert->rows);
@@ -217,7 +218,9 @@ void	zbx_db_insert_add_values_dyn(zbx_db_insert_t *db_insert, zbx_db_value_t **v
 			case ZBX_TYPE_TEXT:
 			case ZBX_TYPE_CUID:
 			case ZBX_TYPE_BLOB:
-				row[i].str = db_dyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_ON);
+				/* bulk load sends values out of band, only the length limits apply */
+				row[i].str = db_dyn_escape_field_len(field, value->str,
+						0 == db_insert->bulk_load ? ESCAPE_SEQUENCE_ON : ESCAPE_SEQUENCE_OFF);
 				break;
 			case ZBX_TYPE_INT:
 			case ZBX_TYPE_FLOAT:
@@ -353,6 +356,44 @@ static void	decode_and_escape_binary_value_for_sql(zbx_dbconn_t *db, char **sql_
 }
 #endif
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: assigns ids to the auto increment field of bulk insert rows       *
+ *                                                                            *
+ * Parameters: db_insert - [IN] the bulk insert data                          *
+ *                                                                            *
+ * Return value: SUCCEED - the ids were assigned or auto increment is not set *
+ *               FAIL    - failed to reserve ids                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_insert_assign_ids(zbx_db_insert_t *db_insert)
+{
+	zbx_uint64_t	id;
+
+	if (-1 == db_insert->autoincrement)
+		return SUCCEED;
+
+	if (0 == (id = zbx_dbconn_get_maxid_num(db_insert->db, db_insert->table->table,
+			db_insert->rows.values_num)))
+	{
+		/* returning 0 nextid means failed transaction */
+		return FAIL;
+	}
+
+	for (int i = 0; i < db_insert->rows.values_num; i++)
+	{
+		zbx_db_value_t	*values = (zbx_db_value_t *)db_insert->rows.values[i];
+
+		values[db_insert->autoincrement].ui64 = id++;
+	}
+
+	db_insert->lastid = id - 1;
+	/* reset autoincrement so execute could be retried with the same ids */
+	db_insert->autoincrement = -1;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: executes the prepared database bulk insert operation              *
@@ -384,29 +425,13 @@ int	zbx_db_insert_execute(zbx_db_insert_t *db_insert)
 	if (0 == db_insert->rows.values_num)
 		return SUCCEED;
 
-	/* process the auto increment field */
-	if (-1 != db_insert->autoincrement)
-	{
-		zbx_uint64_t	id;
+	if (SUCCEED != db_insert_assign_ids(db_insert))
+		return FAIL;
 
-		if (0 == (id = zbx_dbconn_get_maxid_num(db_insert->db, db_insert->table->table,
-				db_insert->rows.values_num)))
-		{
-			/* returning 0 nextid means failed transaction */
-			return FAIL;
-		}
-
-		for (i = 0; i < db_insert->rows.values_num; i++)
-		{
-			zbx_db_value_t	*values = (zbx_db_value_t *)db_insert->rows.values[i];
-
-			values[db_insert->autoincrement].ui64 = id++;
-		}
-
-		db_insert->lastid = id - 1;
-		/* reset autoincrement so execute could be retried with the same ids */
-		db_insert->autoincrement = -1;
-	}
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	if (0 != db_insert->bulk_load)
+		return dbconn_bulk_load(db_insert->db, db_insert->table, &db_insert->fields, &db_insert->rows);
+#endif
 
 	sql = (char *)zbx_malloc(NULL, sql_alloc);
 	sql_command = (char *)zbx_malloc(NULL, sql_command_alloc);
@@ -599,3 +624,38 @@ void	zbx_db_insert_set_batch_size(zbx_db_insert_t *self, int batch_size)
 {
 	self->batch_size = batch_size;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: switches bulk insert to native database bulk load protocol        *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Comments: Rows are streamed with COPY FROM STDIN in binary format on       *
+ *           PostgreSQL and inserted with prepared multi-row statements on    *
+ *           MySQL. Values are passed without converting them to SQL text.    *
+ *           Other databases and field lists with types or flags that cannot  *
+ *           be bound (for example ZBX_UPPER) keep using insert statements.   *
+ *           Must be called before any values are added.                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_db_insert_set_bulk_load(zbx_db_insert_t *self)
+{
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	if (0 != self->rows.values_num)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return;
+	}
+
+	for (int i = 0; i < self->fields.values_num; i++)
+	{
+		if (SUCCEED != dbconn_field_bulk_load_supported(self->fields.values[i]))
+			return;
+	}
+
+	self->bulk_load = 1;
+#else
+	ZBX_UNUSED(self);
+#endif
+}
@@ -0,0 +1,652 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+/******************************************************************************
+ *                                                                            *
+ * Columnar history data batch is a binary block, base64 encoded into the     *
+ * 'proxy data' JSON:                                                         *
+ *                                                                            *
+ *   <version:1 byte>                                                         *
+ *   <rows_num:varint>                                                        *
+ *   <strings_num:varint><strings_size:varint>{<len:varint><bytes>}...        *
+ *   {<column_size:varint><column data>} x ZBX_HISTORY_COLUMNS_NUM            *
+ *                                                                            *
+ * Each column holds one field of all rows. Identifiers and clock are delta   *
+ * coded, signed values are zigzag coded and all integers are stored in       *
+ * variable length (LEB128) format. String values and log sources are kept    *
+ * once in the shared string table and referenced by index, unsigned integer  *
+ * values are stored as numbers in a separate column.                         *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "history_columns.h"
+#include "zbxdbwrap.h"
+
+#include "zbxalgo.h"
+#include "zbxcrypto.h"
+#include "zbxjson.h"
+#include "zbxnum.h"
+#include "zbxserialize.h"
+#include "zbx_item_constants.h"
+
+#define HISTORY_COLUMNS_VERSION		1
+
+#define HISTORY_COLUMN_ID		0
+#define HISTORY_COLUMN_ITEMID		1
+#define HISTORY_COLUMN_CLOCK		2
+#define HISTORY_COLUMN_NS		3
+#define HISTORY_COLUMN_FLAGS		4
+#define HISTORY_COLUMN_VALUE_STR	5
+#define HISTORY_COLUMN_VALUE_UINT	6
+#define HISTORY_COLUMN_LOG		7
+#define HISTORY_COLUMN_SOURCE		8
+#define HISTORY_COLUMN_META		9
+
+#define HISTORY_ROW_VALUE		0x01
+#define HISTORY_ROW_VALUE_UINT		0x02
+#define HISTORY_ROW_META		0x04
+#define HISTORY_ROW_LOG			0x08
+#define HISTORY_ROW_SOURCE		0x10
+#define HISTORY_ROW_NOTSUPPORTED	0x20
+
+typedef struct
+{
+	unsigned char	*data;
+	size_t		data_alloc;
+	size_t		data_offset;
+}
+history_buffer_t;
+
+typedef struct
+{
+	char		*str;
+	zbx_uint32_t	index;
+}
+history_string_t;
+
+struct zbx_history_columns
+{
+	history_buffer_t	columns[ZBX_HISTORY_COLUMNS_NUM];
+	history_buffer_t	strings;
+	zbx_hashset_t		strings_index;
+	zbx_uint64_t		rows_num;
+	zbx_uint64_t		id;
+	zbx_uint64_t		itemid;
+	int			clock;
+};
+
+static zbx_hash_t	history_string_hash(const void *data)
+{
+	const history_string_t	*s = (const history_string_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(s->str);
+}
+
+static int	history_string_compare(const void *d1, const void *d2)
+{
+	const history_string_t	*s1 = (const history_string_t *)d1;
+	const history_string_t	*s2 = (const history_string_t *)d2;
+
+	return strcmp(s1->str, s2->str);
+}
+
+static void	history_string_clean(void *data)
+{
+	history_string_t	*s = (history_string_t *)data;
+
+	zbx_free(s->str);
+}
+
+static zbx_uint64_t	zigzag_encode(zbx_int64_t value)
+{
+	return ((zbx_uint64_t)value << 1) ^ (zbx_uint64_t)(value >> 63);
+}
+
+static zbx_int64_t	zigzag_decode(zbx_uint64_t value)
+{
+	return (zbx_int64_t)(value >> 1) ^ -(zbx_int64_t)(value & 1);
+}
+
+static void	history_buffer_reserve(history_buffer_t *buf, size_t size)
+{
+	if (buf->data_offset + size <= buf->data_alloc)
+		return;
+
+	if (0 == buf->data_alloc)
+		buf->data_alloc = 256;
+
+	while (buf->data_offset + size > buf->data_alloc)
+		buf->data_alloc *= 2;
+
+	buf->data = (unsigned char *)zbx_realloc(buf->data, buf->data_alloc);
+}
+
+static void	history_buffer_put_uint64(history_buffer_t *buf, zbx_uint64_t value)
+{
+	history_buffer_reserve(buf, ZBX_SERIALIZE_UINT64_COMPACT_MAX);
+	buf->data_offset += zbx_serialize_uint64_compact(buf->data + buf->data_offset, value);
+}
+
+static void	history_buffer_put_int64(history_buffer_t *buf, zbx_int64_t value)
+{
+	history_buffer_put_uint64(buf, zigzag_encode(value));
+}
+
+static void	history_buffer_put_data(history_buffer_t *buf, const void *data, size_t size)
+{
+	if (0 == size)
+		return;
+
+	history_buffer_reserve(buf, size);
+	memcpy(buf->data + buf->data_offset, data, size);
+	buf->data_offset += size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets string index in shared string table, adding new strings      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	history_columns_add_string(zbx_history_columns_t *columns, const char *str)
+{
+	history_string_t	local, *s;
+	size_t			len;
+
+	local.str = (char *)str;
+
+	if (NULL != (s = (history_string_t *)zbx_hashset_search(&columns->strings_index, &local)))
+		return s->index;
+
+	local.str = zbx_strdup(NULL, str);
+	local.index = (zbx_uint32_t)columns->strings_index.num_data;
+	s = (history_string_t *)zbx_hashset_insert(&columns->strings_index, &local, sizeof(local));
+
+	len = strlen(str);
+	history_buffer_put_uint64(&columns->strings, len);
+	history_buffer_put_data(&columns->strings, str, len);
+
+	return s->index;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if value can be stored in unsigned integer column without  *
+ *          changing its text representation                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	history_value_is_uint(const char *value, zbx_uint64_t *value_ui64)
+{
+	size_t	len;
+
+	if ('\0' == *value || ('0' == *value && '\0' != value[1]) || ZBX_MAX_UINT64_LEN - 1 < (len = strlen(value)))
+		return FAIL;
+
+	return zbx_is_uint64_n(value, len, value_ui64);
+}
+
+zbx_history_columns_t	*zbx_history_columns_create(void)
+{
+	zbx_history_columns_t	*columns;
+
+	columns = (zbx_history_columns_t *)zbx_malloc(NULL, sizeof(zbx_history_columns_t));
+	memset(columns, 0, sizeof(zbx_history_columns_t));
+
+	zbx_hashset_create_ext(&columns->strings_index, 100, history_string_hash, history_string_compare,
+			history_string_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	return columns;
+}
+
+void	zbx_history_columns_free(zbx_history_columns_t *columns)
+{
+	int	i;
+
+	for (i = 0; i < ZBX_HISTORY_COLUMNS_NUM; i++)
+		zbx_free(columns->columns[i].data);
+
+	zbx_free(columns->strings.data);
+	zbx_hashset_destroy(&columns->strings_index);
+	zbx_free(columns);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends history value to columnar batch                           *
+ *                                                                            *
+ * Parameters: columns - [IN/OUT] columnar batch                              *
+ *             itemid  - [IN] item identifier                                 *
+ *             value   - [IN] value to append, NULL value->value means that   *
+ *                            there is no value (meta or state only update)   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_history_columns_append(zbx_history_columns_t *columns, zbx_uint64_t itemid, const zbx_agent_value_t *value)
+{
+	unsigned char	flags = 0;
+	zbx_uint64_t	value_ui64;
+
+	if (ITEM_STATE_NORMAL != value->state)
+		flags |= HISTORY_ROW_NOTSUPPORTED;
+
+	if (0 != value->meta)
+		flags |= HISTORY_ROW_META;
+
+	if (NULL != value->value)
+	{
+		flags |= HISTORY_ROW_VALUE;
+
+		if (SUCCEED == history_value_is_uint(value->value, &value_ui64))
+		{
+			flags |= HISTORY_ROW_VALUE_UINT;
+			history_buffer_put_uint64(&columns->columns[HISTORY_COLUMN_VALUE_UINT], value_ui64);
+		}
+		else
+		{
+			history_buffer_put_uint64(&columns->columns[HISTORY_COLUMN_VALUE_STR],
+					history_columns_add_string(columns, value->value));
+		}
+
+		if (0 != value->timestamp || 0 != value->severity || 0 != value->logeventid)
+		{
+			flags |= HISTORY_ROW_LOG;
+			history_buffer_put_int64(&columns->columns[HISTORY_COLUMN_LOG], value->timestamp);
+			history_buffer_put_int64(&columns->columns[HISTORY_COLUMN_LOG], value->severity);
+			history_buffer_put_int64(&columns->columns[HISTORY_COLUMN_LOG], value->logeventid);
+		}
+
+		if (NULL != value->source && '\0' != *value->source)
+		{
+			flags |= HISTORY_ROW_SOURCE;
+			history_buffer_put_uint64(&columns->columns[HISTORY_COLUMN_SOURCE],
+					history_columns_add_string(columns, value->source));
+		}
+	}
+
+	if (0 != value->meta)
+	{
+		history_buffer_put_uint64(&columns->columns[HISTORY_COLUMN_META], value->lastlogsize);
+		history_buffer_put_int64(&columns->columns[HISTORY_COLUMN_META], value->mtime);
+	}
+
+	history_buffer_put_int64(&columns->columns[HISTORY_COLUMN_ID], (zbx_int64_t)(value->id - columns->id));
+	history_buffer_put_int64(&columns->columns[HISTORY_COLUMN_ITEMID], (zbx_int64_t)(itemid - columns->itemid));
+	history_buffer_put_int64(&columns->columns[HISTORY_COLUMN_CLOCK],
+			(zbx_int64_t)value->ts.sec - (zbx_int64_t)columns->clock);
+	history_buffer_put_uint64(&columns->columns[HISTORY_COLUMN_NS], (zbx_uint64_t)value->ts.ns);
+	history_buffer_put_data(&columns->columns[HISTORY_COLUMN_FLAGS], &flags, 1);
+
+	columns->id = value->id;
+	columns->itemid = itemid;
+	columns->clock = value->ts.sec;
+	columns->rows_num++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns approximate size of columnar batch after encoding         *
+ *                                                                            *
+ ******************************************************************************/
+size_t	zbx_history_columns_size(const zbx_history_columns_t *columns)
+{
+	size_t	size = columns->strings.data_offset + 1 + 3 * ZBX_SERIALIZE_UINT64_COMPACT_MAX;
+	int	i;
+
+	for (i = 0; i < ZBX_HISTORY_COLUMNS_NUM; i++)
+		size += columns->columns[i].data_offset + ZBX_SERIALIZE_UINT64_COMPACT_MAX;
+
+	/* base64 encoding overhead */
+	return (size + 2) / 3 * 4;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds columnar batch to json as base64 encoded string              *
+ *                                                                            *
+ * Parameters: columns - [IN] columnar batch                                  *
+ *             tag     - [IN] json tag name                                   *
+ *             j       - [OUT] output json                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_history_columns_export(const zbx_history_columns_t *columns, const char *tag, struct zbx_json *j)
+{
+	history_buffer_t	buf = {0};
+	unsigned char		version = HISTORY_COLUMNS_VERSION;
+	char			*str = NULL;
+	int			i;
+
+	history_buffer_put_data(&buf, &version, 1);
+	history_buffer_put_uint64(&buf, columns->rows_num);
+	history_buffer_put_uint64(&buf, (zbx_uint64_t)columns->strings_index.num_data);
+	history_buffer_put_uint64(&buf, columns->strings.data_offset);
+	history_buffer_put_data(&buf, columns->strings.data, columns->strings.data_offset);
+
+	for (i = 0; i < ZBX_HISTORY_COLUMNS_NUM; i++)
+	{
+		history_buffer_put_uint64(&buf, columns->columns[i].data_offset);
+		history_buffer_put_data(&buf, columns->columns[i].data, columns->columns[i].data_offset);
+	}
+
+	zbx_base64_encode_dyn((const char *)buf.data, &str, (int)buf.data_offset);
+	zbx_json_addstring(j, tag, str, ZBX_JSON_TYPE_STRING);
+
+	zbx_free(str);
+	zbx_free(buf.data);
+}
+
+static int	history_column_get_uint64(zbx_history_column_t *column, zbx_uint64_t *value)
+{
+	zbx_uint64_t	result = 0;
+	int		shift;
+
+	for (shift = 0; shift < 64 && column->ptr < column->end; shift += 7)
+	{
+		unsigned char	c = *column->ptr++;
+
+		result |= (zbx_uint64_t)(c & 0x7f) << shift;
+
+		if (0 == (c & 0x80))
+		{
+			*value = result;
+			return SUCCEED;
+		}
+	}
+
+	return FAIL;
+}
+
+static int	history_column_get_int64(zbx_history_column_t *column, zbx_int64_t *value)
+{
+	zbx_uint64_t	value_ui64;
+
+	if (SUCCEED != history_column_get_uint64(column, &value_ui64))
+		return FAIL;
+
+	*value = zigzag_decode(value_ui64);
+
+	return SUCCEED;
+}
+
+static int	history_column_get_int(zbx_history_column_t *column, int *value)
+{
+	zbx_int64_t	value_i64;
+
+	if (SUCCEED != history_column_get_int64(column, &value_i64) || INT_MIN > value_i64 || INT_MAX < value_i64)
+		return FAIL;
+
+	*value = (int)value_i64;
+
+	return SUCCEED;
+}
+
+static int	history_column_get_size(zbx_history_column_t *column, zbx_history_column_t *out)
+{
+	zbx_uint64_t	size;
+
+	if (SUCCEED != history_column_get_uint64(column, &size) || (zbx_uint64_t)(column->end - column->ptr) < size)
+		return FAIL;
+
+	out->ptr = column->ptr;
+	out->end = column->ptr + size;
+	column->ptr = out->end;
+
+	return SUCCEED;
+}
+
+static int	history_column_get_string(zbx_history_columns_reader_t *reader, zbx_history_column_t *column,
+		char **str)
+{
+	zbx_uint64_t			index;
+	const zbx_history_column_str_t	*s;
+
+	if (SUCCEED != history_column_get_uint64(column, &index) || reader->strings_num <= index)
+		return FAIL;
+
+	s = &reader->strings[index];
+	*str = (char *)zbx_malloc(NULL, s->len + 1);
+	memcpy(*str, s->ptr, s->len);
+	(*str)[s->len] = '\0';
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: decodes columnar batch and prepares it for reading                *
+ *                                                                            *
+ * Parameters: reader - [OUT] columnar batch reader                           *
+ *             data   - [IN] base64 encoded columnar batch                    *
+ *             error  - [OUT] error message                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the batch was decoded successfully                 *
+ *               FAIL    - invalid batch format                               *
+ *                                                                            *
+ ******************************************************************************/
+int	history_columns_reader_open(zbx_history_columns_reader_t *reader, const char *data, char **error)
+{
+	size_t			data_len, size;
+	zbx_history_column_t	blob, strings;
+	zbx_uint64_t		strings_num, rows_num;
+	zbx_uint32_t		i;
+
+	memset(reader, 0, sizeof(zbx_history_columns_reader_t));
+
+	if (0 == (data_len = strlen(data)))
+	{
+		*error = zbx_strdup(*error, "empty columnar history data");
+		return FAIL;
+	}
+
+	reader->data = (unsigned char *)zbx_malloc(NULL, data_len / 4 * 3 + 3);
+	zbx_base64_decode(data, (char *)reader->data, data_len / 4 * 3 + 3, &size);
+
+	blob.ptr = reader->data;
+	blob.end = reader->data + size;
+
+	if (blob.ptr == blob.end || HISTORY_COLUMNS_VERSION != *blob.ptr++)
+	{
+		*error = zbx_strdup(*error, "unsupported columnar history data version");
+		goto fail;
+	}
+
+	if (SUCCEED != history_column_get_uint64(&blob, &rows_num) ||
+			SUCCEED != history_column_get_uint64(&blob, &strings_num) ||
+			SUCCEED != history_column_get_size(&blob, &strings) ||
+			(zbx_uint64_t)(strings.end - strings.ptr) < strings_num)
+	{
+		goto invalid;
+	}
+
+	reader->strings_num = (zbx_uint32_t)strings_num;
+
+	if (0 != strings_num)
+	{
+		reader->strings = (zbx_history_column_str_t *)zbx_malloc(NULL,
+				sizeof(zbx_history_column_str_t) * reader->strings_num);
+	}
+
+	for (i = 0; i < reader->strings_num; i++)
+	{
+		zbx_history_column_t	str;
+
+		if (SUCCEED != history_column_get_size(&strings, &str))
+			goto invalid;
+
+		reader->strings[i].ptr = str.ptr;
+		reader->strings[i].len = (zbx_uint32_t)(str.end - str.ptr);
+	}
+
+	for (i = 0; i < ZBX_HISTORY_COLUMNS_NUM; i++)
+	{
+		if (SUCCEED != history_column_get_size(&blob, &reader->columns[i]))
+			goto invalid;
+	}
+
+	/* every row has exactly one byte in flags column */
+	if ((zbx_uint64_t)(reader->columns[HISTORY_COLUMN_FLAGS].end - reader->columns[HISTORY_COLUMN_FLAGS].ptr) !=
+			rows_num)
+	{
+		goto invalid;
+	}
+
+	reader->rows_left = rows_num;
+
+	return SUCCEED;
+invalid:
+	*error = zbx_strdup(*error, "invalid columnar history data format");
+fail:
+	history_columns_reader_close(reader);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads next row from columnar batch                                *
+ *                                                                            *
+ * Parameters: reader - [IN/OUT] columnar batch reader                        *
+ *             itemid - [OUT] item identifier                                 *
+ *             value  - [OUT] agent value, must be freed by the caller        *
+ *             error  - [OUT] error message                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the row was read successfully                      *
+ *               FAIL    - no more rows or invalid batch format               *
+ *                                                                            *
+ ******************************************************************************/
+int	history_columns_reader_next(zbx_history_columns_reader_t *reader, zbx_uint64_t *itemid,
+		zbx_agent_value_t *value, char **error)
+{
+	zbx_history_column_t	*columns = reader->columns;
+	unsigned char		flags;
+	zbx_int64_t		delta;
+	zbx_uint64_t		ns;
+	int			i;
+
+	if (0 == reader->rows_left)
+		return FAIL;
+
+	memset(value, 0, sizeof(zbx_agent_value_t));
+
+	flags = *columns[HISTORY_COLUMN_FLAGS].ptr++;
+
+	if (SUCCEED != history_column_get_int64(&columns[HISTORY_COLUMN_ID], &delta))
+		goto fail;
+
+	reader->id += (zbx_uint64_t)delta;
+
+	if (SUCCEED != history_column_get_int64(&columns[HISTORY_COLUMN_ITEMID], &delta))
+		goto fail;
+
+	reader->itemid += (zbx_uint64_t)delta;
+
+	if (SUCCEED != history_column_get_int64(&columns[HISTORY_COLUMN_CLOCK], &delta))
+		goto fail;
+
+	reader->clock += (zbx_uint64_t)delta;
+
+	if (INT_MAX < reader->clock)
+		goto fail;
+
+	if (SUCCEED != history_column_get_uint64(&columns[HISTORY_COLUMN_NS], &ns) || 999999999 < ns)
+		goto fail;
+
+	value->id = reader->id;
+	value->ts.sec = (int)reader->clock;
+	value->ts.ns = (int)ns;
+	*itemid = reader->itemid;
+
+	if (0 != (flags & HISTORY_ROW_NOTSUPPORTED))
+		value->state = ITEM_STATE_NOTSUPPORTED;
+
+	if (0 != (flags & HISTORY_ROW_VALUE))
+	{
+		if (0 != (flags & HISTORY_ROW_VALUE_UINT))
+		{
+			zbx_uint64_t	value_ui64;
+
+			if (SUCCEED != history_column_get_uint64(&columns[HISTORY_COLUMN_VALUE_UINT], &value_ui64))
+				goto fail;
+
+			value->value = zbx_dsprintf(NULL, ZBX_FS_UI64, value_ui64);
+		}
+		else if (SUCCEED != history_column_get_string(reader, &columns[HISTORY_COLUMN_VALUE_STR],
+				&value->value))
+		{
+			goto fail;
+		}
+
+		if (0 != (flags & HISTORY_ROW_LOG))
+		{
+			if (SUCCEED != history_column_get_int(&columns[HISTORY_COLUMN_LOG], &value->timestamp) ||
+					SUCCEED != history_column_get_int(&columns[HISTORY_COLUMN_LOG],
+					&value->severity) ||
+					SUCCEED != history_column_get_int(&columns[HISTORY_COLUMN_LOG],
+					&value->logeventid))
+			{
+				goto fail;
+			}
+		}
+
+		if (0 != (flags & HISTORY_ROW_SOURCE) && SUCCEED != history_column_get_string(reader,
+				&columns[HISTORY_COLUMN_SOURCE], &value->source))
+		{
+			goto fail;
+		}
+	}
+
+	/* unsupported item meta information is ignored, see parse_history_data_row_value() */
+	if (0 != (flags & HISTORY_ROW_META))
+	{
+		zbx_uint64_t	lastlogsize;
+		int		mtime;
+
+		if (SUCCEED != history_column_get_uint64(&columns[HISTORY_COLUMN_META], &lastlogsize) ||
+				SUCCEED != history_column_get_int(&columns[HISTORY_COLUMN_META], &mtime))
+		{
+			goto fail;
+		}
+
+		if (ITEM_STATE_NOTSUPPORTED != value->state)
+		{
+			value->meta = 1;
+			value->lastlogsize = lastlogsize;
+			value->mtime = mtime;
+		}
+	}
+
+	/* all column data must be consumed by the declared rows */
+	if (0 == --reader->rows_left)
+	{
+		for (i = 0; i < ZBX_HISTORY_COLUMNS_NUM; i++)
+		{
+			if (columns[i].ptr != columns[i].end)
+				goto fail;
+		}
+	}
+
+	return SUCCEED;
+fail:
+	zbx_free(value->value);
+	zbx_free(value->source);
+	reader->rows_left = 0;
+	*error = zbx_strdup(*error, "invalid columnar history data format");
+
+	return FAIL;
+}
+
+void	history_columns_reader_close(zbx_history_columns_reader_t *reader)
+{
+	zbx_free(reader->strings);
+	zbx_free(reader->data);
+	reader->rows_left = 0;
+}
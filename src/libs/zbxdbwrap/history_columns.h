@@ -0,0 +1,56 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_HISTORY_COLUMNS_H
+#define ZABBIX_HISTORY_COLUMNS_H
+
+#include "zbxcommon.h"
+#include "zbxcacheconfig.h"
+
+/* number of value columns in columnar history data batch */
+#define ZBX_HISTORY_COLUMNS_NUM	10
+
+typedef struct
+{
+	const unsigned char	*ptr;
+	const unsigned char	*end;
+}
+zbx_history_column_t;
+
+typedef struct
+{
+	const unsigned char	*ptr;
+	zbx_uint32_t		len;
+}
+zbx_history_column_str_t;
+
+typedef struct
+{
+	unsigned char			*data;
+	zbx_history_column_str_t	*strings;
+	zbx_uint32_t			strings_num;
+	zbx_uint64_t			rows_left;
+	zbx_uint64_t			id;
+	zbx_uint64_t			itemid;
+	zbx_uint64_t			clock;
+	zbx_history_column_t		columns[ZBX_HISTORY_COLUMNS_NUM];
+}
+zbx_history_columns_reader_t;
+
+int	history_columns_reader_open(zbx_history_columns_reader_t *reader, const char *data, char **error);
+int	history_columns_reader_next(zbx_history_columns_reader_t *reader, zbx_uint64_t *itemid,
+		zbx_agent_value_t *value, char **error);
+void	history_columns_reader_close(zbx_history_columns_reader_t *reader);
+
+#endif
@@ -13,6 +13,7 @@
 **/
 
 #include "zbxdbwrap.h"
+#include "history_columns.h"
 
 #include "zbxdbhigh.h"
 #include "zbxsysinfo.h"
@@ -1166,6 +1167,46 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads up to ZBX_HISTORY_VALUES_MAX item values and item           *
+ *          identifiers from columnar history data batch                      *
+ *                                                                            *
+ * Parameters: reader     - [IN/OUT] the columnar batch reader                *
+ *             values     - [OUT] the item values                             *
+ *             itemids    - [OUT] the corresponding item identifiers          *
+ *             values_num - [OUT] number of elements in values and itemids    *
+ *                                arrays                                      *
+ *             parsed_num - [OUT] the number of values parsed                 *
+ *             error      - [OUT] the error message                           *
+ *                                                                            *
+ * Return value:  SUCCEED - values were parsed successfully                   *
+ *                FAIL    - an error occurred                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	parse_history_columns(zbx_history_columns_reader_t *reader, zbx_agent_value_t *values,
+		zbx_uint64_t *itemids, int *values_num, int *parsed_num, char **error)
+{
+	*values_num = 0;
+	*parsed_num = 0;
+
+	while (0 != reader->rows_left && *values_num < ZBX_HISTORY_VALUES_MAX)
+	{
+		if (SUCCEED != history_columns_reader_next(reader, &itemids[*values_num], &values[*values_num], error))
+		{
+			zbx_agent_values_clean(values, (size_t)*values_num);
+			*values_num = 0;
+
+			return FAIL;
+		}
+
+		(*parsed_num)++;
+		(*values_num)++;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: validates item received from proxy                                *
@@ -1206,6 +1247,8 @@ static int	proxy_item_validator(zbx_history_recv_item_t *item, zbx_socket_t *soc
  *             validator_func - [IN]  function to validate item permission    *
  *             validator_args - [IN]  validator function arguments            *
  *             jp_data        - [IN]  JSON with history data array            *
+ *             reader         - [IN]  columnar history data batch reader,     *
+ *                                    used instead of jp_data if not NULL     *
  *             session        - [IN]  the data session                        *
  *             nodata_win     - [OUT] counter of delayed values               *
  *             info           - [OUT] address of a pointer to the info        *
@@ -1222,8 +1265,8 @@ static int	proxy_item_validator(zbx_history_recv_item_t *item, zbx_socket_t *soc
  *                                                                            *
  ******************************************************************************/
 static int	process_history_data_by_itemids(zbx_socket_t *sock, zbx_client_item_validator_t validator_func,
-		void *validator_args, struct zbx_json_parse *jp_data, zbx_session_t *session,
-		zbx_proxy_suppress_t *nodata_win, char **info, unsigned int mode)
+		void *validator_args, struct zbx_json_parse *jp_data, zbx_history_columns_reader_t *reader,
+		zbx_session_t *session, zbx_proxy_suppress_t *nodata_win, char **info, unsigned int mode)
 {
 	const char		*pnext = NULL;
 	int			ret = SUCCEED, processed_num = 0, total_num = 0, values_num, read_num, i, *errcodes;
@@ -1241,8 +1284,10 @@ static int	process_history_data_by_itemids(zbx_socket_t *sock, zbx_client_item_v
 
 	sec = zbx_time();
 
-	while (SUCCEED == parse_history_data_by_itemids(jp_data, &pnext, values, itemids, &values_num, &read_num,
-			&unique_shift, &error) && 0 != values_num)
+	while (SUCCEED == (NULL != reader ?
+			parse_history_columns(reader, values, itemids, &values_num, &read_num, &error) :
+			parse_history_data_by_itemids(jp_data, &pnext, values, itemids, &values_num, &read_num,
+			&unique_shift, &error)) && 0 != values_num)
 	{
 		zbx_dc_config_history_recv_get_items_by_itemids(items, itemids, errcodes, (size_t)values_num, mode);
 
@@ -1278,7 +1323,7 @@ static int	process_history_data_by_itemids(zbx_socket_t *sock, zbx_client_item_v
 
 		zbx_agent_values_clean(values, values_num);
 
-		if (NULL == pnext)
+		if (NULL != reader ? 0 == reader->rows_left : NULL == pnext)
 			break;
 	}
 
@@ -1656,8 +1701,8 @@ int	zbx_process_agent_history_data(zbx_socket_t *sock, struct zbx_json_parse *jp
 		else
 			session = zbx_dc_get_or_create_session(hostid, token, ZBX_SESSION_TYPE_DATA);
 
-		ret = process_history_data_by_itemids(sock, agent_item_validator, &rights, &jp_data, session, NULL,
-				info, ZBX_ITEM_GET_DEFAULT);
+		ret = process_history_data_by_itemids(sock, agent_item_validator, &rights, &jp_data, NULL, session,
+				NULL, info, ZBX_ITEM_GET_DEFAULT);
 	}
 	else
 	{
@@ -2536,9 +2581,13 @@ int	zbx_process_proxy_data(const zbx_dc_proxy_t *proxy, const struct zbx_json_pa
 
 	flags_old = proxy_diff.nodata_win.flags;
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data))
+	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data) ||
+			NULL != zbx_json_pair_by_name(jp, ZBX_PROTO_TAG_HISTORY_COLUMNS))
 	{
-		zbx_session_t	*session = NULL;
+		zbx_session_t			*session = NULL;
+		zbx_history_columns_reader_t	reader, *preader = NULL;
+		char				*columns = NULL;
+		size_t				columns_alloc = 0;
 
 		if (SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_SESSION, value, sizeof(value), NULL))
 		{
@@ -2554,12 +2603,30 @@ int	zbx_process_proxy_data(const zbx_dc_proxy_t *proxy, const struct zbx_json_pa
 			session = zbx_dc_get_or_create_session(proxy->proxyid, value, ZBX_SESSION_TYPE_DATA);
 		}
 
+		if (SUCCEED == zbx_json_value_by_name_dyn(jp, ZBX_PROTO_TAG_HISTORY_COLUMNS, &columns, &columns_alloc,
+				NULL))
+		{
+			if (SUCCEED != history_columns_reader_open(&reader, columns, &error_step))
+			{
+				zbx_free(columns);
+				zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
+				ret = FAIL;
+				goto out;
+			}
+
+			zbx_free(columns);
+			preader = &reader;
+		}
+
 		if (SUCCEED != (ret = process_history_data_by_itemids(NULL, proxy_item_validator,
-				(void *)&proxy->proxyid, &jp_data, session, &proxy_diff.nodata_win, &error_step,
+				(void *)&proxy->proxyid, &jp_data, preader, session, &proxy_diff.nodata_win, &error_step,
 				ZBX_ITEM_GET_PROCESS)))
 		{
 			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
 		}
+
+		if (NULL != preader)
+			history_columns_reader_close(preader);
 	}
 
 	if (0 != (proxy_diff.nodata_win.flags & ZBX_PROXY_SUPPRESS_ACTIVE))
@@ -18,7 +18,9 @@
 #include "zbxalgo.h"
 #include "zbxshmem.h"
 #include "zbxcachehistory.h"
+#include "zbxcacheconfig.h"
 #include "zbxconnector.h"
+#include "zbxdb.h"
 #include "zbxlog.h"
 #include "zbxmutexs.h"
 #include "zbxtime.h"
@@ -197,6 +199,18 @@ void	zbx_diag_add_mem_stats(struct zbx_json *json, const char *name, const zbx_s
 
 	zbx_json_close(json);
 	zbx_json_close(json);
+
+	if (0 != stats->slabs_num)
+	{
+		zbx_json_addobject(json, "slabs");
+		zbx_json_adduint64(json, "count", stats->slabs_num);
+		zbx_json_adduint64(json, "size", stats->slabs_size);
+		zbx_json_adduint64(json, "used", stats->slab_objects_size);
+		zbx_json_adduint64(json, "objects", stats->slab_objects_num);
+		zbx_json_adduint64(json, "free", stats->slab_objects_free);
+		zbx_json_close(json);
+	}
+
 	zbx_json_close(json);
 }
 
@@ -409,16 +423,17 @@ static void	zbx_json_addhex(struct zbx_json *j, const char *name, zbx_uint64_t v
  ******************************************************************************/
 void	zbx_diag_add_locks_info(struct zbx_json *json)
 {
-	int		i;
+	int				i;
+	zbx_dc_sync_lock_stats_t	sync_stats[ZBX_DC_SYNC_STAGE_COUNT];
 #ifdef HAVE_VMINFO_T_UPDATES
-	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
+	const char	*names[ZBX_MUTEX_CACHE_SHARD] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
 				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
 				"ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_KSTAT", "ZBX_MUTEX_MODBUS",
 				"ZBX_MUTEX_TREND_FUNC", "ZBX_MUTEX_REMOTE_COMMANDS", "ZBX_MUTEX_PROXY_BUFFER",
 				"ZBX_MUTEX_VPS_MONITOR"};
 #else
-	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
+	const char	*names[ZBX_MUTEX_CACHE_SHARD] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
 				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
 				"ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_MODBUS",
@@ -427,13 +442,24 @@ void	zbx_diag_add_locks_info(struct zbx_json *json)
 #endif
 	zbx_json_addarray(json, ZBX_DIAG_LOCKS);
 
-	for (i = 0; i < ZBX_MUTEX_COUNT; i++)
+	for (i = 0; i < ZBX_MUTEX_CACHE_SHARD; i++)
 	{
 		zbx_json_addobject(json, NULL);
 		zbx_json_addhex(json, names[i], (zbx_uint64_t)zbx_mutex_addr_get(i));
 		zbx_json_close(json);
 	}
 
+	for (i = ZBX_MUTEX_CACHE_SHARD; i <= ZBX_MUTEX_CACHE_SHARD_LAST; i++)
+	{
+		char	name[MAX_STRING_LEN];
+
+		zbx_snprintf(name, sizeof(name), "ZBX_MUTEX_CACHE_SHARD_%d", i - ZBX_MUTEX_CACHE_SHARD + 1);
+
+		zbx_json_addobject(json, NULL);
+		zbx_json_addhex(json, name, (zbx_uint64_t)zbx_mutex_addr_get(i));
+		zbx_json_close(json);
+	}
+
 	zbx_json_addobject(json, NULL);
 	zbx_json_addhex(json, "ZBX_RWLOCK_CONFIG", (zbx_uint64_t)zbx_rwlock_addr_get(ZBX_RWLOCK_CONFIG));
 	zbx_json_close(json);
@@ -446,6 +472,48 @@ void	zbx_diag_add_locks_info(struct zbx_json *json)
 	zbx_json_addhex(json, "ZBX_RWLOCK_VALUECACHE", (zbx_uint64_t)zbx_rwlock_addr_get(ZBX_RWLOCK_VALUECACHE));
 	zbx_json_close(json);
 
+	zbx_dc_get_sync_lock_stats(sync_stats);
+
+	/* configuration cache write lock hold time per configuration sync stage */
+	for (i = 0; i < ZBX_DC_SYNC_STAGE_COUNT; i++)
+	{
+		zbx_json_addobject(json, NULL);
+		zbx_json_addstring(json, "config_sync", zbx_dc_sync_stage_string((zbx_dc_sync_stage_t)i),
+				ZBX_JSON_TYPE_STRING);
+		zbx_json_adduint64(json, "syncs", sync_stats[i].syncs);
+		zbx_json_adduint64(json, "locks", sync_stats[i].locks);
+		zbx_json_addfloat(json, "last", sync_stats[i].last);
+		zbx_json_addfloat(json, "max", sync_stats[i].max);
+		zbx_json_addfloat(json, "total", sync_stats[i].total);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add database diagnostic information to json data                  *
+ *                                                                            *
+ * Parameters: json  - [IN/OUT] the json to update                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_diag_add_database_info(struct zbx_json *json)
+{
+	zbx_db_stmt_stats_t	stats;
+
+	zbx_db_get_stmt_stats(&stats);
+
+	zbx_json_addobject(json, ZBX_DIAG_DATABASE);
+
+	zbx_json_addobject(json, "statements");
+	zbx_json_adduint64(json, "hits", stats.hits);
+	zbx_json_adduint64(json, "misses", stats.misses);
+	zbx_json_adduint64(json, "evictions", stats.evictions);
+	zbx_json_adduint64(json, "prepares", stats.prepares);
+	zbx_json_adduint64(json, "executions", stats.executions);
+	zbx_json_close(json);
+
 	zbx_json_close(json);
 }
 
@@ -553,6 +621,9 @@ static void	diag_prepare_default_request(struct zbx_json *j, unsigned int flags)
 	if (0 != (flags & (1 << ZBX_DIAGINFO_PROXYBUFFER)))
 		diag_add_section_request(j, ZBX_DIAG_PROXYBUFFER, NULL);
 
+	if (0 != (flags & (1 << ZBX_DIAGINFO_DATABASE)))
+		diag_add_section_request(j, ZBX_DIAG_DATABASE, NULL);
+
 }
 
 /******************************************************************************
@@ -831,6 +902,29 @@ static void	diag_log_proxybuffer(struct zbx_json_parse *jp, char **out, size_t *
 	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "==");
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: log database diagnostic information                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_log_database(struct zbx_json_parse *jp, char **out, size_t *out_alloc, size_t *out_offset)
+{
+	char			*msg = NULL;
+	struct zbx_json_parse	jp_stmts;
+
+	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "== database diagnostic information ==");
+
+	if (SUCCEED == zbx_json_brackets_by_name(jp, "statements", &jp_stmts))
+	{
+		diag_get_simple_values(&jp_stmts, &msg);
+		zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "Statements:");
+		zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "  %s", msg);
+		zbx_free(msg);
+	}
+
+	zbx_strlog_alloc(LOG_LEVEL_INFORMATION, out, out_alloc, out_offset, "==");
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: log diagnostic information                                        *
@@ -897,6 +991,8 @@ void	zbx_diag_log_info(unsigned int flags, char **result)
 				diag_log_connector(&jp_section, result, &result_alloc, &result_offset);
 			else if (0 == strcmp(section, ZBX_DIAG_PROXYBUFFER))
 				diag_log_proxybuffer(&jp_section, result, &result_alloc, &result_offset);
+			else if (0 == strcmp(section, ZBX_DIAG_DATABASE))
+				diag_log_database(&jp_section, result, &result_alloc, &result_offset);
 		}
 	}
 	else
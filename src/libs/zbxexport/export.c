@@ -13,6 +13,7 @@
 **/
 
 #include "zbxexport.h"
+#include "export_writer.h"
 
 #include "zbxcommon.h"
 #include "zbxstr.h"
@@ -180,6 +181,9 @@ int	zbx_init_library_export(zbx_config_export_t *zbx_config_export, char **error
 		return FAIL;
 	}
 
+	if (0 != zbx_config_export->writer && SUCCEED != export_writer_init(zbx_config_export, error))
+		return FAIL;
+
 	config_export = zbx_config_export;
 
 	return SUCCEED;
@@ -191,6 +195,9 @@ void	zbx_deinit_library_export(void)
 	{
 		zbx_free(config_export->dir);
 		zbx_free(config_export->type);
+
+		if (0 != config_export->writer)
+			export_writer_deinit();
 	}
 	get_history_file = NULL;
 	get_trends_file = NULL;
@@ -232,7 +239,8 @@ static zbx_export_file_t	*export_init(const char *process_type, const char *proc
 	}
 
 	file = (zbx_export_file_t *)zbx_malloc(NULL, sizeof(zbx_export_file_t));
-	file->name = zbx_dsprintf(NULL, "%s/%s-%s-%d.ndjson", export_dir, process_type, process_name, process_num);
+	file->name = zbx_dsprintf(NULL, "%s/%s-%s-%d.ndjson%s", export_dir, process_type, process_name, process_num,
+			0 != config_export->compression ? ".gz" : "");
 
 	free(export_dir);
 
@@ -243,6 +251,13 @@ static zbx_export_file_t	*export_init(const char *process_type, const char *proc
 	}
 
 	file->missing = 0;
+	file->batch = NULL;
+	file->batch_alloc = 0;
+	file->batch_offset = 0;
+	file->batch_records = 0;
+
+	if (0 != config_export->writer)
+		export_writer_register();
 
 	return file;
 }
@@ -273,12 +288,30 @@ zbx_export_file_t	*zbx_problems_export_init(zbx_get_export_file_f get_export_fil
 
 void	zbx_export_deinit(zbx_export_file_t *file)
 {
+	if (0 != config_export->writer)
+	{
+		export_writer_flush(file);
+		export_writer_unregister();
+		zbx_free(file->batch);
+	}
+
 	zbx_fclose(file->file);
 	zbx_free(file->name);
 	zbx_free(file);
 }
 
-static void	export_write(const char *buf, size_t count, zbx_export_file_t *file)
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write data to export file, rotating the file when it reaches      *
+ *          configured size                                                   *
+ *                                                                            *
+ * Parameters: file  - [IN] export file                                       *
+ *             buf   - [IN] data to write                                     *
+ *             count - [IN] data size                                         *
+ *             eol   - [IN] 1 - terminate data with newline                   *
+ *                                                                            *
+ ******************************************************************************/
+void	export_file_write(zbx_export_file_t *file, const char *buf, size_t count, int eol)
 {
 #define ZBX_LOGGING_SUSPEND_TIME	10
 
@@ -321,7 +354,7 @@ static void	export_write(const char *buf, size_t count, zbx_export_file_t *file)
 		goto error;
 	}
 
-	if (config_export->file_size <= count + (size_t)file_offset + 1)
+	if (config_export->file_size <= count + (size_t)file_offset + (size_t)eol)
 	{
 		char	filename_old[MAX_STRING_LEN];
 
@@ -355,7 +388,7 @@ static void	export_write(const char *buf, size_t count, zbx_export_file_t *file)
 			goto error;
 	}
 
-	if (count != fwrite(buf, 1, count, file->file) || '\n' != fputc('\n', file->file))
+	if (count != fwrite(buf, 1, count, file->file) || (0 != eol && '\n' != fputc('\n', file->file)))
 	{
 		error_msg = zbx_dsprintf(error_msg, "cannot write to export file '%s': %s", file->name,
 				zbx_strerror(errno));
@@ -384,6 +417,20 @@ error:
 #undef ZBX_LOGGING_SUSPEND_TIME
 }
 
+static void	export_write(const char *buf, size_t count, zbx_export_file_t *file)
+{
+	if (NULL == config_export)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "export library is not initialized");
+		exit(EXIT_FAILURE);
+	}
+
+	if (0 != config_export->writer)
+		export_writer_append(file, buf, count);
+	else
+		export_file_write(file, buf, count, 1);
+}
+
 void	zbx_problems_export_write(const char *buf, size_t count)
 {
 	export_write(buf, count, get_problems_file());
@@ -401,7 +448,9 @@ void	zbx_trends_export_write(const char *buf, size_t count)
 
 static void	export_flush(zbx_export_file_t *file)
 {
-	if (NULL != file && NULL != file->file && 0 != fflush(file->file))
+	if (NULL != file && 0 != config_export->writer)
+		export_writer_flush(file);
+	else if (NULL != file && NULL != file->file && 0 != fflush(file->file))
 		zabbix_log(LOG_LEVEL_ERR, "cannot flush export file '%s': %s", file->name, zbx_strerror(errno));
 }
 
@@ -0,0 +1,614 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "export_writer.h"
+
+#include "zbxcommon.h"
+#include "zbxalgo.h"
+#include "zbxshmem.h"
+#include "zbxthreads.h"
+#include "zbxtime.h"
+
+#ifdef HAVE_ZLIB
+#include "zlib.h"
+#endif
+
+/* records are queued for writing when the batch buffer reaches this size */
+#define EXPORT_WRITER_BATCH_SIZE	ZBX_MEBIBYTE
+
+/* maximum time exporting process waits for free queue space before dropping data */
+#define EXPORT_WRITER_WAIT_TIMEOUT	1
+
+#define EXPORT_WRITER_LOG_SUSPEND_TIME	10
+
+typedef enum
+{
+	EXPORT_WRITER_STOPPED = 0,
+	EXPORT_WRITER_RUNNING,
+	EXPORT_WRITER_FAILED
+}
+zbx_export_writer_state_t;
+
+/* export writer statistics, shared by all processes */
+typedef struct
+{
+	zbx_uint64_t	written_records;
+	zbx_uint64_t	written_bytes;
+	zbx_uint64_t	dropped_records;
+	zbx_uint64_t	dropped_bytes;
+	zbx_uint64_t	waits;
+	zbx_uint64_t	wait_time;	/* in microseconds */
+	zbx_uint64_t	queued_bytes;
+}
+zbx_export_writer_stats_t;
+
+typedef struct
+{
+	zbx_export_file_t	*file;
+	char			*data;
+	size_t			size;
+	int			records_num;
+}
+zbx_export_batch_t;
+
+typedef struct
+{
+	pthread_t			thread;
+	pthread_mutex_t			lock;
+	pthread_cond_t			event;		/* signaled when batches are queued or writer is stopped */
+	pthread_cond_t			done;		/* signaled when queued batches are written */
+
+	zbx_list_t			batches;
+	zbx_uint64_t			queued_size;
+	int				busy;		/* writer thread is writing batches outside lock */
+	int				stop;
+	int				files_num;
+	zbx_export_writer_state_t	state;
+	pid_t				pid;
+
+	/* writer thread buffers */
+	char				*buf;
+	size_t				buf_alloc;
+#ifdef HAVE_ZLIB
+	char				*gzbuf;
+	size_t				gzbuf_alloc;
+#endif
+}
+zbx_export_writer_t;
+
+static zbx_shmem_info_t			*writer_stats_mem = NULL;
+static zbx_export_writer_stats_t	*writer_stats = NULL;
+static const zbx_config_export_t	*writer_config = NULL;
+
+static zbx_export_writer_t	writer;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize background export writer statistics                    *
+ *                                                                            *
+ * Parameters: config - [IN] export configuration                             *
+ *             error  - [OUT]                                                 *
+ *                                                                            *
+ * Return value: SUCCEED - writer was initialized                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	export_writer_init(const zbx_config_export_t *config, char **error)
+{
+#ifndef HAVE_ZLIB
+	if (0 != config->compression)
+	{
+		*error = zbx_strdup(*error, "export file compression requires zlib support");
+		return FAIL;
+	}
+#endif
+	if (SUCCEED != zbx_shmem_create_min(&writer_stats_mem, sizeof(zbx_export_writer_stats_t),
+			"export writer statistics", NULL, 0, error))
+	{
+		return FAIL;
+	}
+
+	writer_stats = (zbx_export_writer_stats_t *)writer_stats_mem->base;
+	memset(writer_stats, 0, sizeof(zbx_export_writer_stats_t));
+
+	writer_config = config;
+
+	return SUCCEED;
+}
+
+void	export_writer_deinit(void)
+{
+	writer_stats = NULL;
+	writer_config = NULL;
+
+	if (NULL != writer_stats_mem)
+	{
+		zbx_shmem_destroy(writer_stats_mem);
+		writer_stats_mem = NULL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reset writer state inherited from parent process                  *
+ *                                                                            *
+ * Comments: The writer thread is not inherited by forked process and the     *
+ *           queued batches belong to the files of parent process, so they    *
+ *           are discarded.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	export_writer_reset(void)
+{
+	memset(&writer, 0, sizeof(writer));
+
+	pthread_mutex_init(&writer.lock, NULL);
+	pthread_cond_init(&writer.event, NULL);
+	pthread_cond_init(&writer.done, NULL);
+	zbx_list_create(&writer.batches);
+
+	writer.pid = getpid();
+}
+
+static void	export_buf_reserve(char **buf, size_t *alloc, size_t size)
+{
+	if (size <= *alloc)
+		return;
+
+	if (0 == *alloc)
+		*alloc = EXPORT_WRITER_BATCH_SIZE;
+
+	while (*alloc < size)
+		*alloc *= 2;
+
+	*buf = (char *)zbx_realloc(*buf, *alloc);
+}
+
+#ifdef HAVE_ZLIB
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compress data into gzip member                                    *
+ *                                                                            *
+ * Parameters: data - [IN] data to compress                                   *
+ *             size - [IN] data size                                          *
+ *             out  - [OUT] compressed data size                              *
+ *                                                                            *
+ * Return value: SUCCEED - data was compressed into writer.gzbuf              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	export_writer_compress(const char *data, size_t size, size_t *out)
+{
+	z_stream	zs;
+	int		ret = FAIL;
+
+	memset(&zs, 0, sizeof(zs));
+
+	if (Z_OK != deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY))
+		return FAIL;
+
+	export_buf_reserve(&writer.gzbuf, &writer.gzbuf_alloc, deflateBound(&zs, (uLong)size));
+
+	zs.next_in = (Bytef *)data;
+	zs.avail_in = (uInt)size;
+	zs.next_out = (Bytef *)writer.gzbuf;
+	zs.avail_out = (uInt)writer.gzbuf_alloc;
+
+	if (Z_STREAM_END == deflate(&zs, Z_FINISH))
+	{
+		*out = zs.total_out;
+		ret = SUCCEED;
+	}
+
+	deflateEnd(&zs);
+
+	return ret;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write records to export file, compressing them if configured      *
+ *                                                                            *
+ * Parameters: file        - [IN] export file                                 *
+ *             data        - [IN] records                                     *
+ *             size        - [IN] records size                                *
+ *             records_num - [IN] number of records                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	export_writer_write_data(zbx_export_file_t *file, const char *data, size_t size,
+		zbx_uint64_t records_num)
+{
+#ifdef HAVE_ZLIB
+	if (0 != writer_config->compression)
+	{
+		size_t	gzsize;
+
+		if (SUCCEED != export_writer_compress(data, size, &gzsize))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot compress data for export file '%s'", file->name);
+			__atomic_fetch_add(&writer_stats->dropped_records, records_num, __ATOMIC_RELAXED);
+			__atomic_fetch_add(&writer_stats->dropped_bytes, size, __ATOMIC_RELAXED);
+			return;
+		}
+
+		export_file_write(file, writer.gzbuf, gzsize, 0);
+	}
+	else
+#endif
+		export_file_write(file, data, size, 0);
+
+	if (NULL != file->file && 0 != fflush(file->file))
+		zabbix_log(LOG_LEVEL_ERR, "cannot flush export file '%s': %s", file->name, zbx_strerror(errno));
+
+	__atomic_fetch_add(&writer_stats->written_records, records_num, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&writer_stats->written_bytes, size, __ATOMIC_RELAXED);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: write batches of the same export file with single write           *
+ *                                                                            *
+ * Parameters: batches - [IN] batches to write                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	export_writer_write(zbx_vector_ptr_t *batches)
+{
+	zbx_export_batch_t	*batch = (zbx_export_batch_t *)batches->values[0];
+	zbx_export_file_t	*file = batch->file;
+	const char		*data;
+	size_t			size = 0;
+	int			i;
+	zbx_uint64_t		records_num = 0;
+
+	if (1 == batches->values_num)
+	{
+		data = batch->data;
+		size = batch->size;
+		records_num = (zbx_uint64_t)batch->records_num;
+	}
+	else
+	{
+		for (i = 0; i < batches->values_num; i++)
+		{
+			batch = (zbx_export_batch_t *)batches->values[i];
+
+			export_buf_reserve(&writer.buf, &writer.buf_alloc, size + batch->size);
+			memcpy(writer.buf + size, batch->data, batch->size);
+			size += batch->size;
+			records_num += (zbx_uint64_t)batch->records_num;
+		}
+
+		data = writer.buf;
+	}
+
+	export_writer_write_data(file, data, size, records_num);
+}
+
+static void	export_batch_free(zbx_export_batch_t *batch)
+{
+	zbx_free(batch->data);
+	zbx_free(batch);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: export writer thread entry                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	*export_writer_entry(void *args)
+{
+	zbx_vector_ptr_t	batches;
+	zbx_export_batch_t	*batch;
+	zbx_export_file_t	*file;
+	sigset_t		mask;
+	int			err;
+
+	ZBX_UNUSED(args);
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGUSR1);
+	sigaddset(&mask, SIGUSR2);
+	sigaddset(&mask, SIGHUP);
+	sigaddset(&mask, SIGQUIT);
+	sigaddset(&mask, SIGINT);
+
+	if (0 != (err = pthread_sigmask(SIG_BLOCK, &mask, NULL)))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot block signals: %s", zbx_strerror(err));
+
+	zbx_vector_ptr_create(&batches);
+
+	pthread_mutex_lock(&writer.lock);
+
+	while (1)
+	{
+		zbx_uint64_t	size = 0;
+
+		if (SUCCEED != zbx_list_pop(&writer.batches, (void **)&batch))
+		{
+			if (0 != writer.stop)
+				break;
+
+			pthread_cond_wait(&writer.event, &writer.lock);
+			continue;
+		}
+
+		file = batch->file;
+		zbx_vector_ptr_append(&batches, batch);
+		size += batch->size;
+
+		/* group subsequent batches of the same file into single write */
+		while (SUCCEED == zbx_list_peek(&writer.batches, (void **)&batch) && batch->file == file)
+		{
+			zbx_list_pop(&writer.batches, (void **)&batch);
+			zbx_vector_ptr_append(&batches, batch);
+			size += batch->size;
+		}
+
+		writer.busy = 1;
+		pthread_mutex_unlock(&writer.lock);
+
+		export_writer_write(&batches);
+
+		zbx_vector_ptr_clear_ext(&batches, (zbx_clean_func_t)export_batch_free);
+
+		pthread_mutex_lock(&writer.lock);
+		writer.busy = 0;
+		writer.queued_size -= size;
+		__atomic_fetch_sub(&writer_stats->queued_bytes, size, __ATOMIC_RELAXED);
+		pthread_cond_broadcast(&writer.done);
+	}
+
+	pthread_mutex_unlock(&writer.lock);
+
+	zbx_vector_ptr_destroy(&batches);
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: register export file to be written by export writer               *
+ *                                                                            *
+ ******************************************************************************/
+void	export_writer_register(void)
+{
+	if (writer.pid != getpid())
+		export_writer_reset();
+
+	writer.files_num++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: start writer thread if it's not running                           *
+ *                                                                            *
+ * Return value: SUCCEED - writer thread is running                           *
+ *               FAIL    - writer thread could not be started                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	export_writer_start(void)
+{
+	pthread_attr_t	attr;
+	int		err;
+
+	if (EXPORT_WRITER_RUNNING == writer.state)
+		return SUCCEED;
+
+	if (EXPORT_WRITER_FAILED == writer.state)
+		return FAIL;
+
+	writer.stop = 0;
+
+	zbx_pthread_init_attr(&attr);
+	if (0 != (err = pthread_create(&writer.thread, &attr, export_writer_entry, NULL)))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot create export writer thread: %s, export files will be written"
+				" directly", zbx_strerror(err));
+		writer.state = EXPORT_WRITER_FAILED;
+
+		return FAIL;
+	}
+
+	writer.state = EXPORT_WRITER_RUNNING;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: queue batched records of export file for writing                  *
+ *                                                                            *
+ * Parameters: file - [IN] export file                                        *
+ *                                                                            *
+ * Comments: When queue is full the exporting process waits for writer thread *
+ *           to free queue space. If it is not freed within                   *
+ *           EXPORT_WRITER_WAIT_TIMEOUT seconds the batch is dropped.         *
+ *                                                                            *
+ ******************************************************************************/
+static void	export_writer_enqueue(zbx_export_file_t *file)
+{
+	static time_t		last_log_time = 0;
+	zbx_export_batch_t	*batch;
+	size_t			size = file->batch_offset;
+
+	if (0 == size)
+		return;
+
+	if (SUCCEED != export_writer_start())
+	{
+		/* writer thread buffers are free to use when the thread is not running */
+		export_writer_write_data(file, file->batch, size, (zbx_uint64_t)file->batch_records);
+		goto out;
+	}
+
+	pthread_mutex_lock(&writer.lock);
+
+	if (writer.queued_size + size > writer_config->queue_size && 0 != writer.queued_size)
+	{
+		struct timespec	ts;
+		double		time_start;
+
+		time_start = zbx_time();
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += EXPORT_WRITER_WAIT_TIMEOUT;
+
+		while (writer.queued_size + size > writer_config->queue_size && 0 != writer.queued_size)
+		{
+			if (0 != pthread_cond_timedwait(&writer.done, &writer.lock, &ts))
+				break;
+		}
+
+		__atomic_fetch_add(&writer_stats->waits, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&writer_stats->wait_time, (zbx_uint64_t)((zbx_time() - time_start) * 1000000),
+				__ATOMIC_RELAXED);
+	}
+
+	if (writer.queued_size + size > writer_config->queue_size && 0 != writer.queued_size)
+	{
+		time_t	now;
+
+		pthread_mutex_unlock(&writer.lock);
+
+		__atomic_fetch_add(&writer_stats->dropped_records, (zbx_uint64_t)file->batch_records,
+				__ATOMIC_RELAXED);
+		__atomic_fetch_add(&writer_stats->dropped_bytes, size, __ATOMIC_RELAXED);
+
+		if (EXPORT_WRITER_LOG_SUSPEND_TIME < (now = time(NULL)) - last_log_time)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "export queue is full, dropped %d records of export file '%s'",
+					file->batch_records, file->name);
+			last_log_time = now;
+		}
+
+		goto out;
+	}
+
+	batch = (zbx_export_batch_t *)zbx_malloc(NULL, sizeof(zbx_export_batch_t));
+	batch->file = file;
+	batch->data = file->batch;
+	batch->size = size;
+	batch->records_num = file->batch_records;
+
+	zbx_list_append(&writer.batches, batch, NULL);
+	writer.queued_size += size;
+	__atomic_fetch_add(&writer_stats->queued_bytes, size, __ATOMIC_RELAXED);
+
+	pthread_cond_signal(&writer.event);
+	pthread_mutex_unlock(&writer.lock);
+
+	/* batch buffer is owned by writer thread now */
+	file->batch = NULL;
+	file->batch_alloc = 0;
+out:
+	file->batch_offset = 0;
+	file->batch_records = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add record to export file batch                                   *
+ *                                                                            *
+ * Parameters: file  - [IN] export file                                       *
+ *             buf   - [IN] record                                            *
+ *             count - [IN] record size                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	export_writer_append(zbx_export_file_t *file, const char *buf, size_t count)
+{
+	export_buf_reserve(&file->batch, &file->batch_alloc, file->batch_offset + count + 1);
+
+	memcpy(file->batch + file->batch_offset, buf, count);
+	file->batch_offset += count;
+	file->batch[file->batch_offset++] = '\n';
+	file->batch_records++;
+
+	if (EXPORT_WRITER_BATCH_SIZE <= file->batch_offset)
+		export_writer_enqueue(file);
+}
+
+void	export_writer_flush(zbx_export_file_t *file)
+{
+	export_writer_enqueue(file);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: wait until queued batches are written and stop writer thread      *
+ *          when the last export file is unregistered                         *
+ *                                                                            *
+ ******************************************************************************/
+void	export_writer_unregister(void)
+{
+	if (writer.pid != getpid())
+		return;
+
+	if (EXPORT_WRITER_RUNNING == writer.state)
+	{
+		pthread_mutex_lock(&writer.lock);
+
+		while (0 != writer.queued_size || 0 != writer.busy)
+			pthread_cond_wait(&writer.done, &writer.lock);
+
+		if (1 == writer.files_num)
+		{
+			writer.stop = 1;
+			pthread_cond_signal(&writer.event);
+		}
+
+		pthread_mutex_unlock(&writer.lock);
+
+		if (1 == writer.files_num)
+		{
+			pthread_join(writer.thread, NULL);
+			writer.state = EXPORT_WRITER_STOPPED;
+		}
+	}
+
+	if (0 == --writer.files_num)
+	{
+		zbx_free(writer.buf);
+		writer.buf_alloc = 0;
+#ifdef HAVE_ZLIB
+		zbx_free(writer.gzbuf);
+		writer.gzbuf_alloc = 0;
+#endif
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get background export writer statistics                           *
+ *                                                                            *
+ * Parameters: stats - [OUT] export writer statistics                         *
+ *                                                                            *
+ * Return value: SUCCEED - statistics were returned                           *
+ *               FAIL    - background export writer is not enabled            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_export_get_stats(zbx_export_stats_t *stats)
+{
+	if (NULL == writer_stats)
+		return FAIL;
+
+	stats->written_records = __atomic_load_n(&writer_stats->written_records, __ATOMIC_RELAXED);
+	stats->written_bytes = __atomic_load_n(&writer_stats->written_bytes, __ATOMIC_RELAXED);
+	stats->dropped_records = __atomic_load_n(&writer_stats->dropped_records, __ATOMIC_RELAXED);
+	stats->dropped_bytes = __atomic_load_n(&writer_stats->dropped_bytes, __ATOMIC_RELAXED);
+	stats->waits = __atomic_load_n(&writer_stats->waits, __ATOMIC_RELAXED);
+	stats->wait_time = (double)__atomic_load_n(&writer_stats->wait_time, __ATOMIC_RELAXED) / 1000000;
+	stats->queued_bytes = __atomic_load_n(&writer_stats->queued_bytes, __ATOMIC_RELAXED);
+
+	return SUCCEED;
+}
@@ -0,0 +1,29 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_EXPORT_WRITER_H
+#define ZABBIX_EXPORT_WRITER_H
+
+#include "zbxexport.h"
+
+void	export_file_write(zbx_export_file_t *file, const char *buf, size_t count, int eol);
+
+int	export_writer_init(const zbx_config_export_t *config, char **error);
+void	export_writer_deinit(void);
+void	export_writer_register(void);
+void	export_writer_append(zbx_export_file_t *file, const char *buf, size_t count);
+void	export_writer_flush(zbx_export_file_t *file);
+void	export_writer_unregister(void);
+
+#endif
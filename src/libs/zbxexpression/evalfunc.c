@@ -1110,6 +1110,27 @@ static int	evaluate_COUNT(zbx_variant_t *value, const zbx_dc_evaluate_item_t *it
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
+	/* values are not needed when counting all values */
+	if (OP_ANY == pdata.op && COUNT_UNIQUE != unique)
+	{
+		zbx_history_value_t	result;
+
+		if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+				ZBX_VC_AGGR_COUNT, &result, &count))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto clean;
+		}
+
+		if (count > limit)
+			count = limit;
+
+		zbx_variant_set_dbl(value, count);
+
+		ret = SUCCEED;
+		goto clean;
+	}
+
 	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
@@ -1195,16 +1216,13 @@ out:
 static int	evaluate_SUM(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
-	int				arg1, i, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_history_value_t		result;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift, values_num;
+	zbx_value_type_t	arg1_type;
+	zbx_history_value_t	result;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1238,32 +1256,16 @@ static int	evaluate_SUM(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, nvalues, &ts_end, ZBX_VC_AGGR_SUM,
+			&result, &values_num))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-	{
-		result.dbl = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.dbl += values.values[i].value.dbl;
-	}
-	else
-	{
-		result.ui64 = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.ui64 += values.values[i].value.ui64;
-	}
-
 	zbx_history_value2variant(&result, item->value_type, value);
 	ret = SUCCEED;
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1287,15 +1289,13 @@ out:
 static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
-	int				arg1, ret = FAIL, i, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift, values_num;
+	zbx_value_type_t	arg1_type;
+	zbx_history_value_t	avg;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1329,29 +1329,16 @@ static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, nvalues, &ts_end, ZBX_VC_AGGR_AVG,
+			&avg, &values_num))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < values_num)
 	{
-		double	avg = 0;
-
-		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.dbl / (i + 1) - avg / (i + 1);
-		}
-		else
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += (double)values.values[i].value.ui64;
-
-			avg = avg / values.values_num;
-		}
-		zbx_variant_set_dbl(value, avg);
+		zbx_variant_set_dbl(value, avg.dbl);
 
 		ret = SUCCEED;
 	}
@@ -1361,8 +1348,6 @@ static int	evaluate_AVG(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1405,17 +1390,6 @@ static int	evaluate_LAST(zbx_variant_t *value, const zbx_dc_evaluate_item_t *ite
 #define EVALUATE_MIN	0
 #define EVALUATE_MAX	1
 
-#define LOOP_FIND_MIN_OR_MAX(type, mode_op)							\
-	do											\
-	{											\
-		for (i = 1; i < values.values_num; i++)							\
-		{											\
-			if (values.values[i].value.type mode_op values.values[index].value.type)	\
-				index = i;								\
-		}											\
-	}												\
-	while(0)
-
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate function 'min' or 'max' for the item.                    *
@@ -1435,15 +1409,13 @@ static int	evaluate_LAST(zbx_variant_t *value, const zbx_dc_evaluate_item_t *ite
 static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_t *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error, int min_or_max)
 {
-	int				arg1, i, ret = FAIL, seconds = 0, nvalues = 0, time_shift;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			arg1, ret = FAIL, seconds = 0, nvalues = 0, time_shift, values_num;
+	zbx_value_type_t	arg1_type;
+	zbx_history_value_t	result;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1477,40 +1449,16 @@ static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_aggregate(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+			EVALUATE_MIN == min_or_max ? ZBX_VC_AGGR_MIN : ZBX_VC_AGGR_MAX, &result, &values_num))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < values_num)
 	{
-		int	index = 0;
-
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
-		{
-			if (EVALUATE_MIN == min_or_max)
-			{
-				LOOP_FIND_MIN_OR_MAX(ui64, <);
-			}
-			else
-			{
-				LOOP_FIND_MIN_OR_MAX(ui64, >);
-			}
-		}
-		else
-		{
-			if (EVALUATE_MIN == min_or_max)
-			{
-				LOOP_FIND_MIN_OR_MAX(dbl, <);
-			}
-			else
-			{
-				LOOP_FIND_MIN_OR_MAX(dbl, >);
-			}
-		}
-
-		zbx_history_value2variant(&values.values[index].value, item->value_type, value);
+		zbx_history_value2variant(&result, item->value_type, value);
 		ret = SUCCEED;
 	}
 	else
@@ -1519,8 +1467,6 @@ static int	evaluate_MIN_or_MAX(zbx_variant_t *value, const zbx_dc_evaluate_item_
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -2521,7 +2467,7 @@ out:
 }
 
 static int	validate_params_and_get_data(const zbx_dc_evaluate_item_t *item, const char *parameters,
-		const zbx_timespec_t *ts, zbx_vector_history_record_t *values, char **error)
+		const zbx_timespec_t *ts, zbx_vector_dbl_t *values, char **error)
 {
 	int			arg1, seconds = 0, nvalues = 0, time_shift;
 	zbx_value_type_t	arg1_type;
@@ -2562,7 +2508,7 @@ static int	validate_params_and_get_data(const zbx_dc_evaluate_item_t *item, cons
 			return FAIL;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_values_dbl(item->itemid, item->value_type, values, seconds, nvalues, &ts_end))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		return FAIL;
@@ -3334,25 +3280,6 @@ out:
 	return ret;
 }
 
-static void	history_to_dbl_vector(const zbx_history_record_t *v, int n, unsigned char value_type,
-		zbx_vector_dbl_t *values)
-{
-	int	i;
-
-	zbx_vector_dbl_reserve(values, (size_t)n);
-
-	if (ITEM_VALUE_TYPE_FLOAT == value_type)
-	{
-		for (i = 0; i < n; i++)
-			zbx_vector_dbl_append(values, v[i].value.dbl);
-	}
-	else
-	{
-		for (i = 0; i < n; i++)
-			zbx_vector_dbl_append(values, (double)v[i].value.ui64);
-	}
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: common operations for aggregate function calculation.             *
@@ -3375,34 +3302,27 @@ static int	evaluate_statistical_func(zbx_variant_t *value, const zbx_dc_evaluate
 		const char *parameters, const zbx_timespec_t *ts, zbx_statistical_func_t stat_func, int min_values,
 		char **error)
 {
-	int				ret = FAIL;
-	zbx_vector_history_record_t	values;
+	int			ret = FAIL;
+	zbx_vector_dbl_t	values;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
+	zbx_vector_dbl_create(&values);
 
 	if (SUCCEED != validate_params_and_get_data(item, parameters, ts, &values, error))
 		goto out;
 
 	if (min_values <= values.values_num)
 	{
-		zbx_vector_dbl_t	values_dbl;
-		double			result;
-
-		zbx_vector_dbl_create(&values_dbl);
-
-		history_to_dbl_vector(values.values, values.values_num, item->value_type, &values_dbl);
+		double	result;
 
-		if (SUCCEED == (ret = stat_func(&values_dbl, &result, error)))
+		if (SUCCEED == (ret = stat_func(&values, &result, error)))
 			zbx_variant_set_dbl(value, result);
-
-		zbx_vector_dbl_destroy(&values_dbl);
 	}
 	else
 		*error = zbx_strdup(*error, "not enough data");
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
+	zbx_vector_dbl_destroy(&values);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
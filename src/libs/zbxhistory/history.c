@@ -42,7 +42,8 @@ zbx_history_iface_t	history_ifaces[ITEM_VALUE_TYPE_BIN + 1];
  *                                                                                  *
  ************************************************************************************/
 int	zbx_history_init(const char *config_history_storage_url, const char *config_history_storage_opts,
-		int config_log_slow_queries, char **error)
+		int config_log_slow_queries, int config_history_storage_streams, int config_history_storage_compression,
+		char **error)
 {
 	/* TODO: support per value type specific configuration */
 
@@ -65,7 +66,8 @@ int	zbx_history_init(const char *config_history_storage_url, const char *config_
 			}
 
 			if (FAIL == zbx_history_elastic_init(&history_ifaces[i], i, config_history_storage_url,
-					config_log_slow_queries, error))
+					config_log_slow_queries, config_history_storage_streams,
+					config_history_storage_compression, error))
 			{
 				return FAIL;
 			}
@@ -95,6 +97,21 @@ void	zbx_history_destroy(void)
 	}
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: gets and resets history storage write statistics of the current process *
+ *                                                                                  *
+ * Parameters: stats - [OUT] the statistics                                         *
+ *                                                                                  *
+ * Return value: SUCCEED - statistics were collected since the last call            *
+ *               FAIL    - otherwise                                                *
+ *                                                                                  *
+ ************************************************************************************/
+int	zbx_history_get_storage_stats(zbx_history_storage_stats_t *stats)
+{
+	return zbx_elastic_get_stats(stats);
+}
+
 /************************************************************************************
  *                                                                                  *
  * Purpose: sends values to history storage                                         *
@@ -53,9 +53,11 @@ void	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type);
 
 /* elastic hist */
 int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type,
-		const char *config_history_storage_url, int config_log_slow_queries, char **error);
+		const char *config_history_storage_url, int config_log_slow_queries, int bulk_streams,
+		int bulk_compression, char **error);
 void	zbx_elastic_version_extract(struct zbx_json *json, int *result, int config_allow_unsupported_db_versions,
 		const char *config_history_storage_url);
 zbx_uint32_t	zbx_elastic_version_get(void);
+int	zbx_elastic_get_stats(zbx_history_storage_stats_t *stats);
 
 #endif
@@ -30,35 +30,36 @@
 #include "zbxcurl.h"
 #include "zbxcacheconfig.h"
 
+#ifdef HAVE_ZLIB
+#include "zlib.h"
+#endif
+
 #define		ZBX_HISTORY_STORAGE_DOWN	10000 /* Timeout in milliseconds */
 
 #define		ZBX_IDX_JSON_ALLOCATE		256
 #define		ZBX_JSON_ALLOCATE		2048
 
+/* the minimum number of documents in bulk request when values are split between parallel requests */
+#define		ZBX_ELASTIC_BULK_DOCS_MIN	100
+
+/* HistoryStorageDateIndex option values */
+#define		ZBX_ELASTIC_DATE_INDEX_PIPELINE	1
+#define		ZBX_ELASTIC_DATE_INDEX_DAILY	2
+
 const char	*value_type_str[] = {"dbl", "str", "log", "uint", "text"};
 
 static zbx_uint32_t	ZBX_ELASTIC_SVERSION = ZBX_DBVERSION_UNDEFINED;
 
 typedef struct
 {
-	char	*base_url;
-	char	*post_url;
-	char	*buf;
-	CURL	*handle;
+	char		*base_url;
+	char		*post_url;
+	CURL		*handle;
+	int		bulk_streams;
+	unsigned char	bulk_compression;
 }
 zbx_elastic_data_t;
 
-typedef struct
-{
-	unsigned char		initialized;
-	zbx_vector_ptr_t	ifaces;
-
-	CURLM			*handle;
-}
-zbx_elastic_writer_t;
-
-static zbx_elastic_writer_t	writer;
-
 typedef struct
 {
 	char	*data;
@@ -69,14 +70,40 @@ zbx_httppage_t;
 
 static zbx_httppage_t	page_r;
 
+/* bulk request with history values of a single value type */
 typedef struct
 {
-	zbx_httppage_t	page;
-	char		errbuf[CURL_ERROR_SIZE];
+	char			*url;
+	char			*buf;		/* ndjson request body */
+	size_t			buf_alloc;
+	size_t			buf_offset;
+	zbx_vector_uint64_t	docs;		/* offsets of documents (action and source lines) in buf */
+	char			*gzbuf;		/* gzip compressed request body */
+	size_t			gzbuf_alloc;
+	size_t			body_size;	/* size of the last sent request body */
+	unsigned char		compression;
+	CURL			*handle;
+	zbx_httppage_t		page;
+	char			errbuf[CURL_ERROR_SIZE];
 }
-zbx_curlpage_t;
+zbx_elastic_bulk_t;
+
+typedef struct
+{
+	unsigned char		initialized;
+	zbx_vector_ptr_t	bulks;
 
-static zbx_curlpage_t	page_w[ITEM_VALUE_TYPE_BIN + 1];
+	/* the multi handle is kept between flushes to reuse connections */
+	CURLM			*handle;
+	struct curl_slist	*headers;
+	struct curl_slist	*headers_gzip;
+}
+zbx_elastic_writer_t;
+
+static zbx_elastic_writer_t	writer;
+
+/* the history storage statistics collected since the last zbx_elastic_get_stats() call */
+static zbx_history_storage_stats_t	elastic_stats;
 
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
@@ -238,85 +265,408 @@ static void	elastic_close(zbx_history_iface_t *hist)
 {
 	zbx_elastic_data_t	*data = hist->data.elastic_data;
 
-	zbx_free(data->buf);
 	zbx_free(data->post_url);
 
 	if (NULL != data->handle)
 	{
-		if (NULL != writer.handle)
-			curl_multi_remove_handle(writer.handle, data->handle);
-
 		curl_easy_cleanup(data->handle);
 		data->handle = NULL;
 	}
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: check an error from Elastic json response                         *
- *                                                                            *
- * Parameters: page - [IN]  the buffer with json response                     *
- *             err  - [OUT] the parse error message. If the error value is    *
- *                           set it must be freed by caller after it has      *
- *                           been used.                                       *
- *                                                                            *
- * Return value: SUCCEED - the response contains an error                     *
- *               FAIL    - otherwise                                          *
- *                                                                            *
- ******************************************************************************/
-static int	elastic_is_error_present(zbx_httppage_t *page, char **err)
+/******************************************************************************************************************
+ *                                                                                                                *
+ * bulk request support                                                                                           *
+ *                                                                                                                *
+ ******************************************************************************************************************/
+
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: creates bulk request                                                    *
+ *                                                                                  *
+ * Parameters:  base_url    - [IN] the history storage URL                          *
+ *              compression - [IN] 1 - compress request body, 0 - otherwise         *
+ *                                                                                  *
+ ************************************************************************************/
+static zbx_elastic_bulk_t	*elastic_bulk_create(const char *base_url, unsigned char compression)
 {
-	struct zbx_json_parse	jp, jp_values, jp_index, jp_error, jp_items, jp_item;
-	const char		*errors, *p = NULL;
-	char			*index = NULL, *status = NULL, *type = NULL, *reason = NULL;
-	size_t			index_alloc = 0, status_alloc = 0, type_alloc = 0, reason_alloc = 0;
-	int			rc_js = SUCCEED;
+	zbx_elastic_bulk_t	*bulk;
 
-	zabbix_log(LOG_LEVEL_TRACE, "%s() raw json: %s", __func__, ZBX_NULL2EMPTY_STR(page->data));
+	bulk = (zbx_elastic_bulk_t *)zbx_malloc(NULL, sizeof(zbx_elastic_bulk_t));
+	memset(bulk, 0, sizeof(zbx_elastic_bulk_t));
 
-	if (SUCCEED != zbx_json_open(page->data, &jp) || SUCCEED != zbx_json_brackets_open(jp.start, &jp_values))
-		return FAIL;
+	bulk->url = zbx_dsprintf(NULL, "%s/_bulk", base_url);
+	bulk->compression = compression;
+	zbx_vector_uint64_create(&bulk->docs);
+
+	return bulk;
+}
+
+static void	elastic_bulk_free(zbx_elastic_bulk_t *bulk)
+{
+	if (NULL != bulk->handle)
+	{
+		if (NULL != writer.handle)
+			curl_multi_remove_handle(writer.handle, bulk->handle);
 
-	if (NULL == (errors = zbx_json_pair_by_name(&jp_values, "errors")) || 0 != strncmp("true", errors, 4))
+		curl_easy_cleanup(bulk->handle);
+	}
+
+	zbx_vector_uint64_destroy(&bulk->docs);
+	zbx_free(bulk->page.data);
+	zbx_free(bulk->gzbuf);
+	zbx_free(bulk->buf);
+	zbx_free(bulk->url);
+	zbx_free(bulk);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: adds document to bulk request                                           *
+ *                                                                                  *
+ * Parameters:  bulk   - [IN] the bulk request                                      *
+ *              action - [IN] the bulk action line                                  *
+ *              source - [IN] the document source line                              *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_bulk_add_doc(zbx_elastic_bulk_t *bulk, const char *action, const char *source)
+{
+	zbx_vector_uint64_append(&bulk->docs, (zbx_uint64_t)bulk->buf_offset);
+
+	zbx_strcpy_alloc(&bulk->buf, &bulk->buf_alloc, &bulk->buf_offset, action);
+	zbx_chrcpy_alloc(&bulk->buf, &bulk->buf_alloc, &bulk->buf_offset, '\n');
+	zbx_strcpy_alloc(&bulk->buf, &bulk->buf_alloc, &bulk->buf_offset, source);
+	zbx_chrcpy_alloc(&bulk->buf, &bulk->buf_alloc, &bulk->buf_offset, '\n');
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: compresses bulk request body with gzip                                  *
+ *                                                                                  *
+ * Return value: SUCCEED - the request body was compressed                          *
+ *               FAIL    - otherwise                                                *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_bulk_compress(zbx_elastic_bulk_t *bulk)
+{
+#ifdef HAVE_ZLIB
+	z_stream	strm;
+	uLong		bound;
+	int		rc;
+
+	memset(&strm, 0, sizeof(strm));
+
+	/* window bits over 15 make deflate write gzip header and trailer instead of zlib wrapper */
+	if (Z_OK != deflateInit2(&strm, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY))
 		return FAIL;
 
-	if (SUCCEED == zbx_json_brackets_by_name(&jp, "items", &jp_items))
+	if (bulk->gzbuf_alloc < (bound = deflateBound(&strm, (uLong)bulk->buf_offset)))
 	{
-		while (NULL != (p = zbx_json_next(&jp_items, p)))
+		bulk->gzbuf_alloc = (size_t)bound;
+		bulk->gzbuf = (char *)zbx_realloc(bulk->gzbuf, bulk->gzbuf_alloc);
+	}
+
+	strm.next_in = (Bytef *)bulk->buf;
+	strm.avail_in = (uInt)bulk->buf_offset;
+	strm.next_out = (Bytef *)bulk->gzbuf;
+	strm.avail_out = (uInt)bulk->gzbuf_alloc;
+
+	rc = deflate(&strm, Z_FINISH);
+	bulk->body_size = (size_t)strm.total_out;
+	deflateEnd(&strm);
+
+	return Z_STREAM_END == rc ? SUCCEED : FAIL;
+#else
+	ZBX_UNUSED(bulk);
+
+	return FAIL;
+#endif
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: prepares bulk request cURL handle for sending the current documents     *
+ *                                                                                  *
+ * Return value: SUCCEED - the handle is ready to be added to the multi handle      *
+ *               FAIL    - otherwise                                                *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_bulk_prepare(zbx_elastic_bulk_t *bulk)
+{
+	CURLoption		opt;
+	CURLcode		err;
+	char			*error = NULL, *body;
+	struct curl_slist	*headers;
+
+	if (NULL == bulk->handle)
+	{
+		if (NULL == (bulk->handle = curl_easy_init()))
 		{
-			if (SUCCEED == zbx_json_brackets_open(p, &jp_item) &&
-					SUCCEED == zbx_json_brackets_by_name(&jp_item, "index", &jp_index) &&
-					SUCCEED == zbx_json_brackets_by_name(&jp_index, "error", &jp_error))
-			{
-				if (SUCCEED != zbx_json_value_by_name_dyn(&jp_error, "type", &type, &type_alloc, NULL))
-					rc_js = FAIL;
-				if (SUCCEED != zbx_json_value_by_name_dyn(&jp_error, "reason", &reason, &reason_alloc, NULL))
-					rc_js = FAIL;
-			}
-			else
-				continue;
+			zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
+			return FAIL;
+		}
 
-			if (SUCCEED != zbx_json_value_by_name_dyn(&jp_index, "status", &status, &status_alloc, NULL))
-				rc_js = FAIL;
-			if (SUCCEED != zbx_json_value_by_name_dyn(&jp_index, "_index", &index, &index_alloc, NULL))
-				rc_js = FAIL;
+		if (CURLE_OK != (err = curl_easy_setopt(bulk->handle, opt = CURLOPT_URL, bulk->url)) ||
+				CURLE_OK != (err = curl_easy_setopt(bulk->handle, opt = CURLOPT_POST, 1L)) ||
+				CURLE_OK != (err = curl_easy_setopt(bulk->handle, opt = CURLOPT_WRITEFUNCTION,
+						curl_write_cb)) ||
+				CURLE_OK != (err = curl_easy_setopt(bulk->handle, opt = CURLOPT_WRITEDATA,
+						&bulk->page)) ||
+				CURLE_OK != (err = curl_easy_setopt(bulk->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
+				CURLE_OK != (err = curl_easy_setopt(bulk->handle, opt = CURLOPT_ERRORBUFFER,
+						bulk->errbuf)) ||
+				CURLE_OK != (err = curl_easy_setopt(bulk->handle, opt = CURLOPT_ACCEPT_ENCODING, "")) ||
+				CURLE_OK != (err = curl_easy_setopt(bulk->handle, opt = CURLOPT_PRIVATE, bulk)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
+			return FAIL;
+		}
 
-			break;
+		if (SUCCEED != zbx_curl_setopt_https(bulk->handle, &error))
+		{
+			zabbix_log(LOG_LEVEL_ERR, error);
+			zbx_free(error);
+			return FAIL;
 		}
 	}
+
+	if (0 != bulk->compression && SUCCEED == elastic_bulk_compress(bulk))
+	{
+		body = bulk->gzbuf;
+		headers = writer.headers_gzip;
+	}
 	else
-		rc_js = FAIL;
+	{
+		body = bulk->buf;
+		bulk->body_size = bulk->buf_offset;
+		headers = writer.headers;
+	}
 
-	*err = zbx_dsprintf(NULL,"index:%s status:%s type:%s reason:%s%s", ZBX_NULL2EMPTY_STR(index),
-			ZBX_NULL2EMPTY_STR(status), ZBX_NULL2EMPTY_STR(type), ZBX_NULL2EMPTY_STR(reason),
-			FAIL == rc_js ? " / elasticsearch version is not fully compatible with zabbix server" : "");
+	if (CURLE_OK != (err = curl_easy_setopt(bulk->handle, opt = CURLOPT_HTTPHEADER, headers)) ||
+			CURLE_OK != (err = curl_easy_setopt(bulk->handle, opt = CURLOPT_POSTFIELDSIZE_LARGE,
+					(curl_off_t)bulk->body_size)) ||
+			CURLE_OK != (err = curl_easy_setopt(bulk->handle, opt = CURLOPT_POSTFIELDS, body)))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
+		return FAIL;
+	}
+
+	*bulk->errbuf = '\0';
+	bulk->page.offset = 0;
+
+	if (0 < bulk->page.alloc)
+		*bulk->page.data = '\0';
+
+	zabbix_log(LOG_LEVEL_DEBUG, "sending %d documents, " ZBX_FS_SIZE_T " bytes: %.*s", bulk->docs.values_num,
+			(zbx_fs_size_t)bulk->body_size, (int)bulk->buf_offset, bulk->buf);
+
+	return SUCCEED;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: gets error description of bulk response item                            *
+ *                                                                                  *
+ ************************************************************************************/
+static char	*elastic_bulk_item_error(const struct zbx_json_parse *jp_index)
+{
+	struct zbx_json_parse	jp_error;
+	char			*index = NULL, *status = NULL, *type = NULL, *reason = NULL, *err;
+	size_t			index_alloc = 0, status_alloc = 0, type_alloc = 0, reason_alloc = 0;
+
+	zbx_json_value_by_name_dyn(jp_index, "_index", &index, &index_alloc, NULL);
+	zbx_json_value_by_name_dyn(jp_index, "status", &status, &status_alloc, NULL);
+
+	if (SUCCEED == zbx_json_brackets_by_name(jp_index, "error", &jp_error))
+	{
+		zbx_json_value_by_name_dyn(&jp_error, "type", &type, &type_alloc, NULL);
+		zbx_json_value_by_name_dyn(&jp_error, "reason", &reason, &reason_alloc, NULL);
+	}
+
+	err = zbx_dsprintf(NULL, "index:%s status:%s type:%s reason:%s", ZBX_NULL2EMPTY_STR(index),
+			ZBX_NULL2EMPTY_STR(status), ZBX_NULL2EMPTY_STR(type), ZBX_NULL2EMPTY_STR(reason));
 
-	zbx_free(status);
-	zbx_free(type);
 	zbx_free(reason);
+	zbx_free(type);
+	zbx_free(status);
 	zbx_free(index);
 
-	return SUCCEED;
+	return err;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: removes written and permanently rejected documents from bulk request    *
+ *                                                                                  *
+ * Parameters:  bulk - [IN/OUT] the bulk request with received response             *
+ *                                                                                  *
+ * Return value: the number of documents left in bulk request to be resent          *
+ *                                                                                  *
+ * Comments: Bulk response items are listed in the same order as request documents. *
+ *           Documents rejected because of overload (status 429) or server errors   *
+ *           are kept for resending, the other rejected documents are dropped.      *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_bulk_check_items(zbx_elastic_bulk_t *bulk)
+{
+	struct zbx_json_parse	jp, jp_items, jp_item, jp_index;
+	const char		*errors, *p = NULL;
+	char			*buf = NULL, *error = NULL, status[MAX_ID_LEN + 1];
+	size_t			buf_alloc = 0, buf_offset = 0;
+	int			i = 0, failed_num = 0;
+	zbx_vector_uint64_t	docs;
+
+	zabbix_log(LOG_LEVEL_TRACE, "%s() raw json: %s", __func__, ZBX_NULL2EMPTY_STR(bulk->page.data));
+
+	if (NULL == bulk->page.data || SUCCEED != zbx_json_open(bulk->page.data, &jp) ||
+			NULL == (errors = zbx_json_pair_by_name(&jp, "errors")) || 0 != strncmp("true", errors, 4))
+	{
+		elastic_stats.documents += (zbx_uint64_t)bulk->docs.values_num;
+		return 0;
+	}
+
+	if (SUCCEED != zbx_json_brackets_by_name(&jp, "items", &jp_items))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: elasticsearch version is not fully"
+				" compatible with zabbix server");
+		return bulk->docs.values_num;
+	}
+
+	zbx_vector_uint64_create(&docs);
+
+	for (; i < bulk->docs.values_num && NULL != (p = zbx_json_next(&jp_items, p)); i++)
+	{
+		int	code = 0;
+
+		if (SUCCEED == zbx_json_brackets_open(p, &jp_item) &&
+				SUCCEED == zbx_json_brackets_by_name(&jp_item, "index", &jp_index) &&
+				SUCCEED == zbx_json_value_by_name(&jp_index, "status", status, sizeof(status), NULL))
+		{
+			code = atoi(status);
+		}
+
+		if (200 <= code && 300 > code)
+		{
+			elastic_stats.documents++;
+			continue;
+		}
+
+		if (NULL == error && 0 != code)
+			error = elastic_bulk_item_error(&jp_index);
+
+		if (0 != code && 429 != code && 500 > code)
+		{
+			failed_num++;
+			continue;
+		}
+
+		zbx_vector_uint64_append(&docs, (zbx_uint64_t)buf_offset);
+		zbx_strncpy_alloc(&buf, &buf_alloc, &buf_offset, bulk->buf + bulk->docs.values[i],
+				(i + 1 < bulk->docs.values_num ? bulk->docs.values[i + 1] : bulk->buf_offset) -
+				bulk->docs.values[i]);
+	}
+
+	/* documents without response items are resent */
+	if (i < bulk->docs.values_num)
+	{
+		zbx_vector_uint64_append(&docs, (zbx_uint64_t)buf_offset);
+		zbx_strncpy_alloc(&buf, &buf_alloc, &buf_offset, bulk->buf + bulk->docs.values[i],
+				bulk->buf_offset - bulk->docs.values[i]);
+
+		for (i++; i < bulk->docs.values_num; i++)
+		{
+			zbx_vector_uint64_append(&docs, docs.values[docs.values_num - 1] + bulk->docs.values[i] -
+					bulk->docs.values[i - 1]);
+		}
+	}
+
+	if (0 != failed_num || 0 != docs.values_num)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: %d documents rejected, %d documents"
+				" will be resent: %s", failed_num, docs.values_num, ZBX_NULL2EMPTY_STR(error));
+	}
+
+	elastic_stats.failed += (zbx_uint64_t)failed_num;
+
+	zbx_free(bulk->buf);
+	bulk->buf = buf;
+	bulk->buf_alloc = buf_alloc;
+	bulk->buf_offset = buf_offset;
+
+	zbx_vector_uint64_destroy(&bulk->docs);
+	bulk->docs = docs;
+
+	zbx_free(error);
+
+	return bulk->docs.values_num;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: processes completed bulk request                                        *
+ *                                                                                  *
+ * Parameters:  bulk   - [IN/OUT] the bulk request                                  *
+ *              result - [IN] the transfer result                                   *
+ *                                                                                  *
+ * Return value: SUCCEED - the bulk request is done                                 *
+ *               FAIL    - the bulk request must be resent with the documents left  *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_bulk_process(zbx_elastic_bulk_t *bulk, CURLcode result)
+{
+	double		total_time;
+	long int	response_code = 0;
+	int		retry_num;
+
+	elastic_stats.requests++;
+	elastic_stats.bytes += (zbx_uint64_t)bulk->body_size;
+
+	if (CURLE_OK == curl_easy_getinfo(bulk->handle, CURLINFO_TOTAL_TIME, &total_time))
+		elastic_stats.time += total_time;
+
+	if (CURLE_HTTP_RETURNED_ERROR == result)
+	{
+		if (CURLE_OK != curl_easy_getinfo(bulk->handle, CURLINFO_RESPONSE_CODE, &response_code))
+			response_code = 0;
+
+		if ('\0' != *bulk->errbuf)
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, HTTP error message: %s",
+					bulk->errbuf);
+		}
+		else if (0 != response_code)
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, HTTP status code: %ld",
+					response_code);
+		}
+		else
+			zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, unknown HTTP status code");
+
+		/* If the error is due to malformed data, there is no sense on re-trying to send. */
+		/* Requests rejected because of overload or server errors are resent. */
+		if (429 != response_code && 500 > response_code)
+		{
+			elastic_stats.failed += (zbx_uint64_t)bulk->docs.values_num;
+			return SUCCEED;
+		}
+
+		retry_num = bulk->docs.values_num;
+	}
+	else if (CURLE_OK != result)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: %s",
+				'\0' != *bulk->errbuf ? bulk->errbuf : curl_easy_strerror(result));
+
+		/* If the error is due to curl internal problems or unrelated */
+		/* problems with HTTP, the whole request is resent */
+		retry_num = bulk->docs.values_num;
+	}
+	else if (0 == (retry_num = elastic_bulk_check_items(bulk)))
+		return SUCCEED;
+
+	elastic_stats.retried += (zbx_uint64_t)retry_num;
+
+	return FAIL;
 }
 
 /******************************************************************************************************************
@@ -335,7 +685,7 @@ static void	elastic_writer_init(void)
 	if (0 != writer.initialized)
 		return;
 
-	zbx_vector_ptr_create(&writer.ifaces);
+	zbx_vector_ptr_create(&writer.bulks);
 
 	if (NULL == (writer.handle = curl_multi_init()))
 	{
@@ -343,147 +693,111 @@ static void	elastic_writer_init(void)
 		exit(EXIT_FAILURE);
 	}
 
+	writer.headers = curl_slist_append(NULL, "Content-Type: application/x-ndjson");
+	writer.headers_gzip = curl_slist_append(NULL, "Content-Type: application/x-ndjson");
+	writer.headers_gzip = curl_slist_append(writer.headers_gzip, "Content-Encoding: gzip");
+
 	writer.initialized = 1;
 }
 
 /************************************************************************************
  *                                                                                  *
- * Purpose: releases initialized elastic writer by freeing allocated resources and  *
- *          setting its state to uninitialized.                                     *
+ * Purpose: releases bulk requests of the flushed batch, the multi handle is kept   *
+ *          for the next batch                                                      *
  *                                                                                  *
  ************************************************************************************/
 static void	elastic_writer_release(void)
 {
 	int	i;
 
-	for (i = 0; i < writer.ifaces.values_num; i++)
-		elastic_close((zbx_history_iface_t *)writer.ifaces.values[i]);
-
-	curl_multi_cleanup(writer.handle);
-	writer.handle = NULL;
-
-	zbx_vector_ptr_destroy(&writer.ifaces);
+	for (i = 0; i < writer.bulks.values_num; i++)
+		elastic_bulk_free((zbx_elastic_bulk_t *)writer.bulks.values[i]);
 
-	writer.initialized = 0;
+	zbx_vector_ptr_clear(&writer.bulks);
 }
 
 /************************************************************************************
  *                                                                                  *
- * Purpose: adds history storage interface to be flushed later                      *
- *                                                                                  *
- * Parameters: db_insert - [IN] bulk insert data                                    *
+ * Purpose: destroys elastic writer by freeing allocated resources and setting its  *
+ *          state to uninitialized                                                  *
  *                                                                                  *
  ************************************************************************************/
-static void	elastic_writer_add_iface(zbx_history_iface_t *hist)
+static void	elastic_writer_destroy(void)
 {
-	zbx_elastic_data_t	*data = hist->data.elastic_data;
-	CURLoption		opt;
-	CURLcode		err;
-	char			*error = NULL;
-
-	elastic_writer_init();
-
-	if (NULL == (data->handle = curl_easy_init()))
-	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
+	if (0 == writer.initialized)
 		return;
-	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POST, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, data->buf)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEFUNCTION,
-					curl_write_cb)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEDATA,
-					&page_w[hist->value_type].page)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_ERRORBUFFER,
-					page_w[hist->value_type].errbuf)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_ACCEPT_ENCODING, "")))
-	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
-		goto out;
-	}
-
-	if (SUCCEED != zbx_curl_setopt_https(data->handle, &error))
-	{
-		zabbix_log(LOG_LEVEL_ERR, error);
-		goto out;
-	}
-
-	*page_w[hist->value_type].errbuf = '\0';
+	elastic_writer_release();
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_PRIVATE, &page_w[hist->value_type])))
-	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
-		goto out;
-	}
+	curl_multi_cleanup(writer.handle);
+	writer.handle = NULL;
 
-	page_w[hist->value_type].page.offset = 0;
+	curl_slist_free_all(writer.headers);
+	curl_slist_free_all(writer.headers_gzip);
 
-	if (0 < page_w[hist->value_type].page.alloc)
-		*page_w[hist->value_type].page.data = '\0';
+	zbx_vector_ptr_destroy(&writer.bulks);
 
-	curl_multi_add_handle(writer.handle, data->handle);
+	writer.initialized = 0;
+}
 
-	zbx_vector_ptr_append(&writer.ifaces, hist);
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: adds bulk request to be flushed later                                   *
+ *                                                                                  *
+ * Parameters: bulk - [IN] the bulk request                                         *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_writer_add_bulk(zbx_elastic_bulk_t *bulk)
+{
+	elastic_writer_init();
 
-	return;
-out:
-	zbx_free(error);
-	elastic_close(hist);
+	zbx_vector_ptr_append(&writer.bulks, bulk);
 }
 
 /************************************************************************************
  *                                                                                  *
  * Purpose: posts historical data to elastic storage                                *
  *                                                                                  *
+ * Comments: Bulk requests are sent in parallel. Requests that failed because of    *
+ *           transport errors or overloaded storage are resent after sleeping for   *
+ *           ZBX_HISTORY_STORAGE_DOWN / 1000 seconds with only the documents that   *
+ *           were not written.                                                      *
+ *                                                                                  *
  ************************************************************************************/
 static int	elastic_writer_flush(void)
 {
-	struct curl_slist	*curl_headers = NULL;
-	int			i, running, previous, msgnum;
+	int			i, running, msgnum;
 	CURLMsg			*msg;
 	zbx_vector_ptr_t	retries;
-	CURLcode		err;
 	int			ret = SUCCEED;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	/* The writer might be uninitialized only if the history */
+	/* The writer might have no bulk requests only if the history */
 	/* was already flushed. In that case, return SUCCEED */
-	if (0 == writer.initialized)
+	if (0 == writer.initialized || 0 == writer.bulks.values_num)
 		goto end;
 
 	zbx_vector_ptr_create(&retries);
 
-	curl_headers = curl_slist_append(curl_headers, "Content-Type: application/x-ndjson");
-
-	for (i = 0; i < writer.ifaces.values_num; i++)
+	for (i = 0; i < writer.bulks.values_num; i++)
 	{
-		zbx_history_iface_t	*hist = (zbx_history_iface_t *)writer.ifaces.values[i];
-		zbx_elastic_data_t	*data = hist->data.elastic_data;
+		zbx_elastic_bulk_t	*bulk = (zbx_elastic_bulk_t *)writer.bulks.values[i];
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_HTTPHEADER, curl_headers)))
+		if (SUCCEED != elastic_bulk_prepare(bulk))
 		{
-			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_HTTPHEADER,
-					curl_easy_strerror(err));
 			ret = FAIL;
 			goto clean;
 		}
 
-		zabbix_log(LOG_LEVEL_DEBUG, "sending %s", data->buf);
+		curl_multi_add_handle(writer.handle, bulk->handle);
 	}
 
 try_again:
-	previous = 0;
-
 	do
 	{
 		int		fds;
 		CURLMcode	code;
-		char		*error;
-		zbx_curlpage_t	*curl_page;
 
 		if (CURLM_OK != (code = curl_multi_perform(writer.handle, &running)))
 		{
@@ -497,100 +811,52 @@ try_again:
 			break;
 		}
 
-		if (previous == running)
-			continue;
-
 		while (NULL != (msg = curl_multi_info_read(writer.handle, &msgnum)))
 		{
-			/* If the error is due to malformed data, there is no sense on re-trying to send. */
-			/* That's why we actually check for transport and curl errors separately */
-			if (CURLE_HTTP_RETURNED_ERROR == msg->data.result)
-			{
-				if (CURLE_OK == curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE,
-						(char **)&curl_page) && '\0' != *curl_page->errbuf)
-				{
-					zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, HTTP error"
-							" message: %s", curl_page->errbuf);
-				}
-				else
-				{
-					char		http_status[MAX_STRING_LEN];
-					long int	response_code;
-
-					if (CURLE_OK == curl_easy_getinfo(msg->easy_handle,
-							CURLINFO_RESPONSE_CODE, &response_code))
-					{
-						zbx_snprintf(http_status, sizeof(http_status), "HTTP status code: %ld",
-								response_code);
-					}
-					else
-					{
-						zbx_strlcpy(http_status, "unknown HTTP status code",
-								sizeof(http_status));
-					}
-
-					zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, %s", http_status);
-				}
-			}
-			else if (CURLE_OK != msg->data.result)
-			{
-				if (CURLE_OK == curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE,
-						(char **)&curl_page) && '\0' != *curl_page->errbuf)
-				{
-					zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: %s",
-							curl_page->errbuf);
-				}
-				else
-				{
-					zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: %s",
-							curl_easy_strerror(msg->data.result));
-				}
+			zbx_elastic_bulk_t	*bulk;
 
-				/* If the error is due to curl internal problems or unrelated */
-				/* problems with HTTP, we put the handle in a retry list and */
-				/* remove it from the current execution loop */
-				zbx_vector_ptr_append(&retries, msg->easy_handle);
-				curl_multi_remove_handle(writer.handle, msg->easy_handle);
-			}
-			else if (CURLE_OK == curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&curl_page)
-					&& SUCCEED == elastic_is_error_present(&curl_page->page, &error))
+			if (CURLMSG_DONE != msg->msg || CURLE_OK != curl_easy_getinfo(msg->easy_handle,
+					CURLINFO_PRIVATE, (char **)&bulk))
 			{
-				zabbix_log(LOG_LEVEL_WARNING, "%s() cannot send data to elasticsearch: %s",
-						__func__, error);
-				zbx_free(error);
-
-				/* If the error is due to elastic internal problems (for example an index */
-				/* became read-only), we put the handle in a retry list and */
-				/* remove it from the current execution loop */
-				zbx_vector_ptr_append(&retries, msg->easy_handle);
-				curl_multi_remove_handle(writer.handle, msg->easy_handle);
+				continue;
 			}
-		}
 
-		previous = running;
+			curl_multi_remove_handle(writer.handle, msg->easy_handle);
+
+			if (SUCCEED != elastic_bulk_process(bulk, msg->data.result))
+				zbx_vector_ptr_append(&retries, bulk);
+		}
 	}
-	while (running);
+	while (0 != running);
 
-	/* We check if we have handles to retry. If yes, we put them back in the multi */
+	/* We check if we have bulk requests to retry. If yes, we put them back in the multi */
 	/* handle and go to the beginning of the do while() for try sending the data again */
 	/* after sleeping for ZBX_HISTORY_STORAGE_DOWN / 1000 (seconds) */
 	if (0 < retries.values_num)
 	{
+		sleep(ZBX_HISTORY_STORAGE_DOWN / 1000);
+
 		for (i = 0; i < retries.values_num; i++)
-			curl_multi_add_handle(writer.handle, retries.values[i]);
+		{
+			zbx_elastic_bulk_t	*bulk = (zbx_elastic_bulk_t *)retries.values[i];
+
+			if (SUCCEED != elastic_bulk_prepare(bulk))
+			{
+				ret = FAIL;
+				goto clean;
+			}
+
+			curl_multi_add_handle(writer.handle, bulk->handle);
+		}
 
 		zbx_vector_ptr_clear(&retries);
 
-		sleep(ZBX_HISTORY_STORAGE_DOWN / 1000);
 		goto try_again;
 	}
 clean:
-	curl_slist_free_all(curl_headers);
-
 	zbx_vector_ptr_destroy(&retries);
 
 	elastic_writer_release();
-
 end:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
@@ -616,6 +882,9 @@ static void	elastic_destroy(zbx_history_iface_t *hist)
 
 	elastic_close(hist);
 
+	/* the writer is shared by all elastic history interfaces */
+	elastic_writer_destroy();
+
 	zbx_free(data->base_url);
 	zbx_free(data);
 }
@@ -1009,39 +1278,79 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 	return elastic_read_values_by_count(hist, itemid, count, end, values);
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: writes bulk action line with the target index                           *
+ *                                                                                  *
+ * Parameters:  json     - [OUT] the action line                                    *
+ *              index    - [IN] the index name                                      *
+ *              pipeline - [IN] the ingest pipeline name, optional (can be NULL)    *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_index_action(struct zbx_json *json, const char *index, const char *pipeline)
+{
+	zbx_json_clean(json);
+
+	zbx_json_addobject(json, "index");
+	zbx_json_addstring(json, "_index", index, ZBX_JSON_TYPE_STRING);
+
+	if (NULL != pipeline)
+		zbx_json_addstring(json, "pipeline", pipeline, ZBX_JSON_TYPE_STRING);
+
+	zbx_json_close(json);
+	zbx_json_close(json);
+}
+
 /************************************************************************************
  *                                                                                  *
  * Purpose: sends history data to the storage                                       *
  *                                                                                  *
  * Parameters:  hist    - [IN] the history storage interface                        *
  *              history - [IN] the history data vector (may have mixed value types) *
+ *              config_history_storage_pipelines - [IN] the date index mode         *
+ *                                                                                  *
+ * Comments: Values are split into up to bulk_streams bulk requests that are sent   *
+ *           in parallel when the history is flushed. With daily date index mode    *
+ *           values are stored in <value type>-YYYY-MM-DD indices by value clock    *
+ *           (UTC), the same names date index pipelines generate.                   *
  *                                                                                  *
  ************************************************************************************/
 static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_dc_history_ptr_t *history,
 		int config_history_storage_pipelines)
 {
 	zbx_elastic_data_t	*data = hist->data.elastic_data;
-	int			i, num = 0;
+	int			i, num = 0, bulks_num, docs_max;
 	zbx_dc_history_t	*h;
 	struct zbx_json		json_idx, json;
-	size_t			buf_alloc = 0, buf_offset = 0;
+	zbx_elastic_bulk_t	*bulk = NULL;
+	time_t			day_start = 0, day_end = 0;
 	char			pipeline[14]; /* index name length + suffix "-pipeline" */
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_json_init(&json_idx, ZBX_IDX_JSON_ALLOCATE);
+	for (i = 0; i < history->values_num; i++)
+	{
+		if (hist->value_type == history->values[i]->value_type)
+			num++;
+	}
+
+	if (0 == num)
+		goto out;
 
-	zbx_json_addobject(&json_idx, "index");
-	zbx_json_addstring(&json_idx, "_index", value_type_str[hist->value_type], ZBX_JSON_TYPE_STRING);
+	/* split values between parallel bulk requests, but avoid sending too small requests */
+	bulks_num = MIN(data->bulk_streams, (num + ZBX_ELASTIC_BULK_DOCS_MIN - 1) / ZBX_ELASTIC_BULK_DOCS_MIN);
+	docs_max = (num + bulks_num - 1) / bulks_num;
 
-	if (1 == config_history_storage_pipelines)
+	zbx_json_init(&json_idx, ZBX_IDX_JSON_ALLOCATE);
+	zbx_json_init(&json, ZBX_JSON_ALLOCATE);
+
+	if (ZBX_ELASTIC_DATE_INDEX_PIPELINE == config_history_storage_pipelines)
 	{
 		zbx_snprintf(pipeline, sizeof(pipeline), "%s-pipeline", value_type_str[hist->value_type]);
-		zbx_json_addstring(&json_idx, "pipeline", pipeline, ZBX_JSON_TYPE_STRING);
+		elastic_index_action(&json_idx, value_type_str[hist->value_type], pipeline);
 	}
-
-	zbx_json_close(&json_idx);
-	zbx_json_close(&json_idx);
+	else
+		elastic_index_action(&json_idx, value_type_str[hist->value_type], NULL);
 
 	for (i = 0; i < history->values_num; i++)
 	{
@@ -1050,7 +1359,28 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_dc_his
 		if (hist->value_type != h->value_type)
 			continue;
 
-		zbx_json_init(&json, ZBX_JSON_ALLOCATE);
+		if (ZBX_ELASTIC_DATE_INDEX_DAILY == config_history_storage_pipelines &&
+				(h->ts.sec < day_start || h->ts.sec >= day_end))
+		{
+			char		index[32];
+			struct tm	tm;
+
+			day_start = h->ts.sec - h->ts.sec % SEC_PER_DAY;
+			day_end = day_start + SEC_PER_DAY;
+
+			gmtime_r(&day_start, &tm);
+			zbx_snprintf(index, sizeof(index), "%s-%04d-%02d-%02d", value_type_str[hist->value_type],
+					tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+			elastic_index_action(&json_idx, index, NULL);
+		}
+
+		if (NULL == bulk || docs_max == bulk->docs.values_num)
+		{
+			bulk = elastic_bulk_create(data->base_url, data->bulk_compression);
+			elastic_writer_add_bulk(bulk);
+		}
+
+		zbx_json_clean(&json);
 
 		zbx_json_adduint64(&json, "itemid", h->itemid);
 
@@ -1074,21 +1404,12 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_dc_his
 
 		zbx_json_close(&json);
 
-		zbx_snprintf_alloc(&data->buf, &buf_alloc, &buf_offset, "%s\n%s\n", json_idx.buffer, json.buffer);
-
-		zbx_json_free(&json);
-
-		num++;
-	}
-
-	if (num > 0)
-	{
-		data->post_url = zbx_dsprintf(NULL, "%s/_bulk", data->base_url);
-		elastic_writer_add_iface(hist);
+		elastic_bulk_add_doc(bulk, json_idx.buffer, json.buffer);
 	}
 
+	zbx_json_free(&json);
 	zbx_json_free(&json_idx);
-
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
 	return num;
@@ -1119,6 +1440,10 @@ static int	elastic_flush(zbx_history_iface_t *hist)
  *    hist                       - [IN] history storage interface                   *
  *    value_type                 - [IN] target value type                           *
  *    config_history_storage_url - [IN]                                             *
+ *    config_log_slow_queries    - [IN]                                             *
+ *    bulk_streams               - [IN] number of parallel bulk requests per value  *
+ *                                      type                                        *
+ *    bulk_compression           - [IN] 1 - gzip compress bulk requests             *
  *    error                      - [OUT] error message                              *
  *                                                                                  *
  * Return value: SUCCEED - history storage interface was initialized                *
@@ -1126,7 +1451,8 @@ static int	elastic_flush(zbx_history_iface_t *hist)
  *                                                                                  *
  ************************************************************************************/
 int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type,
-		const char *config_history_storage_url, int config_log_slow_queries, char **error)
+		const char *config_history_storage_url, int config_log_slow_queries, int bulk_streams,
+		int bulk_compression, char **error)
 {
 	zbx_elastic_data_t	*data;
 
@@ -1143,9 +1469,10 @@ int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type
 	memset(data, 0, sizeof(zbx_elastic_data_t));
 	data->base_url = zbx_strdup(NULL, config_history_storage_url);
 	zbx_rtrim(data->base_url, "/");
-	data->buf = NULL;
 	data->post_url = NULL;
 	data->handle = NULL;
+	data->bulk_streams = MAX(bulk_streams, 1);
+	data->bulk_compression = (unsigned char)bulk_compression;
 
 	hist->value_type = value_type;
 	hist->data.elastic_data = data;
@@ -1329,14 +1656,39 @@ zbx_uint32_t	zbx_elastic_version_get(void)
 
 	return ZBX_ELASTIC_SVERSION;
 }
+
+/************************************************************************************
+ *                                                                                  *
+ * Purpose: gets and resets history storage statistics collected by the current     *
+ *          process                                                                 *
+ *                                                                                  *
+ * Parameters:  stats - [OUT] the statistics                                        *
+ *                                                                                  *
+ * Return value: SUCCEED - bulk requests were sent since the last call              *
+ *               FAIL    - otherwise                                                *
+ *                                                                                  *
+ ************************************************************************************/
+int	zbx_elastic_get_stats(zbx_history_storage_stats_t *stats)
+{
+	if (0 == elastic_stats.requests)
+		return FAIL;
+
+	*stats = elastic_stats;
+	memset(&elastic_stats, 0, sizeof(elastic_stats));
+
+	return SUCCEED;
+}
 #else
 int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type,
-		const char *config_history_storage_url, int config_log_slow_queries, char **error)
+		const char *config_history_storage_url, int config_log_slow_queries, int bulk_streams,
+		int bulk_compression, char **error)
 {
 	ZBX_UNUSED(hist);
 	ZBX_UNUSED(value_type);
 	ZBX_UNUSED(config_history_storage_url);
 	ZBX_UNUSED(config_log_slow_queries);
+	ZBX_UNUSED(bulk_streams);
+	ZBX_UNUSED(bulk_compression);
 
 	*error = zbx_strdup(*error, "Zabbix must be compiled with cURL library for Elasticsearch history backend");
 
@@ -1356,4 +1708,11 @@ zbx_uint32_t	zbx_elastic_version_get(void)
 {
 	return ZBX_DBVERSION_UNDEFINED;
 }
+
+int	zbx_elastic_get_stats(zbx_history_storage_stats_t *stats)
+{
+	ZBX_UNUSED(stats);
+
+	return FAIL;
+}
 #endif
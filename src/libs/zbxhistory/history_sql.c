@@ -196,6 +196,7 @@ static void	add_history_dbl(const zbx_vector_dc_history_ptr_t *history)
 	zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 
 	zbx_db_insert_prepare(db_insert, "history", "itemid", "clock", "ns", "value", (char *)NULL);
+	zbx_db_insert_set_bulk_load(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
@@ -215,6 +216,7 @@ static void	add_history_uint(const zbx_vector_dc_history_ptr_t *history)
 	zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 
 	zbx_db_insert_prepare(db_insert, "history_uint", "itemid", "clock", "ns", "value", (char *)NULL);
+	zbx_db_insert_set_bulk_load(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
@@ -234,6 +236,7 @@ static void	add_history_str(const zbx_vector_dc_history_ptr_t *history)
 	zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 
 	zbx_db_insert_prepare(db_insert, "history_str", "itemid", "clock", "ns", "value", (char *)NULL);
+	zbx_db_insert_set_bulk_load(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
@@ -253,6 +256,7 @@ static void	add_history_text(const zbx_vector_dc_history_ptr_t *history)
 	zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 
 	zbx_db_insert_prepare(db_insert, "history_text", "itemid", "clock", "ns", "value", (char *)NULL);
+	zbx_db_insert_set_bulk_load(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
@@ -273,6 +277,7 @@ static void	add_history_log(const zbx_vector_dc_history_ptr_t *history)
 
 	zbx_db_insert_prepare(db_insert, "history_log", "itemid", "clock", "ns", "timestamp", "source", "severity",
 			"value", "logeventid", (char *)NULL);
+	zbx_db_insert_set_bulk_load(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
@@ -296,6 +301,7 @@ static void	add_history_bin(const zbx_vector_dc_history_ptr_t *history)
 	zbx_db_insert_t	*db_insert = (zbx_db_insert_t *)zbx_malloc(NULL, sizeof(zbx_db_insert_t));
 
 	zbx_db_insert_prepare(db_insert, "history_bin", "itemid", "clock", "ns", "value", (char *)NULL);
+	zbx_db_insert_set_bulk_load(db_insert);
 
 	for (int i = 0; i < history->values_num; i++)
 	{
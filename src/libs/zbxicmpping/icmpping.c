@@ -13,6 +13,7 @@
 **/
 
 #include "zbxicmpping.h"
+#include "icmpping_native.h"
 
 #ifdef HAVE_IPV6
 #	include "zbxcomms.h"
@@ -46,6 +47,9 @@ static ZBX_THREAD_LOCAL int		fping_ipv6_supported;
 
 static ZBX_THREAD_LOCAL time_t		fping_check_reset_at;	/* time of the last fping options expiration */
 static ZBX_THREAD_LOCAL char		tmpfile_uniq[255] = {'\0'};
+#ifdef HAVE_LIBEVENT
+static ZBX_THREAD_LOCAL unsigned char	native_icmp_failed;	/* ICMP sockets cannot be opened, fping is used */
+#endif
 
 typedef struct
 {
@@ -1199,18 +1203,30 @@ void	zbx_init_icmpping_env(const char *prefix, long int id)
  * Return value: SUCCEED - successfully processed hosts                       *
  *               NOTSUPPORTED - otherwise                                     *
  *                                                                            *
- * Comments: use external binary 'fping' to avoid superuser privileges        *
+ * Comments: When native ICMP is enabled the hosts are pinged over ICMP       *
+ *           sockets, otherwise external binary 'fping' is used to avoid      *
+ *           superuser privileges. Falls back to 'fping' if ICMP sockets      *
+ *           cannot be opened.                                                *
  *                                                                            *
  ******************************************************************************/
 int	zbx_ping(zbx_fping_host_t *hosts, int hosts_count, int requests_count, int period, int size, int timeout,
 		unsigned char allow_redirect, int rdns, char *error, size_t max_error_len)
 {
-	int	ret;
+	int	ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hosts_count:%d", __func__, hosts_count);
 
-	if (NOTSUPPORTED == (ret = hosts_ping(hosts, hosts_count, requests_count, period, size, timeout,
-			allow_redirect, rdns, error, max_error_len)))
+#ifdef HAVE_LIBEVENT
+	if (0 != config_icmpping->get_enable_native_icmp() && 0 == native_icmp_failed &&
+			SUCCEED != (ret = icmpping_native_ping(hosts, hosts_count, requests_count, period, size,
+			timeout, allow_redirect, rdns, config_icmpping->get_source_ip(), error, max_error_len)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot use native ICMP, falling back to fping: %s", error);
+		native_icmp_failed = 1;
+	}
+#endif
+	if (SUCCEED != ret && NOTSUPPORTED == (ret = hosts_ping(hosts, hosts_count, requests_count, period, size,
+			timeout, allow_redirect, rdns, error, max_error_len)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "%s", error);
 	}
@@ -0,0 +1,762 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "icmpping_native.h"
+
+#ifdef HAVE_LIBEVENT
+
+#include "zbxtime.h"
+
+#include <event2/event.h>
+#include <event2/util.h>
+
+#define ZBX_ICMP_ECHO_REPLY		0
+#define ZBX_ICMP_ECHO_REQUEST		8
+#define ZBX_ICMP6_ECHO_REQUEST		128
+#define ZBX_ICMP6_ECHO_REPLY		129
+
+/* defaults of fping options used by zbx_ping() */
+#define ZBX_ICMP_DEFAULT_PERIOD		1000	/* -p, milliseconds */
+#define ZBX_ICMP_DEFAULT_SIZE		56	/* -b, bytes */
+#define ZBX_ICMP_DEFAULT_TIMEOUT_MAX	2000	/* -t defaults to -p period up to 2 seconds, milliseconds */
+#define ZBX_ICMP_TARGET_INTERVAL	10	/* -i, maximum interval between requests to targets, milliseconds */
+
+#define ZBX_ICMP_SEQ_MAX		65536
+#define ZBX_ICMP_SEND_BURST		256	/* maximum requests sent at once before polling replies */
+#define ZBX_ICMP_RECV_SIZE		512	/* only IP and ICMP headers of replies are inspected */
+#define ZBX_ICMP_RCVBUF			(4 * ZBX_MEBIBYTE)
+
+typedef struct
+{
+	unsigned char	type;
+	unsigned char	code;
+	unsigned short	checksum;
+	unsigned short	id;
+	unsigned short	seq;
+}
+zbx_icmp_echo_t;
+
+typedef struct
+{
+	zbx_fping_host_t	*host;
+	struct sockaddr_storage	addr;
+	socklen_t		addr_len;
+	double			*rtt;	/* response times of individual requests in ms, negative - no response */
+}
+zbx_icmp_target_t;
+
+/* request waiting for reply, indexed by ICMP sequence number */
+typedef struct
+{
+	int	target;		/* target index, -1 - slot is free */
+	int	request;	/* request index of the target */
+	double	sent;
+}
+zbx_icmp_slot_t;
+
+typedef struct
+{
+	evutil_socket_t	fd;
+	int		type;	/* SOCK_DGRAM - unprivileged ICMP socket, SOCK_RAW - raw socket */
+	struct event	*ev;
+}
+zbx_icmp_socket_t;
+
+typedef struct
+{
+	zbx_icmp_target_t	*targets;
+	int			targets_num;
+	int			requests_count;
+	int			requests_num;	/* total number of requests to all targets */
+	int			sent;		/* number of requests sent so far */
+	int			pending;	/* number of requests waiting for reply */
+	double			start;
+	double			period;		/* interval between requests to one target, seconds */
+	double			step;		/* interval between requests to subsequent targets, seconds */
+	double			timeout;	/* seconds */
+	double			last_sent;
+	unsigned char		allow_redirect;
+	unsigned short		ident;
+	unsigned char		*packet;
+	size_t			packet_len;
+	zbx_icmp_slot_t		*slots;
+	int			slots_num;
+	int			seq;
+	zbx_icmp_socket_t	sock4;
+	zbx_icmp_socket_t	sock6;
+	struct event_base	*base;
+	struct event		*timer;
+	int			finished;
+}
+zbx_icmp_engine_t;
+
+/* identifies replies on raw sockets, the address of thread local variable distinguishes discoverer threads */
+static ZBX_THREAD_LOCAL unsigned short	icmp_ident;
+
+static unsigned short	icmp_checksum(const unsigned char *data, size_t len)
+{
+	unsigned int	sum = 0;
+	size_t		i;
+
+	for (i = 0; i + 1 < len; i += 2)
+		sum += (unsigned int)(data[i] << 8 | data[i + 1]);
+
+	if (i < len)
+		sum += (unsigned int)(data[i] << 8);
+
+	while (0 != (sum >> 16))
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return htons((unsigned short)~sum);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: rounds response time the same way fping prints it                 *
+ *                                                                            *
+ * Parameters: ms - [IN] response time in milliseconds                        *
+ *                                                                            *
+ * Return value: response time in milliseconds as reported by fping           *
+ *                                                                            *
+ * Comments: Statistics of fping based checks are calculated from the fping   *
+ *           output, rounding keeps the results of both methods identical.    *
+ *                                                                            *
+ ******************************************************************************/
+static double	icmp_rtt_round(double ms)
+{
+	char	buf[32];
+	int	precision;
+
+	if (1.0 > ms)
+		precision = 3;
+	else if (10.0 > ms)
+		precision = 2;
+	else if (100.0 > ms)
+		precision = 1;
+	else
+		precision = 0;
+
+	zbx_snprintf(buf, sizeof(buf), "%.*f", precision, ms);
+
+	return atof(buf);
+}
+
+static int	icmp_addr_resolve(const char *addr, int family, int flags, struct sockaddr_storage *sa,
+		socklen_t *sa_len)
+{
+	struct addrinfo	hints, *ai;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = family;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_flags = flags;
+
+	if (0 != getaddrinfo(addr, NULL, &hints, &ai))
+		return FAIL;
+
+	memcpy(sa, ai->ai_addr, ai->ai_addrlen);
+	*sa_len = (socklen_t)ai->ai_addrlen;
+	freeaddrinfo(ai);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: resolves target address                                           *
+ *                                                                            *
+ * Parameters: target - [OUT]                                                 *
+ *             addr   - [IN] IP address or DNS name                           *
+ *             family - [IN] address family of source IP, AF_UNSPEC if source *
+ *                           IP is not configured                             *
+ *                                                                            *
+ * Return value: SUCCEED - address was resolved                               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_target_resolve(zbx_icmp_target_t *target, const char *addr, int family)
+{
+	if (AF_UNSPEC != family)
+		return icmp_addr_resolve(addr, family, 0, &target->addr, &target->addr_len);
+
+	/* IPv4 addresses are preferred as fping is executed before fping6, but unlike with fping6 the IPv6 address */
+	/* of a dual-stack name is not pinged again, see EnableNativeICMP description                               */
+	if (SUCCEED == icmp_addr_resolve(addr, AF_INET, 0, &target->addr, &target->addr_len))
+		return SUCCEED;
+#ifdef HAVE_IPV6
+	return icmp_addr_resolve(addr, AF_INET6, 0, &target->addr, &target->addr_len);
+#else
+	return FAIL;
+#endif
+}
+
+static int	icmp_addr_compare(const zbx_icmp_target_t *target, const struct sockaddr_storage *sa)
+{
+	if (target->addr.ss_family != sa->ss_family)
+		return FAIL;
+
+	if (AF_INET == sa->ss_family)
+	{
+		return 0 == memcmp(&((const struct sockaddr_in *)&target->addr)->sin_addr,
+				&((const struct sockaddr_in *)sa)->sin_addr, sizeof(struct in_addr)) ? SUCCEED : FAIL;
+	}
+#ifdef HAVE_IPV6
+	if (AF_INET6 == sa->ss_family)
+	{
+		return 0 == memcmp(&((const struct sockaddr_in6 *)&target->addr)->sin6_addr,
+				&((const struct sockaddr_in6 *)sa)->sin6_addr, sizeof(struct in6_addr)) ? SUCCEED : FAIL;
+	}
+#endif
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: opens ICMP socket                                                 *
+ *                                                                            *
+ * Parameters: sock          - [OUT]                                          *
+ *             family        - [IN] AF_INET or AF_INET6                       *
+ *             source        - [IN] source address                            *
+ *             source_len    - [IN] source address length, 0 if source        *
+ *                                  address is not configured                 *
+ *             error         - [OUT] error message                            *
+ *             max_error_len - [IN] length of error buffer                    *
+ *                                                                            *
+ * Return value: SUCCEED - socket was opened                                  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Unprivileged ICMP sockets are preferred, raw sockets require     *
+ *           root privileges or CAP_NET_RAW capability.                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_socket_open(zbx_icmp_socket_t *sock, int family, const struct sockaddr_storage *source,
+		socklen_t source_len, char *error, size_t max_error_len)
+{
+	int		protocol = IPPROTO_ICMP, rcvbuf = ZBX_ICMP_RCVBUF;
+	const char	*name = "ICMP";
+
+#ifdef HAVE_IPV6
+	if (AF_INET6 == family)
+	{
+		protocol = IPPROTO_ICMPV6;
+		name = "ICMPv6";
+	}
+#endif
+	if (-1 != (sock->fd = socket(family, SOCK_DGRAM, protocol)))
+	{
+		sock->type = SOCK_DGRAM;
+	}
+	else if (-1 != (sock->fd = socket(family, SOCK_RAW, protocol)))
+	{
+		sock->type = SOCK_RAW;
+	}
+	else
+	{
+		zbx_snprintf(error, max_error_len, "cannot create %s socket: %s", name, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	/* replies to large batches arrive in bursts */
+	if (0 != setsockopt(sock->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)))
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot set %s socket receive buffer: %s", name, zbx_strerror(errno));
+
+	if (0 != evutil_make_socket_nonblocking(sock->fd) || 0 != evutil_make_socket_closeonexec(sock->fd))
+	{
+		zbx_snprintf(error, max_error_len, "cannot set %s socket options: %s", name, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if (0 != source_len && family == source->ss_family &&
+			0 != bind(sock->fd, (const struct sockaddr *)source, source_len))
+	{
+		zbx_snprintf(error, max_error_len, "cannot bind %s socket to source address: %s", name,
+				zbx_strerror(errno));
+		return FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "opened %s %s socket", SOCK_RAW == sock->type ? "raw" : "unprivileged", name);
+
+	return SUCCEED;
+}
+
+static double	icmp_request_due(const zbx_icmp_engine_t *engine)
+{
+	return engine->start + engine->sent % engine->targets_num * engine->step +
+			engine->sent / engine->targets_num * engine->period;
+}
+
+static void	icmp_request_send(zbx_icmp_engine_t *engine)
+{
+	int			target_idx = engine->sent % engine->targets_num;
+	zbx_icmp_target_t	*target = &engine->targets[target_idx];
+	zbx_icmp_slot_t		*slot = &engine->slots[engine->seq];
+	zbx_icmp_echo_t		echo;
+	evutil_socket_t		fd;
+
+	echo.code = 0;
+	echo.checksum = 0;
+	echo.id = htons(engine->ident);
+	echo.seq = htons((unsigned short)engine->seq);
+
+	if (AF_INET == target->addr.ss_family)
+	{
+		echo.type = ZBX_ICMP_ECHO_REQUEST;
+		fd = engine->sock4.fd;
+		memcpy(engine->packet, &echo, sizeof(echo));
+		echo.checksum = icmp_checksum(engine->packet, engine->packet_len);
+	}
+	else
+	{
+		/* ICMPv6 checksum includes IPv6 pseudo header and is calculated by kernel */
+		echo.type = ZBX_ICMP6_ECHO_REQUEST;
+		fd = engine->sock6.fd;
+	}
+
+	memcpy(engine->packet, &echo, sizeof(echo));
+
+	slot->sent = zbx_time();
+
+	if (-1 == sendto(fd, engine->packet, engine->packet_len, 0, (const struct sockaddr *)&target->addr,
+			target->addr_len))
+	{
+		/* fping reports such requests as timed out */
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot send ICMP echo request to \"%s\": %s", target->host->addr,
+				zbx_strerror(errno));
+		slot->target = -1;
+	}
+	else
+	{
+		slot->target = target_idx;
+		slot->request = engine->sent / engine->targets_num;
+		engine->pending++;
+	}
+
+	engine->last_sent = slot->sent;
+	engine->seq = (engine->seq + 1) % engine->slots_num;
+	engine->sent++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends requests that are due                                       *
+ *                                                                            *
+ * Comments: The k-th request to the n-th target is sent at                   *
+ *           start + n * step + k * period, so each target receives requests  *
+ *           at the configured period, while requests to different targets    *
+ *           are spread evenly within the period.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	icmp_requests_send(zbx_icmp_engine_t *engine, double now)
+{
+	for (int i = 0; ZBX_ICMP_SEND_BURST > i && engine->sent < engine->requests_num; i++)
+	{
+		zbx_icmp_slot_t	*slot = &engine->slots[engine->seq];
+
+		if (icmp_request_due(engine) > now)
+			break;
+
+		if (-1 != slot->target)
+		{
+			/* sequence number is reused only after the request it was assigned to times out */
+			if (slot->sent + engine->timeout > now)
+				break;
+
+			engine->pending--;
+		}
+
+		icmp_request_send(engine);
+	}
+}
+
+static void	icmp_engine_schedule(zbx_icmp_engine_t *engine, double now)
+{
+	struct timeval	tv;
+	double		next, delay;
+
+	if (engine->sent == engine->requests_num)
+	{
+		next = engine->last_sent + engine->timeout;
+
+		if (0 == engine->pending || next <= now)
+		{
+			engine->finished = 1;
+			event_base_loopbreak(engine->base);
+			return;
+		}
+	}
+	else
+	{
+		const zbx_icmp_slot_t	*slot = &engine->slots[engine->seq];
+
+		next = icmp_request_due(engine);
+
+		if (-1 != slot->target)
+			next = MAX(next, slot->sent + engine->timeout);
+	}
+
+	delay = MAX(next - now, 0);
+	tv.tv_sec = (time_t)delay;
+	tv.tv_usec = (suseconds_t)((delay - (double)tv.tv_sec) * 1000000);
+
+	evtimer_add(engine->timer, &tv);
+}
+
+static void	icmp_timer_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_icmp_engine_t	*engine = (zbx_icmp_engine_t *)arg;
+	double			now;
+
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+
+	now = zbx_time();
+	icmp_requests_send(engine, now);
+	icmp_engine_schedule(engine, now);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: matches reply to request and records response time                *
+ *                                                                            *
+ * Parameters: engine - [IN/OUT]                                              *
+ *             sock   - [IN] socket the reply was received on                 *
+ *             buf    - [IN] received packet                                  *
+ *             len    - [IN] received packet length                           *
+ *             from   - [IN] reply source address                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	icmp_reply_process(zbx_icmp_engine_t *engine, const zbx_icmp_socket_t *sock, const unsigned char *buf,
+		size_t len, const struct sockaddr_storage *from)
+{
+	zbx_icmp_echo_t		echo;
+	zbx_icmp_slot_t		*slot;
+	zbx_icmp_target_t	*target;
+	unsigned char		reply_type = ZBX_ICMP6_ECHO_REPLY;
+	unsigned short		seq;
+	double			now = zbx_time();
+
+	if (sock == &engine->sock4)
+	{
+		/* raw sockets and unprivileged sockets on some systems return IPv4 header */
+		if (0 < len && 4 == (buf[0] >> 4))
+		{
+			size_t	header_len = (size_t)(buf[0] & 0x0f) * 4;
+
+			if (header_len > len)
+				return;
+
+			buf += header_len;
+			len -= header_len;
+		}
+
+		reply_type = ZBX_ICMP_ECHO_REPLY;
+	}
+
+	if (sizeof(echo) > len)
+		return;
+
+	memcpy(&echo, buf, sizeof(echo));
+
+	if (reply_type != echo.type || 0 != echo.code)
+		return;
+
+	/* kernel replaces identifier of unprivileged sockets and delivers only replies to own requests */
+	if (SOCK_RAW == sock->type && engine->ident != ntohs(echo.id))
+		return;
+
+	if (engine->slots_num <= (seq = ntohs(echo.seq)) || -1 == (slot = &engine->slots[seq])->target)
+		return;
+
+	target = &engine->targets[slot->target];
+
+	if (now - slot->sent > engine->timeout)
+		return;
+
+	/* replies from other than target address are redirects, see redirect_detect() */
+	if (SUCCEED != icmp_addr_compare(target, from) && 0 == engine->allow_redirect)
+		return;
+
+	target->rtt[slot->request] = (now - slot->sent) * 1000;
+	slot->target = -1;
+	engine->pending--;
+}
+
+static void	icmp_read_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_icmp_engine_t	*engine = (zbx_icmp_engine_t *)arg;
+	const zbx_icmp_socket_t	*sock = fd == engine->sock4.fd ? &engine->sock4 : &engine->sock6;
+	unsigned char		buf[ZBX_ICMP_RECV_SIZE];
+	ssize_t			n;
+
+	ZBX_UNUSED(what);
+
+	for (;;)
+	{
+		struct sockaddr_storage	from;
+		socklen_t		from_len = sizeof(from);
+
+		if (-1 == (n = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len)))
+			break;
+
+		icmp_reply_process(engine, sock, buf, (size_t)n, &from);
+	}
+
+	if (engine->sent == engine->requests_num && 0 == engine->pending)
+	{
+		engine->finished = 1;
+		event_base_loopbreak(engine->base);
+	}
+}
+
+static int	icmp_socket_event_add(zbx_icmp_engine_t *engine, zbx_icmp_socket_t *sock, char *error,
+		size_t max_error_len)
+{
+	if (-1 == sock->fd)
+		return SUCCEED;
+
+	if (NULL == (sock->ev = event_new(engine->base, sock->fd, EV_READ | EV_PERSIST, icmp_read_cb, engine)) ||
+			0 != event_add(sock->ev, NULL))
+	{
+		zbx_strlcpy(error, "cannot add ICMP socket event", max_error_len);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+static void	icmp_socket_close(zbx_icmp_socket_t *sock)
+{
+	if (NULL != sock->ev)
+		event_free(sock->ev);
+
+	if (-1 != sock->fd)
+		close(sock->fd);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates target statistics like stats_calc() from fping output  *
+ *                                                                            *
+ ******************************************************************************/
+static void	icmp_target_stats_calc(const zbx_icmp_target_t *target, int requests_count)
+{
+	zbx_fping_host_t	*host = target->host;
+
+	for (int i = 0; i < requests_count; i++)
+	{
+		double	sec;
+
+		if (0 > target->rtt[i])
+			continue;
+
+		sec = icmp_rtt_round(target->rtt[i]) / 1000; /* convert ms to seconds */
+
+		if (0 == host->rcv || host->min > sec)
+			host->min = sec;
+		if (0 == host->rcv || host->max < sec)
+			host->max = sec;
+		host->sum += sec;
+		host->rcv++;
+	}
+
+	host->cnt += requests_count;
+}
+
+static void	icmp_target_dnsname_get(const zbx_icmp_target_t *target)
+{
+	zbx_fping_host_t	*host = target->host;
+	char			name[ZBX_MAX_DNSNAME_LEN + 1];
+
+	/* only names of responding hosts are used */
+	if (0 != host->rcv && 0 == getnameinfo((const struct sockaddr *)&target->addr, target->addr_len, name,
+			sizeof(name), NULL, 0, NI_NAMEREQD))
+	{
+		if (NULL == host->dnsname || '\0' == *host->dnsname)
+			host->dnsname = zbx_strdup(host->dnsname, name);
+	}
+	else if (NULL == host->dnsname)
+		host->dnsname = zbx_strdup(NULL, "");
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pings hosts with ICMP echo requests without executing fping       *
+ *                                                                            *
+ * Parameters: see zbx_ping()                                                 *
+ *             source_ip - [IN] source IP address, NULL if not configured     *
+ *                                                                            *
+ * Return value: SUCCEED - hosts were pinged                                  *
+ *               FAIL    - ICMP sockets are not available                     *
+ *                                                                            *
+ * Comments: Results are the same as calculated from the fping output with    *
+ *           the same options. Hosts that cannot be resolved are left with    *
+ *           zero sent requests count.                                        *
+ *                                                                            *
+ ******************************************************************************/
+int	icmpping_native_ping(zbx_fping_host_t *hosts, int hosts_count, int requests_count, int period, int size,
+		int timeout, unsigned char allow_redirect, int rdns, const char *source_ip, char *error,
+		size_t max_error_len)
+{
+	zbx_icmp_engine_t	engine;
+	struct sockaddr_storage	source;
+	socklen_t		source_len = 0;
+	int			i, ret = FAIL, family = AF_UNSPEC, families = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hosts_count:%d requests_count:%d period:%d size:%d timeout:%d",
+			__func__, hosts_count, requests_count, period, size, timeout);
+
+	memset(&engine, 0, sizeof(engine));
+	engine.sock4.fd = -1;
+	engine.sock6.fd = -1;
+
+	if (NULL != source_ip)
+	{
+#ifdef HAVE_IPV6
+		family = AF_UNSPEC;
+#else
+		family = AF_INET;
+#endif
+		if (SUCCEED != icmp_addr_resolve(source_ip, family, AI_NUMERICHOST, &source, &source_len))
+		{
+			zbx_snprintf(error, max_error_len, "invalid source IP address \"%s\"", source_ip);
+			goto out;
+		}
+
+		/* like fping, only targets of the source IP address family are pinged */
+		family = source.ss_family;
+	}
+
+	engine.targets = (zbx_icmp_target_t *)zbx_malloc(NULL, sizeof(zbx_icmp_target_t) * (size_t)hosts_count);
+
+	for (i = 0; i < hosts_count; i++)
+	{
+		zbx_icmp_target_t	*target = &engine.targets[engine.targets_num];
+
+		if (SUCCEED != icmp_target_resolve(target, hosts[i].addr, family))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot resolve \"%s\"", hosts[i].addr);
+			continue;
+		}
+
+		target->host = &hosts[i];
+		target->rtt = (double *)zbx_malloc(NULL, sizeof(double) * (size_t)requests_count);
+
+		for (int j = 0; j < requests_count; j++)
+			target->rtt[j] = -1;
+
+		families |= AF_INET == target->addr.ss_family ? 0x01 : 0x02;
+		engine.targets_num++;
+	}
+
+	if (0 != (families & 0x01) && SUCCEED != icmp_socket_open(&engine.sock4, AF_INET, &source, source_len,
+			error, max_error_len))
+	{
+		goto out;
+	}
+#ifdef HAVE_IPV6
+	if (0 != (families & 0x02) && SUCCEED != icmp_socket_open(&engine.sock6, AF_INET6, &source, source_len,
+			error, max_error_len))
+	{
+		goto out;
+	}
+#endif
+	if (0 == engine.targets_num)
+	{
+		ret = SUCCEED;
+		goto out;
+	}
+
+	if (NULL == (engine.base = event_base_new()))
+	{
+		zbx_strlcpy(error, "cannot initialize event base", max_error_len);
+		goto out;
+	}
+
+	if (SUCCEED != icmp_socket_event_add(&engine, &engine.sock4, error, max_error_len) ||
+			SUCCEED != icmp_socket_event_add(&engine, &engine.sock6, error, max_error_len))
+	{
+		goto out;
+	}
+
+	if (NULL == (engine.timer = evtimer_new(engine.base, icmp_timer_cb, &engine)))
+	{
+		zbx_strlcpy(error, "cannot create ICMP timer event", max_error_len);
+		goto out;
+	}
+
+	if (0 == period)
+		period = ZBX_ICMP_DEFAULT_PERIOD;
+
+	if (0 == timeout)
+		timeout = MIN(period, ZBX_ICMP_DEFAULT_TIMEOUT_MAX);
+
+	if (0 == icmp_ident)
+		icmp_ident = (unsigned short)(getpid() ^ (int)((uintptr_t)&icmp_ident >> 4));
+
+	engine.requests_count = requests_count;
+	engine.requests_num = engine.targets_num * requests_count;
+	engine.period = period / 1000.0;
+	engine.step = MIN(engine.period / engine.targets_num, ZBX_ICMP_TARGET_INTERVAL / 1000.0);
+	engine.timeout = timeout / 1000.0;
+	engine.allow_redirect = allow_redirect;
+	engine.ident = icmp_ident;
+	engine.packet_len = sizeof(zbx_icmp_echo_t) + (size_t)(0 != size ? size : ZBX_ICMP_DEFAULT_SIZE);
+	engine.packet = (unsigned char *)zbx_calloc(NULL, 1, engine.packet_len);
+	engine.slots_num = MIN(engine.requests_num, ZBX_ICMP_SEQ_MAX);
+	engine.slots = (zbx_icmp_slot_t *)zbx_malloc(NULL, sizeof(zbx_icmp_slot_t) * (size_t)engine.slots_num);
+
+	for (i = 0; i < engine.slots_num; i++)
+		engine.slots[i].target = -1;
+
+	engine.start = zbx_time();
+	icmp_timer_cb(-1, 0, &engine);
+
+	if (0 == engine.finished && -1 == event_base_dispatch(engine.base))
+	{
+		zbx_strlcpy(error, "cannot process event base", max_error_len);
+		goto out;
+	}
+
+	for (i = 0; i < engine.targets_num; i++)
+	{
+		icmp_target_stats_calc(&engine.targets[i], requests_count);
+
+		if (0 != rdns)
+			icmp_target_dnsname_get(&engine.targets[i]);
+	}
+
+	ret = SUCCEED;
+out:
+	if (NULL != engine.timer)
+		event_free(engine.timer);
+
+	icmp_socket_close(&engine.sock4);
+	icmp_socket_close(&engine.sock6);
+
+	if (NULL != engine.base)
+		event_base_free(engine.base);
+
+	for (i = 0; i < engine.targets_num; i++)
+		zbx_free(engine.targets[i].rtt);
+
+	zbx_free(engine.targets);
+	zbx_free(engine.slots);
+	zbx_free(engine.packet);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s sent:%d", __func__, zbx_result_string(ret), engine.sent);
+
+	return ret;
+}
+
+#endif
@@ -22,6 +22,13 @@
 #	include <event2/util.h>
 #endif
 
+#include <sys/uio.h>
+
+#ifdef HAVE_SYS_EVENTFD_H
+#	include <sys/eventfd.h>
+#	define ZBX_IPC_SHM_RING
+#endif
+
 #include "zbxipcservice.h"
 #include "zbxalgo.h"
 #include "zbxstr.h"
@@ -31,6 +38,77 @@
 
 #define ZBX_IPC_DATA_DUMP_SIZE		128
 
+/* maximum number of io vectors written with a single writev() call */
+#define ZBX_IPC_IOV_MAX			64
+
+/* the default size of pooled receive buffer and the minimum space to read into */
+#define ZBX_IPC_RX_POOL_SIZE		(64 * ZBX_KIBIBYTE)
+#define ZBX_IPC_RX_POOL_MIN_READ	ZBX_IPC_SOCKET_BUFFER_SIZE
+
+/* Pooled receive buffer. Socket data is read directly into the buffer and   */
+/* the received messages reference their data inside it instead of copying.  */
+/* The buffer is freed when the client and all messages have released it.    */
+struct zbx_ipc_rx_pool
+{
+	unsigned char	*data;
+	zbx_uint32_t	size;
+
+	/* the number of bytes read into buffer */
+	zbx_uint32_t	bytes;
+
+	/* the offset of the first incomplete message */
+	zbx_uint32_t	offset;
+
+	zbx_uint32_t	refcount;
+};
+
+#ifdef ZBX_IPC_SHM_RING
+
+/* internal messages used to switch client socket to shared memory ring transport */
+#define ZBX_IPC_SHM_REQUEST		0xfffffff0
+#define ZBX_IPC_SHM_RESPONSE		0xfffffff1
+
+/* the response data - ring size (0 if shared memory transport was refused) and shared memory id */
+#define ZBX_IPC_SHM_RESPONSE_SIZE	(sizeof(zbx_uint32_t) * 2)
+
+#define ZBX_IPC_SHM_RING_LINE_SIZE	64
+
+/* Shared memory ring header. The positions are kept in separate cache lines */
+/* to avoid false sharing between producer (client) and consumer (service).  */
+typedef struct
+{
+	/* the total number of bytes written, updated by producer */
+	zbx_uint64_t	head;
+	unsigned char	head_pad[ZBX_IPC_SHM_RING_LINE_SIZE - sizeof(zbx_uint64_t)];
+
+	/* the total number of bytes read, updated by consumer */
+	zbx_uint64_t	tail;
+	unsigned char	tail_pad[ZBX_IPC_SHM_RING_LINE_SIZE - sizeof(zbx_uint64_t)];
+
+	/* set before waiting for data/space eventfd, reset by the other side when signalling it */
+	zbx_uint32_t	consumer_waiting;
+	zbx_uint32_t	producer_waiting;
+	unsigned char	waiting_pad[ZBX_IPC_SHM_RING_LINE_SIZE - sizeof(zbx_uint32_t) * 2];
+}
+zbx_ipc_shm_ring_header_t;
+
+/* Single producer/single consumer byte ring in shared memory carrying the same */
+/* message stream as socket. The producer signals data_fd after writing and the */
+/* consumer signals space_fd after reading if the other side is waiting.        */
+struct zbx_ipc_shm_ring
+{
+	zbx_ipc_shm_ring_header_t	*header;
+	unsigned char			*data;
+
+	/* the ring data size, power of two */
+	zbx_uint32_t			size;
+
+	int				data_fd;
+	int				space_fd;
+};
+
+#endif
+
 static char	ipc_path[ZBX_IPC_PATH_MAX] = {0};
 static size_t	ipc_path_root_len = 0;
 
@@ -52,6 +130,9 @@ struct zbx_ipc_client
 	zbx_uint32_t		rx_bytes;
 	zbx_queue_ptr_t		rx_queue;
 	struct event		*rx_event;
+	zbx_ipc_rx_pool_t	*rx_pool;
+	zbx_ipc_shm_ring_t	*rx_ring;
+	struct event		*rx_ring_event;
 
 	zbx_uint32_t		tx_header[2];
 	unsigned char		*tx_data;
@@ -103,6 +184,11 @@ static void	event_free(struct event *event)
 
 static void	ipc_client_read_event_cb(evutil_socket_t fd, short what, void *arg);
 static void	ipc_client_write_event_cb(evutil_socket_t fd, short what, void *arg);
+static void	ipc_client_set_tx_message(zbx_ipc_client_t *client, zbx_uint32_t code, const unsigned char *data,
+		zbx_uint32_t size, zbx_uint32_t tx_size);
+#ifdef ZBX_IPC_SHM_RING
+static void	ipc_client_ring_event_cb(evutil_socket_t fd, short what, void *arg);
+#endif
 
 static const char	*ipc_get_path(void)
 {
@@ -164,12 +250,13 @@ static const char	*ipc_make_path(const char *service_name, char **error)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: writes data to a socket                                           *
+ * Purpose: writes data vectors to a socket                                   *
  *                                                                            *
  * Parameters: fd        - [IN] the socket file descriptor                    *
- *             data      - [IN] the data                                      *
- *             size      - [IN] the data size                                 *
- *             size_sent - [IN] the actual size written to socket             *
+ *             iov       - [IN/OUT] the data vectors, modified to skip the    *
+ *                                  written data                              *
+ *             iov_num   - [IN] the number of data vectors                    *
+ *             size_sent - [OUT] the actual size written to socket            *
  *                                                                            *
  * Return value: SUCCEED - no socket errors were detected. Either the data or *
  *                         a part of it was written to socket or a write to   *
@@ -177,17 +264,16 @@ static const char	*ipc_make_path(const char *service_name, char **error)
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	ipc_write_data(int fd, const unsigned char *data, zbx_uint32_t size, zbx_uint32_t *size_sent)
+static int	ipc_writev_data(int fd, struct iovec *iov, int iov_num, size_t *size_sent)
 {
-	zbx_uint32_t	offset = 0;
-	int		ret = SUCCEED;
-	ssize_t		n;
+	int	ret = SUCCEED;
+	ssize_t	n;
 
-	while (offset != size)
-	{
-		n = write(fd, data + offset, size - offset);
+	*size_sent = 0;
 
-		if (-1 == n)
+	while (0 < iov_num)
+	{
+		if (-1 == (n = writev(fd, iov, iov_num)))
 		{
 			if (EINTR == errno)
 				continue;
@@ -200,10 +286,21 @@ static int	ipc_write_data(int fd, const unsigned char *data, zbx_uint32_t size,
 			break;
 		}
 
-		offset += n;
-	}
+		*size_sent += (size_t)n;
+
+		while (0 < iov_num && (size_t)n >= iov->iov_len)
+		{
+			n -= (ssize_t)iov->iov_len;
+			iov++;
+			iov_num--;
+		}
 
-	*size_sent = offset;
+		if (0 != n)
+		{
+			iov->iov_base = (char *)iov->iov_base + n;
+			iov->iov_len -= (size_t)n;
+		}
+	}
 
 	return ret;
 }
@@ -315,28 +412,21 @@ static int	ipc_socket_write_message(zbx_ipc_socket_t *csocket, zbx_uint32_t code
 		zbx_uint32_t size, zbx_uint32_t *tx_size)
 {
 	int		ret;
-	zbx_uint32_t	size_data, buffer[ZBX_IPC_SOCKET_BUFFER_SIZE / sizeof(zbx_uint32_t)];
-
-	buffer[0] = code;
-	buffer[1] = size;
-
-	if (ZBX_IPC_SOCKET_BUFFER_SIZE - ZBX_IPC_HEADER_SIZE >= size)
-	{
-		if (0 != size)
-			memcpy(buffer + 2, data, size);
-
-		return ipc_write_data(csocket->fd, (unsigned char *)buffer, size + ZBX_IPC_HEADER_SIZE, tx_size);
-	}
+	zbx_uint32_t	header[2];
+	struct iovec	iov[2];
+	size_t		size_sent;
 
-	if (FAIL == ipc_write_data(csocket->fd, (unsigned char *)buffer, ZBX_IPC_HEADER_SIZE, tx_size))
-		return FAIL;
+	header[ZBX_IPC_MESSAGE_CODE] = code;
+	header[ZBX_IPC_MESSAGE_SIZE] = size;
 
-	/* in the case of non-blocking sockets only a part of the header might be sent */
-	if (ZBX_IPC_HEADER_SIZE != *tx_size)
-		return SUCCEED;
+	/* write header and data with a single call, without copying data into intermediate buffer */
+	iov[0].iov_base = header;
+	iov[0].iov_len = ZBX_IPC_HEADER_SIZE;
+	iov[1].iov_base = (void *)data;
+	iov[1].iov_len = size;
 
-	ret = ipc_write_data(csocket->fd, data, size, &size_data);
-	*tx_size += size_data;
+	ret = ipc_writev_data(csocket->fd, iov, 0 != size ? 2 : 1, &size_sent);
+	*tx_size = (zbx_uint32_t)size_sent;
 
 	return ret;
 }
@@ -487,14 +577,562 @@ static int	ipc_socket_read_message(zbx_ipc_socket_t *csocket, zbx_uint32_t *head
 
 		csocket->rx_buffer_bytes = read_size;
 
-		ret = ipc_read_buffer(header, data, *rx_bytes, csocket->rx_buffer, csocket->rx_buffer_bytes,
-				&read_size);
+		ret = ipc_read_buffer(header, data, *rx_bytes, csocket->rx_buffer, csocket->rx_buffer_bytes,
+				&read_size);
+
+		csocket->rx_buffer_offset += read_size;
+		*rx_bytes += read_size;
+	}
+out:
+	return ret;
+}
+
+#ifdef ZBX_IPC_SHM_RING
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates shared memory ring handle                                 *
+ *                                                                            *
+ * Parameters: addr     - [IN] the attached shared memory segment             *
+ *             size     - [IN] the ring data size                             *
+ *             data_fd  - [IN] the eventfd signalled after writing data       *
+ *             space_fd - [IN] the eventfd signalled after reading data       *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_ipc_shm_ring_t	*ipc_shm_ring_new(void *addr, zbx_uint32_t size, int data_fd, int space_fd)
+{
+	zbx_ipc_shm_ring_t	*ring;
+
+	ring = (zbx_ipc_shm_ring_t *)zbx_malloc(NULL, sizeof(zbx_ipc_shm_ring_t));
+	ring->header = (zbx_ipc_shm_ring_header_t *)addr;
+	ring->data = (unsigned char *)addr + sizeof(zbx_ipc_shm_ring_header_t);
+	ring->size = size;
+	ring->data_fd = data_fd;
+	ring->space_fd = space_fd;
+
+	return ring;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: detaches shared memory ring and frees its handle                  *
+ *                                                                            *
+ * Parameters: ring - [IN] the shared memory ring                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_shm_ring_free(zbx_ipc_shm_ring_t *ring)
+{
+	if (-1 == shmdt(ring->header))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot detach IPC shared memory ring: %s", zbx_strerror(errno));
+
+	close(ring->data_fd);
+	close(ring->space_fd);
+	zbx_free(ring);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates shared memory ring on service side                        *
+ *                                                                            *
+ * Parameters: size  - [IN] the ring data size, power of two                  *
+ *             shmid - [OUT] the shared memory identifier                     *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: The created ring or NULL on error.                           *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_ipc_shm_ring_t	*ipc_shm_ring_create(zbx_uint32_t size, int *shmid, char **error)
+{
+	void				*addr;
+	int				data_fd = -1, space_fd = -1;
+	zbx_ipc_shm_ring_header_t	*header;
+
+	if (-1 == (*shmid = shmget(IPC_PRIVATE, sizeof(zbx_ipc_shm_ring_header_t) + size,
+			IPC_CREAT | IPC_EXCL | 0600)))
+	{
+		*error = zbx_dsprintf(*error, "cannot allocate shared memory: %s", zbx_strerror(errno));
+		return NULL;
+	}
+
+	addr = shmat(*shmid, NULL, 0);
+
+	/* Mark the segment for destruction right away so it is not leaked if any of the processes */
+	/* crashes. It is destroyed after the last detach, Linux still allows client to attach it. */
+	(void)shmctl(*shmid, IPC_RMID, NULL);
+
+	if ((void *)-1 == addr)
+	{
+		*error = zbx_dsprintf(*error, "cannot attach shared memory: %s", zbx_strerror(errno));
+		return NULL;
+	}
+
+	if (-1 == (data_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) ||
+			-1 == (space_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)))
+	{
+		*error = zbx_dsprintf(*error, "cannot create eventfd: %s", zbx_strerror(errno));
+
+		if (-1 != data_fd)
+			close(data_fd);
+
+		(void)shmdt(addr);
+		return NULL;
+	}
+
+	header = (zbx_ipc_shm_ring_header_t *)addr;
+	memset(header, 0, sizeof(zbx_ipc_shm_ring_header_t));
+
+	/* service waits for data until the client writes the first message */
+	header->consumer_waiting = 1;
+
+	return ipc_shm_ring_new(addr, size, data_fd, space_fd);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: signals eventfd                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_shm_ring_signal(int fd)
+{
+	while (-1 == eventfd_write(fd, 1) && EINTR == errno)
+		;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: makes written data visible to consumer and wakes it up if needed  *
+ *                                                                            *
+ * Parameters: ring - [IN] the shared memory ring                             *
+ *             head - [IN] the new producer position                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_shm_ring_publish(zbx_ipc_shm_ring_t *ring, zbx_uint64_t head)
+{
+	__atomic_store_n(&ring->header->head, head, __ATOMIC_SEQ_CST);
+
+	if (0 != __atomic_exchange_n(&ring->header->consumer_waiting, 0, __ATOMIC_SEQ_CST))
+		ipc_shm_ring_signal(ring->data_fd);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: waits until consumer frees space in full shared memory ring       *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket                                  *
+ *             head    - [IN] the producer position                           *
+ *                                                                            *
+ * Return value: SUCCEED - there is free space in ring                        *
+ *               FAIL    - the service has closed connection or an error      *
+ *                         occurred                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_ring_wait_space(zbx_ipc_socket_t *csocket, zbx_uint64_t head)
+{
+	zbx_ipc_shm_ring_t	*ring = csocket->tx_ring;
+	struct pollfd		pds[2];
+	eventfd_t		value;
+
+	pds[0].fd = ring->space_fd;
+	pds[0].events = POLLIN;
+
+	/* only hangup and errors are reported for socket */
+	pds[1].fd = csocket->fd;
+	pds[1].events = 0;
+
+	__atomic_store_n(&ring->header->producer_waiting, 1, __ATOMIC_SEQ_CST);
+
+	while (ring->size == head - __atomic_load_n(&ring->header->tail, __ATOMIC_SEQ_CST))
+	{
+		if (-1 == poll(pds, 2, -1))
+		{
+			if (EINTR == errno)
+				continue;
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait for IPC shared memory ring: %s",
+					zbx_strerror(errno));
+			return FAIL;
+		}
+
+		if (0 != (pds[1].revents & (POLLHUP | POLLERR | POLLNVAL)))
+			return FAIL;
+
+		if (0 != (pds[0].revents & POLLIN))
+			(void)eventfd_read(ring->space_fd, &value);
+	}
+
+	__atomic_store_n(&ring->header->producer_waiting, 0, __ATOMIC_SEQ_CST);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: writes IPC message to shared memory ring                          *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket with attached ring               *
+ *             code    - [IN] the message code                                *
+ *             data    - [IN] the data                                        *
+ *             size    - [IN] the data size                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the message was written                            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The message is written in the same format as to socket, so       *
+ *           messages larger than ring are streamed through it while the      *
+ *           service reads them. Blocks while the ring is full.               *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_ring_write_message(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const unsigned char *data,
+		zbx_uint32_t size)
+{
+	zbx_ipc_shm_ring_t	*ring = csocket->tx_ring;
+	zbx_uint32_t		header[2];
+	const unsigned char	*src[2];
+	zbx_uint32_t		left[2];
+	zbx_uint64_t		head = ring->header->head;
+
+	header[ZBX_IPC_MESSAGE_CODE] = code;
+	header[ZBX_IPC_MESSAGE_SIZE] = size;
+
+	src[0] = (const unsigned char *)header;
+	left[0] = ZBX_IPC_HEADER_SIZE;
+	src[1] = data;
+	left[1] = size;
+
+	for (int i = 0; i < 2; i++)
+	{
+		while (0 != left[i])
+		{
+			zbx_uint32_t	used, offset, copy_size;
+
+			used = (zbx_uint32_t)(head - __atomic_load_n(&ring->header->tail, __ATOMIC_ACQUIRE));
+
+			if (ring->size == used)
+			{
+				ipc_shm_ring_publish(ring, head);
+
+				if (SUCCEED != ipc_shm_ring_wait_space(csocket, head))
+					return FAIL;
+
+				continue;
+			}
+
+			offset = (zbx_uint32_t)(head & (ring->size - 1));
+			copy_size = MIN(left[i], ring->size - used);
+			copy_size = MIN(copy_size, ring->size - offset);
+
+			memcpy(ring->data + offset, src[i], copy_size);
+			src[i] += copy_size;
+			left[i] -= copy_size;
+			head += copy_size;
+		}
+	}
+
+	ipc_shm_ring_publish(ring, head);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sends shared memory ring response with eventfd descriptors        *
+ *                                                                            *
+ * Parameters: fd        - [IN] the client socket                             *
+ *             response  - [IN] the response message (header and data)        *
+ *             ring      - [IN] the shared memory ring                        *
+ *             size_sent - [OUT] the number of bytes sent                     *
+ *                                                                            *
+ * Return value: SUCCEED - no socket errors were detected                     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_ring_send_response(int fd, zbx_uint32_t *response, const zbx_ipc_shm_ring_t *ring,
+		zbx_uint32_t *size_sent)
+{
+	struct msghdr	msg;
+	struct iovec	iov;
+	struct cmsghdr	*cmsg;
+	ssize_t		n;
+	int		fds[2];
+	union
+	{
+		struct cmsghdr	header;
+		char		buf[CMSG_SPACE(sizeof(fds))];
+	}
+	control;
+
+	fds[0] = ring->data_fd;
+	fds[1] = ring->space_fd;
+
+	iov.iov_base = response;
+	iov.iov_len = ZBX_IPC_HEADER_SIZE + ZBX_IPC_SHM_RESPONSE_SIZE;
+
+	memset(&msg, 0, sizeof(msg));
+	memset(&control, 0, sizeof(control));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	*size_sent = 0;
+
+	while (-1 == (n = sendmsg(fd, &msg, 0)))
+	{
+		if (EINTR == errno)
+			continue;
+
+		if (EWOULDBLOCK == errno || EAGAIN == errno)
+			return SUCCEED;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot send IPC shared memory ring response: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	*size_sent = (zbx_uint32_t)n;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: handles client request to use shared memory ring transport        *
+ *                                                                            *
+ * Parameters: client - [IN] the IPC service client                           *
+ *                                                                            *
+ * Comments: If the service has shared memory transport enabled a ring is     *
+ *           created and passed to client together with eventfd descriptors.  *
+ *           Otherwise the request is refused and client keeps using socket.  *
+ *           The socket is still read, so messages sent through it (refused   *
+ *           request or client failing to attach the ring) are processed.     *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_client_attach_shm(zbx_ipc_client_t *client)
+{
+	zbx_ipc_service_t	*service = client->service;
+	zbx_ipc_shm_ring_t	*ring = NULL;
+	zbx_uint32_t		response[4], size_sent;
+	int			shmid = -1;
+	char			*error = NULL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() clientid:" ZBX_FS_UI64, __func__, client->id);
+
+	response[ZBX_IPC_MESSAGE_CODE] = ZBX_IPC_SHM_RESPONSE;
+	response[ZBX_IPC_MESSAGE_SIZE] = ZBX_IPC_SHM_RESPONSE_SIZE;
+	response[2] = 0;
+	response[3] = 0;
+
+	if (0 != service->shm_ring_size && NULL == client->rx_ring && 0 == client->tx_bytes &&
+			NULL == (ring = ipc_shm_ring_create(service->shm_ring_size, &shmid, &error)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot create IPC shared memory ring: %s", error);
+		zbx_free(error);
+	}
+
+	if (NULL != ring)
+	{
+		response[2] = ring->size;
+		response[3] = (zbx_uint32_t)shmid;
+
+		if (SUCCEED != ipc_shm_ring_send_response(client->csocket.fd, response, ring, &size_sent) ||
+				0 == size_sent)
+		{
+			ipc_shm_ring_free(ring);
+			ring = NULL;
+			response[2] = 0;
+			response[3] = 0;
+		}
+		else if (ZBX_IPC_HEADER_SIZE + ZBX_IPC_SHM_RESPONSE_SIZE != size_sent)
+		{
+			ipc_client_set_tx_message(client, ZBX_IPC_SHM_RESPONSE, (unsigned char *)(response + 2),
+					ZBX_IPC_SHM_RESPONSE_SIZE, size_sent);
+		}
+	}
+
+	if (NULL == ring)
+	{
+		(void)zbx_ipc_client_send(client, ZBX_IPC_SHM_RESPONSE, (unsigned char *)(response + 2),
+				ZBX_IPC_SHM_RESPONSE_SIZE);
+		goto out;
+	}
+
+	client->rx_ring = ring;
+	client->rx_ring_event = event_new(service->ev, ring->data_fd, EV_READ | EV_PERSIST, ipc_client_ring_event_cb,
+			(void *)client);
+	event_add(client->rx_ring_event, NULL);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() ring:%u", __func__, NULL != ring ? ring->size : 0);
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: adds received message to client's received messages queue         *
+ *                                                                            *
+ * Parameters: client  - [IN] the client                                      *
+ *             message - [IN] the received message                            *
+ *                                                                            *
+ * Comments: Internal messages are processed here and not queued.             *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_client_queue_rx_message(zbx_ipc_client_t *client, zbx_ipc_message_t *message)
+{
+#ifdef ZBX_IPC_SHM_RING
+	if (ZBX_IPC_SHM_REQUEST == message->code && NULL != client->service)
+	{
+		zbx_ipc_message_free(message);
+		ipc_client_attach_shm(client);
+		return;
+	}
+#endif
+	zbx_queue_ptr_push(&client->rx_queue, message);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates pooled receive buffer                                     *
+ *                                                                            *
+ * Parameters: size - [IN] the buffer size                                    *
+ *                                                                            *
+ * Return value: The created buffer with a single reference.                  *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_ipc_rx_pool_t	*ipc_rx_pool_create(zbx_uint32_t size)
+{
+	zbx_ipc_rx_pool_t	*pool;
+
+	pool = (zbx_ipc_rx_pool_t *)zbx_malloc(NULL, sizeof(zbx_ipc_rx_pool_t) + size);
+	pool->data = (unsigned char *)(pool + 1);
+	pool->size = size;
+	pool->bytes = 0;
+	pool->offset = 0;
+	pool->refcount = 1;
+
+	return pool;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: releases pooled receive buffer reference                          *
+ *                                                                            *
+ * Parameters: pool - [IN] the pooled receive buffer                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_rx_pool_release(zbx_ipc_rx_pool_t *pool)
+{
+	if (0 == --pool->refcount)
+		zbx_free(pool);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses complete messages in client's pooled receive buffer        *
+ *                                                                            *
+ * Parameters: client - [IN] the client                                       *
+ *                                                                            *
+ * Comments: The parsed messages are added to received messages queue and     *
+ *           reference their data inside the pooled buffer. If the buffer has *
+ *           not enough space left for the next message, the incomplete       *
+ *           message is moved to a new buffer.                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_client_parse_rx_pool(zbx_ipc_client_t *client)
+{
+	zbx_ipc_rx_pool_t	*pool = client->rx_pool;
+	zbx_uint32_t		header[2], pending;
+	zbx_uint64_t		required = ZBX_IPC_RX_POOL_MIN_READ;
+
+	while (ZBX_IPC_HEADER_SIZE <= (pending = pool->bytes - pool->offset))
+	{
+		zbx_ipc_message_t	*message;
+
+		memcpy(header, pool->data + pool->offset, ZBX_IPC_HEADER_SIZE);
+
+		if ((zbx_uint64_t)header[ZBX_IPC_MESSAGE_SIZE] + ZBX_IPC_HEADER_SIZE > pending)
+		{
+			required = MAX(required, (zbx_uint64_t)header[ZBX_IPC_MESSAGE_SIZE] + ZBX_IPC_HEADER_SIZE);
+			break;
+		}
+
+		message = (zbx_ipc_message_t *)zbx_malloc(NULL, sizeof(zbx_ipc_message_t));
+		message->code = header[ZBX_IPC_MESSAGE_CODE];
+		message->size = header[ZBX_IPC_MESSAGE_SIZE];
+
+		if (0 != message->size)
+		{
+			message->data = pool->data + pool->offset + ZBX_IPC_HEADER_SIZE;
+			message->pool = pool;
+			pool->refcount++;
+		}
+		else
+		{
+			message->data = NULL;
+			message->pool = NULL;
+		}
+
+		pool->offset += ZBX_IPC_HEADER_SIZE + message->size;
+		ipc_client_queue_rx_message(client, message);
+	}
+
+	if (0 == pending && 1 == pool->refcount && ZBX_IPC_RX_POOL_SIZE == pool->size)
+	{
+		/* all messages have been released - the buffer can be reused */
+		pool->bytes = 0;
+		pool->offset = 0;
+		return;
+	}
+
+	if (pool->size - pool->offset >= required)
+		return;
+
+	client->rx_pool = ipc_rx_pool_create((zbx_uint32_t)MAX(ZBX_IPC_RX_POOL_SIZE, required));
+
+	if (0 != pending)
+		memcpy(client->rx_pool->data, pool->data + pool->offset, pending);
+
+	client->rx_pool->bytes = pending;
+
+	ipc_rx_pool_release(pool);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads data from IPC service client into pooled receive buffer     *
+ *                                                                            *
+ * Parameters: client - [IN] the client to read                               *
+ *                                                                            *
+ * Return value:  FAIL - read error/connection was closed                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_client_read_pooled(zbx_ipc_client_t *client)
+{
+	ssize_t	n;
+
+	while (1)
+	{
+		zbx_ipc_rx_pool_t	*pool = client->rx_pool;
+
+		if (-1 == (n = read(client->csocket.fd, pool->data + pool->bytes, pool->size - pool->bytes)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			if (EWOULDBLOCK == errno || EAGAIN == errno)
+				return SUCCEED;
+
+			return FAIL;
+		}
+
+		if (0 == n)
+			return FAIL;
 
-		csocket->rx_buffer_offset += read_size;
-		*rx_bytes += read_size;
+		pool->bytes += (zbx_uint32_t)n;
+		ipc_client_parse_rx_pool(client);
 	}
-out:
-	return ret;
 }
 
 /******************************************************************************
@@ -517,6 +1155,12 @@ static void	ipc_client_free_events(zbx_ipc_client_t *client)
 		event_free(client->tx_event);
 		client->tx_event = NULL;
 	}
+
+	if (NULL != client->rx_ring_event)
+	{
+		event_free(client->rx_ring_event);
+		client->rx_ring_event = NULL;
+	}
 }
 
 /******************************************************************************
@@ -539,6 +1183,14 @@ static void	ipc_client_free(zbx_ipc_client_t *client)
 	zbx_queue_ptr_destroy(&client->rx_queue);
 	zbx_free(client->rx_data);
 
+	if (NULL != client->rx_pool)
+		ipc_rx_pool_release(client->rx_pool);
+
+#ifdef ZBX_IPC_SHM_RING
+	if (NULL != client->rx_ring)
+		ipc_shm_ring_free(client->rx_ring);
+#endif
+
 	while (NULL != (message = (zbx_ipc_message_t *)zbx_queue_ptr_pop(&client->tx_queue)))
 		zbx_ipc_message_free(message);
 
@@ -565,11 +1217,114 @@ static void	ipc_client_push_rx_message(zbx_ipc_client_t *client)
 	message->code = client->rx_header[ZBX_IPC_MESSAGE_CODE];
 	message->size = client->rx_header[ZBX_IPC_MESSAGE_SIZE];
 	message->data = client->rx_data;
-	zbx_queue_ptr_push(&client->rx_queue, message);
+	message->pool = NULL;
 
 	client->rx_data = NULL;
 	client->rx_bytes = 0;
+
+	ipc_client_queue_rx_message(client, message);
+}
+
+#ifdef ZBX_IPC_SHM_RING
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses data read from shared memory ring                          *
+ *                                                                            *
+ * Parameters: client - [IN] the client                                       *
+ *             data   - [IN] the data                                         *
+ *             size   - [IN] the data size                                    *
+ *                                                                            *
+ * Return value: The number of bytes consumed.                                *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	ipc_client_parse_ring_data(zbx_ipc_client_t *client, const unsigned char *data,
+		zbx_uint32_t size)
+{
+	zbx_uint32_t	offset = 0, read_size;
+
+	if (NULL != client->rx_pool)
+	{
+		zbx_ipc_rx_pool_t	*pool = client->rx_pool;
+
+		read_size = MIN(size, pool->size - pool->bytes);
+		memcpy(pool->data + pool->bytes, data, read_size);
+		pool->bytes += read_size;
+		ipc_client_parse_rx_pool(client);
+
+		return read_size;
+	}
+
+	while (offset < size)
+	{
+		int	ret;
+
+		ret = ipc_read_buffer(client->rx_header, &client->rx_data, client->rx_bytes, data + offset,
+				size - offset, &read_size);
+
+		client->rx_bytes += read_size;
+		offset += read_size;
+
+		if (SUCCEED == ret)
+			ipc_client_push_rx_message(client);
+	}
+
+	return offset;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads messages from IPC service client shared memory ring         *
+ *                                                                            *
+ * Parameters: client - [IN] the client                                       *
+ *             limit  - [IN] the maximum number of bytes to read              *
+ *                                                                            *
+ * Comments: When the limit is reached the ring event is activated to resume  *
+ *           reading in the next event loop iteration, so that a busy client  *
+ *           does not starve the others.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_client_read_ring(zbx_ipc_client_t *client, zbx_uint64_t limit)
+{
+	zbx_ipc_shm_ring_t		*ring = client->rx_ring;
+	zbx_ipc_shm_ring_header_t	*header = ring->header;
+	zbx_uint64_t			tail = header->tail, head, read_total = 0;
+
+	while (1)
+	{
+		zbx_uint32_t	offset, size;
+
+		if (tail == (head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE)))
+		{
+			__atomic_store_n(&header->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+
+			if (tail == __atomic_load_n(&header->head, __ATOMIC_SEQ_CST))
+				break;
+
+			/* data was written meanwhile, the producer might also signal it - resulting in a spurious wakeup */
+			__atomic_store_n(&header->consumer_waiting, 0, __ATOMIC_SEQ_CST);
+			continue;
+		}
+
+		if (read_total >= limit)
+		{
+			event_active(client->rx_ring_event, EV_READ, 0);
+			break;
+		}
+
+		offset = (zbx_uint32_t)(tail & (ring->size - 1));
+		size = (zbx_uint32_t)MIN(head - tail, ring->size - offset);
+		size = ipc_client_parse_ring_data(client, ring->data + offset, size);
+
+		tail += size;
+		read_total += size;
+
+		__atomic_store_n(&header->tail, tail, __ATOMIC_SEQ_CST);
+
+		if (0 != __atomic_exchange_n(&header->producer_waiting, 0, __ATOMIC_SEQ_CST))
+			ipc_shm_ring_signal(ring->space_fd);
+	}
 }
+#endif
 
 /******************************************************************************
  *                                                                            *
@@ -611,6 +1366,9 @@ static int	ipc_client_read(zbx_ipc_client_t *client)
 {
 	int	rc;
 
+	if (NULL != client->rx_pool)
+		return ipc_client_read_pooled(client);
+
 	do
 	{
 		if (FAIL == ipc_socket_read_message(&client->csocket, client->rx_header, &client->rx_data,
@@ -630,6 +1388,24 @@ static int	ipc_client_read(zbx_ipc_client_t *client)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: gets queued message without removing it from queue                *
+ *                                                                            *
+ * Parameters: queue - [IN] the message queue                                 *
+ *             index - [IN] the message index, counting from the queue tail   *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_ipc_message_t	*ipc_queue_peek_message(const zbx_queue_ptr_t *queue, int index)
+{
+	int	pos = queue->tail_pos + index;
+
+	if (pos >= queue->alloc_num)
+		pos -= queue->alloc_num;
+
+	return (zbx_ipc_message_t *)queue->values[pos];
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: writes queued data to IPC service client                          *
@@ -639,48 +1415,75 @@ static int	ipc_client_read(zbx_ipc_client_t *client)
  * Return value: SUCCEED - the data was sent successfully                     *
  *               FAIL    - otherwise                                          *
  *                                                                            *
+ * Comments: The rest of the current message and the following queued         *
+ *           messages are coalesced into a single writev() call.              *
+ *                                                                            *
  ******************************************************************************/
 static int	ipc_client_write(zbx_ipc_client_t *client)
 {
-	zbx_uint32_t	data_size, write_size;
-
-	data_size = client->tx_header[ZBX_IPC_MESSAGE_SIZE];
+	struct iovec	iov[ZBX_IPC_IOV_MAX];
+	zbx_uint32_t	headers[ZBX_IPC_IOV_MAX][2];
 
-	if (data_size < client->tx_bytes)
+	while (0 < client->tx_bytes)
 	{
-		zbx_uint32_t	size, offset;
+		zbx_uint32_t	data_size, data_left;
+		size_t		write_size;
+		int		iov_num = 0, queued_num;
 
-		size = client->tx_bytes - data_size;
-		offset = ZBX_IPC_HEADER_SIZE - size;
+		data_size = client->tx_header[ZBX_IPC_MESSAGE_SIZE];
 
-		if (SUCCEED != ipc_write_data(client->csocket.fd, (unsigned char *)client->tx_header + offset, size,
-				&write_size))
+		if (data_size < client->tx_bytes)
 		{
-			return FAIL;
+			zbx_uint32_t	header_left = client->tx_bytes - data_size;
+
+			iov[iov_num].iov_base = (unsigned char *)client->tx_header + ZBX_IPC_HEADER_SIZE - header_left;
+			iov[iov_num++].iov_len = header_left;
 		}
 
-		client->tx_bytes -= write_size;
+		if (0 != (data_left = MIN(data_size, client->tx_bytes)))
+		{
+			iov[iov_num].iov_base = client->tx_data + data_size - data_left;
+			iov[iov_num++].iov_len = data_left;
+		}
 
-		if (data_size < client->tx_bytes)
-			return SUCCEED;
-	}
+		queued_num = zbx_queue_ptr_values_num(&client->tx_queue);
 
-	while (0 < client->tx_bytes)
-	{
-		if (SUCCEED != ipc_write_data(client->csocket.fd, client->tx_data + data_size - client->tx_bytes,
-				client->tx_bytes, &write_size))
+		for (int i = 0; i < queued_num && iov_num + 2 <= ZBX_IPC_IOV_MAX; i++)
 		{
-			return FAIL;
+			zbx_ipc_message_t	*message = ipc_queue_peek_message(&client->tx_queue, i);
+
+			headers[i][ZBX_IPC_MESSAGE_CODE] = message->code;
+			headers[i][ZBX_IPC_MESSAGE_SIZE] = message->size;
+
+			iov[iov_num].iov_base = headers[i];
+			iov[iov_num++].iov_len = ZBX_IPC_HEADER_SIZE;
+
+			if (0 != message->size)
+			{
+				iov[iov_num].iov_base = message->data;
+				iov[iov_num++].iov_len = message->size;
+			}
 		}
 
+		if (SUCCEED != ipc_writev_data(client->csocket.fd, iov, iov_num, &write_size))
+			return FAIL;
+
 		if (0 == write_size)
 			return SUCCEED;
 
-		client->tx_bytes -= write_size;
-	}
+		/* skip the sent messages, the first partially sent message becomes the current one */
+		while (0 != write_size)
+		{
+			if (write_size < client->tx_bytes)
+			{
+				client->tx_bytes -= (zbx_uint32_t)write_size;
+				break;
+			}
 
-	if (0 == client->tx_bytes)
-		ipc_client_pop_tx_message(client);
+			write_size -= client->tx_bytes;
+			ipc_client_pop_tx_message(client);
+		}
+	}
 
 	return SUCCEED;
 }
@@ -763,6 +1566,10 @@ static void	ipc_service_add_client(zbx_ipc_service_t *service, int fd)
 	client->csocket.rx_buffer_bytes = 0;
 	client->csocket.rx_buffer_offset = 0;
 	client->id = next_clientid++;
+
+	if (0 != service->rx_pool)
+		client->rx_pool = ipc_rx_pool_create(ZBX_IPC_RX_POOL_SIZE);
+
 	client->state = ZBX_IPC_CLIENT_STATE_NONE;
 	client->refcount = 1;
 
@@ -835,6 +1642,11 @@ static void	ipc_client_read_event_cb(evutil_socket_t fd, short what, void *arg)
 
 	if (SUCCEED != ipc_client_read(client))
 	{
+#ifdef ZBX_IPC_SHM_RING
+		/* read messages written to ring before the connection was closed */
+		if (NULL != client->rx_ring)
+			ipc_client_read_ring(client, ZBX_MAX_UINT64);
+#endif
 		ipc_client_free_events(client);
 		ipc_service_remove_client(client->service, client);
 	}
@@ -842,6 +1654,26 @@ static void	ipc_client_read_event_cb(evutil_socket_t fd, short what, void *arg)
 	ipc_service_push_client(client->service, client);
 }
 
+#ifdef ZBX_IPC_SHM_RING
+/******************************************************************************
+ *                                                                            *
+ * Purpose: service client shared memory ring data event libevent callback    *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_client_ring_event_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_ipc_client_t	*client = (zbx_ipc_client_t *)arg;
+	eventfd_t		value;
+
+	ZBX_UNUSED(what);
+
+	(void)eventfd_read(fd, &value);
+
+	ipc_client_read_ring(client, client->rx_ring->size);
+	ipc_service_push_client(client->service, client);
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Purpose: service client write event libevent callback                      *
@@ -972,6 +1804,7 @@ static zbx_ipc_message_t	*ipc_message_create(zbx_uint32_t code, const unsigned c
 
 	message->code = code;
 	message->size = size;
+	message->pool = NULL;
 
 	if (0 != size)
 	{
@@ -1139,6 +1972,7 @@ int	zbx_ipc_socket_open(zbx_ipc_socket_t *csocket, const char *service_name, int
 
 	csocket->rx_buffer_bytes = 0;
 	csocket->rx_buffer_offset = 0;
+	csocket->tx_ring = NULL;
 
 	ret = SUCCEED;
 out:
@@ -1163,6 +1997,14 @@ void	zbx_ipc_socket_close(zbx_ipc_socket_t *csocket)
 		csocket->fd = -1;
 	}
 
+#ifdef ZBX_IPC_SHM_RING
+	if (NULL != csocket->tx_ring)
+	{
+		ipc_shm_ring_free(csocket->tx_ring);
+		csocket->tx_ring = NULL;
+	}
+#endif
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -1186,6 +2028,13 @@ int	zbx_ipc_socket_write(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const uns
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+#ifdef ZBX_IPC_SHM_RING
+	if (NULL != csocket->tx_ring)
+	{
+		ret = ipc_shm_ring_write_message(csocket, code, data, size);
+		goto out;
+	}
+#endif
 	if (SUCCEED == ipc_socket_write_message(csocket, code, data, size, &size_sent) &&
 			size_sent == size + ZBX_IPC_HEADER_SIZE)
 	{
@@ -1193,7 +2042,9 @@ int	zbx_ipc_socket_write(zbx_ipc_socket_t *csocket, zbx_uint32_t code, const uns
 	}
 	else
 		ret = FAIL;
-
+#ifdef ZBX_IPC_SHM_RING
+out:
+#endif
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1233,6 +2084,7 @@ int	zbx_ipc_socket_read(zbx_ipc_socket_t *csocket, zbx_ipc_message_t *message)
 	message->code = header[ZBX_IPC_MESSAGE_CODE];
 	message->size = header[ZBX_IPC_MESSAGE_SIZE];
 	message->data = data;
+	message->pool = NULL;
 
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE))
 	{
@@ -1267,18 +2119,151 @@ int	zbx_ipc_socket_connected(const zbx_ipc_socket_t *csocket)
 	return 0 < csocket->fd ? SUCCEED : FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: switches messages written to IPC service to shared memory ring    *
+ *                                                                            *
+ * Parameters: csocket - [IN] an opened IPC socket to the service             *
+ *                                                                            *
+ * Return value: SUCCEED - the messages written with zbx_ipc_socket_write()   *
+ *                         will be passed through shared memory ring          *
+ *               FAIL    - the service does not support shared memory         *
+ *                         transport or an error occurred, socket is used     *
+ *                                                                            *
+ * Comments: This function must be called right after opening socket, before  *
+ *           writing any other messages. The service responses are still      *
+ *           read from socket.                                                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_socket_enable_shm(zbx_ipc_socket_t *csocket)
+{
+#ifdef ZBX_IPC_SHM_RING
+	zbx_uint32_t	response[4], tx_size, offset = 0;
+	int		fds[2], fds_num = 0, ret = FAIL;
+	void		*addr;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != csocket->tx_ring)
+	{
+		ret = SUCCEED;
+		goto out;
+	}
+
+	if (SUCCEED != ipc_socket_write_message(csocket, ZBX_IPC_SHM_REQUEST, NULL, 0, &tx_size) ||
+			ZBX_IPC_HEADER_SIZE != tx_size)
+	{
+		goto out;
+	}
+
+	while (offset < sizeof(response))
+	{
+		struct msghdr	msg;
+		struct iovec	iov;
+		struct cmsghdr	*cmsg;
+		ssize_t		n;
+		union
+		{
+			struct cmsghdr	header;
+			char		buf[CMSG_SPACE(sizeof(fds))];
+		}
+		control;
+
+		iov.iov_base = (unsigned char *)response + offset;
+		iov.iov_len = sizeof(response) - offset;
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.buf;
+		msg.msg_controllen = sizeof(control.buf);
+
+		if (-1 == (n = recvmsg(csocket->fd, &msg, 0)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			goto out;
+		}
+
+		if (0 == n)
+			goto out;
+
+		for (cmsg = CMSG_FIRSTHDR(&msg); NULL != cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+		{
+			if (SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type && 0 == fds_num &&
+					CMSG_LEN(sizeof(fds)) == cmsg->cmsg_len)
+			{
+				memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+				fds_num = 2;
+			}
+		}
+
+		offset += (zbx_uint32_t)n;
+	}
+
+	if (ZBX_IPC_SHM_RESPONSE != response[ZBX_IPC_MESSAGE_CODE] ||
+			ZBX_IPC_SHM_RESPONSE_SIZE != response[ZBX_IPC_MESSAGE_SIZE])
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "unexpected response to IPC shared memory ring request");
+		goto out;
+	}
+
+	if (0 == response[2] || 2 != fds_num)
+		goto out;
+
+	if (0 != (response[2] & (response[2] - 1)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid IPC shared memory ring size %u", response[2]);
+		goto out;
+	}
+
+	if ((void *)-1 == (addr = shmat((int)response[3], NULL, 0)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot attach IPC shared memory ring: %s", zbx_strerror(errno));
+		goto out;
+	}
+
+	csocket->tx_ring = ipc_shm_ring_new(addr, response[2], fds[0], fds[1]);
+	fds_num = 0;
+
+	ret = SUCCEED;
+out:
+	if (0 != fds_num)
+	{
+		close(fds[0]);
+		close(fds[1]);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+#else
+	ZBX_UNUSED(csocket);
+
+	return FAIL;
+#endif
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: frees the resources allocated to store IPC message data           *
  *                                                                            *
  * Parameters: message - [IN] the message to free                             *
  *                                                                            *
+ * Comments: Messages received by services with pooled receive buffers must   *
+ *           be freed with this function, their data cannot be taken over.    *
+ *                                                                            *
  ******************************************************************************/
 void	zbx_ipc_message_free(zbx_ipc_message_t *message)
 {
 	if (NULL != message)
 	{
-		zbx_free(message->data);
+		if (NULL != message->pool)
+			ipc_rx_pool_release(message->pool);
+		else
+			zbx_free(message->data);
+
 		zbx_free(message);
 	}
 }
@@ -1355,6 +2340,7 @@ void	zbx_ipc_message_copy(zbx_ipc_message_t *dst, const zbx_ipc_message_t *src)
 {
 	dst->code = src->code;
 	dst->size = src->size;
+	dst->pool = NULL;
 	dst->data = (unsigned char *)zbx_malloc(NULL, src->size);
 	memcpy(dst->data, src->data, src->size);
 }
@@ -1518,6 +2504,8 @@ int	zbx_ipc_service_start(zbx_ipc_service_t *service, const char *service_name,
 	}
 
 	service->path = zbx_strdup(NULL, socket_path);
+	service->rx_pool = 0;
+	service->shm_ring_size = 0;
 	zbx_vector_ipc_client_ptr_create(&service->clients);
 	zbx_queue_ptr_create(&service->clients_recv);
 
@@ -1571,6 +2559,54 @@ void	zbx_ipc_service_close(zbx_ipc_service_t *service)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enables pooled receive buffers for the service clients            *
+ *                                                                            *
+ * Parameters: service - [IN] the IPC service                                 *
+ *                                                                            *
+ * Comments: Client data is read directly into large shared buffers and the   *
+ *           received messages reference their data inside those buffers      *
+ *           instead of allocating and copying it for each message. The       *
+ *           messages must be freed with zbx_ipc_message_free() by the        *
+ *           service thread and their data must not be taken over or kept     *
+ *           after the message is freed.                                      *
+ *           This function must be called after starting the service, before  *
+ *           the clients are connected.                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ipc_service_enable_rx_pool(zbx_ipc_service_t *service)
+{
+	service->rx_pool = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enables shared memory ring transport for the service clients      *
+ *                                                                            *
+ * Parameters: service   - [IN] the IPC service                               *
+ *             ring_size - [IN] the ring size per client, rounded up to power *
+ *                              of two                                        *
+ *                                                                            *
+ * Comments: Clients requesting it with zbx_ipc_socket_enable_shm() write     *
+ *           messages into a per client single producer/single consumer ring  *
+ *           in shared memory instead of socket and use eventfd wakeups, so   *
+ *           the message data does not cross kernel. The messages are         *
+ *           received with the same zbx_ipc_service_recv() function.          *
+ *           Shared memory transport is supported only on platforms with      *
+ *           eventfd, otherwise clients keep using socket.                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ipc_service_enable_shm(zbx_ipc_service_t *service, zbx_uint32_t ring_size)
+{
+	zbx_uint32_t	size = ZBX_IPC_SOCKET_BUFFER_SIZE;
+
+	while (size < ring_size && 0 != (size << 1))
+		size <<= 1;
+
+	service->shm_ring_size = size;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: receives ipc message from a connected client                      *
@@ -1661,6 +2697,34 @@ void	zbx_ipc_service_alert(zbx_ipc_service_t *service)
 	event_active(service->ev_alert, 0, 0);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: stores partially sent message to be sent when socket becomes      *
+ *          ready                                                             *
+ *                                                                            *
+ * Parameters: client  - [IN] the IPC client                                  *
+ *             code    - [IN] the message code                                *
+ *             data    - [IN] the data                                        *
+ *             size    - [IN] the data size                                   *
+ *             tx_size - [IN] the number of bytes already sent                *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_client_set_tx_message(zbx_ipc_client_t *client, zbx_uint32_t code, const unsigned char *data,
+		zbx_uint32_t size, zbx_uint32_t tx_size)
+{
+	client->tx_header[ZBX_IPC_MESSAGE_CODE] = code;
+	client->tx_header[ZBX_IPC_MESSAGE_SIZE] = size;
+
+	if (0 != size)
+	{
+		client->tx_data = (unsigned char *)zbx_malloc(NULL, size);
+		memcpy(client->tx_data, data, size);
+	}
+
+	client->tx_bytes = ZBX_IPC_HEADER_SIZE + size - tx_size;
+	event_add(client->tx_event, NULL);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: Sends IPC message to client                                       *
@@ -1695,14 +2759,7 @@ int	zbx_ipc_client_send(zbx_ipc_client_t *client, zbx_uint32_t code, const unsig
 		goto out;
 
 	if (tx_size != ZBX_IPC_HEADER_SIZE + size)
-	{
-		client->tx_header[ZBX_IPC_MESSAGE_CODE] = code;
-		client->tx_header[ZBX_IPC_MESSAGE_SIZE] = size;
-		client->tx_data = (unsigned char *)zbx_malloc(NULL, size);
-		memcpy(client->tx_data, data, size);
-		client->tx_bytes = ZBX_IPC_HEADER_SIZE + size - tx_size;
-		event_add(client->tx_event, NULL);
-	}
+		ipc_client_set_tx_message(client, code, data, size, tx_size);
 
 	ret = SUCCEED;
 out:
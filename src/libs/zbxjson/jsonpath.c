@@ -2868,30 +2868,30 @@ static void	jsonpath_ctx_clear(zbx_jsonpath_context_t *ctx)
 
 /******************************************************************************
  *                                                                            *
- * Purpose: perform jsonpath query on the specified json object               *
+ * Purpose: perform compiled jsonpath query on the specified json object      *
  *                                                                            *
- * Parameters: obj    - [IN] json object                                      *
- *             index  - [IN] jsonpath index (optional)                        *
- *             path   - [IN] jsonpath                                         *
- *             output - [OUT] output value                                    *
+ * Parameters: obj      - [IN] json object                                    *
+ *             index    - [IN] jsonpath index (optional)                      *
+ *             jsonpath - [IN] compiled jsonpath                              *
+ *             output   - [OUT] output value                                  *
  *                                                                            *
  * Return value: SUCCEED - the query was performed successfully (empty result *
  *                         being counted as successful query)                 *
  *               FAIL    - otherwise                                          *
  *                                                                            *
+ * Comments: The compiled jsonpath is not modified during query, so it can be *
+ *           shared between threads.                                          *
+ *                                                                            *
  ******************************************************************************/
-int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const char *path, char **output)
+int	zbx_jsonobj_query_path(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const zbx_jsonpath_t *jsonpath,
+		char **output)
 {
 	zbx_jsonpath_context_t	ctx;
-	zbx_jsonpath_t		jsonpath;
 	int			ret = SUCCEED;
 
-	if (FAIL == zbx_jsonpath_compile(path, &jsonpath))
-		return FAIL;
-
 	ctx.found = 0;
 	ctx.root = obj;
-	ctx.path = &jsonpath;
+	ctx.path = jsonpath;
 	zbx_vector_jsonobj_ref_create(&ctx.objects);
 	ctx.index = index;
 
@@ -2910,15 +2910,15 @@ int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const
 	if (SUCCEED == ret)
 	{
 		zbx_vector_jsonobj_ref_t	out;
-		int				definite_path = jsonpath.definite, path_depth;
+		int				definite_path = jsonpath->definite, path_depth;
 
 		zbx_vector_jsonobj_ref_create(&out);
 
-		path_depth = jsonpath.segments_num;
-		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath.segments[path_depth - 1].type)
+		path_depth = jsonpath->segments_num;
+		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath->segments[path_depth - 1].type)
 			path_depth--;
 
-		if (path_depth < jsonpath.segments_num)
+		if (path_depth < jsonpath->segments_num)
 		{
 			if (SUCCEED == (ret = jsonpath_apply_functions(&ctx, path_depth, &definite_path, &out)))
 				ret = jsonpath_format_query_result(&out, definite_path, output);
@@ -2931,6 +2931,34 @@ int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const
 	}
 
 	jsonpath_ctx_clear(&ctx);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: perform jsonpath query on the specified json object               *
+ *                                                                            *
+ * Parameters: obj    - [IN] json object                                      *
+ *             index  - [IN] jsonpath index (optional)                        *
+ *             path   - [IN] jsonpath                                         *
+ *             output - [OUT] output value                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the query was performed successfully (empty result *
+ *                         being counted as successful query)                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonobj_query_ext(zbx_jsonobj_t *obj, zbx_jsonpath_index_t *index, const char *path, char **output)
+{
+	zbx_jsonpath_t	jsonpath;
+	int		ret;
+
+	if (FAIL == zbx_jsonpath_compile(path, &jsonpath))
+		return FAIL;
+
+	ret = zbx_jsonobj_query_path(obj, index, &jsonpath, output);
+
 	zbx_jsonpath_clear(&jsonpath);
 
 	return ret;
@@ -49,6 +49,82 @@ static const char	*get_agent_step_string(zbx_zabbix_agent_step_t step)
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses JSON response to the request of all context items          *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_handle_json_response(zbx_agent_context *agent_context)
+{
+	AGENT_RESULT	**results;
+	int		*errcodes, ret, num = agent_context->batch_items_num + 1;
+	unsigned char	*deferred;
+
+	results = (AGENT_RESULT **)zbx_malloc(NULL, sizeof(AGENT_RESULT *) * (size_t)num);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+	deferred = (unsigned char *)zbx_malloc(NULL, sizeof(unsigned char) * (size_t)num);
+
+	results[0] = &agent_context->item.result;
+
+	for (int i = 1; i < num; i++)
+		results[i] = &agent_context->batch_items[i - 1].result;
+
+	if (SUCCEED == (ret = zbx_agent_handle_batch_response(agent_context->s.buffer,
+			agent_context->s.read_bytes + agent_context->tcp_recv_context.offset,
+			agent_context->item.interface.addr, results, errcodes, deferred, num,
+			&agent_context->item.version, &agent_context->capabilities)))
+	{
+		ret = errcodes[0];
+	}
+
+	for (int i = 1; i < num; i++)
+	{
+		if (FAIL != ret)
+		{
+			agent_context->batch_items[i - 1].ret = errcodes[i];
+			agent_context->batch_deferred[i - 1] = deferred[i];
+		}
+
+		agent_context->batch_items[i - 1].version = agent_context->item.version;
+	}
+
+	zbx_free(deferred);
+	zbx_free(errcodes);
+	zbx_free(results);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets result of batch items that were not processed by agent       *
+ *                                                                            *
+ * Comments: Batch items without response share the error of the request.     *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_batch_items_finish(zbx_agent_context *agent_context)
+{
+	for (int i = 0; i < agent_context->batch_items_num; i++)
+	{
+		zbx_dc_item_context_t	*item = &agent_context->batch_items[i];
+
+		if (SUCCEED == item->ret || 0 != ZBX_ISSET_MSG(&item->result))
+			continue;
+
+		if (SUCCEED != agent_context->item.ret && 0 != ZBX_ISSET_MSG(&agent_context->item.result))
+		{
+			item->ret = agent_context->item.ret;
+			SET_MSG_RESULT(&item->result, zbx_strdup(NULL, agent_context->item.result.msg));
+		}
+		else
+		{
+			item->ret = NETWORK_ERROR;
+			SET_MSG_RESULT(&item->result, zbx_strdup(NULL, "Get value from agent failed: batch request was"
+					" not processed"));
+		}
+	}
+}
+
 static int	agent_task_process(short event, void *data, int *fd, const char *addr, char *dnserr,
 		struct event *timeout_event)
 {
@@ -88,7 +164,7 @@ static int	agent_task_process(short event, void *data, int *fd, const char *addr
 		{
 			SET_MSG_RESULT(&agent_context->item.result, zbx_dsprintf(NULL, "Get value from agent"
 					" failed: Cannot resolve address: %s", dnserr));
-			return ZBX_ASYNC_TASK_STOP;
+			goto finish;
 		}
 
 		switch (agent_context->step)
@@ -98,7 +174,7 @@ static int	agent_task_process(short event, void *data, int *fd, const char *addr
 						" failed: cannot initialize TCP connection to [[%s]:%hu]:"
 						" timed out", agent_context->item.interface.addr,
 						agent_context->item.interface.port));
-				return ZBX_ASYNC_TASK_STOP;
+				goto finish;
 			case ZABBIX_AGENT_STEP_CONNECT_WAIT:
 				SET_MSG_RESULT(&agent_context->item.result, zbx_dsprintf(NULL, "Get value from agent"
 						" failed: cannot establish TCP connection to [[%s]:%hu]:"
@@ -265,11 +341,20 @@ static int	agent_task_process(short event, void *data, int *fd, const char *addr
 				}
 			}
 
-			if (FAIL == (agent_context->item.ret = zbx_agent_handle_response(
-					agent_context->s.buffer, agent_context->s.read_bytes,
-					agent_context->s.read_bytes + agent_context->tcp_recv_context.offset,
-					agent_context->item.interface.addr, &agent_context->item.result,
-					&agent_context->item.version)))
+			if (ZBX_COMPONENT_VERSION(7, 0, 0) <= agent_context->item.version)
+			{
+				agent_context->item.ret = agent_handle_json_response(agent_context);
+			}
+			else
+			{
+				agent_context->item.ret = zbx_agent_handle_response(agent_context->s.buffer,
+						agent_context->s.read_bytes,
+						agent_context->s.read_bytes + agent_context->tcp_recv_context.offset,
+						agent_context->item.interface.addr, &agent_context->item.result,
+						&agent_context->item.version);
+			}
+
+			if (FAIL == agent_context->item.ret)
 			{
 				/* retry with other protocol */
 				agent_context->step = ZABBIX_AGENT_STEP_CONNECT_INIT;
@@ -290,6 +375,8 @@ out:
 	zbx_tcp_send_context_clear(&agent_context->tcp_send_context);
 	if (ZABBIX_AGENT_STEP_CONNECT_INIT == agent_context->step)
 		return agent_task_process(0, data, fd, addr, dnserr, NULL);
+finish:
+	agent_batch_items_finish(agent_context);
 
 	return ZBX_ASYNC_TASK_STOP;
 }
@@ -303,53 +390,65 @@ void	zbx_async_check_agent_clean(zbx_agent_context *agent_context)
 	zbx_free(agent_context->tls_arg2);
 	zbx_free(agent_context->reverse_dns);
 	zbx_free_agent_result(&agent_context->item.result);
-}
 
-int	zbx_async_check_agent(zbx_dc_item_t *item, AGENT_RESULT *result,  zbx_async_task_clear_cb_t clear_cb,
-		void *arg, void *arg_action, struct event_base *base, struct evdns_base *dnsbase,
-		const char *config_source_ip, zbx_async_resolve_reverse_dns_t resolve_reverse_dns)
-{
-	zbx_agent_context	*agent_context = zbx_malloc(NULL, sizeof(zbx_agent_context));
-	int			ret = NOTSUPPORTED;
+	for (int i = 0; i < agent_context->batch_items_num; i++)
+	{
+		zbx_free(agent_context->batch_items[i].key_orig);
+		zbx_free(agent_context->batch_items[i].key);
+		zbx_free_agent_result(&agent_context->batch_items[i].result);
+	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s' host:'%s' addr:'%s'  conn:'%s'", __func__, item->key,
-			item->host.host, item->interface.addr, zbx_tcp_connection_type_name(item->host.tls_connect));
+	zbx_free(agent_context->batch_items);
+	zbx_free(agent_context->batch_deferred);
+}
 
-	zbx_json_init(&agent_context->j, ZBX_JSON_STAT_BUF_LEN);
-	agent_context->arg = arg;
-	agent_context->arg_action = arg_action;
-	agent_context->item.itemid = item->itemid;
-	agent_context->item.hostid = item->host.hostid;
-	agent_context->item.value_type = item->value_type;
-	agent_context->item.flags = item->flags;
-	agent_context->item.interface = item->interface;
-	agent_context->item.interface.addr = (item->interface.addr == item->interface.dns_orig ?
-			agent_context->item.interface.dns_orig : agent_context->item.interface.ip_orig);
-	agent_context->item.key_orig = zbx_strdup(NULL, item->key_orig);
+static void	agent_item_context_init(zbx_dc_item_context_t *item_context, zbx_dc_item_t *item)
+{
+	item_context->itemid = item->itemid;
+	item_context->hostid = item->host.hostid;
+	item_context->value_type = item->value_type;
+	item_context->flags = item->flags;
+	item_context->interface = item->interface;
+	item_context->interface.addr = (item->interface.addr == item->interface.dns_orig ?
+			item_context->interface.dns_orig : item_context->interface.ip_orig);
+	item_context->key_orig = zbx_strdup(NULL, item->key_orig);
 
 	if (item->key != item->key_orig)
 	{
-		agent_context->item.key = item->key;
+		item_context->key = item->key;
 		item->key = NULL;
 	}
 	else
-		agent_context->item.key = zbx_strdup(NULL, item->key);
+		item_context->key = zbx_strdup(NULL, item->key);
+
+	zbx_strlcpy(item_context->host, item->host.host, sizeof(item_context->host));
+	zbx_init_agent_result(&item_context->result);
+	item_context->ret = NETWORK_ERROR;
+	item_context->version = item->interface.version;
+}
+
+static int	async_check_agent_init(zbx_agent_context *agent_context, zbx_dc_item_t *item, AGENT_RESULT *result,
+		void *arg, void *arg_action, const char *config_source_ip,
+		zbx_async_resolve_reverse_dns_t resolve_reverse_dns)
+{
+	zbx_json_init(&agent_context->j, ZBX_JSON_STAT_BUF_LEN);
+	agent_context->arg = arg;
+	agent_context->arg_action = arg_action;
+	agent_item_context_init(&agent_context->item, item);
+
+	agent_context->batch_items = NULL;
+	agent_context->batch_deferred = NULL;
+	agent_context->batch_items_num = 0;
+	agent_context->capabilities = 0;
 
 	agent_context->resolve_reverse_dns = resolve_reverse_dns;
 	agent_context->rdns_step = ZABBIX_ASYNC_STEP_DEFAULT;
 	agent_context->reverse_dns = NULL;
 
 	agent_context->tls_connect = item->host.tls_connect;
-	zbx_strlcpy(agent_context->item.host, item->host.host, sizeof(agent_context->item.host));
-
 	agent_context->config_source_ip = config_source_ip;
-
-	zbx_init_agent_result(&agent_context->item.result);
-
 	agent_context->config_timeout = item->timeout;
 
-	agent_context->item.version = item->interface.version;
-
 	switch (agent_context->tls_connect)
 	{
 		case ZBX_TCP_SEC_UNENCRYPTED:
@@ -370,18 +469,16 @@ int	zbx_async_check_agent(zbx_dc_item_t *item, AGENT_RESULT *result,  zbx_async_
 		case ZBX_TCP_SEC_TLS_PSK:
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "A TLS connection is configured to be used with agent"
 					" but support for TLS was not compiled in"));
-			ret = CONFIG_ERROR;
 			agent_context->tls_arg1 = NULL;
 			agent_context->tls_arg2 = NULL;
-			goto out;
+			return CONFIG_ERROR;
 #endif
 		default:
 			THIS_SHOULD_NEVER_HAPPEN;
 			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid TLS connection parameters."));
-			ret = CONFIG_ERROR;
 			agent_context->tls_arg1 = NULL;
 			agent_context->tls_arg2 = NULL;
-			goto out;
+			return CONFIG_ERROR;
 	}
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	if (SUCCEED != zbx_is_ip(agent_context->item.interface.addr))
@@ -389,12 +486,30 @@ int	zbx_async_check_agent(zbx_dc_item_t *item, AGENT_RESULT *result,  zbx_async_
 	else
 		agent_context->server_name = NULL;
 #endif
+	agent_context->step = ZABBIX_AGENT_STEP_CONNECT_INIT;
+
+	return SUCCEED;
+}
+
+int	zbx_async_check_agent(zbx_dc_item_t *item, AGENT_RESULT *result,  zbx_async_task_clear_cb_t clear_cb,
+		void *arg, void *arg_action, struct event_base *base, struct evdns_base *dnsbase,
+		const char *config_source_ip, zbx_async_resolve_reverse_dns_t resolve_reverse_dns)
+{
+	zbx_agent_context	*agent_context = zbx_malloc(NULL, sizeof(zbx_agent_context));
+	int			ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s' host:'%s' addr:'%s'  conn:'%s'", __func__, item->key,
+			item->host.host, item->interface.addr, zbx_tcp_connection_type_name(item->host.tls_connect));
+
+	if (SUCCEED != (ret = async_check_agent_init(agent_context, item, result, arg, arg_action, config_source_ip,
+			resolve_reverse_dns)))
+	{
+		goto out;
+	}
 
 	if (ZBX_COMPONENT_VERSION(7, 0, 0) <= agent_context->item.version)
 		zbx_agent_prepare_request(&agent_context->j, agent_context->item.key, item->timeout);
 
-	agent_context->step = ZABBIX_AGENT_STEP_CONNECT_INIT;
-
 	zbx_async_poller_add_task(base, dnsbase, agent_context->item.interface.addr, agent_context, item->timeout + 1,
 			agent_task_process, clear_cb);
 
@@ -408,3 +523,82 @@ out:
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: requests values of multiple items from the same interface in one  *
+ *          passive checks request                                            *
+ *                                                                            *
+ * Parameters: items            - [IN] items of the same interface            *
+ *             results          - [OUT] item results, set on failure          *
+ *             num              - [IN] number of items                        *
+ *             clear_cb         - [IN] task completion callback               *
+ *             arg              - [IN] callback argument                      *
+ *             arg_action       - [IN] poller configuration                   *
+ *             base             - [IN] event base                             *
+ *             dnsbase          - [IN] DNS event base                         *
+ *             config_source_ip - [IN]                                        *
+ *                                                                            *
+ * Return value: SUCCEED - task was added                                     *
+ *               CONFIG_ERROR - otherwise, all results contain error message  *
+ *                                                                            *
+ * Comments: Only agents with ZBX_AGENT_CAPABILITY_BATCH capability support   *
+ *           such requests. Results of the first item are stored in item      *
+ *           context and results of other items in batch items of context.    *
+ *           Agent executes keys one after another, so the response is        *
+ *           awaited for the sum of item timeouts. Callers must limit it to   *
+ *           ZBX_AGENT_BATCH_TIMEOUT_MAX, keys exceeding the limit are        *
+ *           deferred by agent.                                               *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_async_check_agent_batch(zbx_dc_item_t **items, AGENT_RESULT **results, int num,
+		zbx_async_task_clear_cb_t clear_cb, void *arg, void *arg_action, struct event_base *base,
+		struct evdns_base *dnsbase, const char *config_source_ip)
+{
+	zbx_agent_context	*agent_context = zbx_malloc(NULL, sizeof(zbx_agent_context));
+	int			ret, timeout = items[0]->timeout;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d host:'%s' addr:'%s'  conn:'%s'", __func__, num,
+			items[0]->host.host, items[0]->interface.addr,
+			zbx_tcp_connection_type_name(items[0]->host.tls_connect));
+
+	if (SUCCEED != (ret = async_check_agent_init(agent_context, items[0], results[0], arg, arg_action,
+			config_source_ip, ZABBIX_ASYNC_RESOLVE_REVERSE_DNS_NO)))
+	{
+		for (int i = 1; i < num; i++)
+			SET_MSG_RESULT(results[i], zbx_strdup(NULL, results[0]->msg));
+
+		goto out;
+	}
+
+	zbx_agent_prepare_request(&agent_context->j, agent_context->item.key, items[0]->timeout);
+
+	agent_context->batch_items = (zbx_dc_item_context_t *)zbx_malloc(NULL,
+			sizeof(zbx_dc_item_context_t) * (size_t)(num - 1));
+	agent_context->batch_deferred = (unsigned char *)zbx_calloc(NULL, (size_t)(num - 1), sizeof(unsigned char));
+
+	for (int i = 1; i < num; i++)
+	{
+		zbx_dc_item_context_t	*item_context = &agent_context->batch_items[agent_context->batch_items_num++];
+
+		agent_item_context_init(item_context, items[i]);
+		zbx_agent_request_add_key(&agent_context->j, item_context->key, items[i]->timeout);
+
+		timeout += items[i]->timeout;
+	}
+
+	agent_context->config_timeout = timeout;
+
+	zbx_async_poller_add_task(base, dnsbase, agent_context->item.interface.addr, agent_context, timeout + 1,
+			agent_task_process, clear_cb);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(SUCCEED));
+
+	return SUCCEED;
+out:
+	zbx_async_check_agent_clean(agent_context);
+	zbx_free(agent_context);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
@@ -29,7 +29,7 @@ void	zbx_async_check_httpagent_clean(zbx_httpagent_context *httpagent_context)
 
 int	zbx_async_check_httpagent(zbx_dc_item_t *item, AGENT_RESULT *result, const char *config_source_ip,
 		const char *config_ssl_ca_location, const char *config_ssl_cert_location,
-		const char *config_ssl_key_location, CURLM *curl_handle)
+		const char *config_ssl_key_location, CURLM *curl_handle, CURLSH *curl_share)
 {
 	char			*error = NULL;
 	zbx_httpagent_context	*httpagent_context = zbx_malloc(NULL, sizeof(zbx_httpagent_context));
@@ -70,6 +70,27 @@ int	zbx_async_check_httpagent(zbx_dc_item_t *item, AGENT_RESULT *result, const c
 		goto fail;
 	}
 
+	if (CURLE_OK != (err = curl_easy_setopt(httpagent_context->http_context.easyhandle, CURLOPT_SHARE,
+			curl_share)))
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set cURL share handle: %s",
+				curl_easy_strerror(err)));
+
+		goto fail;
+	}
+
+#if LIBCURL_VERSION_NUM >= 0x072f00 && LIBCURL_VERSION_NUM < 0x073e00
+	/* HTTP/2 over TLS is the default starting with version 7.62.0 (0x073e00), the option is ignored */
+	/* when cURL is built without HTTP/2 support and HTTP/1.1 is used then                           */
+	(void)curl_easy_setopt(httpagent_context->http_context.easyhandle, CURLOPT_HTTP_VERSION,
+			CURL_HTTP_VERSION_2TLS);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072b00
+	/* CURLOPT_PIPEWAIT is supported starting with version 7.43.0 (0x072b00), wait for a connection */
+	/* to be multiplexed instead of opening a new one to the same host                              */
+	(void)curl_easy_setopt(httpagent_context->http_context.easyhandle, CURLOPT_PIPEWAIT, 1L);
+#endif
+
 	if (CURLM_OK != (merr = curl_multi_add_handle(curl_handle, httpagent_context->http_context.easyhandle)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot add a standard curl handle to the multi stack: %s",
@@ -43,7 +43,7 @@ zbx_httpagent_context;
 
 int	zbx_async_check_httpagent(zbx_dc_item_t *item, AGENT_RESULT *result, const char *config_source_ip,
 		const char *config_ssl_ca_location, const char *config_ssl_cert_location,
-		const char *config_ssl_key_location, CURLM *curl_handle);
+		const char *config_ssl_key_location, CURLM *curl_handle, CURLSH *curl_share);
 void	zbx_async_check_httpagent_clean(zbx_httpagent_context *httpagent_context);
 #endif
 #endif
@@ -145,11 +145,21 @@ void	zbx_async_manager_requeue(zbx_async_manager_t *manager, zbx_uint64_t itemid
 	async_task_queue_unlock(&manager->queue);
 }
 
+void	zbx_async_manager_requeue_deferred(zbx_async_manager_t *manager, zbx_uint64_t itemid, int nextcheck)
+{
+	async_task_queue_lock(&manager->queue);
+
+	zbx_vector_uint64_append(&manager->queue.deferred_itemids, itemid);
+	zbx_vector_int32_append(&manager->queue.deferred_nextchecks, nextcheck);
+
+	async_task_queue_unlock(&manager->queue);
+}
+
 void	zbx_async_manager_requeue_flush(zbx_async_manager_t *manager)
 {
 	async_task_queue_lock(&manager->queue);
 
-	if (0 != manager->queue.itemids.values_num)
+	if (0 != manager->queue.itemids.values_num || 0 != manager->queue.deferred_itemids.values_num)
 		async_task_queue_notify(&manager->queue);
 
 	async_task_queue_unlock(&manager->queue);
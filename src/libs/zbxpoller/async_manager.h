@@ -55,6 +55,8 @@ void			zbx_async_manager_queue_get(zbx_async_manager_t *manager,
 					zbx_vector_poller_item_t *poller_items);
 void			zbx_async_manager_requeue(zbx_async_manager_t *manager, zbx_uint64_t itemid, int errcode,
 					int lastclock);
+void			zbx_async_manager_requeue_deferred(zbx_async_manager_t *manager, zbx_uint64_t itemid,
+					int nextcheck);
 void			zbx_async_manager_requeue_flush(zbx_async_manager_t *manager);
 void			zbx_async_manager_interfaces_flush(zbx_async_manager_t *manager, zbx_hashset_t *interfaces);
 void			zbx_interface_status_clean(zbx_interface_status_t *interface_status);
@@ -43,6 +43,8 @@
 #include "zbxtime.h"
 #include "zbxtypes.h"
 #include "zbxasyncpoller.h"
+#include "zbxagentget.h"
+#include "zbxversion.h"
 
 #include <event2/dns.h>
 
@@ -50,6 +52,18 @@
 #	define EVDNS_BASE_INITIALIZE_NAMESERVERS	1
 #endif
 
+#ifdef HAVE_NETSNMP
+#define ZBX_SNMP_INTERFACE_BATCHES_MAX	1	/* SNMP batch requests in flight per interface */
+#define ZBX_SNMP_INTERFACE_BATCH_DELAY	1	/* seconds to postpone items of interface over the limit */
+
+typedef struct
+{
+	zbx_uint64_t	interfaceid;
+	int		batches_num;
+}
+zbx_snmp_interface_batches_t;
+#endif
+
 static void	process_async_result(zbx_dc_item_context_t *item, zbx_poller_config_t *poller_config)
 {
 	zbx_timespec_t		timespec;
@@ -121,13 +135,49 @@ static void	process_async_result(zbx_dc_item_context_t *item, zbx_poller_config_
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(item->ret));
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: requeues item deferred by agent for immediate check without       *
+ *          changing its state, the item is checked one by one next time      *
+ *                                                                            *
+ ******************************************************************************/
+static void	process_deferred_result(zbx_dc_item_context_t *item, zbx_poller_config_t *poller_config)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "itemid:" ZBX_FS_UI64 " key:'%s' host:'%s' was deferred by agent", item->itemid,
+			item->key, item->host);
+
+	zbx_hashset_insert(&poller_config->deferred_items, &item->itemid, sizeof(item->itemid));
+	zbx_async_manager_requeue_deferred(poller_config->manager, item->itemid, (int)time(NULL));
+
+	poller_config->processing--;
+}
+
 static void	process_agent_result(void *data)
 {
 	zbx_agent_context	*agent_context = (zbx_agent_context *)data;
 	zbx_poller_config_t	*poller_config = (zbx_poller_config_t *)agent_context->arg;
 
+	if (ZBX_COMPONENT_VERSION(7, 0, 0) <= agent_context->item.version &&
+			(SUCCEED == agent_context->item.ret || NOTSUPPORTED == agent_context->item.ret))
+	{
+		zbx_uint64_t	interfaceid = agent_context->item.interface.interfaceid;
+
+		if (0 != (agent_context->capabilities & ZBX_AGENT_CAPABILITY_BATCH))
+			zbx_hashset_insert(&poller_config->batch_interfaces, &interfaceid, sizeof(interfaceid));
+		else
+			zbx_hashset_remove(&poller_config->batch_interfaces, &interfaceid);
+	}
+
 	process_async_result(&agent_context->item, poller_config);
 
+	for (int i = 0; i < agent_context->batch_items_num; i++)
+	{
+		if (0 != agent_context->batch_deferred[i])
+			process_deferred_result(&agent_context->batch_items[i], poller_config);
+		else
+			process_async_result(&agent_context->batch_items[i], poller_config);
+	}
+
 	zbx_async_check_agent_clean(agent_context);
 	zbx_free(agent_context);
 }
@@ -136,8 +186,24 @@ static void	process_snmp_result(void *data)
 {
 	zbx_snmp_context_t	*snmp_context = (zbx_snmp_context_t *)data;
 	zbx_poller_config_t	*poller_config = (zbx_poller_config_t *)zbx_async_check_snmp_get_arg(snmp_context);
+	zbx_dc_item_context_t	*batch_items;
+	int			batch_items_num;
 
-	process_async_result(zbx_async_check_snmp_get_item_context(snmp_context), poller_config);
+	if (NULL != (batch_items = zbx_async_check_snmp_get_batch_items(snmp_context, &batch_items_num)))
+	{
+		zbx_snmp_interface_batches_t	*interface_batches;
+
+		if (NULL != (interface_batches = zbx_hashset_search(&poller_config->snmp_batches,
+				&batch_items[0].interface.interfaceid)) && 0 == --interface_batches->batches_num)
+		{
+			zbx_hashset_remove_direct(&poller_config->snmp_batches, interface_batches);
+		}
+
+		for (int i = 0; i < batch_items_num; i++)
+			process_async_result(&batch_items[i], poller_config);
+	}
+	else
+		process_async_result(zbx_async_check_snmp_get_item_context(snmp_context), poller_config);
 
 	zbx_async_check_snmp_clean(snmp_context);
 }
@@ -145,7 +211,7 @@ static void	process_snmp_result(void *data)
 #ifdef HAVE_LIBCURL
 static void	process_httpagent_result(CURL *easy_handle, CURLcode err, void *arg)
 {
-	long				response_code;
+	long				response_code, connects;
 	char				*status_codes, *error, *out = NULL;
 	AGENT_RESULT			result;
 	zbx_httpagent_context		*httpagent_context;
@@ -168,6 +234,15 @@ static void	process_httpagent_result(CURL *easy_handle, CURLcode err, void *arg)
 
 	zbx_timespec(&timespec);
 
+	/* no new connections means that the transfer was made over a cached connection */
+	if (CURLE_OK == curl_easy_getinfo(easy_handle, CURLINFO_NUM_CONNECTS, &connects))
+	{
+		if (0 != connects)
+			poller_config->connections_new += (int)connects;
+		else if (CURLE_OK == err)
+			poller_config->connections_reused++;
+	}
+
 	zbx_init_agent_result(&result);
 	status_codes = httpagent_context->item_context.status_codes;
 	item_context = &httpagent_context->item_context;
@@ -219,6 +294,210 @@ static void	async_wake(evutil_socket_t fd, short events, void *arg)
 	ZBX_UNUSED(arg);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: requests Zabbix agent items of the same interface in batches      *
+ *                                                                            *
+ * Parameters: poller_config - [IN] poller configuration                      *
+ *             items         - [IN] items to check                            *
+ *             results       - [OUT] item results                             *
+ *             errcodes      - [IN/OUT] item error codes, codes of batched    *
+ *                                      items are updated                     *
+ *             num           - [IN] number of items                           *
+ *             batched       - [OUT] flags of items added to batches          *
+ *                                                                            *
+ * Comments: Only items of agents that have reported batch capability are     *
+ *           batched, other items are checked one by one. The sum of batch    *
+ *           item timeouts is limited by ZBX_AGENT_BATCH_TIMEOUT_MAX as agent *
+ *           executes keys one after another. Items deferred by agent in      *
+ *           previous batch are checked one by one.                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_initiate_agent_batches(zbx_poller_config_t *poller_config, zbx_dc_item_t *items,
+		AGENT_RESULT *results, int *errcodes, int num, unsigned char *batched)
+{
+	zbx_vector_uint64_pair_t	candidates;
+	zbx_dc_item_t			*batch_items[ZBX_MAX_AGENT_BATCH_ITEMS];
+	AGENT_RESULT			*batch_results[ZBX_MAX_AGENT_BATCH_ITEMS];
+	int				batch_indexes[ZBX_MAX_AGENT_BATCH_ITEMS];
+
+	zbx_vector_uint64_pair_create(&candidates);
+
+	for (int i = 0; i < num; i++)
+	{
+		zbx_uint64_pair_t	pair;
+
+		if (SUCCEED != errcodes[i] || ITEM_TYPE_ZABBIX != items[i].type ||
+				ZBX_COMPONENT_VERSION(7, 0, 0) > items[i].interface.version ||
+				NULL == zbx_hashset_search(&poller_config->batch_interfaces,
+				&items[i].interface.interfaceid))
+		{
+			continue;
+		}
+
+		if (NULL != zbx_hashset_search(&poller_config->deferred_items, &items[i].itemid))
+		{
+			zbx_hashset_remove(&poller_config->deferred_items, &items[i].itemid);
+			continue;
+		}
+
+		pair.first = items[i].interface.interfaceid;
+		pair.second = (zbx_uint64_t)i;
+		zbx_vector_uint64_pair_append(&candidates, pair);
+	}
+
+	zbx_vector_uint64_pair_sort(&candidates, ZBX_DEFAULT_UINT64_PAIR_COMPARE_FUNC);
+
+	for (int i = 0, batch_num; i < candidates.values_num; i += batch_num)
+	{
+		int	ret, timeout = 0;
+
+		for (batch_num = 0; batch_num < ZBX_MAX_AGENT_BATCH_ITEMS && i + batch_num < candidates.values_num &&
+				candidates.values[i].first == candidates.values[i + batch_num].first; batch_num++)
+		{
+			int	index = (int)candidates.values[i + batch_num].second;
+
+			if (0 != batch_num && ZBX_AGENT_BATCH_TIMEOUT_MAX < timeout + items[index].timeout)
+				break;
+
+			timeout += items[index].timeout;
+			batch_indexes[batch_num] = index;
+			batch_items[batch_num] = &items[index];
+			batch_results[batch_num] = &results[index];
+		}
+
+		/* single items are checked without batch overhead */
+		if (1 == batch_num)
+			continue;
+
+		ret = zbx_async_check_agent_batch(batch_items, batch_results, batch_num, process_agent_result,
+				poller_config, poller_config, poller_config->base, poller_config->dnsbase,
+				poller_config->config_source_ip);
+
+		for (int j = 0; j < batch_num; j++)
+		{
+			errcodes[batch_indexes[j]] = ret;
+			batched[batch_indexes[j]] = 1;
+
+			if (SUCCEED == ret)
+				poller_config->processing++;
+		}
+	}
+
+	zbx_vector_uint64_pair_destroy(&candidates);
+}
+
+#ifdef HAVE_NETSNMP
+/******************************************************************************
+ *                                                                            *
+ * Purpose: requests SNMP items with plain OIDs of the same interface in      *
+ *          batches                                                           *
+ *                                                                            *
+ * Parameters: poller_config - [IN] poller configuration                      *
+ *             items         - [IN] items to check                            *
+ *             results       - [OUT] item results                             *
+ *             errcodes      - [IN/OUT] item error codes, codes of batched    *
+ *                                      items are updated                     *
+ *             num           - [IN] number of items                           *
+ *             batched       - [OUT] flags of items added to batches          *
+ *                                                                            *
+ * Comments: Items of walk[] and get[] OIDs are checked one by one.           *
+ *           No more than ZBX_SNMP_INTERFACE_BATCHES_MAX batches are sent to  *
+ *           the same interface at a time, items of other batches are         *
+ *           requeued without checking to be polled a bit later.              *
+ *                                                                            *
+ ******************************************************************************/
+static void	async_initiate_snmp_batches(zbx_poller_config_t *poller_config, zbx_dc_item_t *items,
+		AGENT_RESULT *results, int *errcodes, int num, unsigned char *batched)
+{
+	zbx_vector_uint64_pair_t	candidates;
+	zbx_dc_item_t			*batch_items[ZBX_MAX_SNMP_ITEMS];
+	AGENT_RESULT			*batch_results[ZBX_MAX_SNMP_ITEMS];
+	int				batch_indexes[ZBX_MAX_SNMP_ITEMS], batch_errcodes[ZBX_MAX_SNMP_ITEMS];
+	time_t				now;
+
+	now = time(NULL);
+
+	zbx_vector_uint64_pair_create(&candidates);
+
+	for (int i = 0; i < num; i++)
+	{
+		zbx_uint64_pair_t	pair;
+
+		if (SUCCEED != errcodes[i] || ITEM_TYPE_SNMP != items[i].type ||
+				0 == strncmp(items[i].snmp_oid, "walk[", ZBX_CONST_STRLEN("walk[")) ||
+				0 == strncmp(items[i].snmp_oid, "get[", ZBX_CONST_STRLEN("get[")))
+		{
+			continue;
+		}
+
+		pair.first = items[i].interface.interfaceid;
+		pair.second = (zbx_uint64_t)i;
+		zbx_vector_uint64_pair_append(&candidates, pair);
+	}
+
+	zbx_vector_uint64_pair_sort(&candidates, ZBX_DEFAULT_UINT64_PAIR_COMPARE_FUNC);
+
+	for (int i = 0, batch_num; i < candidates.values_num; i += batch_num)
+	{
+		zbx_snmp_interface_batches_t	*interface_batches;
+
+		for (batch_num = 0; batch_num < ZBX_MAX_SNMP_ITEMS && i + batch_num < candidates.values_num &&
+				candidates.values[i].first == candidates.values[i + batch_num].first; batch_num++)
+		{
+			int	index = (int)candidates.values[i + batch_num].second;
+
+			batch_indexes[batch_num] = index;
+			batch_items[batch_num] = &items[index];
+			batch_results[batch_num] = &results[index];
+		}
+
+		if (NULL == (interface_batches = zbx_hashset_search(&poller_config->snmp_batches,
+				&candidates.values[i].first)))
+		{
+			zbx_snmp_interface_batches_t	interface_batches_local = {.interfaceid =
+					candidates.values[i].first};
+
+			interface_batches = zbx_hashset_insert(&poller_config->snmp_batches, &interface_batches_local,
+					sizeof(interface_batches_local));
+		}
+
+		if (ZBX_SNMP_INTERFACE_BATCHES_MAX <= interface_batches->batches_num)
+		{
+			for (int j = 0; j < batch_num; j++)
+			{
+				zbx_async_manager_requeue_deferred(poller_config->manager, batch_items[j]->itemid,
+						(int)now + ZBX_SNMP_INTERFACE_BATCH_DELAY);
+				batched[batch_indexes[j]] = 1;
+			}
+
+			continue;
+		}
+
+		if (SUCCEED == zbx_async_check_snmp_get_values(batch_items, batch_results, batch_errcodes, batch_num,
+				process_snmp_result, poller_config, poller_config, poller_config->base,
+				poller_config->dnsbase, poller_config->config_source_ip,
+				ZBX_SNMP_DEFAULT_NUMBER_OF_RETRIES))
+		{
+			interface_batches->batches_num++;
+		}
+		else if (0 == interface_batches->batches_num)
+			zbx_hashset_remove_direct(&poller_config->snmp_batches, interface_batches);
+
+		for (int j = 0; j < batch_num; j++)
+		{
+			errcodes[batch_indexes[j]] = batch_errcodes[j];
+			batched[batch_indexes[j]] = 1;
+
+			if (SUCCEED == batch_errcodes[j])
+				poller_config->processing++;
+		}
+	}
+
+	zbx_vector_uint64_pair_destroy(&candidates);
+}
+#endif
+
 static void	async_initiate_queued_checks(zbx_poller_config_t *poller_config, const char *zbx_progname)
 {
 	zbx_dc_item_t			*items = NULL;
@@ -254,7 +533,8 @@ static void	async_initiate_queued_checks(zbx_poller_config_t *poller_config, con
 
 	for (int j = 0; j < poller_items.values_num; j++)
 	{
-		int	num;
+		int		num;
+		unsigned char	*batched = NULL;
 
 		items = poller_items.values[j]->items;
 		results = poller_items.values[j]->results;
@@ -263,9 +543,24 @@ static void	async_initiate_queued_checks(zbx_poller_config_t *poller_config, con
 
 		total += num;
 
+		if (ZBX_POLLER_TYPE_AGENT == poller_config->poller_type)
+		{
+			batched = (unsigned char *)zbx_calloc(NULL, (size_t)num, sizeof(unsigned char));
+			async_initiate_agent_batches(poller_config, items, results, errcodes, num, batched);
+		}
+#ifdef HAVE_NETSNMP
+		else if (ZBX_POLLER_TYPE_SNMP == poller_config->poller_type)
+		{
+			zbx_set_snmp_bulkwalk_options(zbx_progname);
+
+			batched = (unsigned char *)zbx_calloc(NULL, (size_t)num, sizeof(unsigned char));
+			async_initiate_snmp_batches(poller_config, items, results, errcodes, num, batched);
+		}
+#endif
+
 		for (int i = 0; i < num; i++)
 		{
-			if (SUCCEED != errcodes[i])
+			if (SUCCEED != errcodes[i] || (NULL != batched && 0 != batched[i]))
 				continue;
 
 			if (ITEM_TYPE_HTTPAGENT == items[i].type)
@@ -274,7 +569,8 @@ static void	async_initiate_queued_checks(zbx_poller_config_t *poller_config, con
 				errcodes[i] = zbx_async_check_httpagent(&items[i], &results[i],
 						poller_config->config_source_ip, poller_config->config_ssl_ca_location,
 						poller_config->config_ssl_cert_location,
-						poller_config->config_ssl_key_location, poller_config->curl_handle);
+						poller_config->config_ssl_key_location, poller_config->curl_handle,
+						poller_config->curl_share);
 	#else
 				errcodes[i] = NOTSUPPORTED;
 				SET_MSG_RESULT(&results[i], zbx_strdup(NULL, "Support for HTTP agent was not compiled"
@@ -327,6 +623,7 @@ static void	async_initiate_queued_checks(zbx_poller_config_t *poller_config, con
 			}
 		}
 
+		zbx_free(batched);
 		zbx_poller_item_free(poller_items.values[j]);
 	}
 #ifdef HAVE_NETSNMP
@@ -367,6 +664,14 @@ static void	async_poller_init(zbx_poller_config_t *poller_config, zbx_thread_pol
 	zbx_hashset_create_ext(&poller_config->interfaces, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
 			ZBX_DEFAULT_UINT64_COMPARE_FUNC, (zbx_clean_func_t)zbx_interface_status_clean,
 			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	zbx_hashset_create(&poller_config->batch_interfaces, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&poller_config->deferred_items, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+#ifdef HAVE_NETSNMP
+	zbx_hashset_create(&poller_config->snmp_batches, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+#endif
 
 	if (NULL == (poller_config->base = event_base_new()))
 	{
@@ -473,6 +778,11 @@ static void	async_poller_destroy(zbx_poller_config_t *poller_config)
 	event_base_free(poller_config->base);
 	zbx_hashset_clear(&poller_config->interfaces);
 	zbx_hashset_destroy(&poller_config->interfaces);
+	zbx_hashset_destroy(&poller_config->batch_interfaces);
+	zbx_hashset_destroy(&poller_config->deferred_items);
+#ifdef HAVE_NETSNMP
+	zbx_hashset_destroy(&poller_config->snmp_batches);
+#endif
 }
 
 #ifdef HAVE_LIBCURL
@@ -554,6 +864,7 @@ ZBX_THREAD_ENTRY(zbx_async_poller_thread, args)
 		}
 
 		poller_config.curl_handle = asynchttppoller_config->curl_handle;
+		poller_config.curl_share = asynchttppoller_config->curl_share;
 #endif
 	}
 	else if (ZBX_POLLER_TYPE_AGENT == poller_type)
@@ -606,11 +917,22 @@ ZBX_THREAD_ENTRY(zbx_async_poller_thread, args)
 
 		if (STAT_INTERVAL <= time(NULL) - last_stat_time)
 		{
+			char	conn_stats[64] = "";
+
 			zbx_update_env(get_process_type_string(process_type), zbx_time());
+#ifdef HAVE_LIBCURL
+			if (ZBX_POLLER_TYPE_HTTPAGENT == poller_type)
+			{
+				zbx_snprintf(conn_stats, sizeof(conn_stats), ", connections %d new %d reused",
+						poller_config.connections_new, poller_config.connections_reused);
 
-			zbx_setproctitle("%s #%d [got %d values, queued %d in 5 sec, awaiting %d%s]",
+				poller_config.connections_new = 0;
+				poller_config.connections_reused = 0;
+			}
+#endif
+			zbx_setproctitle("%s #%d [got %d values, queued %d in 5 sec, awaiting %d%s%s]",
 				get_process_type_string(process_type), process_num, poller_config.processed,
-				poller_config.queued, poller_config.processing, zbx_vps_monitor_status());
+				poller_config.queued, poller_config.processing, conn_stats, zbx_vps_monitor_status());
 
 			poller_config.processed = 0;
 			poller_config.queued = 0;
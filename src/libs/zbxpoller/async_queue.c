@@ -34,6 +34,8 @@ void	async_task_queue_destroy(zbx_async_queue_t *queue)
 	zbx_vector_uint64_destroy(&queue->itemids);
 	zbx_vector_int32_destroy(&queue->errcodes);
 	zbx_vector_int32_destroy(&queue->lastclocks);
+	zbx_vector_uint64_destroy(&queue->deferred_itemids);
+	zbx_vector_int32_destroy(&queue->deferred_nextchecks);
 
 	zbx_vector_poller_item_clear_ext(&queue->poller_items, zbx_poller_item_free);
 	zbx_vector_poller_item_destroy(&queue->poller_items);
@@ -59,6 +61,8 @@ int	async_task_queue_init(zbx_async_queue_t *queue, zbx_thread_poller_args *poll
 	zbx_vector_uint64_create(&queue->itemids);
 	zbx_vector_int32_create(&queue->errcodes);
 	zbx_vector_int32_create(&queue->lastclocks);
+	zbx_vector_uint64_create(&queue->deferred_itemids);
+	zbx_vector_int32_create(&queue->deferred_nextchecks);
 	zbx_vector_poller_item_create(&queue->poller_items);
 	zbx_vector_interface_status_create(&queue->interfaces);
 
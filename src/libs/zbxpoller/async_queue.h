@@ -40,6 +40,8 @@ typedef struct
 	zbx_vector_uint64_t		itemids;
 	zbx_vector_int32_t		errcodes;
 	zbx_vector_int32_t		lastclocks;
+	zbx_vector_uint64_t		deferred_itemids;
+	zbx_vector_int32_t		deferred_nextchecks;
 	unsigned char			check_queue;
 
 	pthread_mutex_t			lock;
@@ -136,6 +136,8 @@ static void	*async_worker_entry(void *args)
 	int				err;
 	zbx_vector_interface_status_t	interfaces;
 	zbx_vector_uint64_t		itemids;
+	zbx_vector_uint64_t		deferred_itemids;
+	zbx_vector_int32_t		deferred_nextchecks;
 	zbx_vector_int32_t		errcodes;
 	zbx_vector_int32_t		lastclocks;
 
@@ -162,6 +164,8 @@ static void	*async_worker_entry(void *args)
 	zbx_vector_uint64_create(&itemids);
 	zbx_vector_int32_create(&errcodes);
 	zbx_vector_int32_create(&lastclocks);
+	zbx_vector_uint64_create(&deferred_itemids);
+	zbx_vector_int32_create(&deferred_nextchecks);
 
 	const unsigned char	poller_type = queue->poller_type;
 	const zbx_uint64_t	processing_limit = queue->processing_limit;
@@ -203,6 +207,21 @@ static void	*async_worker_entry(void *args)
 			processing_num = queue->processing_num -= itemids.values_num;
 		}
 
+		if (0 != queue->deferred_itemids.values_num)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "requeue deferred num:%d", queue->deferred_itemids.values_num);
+
+			zbx_vector_uint64_append_array(&deferred_itemids, queue->deferred_itemids.values,
+					queue->deferred_itemids.values_num);
+			zbx_vector_int32_append_array(&deferred_nextchecks, queue->deferred_nextchecks.values,
+					queue->deferred_nextchecks.values_num);
+
+			zbx_vector_uint64_clear(&queue->deferred_itemids);
+			zbx_vector_int32_clear(&queue->deferred_nextchecks);
+
+			processing_num = queue->processing_num -= deferred_itemids.values_num;
+		}
+
 		queue_poller_items_values_num = queue->poller_items.values_num;
 
 		async_task_queue_unlock(queue);
@@ -233,6 +252,25 @@ static void	*async_worker_entry(void *args)
 			zabbix_log(LOG_LEVEL_DEBUG, "requeue items nextcheck:%d", nextcheck);
 		}
 
+		/* queue nextcheck returned after requeuing deferred items also covers other requeued items */
+		if (0 != deferred_itemids.values_num)
+		{
+			int	nextcheck;
+
+			zbx_dc_poller_requeue_items_at(deferred_itemids.values, deferred_nextchecks.values,
+					(size_t)deferred_itemids.values_num, poller_type, &nextcheck);
+
+			if (FAIL == nextcheck || nextcheck > time(NULL))
+				check_queue = 0;
+			else
+				check_queue = 1;
+
+			zbx_vector_int32_clear(&deferred_nextchecks);
+			zbx_vector_uint64_clear(&deferred_itemids);
+
+			zabbix_log(LOG_LEVEL_DEBUG, "requeue deferred items nextcheck:%d", nextcheck);
+		}
+
 		/* only check queue if requested to preserve resources */
 		if (1 == check_queue)
 		{
@@ -268,6 +306,8 @@ static void	*async_worker_entry(void *args)
 	zbx_vector_interface_status_clear_ext(&interfaces, zbx_interface_status_free);
 	zbx_vector_interface_status_destroy(&interfaces);
 
+	zbx_vector_int32_destroy(&deferred_nextchecks);
+	zbx_vector_uint64_destroy(&deferred_itemids);
 	zbx_vector_int32_destroy(&lastclocks);
 	zbx_vector_int32_destroy(&errcodes);
 	zbx_vector_uint64_destroy(&itemids);
@@ -658,6 +658,8 @@ int	get_value_internal(const zbx_dc_item_t *item, AGENT_RESULT *result, const zb
 				SET_UI64_RESULT(result, *(zbx_uint64_t *)zbx_dc_get_stats(ZBX_STATS_HISTORY_FREE));
 			else if (0 == strcmp(tmp1, "pused"))
 				SET_DBL_RESULT(result, *(double *)zbx_dc_get_stats(ZBX_STATS_HISTORY_PUSED));
+			else if (0 == strcmp(tmp1, "lockwait"))
+				SET_DBL_RESULT(result, *(double *)zbx_dc_get_stats(ZBX_STATS_HISTORY_LOCK_WAIT));
 			else
 			{
 				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
@@ -1018,6 +1020,14 @@ int	get_value_internal(const zbx_dc_item_t *item, AGENT_RESULT *result, const zb
 		{
 			SET_UI64_RESULT(result, stats.requests_num);
 		}
+		else if (0 == strcmp(tmp, "rollups"))
+		{
+			SET_UI64_RESULT(result, stats.rollups_num);
+		}
+		else if (0 == strcmp(tmp, "rollup_hits"))
+		{
+			SET_UI64_RESULT(result, stats.rollup_hits);
+		}
 		else if (0 == strcmp(tmp, "pmisses"))
 		{
 			zbx_uint64_t	total = stats.hits + stats.misses;
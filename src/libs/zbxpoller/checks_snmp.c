@@ -186,6 +186,16 @@ struct zbx_snmp_context
 	zbx_async_resolve_reverse_dns_t	resolve_reverse_dns;
 	zbx_async_rdns_step_t		step;
 	char				*reverse_dns;
+	zbx_dc_item_context_t		*batch_items;	/* items of ZBX_SNMP_GET_VALUES request */
+	int				batch_items_num;
+	int				next_item;	/* first batch item that was not requested yet */
+	int				mapping[ZBX_MAX_SNMP_ITEMS];	/* batch items of the current PDU */
+	int				mapping_num;
+	int				max_vars;
+	int				level;		/* 0 - full requests, 1 - halved, 2 - one by one */
+	int				max_succeed;
+	int				min_fail;
+	int				bulk;
 };
 
 typedef struct
@@ -205,8 +215,9 @@ static char				snmp_rwlock_init_done;
 static zbx_hashset_t	engineid_cache;
 static int		engineid_cache_initialized = 0;
 
-#define ZBX_SNMP_GET	0
-#define ZBX_SNMP_WALK	1
+#define ZBX_SNMP_GET		0
+#define ZBX_SNMP_WALK		1
+#define ZBX_SNMP_GET_VALUES	2
 
 #define	SNMP_MT_EXECLOCK					\
 	if (0 != snmp_rwlock_init_done)				\
@@ -2328,6 +2339,8 @@ static void	snmp_bulkwalk_set_options(zbx_snmp_format_opts_t *opts)
 	netsnmp_ds_set_boolean(NETSNMP_DS_LIBRARY_ID, NETSNMP_DS_LIB_DONT_PRINT_UNITS, opts->no_print_units);
 }
 
+static ZBX_THREAD_LOCAL zbx_snmp_format_opts_t	default_opts;
+
 static void	snmp_bulkwalk_remove_matching_oids(zbx_vector_snmp_oid_t *oids)
 {
 	zbx_vector_snmp_oid_sort(oids, (zbx_compare_func_t)zbx_snmp_oid_compare);
@@ -2721,6 +2734,275 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: selects next batch items without result for GET request           *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_get_values_map_next(zbx_snmp_context_t *snmp_context, zbx_bulkwalk_context_t *bulkwalk_context)
+{
+	snmp_context->mapping_num = 0;
+
+	for (; snmp_context->next_item < snmp_context->batch_items_num &&
+			snmp_context->mapping_num < snmp_context->max_vars; snmp_context->next_item++)
+	{
+		const AGENT_RESULT	*result = &snmp_context->batch_items[snmp_context->next_item].result;
+
+		if (0 != ZBX_ISSET_VALUE(result) || 0 != ZBX_ISSET_MSG(result))
+			continue;
+
+		snmp_context->mapping[snmp_context->mapping_num++] = snmp_context->next_item;
+	}
+
+	if (0 == snmp_context->mapping_num)
+	{
+		bulkwalk_context->running = 0;
+		return;
+	}
+
+	/* the first requested OID is reported in log and timeout messages */
+	bulkwalk_context->p_oid = snmp_context->param_oids.values[snmp_context->mapping[0]];
+	memcpy(bulkwalk_context->name, bulkwalk_context->p_oid->root_oid,
+			bulkwalk_context->p_oid->root_oid_len * sizeof(oid));
+	bulkwalk_context->name_length = bulkwalk_context->p_oid->root_oid_len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: repeats the last GET request with fewer variables                 *
+ *                                                                            *
+ * Comments: Follows the levels of synchronous zbx_snmp_get_values() - failed *
+ *           full request is repeated with half of its variables, failed      *
+ *           halved request is repeated one variable at a time and the first  *
+ *           failed single variable request fails the rest of batch items.    *
+ *           Smaller requests are not retried after timeout.                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_get_values_halve(zbx_snmp_context_t *snmp_context, zbx_bulkwalk_context_t *bulkwalk_context)
+{
+	if (snmp_context->min_fail > snmp_context->mapping_num)
+		snmp_context->min_fail = snmp_context->mapping_num;
+
+	if (0 == snmp_context->level++)
+		snmp_context->max_vars = MAX(snmp_context->mapping_num / 2, 1);
+	else
+		snmp_context->max_vars = 1;
+
+	snmp_context->retries = 0;
+	snmp_context->next_item = snmp_context->mapping[0];
+
+	snmp_get_values_map_next(snmp_context, bulkwalk_context);
+}
+
+static int	snmp_get_values_add_vars(zbx_snmp_context_t *snmp_context, zbx_bulkwalk_context_t *bulkwalk_context,
+		struct snmp_pdu *pdu, char *error, size_t max_error_len)
+{
+	for (int i = 0; i < snmp_context->mapping_num; i++)
+	{
+		const zbx_snmp_oid_t	*p_oid = snmp_context->param_oids.values[snmp_context->mapping[i]];
+
+		if (NULL == snmp_add_null_var(pdu, p_oid->root_oid, p_oid->root_oid_len))
+		{
+			zbx_strlcpy(error, "snmp_add_null_var(): cannot add null variable.", max_error_len);
+			return CONFIG_ERROR;
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets batch item values from GET response                          *
+ *                                                                            *
+ * Return value: SUCCEED - response was processed, failed variables (if any)  *
+ *                         are removed from the next request                  *
+ *               NOTSUPPORTED, NETWORK_ERROR - request failed, the error      *
+ *                         applies to all batch items without result          *
+ *                                                                            *
+ * Comments: Follows the synchronous zbx_snmp_get_values() - variables        *
+ *           rejected with noSuchName error are removed from request, too big *
+ *           or mismatching responses and, after the first request was        *
+ *           reduced, other errors are retried with fewer variables.          *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmp_get_values_handle_response(zbx_snmp_context_t *snmp_context,
+		zbx_bulkwalk_context_t *bulkwalk_context, int status, struct snmp_pdu *response, char *error,
+		size_t max_error_len)
+{
+	struct variable_list	*var;
+	int			i, ret = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() status:%d errstat:%ld mapping_num:%d", __func__, status,
+			STAT_SUCCESS == status ? response->errstat : (long)-1, snmp_context->mapping_num);
+
+	if (STAT_SUCCESS == status && SNMP_ERR_NOERROR == response->errstat)
+	{
+		zbx_snmp_format_opts_t	bulk_opts;
+
+		for (i = 0, var = response->variables; NULL != var; var = var->next_variable)
+			i++;
+
+		if (i != snmp_context->mapping_num)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains too %s variable bindings",
+					snmp_context->item.host, i > snmp_context->mapping_num ? "many" : "few");
+
+			/* give device a chance to handle a smaller request */
+			if (1 != snmp_context->mapping_num)
+			{
+				snmp_get_values_halve(snmp_context, bulkwalk_context);
+				goto out;
+			}
+
+			zbx_snprintf(error, max_error_len, "Invalid SNMP response: too %s variable bindings.",
+					i > snmp_context->mapping_num ? "many" : "few");
+
+			ret = NOTSUPPORTED;
+			goto out;
+		}
+
+		/* check that response variable bindings match the request variable bindings */
+		for (i = 0, var = response->variables; NULL != var; i++, var = var->next_variable)
+		{
+			const zbx_snmp_oid_t	*p_oid = snmp_context->param_oids.values[snmp_context->mapping[i]];
+			char			sent_oid[ZBX_ITEM_SNMP_OID_LEN_MAX],
+						received_oid[ZBX_ITEM_SNMP_OID_LEN_MAX];
+
+			if (p_oid->root_oid_len == var->name_length &&
+					0 == memcmp(p_oid->root_oid, var->name, p_oid->root_oid_len * sizeof(oid)))
+			{
+				continue;
+			}
+
+			zbx_snmp_dump_oid(sent_oid, sizeof(sent_oid), p_oid->root_oid, p_oid->root_oid_len);
+			zbx_snmp_dump_oid(received_oid, sizeof(received_oid), var->name, var->name_length);
+
+			if (1 != snmp_context->mapping_num)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains variable bindings"
+						" that do not match the request: sent \"%s\", received \"%s\"",
+						snmp_context->item.host, sent_oid, received_oid);
+
+				/* give device a chance to handle a smaller request */
+				snmp_get_values_halve(snmp_context, bulkwalk_context);
+				goto out;
+			}
+
+			zabbix_log(LOG_LEVEL_DEBUG, "SNMP response from host \"%s\" contains variable bindings"
+					" that do not match the request: sent \"%s\", received \"%s\"",
+					snmp_context->item.host, sent_oid, received_oid);
+		}
+
+		/* values are formatted in the same way as by synchronous pollers, not as walk results */
+		if (1 == zbx_snmp_init_bulkwalk_done)
+		{
+			snmp_bulkwalk_get_options(&bulk_opts);
+			snmp_bulkwalk_set_options(&default_opts);
+		}
+
+		for (i = 0, var = response->variables; NULL != var; i++, var = var->next_variable)
+		{
+			zbx_dc_item_context_t	*item = &snmp_context->batch_items[snmp_context->mapping[i]];
+			unsigned char		val_type;
+
+			item->ret = zbx_snmp_set_result(var, &item->result, &val_type, ZBX_ASN_OCTET_STR_HEX);
+
+			if (ZBX_ISSET_TEXT(&item->result) && ZBX_SNMP_STR_HEX == val_type)
+				zbx_remove_chars(item->result.text, "\r\n");
+		}
+
+		if (1 == zbx_snmp_init_bulkwalk_done)
+			snmp_bulkwalk_set_options(&bulk_opts);
+
+		if (snmp_context->max_succeed < snmp_context->mapping_num)
+			snmp_context->max_succeed = snmp_context->mapping_num;
+
+		snmp_get_values_map_next(snmp_context, bulkwalk_context);
+	}
+	else if (STAT_SUCCESS == status && SNMP_ERR_NOSUCHNAME == response->errstat && 0 != response->errindex)
+	{
+		/* SNMPv1 agents reject the whole request because of a single unknown variable, */
+		/* so the variable is removed and the rest are requested again                  */
+		zbx_dc_item_context_t	*item;
+
+		if (0 > (i = (int)response->errindex - 1) || i >= snmp_context->mapping_num)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains an out of bounds error"
+					" index: %ld", snmp_context->item.host, response->errindex);
+
+			zbx_strlcpy(error, "Invalid SNMP response: error index out of bounds.", max_error_len);
+
+			ret = NOTSUPPORTED;
+			goto out;
+		}
+
+		item = &snmp_context->batch_items[snmp_context->mapping[i]];
+		item->ret = zbx_get_snmp_response_error(snmp_context->ssp, &item->interface, status, response, error,
+				max_error_len, 0);
+		SET_MSG_RESULT(&item->result, zbx_strdup(NULL, error));
+		*error = '\0';
+
+		snmp_context->next_item = snmp_context->mapping[0];
+		snmp_get_values_map_next(snmp_context, bulkwalk_context);
+	}
+	else if (1 < snmp_context->mapping_num && ((STAT_SUCCESS == status && SNMP_ERR_TOOBIG == response->errstat) ||
+			0 != snmp_context->level))
+	{
+		snmp_get_values_halve(snmp_context, bulkwalk_context);
+	}
+	else
+	{
+		ret = zbx_get_snmp_response_error(snmp_context->ssp, &snmp_context->item.interface, status, response,
+				error, max_error_len, 0);
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s running:%d next_item:%d max_vars:%d", __func__,
+			zbx_result_string(ret), bulkwalk_context->running, snmp_context->next_item,
+			snmp_context->max_vars);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: sets task error to batch items without result and updates         *
+ *          interface bulk request statistics                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_get_values_finish(zbx_snmp_context_t *snmp_context)
+{
+	for (int i = 0; i < snmp_context->batch_items_num; i++)
+	{
+		zbx_dc_item_context_t	*item = &snmp_context->batch_items[i];
+
+		if (0 != ZBX_ISSET_VALUE(&item->result) || 0 != ZBX_ISSET_MSG(&item->result))
+			continue;
+
+		if (SUCCEED == snmp_context->item.ret)
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			item->ret = NOTSUPPORTED;
+			SET_MSG_RESULT(&item->result, zbx_strdup(NULL, "No value received."));
+			continue;
+		}
+
+		item->ret = snmp_context->item.ret;
+
+		if (0 != ZBX_ISSET_MSG(&snmp_context->item.result))
+			SET_MSG_RESULT(&item->result, zbx_strdup(NULL, snmp_context->item.result.msg));
+		else
+			SET_MSG_RESULT(&item->result, zbx_strdup(NULL, "Cannot retrieve SNMP value."));
+	}
+
+	if (SUCCEED == snmp_context->item.ret && SNMP_BULK_ENABLED == snmp_context->bulk &&
+			(0 != snmp_context->max_succeed || ZBX_MAX_SNMP_ITEMS + 1 != snmp_context->min_fail))
+	{
+		zbx_dc_config_update_interface_snmp_stats(snmp_context->item.interface.interfaceid,
+				snmp_context->max_succeed, snmp_context->min_fail);
+	}
+}
+
 static int	asynch_response(int operation, struct snmp_session *sp, int reqid, struct snmp_pdu *pdu, void *magic)
 {
 	zbx_bulkwalk_context_t	*bulkwalk_context;
@@ -2791,7 +3073,18 @@ static int	asynch_response(int operation, struct snmp_session *sp, int reqid, st
 			goto out;
 	}
 
-	if (NULL != pdu)
+	if (NULL != pdu && ZBX_SNMP_GET_VALUES == snmp_context->snmp_oid_type)
+	{
+		char	error[MAX_STRING_LEN];
+
+		if (SUCCEED != (ret = snmp_get_values_handle_response(snmp_context, bulkwalk_context, stat, pdu, error,
+				sizeof(error))))
+		{
+			snmp_context->item.ret = ret;
+			bulkwalk_context->error = zbx_strdup(bulkwalk_context->error, error);
+		}
+	}
+	else if (NULL != pdu)
 	{
 		char	error[MAX_STRING_LEN];
 
@@ -2904,7 +3197,16 @@ static int	snmp_bulkwalk_add(zbx_snmp_context_t *snmp_context, int *fd, char *er
 			pdu->max_repetitions = snmp_context->snmp_max_repetitions;
 		}
 
-		if (NULL == snmp_add_null_var(pdu, bulkwalk_context->name, bulkwalk_context->name_length))
+		if (ZBX_SNMP_GET_VALUES == snmp_context->snmp_oid_type)
+		{
+			if (SUCCEED != (ret = snmp_get_values_add_vars(snmp_context, bulkwalk_context, pdu, error,
+					max_error_len)))
+			{
+				snmp_free_pdu(pdu);
+				goto out;
+			}
+		}
+		else if (NULL == snmp_add_null_var(pdu, bulkwalk_context->name, bulkwalk_context->name_length))
 		{
 			zbx_strlcpy(error, "snmp_add_null_var(): cannot add null variable.", max_error_len);
 			ret = CONFIG_ERROR;
@@ -2921,9 +3223,20 @@ static int	snmp_bulkwalk_add(zbx_snmp_context_t *snmp_context, int *fd, char *er
 	if (0 == (bulkwalk_context->reqid = snmp_sess_async_send(snmp_context->ssp, pdu, asynch_response,
 			bulkwalk_context)))
 	{
+		snmp_free_pdu(pdu);
+
+		/* SNMPv3 request that exceeds device "msgMaxSize" is retried with half of variables */
+		if (ZBX_SNMP_GET_VALUES == snmp_context->snmp_oid_type && 0 == snmp_context->probe &&
+				1 < snmp_context->mapping_num &&
+				SNMPERR_TOO_LONG == snmp_sess_session(snmp_context->ssp)->s_snmp_errno)
+		{
+			snmp_get_values_halve(snmp_context, bulkwalk_context);
+
+			return snmp_bulkwalk_add(snmp_context, fd, error, max_error_len);
+		}
+
 		ret = zbx_get_snmp_response_error(snmp_context->ssp, &snmp_context->item.interface, STAT_ERROR, NULL,
 				error, max_error_len, 0);
-		snmp_free_pdu(pdu);
 		goto out;
 	}
 
@@ -2958,8 +3271,6 @@ out:
 	return ret;
 }
 
-static ZBX_THREAD_LOCAL zbx_snmp_format_opts_t	default_opts;
-
 void	zbx_set_snmp_bulkwalk_options(const char *progname)
 {
 	zbx_snmp_format_opts_t	bulk_opts;
@@ -3053,6 +3364,31 @@ static int	snmp_task_process(short event, void *data, int *fd, const char *addr,
 			}
 		}
 
+		if (ZBX_SNMP_GET_VALUES == snmp_context->snmp_oid_type)
+		{
+			if (0 == snmp_context->probe && 1 < snmp_context->mapping_num)
+			{
+				/* some devices do not respond to requests with too many variables */
+				struct timeval	tv = {snmp_context->config_timeout, 0};
+
+				snmp_get_values_halve(snmp_context, bulkwalk_context);
+
+				zabbix_log(LOG_LEVEL_DEBUG, "cannot receive response for itemid:" ZBX_FS_UI64
+						" from [[%s]:%hu]: timed out, retrying with %d variables",
+						snmp_context->item.itemid, snmp_context->item.interface.addr,
+						snmp_context->item.interface.port, snmp_context->max_vars);
+
+				evtimer_add(timeout_event, &tv);
+				goto send;
+			}
+
+			snmp_context->item.ret = zbx_get_snmp_response_error(snmp_context->ssp,
+					&snmp_context->item.interface, STAT_TIMEOUT, NULL, error, sizeof(error),
+					snmp_context->max_succeed);
+			SET_MSG_RESULT(&snmp_context->item.result, zbx_strdup(NULL, error));
+			goto stop;
+		}
+
 		char		buffer[MAX_OID_LEN];
 		const char	*err_detail;
 
@@ -3160,13 +3496,29 @@ static int	snmp_task_process(short event, void *data, int *fd, const char *addr,
 
 		if (NULL != bulkwalk_context->error)
 		{
-			snmp_context->item.ret = NOTSUPPORTED;
+			/* batch request error code is set by response handler */
+			if (ZBX_SNMP_GET_VALUES != snmp_context->snmp_oid_type)
+				snmp_context->item.ret = NOTSUPPORTED;
+
 			SET_MSG_RESULT(&snmp_context->item.result, bulkwalk_context->error);
 			bulkwalk_context->error = NULL;
 			goto stop;
 		}
 
-		if (0 == bulkwalk_context->running)
+		if (ZBX_SNMP_GET_VALUES == snmp_context->snmp_oid_type)
+		{
+			struct timeval	tv = {snmp_context->config_timeout, 0};
+
+			if (0 == bulkwalk_context->running)
+			{
+				snmp_context->item.ret = SUCCEED;
+				goto stop;
+			}
+
+			/* each request of the batch is limited by item timeout rather than the whole batch */
+			evtimer_add(timeout_event, &tv);
+		}
+		else if (0 == bulkwalk_context->running)
 		{
 			if (0 == bulkwalk_context->vars_num && SNMP_MSG_GETBULK == bulkwalk_context->pdu_type)
 			{
@@ -3214,6 +3566,7 @@ static int	snmp_task_process(short event, void *data, int *fd, const char *addr,
 		}
 	}
 
+send:
 	if (SUCCEED != (ret = snmp_bulkwalk_add(snmp_context, fd, error, sizeof(error))))
 	{
 		snmp_context->item.ret = ret;
@@ -3222,6 +3575,9 @@ static int	snmp_task_process(short event, void *data, int *fd, const char *addr,
 	else
 		task_ret = ZBX_ASYNC_TASK_READ;
 stop:
+	if (ZBX_ASYNC_TASK_STOP == task_ret && ZBX_SNMP_GET_VALUES == snmp_context->snmp_oid_type)
+		snmp_get_values_finish(snmp_context);
+
 	snmp_error = snmp_api_errstring(SNMPERR_SUCCESS);
 
 	if ('\0' != *snmp_error)
@@ -3249,6 +3605,13 @@ zbx_dc_item_context_t	*zbx_async_check_snmp_get_item_context(zbx_snmp_context_t
 	return &snmp_context->item;
 }
 
+zbx_dc_item_context_t	*zbx_async_check_snmp_get_batch_items(zbx_snmp_context_t *snmp_context, int *num)
+{
+	*num = snmp_context->batch_items_num;
+
+	return snmp_context->batch_items;
+}
+
 char	*zbx_async_check_snmp_get_reverse_dns(zbx_snmp_context_t *snmp_context)
 {
 	return snmp_context->reverse_dns;
@@ -3276,6 +3639,15 @@ void	zbx_async_check_snmp_clean(zbx_snmp_context_t *snmp_context)
 	zbx_free(snmp_context->reverse_dns);
 	zbx_free_agent_result(&snmp_context->item.result);
 
+	for (int i = 0; i < snmp_context->batch_items_num; i++)
+	{
+		zbx_free(snmp_context->batch_items[i].key);
+		zbx_free(snmp_context->batch_items[i].key_orig);
+		zbx_free_agent_result(&snmp_context->batch_items[i].result);
+	}
+
+	zbx_free(snmp_context->batch_items);
+
 	zbx_vector_bulkwalk_context_clear_ext(&snmp_context->bulkwalk_contexts, snmp_bulkwalk_context_free);
 	zbx_vector_bulkwalk_context_destroy(&snmp_context->bulkwalk_contexts);
 	zbx_vector_snmp_oid_clear_ext(&snmp_context->param_oids, vector_snmp_oid_free);
@@ -3283,18 +3655,35 @@ void	zbx_async_check_snmp_clean(zbx_snmp_context_t *snmp_context)
 	zbx_free(snmp_context);
 }
 
-int	zbx_async_check_snmp(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_async_task_clear_cb_t clear_cb,
-		void *arg, void *arg_action, struct event_base *base, struct evdns_base *dnsbase,
+static void	snmp_item_context_init(zbx_dc_item_context_t *item_context, zbx_dc_item_t *item)
+{
+	item_context->interface = item->interface;
+	item_context->interface.addr = (item->interface.addr == item->interface.dns_orig ?
+			item_context->interface.dns_orig : item_context->interface.ip_orig);
+	zbx_strlcpy(item_context->host, item->host.host, sizeof(item_context->host));
+	item_context->itemid = item->itemid;
+	item_context->hostid = item->host.hostid;
+	item_context->value_type = item->value_type;
+	item_context->flags = item->flags;
+	item_context->key_orig = zbx_strdup(NULL, item->key_orig);
+
+	if (item->key != item->key_orig)
+	{
+		item_context->key = item->key;
+		item->key = NULL;
+	}
+	else
+		item_context->key = zbx_strdup(NULL, item->key);
+
+	item_context->version = item->interface.version;
+
+	zbx_init_agent_result(&item_context->result);
+}
+
+static zbx_snmp_context_t	*snmp_context_create(zbx_dc_item_t *item, void *arg, void *arg_action,
 		const char *config_source_ip, zbx_async_resolve_reverse_dns_t resolve_reverse_dns, int retries)
 {
-	int			ret = SUCCEED, pdu_type, is_oid_plain = 0;
-	AGENT_REQUEST		request;
 	zbx_snmp_context_t	*snmp_context;
-	char			error[MAX_STRING_LEN];
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s' host:'%s' addr:'%s' timeout:%d retries:%d max_repetitions:%d",
-			__func__, item->key, item->host.host, item->interface.addr, item->timeout, retries,
-			item->snmp_max_repetitions);
 
 	snmp_context = zbx_malloc(NULL, sizeof(zbx_snmp_context_t));
 
@@ -3303,27 +3692,7 @@ int	zbx_async_check_snmp(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_async_ta
 	snmp_context->reverse_dns = NULL;
 
 	snmp_context->ssp = NULL;
-	snmp_context->item.interface = item->interface;
-	snmp_context->item.interface.addr = (item->interface.addr == item->interface.dns_orig ?
-			snmp_context->item.interface.dns_orig : snmp_context->item.interface.ip_orig);
-	zbx_strlcpy(snmp_context->item.host, item->host.host, sizeof(snmp_context->item.host));
-	snmp_context->item.itemid = item->itemid;
-	snmp_context->item.hostid = item->host.hostid;
-	snmp_context->item.value_type = item->value_type;
-	snmp_context->item.flags = item->flags;
-	snmp_context->item.key_orig = zbx_strdup(NULL, item->key_orig);
-
-	if (item->key != item->key_orig)
-	{
-		snmp_context->item.key = item->key;
-		item->key = NULL;
-	}
-	else
-		snmp_context->item.key = zbx_strdup(NULL, item->key);
-
-	snmp_context->item.version = item->interface.version;
-
-	zbx_init_agent_result(&snmp_context->item.result);
+	snmp_item_context_init(&snmp_context->item, item);
 
 	snmp_context->config_timeout = item->timeout;
 
@@ -3352,10 +3721,38 @@ int	zbx_async_check_snmp(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_async_ta
 	item->snmpv3_privpassphrase = NULL;
 	snmp_context->config_source_ip = config_source_ip;
 
+	snmp_context->batch_items = NULL;
+	snmp_context->batch_items_num = 0;
+	snmp_context->next_item = 0;
+	snmp_context->mapping_num = 0;
+	snmp_context->max_vars = 1;
+	snmp_context->level = 0;
+	snmp_context->max_succeed = 0;
+	snmp_context->min_fail = ZBX_MAX_SNMP_ITEMS + 1;
+	snmp_context->bulk = SNMP_BULK_DISABLED;
+
 	zbx_vector_bulkwalk_context_create(&snmp_context->bulkwalk_contexts);
+	zbx_vector_snmp_oid_create(&snmp_context->param_oids);
+
+	return snmp_context;
+}
+
+int	zbx_async_check_snmp(zbx_dc_item_t *item, AGENT_RESULT *result, zbx_async_task_clear_cb_t clear_cb,
+		void *arg, void *arg_action, struct event_base *base, struct evdns_base *dnsbase,
+		const char *config_source_ip, zbx_async_resolve_reverse_dns_t resolve_reverse_dns, int retries)
+{
+	int			ret = SUCCEED, pdu_type, is_oid_plain = 0;
+	AGENT_REQUEST		request;
+	zbx_snmp_context_t	*snmp_context;
+	char			error[MAX_STRING_LEN];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() key:'%s' host:'%s' addr:'%s' timeout:%d retries:%d max_repetitions:%d",
+			__func__, item->key, item->host.host, item->interface.addr, item->timeout, retries,
+			item->snmp_max_repetitions);
+
+	snmp_context = snmp_context_create(item, arg, arg_action, config_source_ip, resolve_reverse_dns, retries);
 
 	zbx_init_agent_request(&request);
-	zbx_vector_snmp_oid_create(&snmp_context->param_oids);
 
 	if (0 == strncmp(item->snmp_oid, "walk[", ZBX_CONST_STRLEN("walk[")))
 	{
@@ -3446,6 +3843,123 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: requests values of SNMP items with plain OIDs of the same         *
+ *          interface asynchronously, combining OIDs into GET requests        *
+ *                                                                            *
+ * Parameters: items            - [IN] items of the same interface            *
+ *             results          - [OUT] results of items that were not added  *
+ *                                      to request                            *
+ *             errcodes         - [OUT] item error codes                      *
+ *             num              - [IN] number of items                        *
+ *             clear_cb         - [IN] callback to process and free request   *
+ *                                     context                                *
+ *             arg              - [IN] callback argument                      *
+ *             arg_action       - [IN] poller configuration                   *
+ *             base             - [IN] event base                             *
+ *             dnsbase          - [IN] DNS event base                         *
+ *             config_source_ip - [IN]                                        *
+ *             retries          - [IN] number of request retries              *
+ *                                                                            *
+ * Return value: SUCCEED - request task was added, items with SUCCEED error   *
+ *                         code are processed by clear callback               *
+ *               FAIL    - none of items can be requested                     *
+ *                                                                            *
+ * Comments: Number of variables per request is suggested by configuration    *
+ *           cache and adjusted by responses in the same way as synchronous   *
+ *           pollers do. Requests are sent one after another, so a device is  *
+ *           never queried by more than one request of the batch at a time.   *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_async_check_snmp_get_values(zbx_dc_item_t **items, AGENT_RESULT **results, int *errcodes, int num,
+		zbx_async_task_clear_cb_t clear_cb, void *arg, void *arg_action, struct event_base *base,
+		struct evdns_base *dnsbase, const char *config_source_ip, int retries)
+{
+	zbx_snmp_context_t	*snmp_context = NULL;
+	zbx_bulkwalk_context_t	*bulkwalk_context;
+	zbx_vector_snmp_oid_t	oids;
+	int			ret = FAIL;
+	char			error[MAX_STRING_LEN];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' num:%d", __func__, items[0]->host.host,
+			items[0]->interface.addr, num);
+
+	zbx_vector_snmp_oid_create(&oids);
+
+	for (int i = 0; i < num; i++)
+	{
+		zbx_dc_item_context_t	*item_context;
+
+		if (0 != zbx_num_key_param(items[i]->snmp_oid))
+		{
+			SET_MSG_RESULT(results[i], zbx_dsprintf(NULL, "OID \"%s\" contains unsupported parameters.",
+					items[i]->snmp_oid));
+			errcodes[i] = CONFIG_ERROR;
+			continue;
+		}
+
+		if (SUCCEED != snmp_bulkwalk_parse_param(items[i]->snmp_oid, &oids, error, sizeof(error)))
+		{
+			SET_MSG_RESULT(results[i], zbx_strdup(NULL, error));
+			errcodes[i] = CONFIG_ERROR;
+			continue;
+		}
+
+		if (NULL == snmp_context)
+		{
+			snmp_context = snmp_context_create(items[i], arg, arg_action, config_source_ip,
+					ZABBIX_ASYNC_RESOLVE_REVERSE_DNS_NO, retries);
+
+			snmp_context->snmp_oid_type = ZBX_SNMP_GET_VALUES;
+			snmp_context->probe = ZBX_IF_SNMP_VERSION_3 == items[i]->snmp_version ? 1 : 0;
+			snmp_context->item.ret = NOTSUPPORTED;
+			snmp_context->batch_items = (zbx_dc_item_context_t *)zbx_malloc(NULL,
+					sizeof(zbx_dc_item_context_t) * (size_t)(num - i));
+		}
+
+		item_context = &snmp_context->batch_items[snmp_context->batch_items_num++];
+		snmp_item_context_init(item_context, items[i]);
+		item_context->ret = NOTSUPPORTED;
+
+		/* key of the first item is already owned by request context */
+		if (NULL == item_context->key)
+			item_context->key = zbx_strdup(NULL, snmp_context->item.key);
+
+		zbx_vector_snmp_oid_append(&snmp_context->param_oids, oids.values[oids.values_num - 1]);
+
+		if (snmp_context->config_timeout < items[i]->timeout)
+			snmp_context->config_timeout = items[i]->timeout;
+
+		errcodes[i] = SUCCEED;
+	}
+
+	if (NULL == snmp_context)
+		goto out;
+
+	snmp_context->max_vars = zbx_dc_config_get_suggested_snmp_vars(snmp_context->item.interface.interfaceid,
+			&snmp_context->bulk);
+	snmp_context->max_vars = MIN(snmp_context->max_vars, ZBX_MAX_SNMP_ITEMS);
+
+	bulkwalk_context = snmp_bulkwalk_context_create(snmp_context, SNMP_MSG_GET,
+			snmp_context->param_oids.values[0]);
+	zbx_vector_bulkwalk_context_append(&snmp_context->bulkwalk_contexts, bulkwalk_context);
+
+	snmp_get_values_map_next(snmp_context, bulkwalk_context);
+
+	zbx_async_poller_add_task(base, dnsbase, snmp_context->item.interface.addr, snmp_context,
+			snmp_context->config_timeout, snmp_task_process, clear_cb);
+
+	ret = SUCCEED;
+out:
+	/* parsed OIDs are owned by request context */
+	zbx_vector_snmp_oid_destroy(&oids);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 static int	zbx_snmp_process_dynamic(zbx_snmp_sess_t ssp, const zbx_dc_item_t *items, AGENT_RESULT *results,
 		int *errcodes, int num, char *error, size_t max_error_len, int *max_succeed, int *min_fail, int bulk,
 		unsigned char poller_type)
@@ -1187,6 +1187,334 @@ out:
 	return ret;
 }
 
+/* compiled preprocessing step */
+typedef struct
+{
+	int		type;
+	unsigned char	compiled;	/* 1 if step parameters were pre-parsed */
+	int		fused_num;	/* number of steps, starting with this one, executed in single pass */
+
+	union
+	{
+		zbx_jsonpath_t	jsonpath;
+
+		struct
+		{
+			double		dbl;
+			zbx_uint64_t	ui64;
+			unsigned char	is_ui64;
+		}
+		multiplier;
+	}
+	data;
+}
+zbx_pp_pipeline_step_t;
+
+struct zbx_pp_pipeline
+{
+	int			steps_num;
+	zbx_pp_pipeline_step_t	*steps;
+};
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free compiled preprocessing pipeline                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_pipeline_free(zbx_pp_pipeline_t *pipeline)
+{
+	for (int i = 0; i < pipeline->steps_num; i++)
+	{
+		if (ZBX_PREPROC_JSONPATH == pipeline->steps[i].type && 0 != pipeline->steps[i].compiled)
+			zbx_jsonpath_clear(&pipeline->steps[i].data.jsonpath);
+	}
+
+	zbx_free(pipeline->steps);
+	zbx_free(pipeline);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pre-parse preprocessing step parameters                           *
+ *                                                                            *
+ * Parameters: step  - [IN] preprocessing step                                *
+ *             cstep - [OUT] compiled step                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the step was compiled                              *
+ *               FAIL    - the step must be interpreted                       *
+ *                                                                            *
+ * Comments: Steps with user macros in parameters are not compiled because    *
+ *           the macros are resolved during execution.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_pipeline_compile_step(const zbx_pp_step_t *step, zbx_pp_pipeline_step_t *cstep)
+{
+	char	buffer[MAX_STRING_LEN];
+
+	memset(cstep, 0, sizeof(zbx_pp_pipeline_step_t));
+	cstep->type = step->type;
+
+	switch (step->type)
+	{
+		case ZBX_PREPROC_MULTIPLIER:
+			if (NULL != strstr(step->params, "{$"))
+				return FAIL;
+
+			/* parse multiplier in the same way as pp_execute_multiply() does */
+			zbx_strlcpy(buffer, step->params, sizeof(buffer));
+			zbx_trim_float(buffer);
+
+			if (FAIL == zbx_is_double(buffer, NULL))
+				return FAIL;
+
+			cstep->data.multiplier.dbl = atof(buffer);
+			if (SUCCEED == zbx_is_uint64(buffer, &cstep->data.multiplier.ui64))
+				cstep->data.multiplier.is_ui64 = 1;
+			break;
+		case ZBX_PREPROC_JSONPATH:
+			if (NULL != strstr(step->params, "{$"))
+				return FAIL;
+
+			if (FAIL == zbx_jsonpath_compile(step->params, &cstep->data.jsonpath))
+				return FAIL;
+			break;
+		case ZBX_PREPROC_DELTA_VALUE:
+		case ZBX_PREPROC_DELTA_SPEED:
+			break;
+		default:
+			return FAIL;
+	}
+
+	cstep->compiled = 1;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile item preprocessing steps                                  *
+ *                                                                            *
+ * Parameters: preproc - [IN/OUT] item preprocessing data                     *
+ *                                                                            *
+ * Comments: Step chains matching [jsonpath] [multiplier...] [delta] pattern  *
+ *           are fused and executed in single pass without copying the        *
+ *           intermediate values. Delta can only be the last step of fused    *
+ *           chain, so the preprocessing history is updated only after all    *
+ *           fused steps have succeeded.                                      *
+ *                                                                            *
+ *           This function must be called before the preprocessing data is    *
+ *           shared with workers.                                             *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_pipeline_compile(zbx_pp_item_preproc_t *preproc)
+{
+	zbx_pp_pipeline_t	*pipeline;
+	int			i, j;
+
+	pipeline = (zbx_pp_pipeline_t *)zbx_malloc(NULL, sizeof(zbx_pp_pipeline_t));
+	pipeline->steps_num = preproc->steps_num;
+	pipeline->steps = (zbx_pp_pipeline_step_t *)zbx_malloc(NULL,
+			sizeof(zbx_pp_pipeline_step_t) * (size_t)preproc->steps_num);
+
+	for (i = 0; i < preproc->steps_num; i++)
+		(void)pp_pipeline_compile_step(preproc->steps + i, pipeline->steps + i);
+
+	for (i = 0; i < preproc->steps_num; i++)
+	{
+		if (0 == pipeline->steps[i].compiled)
+			continue;
+
+		j = i;
+
+		if (ZBX_PREPROC_JSONPATH == preproc->steps[j].type)
+			j++;
+
+		while (j < preproc->steps_num && 0 != pipeline->steps[j].compiled &&
+				ZBX_PREPROC_MULTIPLIER == preproc->steps[j].type)
+		{
+			j++;
+		}
+
+		if (j < preproc->steps_num && 0 != pipeline->steps[j].compiled &&
+				(ZBX_PREPROC_DELTA_VALUE == preproc->steps[j].type ||
+				ZBX_PREPROC_DELTA_SPEED == preproc->steps[j].type))
+		{
+			j++;
+		}
+
+		/* single delta step has nothing to gain from compilation */
+		if (1 == j - i && (ZBX_PREPROC_DELTA_VALUE == preproc->steps[i].type ||
+				ZBX_PREPROC_DELTA_SPEED == preproc->steps[i].type))
+		{
+			continue;
+		}
+
+		pipeline->steps[i].fused_num = j - i;
+	}
+
+	preproc->pipeline = pipeline;
+	preproc->pipeline_free = pp_pipeline_free;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute fused preprocessing steps in single pass                  *
+ *                                                                            *
+ * Parameters: preproc     - [IN] item preprocessing data                     *
+ *             index       - [IN] index of the first step to execute          *
+ *             value       - [IN/OUT] input/output value                      *
+ *             ts          - [IN] value timestamp                             *
+ *             history_in  - [IN] historical (previous) data                  *
+ *             history_out - [OUT] historical (next) data                     *
+ *             results     - [OUT] step results                               *
+ *                                                                            *
+ * Return value: The number of executed steps or 0 if the steps must be       *
+ *               executed one by one. In the last case value, history and     *
+ *               results are left unchanged, so the interpreted execution can *
+ *               produce the same error message and apply error handlers.     *
+ *                                                                            *
+ ******************************************************************************/
+static int	pp_pipeline_execute(const zbx_pp_item_preproc_t *preproc, int index, zbx_variant_t *value,
+		zbx_timespec_t ts, const zbx_pp_history_t *history_in, zbx_pp_history_t *history_out,
+		zbx_pp_result_t *results)
+{
+	const zbx_pp_pipeline_step_t	*cstep = preproc->pipeline->steps + index;
+	const zbx_variant_t		*value_src = value;
+	zbx_variant_t			value_str, value_num, history_value_out;
+	zbx_timespec_t			history_ts;
+	int				steps_num = cstep->fused_num, i = 0;
+	char				*errmsg = NULL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() step:%d steps:%d", __func__, index, steps_num);
+
+	zbx_variant_set_none(&value_str);
+	zbx_variant_set_none(&value_num);
+	zbx_variant_set_none(&history_value_out);
+
+	if (ZBX_PREPROC_JSONPATH == preproc->steps[index].type)
+	{
+		zbx_jsonobj_t	obj;
+		char		*data = NULL;
+		int		ret;
+
+		if (ZBX_VARIANT_STR != value->type || SUCCEED != zbx_jsonobj_open(value->data.str, &obj))
+			goto fail;
+
+		ret = zbx_jsonobj_query_path(&obj, NULL, &cstep->data.jsonpath, &data);
+		zbx_jsonobj_clear(&obj);
+
+		if (SUCCEED != ret || NULL == data)
+			goto fail;
+
+		zbx_variant_set_str(&value_str, data);
+		value_src = &value_str;
+		i++;
+	}
+
+	for (; i < steps_num; i++)
+	{
+		zbx_variant_t		value_tmp;
+		const zbx_pp_step_t	*step = preproc->steps + index + i;
+
+		/* the numeric conversion matches the one done by each interpreted numeric step */
+		if (FAIL == zbx_item_preproc_convert_value_to_numeric(&value_tmp, value_src, preproc->value_type,
+				&errmsg))
+		{
+			zbx_free(errmsg);
+			goto fail;
+		}
+
+		zbx_variant_clear(&value_num);
+		value_num = value_tmp;
+		value_src = &value_num;
+
+		cstep = preproc->pipeline->steps + index + i;
+
+		switch (step->type)
+		{
+			case ZBX_PREPROC_MULTIPLIER:
+				if (ZBX_VARIANT_DBL == value_num.type)
+				{
+					value_num.data.dbl *= cstep->data.multiplier.dbl;
+				}
+				else if (0 != cstep->data.multiplier.is_ui64)
+				{
+					value_num.data.ui64 *= cstep->data.multiplier.ui64;
+				}
+				else
+				{
+					value_num.data.ui64 = (zbx_uint64_t)((double)value_num.data.ui64 *
+							cstep->data.multiplier.dbl);
+				}
+				break;
+			case ZBX_PREPROC_DELTA_VALUE:
+			case ZBX_PREPROC_DELTA_SPEED:
+			{
+				const zbx_variant_t	*history_value_in;
+				zbx_variant_t		history_none;
+
+				zbx_pp_history_get(history_in, index + i, &history_value_in, &history_ts);
+
+				if (NULL == history_value_in)
+				{
+					zbx_variant_set_none(&history_none);
+					history_value_in = &history_none;
+				}
+
+				if (SUCCEED != item_preproc_delta(preproc->value_type, &value_num, &ts, step->type,
+						history_value_in, &history_value_out, &history_ts, &errmsg))
+				{
+					zbx_free(errmsg);
+					zbx_variant_clear(&history_value_out);
+					goto fail;
+				}
+				break;
+			}
+		}
+
+		results[i].value = value_num;
+	}
+
+	/* the json query result is moved to the results instead of being copied */
+	if (ZBX_VARIANT_NONE != value_str.type)
+	{
+		if (1 == steps_num)
+			zbx_variant_copy(&value_num, &value_str);
+
+		results[0].value = value_str;
+	}
+
+	for (i = 0; i < steps_num; i++)
+	{
+		zbx_variant_set_none(&results[i].value_raw);
+		results[i].action = ZBX_PREPROC_FAIL_DEFAULT;
+	}
+
+	if (ZBX_VARIANT_NONE != history_value_out.type)
+	{
+		if (NULL != history_out)
+			zbx_pp_history_add(history_out, index + steps_num - 1, &history_value_out, history_ts);
+		else
+			zbx_variant_clear(&history_value_out);
+	}
+
+	zbx_variant_clear(value);
+	*value = value_num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() value:%.*s", __func__, PP_VALUE_LOG_LIMIT,
+			zbx_variant_value_desc(value));
+
+	return steps_num;
+fail:
+	/* numeric results are not allocated, only the json query result must be freed */
+	zbx_variant_clear(&value_str);
+	zbx_variant_clear(&value_num);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() falling back to step by step execution", __func__);
+
+	return 0;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: execute preprocessing steps                                       *
@@ -1210,7 +1538,7 @@ void	pp_execute(zbx_pp_context_t *ctx, zbx_pp_item_preproc_t *preproc, zbx_pp_ca
 {
 	zbx_pp_result_t		*results;
 	zbx_pp_history_t	*history_out, *history_in;
-	int			quote_error, results_num, action;
+	int			quote_error, results_num, action, fused_num;
 	zbx_variant_t		value_raw;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s(): value:%.*s type:%s", __func__, PP_VALUE_LOG_LIMIT,
@@ -1266,6 +1594,19 @@ void	pp_execute(zbx_pp_context_t *ctx, zbx_pp_item_preproc_t *preproc, zbx_pp_ca
 		action = ZBX_PREPROC_FAIL_DEFAULT;
 		quote_error = 0;
 
+		if (NULL == cache && NULL != preproc->pipeline && 0 != preproc->pipeline->steps[i].fused_num &&
+				0 != (fused_num = pp_pipeline_execute(preproc, i, value_out, ts, history_in, history_out,
+				results + results_num)))
+		{
+			results_num += fused_num;
+			i += fused_num - 1;
+
+			if (ZBX_VARIANT_NONE == value_out->type)
+				break;
+
+			continue;
+		}
+
 		zbx_variant_set_none(&history_value_out);
 		zbx_pp_history_get(history_in, i, &history_value_in, &history_ts);
 
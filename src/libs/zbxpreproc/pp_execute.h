@@ -43,4 +43,6 @@ int	pp_execute_step(zbx_pp_context_t *ctx, zbx_pp_cache_t *cache, zbx_dc_um_shar
 		zbx_pp_step_t *step, const zbx_variant_t *history_value_last, zbx_variant_t *history_value,
 		zbx_timespec_t *history_ts, const char *config_source_ip);
 
+void	pp_pipeline_compile(zbx_pp_item_preproc_t *preproc);
+
 #endif
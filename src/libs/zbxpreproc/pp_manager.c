@@ -16,13 +16,13 @@
 #include "pp_worker.h"
 #include "pp_queue.h"
 #include "pp_task.h"
+#include "pp_execute.h"
 #include "zbxpreproc.h"
 #include "zbxalgo.h"
 #include "zbxtimekeeper.h"
 #include "zbxself.h"
 #include "zbxstr.h"
 #include "zbxcachehistory.h"
-#include "zbxprof.h"
 #include "pp_protocol.h"
 #include "zbx_item_constants.h"
 #include "zbxnix.h"
@@ -144,7 +144,7 @@ static zbx_pp_manager_t	*zbx_pp_manager_create(int workers_num, zbx_pp_notify_cb
 	manager = (zbx_pp_manager_t *)zbx_malloc(NULL, sizeof(zbx_pp_manager_t));
 	memset(manager, 0, sizeof(zbx_pp_manager_t));
 
-	if (SUCCEED != pp_task_queue_init(&manager->queue, error))
+	if (SUCCEED != pp_task_queue_init(&manager->queue, workers_num, error))
 		goto out;
 
 	manager->timekeeper = zbx_timekeeper_create(workers_num, NULL);
@@ -223,9 +223,9 @@ static void	zbx_pp_manager_free(zbx_pp_manager_t *manager)
 	pp_task_queue_lock(&manager->queue);
 	for (i = 0; i < manager->workers_num; i++)
 		pp_worker_stop(&manager->workers[i]);
+	pp_task_queue_unlock(&manager->queue);
 
 	pp_task_queue_notify_all(&manager->queue);
-	pp_task_queue_unlock(&manager->queue);
 
 	for (i = 0; i < manager->workers_num; i++)
 		pp_worker_destroy(&manager->workers[i]);
@@ -267,10 +267,8 @@ static void	zbx_pp_manager_queue_test(zbx_pp_manager_t *manager, zbx_pp_item_pre
 {
 	zbx_pp_task_t	*task = pp_task_test_create(preproc, value, ts, client);
 
-	pp_task_queue_lock(&manager->queue);
 	pp_task_queue_push_test(&manager->queue, task);
 	pp_task_queue_notify(&manager->queue);
-	pp_task_queue_unlock(&manager->queue);
 }
 
 /******************************************************************************
@@ -280,17 +278,10 @@ static void	zbx_pp_manager_queue_test(zbx_pp_manager_t *manager, zbx_pp_item_pre
  ******************************************************************************/
 static void	zbx_pp_manager_queue_value_preproc(zbx_pp_manager_t *manager, zbx_vector_pp_task_ptr_t *tasks)
 {
-	zbx_prof_start(__func__, ZBX_PROF_MUTEX);
-	pp_task_queue_lock(&manager->queue);
-	zbx_prof_end_wait();
-
 	for (int i = 0; i < tasks->values_num; i++)
 		pp_task_queue_push(&manager->queue, tasks->values[i]);
 
 	pp_task_queue_notify(&manager->queue);
-
-	pp_task_queue_unlock(&manager->queue);
-	zbx_prof_end();
 }
 
 /******************************************************************************
@@ -375,7 +366,7 @@ static zbx_pp_item_t	*pp_manager_get_cacheable_dependent_item(zbx_pp_manager_t *
  *             cache          - [IN] preprocessing cache                      *
  *                                   (optional, can be NULL)                  *
  *                                                                            *
- * Comments: This function called within task queue lock.                     *
+ * Comments: This function is called only by manager thread.                  *
  *                                                                            *
  ******************************************************************************/
 static void	pp_manager_queue_dependents(zbx_pp_manager_t *manager, zbx_pp_item_preproc_t *preproc,
@@ -434,7 +425,7 @@ static void	pp_manager_queue_dependents(zbx_pp_manager_t *manager, zbx_pp_item_p
  * Parameters: manager - [IN] manager                                         *
  *             task    - [IN] finished value task                             *
  *                                                                            *
- * Comments: This function called within task queue lock.                     *
+ * Comments: This function is called only by manager thread.                  *
  *                                                                            *
  ******************************************************************************/
 static void	pp_manager_queue_value_task_result(zbx_pp_manager_t *manager, zbx_pp_task_t *task)
@@ -474,7 +465,7 @@ static void	pp_manager_queue_value_task_result(zbx_pp_manager_t *manager, zbx_pp
  * Parameters: manager - [IN] manager                                         *
  *             task    - [IN] finished dependent task                         *
  *                                                                            *
- * Comments: This function called within task queue lock.                     *
+ * Comments: This function is called only by manager thread.                  *
  *                                                                            *
  ******************************************************************************/
 static zbx_pp_task_t	*pp_manager_queue_dependent_task_result(zbx_pp_manager_t *manager, zbx_pp_task_t *task)
@@ -499,7 +490,7 @@ static zbx_pp_task_t	*pp_manager_queue_dependent_task_result(zbx_pp_manager_t *m
  * Parameters: manager  - [IN] manager                                        *
  *             task_seq - [IN] finished sequence task                         *
  *                                                                            *
- * Comments: This function called within task queue lock.                     *
+ * Comments: This function is called only by manager thread.                  *
  *                                                                            *
  ******************************************************************************/
 static zbx_pp_task_t	*pp_manager_requeue_next_sequence_task(zbx_pp_manager_t *manager, zbx_pp_task_t *task_seq)
@@ -561,9 +552,7 @@ static void	zbx_pp_manager_process_finished(zbx_pp_manager_t *manager, zbx_vecto
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	zbx_vector_pp_task_ptr_reserve(tasks, PP_FINISHED_TASK_BATCH_SIZE);
-	zbx_prof_start(__func__, ZBX_PROF_MUTEX);
-	pp_task_queue_lock(&manager->queue);
-	zbx_prof_end_wait();
+
 	while (PP_FINISHED_TASK_BATCH_SIZE > tasks->values_num)
 	{
 		if (NULL != (task = pp_task_queue_pop_finished(&manager->queue)))
@@ -590,12 +579,8 @@ static void	zbx_pp_manager_process_finished(zbx_pp_manager_t *manager, zbx_vecto
 		zbx_vector_pp_task_ptr_append(tasks, task);
 	}
 
-	*pending_num = manager->queue.pending_num;
-	*finished_num = manager->queue.finished_num;
-	*processing_num = manager->queue.processing_num;
+	pp_task_queue_get_stats(&manager->queue, pending_num, processing_num, finished_num);
 
-	pp_task_queue_unlock(&manager->queue);
-	zbx_prof_end();
 	now = time(NULL);
 	if (now != timekeeper_clock)
 	{
@@ -664,9 +649,10 @@ zbx_hashset_t  *zbx_pp_manager_items(zbx_pp_manager_t *manager)
 static void	zbx_pp_manager_get_diag_stats(zbx_pp_manager_t *manager, zbx_uint64_t *preproc_num,
 		zbx_uint64_t *pending_num, zbx_uint64_t *finished_num, zbx_uint64_t *sequences_num)
 {
+	zbx_uint64_t	processing_num;
+
 	*preproc_num = (zbx_uint64_t)manager->items.num_data;
-	*pending_num = manager->queue.pending_num;
-	*finished_num = manager->queue.finished_num;
+	pp_task_queue_get_stats(&manager->queue, pending_num, &processing_num, finished_num);
 	*sequences_num = (zbx_uint64_t)manager->queue.sequences.num_data;
 }
 
@@ -690,6 +676,38 @@ static void	zbx_pp_manager_get_worker_usage(zbx_pp_manager_t *manager, zbx_vecto
 	(void)zbx_timekeeper_get_usage(manager->timekeeper, worker_usage);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile preprocessing steps of new or changed items               *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *                                                                            *
+ * Comments: Changed items get new preprocessing data from configuration      *
+ *           cache, so only preprocessing data without compiled pipeline must *
+ *           be compiled. The pipeline is compiled before any task            *
+ *           referencing the preprocessing data is queued, so workers can     *
+ *           access it without locking.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_compile_items(zbx_pp_manager_t *manager)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_pp_item_t		*item;
+	int			compiled_num = 0;
+
+	zbx_hashset_iter_reset(&manager->items, &iter);
+	while (NULL != (item = (zbx_pp_item_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL == item->preproc || NULL != item->preproc->pipeline || 0 == item->preproc->steps_num)
+			continue;
+
+		pp_pipeline_compile(item->preproc);
+		compiled_num++;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() compiled:%d", __func__, compiled_num);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: synchronize preprocessing manager with configuration cache data   *
@@ -707,6 +725,9 @@ static void	preprocessor_sync_configuration(zbx_pp_manager_t *manager)
 	zbx_dc_config_get_preprocessable_items(&manager->items, &manager->um_handle, &revision);
 	manager->revision = revision;
 
+	if (revision != old_revision)
+		preprocessor_compile_items(manager);
+
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE) && revision != old_revision)
 		zbx_pp_manager_dump_items(manager);
 
@@ -724,13 +745,10 @@ static void	preprocessor_sync_configuration(zbx_pp_manager_t *manager)
 static void	preproc_item_value_clear(zbx_preproc_item_value_t *value)
 {
 	zbx_free(value->error);
-	zbx_free(value->ts);
 
+	/* timestamp and result are stored in value batch, only result contents must be freed */
 	if (NULL != value->result)
-	{
 		zbx_free_agent_result(value->result);
-		zbx_free(value->result);
-	}
 }
 
 /******************************************************************************
@@ -866,6 +884,7 @@ static zbx_uint64_t	preprocessor_add_request(zbx_pp_manager_t *manager, zbx_ipc_
 	zbx_preproc_item_value_t	value;
 	zbx_uint64_t			queued_num = 0;
 	zbx_vector_pp_task_ptr_t	tasks;
+	zbx_pp_value_batch_t		batch;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -873,6 +892,7 @@ static zbx_uint64_t	preprocessor_add_request(zbx_pp_manager_t *manager, zbx_ipc_
 	zbx_vector_pp_task_ptr_reserve(&tasks, ZBX_PREPROCESSING_BATCH_SIZE);
 
 	preprocessor_sync_configuration(manager);
+	zbx_preprocessor_value_batch_init(&batch);
 
 	while (offset < message->size)
 	{
@@ -881,7 +901,7 @@ static zbx_uint64_t	preprocessor_add_request(zbx_pp_manager_t *manager, zbx_ipc_
 		zbx_timespec_t		ts;
 		zbx_pp_task_t		*task;
 
-		offset += zbx_preprocessor_unpack_value(&value, message->data + offset);
+		offset += zbx_preprocessor_unpack_value(&batch, &value, message->data + offset);
 		preproc_item_value_extract_data(&value, &var, &ts, &var_opt);
 
 		if (NULL == (task = zbx_pp_manager_create_task(manager, value.itemid, &var, ts, &var_opt)))
@@ -939,7 +959,9 @@ static void	preprocessor_add_test_request(zbx_pp_manager_t *manager, zbx_ipc_cli
 
 static void	preprocessor_reply_queue_size(zbx_pp_manager_t *manager, zbx_ipc_client_t *client)
 {
-	zbx_uint64_t	pending_num = manager->queue.pending_num;
+	zbx_uint64_t	pending_num, processing_num, finished_num;
+
+	pp_task_queue_get_stats(&manager->queue, &pending_num, &processing_num, &finished_num);
 
 	zbx_ipc_client_send(client, ZBX_IPC_PREPROCESSOR_QUEUE, (unsigned char *)&pending_num, sizeof(pending_num));
 }
@@ -1254,6 +1276,10 @@ ZBX_THREAD_ENTRY(zbx_pp_manager_thread, args)
 		exit(EXIT_FAILURE);
 	}
 
+	/* values are unpacked right after receiving, so messages can reference pooled receive buffers */
+	zbx_ipc_service_enable_rx_pool(&service);
+	zbx_ipc_service_enable_shm(&service, ZBX_IPC_SHM_RING_SIZE_DEFAULT);
+
 	if (NULL == (manager = zbx_pp_manager_create(pp_args->workers_num, preprocessor_finished_task_cb,
 			(void *)&service, pp_manager_args_in->config_source_ip, pp_manager_args_in->config_timeout,
 			&error)))
@@ -29,7 +29,22 @@
 #define PACKED_FIELD(value, size)	\
 		(zbx_packed_field_t){(value), (size), (0 == (size) ? PACKED_FIELD_STRING : PACKED_FIELD_RAW)}
 
+#define PP_VALUE_TS		0x01
+#define PP_VALUE_ERROR		0x02
+#define PP_VALUE_STATE		0x04
+#define PP_VALUE_RESULT		0x08
+
+#define PP_VALUE_RESULT_TYPES	(AR_UINT64 | AR_DOUBLE | AR_STRING | AR_TEXT | AR_LOG | AR_MESSAGE | AR_META)
+
+/* the cached message buffer is reused between flushes unless it grows larger than this */
+#define PP_VALUE_BUFFER_MAX	ZBX_MEBIBYTE
+
+#define PP_ZIGZAG_ENCODE(v)	(((zbx_uint64_t)(v) << 1) ^ (zbx_uint64_t)((zbx_int64_t)(v) >> 63))
+#define PP_ZIGZAG_DECODE(v)	((zbx_int64_t)((v) >> 1) ^ -(zbx_int64_t)((v) & 1))
+
 static zbx_ipc_message_t	cached_message;
+static zbx_uint32_t		cached_message_alloc;
+static zbx_pp_value_batch_t	cached_batch;
 static int			cached_values;
 
 ZBX_PTR_VECTOR_IMPL(ipcmsg, zbx_ipc_message_t *)
@@ -126,63 +141,276 @@ static zbx_uint32_t	message_pack_data(zbx_ipc_message_t *message, zbx_packed_fie
 
 /******************************************************************************
  *                                                                            *
- * Purpose: pack item value data into a single buffer that can be used in IPC *
- *                                                                            *
- * Parameters: message - [OUT] IPC message                                    *
- *             value   - [IN] value to be packed                              *
- *                                                                            *
- * Return value: size of packed data                                          *
+ * Purpose: initialize value batch encoding/decoding state                    *
  *                                                                            *
  ******************************************************************************/
-static zbx_uint32_t	preprocessor_pack_value(zbx_ipc_message_t *message, zbx_preproc_item_value_t *value)
+void	zbx_preprocessor_value_batch_init(zbx_pp_value_batch_t *batch)
+{
+	memset(batch, 0, sizeof(zbx_pp_value_batch_t));
+}
+
+static size_t	pp_value_str_size(const char *str)
 {
-	zbx_packed_field_t	fields[24], *offset = fields;	/* 24 - max field count */
-	unsigned char		ts_marker, result_marker, log_marker;
+	return ZBX_SERIALIZE_UINT64_COMPACT_MAX + (NULL != str ? strlen(str) : 0);
+}
 
-	ts_marker = (NULL != value->ts);
-	result_marker = (NULL != value->result);
+static zbx_uint32_t	pp_value_pack_str(unsigned char *ptr, const char *str)
+{
+	zbx_uint32_t	offset;
+	size_t		len;
 
-	*offset++ = PACKED_FIELD(&value->itemid, sizeof(zbx_uint64_t));
-	*offset++ = PACKED_FIELD(&value->hostid, sizeof(zbx_uint64_t));
-	*offset++ = PACKED_FIELD(&value->item_value_type, sizeof(unsigned char));
-	*offset++ = PACKED_FIELD(&value->item_flags, sizeof(unsigned char));
-	*offset++ = PACKED_FIELD(&value->state, sizeof(unsigned char));
-	*offset++ = PACKED_FIELD(value->error, 0);
-	*offset++ = PACKED_FIELD(&ts_marker, sizeof(unsigned char));
+	if (NULL == str)
+		return zbx_serialize_uint64_compact(ptr, 0);
 
-	if (NULL != value->ts)
+	len = strlen(str);
+	offset = zbx_serialize_uint64_compact(ptr, (zbx_uint64_t)len + 1);
+	memcpy(ptr + offset, str, len);
+
+	return offset + (zbx_uint32_t)len;
+}
+
+static zbx_uint32_t	pp_value_unpack_str(const unsigned char *ptr, char **str)
+{
+	zbx_uint32_t	offset;
+	zbx_uint64_t	len;
+
+	offset = zbx_deserialize_uint64_compact(ptr, &len);
+
+	if (0 == len)
 	{
-		*offset++ = PACKED_FIELD(&value->ts->sec, sizeof(int));
-		*offset++ = PACKED_FIELD(&value->ts->ns, sizeof(int));
+		*str = NULL;
+		return offset;
 	}
 
-	*offset++ = PACKED_FIELD(&result_marker, sizeof(unsigned char));
+	len--;
+	*str = (char *)zbx_malloc(NULL, (size_t)len + 1);
+	memcpy(*str, ptr + offset, (size_t)len);
+	(*str)[len] = '\0';
+
+	return offset + (zbx_uint32_t)len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculate maximum size of packed item value                       *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	pp_value_size_max(const zbx_preproc_item_value_t *value)
+{
+	/* header, value type, flags, state, itemid, hostid, timestamp */
+	size_t	size = 4 + ZBX_SERIALIZE_UINT64_COMPACT_MAX * 4;
+
+	if (NULL != value->error)
+		size += pp_value_str_size(value->error);
 
 	if (NULL != value->result)
 	{
+		const AGENT_RESULT	*result = value->result;
+
+		/* result type, numeric values and meta information */
+		size += 1 + ZBX_SERIALIZE_UINT64_COMPACT_MAX * 3 + sizeof(double);
+
+		if (0 != ZBX_ISSET_STR(result))
+			size += pp_value_str_size(result->str);
 
-		*offset++ = PACKED_FIELD(&value->result->lastlogsize, sizeof(zbx_uint64_t));
-		*offset++ = PACKED_FIELD(&value->result->ui64, sizeof(zbx_uint64_t));
-		*offset++ = PACKED_FIELD(&value->result->dbl, sizeof(double));
-		*offset++ = PACKED_FIELD(value->result->str, 0);
-		*offset++ = PACKED_FIELD(value->result->text, 0);
-		*offset++ = PACKED_FIELD(value->result->msg, 0);
-		*offset++ = PACKED_FIELD(&value->result->type, sizeof(int));
-		*offset++ = PACKED_FIELD(&value->result->mtime, sizeof(int));
-
-		log_marker = (NULL != value->result->log);
-		*offset++ = PACKED_FIELD(&log_marker, sizeof(unsigned char));
-		if (NULL != value->result->log)
+		if (0 != ZBX_ISSET_TEXT(result))
+			size += pp_value_str_size(result->text);
+
+		if (0 != ZBX_ISSET_MSG(result))
+			size += pp_value_str_size(result->msg);
+
+		if (0 != ZBX_ISSET_LOG(result))
 		{
-			*offset++ = PACKED_FIELD(value->result->log->value, 0);
-			*offset++ = PACKED_FIELD(value->result->log->source, 0);
-			*offset++ = PACKED_FIELD(&value->result->log->timestamp, sizeof(int));
-			*offset++ = PACKED_FIELD(&value->result->log->severity, sizeof(int));
-			*offset++ = PACKED_FIELD(&value->result->log->logeventid, sizeof(int));
+			size += pp_value_str_size(result->log->value) + pp_value_str_size(result->log->source) +
+					ZBX_SERIALIZE_UINT64_COMPACT_MAX * 3;
 		}
 	}
 
-	return message_pack_data(message, fields, (int)(offset - fields));
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pack agent result fields set by result type                       *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	pp_value_pack_result(unsigned char *ptr, const AGENT_RESULT *result)
+{
+	unsigned char	*offset = ptr, type;
+
+	type = (unsigned char)(result->type & PP_VALUE_RESULT_TYPES);
+	*offset++ = type;
+
+	if (0 != (type & AR_UINT64))
+		offset += zbx_serialize_uint64_compact(offset, result->ui64);
+
+	if (0 != (type & AR_DOUBLE))
+		offset += zbx_serialize_double(offset, result->dbl);
+
+	if (0 != (type & AR_STRING))
+		offset += pp_value_pack_str(offset, result->str);
+
+	if (0 != (type & AR_TEXT))
+		offset += pp_value_pack_str(offset, result->text);
+
+	if (0 != (type & AR_LOG))
+	{
+		offset += pp_value_pack_str(offset, result->log->value);
+		offset += pp_value_pack_str(offset, result->log->source);
+		offset += zbx_serialize_uint64_compact(offset, PP_ZIGZAG_ENCODE(result->log->timestamp));
+		offset += zbx_serialize_uint64_compact(offset, PP_ZIGZAG_ENCODE(result->log->severity));
+		offset += zbx_serialize_uint64_compact(offset, PP_ZIGZAG_ENCODE(result->log->logeventid));
+	}
+
+	if (0 != (type & AR_MESSAGE))
+		offset += pp_value_pack_str(offset, result->msg);
+
+	if (0 != (type & AR_META))
+	{
+		offset += zbx_serialize_uint64_compact(offset, result->lastlogsize);
+		offset += zbx_serialize_uint64_compact(offset, PP_ZIGZAG_ENCODE(result->mtime));
+	}
+
+	return (zbx_uint32_t)(offset - ptr);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unpack agent result fields set by result type                     *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	pp_value_unpack_result(const unsigned char *ptr, AGENT_RESULT *result)
+{
+	const unsigned char	*offset = ptr;
+	zbx_uint64_t		value;
+
+	zbx_init_agent_result(result);
+	result->type = *offset++;
+
+	if (0 != ZBX_ISSET_UI64(result))
+		offset += zbx_deserialize_uint64_compact(offset, &result->ui64);
+
+	if (0 != ZBX_ISSET_DBL(result))
+		offset += zbx_deserialize_double(offset, &result->dbl);
+
+	if (0 != ZBX_ISSET_STR(result))
+		offset += pp_value_unpack_str(offset, &result->str);
+
+	if (0 != ZBX_ISSET_TEXT(result))
+		offset += pp_value_unpack_str(offset, &result->text);
+
+	if (0 != ZBX_ISSET_LOG(result))
+	{
+		result->log = (zbx_log_t *)zbx_malloc(NULL, sizeof(zbx_log_t));
+
+		offset += pp_value_unpack_str(offset, &result->log->value);
+		offset += pp_value_unpack_str(offset, &result->log->source);
+		offset += zbx_deserialize_uint64_compact(offset, &value);
+		result->log->timestamp = (int)PP_ZIGZAG_DECODE(value);
+		offset += zbx_deserialize_uint64_compact(offset, &value);
+		result->log->severity = (int)PP_ZIGZAG_DECODE(value);
+		offset += zbx_deserialize_uint64_compact(offset, &value);
+		result->log->logeventid = (int)PP_ZIGZAG_DECODE(value);
+	}
+
+	if (0 != ZBX_ISSET_MSG(result))
+		offset += pp_value_unpack_str(offset, &result->msg);
+
+	if (0 != ZBX_ISSET_META(result))
+	{
+		offset += zbx_deserialize_uint64_compact(offset, &result->lastlogsize);
+		offset += zbx_deserialize_uint64_compact(offset, &value);
+		result->mtime = (int)PP_ZIGZAG_DECODE(value);
+	}
+
+	return (zbx_uint32_t)(offset - ptr);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pack item value into IPC message using compact batch encoding     *
+ *                                                                            *
+ * Parameters: message       - [IN/OUT] IPC message                           *
+ *             message_alloc - [IN/OUT] allocated message data size           *
+ *             batch         - [IN/OUT] batch encoding state                  *
+ *             value         - [IN] value to be packed                        *
+ *                                                                            *
+ * Return value: size of packed data or 0 if the message size would exceed    *
+ *               4GB limit                                                    *
+ *                                                                            *
+ * Comments: The value is packed as:                                          *
+ *             header (PP_VALUE_* flags), value type, item flags,             *
+ *             [state], itemid delta, hostid delta,                           *
+ *             [timestamp seconds delta, nanoseconds], [error],               *
+ *             [result type (AR_* flags), set result fields]                  *
+ *           Integers are stored in variable length encoding, signed values   *
+ *           and deltas are zigzag encoded, strings are prefixed with         *
+ *           length + 1 (0 for NULL strings).                                 *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_preprocessor_pack_value(zbx_ipc_message_t *message, zbx_uint32_t *message_alloc,
+		zbx_pp_value_batch_t *batch, const zbx_preproc_item_value_t *value)
+{
+	size_t		size_max;
+	unsigned char	*ptr, *offset, header = 0;
+
+	size_max = pp_value_size_max(value);
+
+	if (UINT32_MAX - message->size < size_max)
+		return 0;
+
+	if (message->size + size_max > *message_alloc)
+	{
+		size_t	alloc = MAX((size_t)*message_alloc * 2, message->size + size_max);
+
+		*message_alloc = (zbx_uint32_t)MIN(alloc, UINT32_MAX);
+		message->data = (unsigned char *)zbx_realloc(message->data, *message_alloc);
+	}
+
+	ptr = offset = message->data + message->size;
+
+	if (NULL != value->ts)
+		header |= PP_VALUE_TS;
+
+	if (NULL != value->error)
+		header |= PP_VALUE_ERROR;
+
+	if (ITEM_STATE_NORMAL != value->state)
+		header |= PP_VALUE_STATE;
+
+	if (NULL != value->result)
+		header |= PP_VALUE_RESULT;
+
+	*offset++ = header;
+	*offset++ = value->item_value_type;
+	*offset++ = value->item_flags;
+
+	if (0 != (header & PP_VALUE_STATE))
+		*offset++ = value->state;
+
+	offset += zbx_serialize_uint64_compact(offset, PP_ZIGZAG_ENCODE(value->itemid - batch->itemid));
+	batch->itemid = value->itemid;
+
+	offset += zbx_serialize_uint64_compact(offset, PP_ZIGZAG_ENCODE(value->hostid - batch->hostid));
+	batch->hostid = value->hostid;
+
+	if (NULL != value->ts)
+	{
+		offset += zbx_serialize_uint64_compact(offset, PP_ZIGZAG_ENCODE((zbx_int64_t)value->ts->sec -
+				batch->sec));
+		offset += zbx_serialize_uint64_compact(offset, (zbx_uint64_t)value->ts->ns);
+		batch->sec = value->ts->sec;
+	}
+
+	if (NULL != value->error)
+		offset += pp_value_pack_str(offset, value->error);
+
+	if (NULL != value->result)
+		offset += pp_value_pack_result(offset, value->result);
+
+	message->size += (zbx_uint32_t)(offset - ptr);
+
+	return (zbx_uint32_t)(offset - ptr);
 }
 
 /******************************************************************************
@@ -592,68 +820,58 @@ zbx_uint32_t	zbx_preprocessor_pack_top_stats_result(unsigned char **data, zbx_ve
  *                                                                            *
  * Purpose: unpack item value data from IPC data buffer                       *
  *                                                                            *
- * Parameters: value - [OUT] unpacked item value                              *
+ * Parameters: batch - [IN/OUT] batch decoding state                          *
+ *             value - [OUT] unpacked item value                              *
  *             data  - [IN]  IPC data buffer                                  *
  *                                                                            *
  * Return value: size of packed data                                          *
  *                                                                            *
+ * Comments: Value timestamp and result are stored in batch and are valid     *
+ *           until the next value is unpacked. The result contents and error  *
+ *           must be freed by caller.                                         *
+ *                                                                            *
  ******************************************************************************/
-zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_preproc_item_value_t *value, unsigned char *data)
+zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_pp_value_batch_t *batch, zbx_preproc_item_value_t *value,
+		const unsigned char *data)
 {
-	zbx_uint32_t	value_len;
-	zbx_timespec_t	*timespec = NULL;
-	AGENT_RESULT	*agent_result = NULL;
-	zbx_log_t	*log = NULL;
-	unsigned char	*offset = data, ts_marker, result_marker, log_marker;
-
-	offset += zbx_deserialize_uint64(offset, &value->itemid);
-	offset += zbx_deserialize_uint64(offset, &value->hostid);
-	offset += zbx_deserialize_char(offset, &value->item_value_type);
-	offset += zbx_deserialize_char(offset, &value->item_flags);
-	offset += zbx_deserialize_char(offset, &value->state);
-	offset += zbx_deserialize_str(offset, &value->error, value_len);
-	offset += zbx_deserialize_char(offset, &ts_marker);
-
-	if (0 != ts_marker)
-	{
-		timespec = (zbx_timespec_t *)zbx_malloc(NULL, sizeof(zbx_timespec_t));
+	const unsigned char	*offset = data;
+	unsigned char		header;
+	zbx_uint64_t		delta;
 
-		offset += zbx_deserialize_int(offset, &timespec->sec);
-		offset += zbx_deserialize_int(offset, &timespec->ns);
-	}
+	header = *offset++;
+	value->item_value_type = *offset++;
+	value->item_flags = *offset++;
+	value->state = (0 != (header & PP_VALUE_STATE) ? *offset++ : ITEM_STATE_NORMAL);
+
+	offset += zbx_deserialize_uint64_compact(offset, &delta);
+	value->itemid = batch->itemid += (zbx_uint64_t)PP_ZIGZAG_DECODE(delta);
 
-	value->ts = timespec;
+	offset += zbx_deserialize_uint64_compact(offset, &delta);
+	value->hostid = batch->hostid += (zbx_uint64_t)PP_ZIGZAG_DECODE(delta);
 
-	offset += zbx_deserialize_char(offset, &result_marker);
-	if (0 != result_marker)
+	if (0 != (header & PP_VALUE_TS))
 	{
-		agent_result = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT));
-
-		offset += zbx_deserialize_uint64(offset, &agent_result->lastlogsize);
-		offset += zbx_deserialize_uint64(offset, &agent_result->ui64);
-		offset += zbx_deserialize_double(offset, &agent_result->dbl);
-		offset += zbx_deserialize_str(offset, &agent_result->str, value_len);
-		offset += zbx_deserialize_str(offset, &agent_result->text, value_len);
-		offset += zbx_deserialize_str(offset, &agent_result->msg, value_len);
-		offset += zbx_deserialize_int(offset, &agent_result->type);
-		offset += zbx_deserialize_int(offset, &agent_result->mtime);
-
-		offset += zbx_deserialize_char(offset, &log_marker);
-		if (0 != log_marker)
-		{
-			log = (zbx_log_t *)zbx_malloc(NULL, sizeof(zbx_log_t));
+		offset += zbx_deserialize_uint64_compact(offset, &delta);
+		batch->sec = batch->ts.sec = (int)(batch->sec + PP_ZIGZAG_DECODE(delta));
+		offset += zbx_deserialize_uint64_compact(offset, &delta);
+		batch->ts.ns = (int)delta;
+		value->ts = &batch->ts;
+	}
+	else
+		value->ts = NULL;
 
-			offset += zbx_deserialize_str(offset, &log->value, value_len);
-			offset += zbx_deserialize_str(offset, &log->source, value_len);
-			offset += zbx_deserialize_int(offset, &log->timestamp);
-			offset += zbx_deserialize_int(offset, &log->severity);
-			offset += zbx_deserialize_int(offset, &log->logeventid);
-		}
+	if (0 != (header & PP_VALUE_ERROR))
+		offset += pp_value_unpack_str(offset, &value->error);
+	else
+		value->error = NULL;
 
-		agent_result->log = log;
+	if (0 != (header & PP_VALUE_RESULT))
+	{
+		offset += pp_value_unpack_result(offset, &batch->result);
+		value->result = &batch->result;
 	}
-
-	value->result = agent_result;
+	else
+		value->result = NULL;
 
 	return (zbx_uint32_t)(offset - data);
 }
@@ -804,11 +1022,16 @@ static void	preprocessor_send(zbx_uint32_t code, unsigned char *data, zbx_uint32
 	static zbx_ipc_socket_t	socket = {0};
 
 	/* each process has a permanent connection to preprocessing manager */
-	if (0 == socket.fd && FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN,
-			&error))
+	if (0 == socket.fd)
 	{
-		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
-		exit(EXIT_FAILURE);
+		if (FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN, &error))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
+			exit(EXIT_FAILURE);
+		}
+
+		/* values are passed through shared memory if supported, falling back to socket */
+		(void)zbx_ipc_socket_enable_shm(&socket);
 	}
 
 	if (FAIL == zbx_ipc_socket_write(&socket, code, data, size))
@@ -881,10 +1104,10 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, zbx_uint64_t hostid, unsigne
 		}
 	}
 
-	if (0 == preprocessor_pack_value(&cached_message, &value))
+	if (0 == zbx_preprocessor_pack_value(&cached_message, &cached_message_alloc, &cached_batch, &value))
 	{
 		zbx_preprocessor_flush();
-		preprocessor_pack_value(&cached_message, &value);
+		(void)zbx_preprocessor_pack_value(&cached_message, &cached_message_alloc, &cached_batch, &value);
 	}
 
 	if (ZBX_PREPROCESSING_BATCH_SIZE < ++cached_values)
@@ -904,8 +1127,16 @@ void	zbx_preprocessor_flush(void)
 	{
 		preprocessor_send(ZBX_IPC_PREPROCESSOR_REQUEST, cached_message.data, cached_message.size, NULL);
 
-		zbx_ipc_message_clean(&cached_message);
-		zbx_ipc_message_init(&cached_message);
+		if (PP_VALUE_BUFFER_MAX < cached_message_alloc)
+		{
+			zbx_ipc_message_clean(&cached_message);
+			zbx_ipc_message_init(&cached_message);
+			cached_message_alloc = 0;
+		}
+		else
+			cached_message.size = 0;
+
+		zbx_preprocessor_value_batch_init(&cached_batch);
 		cached_values = 0;
 	}
 }
@@ -60,7 +60,26 @@ typedef struct
 }
 zbx_packed_field_t;
 
-zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_preproc_item_value_t *value, unsigned char *data);
+/* Compact item value batch encoding state. Item and host identifiers and timestamps are */
+/* delta encoded against the previous value of the same batch (IPC message).             */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	hostid;
+	int		sec;
+
+	/* decoded value timestamp and result storage, reused for every value of the batch */
+	zbx_timespec_t	ts;
+	AGENT_RESULT	result;
+}
+zbx_pp_value_batch_t;
+
+void	zbx_preprocessor_value_batch_init(zbx_pp_value_batch_t *batch);
+
+zbx_uint32_t	zbx_preprocessor_pack_value(zbx_ipc_message_t *message, zbx_uint32_t *message_alloc,
+		zbx_pp_value_batch_t *batch, const zbx_preproc_item_value_t *value);
+zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_pp_value_batch_t *batch, zbx_preproc_item_value_t *value,
+		const unsigned char *data);
 
 void	zbx_preprocessor_unpack_test_request(zbx_pp_item_preproc_t *preproc, zbx_variant_t *value, zbx_timespec_t *ts,
 		const unsigned char *data);
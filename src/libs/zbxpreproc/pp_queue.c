@@ -21,6 +21,8 @@
 #define PP_TASK_QUEUE_INIT_LOCK		0x01
 #define PP_TASK_QUEUE_INIT_EVENT	0x02
 
+#define PP_TASK_RING_INIT_SIZE		1024
+
 ZBX_PTR_VECTOR_IMPL(pp_top_stats_ptr, zbx_pp_top_stats_t *)
 
 /* task sequence registry by itemid */
@@ -31,28 +33,194 @@ typedef struct
 }
 zbx_pp_item_task_sequence_t;
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create task ring buffer                                           *
+ *                                                                            *
+ * Parameters: size - [IN] buffer size, must be power of 2                    *
+ *             prev - [IN] previous buffer (optional)                         *
+ *                                                                            *
+ * Return value: The created buffer.                                          *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_pp_task_buf_t	*pp_task_buf_create(zbx_uint64_t size, zbx_pp_task_buf_t *prev)
+{
+	zbx_pp_task_buf_t	*buf;
+
+	buf = (zbx_pp_task_buf_t *)zbx_malloc(NULL, offsetof(zbx_pp_task_buf_t, tasks) +
+			sizeof(zbx_pp_task_t *) * size);
+	buf->mask = size - 1;
+	buf->prev = prev;
+
+	return buf;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: initialize task ring                                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_task_ring_init(zbx_pp_task_ring_t *ring)
+{
+	ring->head = 0;
+	ring->tail = 0;
+	ring->buf = pp_task_buf_create(PP_TASK_RING_INIT_SIZE, NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: grow task ring buffer                                             *
+ *                                                                            *
+ * Parameters: ring - [IN] task ring                                          *
+ *             head - [IN] ring head observed by producer                     *
+ *             tail - [IN] ring tail                                          *
+ *                                                                            *
+ * Comments: Consumers might still be reading tasks from the old buffer, so   *
+ *           it is retired instead of freed. The old buffers are freed when   *
+ *           the ring is destroyed. As the buffer size is doubled each time   *
+ *           the retired buffers cannot take more space than the active one.  *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_task_ring_grow(zbx_pp_task_ring_t *ring, zbx_uint64_t head, zbx_uint64_t tail)
+{
+	zbx_pp_task_buf_t	*buf = ring->buf, *buf_new;
+
+	buf_new = pp_task_buf_create((buf->mask + 1) * 2, buf);
+
+	for (zbx_uint64_t i = head; i < tail; i++)
+		buf_new->tasks[i & buf_new->mask] = buf->tasks[i & buf->mask];
+
+	__atomic_store_n(&ring->buf, buf_new, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: push task into task ring                                          *
+ *                                                                            *
+ * Parameters: ring - [IN] task ring                                          *
+ *             task - [IN] task to push                                       *
+ *                                                                            *
+ * Comments: Only one thread (producer) can push tasks into a ring.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_task_ring_push(zbx_pp_task_ring_t *ring, zbx_pp_task_t *task)
+{
+	zbx_uint64_t		tail = ring->tail, head;
+	zbx_pp_task_buf_t	*buf = ring->buf;
+
+	head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+	if (tail - head > buf->mask)
+	{
+		pp_task_ring_grow(ring, head, tail);
+		buf = ring->buf;
+	}
+
+	__atomic_store_n(&buf->tasks[tail & buf->mask], task, __ATOMIC_RELAXED);
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_SEQ_CST);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: pop task from task ring                                           *
+ *                                                                            *
+ * Parameters: ring - [IN] task ring                                          *
+ *                                                                            *
+ * Return value: The popped task or NULL if the ring is empty.                *
+ *                                                                            *
+ * Comments: Multiple threads (consumers) can pop tasks concurrently. The     *
+ *           task slot is read before claiming it by advancing ring head,     *
+ *           if the head was moved by another consumer meanwhile the read     *
+ *           task is discarded and the pop is retried.                        *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_pp_task_t	*pp_task_ring_pop(zbx_pp_task_ring_t *ring)
+{
+	zbx_uint64_t	head = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+
+	while (head < __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST))
+	{
+		zbx_pp_task_buf_t	*buf = __atomic_load_n(&ring->buf, __ATOMIC_ACQUIRE);
+		zbx_pp_task_t		*task = __atomic_load_n(&buf->tasks[head & buf->mask], __ATOMIC_RELAXED);
+
+		/* on failure the head is updated with the current value */
+		if (0 != __atomic_compare_exchange_n(&ring->head, &head, head + 1, 0, __ATOMIC_SEQ_CST,
+				__ATOMIC_SEQ_CST))
+		{
+			return task;
+		}
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get number of tasks in task ring                                  *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	pp_task_ring_size(zbx_pp_task_ring_t *ring)
+{
+	zbx_uint64_t	head, tail;
+
+	head = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+	tail = __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST);
+
+	return tail > head ? tail - head : 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: free tasks left in task ring and destroy it                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	pp_task_ring_destroy(zbx_pp_task_ring_t *ring)
+{
+	zbx_pp_task_t		*task;
+	zbx_pp_task_buf_t	*buf;
+
+	if (NULL == ring->buf)
+		return;
+
+	while (NULL != (task = pp_task_ring_pop(ring)))
+		pp_task_free(task);
+
+	while (NULL != (buf = ring->buf))
+	{
+		ring->buf = buf->prev;
+		zbx_free(buf);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: initialize task queue                                             *
  *                                                                            *
- * Parameters: queue - [IN] task queue                                        *
- *             error - [OUT]                                                  *
+ * Parameters: queue       - [IN] task queue                                  *
+ *             workers_num - [IN] number of workers                           *
+ *             error       - [OUT]                                            *
  *                                                                            *
  * Return value: SUCCEED - the task queue was initialized successfully        *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	pp_task_queue_init(zbx_pp_queue_t *queue, char **error)
+int	pp_task_queue_init(zbx_pp_queue_t *queue, int workers_num, char **error)
 {
 	int	err, ret = FAIL;
 
 	queue->workers_num = 0;
-	queue->pending_num = 0;
-	queue->finished_num = 0;
-	queue->processing_num = 0;
-	zbx_list_create(&queue->pending);
-	zbx_list_create(&queue->immediate);
-	zbx_list_create(&queue->finished);
+	queue->waiting_num = 0;
+	queue->queued_num = 0;
+
+	pp_task_ring_init(&queue->immediate);
+	pp_task_ring_init(&queue->pending);
+
+	queue->finished_num = workers_num;
+	queue->finished_next = 0;
+	queue->finished = (zbx_pp_task_ring_t *)zbx_malloc(NULL, sizeof(zbx_pp_task_ring_t) * (size_t)workers_num);
+
+	for (int i = 0; i < workers_num; i++)
+		pp_task_ring_init(&queue->finished[i]);
 
 	zbx_hashset_create(&queue->sequences, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
@@ -78,19 +246,6 @@ out:
 	return ret;
 }
 
-/******************************************************************************
- *                                                                            *
- * Purpose: clear task list                                                   *
- *                                                                            *
- ******************************************************************************/
-static void	pp_task_queue_clear_tasks(zbx_list_t *tasks)
-{
-	zbx_pp_task_t	*task = NULL;
-
-	while (SUCCEED == zbx_list_pop(tasks, (void **)&task))
-		pp_task_free(task);
-}
-
 /******************************************************************************
  *                                                                            *
  * Purpose: destroy task queue                                                *
@@ -104,14 +259,16 @@ void	pp_task_queue_destroy(zbx_pp_queue_t *queue)
 	if (0 != (queue->init_flags & PP_TASK_QUEUE_INIT_EVENT))
 		pthread_cond_destroy(&queue->event);
 
-	pp_task_queue_clear_tasks(&queue->pending);
-	zbx_list_destroy(&queue->pending);
+	pp_task_ring_destroy(&queue->pending);
+	pp_task_ring_destroy(&queue->immediate);
 
-	pp_task_queue_clear_tasks(&queue->immediate);
-	zbx_list_destroy(&queue->immediate);
+	if (NULL != queue->finished)
+	{
+		for (int i = 0; i < queue->finished_num; i++)
+			pp_task_ring_destroy(&queue->finished[i]);
 
-	pp_task_queue_clear_tasks(&queue->finished);
-	zbx_list_destroy(&queue->finished);
+		zbx_free(queue->finished);
+	}
 
 	zbx_hashset_destroy(&queue->sequences);
 
@@ -208,20 +365,20 @@ void	pp_task_queue_push_immediate(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 	{
 		case ZBX_PP_TASK_VALUE_SEQ:
 		case ZBX_PP_TASK_DEPENDENT:
-			queue->pending_num++;
+			queue->queued_num++;
 			if (NULL == (task = pp_task_queue_add_sequence(queue, task)))
 				return;
 			break;
 		case ZBX_PP_TASK_SEQUENCE:
 			/* sequence task is just a container for other tasks - it does not affect statistics, */
-			/* so there is no need to increment queue->pending_num                                */
+			/* so there is no need to increment queue->queued_num                                 */
 			break;
 		default:
-			queue->pending_num++;
+			queue->queued_num++;
 			break;
 	}
 
-	(void)zbx_list_append(&queue->immediate, task, NULL);
+	pp_task_ring_push(&queue->immediate, task);
 }
 
 /******************************************************************************
@@ -247,8 +404,8 @@ void	pp_task_queue_remove_sequence(zbx_pp_queue_t *queue, zbx_uint64_t itemid)
  ******************************************************************************/
 void	pp_task_queue_push_test(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 {
-	queue->pending_num++;
-	(void)zbx_list_append(&queue->immediate, task, NULL);
+	queue->queued_num++;
+	pp_task_ring_push(&queue->immediate, task);
 }
 
 /******************************************************************************
@@ -260,29 +417,35 @@ void	pp_task_queue_push_test(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
  *                                                                            *
  * Comments: This function is used to push tasks created by new preprocessing *
  *           or testing requests.                                             *
+ *           Serial value tasks are moved to task sequences here rather than  *
+ *           when popped by workers, so the sequence registry is accessed     *
+ *           only by manager.                                                 *
  *                                                                            *
  ******************************************************************************/
 void	pp_task_queue_push(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
 {
 	zbx_pp_task_value_t	*d = (zbx_pp_task_value_t *)PP_TASK_DATA(task);
-	queue->pending_num++;
+	zbx_pp_task_t		*seq_task;
+
+	queue->queued_num++;
 
 	if (ITEM_TYPE_INTERNAL != d->preproc->type)
 	{
-		(void)zbx_list_append(&queue->pending, task, NULL);
+		if (ZBX_PP_TASK_VALUE_SEQ == task->type && NULL == (task = pp_task_queue_add_sequence(queue, task)))
+			return;
+
+		pp_task_ring_push(&queue->pending, task);
 		return;
 	}
 
 	if (ZBX_PP_TASK_VALUE == task->type)
 	{
-		(void)zbx_list_append(&queue->immediate, task, NULL);
+		pp_task_ring_push(&queue->immediate, task);
 		return;
 	}
 
-	zbx_pp_task_t	*seq_task;
-
 	if (NULL != (seq_task = pp_task_queue_add_sequence(queue, task)))
-		(void)zbx_list_append(&queue->immediate, seq_task, NULL);
+		pp_task_ring_push(&queue->immediate, seq_task);
 }
 
 /******************************************************************************
@@ -294,59 +457,46 @@ void	pp_task_queue_push(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
  * Return value: The popped task or NULL if there are no tasks to be          *
  *               processed.                                                   *
  *                                                                            *
- * Comments: This function is used by workers to pop tasks for processing.    *
- *           Sequence tasks will be moved to existing tasks sequences or      *
- *           returned if there are no registered sequences for this item.     *
+ * Comments: This function is used by workers to pop tasks for processing     *
+ *           and can be called without locking task queue.                    *
  *                                                                            *
  ******************************************************************************/
 zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue)
 {
-	zbx_pp_task_t	*task = NULL;
-
-	if (SUCCEED == zbx_list_pop(&queue->immediate, (void **)&task))
-	{
-		/* while sequence tasks do not affect statistics, the first task in sequence */
-		/* does, so the statistics can be updated for all tasks                      */
-		queue->pending_num--;
-		queue->processing_num++;
-
-		return (zbx_pp_task_t *)task;
-	}
-
-	while (SUCCEED == zbx_list_pop(&queue->pending, (void **)&task))
-	{
-		if (ZBX_PP_TASK_VALUE_SEQ == task->type)
-		{
-			/* task is being moved from pending to immediate queue */
-			/* while still pending, so statistics are not affected */
-			task = pp_task_queue_add_sequence(queue, task);
-		}
-
-		if (NULL != task)
-		{
-			queue->pending_num--;
-			queue->processing_num++;
+	zbx_pp_task_t	*task;
 
-			return task;
-		}
-	}
+	if (NULL != (task = pp_task_ring_pop(&queue->immediate)))
+		return task;
 
-	return NULL;
+	return pp_task_ring_pop(&queue->pending);
 }
 
 /******************************************************************************
  *                                                                            *
  * Purpose: push finished task into queue                                     *
  *                                                                            *
- * Parameters: queue - [IN] task queue                                        *
- *             task  - [IN] task                                              *
+ * Parameters: queue        - [IN] task queue                                 *
+ *             worker_index - [IN] index of the worker pushing the task       *
+ *             task         - [IN] task                                       *
+ *                                                                            *
+ * Return value: SUCCEED - there were no other finished tasks from this       *
+ *                         worker, manager must be notified                   *
+ *               FAIL    - manager has finished tasks to process              *
+ *                                                                            *
+ * Comments: This function is used by workers and can be called without       *
+ *           locking task queue.                                              *
  *                                                                            *
  ******************************************************************************/
-void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
+int	pp_task_queue_push_finished(zbx_pp_queue_t *queue, int worker_index, zbx_pp_task_t *task)
 {
-	queue->finished_num++;
-	queue->processing_num--;
-	(void)zbx_list_append(&queue->finished, task, NULL);
+	zbx_pp_task_ring_t	*ring = &queue->finished[worker_index];
+	zbx_uint64_t		tail = ring->tail;
+
+	pp_task_ring_push(ring, task);
+
+	/* if manager has not popped all previously finished tasks it will check */
+	/* the ring again after popping them and will find the pushed task       */
+	return __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == tail ? SUCCEED : FAIL;
 }
 
 /******************************************************************************
@@ -357,15 +507,21 @@ void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task)
  *                                                                            *
  * Return value: The popped task or NULL if there are no finished tasks.      *
  *                                                                            *
+ * Comments: This function is used by manager. The worker rings are drained   *
+ *           in round robin order.                                            *
+ *                                                                            *
  ******************************************************************************/
 zbx_pp_task_t	*pp_task_queue_pop_finished(zbx_pp_queue_t *queue)
 {
 	zbx_pp_task_t	*task;
 
-	if (SUCCEED == zbx_list_pop(&queue->finished, (void **)&task))
+	for (int i = 0; i < queue->finished_num; i++)
 	{
-		queue->finished_num--;
-		return task;
+		if (NULL != (task = pp_task_ring_pop(&queue->finished[queue->finished_next])))
+			return task;
+
+		if (++queue->finished_next == queue->finished_num)
+			queue->finished_next = 0;
 	}
 
 	return NULL;
@@ -381,20 +537,36 @@ zbx_pp_task_t	*pp_task_queue_pop_finished(zbx_pp_queue_t *queue)
  * Return value: SUCCEED - the wait succeeded                                 *
  *               FAIL    - an error has occurred                              *
  *                                                                            *
- * Comments: This function is used by workers to wait for new tasks.          *
+ * Comments: This function is used by workers to wait for new tasks and must  *
+ *           be called with task queue locked. The worker is registered as    *
+ *           waiting before checking for new tasks, so manager either sees    *
+ *           the waiting worker when pushing tasks or the worker sees the     *
+ *           pushed tasks.                                                    *
  *                                                                            *
  ******************************************************************************/
 int	pp_task_queue_wait(zbx_pp_queue_t *queue, char **error)
 {
-	int	err;
+	int	err, ret = SUCCEED;
 
-	if (0 != (err = pthread_cond_wait(&queue->event, &queue->lock)))
+	__atomic_add_fetch(&queue->waiting_num, 1, __ATOMIC_SEQ_CST);
+
+	if (0 == pp_task_ring_size(&queue->immediate) && 0 == pp_task_ring_size(&queue->pending))
 	{
-		*error = zbx_dsprintf(NULL, "cannot wait for conditional variable: %s", zbx_strerror(err));
-		return FAIL;
+		if (0 != (err = pthread_cond_wait(&queue->event, &queue->lock)))
+		{
+			*error = zbx_dsprintf(NULL, "cannot wait for conditional variable: %s", zbx_strerror(err));
+			ret = FAIL;
+		}
 	}
 
-	return SUCCEED;
+	__atomic_sub_fetch(&queue->waiting_num, 1, __ATOMIC_SEQ_CST);
+
+	/* manager notifies single worker after pushing a batch of tasks, */
+	/* wake up the next worker if there are more tasks to process     */
+	if (SUCCEED == ret && 1 < pp_task_ring_size(&queue->immediate) + pp_task_ring_size(&queue->pending))
+		pthread_cond_signal(&queue->event);
+
+	return ret;
 }
 
 /******************************************************************************
@@ -404,17 +576,25 @@ int	pp_task_queue_wait(zbx_pp_queue_t *queue, char **error)
  * Parameters: queue - [IN] task queue                                        *
  *                                                                            *
  * Comments: This function is used by manager to notify a worker when a new   *
- *           task has been queued.                                            *
+ *           task has been queued. The task queue is locked only if there are *
+ *           waiting workers.                                                 *
  *                                                                            *
  ******************************************************************************/
 void	pp_task_queue_notify(zbx_pp_queue_t *queue)
 {
 	int	err;
 
+	if (0 == __atomic_load_n(&queue->waiting_num, __ATOMIC_SEQ_CST))
+		return;
+
+	pp_task_queue_lock(queue);
+
 	if (0 != (err = pthread_cond_signal(&queue->event)))
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "cannot signal conditional variable: %s", zbx_strerror(err));
 	}
+
+	pp_task_queue_unlock(queue);
 }
 
 /******************************************************************************
@@ -431,10 +611,49 @@ void	pp_task_queue_notify_all(zbx_pp_queue_t *queue)
 {
 	int	err;
 
+	pp_task_queue_lock(queue);
+
 	if (0 != (err = pthread_cond_broadcast(&queue->event)))
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "cannot broadcast conditional variable: %s", zbx_strerror(err));
 	}
+
+	pp_task_queue_unlock(queue);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get task queue statistics                                         *
+ *                                                                            *
+ * Parameters: queue          - [IN] task queue                               *
+ *             pending_num    - [OUT] tasks waiting to be processed           *
+ *             processing_num - [OUT] tasks being processed                   *
+ *             finished_num   - [OUT] finished tasks not yet popped           *
+ *                                                                            *
+ * Comments: This function is used by manager. The statistics are calculated  *
+ *           from ring positions - each popped new task advances the head of  *
+ *           immediate or pending ring and each finished task advances the    *
+ *           tail of worker's finished task ring.                             *
+ *                                                                            *
+ ******************************************************************************/
+void	pp_task_queue_get_stats(zbx_pp_queue_t *queue, zbx_uint64_t *pending_num, zbx_uint64_t *processing_num,
+		zbx_uint64_t *finished_num)
+{
+	zbx_uint64_t	finished_total = 0, finished_popped = 0, started;
+
+	/* read finished task counters before started task counters to keep the difference positive */
+	for (int i = 0; i < queue->finished_num; i++)
+	{
+		finished_total += __atomic_load_n(&queue->finished[i].tail, __ATOMIC_SEQ_CST);
+		finished_popped += queue->finished[i].head;
+	}
+
+	started = __atomic_load_n(&queue->immediate.head, __ATOMIC_SEQ_CST) +
+			__atomic_load_n(&queue->pending.head, __ATOMIC_SEQ_CST);
+
+	*pending_num = queue->queued_num - started;
+	*processing_num = started - finished_total;
+	*finished_num = finished_total - finished_popped;
 }
 
 /******************************************************************************
@@ -453,8 +672,6 @@ void	pp_task_queue_get_sequence_stats(zbx_pp_queue_t *queue, zbx_vector_pp_top_s
 	zbx_pp_top_stats_t		*stat;
 	zbx_list_iterator_t		li;
 
-	pp_task_queue_lock(queue);
-
 	zbx_hashset_iter_reset(&queue->sequences, &iter);
 	while (NULL != (sequence = (zbx_pp_item_task_sequence_t *)zbx_hashset_iter_next(&iter)))
 	{
@@ -477,7 +694,4 @@ void	pp_task_queue_get_sequence_stats(zbx_pp_queue_t *queue, zbx_vector_pp_top_s
 
 		zbx_vector_pp_top_stats_ptr_append(stats, stat);
 	}
-
-	pp_task_queue_unlock(queue);
-
 }
@@ -18,26 +18,58 @@
 #include "zbxpreproc.h"
 #include "zbxalgo.h"
 
+#define PP_TASK_QUEUE_CACHELINE_SIZE	64
+
+/* task ring buffer storage */
+typedef struct zbx_pp_task_buf
+{
+	zbx_uint64_t		mask;
+	struct zbx_pp_task_buf	*prev;	/* retired (smaller) buffer, see pp_task_ring_grow() */
+	zbx_pp_task_t		*tasks[1];
+}
+zbx_pp_task_buf_t;
+
+/* lock-free single producer, multiple consumer task ring */
 typedef struct
 {
-	zbx_uint32_t	init_flags;
-	int		workers_num;
-	zbx_uint64_t	pending_num;
-	zbx_uint64_t	finished_num;
-	zbx_uint64_t	processing_num;
+	zbx_uint64_t		head;	/* updated by consumers */
+	char			pad_head[PP_TASK_QUEUE_CACHELINE_SIZE - sizeof(zbx_uint64_t)];
+
+	zbx_uint64_t		tail;	/* updated by producer */
+	zbx_pp_task_buf_t	*buf;
+	char			pad_tail[PP_TASK_QUEUE_CACHELINE_SIZE - sizeof(zbx_uint64_t) -
+						sizeof(zbx_pp_task_buf_t *)];
+}
+zbx_pp_task_ring_t;
+
+typedef struct
+{
+	zbx_uint32_t		init_flags;
+	int			workers_num;
+	int			waiting_num;
+
+	/* number of queued tasks, updated only by manager */
+	zbx_uint64_t		queued_num;
+
+	/* registered task sequences, accessed only by manager */
+	zbx_hashset_t		sequences;
 
-	zbx_hashset_t	sequences;
+	/* new tasks, pushed by manager and popped by workers */
+	zbx_pp_task_ring_t	immediate;
+	zbx_pp_task_ring_t	pending;
 
-	zbx_list_t	pending;
-	zbx_list_t	immediate;
-	zbx_list_t	finished;
+	/* finished tasks - a ring per worker, pushed by the worker and popped by manager */
+	zbx_pp_task_ring_t	*finished;
+	int			finished_num;
+	int			finished_next;
 
-	pthread_mutex_t	lock;
-	pthread_cond_t	event;
+	/* used by workers to wait for new tasks */
+	pthread_mutex_t		lock;
+	pthread_cond_t		event;
 }
 zbx_pp_queue_t;
 
-int	pp_task_queue_init(zbx_pp_queue_t *queue, char **error);
+int	pp_task_queue_init(zbx_pp_queue_t *queue, int workers_num, char **error);
 void	pp_task_queue_destroy(zbx_pp_queue_t *queue);
 
 void	pp_task_queue_lock(zbx_pp_queue_t *queue);
@@ -55,9 +87,11 @@ void	pp_task_queue_push(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
 
 zbx_pp_task_t	*pp_task_queue_pop_new(zbx_pp_queue_t *queue);
 void	pp_task_queue_push_immediate(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
-void	pp_task_queue_push_finished(zbx_pp_queue_t *queue, zbx_pp_task_t *task);
+int	pp_task_queue_push_finished(zbx_pp_queue_t *queue, int worker_index, zbx_pp_task_t *task);
 zbx_pp_task_t	*pp_task_queue_pop_finished(zbx_pp_queue_t *queue);
 
+void	pp_task_queue_get_stats(zbx_pp_queue_t *queue, zbx_uint64_t *pending_num, zbx_uint64_t *processing_num,
+		zbx_uint64_t *finished_num);
 void	pp_task_queue_get_sequence_stats(zbx_pp_queue_t *queue, zbx_vector_pp_top_stats_ptr_t *stats);
 
 #endif
@@ -130,13 +130,12 @@ static void	*pp_worker_entry(void *args)
 	pp_context_init(&worker->execute_ctx);
 	pp_task_queue_lock(queue);
 	pp_task_queue_register_worker(queue);
+	pp_task_queue_unlock(queue);
 
 	while (0 == worker->stop)
 	{
 		if (NULL != (in = pp_task_queue_pop_new(queue)))
 		{
-			pp_task_queue_unlock(queue);
-
 			zbx_timekeeper_update(worker->timekeeper, worker->id - 1, ZBX_PROCESS_STATE_BUSY);
 
 			zabbix_log(LOG_LEVEL_TRACE, "%s() process task type:%u itemid:" ZBX_FS_UI64, __func__,
@@ -161,26 +160,29 @@ static void	*pp_worker_entry(void *args)
 
 			zbx_timekeeper_update(worker->timekeeper, worker->id - 1, ZBX_PROCESS_STATE_IDLE);
 
-			pp_task_queue_lock(queue);
-			pp_task_queue_push_finished(queue, in);
-
-			if (NULL != worker->finished_cb)
+			if (SUCCEED == pp_task_queue_push_finished(queue, worker->id - 1, in) &&
+					NULL != worker->finished_cb)
+			{
 				worker->finished_cb(worker->finished_data);
+			}
 
 			continue;
 		}
 
-		if (SUCCEED != pp_task_queue_wait(queue, &error))
+		pp_task_queue_lock(queue);
+
+		/* stop flag is set with task queue locked, check it before waiting to avoid missing notification */
+		if (0 == worker->stop && SUCCEED != pp_task_queue_wait(queue, &error))
 		{
 			zabbix_log(LOG_LEVEL_WARNING, "[%d] %s", worker->id, error);
 			zbx_free(error);
 			worker->stop = 1;
 		}
 
-		if (1 < queue->pending_num)
-			pp_task_queue_notify(queue);
+		pp_task_queue_unlock(queue);
 	}
 
+	pp_task_queue_lock(queue);
 	pp_task_queue_deregister_worker(queue);
 	pp_task_queue_unlock(queue);
 
@@ -49,6 +49,8 @@ zbx_pp_item_preproc_t	*zbx_pp_item_preproc_create(zbx_uint64_t hostid, unsigned
 	preproc->flags = flags;
 	preproc->history_cache = NULL;
 	preproc->history_num = 0;
+	preproc->pipeline = NULL;
+	preproc->pipeline_free = NULL;
 
 	preproc->mode = ZBX_PP_PROCESS_PARALLEL;
 
@@ -80,6 +82,9 @@ static void	pp_item_preproc_free(zbx_pp_item_preproc_t *preproc)
 
 	zbx_pp_history_cache_release(preproc->history_cache);
 
+	if (NULL != preproc->pipeline)
+		preproc->pipeline_free(preproc->pipeline);
+
 	zbx_free(preproc);
 }
 
@@ -13,6 +13,7 @@
 **/
 
 #include "pb_history.h"
+#include "pb_segment.h"
 #include "proxybuffer.h"
 #include "zbx_host_constants.h"
 #include "zbx_item_constants.h"
@@ -21,6 +22,7 @@
 #include "zbxcommon.h"
 #include "zbxdb.h"
 #include "zbxdbhigh.h"
+#include "zbxdbwrap.h"
 #include "zbxjson.h"
 #include "zbxnum.h"
 #include "zbxproxybuffer.h"
@@ -31,11 +33,12 @@ static void	pb_history_add_rows_db(zbx_list_t *rows, zbx_list_item_t *next, zbx_
 
 struct zbx_pb_history_data
 {
-	zbx_pb_state_t	state;
-	zbx_list_t	rows;
-	int		rows_num;
-	zbx_db_insert_t	db_insert;
-	zbx_uint64_t	handleid;
+	zbx_pb_state_t		state;
+	zbx_list_t		rows;
+	int			rows_num;
+	zbx_db_insert_t		db_insert;
+	zbx_uint64_t		handleid;
+	zbx_pb_segments_t	*segments;	/* rows are written to segments instead of database */
 };
 
 void	pb_list_free_history(zbx_list_t *list, zbx_pb_history_t *row)
@@ -79,7 +82,7 @@ static void	pb_history_add_value(zbx_pb_history_data_t *data, zbx_uint64_t itemi
 		const zbx_timespec_t *ts, int flags, zbx_uint64_t lastlogsize, int mtime, int timestamp, int logeventid,
 		int severity, const char *source, time_t now)
 {
-	if (PB_MEMORY == data->state)
+	if (PB_MEMORY == data->state || NULL != data->segments)
 	{
 		zbx_pb_history_t	*row;
 
@@ -213,19 +216,69 @@ try_again:
 	return rows->values_num;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get approximate size of exported history data                     *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	pb_history_export_size(const struct zbx_json *j, const zbx_history_columns_t *columns)
+{
+	return j->buffer_offset + (NULL != columns ? zbx_history_columns_size(columns) : 0);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add history record to columnar history data batch                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_history_export_columns(zbx_history_columns_t *columns, const zbx_pb_history_t *row)
+{
+	zbx_agent_value_t	value;
+
+	memset(&value, 0, sizeof(value));
+	value.id = row->id;
+	value.ts = row->ts;
+
+	if (ZBX_PROXY_HISTORY_FLAG_NOVALUE != (row->flags & ZBX_PROXY_HISTORY_MASK_NOVALUE))
+	{
+		value.state = row->state;
+
+		if (0 == (row->flags & ZBX_PROXY_HISTORY_FLAG_NOVALUE))
+		{
+			value.timestamp = row->timestamp;
+			value.severity = row->severity;
+			value.logeventid = row->logeventid;
+			value.source = row->source;
+			value.value = row->value;
+		}
+
+		if (0 != (row->flags & ZBX_PROXY_HISTORY_FLAG_META))
+		{
+			value.meta = 1;
+			value.lastlogsize = row->lastlogsize;
+			value.mtime = row->mtime;
+		}
+	}
+
+	zbx_history_columns_append(columns, row->itemid, &value);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add history records to output json                                *
  *                                                                            *
  * Parameters: j             - [IN/OUT] json output buffer                    *
+ *             columns       - [IN/OUT] columnar history data batch, NULL if  *
+ *                                      records must be exported as json      *
+ *                                      objects                               *
  *             rows          - [IN] history rows to export                    *
  *             lastid        - [OUT] id of last added record                  *
  *                                                                            *
  * Return value: The total number of records exported.                        *
  *                                                                            *
  ******************************************************************************/
-static int	pb_history_export(struct zbx_json *j, int records_num, const zbx_vector_pb_history_ptr_t *rows,
-		zbx_uint64_t *lastid)
+static int	pb_history_export(struct zbx_json *j, zbx_history_columns_t *columns, int records_num,
+		const zbx_vector_pb_history_ptr_t *rows, zbx_uint64_t *lastid)
 {
 	int				i, *errcodes;
 	zbx_pb_history_t		*row;
@@ -275,6 +328,17 @@ static int	pb_history_export(struct zbx_json *j, int records_num, const zbx_vect
 		if (HOST_STATUS_MONITORED != dc_items[i].host.status)
 			continue;
 
+		if (NULL != columns)
+		{
+			pb_history_export_columns(columns, row);
+			records_num++;
+
+			if (ZBX_DATA_JSON_RECORD_LIMIT < pb_history_export_size(j, columns))
+				break;
+
+			continue;
+		}
+
 		if (0 == records_num)
 			zbx_json_addarray(j, ZBX_PROTO_TAG_HISTORY_DATA);
 
@@ -335,7 +399,8 @@ static int	pb_history_export(struct zbx_json *j, int records_num, const zbx_vect
 	return records_num;
 }
 
-static int	pb_history_get_db(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
+static int	pb_history_get_db(struct zbx_json *j, zbx_history_columns_t *columns, zbx_uint64_t *lastid,
+		int *more)
 {
 	int				records_num = 0;
 	zbx_uint64_t			id;
@@ -352,10 +417,10 @@ static int	pb_history_get_db(struct zbx_json *j, zbx_uint64_t *lastid, int *more
 	/*   1) there are no more data to read                                  */
 	/*   2) we have retrieved more than the total maximum number of records */
 	/*   3) we have gathered more than half of the maximum packet size      */
-	while (ZBX_DATA_JSON_BATCH_LIMIT > j->buffer_offset && ZBX_MAX_HRECORDS_TOTAL > records_num &&
+	while (ZBX_DATA_JSON_BATCH_LIMIT > pb_history_export_size(j, columns) && ZBX_MAX_HRECORDS_TOTAL > records_num &&
 			0 != pb_history_get_rows_db(id, &rows, more))
 	{
-		records_num = pb_history_export(j, records_num, &rows, lastid);
+		records_num = pb_history_export(j, columns, records_num, &rows, lastid);
 
 		/* got less data than requested - either no more data to read or the history is full of */
 		/* holes. In this case send retrieved data before attempting to read/wait for more data */
@@ -367,7 +432,7 @@ static int	pb_history_get_db(struct zbx_json *j, zbx_uint64_t *lastid, int *more
 		zbx_vector_pb_history_ptr_clear_ext(&rows, pb_history_free);
 	}
 
-	if (0 != records_num)
+	if (0 != records_num && NULL == columns)
 		zbx_json_close(j);
 
 	zbx_vector_pb_history_ptr_clear_ext(&rows, pb_history_free);
@@ -379,12 +444,79 @@ static int	pb_history_get_db(struct zbx_json *j, zbx_uint64_t *lastid, int *more
 	return records_num;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get history records from segment store                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_history_get_segments(zbx_pb_t *pb, struct zbx_json *j, zbx_history_columns_t *columns,
+		zbx_uint64_t *lastid, int *more)
+{
+	int				i, records_num = 0, rows_num;
+	zbx_uint64_t			id;
+	zbx_pb_history_t		*buf;
+	zbx_vector_pb_history_ptr_t	rows;
+	zbx_vector_pb_segment_t		snapshot;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_vector_pb_segment_create(&snapshot);
+	zbx_vector_pb_history_ptr_create(&rows);
+	zbx_vector_pb_history_ptr_reserve(&rows, ZBX_MAX_HRECORDS);
+	buf = (zbx_pb_history_t *)zbx_malloc(NULL, sizeof(zbx_pb_history_t) * ZBX_MAX_HRECORDS);
+
+	pb_lock();
+	id = pb->history_lastid_sent;
+	pb_segments_snapshot(pb->history_segments, &snapshot);
+	pb_unlock();
+
+	*more = ZBX_PROXY_DATA_MORE;
+
+	/* history rows point to the mapped segment data and are exported without copying */
+	while (ZBX_DATA_JSON_BATCH_LIMIT > pb_history_export_size(j, columns) && ZBX_MAX_HRECORDS_TOTAL > records_num)
+	{
+		if (0 == (rows_num = pb_segments_read(pb->history_segments, &snapshot, id, buf, ZBX_MAX_HRECORDS)))
+		{
+			*more = ZBX_PROXY_DATA_DONE;
+			break;
+		}
+
+		zbx_vector_pb_history_ptr_clear(&rows);
+
+		for (i = 0; i < rows_num; i++)
+			zbx_vector_pb_history_ptr_append(&rows, &buf[i]);
+
+		records_num = pb_history_export(j, columns, records_num, &rows, lastid);
+
+		if (ZBX_MAX_HRECORDS > rows_num)
+		{
+			*more = ZBX_PROXY_DATA_DONE;
+			break;
+		}
+
+		id = *lastid;
+	}
+
+	if (0 != records_num && NULL == columns)
+		zbx_json_close(j);
+
+	zbx_free(buf);
+	zbx_vector_pb_history_ptr_destroy(&rows);
+	zbx_vector_pb_segment_destroy(&snapshot);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() lastid:" ZBX_FS_UI64 " records_num:%d size:~" ZBX_FS_SIZE_T " more:%d",
+			__func__, *lastid, records_num, j->buffer_offset, *more);
+
+	return records_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: get history records from memory cache                             *
  *                                                                            *
  ******************************************************************************/
-static int	pb_history_get_mem(zbx_pb_t *pb, struct zbx_json *j, zbx_uint64_t *lastid, int *more)
+static int	pb_history_get_mem(zbx_pb_t *pb, struct zbx_json *j, zbx_history_columns_t *columns,
+		zbx_uint64_t *lastid, int *more)
 {
 	int	records_num = 0;
 	void	*ptr;
@@ -411,12 +543,13 @@ static int	pb_history_get_mem(zbx_pb_t *pb, struct zbx_json *j, zbx_uint64_t *la
 					break;
 			}
 
-			records_num = pb_history_export(j, records_num, &rows, lastid);
+			records_num = pb_history_export(j, columns, records_num, &rows, lastid);
 
 			if (ZBX_MAX_HRECORDS != rows.values_num)
 				break;
 
-			if (ZBX_DATA_JSON_BATCH_LIMIT <= j->buffer_offset || records_num >= ZBX_MAX_HRECORDS_TOTAL)
+			if (ZBX_DATA_JSON_BATCH_LIMIT <= pb_history_export_size(j, columns) ||
+					records_num >= ZBX_MAX_HRECORDS_TOTAL)
 			{
 				*more = ZBX_PROXY_DATA_MORE;
 				break;
@@ -427,7 +560,7 @@ static int	pb_history_get_mem(zbx_pb_t *pb, struct zbx_json *j, zbx_uint64_t *la
 
 		zbx_vector_pb_history_ptr_destroy(&rows);
 
-		if (0 != records_num)
+		if (0 != records_num && NULL == columns)
 			zbx_json_close(j);
 	}
 
@@ -485,13 +618,19 @@ out:
  * Purpose: set ids to new history rows                                       *
  *                                                                            *
  ******************************************************************************/
-static void	pb_history_set_row_ids(zbx_list_t *rows, int rows_num)
+static void	pb_history_set_row_ids(zbx_pb_t *pb, zbx_list_t *rows, int rows_num)
 {
 	zbx_uint64_t		id;
 	zbx_pb_history_t	*row;
 	zbx_list_iterator_t	li;
 
-	id = zbx_dc_get_nextid("proxy_history", rows_num);
+	if (NULL != pb->history_segments)
+	{
+		id = pb->history_nextid;
+		pb->history_nextid += (zbx_uint64_t)rows_num;
+	}
+	else
+		id = zbx_dc_get_nextid("proxy_history", rows_num);
 	zbx_list_iterator_init(rows, &li);
 
 	while (SUCCEED == zbx_list_iterator_next(&li))
@@ -507,23 +646,25 @@ static void	pb_history_set_row_ids(zbx_list_t *rows, int rows_num)
  *                                                                            *
  * Parameters: pb   - [IN] proxy buffer                                       *
  *             rows - [IN] rows to add                                        *
+ *             next - [IN] next row to add, NULL to add all rows              *
  *                                                                            *
  * Return value: NULL if all rows were added successfully. Otherwise the list *
  *               item of first failed row is returned                         *
  *                                                                            *
  ******************************************************************************/
-static zbx_list_item_t	*pb_history_add_rows_mem(zbx_pb_t *pb, zbx_list_t *rows)
+static zbx_list_item_t	*pb_history_add_rows_mem(zbx_pb_t *pb, zbx_list_t *rows, zbx_list_item_t *next)
 {
 	zbx_list_iterator_t	li;
 	zbx_pb_history_t	*row;
 	int			rows_num = 0;
 	size_t			size = 0;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() next:%p", __func__, next);
 
-	zbx_list_iterator_init(rows, &li);
+	if (SUCCEED != zbx_list_iterator_init_with(rows, next, &li))
+		goto out;
 
-	while (SUCCEED == zbx_list_iterator_next(&li))
+	do
 	{
 		(void)zbx_list_iterator_peek(&li, (void **)&row);
 
@@ -548,6 +689,7 @@ static zbx_list_item_t	*pb_history_add_rows_mem(zbx_pb_t *pb, zbx_list_t *rows)
 
 		rows_num++;
 	}
+	while (SUCCEED == zbx_list_iterator_next(&li));
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() rows_num:%d next:%p", __func__, rows_num, li.current);
 
@@ -595,7 +737,104 @@ static void	pb_history_add_rows_db(zbx_list_t *rows, zbx_list_item_t *next, zbx_
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() rows_num:%d", __func__, rows_num);
 }
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add history rows to segment store                                 *
+ *                                                                            *
+ * Parameters: pb     - [IN] proxy buffer                                     *
+ *             rows   - [IN] rows to add, with ids assigned                   *
+ *             next   - [IN] next row to add                                  *
+ *             lastid - [OUT] last written id                                 *
+ *                                                                            *
+ * Return value: NULL if all rows were written successfully. Otherwise the    *
+ *               list item of first failed row is returned                    *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer locked.           *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_list_item_t	*pb_history_add_rows_segments(zbx_pb_t *pb, zbx_list_t *rows, zbx_list_item_t *next,
+		zbx_uint64_t *lastid)
+{
+	zbx_list_iterator_t	li;
+	zbx_pb_history_t	*row;
+	int			rows_num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() next:%p", __func__, next);
+
+	if (SUCCEED != zbx_list_iterator_init_with(rows, next, &li))
+		goto out;
+
+	do
+	{
+		(void)zbx_list_iterator_peek(&li, (void **)&row);
+
+		if (SUCCEED != pb_segments_append(pb->history_segments, row))
+			goto out;
+
+		rows_num++;
+		*lastid = row->id;
+	}
+	while (SUCCEED == zbx_list_iterator_next(&li));
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() rows_num:%d next:%p", __func__, rows_num, li.current);
+
+	return li.current;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: log history rows that were not written to segment store           *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_history_log_discarded(zbx_list_t *rows, zbx_list_item_t *next)
+{
+	zbx_list_iterator_t	li;
+	int			rows_num = 0;
+
+	if (SUCCEED != zbx_list_iterator_init_with(rows, next, &li))
+		return;
+
+	do
+	{
+		rows_num++;
+	}
+	while (SUCCEED == zbx_list_iterator_next(&li));
+
+	zabbix_log(LOG_LEVEL_ERR, "cannot write %d history records to proxy buffer segments, discarding", rows_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: keep history rows that cannot be written to segment store in      *
+ *          memory cache                                                      *
+ *                                                                            *
+ * Parameters: pb   - [IN] proxy buffer                                       *
+ *             rows - [IN] rows to add, with ids assigned                     *
+ *             next - [IN] first row that was not written to segments         *
+ *                                                                            *
+ * Comments: In hybrid mode the buffer initiates transition to memory state,  *
+ *           so the cached rows are uploaded after the segment records, like  *
+ *           during normal transition from database to memory state. Rows     *
+ *           are discarded only if memory cache is disabled or full.          *
+ *                                                                            *
+ *           This function must be called with proxy buffer locked.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_history_add_rows_segments_fallback(zbx_pb_t *pb, zbx_list_t *rows, zbx_list_item_t *next)
+{
+	if (ZBX_PB_MODE_HYBRID == pb->mode && (PB_DATABASE == pb->state || PB_DATABASE_MEMORY == pb->state))
+	{
+		zbx_list_item_t	*failed;
 
+		if (next != (failed = pb_history_add_rows_mem(pb, rows, next)) && PB_DATABASE == pb->state)
+			pb_set_state(pb, PB_DATABASE_MEMORY, "cannot write history records to segments");
+
+		next = failed;
+	}
+
+	if (NULL != next)
+		pb_history_log_discarded(rows, next);
+}
 
 void	pb_history_flush(zbx_pb_t *pb)
 {
@@ -603,7 +842,18 @@ void	pb_history_flush(zbx_pb_t *pb)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	pb_history_add_rows_db(&pb->history, NULL, &lastid);
+	if (NULL != pb->history_segments)
+	{
+		zbx_list_item_t	*next;
+
+		if (NULL != (next = pb_history_add_rows_segments(pb, &pb->history, NULL, &lastid)))
+			pb_history_log_discarded(&pb->history, next);
+
+		/* rows are already written, avoid writing them again if flush is retried */
+		pb_history_clear(pb, UINT64_MAX);
+	}
+	else
+		pb_history_add_rows_db(&pb->history, NULL, &lastid);
 
 	if (get_pb_data()->history_lastid_db < lastid)
 		get_pb_data()->history_lastid_db = lastid;
@@ -633,7 +883,7 @@ void	pb_history_clear(zbx_pb_t *pb, zbx_uint64_t lastid)
 static void	pb_history_data_free(zbx_pb_history_data_t *data)
 {
 
-	if (PB_MEMORY == data->state)
+	if (PB_MEMORY == data->state || NULL != data->segments)
 	{
 		zbx_pb_history_t	*row;
 
@@ -729,13 +979,15 @@ zbx_pb_history_data_t	*zbx_pb_history_open(void)
 
 	pb_unlock();
 
-	if (PB_MEMORY == data->state)
+	data->segments = pb_data->history_segments;
+
+	if (PB_MEMORY == data->state || NULL != data->segments)
 	{
 		zbx_list_create(&data->rows);
 		data->rows_num = 0;
 	}
 
-	if (PB_DATABASE == get_pb_dst(data->state))
+	if (PB_DATABASE == get_pb_dst(data->state) && NULL == data->segments)
 	{
 		zbx_db_insert_prepare(&data->db_insert, "proxy_history", "id", "itemid", "clock", "timestamp", "source",
 				"severity", "value", "logeventid", "ns", "state", "lastlogsize", "mtime", "flags",
@@ -768,7 +1020,7 @@ void	zbx_pb_history_close(zbx_pb_history_data_t *data)
 		if (0 == data->rows_num)
 			goto out;
 
-		pb_history_set_row_ids(&data->rows, data->rows_num);
+		pb_history_set_row_ids(pb_data, &data->rows, data->rows_num);
 
 		if (PB_MEMORY == pb_data->state && SUCCEED != pb_history_check_age(pb_data))
 		{
@@ -776,7 +1028,7 @@ void	zbx_pb_history_close(zbx_pb_history_data_t *data)
 		}
 		else if (PB_MEMORY == get_pb_dst(pb_data->state))
 		{
-			if (NULL == (next = pb_history_add_rows_mem(pb_data, &data->rows)))
+			if (NULL == (next = pb_history_add_rows_mem(pb_data, &data->rows, NULL)))
 				goto out;
 
 			if (PB_DATABASE_MEMORY == pb_data->state)
@@ -791,16 +1043,37 @@ void	zbx_pb_history_close(zbx_pb_history_data_t *data)
 			}
 		}
 
-		/* not all rows were added to memory cache - flush them to database */
+		/* not all rows were added to memory cache - flush them to disk */
 		pb_data->db_handles_num++;
-		pb_unlock();
 
-		do
+		if (NULL != data->segments)
 		{
-			zbx_db_begin();
-			pb_history_add_rows_db(&data->rows, next, &lastid);
+			if (NULL != (next = pb_history_add_rows_segments(pb_data, &data->rows, next, &lastid)))
+				pb_history_add_rows_segments_fallback(pb_data, &data->rows, next);
 		}
-		while (ZBX_DB_DOWN == zbx_db_commit());
+		else
+		{
+			pb_unlock();
+
+			do
+			{
+				zbx_db_begin();
+				pb_history_add_rows_db(&data->rows, next, &lastid);
+			}
+			while (ZBX_DB_DOWN == zbx_db_commit());
+
+			pb_lock();
+		}
+	}
+	else if (NULL != data->segments)
+	{
+		zbx_list_item_t	*next;
+
+		pb_lock();
+		pb_history_set_row_ids(pb_data, &data->rows, data->rows_num);
+
+		if (NULL != (next = pb_history_add_rows_segments(pb_data, &data->rows, NULL, &lastid)))
+			pb_history_add_rows_segments_fallback(pb_data, &data->rows, next);
 	}
 	else
 	{
@@ -814,9 +1087,9 @@ void	zbx_pb_history_close(zbx_pb_history_data_t *data)
 		while (ZBX_DB_DOWN == zbx_db_commit());
 
 		lastid = zbx_db_insert_get_lastid(&data->db_insert);
-	}
 
-	pb_lock();
+		pb_lock();
+	}
 
 	if (pb_data->history_lastid_db < lastid)
 		pb_data->history_lastid_db = lastid;
@@ -859,28 +1132,89 @@ void	zbx_pb_history_write_meta_value(zbx_pb_history_data_t *data, zbx_uint64_t i
  *                                                                            *
  * Purpose: get history data for sending to server                            *
  *                                                                            *
+ * Parameters: j      - [IN/OUT] json output buffer                           *
+ *             format - [IN] history data format:                             *
+ *                             ZBX_PB_HISTORY_FORMAT_JSON - array of objects  *
+ *                             ZBX_PB_HISTORY_FORMAT_COLUMNS - columnar batch *
+ *                                 supported by the server                    *
+ *             lastid - [OUT] id of last added record                         *
+ *             more   - [OUT] set to ZBX_PROXY_DATA_MORE if there might be    *
+ *                            more data to read                               *
+ *                                                                            *
+ * Return value: The number of records exported.                              *
+ *                                                                            *
  ******************************************************************************/
-int	zbx_pb_history_get_rows(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
+int	zbx_pb_history_get_rows(struct zbx_json *j, int format, zbx_uint64_t *lastid, int *more)
 {
-	int	state, ret;
+	int			state, ret, segments = 0;
+	zbx_history_columns_t	*columns = NULL;
+	zbx_pb_t		*pb_data = get_pb_data();
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() lastid:" ZBX_FS_UI64, __func__, *lastid);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() lastid:" ZBX_FS_UI64 " format:%d", __func__, *lastid, format);
+
+	if (ZBX_PB_HISTORY_FORMAT_COLUMNS == format)
+		columns = zbx_history_columns_create();
 
 	pb_lock();
 
-	if (PB_MEMORY == (state = get_pb_src(get_pb_data()->state)))
-		ret = pb_history_get_mem(get_pb_data(), j, lastid, more);
+	if (PB_MEMORY == (state = get_pb_src(pb_data->state)))
+	{
+		ret = pb_history_get_mem(pb_data, j, columns, lastid, more);
+	}
+	else if (NULL != pb_data->history_segments)
+	{
+		/* proxy history table records written before enabling segment store are uploaded first */
+		if (pb_data->history_lastid_sent >= pb_data->history_segments->table_maxid)
+			segments = 1;
+	}
 
 	pb_unlock();
 
 	if (PB_MEMORY != state)
-		ret = pb_history_get_db(j, lastid, more);
+	{
+		if (0 != segments)
+			ret = pb_history_get_segments(pb_data, j, columns, lastid, more);
+		else
+			ret = pb_history_get_db(j, columns, lastid, more);
+	}
+
+	if (NULL != columns)
+	{
+		if (0 != ret)
+			zbx_history_columns_export(columns, ZBX_PROTO_TAG_HISTORY_COLUMNS, j);
+
+		zbx_history_columns_free(columns);
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() rows:%d", __func__, ret);
 
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get history data format supported by server                       *
+ *                                                                            *
+ * Parameters: jp - [IN] server request or response                           *
+ *                                                                            *
+ * Return value: ZBX_PB_HISTORY_FORMAT_COLUMNS - server accepts columnar      *
+ *                                               history data batches         *
+ *               ZBX_PB_HISTORY_FORMAT_JSON    - otherwise                    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_get_format(const struct zbx_json_parse *jp)
+{
+	char	value[32];
+
+	if (SUCCEED == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_HISTORY_FORMAT, value, sizeof(value), NULL) &&
+			0 == strcmp(value, ZBX_PROTO_VALUE_HISTORY_FORMAT_COLUMNS))
+	{
+		return ZBX_PB_HISTORY_FORMAT_COLUMNS;
+	}
+
+	return ZBX_PB_HISTORY_FORMAT_JSON;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: update database lastid/clear memory records                       *
@@ -900,6 +1234,9 @@ void	zbx_pb_set_history_lastid(const zbx_uint64_t lastid)
 	if (PB_MEMORY == (state = get_pb_src(pb_data->state)))
 		pb_history_clear(pb_data, lastid);
 
+	if (NULL != pb_data->history_segments)
+		(void)pb_segments_reclaim(pb_data->history_segments, lastid, time(NULL) - pb_data->offline_buffer);
+
 	pb_unlock();
 
 	if (PB_DATABASE == state)
@@ -908,6 +1245,40 @@ void	zbx_pb_set_history_lastid(const zbx_uint64_t lastid)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove history segments with records older than offline buffer    *
+ *                                                                            *
+ * Parameters: now - [IN] current timestamp                                   *
+ *                                                                            *
+ * Return value: The number of removed records.                               *
+ *                                                                            *
+ * Comments: Uploaded segments are removed when server confirms the upload,   *
+ *           this also expires segments while server is not reachable.        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_housekeep(int now)
+{
+	int		records = 0;
+	zbx_pb_t	*pb_data = get_pb_data();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	pb_lock();
+
+	if (NULL != pb_data->history_segments)
+	{
+		records = pb_segments_reclaim(pb_data->history_segments, pb_data->history_lastid_sent,
+				(time_t)now - pb_data->offline_buffer);
+	}
+
+	pb_unlock();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() records:%d", __func__, records);
+
+	return records;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: return number of unsent history rows                              *
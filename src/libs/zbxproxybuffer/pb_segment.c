@@ -0,0 +1,980 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "pb_segment.h"
+#include "proxybuffer.h"
+#include "zbxalgo.h"
+#include "zbxcommon.h"
+#include "zbxstr.h"
+
+#include <sys/mman.h>
+#include "zlib.h"
+
+/*
+ * Proxy history segment store.
+ *
+ * History records are appended to preallocated segment files, which are mapped into memory of every process
+ * accessing them. Segment metadata is kept in proxy buffer shared memory and is protected by the proxy buffer
+ * lock. Data written before the segment size was published under the lock is never modified, so readers scan
+ * segments without locking and return records pointing directly into the mapped files.
+ *
+ * Segment file layout:
+ *   pb_segment_header_t
+ *   pb_segment_record_t, value, source, padding to 8 bytes
+ *   ...
+ *   zero bytes up to the end of file
+ */
+
+#define PB_SEGMENT_MAGIC	"ZBXPBHS1"
+#define PB_SEGMENT_VERSION	1
+#define PB_SEGMENT_PREFIX	"history-"
+#define PB_SEGMENT_SUFFIX	".seg"
+
+/* percentage of available disk space used by segments when their total size is not configured */
+#define PB_SEGMENTS_DISK_SHARE	90
+
+typedef struct
+{
+	char		magic[8];
+	zbx_uint32_t	version;
+	zbx_uint32_t	header_size;
+	zbx_uint64_t	seq;
+	zbx_uint64_t	file_size;
+	unsigned char	reserved[32];
+}
+pb_segment_header_t;
+
+typedef struct
+{
+	zbx_uint32_t	size;		/* record size, including header and padding */
+	zbx_uint32_t	crc;		/* crc32 of the record data following this field */
+	zbx_uint64_t	id;
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	lastlogsize;
+	zbx_int64_t	write_clock;
+	int		clock;
+	int		ns;
+	int		timestamp;
+	int		severity;
+	int		logeventid;
+	int		state;
+	int		mtime;
+	int		flags;
+	zbx_uint32_t	value_len;	/* value length, including terminating zero */
+	zbx_uint32_t	source_len;	/* source length, including terminating zero */
+}
+pb_segment_record_t;
+
+/* process local segment file mapping */
+typedef struct
+{
+	zbx_uint64_t	seq;
+	unsigned char	*addr;
+	size_t		size;
+}
+pb_segment_map_t;
+
+/* process local position of the last read record, used to resume reading without scanning segment */
+typedef struct
+{
+	zbx_uint64_t	seq;
+	zbx_uint64_t	offset;
+	zbx_uint64_t	id;
+}
+pb_segment_cursor_t;
+
+typedef struct
+{
+	zbx_uint64_t			id;
+	const pb_segment_record_t	*record;
+}
+pb_segment_ref_t;
+
+ZBX_VECTOR_DECL(pb_segment_ref, pb_segment_ref_t)
+ZBX_VECTOR_IMPL(pb_segment_ref, pb_segment_ref_t)
+
+ZBX_VECTOR_IMPL(pb_segment, zbx_pb_segment_t)
+
+static zbx_hashset_t		segment_maps;
+static int			segment_maps_init = 0;
+static pb_segment_cursor_t	segment_cursor;
+
+static char	*pb_segment_get_path(const char *dir, zbx_uint64_t seq)
+{
+	return zbx_dsprintf(NULL, "%s/" PB_SEGMENT_PREFIX ZBX_FS_UX64 PB_SEGMENT_SUFFIX, dir, seq);
+}
+
+static zbx_uint32_t	pb_segment_record_crc(const pb_segment_record_t *record)
+{
+	const unsigned char	*ptr = (const unsigned char *)&record->id;
+	size_t			len;
+
+	len = sizeof(pb_segment_record_t) - offsetof(pb_segment_record_t, id) + record->value_len +
+			record->source_len;
+
+	return (zbx_uint32_t)crc32(crc32(0L, Z_NULL, 0), ptr, (uInt)len);
+}
+
+static pb_segment_map_t	*pb_segment_map_get(zbx_uint64_t seq)
+{
+	if (0 == segment_maps_init)
+	{
+		zbx_hashset_create(&segment_maps, 16, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		segment_maps_init = 1;
+	}
+
+	return (pb_segment_map_t *)zbx_hashset_search(&segment_maps, &seq);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: map segment file into process memory                              *
+ *                                                                            *
+ * Parameters: dir - [IN] segment directory                                   *
+ *             seq - [IN] segment sequence number                             *
+ *                                                                            *
+ * Return value: The segment mapping or NULL if the segment file cannot be    *
+ *               mapped.                                                      *
+ *                                                                            *
+ * Comments: The mapping is cached until the segment is unmapped by           *
+ *           pb_segment_unmap_stale().                                        *
+ *                                                                            *
+ ******************************************************************************/
+static pb_segment_map_t	*pb_segment_map(const char *dir, zbx_uint64_t seq)
+{
+	pb_segment_map_t	*map, map_local;
+	char			*path;
+	int			fd;
+	zbx_stat_t		st;
+	void			*addr;
+
+	if (NULL != (map = pb_segment_map_get(seq)))
+		return map;
+
+	path = pb_segment_get_path(dir, seq);
+
+	if (-1 == (fd = open(path, O_RDWR)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot open proxy buffer segment \"%s\": %s", path, zbx_strerror(errno));
+		goto out;
+	}
+
+	if (0 != zbx_fstat(fd, &st) || (off_t)sizeof(pb_segment_header_t) > st.st_size)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid proxy buffer segment \"%s\"", path);
+		close(fd);
+		goto out;
+	}
+
+	if (MAP_FAILED == (addr = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot map proxy buffer segment \"%s\": %s", path, zbx_strerror(errno));
+		close(fd);
+		goto out;
+	}
+
+	close(fd);
+
+	map_local.seq = seq;
+	map_local.addr = (unsigned char *)addr;
+	map_local.size = (size_t)st.st_size;
+	map = (pb_segment_map_t *)zbx_hashset_insert(&segment_maps, &map_local, sizeof(map_local));
+out:
+	zbx_free(path);
+
+	return map;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: unmap segments that were removed from segment store               *
+ *                                                                            *
+ * Parameters: seq_min - [IN] sequence number of the oldest existing segment  *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_segment_unmap_stale(zbx_uint64_t seq_min)
+{
+	zbx_hashset_iter_t	iter;
+	pb_segment_map_t	*map;
+
+	if (0 == segment_maps_init)
+		return;
+
+	zbx_hashset_iter_reset(&segment_maps, &iter);
+
+	while (NULL != (map = (pb_segment_map_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (map->seq >= seq_min)
+			continue;
+
+		(void)munmap(map->addr, map->size);
+		zbx_hashset_iter_remove(&iter);
+	}
+}
+
+static void	pb_segment_unmap(zbx_uint64_t seq)
+{
+	pb_segment_map_t	*map;
+
+	if (NULL != (map = pb_segment_map_get(seq)))
+	{
+		(void)munmap(map->addr, map->size);
+		zbx_hashset_remove_direct(&segment_maps, map);
+	}
+}
+
+static void	pb_segment_unlink(const char *dir, zbx_uint64_t seq)
+{
+	char	*path;
+
+	pb_segment_unmap(seq);
+
+	path = pb_segment_get_path(dir, seq);
+
+	if (0 != unlink(path))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove proxy buffer segment \"%s\": %s", path,
+				zbx_strerror(errno));
+	}
+
+	zbx_free(path);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove the oldest segment from segment store                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_segments_pop(zbx_pb_segments_t *segs)
+{
+	zbx_pb_segment_t	*seg;
+
+	if (SUCCEED != zbx_list_pop(&segs->segments, (void **)&seg))
+		return;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "removing proxy buffer segment seq:" ZBX_FS_UI64 " records:%d ids:" ZBX_FS_UI64
+			"-" ZBX_FS_UI64, seg->seq, seg->records_num, seg->min_id, seg->max_id);
+
+	pb_segment_unlink(segs->dir, seg->seq);
+
+	if (seg->seq == segs->active_seq)
+		segs->active_seq = 0;
+
+	segs->total_size -= seg->file_size;
+	pb_free(seg);
+}
+
+static zbx_pb_segment_t	*pb_segments_get_active(zbx_pb_segments_t *segs)
+{
+	zbx_pb_segment_t	*seg;
+
+	if (0 == segs->active_seq || NULL == segs->segments.tail)
+		return NULL;
+
+	seg = (zbx_pb_segment_t *)segs->segments.tail->data;
+
+	return seg->seq == segs->active_seq ? seg : NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create new segment file and make it active                        *
+ *                                                                            *
+ * Return value: The created segment or NULL in the case of failure.          *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_pb_segment_t	*pb_segments_add(zbx_pb_segments_t *segs)
+{
+	zbx_pb_segment_t	*seg;
+	pb_segment_map_t	*map;
+	pb_segment_header_t	*header;
+	char			*path;
+	int			fd, err;
+	zbx_uint64_t		seq;
+
+	if (NULL != (seg = pb_segments_get_active(segs)) && NULL != (map = pb_segment_map(segs->dir, seg->seq)))
+	{
+		/* segment is sealed, initiate its write back without blocking the writer */
+		(void)msync(map->addr, map->size, MS_ASYNC);
+	}
+
+	segs->active_seq = 0;
+
+	/* expire old records when rotating, upload confirmations do not arrive while server is unreachable */
+	(void)pb_segments_reclaim(segs, 0, time(NULL) - segs->offline_buffer);
+
+	while (0 != segs->total_size_max && segs->total_size + segs->segment_size > segs->total_size_max &&
+			NULL != segs->segments.head)
+	{
+		seg = (zbx_pb_segment_t *)segs->segments.head->data;
+
+		if (0 != seg->records_num)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "proxy buffer segment storage is full, discarding %d history"
+					" records", seg->records_num);
+		}
+
+		pb_segments_pop(segs);
+	}
+
+	if (NULL != segs->segments.head)
+		pb_segment_unmap_stale(((zbx_pb_segment_t *)segs->segments.head->data)->seq);
+
+	seq = ++segs->seq;
+	path = pb_segment_get_path(segs->dir, seq);
+	seg = NULL;
+
+	if (-1 == (fd = open(path, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP)))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot create proxy buffer segment \"%s\": %s", path, zbx_strerror(errno));
+		goto out;
+	}
+
+	/* preallocate disk space so running out of it is reported here instead of faulting on mapped memory */
+	if (0 != (err = posix_fallocate(fd, 0, (off_t)segs->segment_size)))
+	{
+		zabbix_log(LOG_LEVEL_ERR, "cannot allocate space for proxy buffer segment \"%s\": %s", path,
+				zbx_strerror(err));
+		close(fd);
+		goto fail;
+	}
+
+	close(fd);
+
+	if (NULL == (map = pb_segment_map(segs->dir, seq)))
+		goto fail;
+
+	header = (pb_segment_header_t *)map->addr;
+	memcpy(header->magic, PB_SEGMENT_MAGIC, sizeof(header->magic));
+	header->version = PB_SEGMENT_VERSION;
+	header->header_size = sizeof(pb_segment_header_t);
+	header->seq = seq;
+	header->file_size = segs->segment_size;
+
+	if (NULL == (seg = (zbx_pb_segment_t *)pb_malloc(sizeof(zbx_pb_segment_t))))
+		goto fail;
+
+	memset(seg, 0, sizeof(zbx_pb_segment_t));
+	seg->seq = seq;
+	seg->size = sizeof(pb_segment_header_t);
+	seg->file_size = segs->segment_size;
+	seg->sorted = 1;
+
+	if (SUCCEED != zbx_list_append(&segs->segments, seg, NULL))
+	{
+		pb_free(seg);
+		seg = NULL;
+		goto fail;
+	}
+
+	segs->total_size += seg->file_size;
+	segs->active_seq = seq;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "created proxy buffer segment seq:" ZBX_FS_UI64, seq);
+
+	goto out;
+fail:
+	pb_segment_unlink(segs->dir, seq);
+out:
+	zbx_free(path);
+
+	return seg;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: validate segment file and restore its metadata                    *
+ *                                                                            *
+ * Parameters: segs - [IN] segment store                                      *
+ *             seq  - [IN] segment sequence number                            *
+ *             seg  - [OUT] segment metadata                                  *
+ *                                                                            *
+ * Return value: SUCCEED - segment contains valid records                     *
+ *               FAIL    - segment is invalid or empty                        *
+ *                                                                            *
+ * Comments: Records are validated up to the first invalid one, which is      *
+ *           expected to be a partially written record left by a crash.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_segment_load(zbx_pb_segments_t *segs, zbx_uint64_t seq, zbx_pb_segment_t *seg)
+{
+	pb_segment_map_t		*map;
+	const pb_segment_header_t	*header;
+	zbx_uint64_t			offset;
+
+	if (NULL == (map = pb_segment_map(segs->dir, seq)))
+		return FAIL;
+
+	header = (const pb_segment_header_t *)map->addr;
+
+	if (0 != memcmp(header->magic, PB_SEGMENT_MAGIC, sizeof(header->magic)) ||
+			PB_SEGMENT_VERSION != header->version || sizeof(pb_segment_header_t) != header->header_size ||
+			seq != header->seq || map->size != header->file_size)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid proxy buffer segment header, seq:" ZBX_FS_UI64, seq);
+		return FAIL;
+	}
+
+	memset(seg, 0, sizeof(zbx_pb_segment_t));
+	seg->seq = seq;
+	seg->file_size = map->size;
+	seg->sorted = 1;
+
+	for (offset = sizeof(pb_segment_header_t); offset + sizeof(pb_segment_record_t) <= map->size;)
+	{
+		const pb_segment_record_t	*record = (const pb_segment_record_t *)(map->addr + offset);
+		const char			*value;
+
+		if (0 == record->size)
+			break;
+
+		if (sizeof(pb_segment_record_t) > record->size || 0 != record->size % 8 ||
+				record->size > map->size - offset || 0 == record->value_len || 0 == record->source_len ||
+				(zbx_uint64_t)record->value_len + record->source_len >
+				record->size - sizeof(pb_segment_record_t) ||
+				pb_segment_record_crc(record) != record->crc)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "discarding corrupted records of proxy buffer segment seq:"
+					ZBX_FS_UI64 " at offset " ZBX_FS_UI64, seq, offset);
+			break;
+		}
+
+		value = (const char *)(record + 1);
+
+		if ('\0' != value[record->value_len - 1] ||
+				'\0' != value[record->value_len + record->source_len - 1])
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "discarding corrupted records of proxy buffer segment seq:"
+					ZBX_FS_UI64 " at offset " ZBX_FS_UI64, seq, offset);
+			break;
+		}
+
+		if (0 == seg->records_num)
+			seg->min_id = record->id;
+		else if (record->id <= seg->max_id)
+			seg->sorted = 0;
+
+		if (record->id < seg->min_id)
+			seg->min_id = record->id;
+
+		if (record->id > seg->max_id)
+			seg->max_id = record->id;
+
+		if ((time_t)record->write_clock > seg->write_clock)
+			seg->write_clock = (time_t)record->write_clock;
+
+		seg->records_num++;
+		offset += record->size;
+	}
+
+	seg->size = offset;
+
+	return 0 != seg->records_num ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get default limit of all segments size                            *
+ *                                                                            *
+ * Parameters: dir          - [IN] segment directory                          *
+ *             segment_size - [IN] segment file size                          *
+ *                                                                            *
+ * Return value: The share of disk space available in segment directory,      *
+ *               but not less than one segment, or 0 if the available disk    *
+ *               space cannot be determined.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	pb_segments_get_default_size(const char *dir, zbx_uint64_t segment_size)
+{
+#ifdef HAVE_SYS_STATVFS_H
+	struct statvfs	s;
+	zbx_uint64_t	size;
+
+	if (0 != statvfs(dir, &s))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot get disk space of proxy buffer segment directory \"%s\": %s",
+				dir, zbx_strerror(errno));
+		return 0;
+	}
+
+	size = (zbx_uint64_t)s.f_bavail * (zbx_uint64_t)s.f_frsize / 100 * PB_SEGMENTS_DISK_SHARE;
+
+	return MAX(size, segment_size);
+#else
+	ZBX_UNUSED(dir);
+	ZBX_UNUSED(segment_size);
+
+	return 0;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: create segment store                                              *
+ *                                                                            *
+ * Parameters: dir            - [IN] segment directory                        *
+ *             segment_size   - [IN] segment file size                        *
+ *             total_size_max - [IN] maximum size of all segments, 0 to limit *
+ *                                   it by available disk space               *
+ *             offline_buffer - [IN] offline buffer in seconds                *
+ *             error          - [OUT] error message                           *
+ *                                                                            *
+ * Return value: The segment store allocated in proxy buffer shared memory    *
+ *               or NULL in the case of failure.                              *
+ *                                                                            *
+ ******************************************************************************/
+zbx_pb_segments_t	*pb_segments_create(const char *dir, zbx_uint64_t segment_size, zbx_uint64_t total_size_max,
+		int offline_buffer, char **error)
+{
+	zbx_pb_segments_t	*segs;
+	int			total_size_auto = 0;
+
+	if (0 != access(dir, R_OK | W_OK | X_OK))
+	{
+		*error = zbx_dsprintf(NULL, "cannot access proxy buffer segment directory \"%s\": %s", dir,
+				zbx_strerror(errno));
+		return NULL;
+	}
+
+	if (0 == total_size_max && 0 != (total_size_max = pb_segments_get_default_size(dir, segment_size)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "limiting proxy buffer segments to " ZBX_FS_UI64 " bytes", total_size_max);
+		total_size_auto = 1;
+	}
+
+	if (NULL == (segs = (zbx_pb_segments_t *)pb_malloc(sizeof(zbx_pb_segments_t))))
+	{
+		*error = zbx_strdup(NULL, "cannot allocate proxy buffer segment store");
+		return NULL;
+	}
+
+	memset(segs, 0, sizeof(zbx_pb_segments_t));
+
+	if (NULL == (segs->dir = pb_strdup(dir)))
+	{
+		pb_free(segs);
+		*error = zbx_strdup(NULL, "cannot allocate proxy buffer segment store");
+		return NULL;
+	}
+
+	segs->segment_size = segment_size;
+	segs->total_size_max = total_size_max;
+	segs->total_size_auto = total_size_auto;
+	segs->offline_buffer = offline_buffer;
+
+	return segs;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: load existing segments on startup                                 *
+ *                                                                            *
+ * Parameters: segs   - [IN] segment store                                    *
+ *             lastid - [IN] id of the last record uploaded to server         *
+ *             maxid  - [OUT] maximum record id in segments                   *
+ *                                                                            *
+ * Comments: Segments without unsent records are removed. Loaded segments     *
+ *           are not appended to, new records are written to a new segment.   *
+ *                                                                            *
+ ******************************************************************************/
+void	pb_segments_recover(zbx_pb_segments_t *segs, zbx_uint64_t lastid, zbx_uint64_t *maxid)
+{
+	DIR			*dir;
+	struct dirent		*entry;
+	zbx_vector_uint64_t	seqs;
+	int			i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() dir:%s lastid:" ZBX_FS_UI64, __func__, segs->dir, lastid);
+
+	*maxid = 0;
+
+	if (NULL == (dir = opendir(segs->dir)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open proxy buffer segment directory \"%s\": %s", segs->dir,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	zbx_vector_uint64_create(&seqs);
+
+	while (NULL != (entry = readdir(dir)))
+	{
+		zbx_uint64_t	seq;
+		char		name[64];
+
+		if (0 != strncmp(entry->d_name, PB_SEGMENT_PREFIX, ZBX_CONST_STRLEN(PB_SEGMENT_PREFIX)))
+			continue;
+
+		if (1 != sscanf(entry->d_name + ZBX_CONST_STRLEN(PB_SEGMENT_PREFIX), ZBX_FS_UX64, &seq))
+			continue;
+
+		zbx_snprintf(name, sizeof(name), PB_SEGMENT_PREFIX ZBX_FS_UX64 PB_SEGMENT_SUFFIX, seq);
+
+		if (0 == strcmp(entry->d_name, name))
+			zbx_vector_uint64_append(&seqs, seq);
+	}
+
+	closedir(dir);
+
+	zbx_vector_uint64_sort(&seqs, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (i = 0; i < seqs.values_num; i++)
+	{
+		zbx_pb_segment_t	seg_local, *seg;
+
+		segs->seq = seqs.values[i];
+
+		if (SUCCEED != pb_segment_load(segs, seqs.values[i], &seg_local) || seg_local.max_id <= lastid)
+		{
+			pb_segment_unlink(segs->dir, seqs.values[i]);
+			continue;
+		}
+
+		if (NULL == (seg = (zbx_pb_segment_t *)pb_malloc(sizeof(zbx_pb_segment_t))))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "not enough memory to load proxy buffer segment seq:" ZBX_FS_UI64,
+					seqs.values[i]);
+			pb_segment_unmap(seqs.values[i]);
+			continue;
+		}
+
+		*seg = seg_local;
+
+		if (SUCCEED != zbx_list_append(&segs->segments, seg, NULL))
+		{
+			pb_free(seg);
+			pb_segment_unmap(seqs.values[i]);
+			continue;
+		}
+
+		segs->total_size += seg->file_size;
+
+		if (seg->max_id > *maxid)
+			*maxid = seg->max_id;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "loaded proxy buffer segment seq:" ZBX_FS_UI64 " records:%d ids:"
+				ZBX_FS_UI64 "-" ZBX_FS_UI64, seg->seq, seg->records_num, seg->min_id, seg->max_id);
+	}
+
+	zbx_vector_uint64_destroy(&seqs);
+
+	/* recovered segments already occupy disk space that was not available when setting the default limit */
+	if (0 != segs->total_size_auto)
+		segs->total_size_max += segs->total_size;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() maxid:" ZBX_FS_UI64, __func__, *maxid);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: append history record to the active segment                       *
+ *                                                                            *
+ * Parameters: segs - [IN] segment store                                      *
+ *             row  - [IN] history record with id assigned                    *
+ *                                                                            *
+ * Return value: SUCCEED - record was written                                 *
+ *               FAIL    - record is too large or segment cannot be created   *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer locked.           *
+ *                                                                            *
+ ******************************************************************************/
+int	pb_segments_append(zbx_pb_segments_t *segs, const zbx_pb_history_t *row)
+{
+	zbx_pb_segment_t	*seg;
+	pb_segment_map_t	*map;
+	pb_segment_record_t	*record;
+	const char		*value, *source;
+	size_t			value_len, source_len, size;
+
+	value = ZBX_NULL2EMPTY_STR(row->value);
+	source = ZBX_NULL2EMPTY_STR(row->source);
+	value_len = strlen(value) + 1;
+	source_len = strlen(source) + 1;
+	size = ZBX_SIZE_T_ALIGN8(sizeof(pb_segment_record_t) + value_len + source_len);
+
+	if (size > segs->segment_size - sizeof(pb_segment_header_t))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "history record with size " ZBX_FS_SIZE_T " is too large for proxy"
+				" buffer segment, discarding", (zbx_fs_size_t)size);
+		return FAIL;
+	}
+
+	if (NULL == (seg = pb_segments_get_active(segs)) || seg->size + size > seg->file_size)
+	{
+		if (NULL == (seg = pb_segments_add(segs)))
+			return FAIL;
+	}
+
+	if (NULL == (map = pb_segment_map(segs->dir, seg->seq)))
+		return FAIL;
+
+	record = (pb_segment_record_t *)(map->addr + seg->size);
+
+	record->size = (zbx_uint32_t)size;
+	record->id = row->id;
+	record->itemid = row->itemid;
+	record->lastlogsize = row->lastlogsize;
+	record->write_clock = (zbx_int64_t)row->write_clock;
+	record->clock = row->ts.sec;
+	record->ns = row->ts.ns;
+	record->timestamp = row->timestamp;
+	record->severity = row->severity;
+	record->logeventid = row->logeventid;
+	record->state = row->state;
+	record->mtime = row->mtime;
+	record->flags = row->flags;
+	record->value_len = (zbx_uint32_t)value_len;
+	record->source_len = (zbx_uint32_t)source_len;
+	memcpy(record + 1, value, value_len);
+	memcpy((char *)(record + 1) + value_len, source, source_len);
+	record->crc = pb_segment_record_crc(record);
+
+	if (0 == seg->records_num || row->id < seg->min_id)
+		seg->min_id = row->id;
+
+	if (0 != seg->records_num && row->id <= seg->max_id)
+		seg->sorted = 0;
+
+	if (row->id > seg->max_id)
+		seg->max_id = row->id;
+
+	if (row->write_clock > seg->write_clock)
+		seg->write_clock = row->write_clock;
+
+	seg->records_num++;
+	seg->size += size;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: remove uploaded and expired segments                              *
+ *                                                                            *
+ * Parameters: segs         - [IN] segment store                              *
+ *             lastid       - [IN] id of the last record uploaded to server   *
+ *             expire_clock - [IN] segments with all records written before   *
+ *                                 this time are removed even if not uploaded *
+ *                                                                            *
+ * Return value: The number of removed records.                               *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer locked.           *
+ *                                                                            *
+ ******************************************************************************/
+int	pb_segments_reclaim(zbx_pb_segments_t *segs, zbx_uint64_t lastid, time_t expire_clock)
+{
+	zbx_pb_segment_t	*seg;
+	int			records_num = 0;
+
+	while (SUCCEED == zbx_list_peek(&segs->segments, (void **)&seg))
+	{
+		if (seg->max_id > lastid && (0 == seg->records_num || seg->write_clock >= expire_clock))
+			break;
+
+		if (seg->max_id > lastid)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "proxy buffer segment records are older than offline buffer,"
+					" discarding %d history records", seg->records_num);
+		}
+
+		records_num += seg->records_num;
+		pb_segments_pop(segs);
+	}
+
+	return records_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: copy segment metadata for reading without proxy buffer lock       *
+ *                                                                            *
+ * Comments: This function must be called with proxy buffer locked.           *
+ *                                                                            *
+ ******************************************************************************/
+void	pb_segments_snapshot(zbx_pb_segments_t *segs, zbx_vector_pb_segment_t *snapshot)
+{
+	zbx_list_iterator_t	li;
+	zbx_pb_segment_t	*seg;
+
+	zbx_list_iterator_init(&segs->segments, &li);
+
+	while (SUCCEED == zbx_list_iterator_next(&li))
+	{
+		(void)zbx_list_iterator_peek(&li, (void **)&seg);
+
+		if (0 != seg->records_num)
+			zbx_vector_pb_segment_append_ptr(snapshot, seg);
+	}
+
+	if (0 != snapshot->values_num)
+		pb_segment_unmap_stale(snapshot->values[0].seq);
+}
+
+static void	pb_segment_record_to_row(const pb_segment_record_t *record, zbx_pb_history_t *row)
+{
+	row->id = record->id;
+	row->itemid = record->itemid;
+	row->lastlogsize = record->lastlogsize;
+	row->ts.sec = record->clock;
+	row->ts.ns = record->ns;
+	row->value = (char *)(record + 1);
+	row->source = row->value + record->value_len;
+	row->timestamp = record->timestamp;
+	row->severity = record->severity;
+	row->logeventid = record->logeventid;
+	row->state = record->state;
+	row->mtime = record->mtime;
+	row->flags = record->flags;
+	row->write_clock = (time_t)record->write_clock;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read records from segments stored in ascending id order           *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_segments_read_sorted(const zbx_pb_segments_t *segs, const zbx_vector_pb_segment_t *snapshot,
+		zbx_uint64_t lastid, zbx_pb_history_t *rows, int rows_max)
+{
+	int	i, rows_num = 0;
+
+	for (i = 0; i < snapshot->values_num && rows_num < rows_max; i++)
+	{
+		const zbx_pb_segment_t	*seg = &snapshot->values[i];
+		pb_segment_map_t	*map;
+		zbx_uint64_t		offset = sizeof(pb_segment_header_t);
+
+		if (seg->max_id <= lastid)
+			continue;
+
+		/* segment might have been removed after expiring */
+		if (NULL == (map = pb_segment_map(segs->dir, seg->seq)))
+			continue;
+
+		if (segment_cursor.seq == seg->seq && segment_cursor.id == lastid && segment_cursor.offset <= seg->size)
+			offset = segment_cursor.offset;
+
+		while (offset < seg->size && rows_num < rows_max)
+		{
+			const pb_segment_record_t	*record = (const pb_segment_record_t *)(map->addr + offset);
+
+			offset += record->size;
+
+			if (record->id <= lastid)
+				continue;
+
+			pb_segment_record_to_row(record, &rows[rows_num++]);
+		}
+
+		if (0 != rows_num)
+		{
+			segment_cursor.seq = seg->seq;
+			segment_cursor.offset = offset;
+			segment_cursor.id = rows[rows_num - 1].id;
+		}
+	}
+
+	return rows_num;
+}
+
+static int	pb_segment_ref_compare(const void *d1, const void *d2)
+{
+	const pb_segment_ref_t	*r1 = (const pb_segment_ref_t *)d1;
+	const pb_segment_ref_t	*r2 = (const pb_segment_ref_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(r1->id, r2->id);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read records from segments not stored in ascending id order       *
+ *                                                                            *
+ * Comments: All unsent records are scanned and sorted by id. Record ids are  *
+ *           allocated under the same lock as records are written, so this is *
+ *           a fallback that is not expected during normal operation.         *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_segments_read_unsorted(const zbx_pb_segments_t *segs, const zbx_vector_pb_segment_t *snapshot,
+		zbx_uint64_t lastid, zbx_pb_history_t *rows, int rows_max)
+{
+	int				i, rows_num;
+	zbx_vector_pb_segment_ref_t	refs;
+
+	zbx_vector_pb_segment_ref_create(&refs);
+
+	for (i = 0; i < snapshot->values_num; i++)
+	{
+		const zbx_pb_segment_t	*seg = &snapshot->values[i];
+		pb_segment_map_t	*map;
+		zbx_uint64_t		offset;
+
+		if (seg->max_id <= lastid || NULL == (map = pb_segment_map(segs->dir, seg->seq)))
+			continue;
+
+		for (offset = sizeof(pb_segment_header_t); offset < seg->size;)
+		{
+			pb_segment_ref_t	ref;
+
+			ref.record = (const pb_segment_record_t *)(map->addr + offset);
+			offset += ref.record->size;
+
+			if ((ref.id = ref.record->id) > lastid)
+				zbx_vector_pb_segment_ref_append(&refs, ref);
+		}
+	}
+
+	zbx_vector_pb_segment_ref_sort(&refs, pb_segment_ref_compare);
+
+	for (rows_num = 0; rows_num < refs.values_num && rows_num < rows_max; rows_num++)
+		pb_segment_record_to_row(refs.values[rows_num].record, &rows[rows_num]);
+
+	zbx_vector_pb_segment_ref_destroy(&refs);
+
+	return rows_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: read history records following the specified id                   *
+ *                                                                            *
+ * Parameters: segs     - [IN] segment store                                  *
+ *             snapshot - [IN] segment metadata snapshot                      *
+ *             lastid   - [IN] id of the last read record                     *
+ *             rows     - [OUT] history records                               *
+ *             rows_max - [IN] maximum number of records to read              *
+ *                                                                            *
+ * Return value: The number of records read.                                  *
+ *                                                                            *
+ * Comments: Returned records point to mapped segment data and stay valid     *
+ *           until the next segment store call by this process.               *
+ *                                                                            *
+ ******************************************************************************/
+int	pb_segments_read(const zbx_pb_segments_t *segs, const zbx_vector_pb_segment_t *snapshot, zbx_uint64_t lastid,
+		zbx_pb_history_t *rows, int rows_max)
+{
+	int	i;
+
+	for (i = 0; i < snapshot->values_num; i++)
+	{
+		if (0 == snapshot->values[i].sorted ||
+				(0 != i && snapshot->values[i].min_id <= snapshot->values[i - 1].max_id))
+		{
+			return pb_segments_read_unsorted(segs, snapshot, lastid, rows, rows_max);
+		}
+	}
+
+	return pb_segments_read_sorted(segs, snapshot, lastid, rows, rows_max);
+}
@@ -0,0 +1,63 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_PB_SEGMENT_H
+#define ZABBIX_PB_SEGMENT_H
+
+#include "proxybuffer.h"
+
+/* history segment metadata, stored in proxy buffer shared memory */
+typedef struct
+{
+	zbx_uint64_t	seq;
+	zbx_uint64_t	min_id;
+	zbx_uint64_t	max_id;
+	zbx_uint64_t	size;		/* size of written data, including segment header */
+	zbx_uint64_t	file_size;
+	time_t		write_clock;	/* write time of the newest record */
+	int		records_num;
+	int		sorted;		/* records are stored in ascending id order */
+}
+zbx_pb_segment_t;
+
+ZBX_VECTOR_DECL(pb_segment, zbx_pb_segment_t)
+
+struct zbx_pb_segments
+{
+	char		*dir;
+	zbx_uint64_t	segment_size;
+	zbx_uint64_t	total_size_max;
+	zbx_uint64_t	total_size;
+	int		total_size_auto;	/* total_size_max is derived from available disk space */
+	int		offline_buffer;		/* records older than this are discarded when rotating segments */
+	zbx_uint64_t	seq;		/* sequence number of the last created segment */
+	zbx_uint64_t	active_seq;	/* sequence number of segment being written, 0 if none */
+
+	/* maximum record id in proxy_history table before switching to segment storage */
+	zbx_uint64_t	table_maxid;
+
+	zbx_list_t	segments;	/* zbx_pb_segment_t, ordered by sequence number */
+};
+
+zbx_pb_segments_t	*pb_segments_create(const char *dir, zbx_uint64_t segment_size, zbx_uint64_t total_size_max,
+		int offline_buffer, char **error);
+void	pb_segments_recover(zbx_pb_segments_t *segs, zbx_uint64_t lastid, zbx_uint64_t *maxid);
+int	pb_segments_append(zbx_pb_segments_t *segs, const zbx_pb_history_t *row);
+int	pb_segments_reclaim(zbx_pb_segments_t *segs, zbx_uint64_t lastid, time_t expire_clock);
+
+void	pb_segments_snapshot(zbx_pb_segments_t *segs, zbx_vector_pb_segment_t *snapshot);
+int	pb_segments_read(const zbx_pb_segments_t *segs, const zbx_vector_pb_segment_t *snapshot, zbx_uint64_t lastid,
+		zbx_pb_history_t *rows, int rows_max);
+
+#endif
@@ -16,6 +16,7 @@
 #include "pb_autoreg.h"
 #include "pb_discovery.h"
 #include "pb_history.h"
+#include "pb_segment.h"
 #include "zbxalgo.h"
 #include "zbxcommon.h"
 #include "zbxdb.h"
@@ -195,6 +196,29 @@ int	pb_free_space(zbx_pb_t *pb, size_t size)
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get maximum record id of proxy history table                      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	pb_get_maxid(const char *table)
+{
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+	zbx_uint64_t	maxid;
+
+	result = zbx_db_select("select max(id) from %s", table);
+
+	if (NULL != (row = zbx_db_fetch(result)))
+		ZBX_DBROW2UINT64(maxid, row[0]);
+	else
+		maxid = 0;
+
+	zbx_db_free_result(result);
+
+	return maxid;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: check if proxy history table has unsent data and update lastid    *
@@ -226,14 +250,7 @@ static int	pb_check_unsent_rows(const char *table, const char *field, zbx_uint64
 
 	zbx_db_free_result(result);
 
-	result = zbx_db_select("select max(id) from %s", table);
-
-	if (NULL != (row = zbx_db_fetch(result)))
-		ZBX_DBROW2UINT64(*maxid, row[0]);
-	else
-		*maxid = 0;
-
-	zbx_db_free_result(result);
+	*maxid = pb_get_maxid(table);
 
 	if (*lastid < *maxid)
 	{
@@ -256,6 +273,39 @@ static int	pb_check_unsent_rows(const char *table, const char *field, zbx_uint64
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: load history segments and check if there are unsent records       *
+ *                                                                            *
+ * Return value: SUCCEED - segments or proxy history table have unsent data   *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: History records are written to segments, but proxy history table *
+ *           still might contain records written before segment storage was   *
+ *           enabled. Those are uploaded first, segment record ids are        *
+ *           allocated after the table records.                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_init_history_segments(zbx_pb_t *pb)
+{
+	zbx_uint64_t	lastid, maxid, segments_maxid;
+
+	lastid = pb_get_lastid("proxy_history", "history_lastid");
+	maxid = pb_get_maxid("proxy_history");
+
+	pb_segments_recover(pb->history_segments, lastid, &segments_maxid);
+	pb->history_segments->table_maxid = maxid;
+
+	pb->history_lastid_sent = lastid;
+	pb->history_lastid_db = MAX(maxid, segments_maxid);
+	pb->history_nextid = MAX(pb->history_lastid_db, lastid) + 1;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() lastid:" ZBX_FS_UI64 " table maxid:" ZBX_FS_UI64 " segments maxid:"
+			ZBX_FS_UI64, __func__, lastid, maxid, segments_maxid);
+
+	return lastid < pb->history_lastid_db ? SUCCEED : FAIL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: set cache state and log the changes                               *
@@ -307,9 +357,16 @@ static void	pb_init_state(zbx_pb_t *pb)
 		return;
 	}
 
-	history_ret = pb_check_unsent_rows("proxy_history", "history_lastid", &lastid, &maxid);
-	pb->history_lastid_db = maxid;
-	pb->history_lastid_sent = lastid;
+	if (NULL != pb->history_segments)
+	{
+		history_ret = pb_init_history_segments(pb);
+	}
+	else
+	{
+		history_ret = pb_check_unsent_rows("proxy_history", "history_lastid", &lastid, &maxid);
+		pb->history_lastid_db = maxid;
+		pb->history_lastid_sent = lastid;
+	}
 
 	discovery_ret = pb_check_unsent_rows("proxy_dhistory", "dhistory_lastid", &lastid, &maxid);
 	autoreg_ret = pb_check_unsent_rows("proxy_autoreg_host", "autoreg_host_lastid", &lastid, &maxid);
@@ -671,13 +728,19 @@ void	pb_wait_handles(const zbx_vector_uint64_t *handleids)
  *             size  - [IN] cache size in bytes                               *
  *             age   - [IN] maximum allowed data age                          *
  *             offline_buffer [IN] offline buffer in seconds                  *
+ *             segment_dir        - [IN] history segment directory, NULL or   *
+ *                                       empty to store history in database   *
+ *             segment_size       - [IN] history segment file size            *
+ *             segment_total_size - [IN] maximum size of all history segment  *
+ *                                       files, 0 - unlimited                 *
  *             error - [OUT] error message                                    *
  *                                                                            *
  * Return value: SUCCEED - proxy buffer was created successfully              *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_pb_create(int mode, zbx_uint64_t size, int age, int offline_buffer, char **error)
+int	zbx_pb_create(int mode, zbx_uint64_t size, int age, int offline_buffer, const char *segment_dir,
+		zbx_uint64_t segment_size, zbx_uint64_t segment_total_size, char **error)
 {
 	int	ret = FAIL, allow_oom;
 
@@ -688,6 +751,10 @@ int	zbx_pb_create(int mode, zbx_uint64_t size, int age, int offline_buffer, char
 		/* allocate proxy buffer only to store statistics and track opened history handles */
 		size = ZBX_KIBIBYTE * 16;
 
+		/* reserve space for history segment metadata */
+		if (NULL != segment_dir && '\0' != *segment_dir)
+			size += ZBX_MEBIBYTE;
+
 		allow_oom = 0;
 	}
 	else
@@ -718,6 +785,18 @@ int	zbx_pb_create(int mode, zbx_uint64_t size, int age, int offline_buffer, char
 	pb_data->max_age = age;
 	pb_data->offline_buffer = offline_buffer;
 
+	if (NULL != segment_dir && '\0' != *segment_dir)
+	{
+		if (NULL == (pb_data->history_segments = pb_segments_create(segment_dir, segment_size,
+				segment_total_size, offline_buffer, error)))
+		{
+			goto out;
+		}
+
+		zbx_list_create_ext(&pb_data->history_segments->segments, __pb_shmem_malloc_func,
+				__pb_shmem_free_func);
+	}
+
 	ret = SUCCEED;
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s(): %s", __func__, ZBX_NULL2EMPTY_STR(*error));
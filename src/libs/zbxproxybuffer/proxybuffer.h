@@ -96,6 +96,8 @@ typedef struct
 }
 zbx_pb_autoreg_t;
 
+typedef struct zbx_pb_segments zbx_pb_segments_t;
+
 typedef struct
 {
 	zbx_list_t		history;
@@ -122,6 +124,10 @@ typedef struct
 
 	zbx_uint64_t		history_lastid_mem;
 
+	/* history segment store, NULL if history is stored in database */
+	zbx_pb_segments_t	*history_segments;
+	zbx_uint64_t		history_nextid;
+
 	/* opened data handle tracking */
 	zbx_uint64_t		handleid;
 	zbx_vector_uint64_t	history_handleids;
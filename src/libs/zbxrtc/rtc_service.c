@@ -205,7 +205,7 @@ static void	rtc_process_diaginfo(const char *data, char **result)
 	if (0 == strcmp(buf, "all"))
 	{
 		scope = (1 << ZBX_DIAGINFO_HISTORYCACHE) | (1 << ZBX_DIAGINFO_PREPROCESSING) |
-				(1 << ZBX_DIAGINFO_LOCKS);
+				(1 << ZBX_DIAGINFO_LOCKS) | (1 << ZBX_DIAGINFO_DATABASE);
 	}
 	else if (0 == strcmp(buf, ZBX_DIAG_HISTORYCACHE))
 	{
@@ -219,6 +219,10 @@ static void	rtc_process_diaginfo(const char *data, char **result)
 	{
 		scope = 1 << ZBX_DIAGINFO_LOCKS;
 	}
+	else if (0 == strcmp(buf, ZBX_DIAG_DATABASE))
+	{
+		scope = 1 << ZBX_DIAGINFO_DATABASE;
+	}
 	else
 	{
 		if (NULL == *result)
@@ -92,3 +92,60 @@ zbx_uint32_t	zbx_deserialize_uint31_compact(const unsigned char *ptr, zbx_uint32
 		return pos;
 	}
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serialize 64 bit unsigned integer into variable length byte       *
+ *          stream with 7 value bits per byte                                 *
+ *                                                                            *
+ * Parameters: ptr   - [OUT] the output buffer, must have space for at least  *
+ *                           ZBX_SERIALIZE_UINT64_COMPACT_MAX bytes           *
+ *             value - [IN] the value to serialize                            *
+ *                                                                            *
+ * Return value: The number of bytes written to the buffer.                   *
+ *                                                                            *
+ * Comments: Low order bits are written first, the high bit of each byte is   *
+ *           set if more bytes follow.                                        *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_serialize_uint64_compact(unsigned char *ptr, zbx_uint64_t value)
+{
+	zbx_uint32_t	len = 0;
+
+	while (0x7f < value)
+	{
+		ptr[len++] = (unsigned char)(0x80 | (value & 0x7f));
+		value >>= 7;
+	}
+
+	ptr[len++] = (unsigned char)value;
+
+	return len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: deserialize 64 bit unsigned integer from variable length byte     *
+ *          stream                                                            *
+ *                                                                            *
+ * Parameters: ptr   - [IN] the byte stream                                   *
+ *             value - [OUT] the deserialized value                           *
+ *                                                                            *
+ * Return value: The number of bytes read from byte stream.                   *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_deserialize_uint64_compact(const unsigned char *ptr, zbx_uint64_t *value)
+{
+	zbx_uint32_t	len = 0, shift = 0;
+
+	*value = 0;
+
+	do
+	{
+		*value |= (zbx_uint64_t)(ptr[len] & 0x7f) << shift;
+		shift += 7;
+	}
+	while (0 != (ptr[len++] & 0x80) && ZBX_SERIALIZE_UINT64_COMPACT_MAX > len);
+
+	return len;
+}
@@ -106,9 +106,64 @@ static void	__mem_free(zbx_shmem_info_t *info, void *ptr);
 #define SHMEM_SIZE_FIELD	sizeof(zbx_uint64_t)
 
 #define SHMEM_FLG_USED		((__UINT64_C(1))<<63)
+#define SHMEM_FLG_SLAB		((__UINT64_C(1))<<62)
 
 #define FREE_CHUNK(ptr)		(((*(zbx_uint64_t *)(ptr)) & SHMEM_FLG_USED) == 0)
 #define CHUNK_SIZE(ptr)		((*(zbx_uint64_t *)(ptr)) & ~SHMEM_FLG_USED)
+#define SLAB_OBJECT(ptr)	(((*(zbx_uint64_t *)(ptr)) & SHMEM_FLG_SLAB) != 0)
+#define SLAB_OFFSET(ptr)	((*(zbx_uint64_t *)(ptr)) & ~(SHMEM_FLG_USED | SHMEM_FLG_SLAB))
+
+/******************************************************************************
+ *                                                                            *
+ *                          Slab mode memory layout                           *
+ *                        ---------------------------                         *
+ *                                                                            *
+ * In slab mode small objects (up to ZBX_SHMEM_SLAB_MAX_OBJECT_SIZE bytes)    *
+ * are allocated from slabs - SHMEM_SLAB_SIZE sized used chunks, split into   *
+ * equally sized objects of one size class (8 byte steps):                    *
+ *                                                                            *
+ *      |--------|-- slab header --|--------|--...--|--------|--...--|        *
+ *                                                                            *
+ *      chunk size                  object   object  object   object          *
+ *                                  header   data    header   data            *
+ *                                                                            *
+ * The object header takes the place of the chunk size field, so pointers     *
+ * returned to the user are 8-aligned as usual. It has both SHMEM_FLG_USED    *
+ * and SHMEM_FLG_SLAB bits set and holds the slab offset from lo_bound, which *
+ * allows to find the owning slab when the object is freed.                   *
+ *                                                                            *
+ * Free objects are kept in a singly linked per slab list, slabs with free    *
+ * objects are kept in a doubly linked per size class list, which makes both  *
+ * allocation and freeing O(1). Empty slabs are returned to the general       *
+ * allocator unless it is the only slab with free objects in its class.       *
+ *                                                                            *
+ ******************************************************************************/
+
+#define SHMEM_SLAB_SIZE			(16 * ZBX_KIBIBYTE)
+#define SHMEM_SLAB_MIN_TOTAL_SIZE	(64 * SHMEM_SLAB_SIZE)
+
+typedef struct zbx_shmem_slab	zbx_shmem_slab_t;
+
+struct zbx_shmem_slab
+{
+	zbx_shmem_slab_t	*prev;
+	zbx_shmem_slab_t	*next;
+	void			*free_objects;
+	zbx_uint32_t		objects_num;
+	zbx_uint32_t		used_num;
+	int			class_index;
+};
+
+struct zbx_shmem_slab_class
+{
+	/* slabs having free objects */
+	zbx_shmem_slab_t	*partial;
+
+	zbx_uint64_t		slabs_size;
+	zbx_uint32_t		slabs_num;
+	zbx_uint32_t		objects_num;
+	zbx_uint32_t		used_num;
+};
 
 #define SHMEM_MIN_SIZE		__UINT64_C(128)
 #define SHMEM_MAX_SIZE		__UINT64_C(0x1000000000)	/* 64 GB */
@@ -521,6 +576,202 @@ static void	__mem_free(zbx_shmem_info_t *info, void *ptr)
 	}
 }
 
+/* slab mode functions */
+
+static int	mem_slab_class_by_size(zbx_uint64_t size)
+{
+	return (int)((size + 7) >> 3) - 1;
+}
+
+static zbx_uint64_t	mem_slab_object_size(int class_index)
+{
+	return (zbx_uint64_t)(class_index + 1) << 3;
+}
+
+static void	mem_slab_link(zbx_shmem_slab_class_t *slab_class, zbx_shmem_slab_t *slab)
+{
+	slab->prev = NULL;
+	slab->next = slab_class->partial;
+
+	if (NULL != slab_class->partial)
+		slab_class->partial->prev = slab;
+
+	slab_class->partial = slab;
+}
+
+static void	mem_slab_unlink(zbx_shmem_slab_class_t *slab_class, zbx_shmem_slab_t *slab)
+{
+	if (NULL != slab->prev)
+		slab->prev->next = slab->next;
+	else
+		slab_class->partial = slab->next;
+
+	if (NULL != slab->next)
+		slab->next->prev = slab->prev;
+}
+
+static zbx_shmem_slab_t	*mem_slab_create(zbx_shmem_info_t *info, int class_index)
+{
+	void			*chunk;
+	char			*object, *end;
+	zbx_shmem_slab_t	*slab;
+	zbx_shmem_slab_class_t	*slab_class = &info->slab_classes[class_index];
+	zbx_uint64_t		object_size, header;
+
+	if (NULL == (chunk = __mem_malloc(info, SHMEM_SLAB_SIZE)))
+		return NULL;
+
+	slab = (zbx_shmem_slab_t *)((char *)chunk + SHMEM_SIZE_FIELD);
+	slab->class_index = class_index;
+	slab->objects_num = 0;
+	slab->used_num = 0;
+	slab->free_objects = NULL;
+
+	object_size = SHMEM_SIZE_FIELD + mem_slab_object_size(class_index);
+	header = SHMEM_FLG_USED | SHMEM_FLG_SLAB | (zbx_uint64_t)((char *)slab - (char *)info->lo_bound);
+
+	/* the chunk might be larger than requested if it was not worth splitting */
+	end = (char *)slab + CHUNK_SIZE(chunk);
+
+	for (object = (char *)ALIGN8(slab + 1); object + object_size <= end; object += object_size)
+	{
+		*(zbx_uint64_t *)object = header;
+		*(void **)(object + SHMEM_SIZE_FIELD) = slab->free_objects;
+		slab->free_objects = object;
+		slab->objects_num++;
+	}
+
+	mem_slab_link(slab_class, slab);
+
+	slab_class->slabs_num++;
+	slab_class->slabs_size += CHUNK_SIZE(chunk);
+	slab_class->objects_num += slab->objects_num;
+
+	return slab;
+}
+
+static void	*mem_slab_malloc(zbx_shmem_info_t *info, zbx_uint64_t size)
+{
+	int			class_index;
+	zbx_shmem_slab_t	*slab;
+	zbx_shmem_slab_class_t	*slab_class;
+	void			*object;
+
+	class_index = mem_slab_class_by_size(size);
+	slab_class = &info->slab_classes[class_index];
+
+	if (NULL == (slab = slab_class->partial) && NULL == (slab = mem_slab_create(info, class_index)))
+		return NULL;
+
+	object = slab->free_objects;
+	slab->free_objects = *(void **)((char *)object + SHMEM_SIZE_FIELD);
+	slab->used_num++;
+	slab_class->used_num++;
+
+	if (NULL == slab->free_objects)
+		mem_slab_unlink(slab_class, slab);
+
+	return object;
+}
+
+static void	mem_slab_free(zbx_shmem_info_t *info, void *ptr)
+{
+	void			*object;
+	zbx_shmem_slab_t	*slab;
+	zbx_shmem_slab_class_t	*slab_class;
+
+	object = (void *)((char *)ptr - SHMEM_SIZE_FIELD);
+	slab = (zbx_shmem_slab_t *)((char *)info->lo_bound + SLAB_OFFSET(object));
+	slab_class = &info->slab_classes[slab->class_index];
+
+	if (NULL == slab->free_objects)
+		mem_slab_link(slab_class, slab);
+
+	*(void **)ptr = slab->free_objects;
+	slab->free_objects = object;
+	slab->used_num--;
+	slab_class->used_num--;
+
+	/* keep the last slab of the class to avoid allocating and releasing it repeatedly */
+	if (0 == slab->used_num && (NULL != slab->prev || NULL != slab->next))
+	{
+		mem_slab_unlink(slab_class, slab);
+
+		slab_class->slabs_num--;
+		slab_class->slabs_size -= CHUNK_SIZE((char *)slab - SHMEM_SIZE_FIELD);
+		slab_class->objects_num -= slab->objects_num;
+
+		__mem_free(info, slab);
+	}
+}
+
+static void	mem_slab_init(zbx_shmem_info_t *info)
+{
+	void	*chunk;
+
+	info->slab_classes = NULL;
+
+	if (NULL == (chunk = __mem_malloc(info, sizeof(zbx_shmem_slab_class_t) * ZBX_SHMEM_SLAB_CLASS_COUNT)))
+		return;
+
+	info->slab_classes = (zbx_shmem_slab_class_t *)((char *)chunk + SHMEM_SIZE_FIELD);
+	memset(info->slab_classes, 0, sizeof(zbx_shmem_slab_class_t) * ZBX_SHMEM_SLAB_CLASS_COUNT);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: allocates memory chunk, using slabs for small objects if enabled  *
+ *                                                                            *
+ * Return value: the allocated chunk or NULL if there is not enough memory    *
+ *                                                                            *
+ ******************************************************************************/
+static void	*mem_malloc(zbx_shmem_info_t *info, zbx_uint64_t size)
+{
+	void	*chunk;
+
+	if (NULL != info->slab_classes && ZBX_SHMEM_SLAB_MAX_OBJECT_SIZE >= size &&
+			NULL != (chunk = mem_slab_malloc(info, size)))
+	{
+		return chunk;
+	}
+
+	return __mem_malloc(info, size);
+}
+
+static void	*mem_realloc(zbx_shmem_info_t *info, void *old, zbx_uint64_t size)
+{
+	void		*object, *chunk;
+	int		class_index;
+	zbx_uint64_t	object_size;
+
+	object = (void *)((char *)old - SHMEM_SIZE_FIELD);
+
+	if (!SLAB_OBJECT(object))
+		return __mem_realloc(info, old, size);
+
+	class_index = ((zbx_shmem_slab_t *)((char *)info->lo_bound + SLAB_OFFSET(object)))->class_index;
+
+	if (ZBX_SHMEM_SLAB_MAX_OBJECT_SIZE >= size && mem_slab_class_by_size(size) == class_index)
+		return object;
+
+	if (NULL == (chunk = mem_malloc(info, size)))
+		return NULL;
+
+	object_size = mem_slab_object_size(class_index);
+	memcpy((char *)chunk + SHMEM_SIZE_FIELD, old, MIN(size, object_size));
+	mem_slab_free(info, old);
+
+	return chunk;
+}
+
+static void	mem_free(zbx_shmem_info_t *info, void *ptr)
+{
+	if (SLAB_OBJECT((char *)ptr - SHMEM_SIZE_FIELD))
+		mem_slab_free(info, ptr);
+	else
+		__mem_free(info, ptr);
+}
+
 /* public memory interface */
 
 int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
@@ -610,6 +861,7 @@ int	zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *des
 
 	(*info)->used_size = 0;
 	(*info)->free_size = (*info)->total_size;
+	(*info)->slab_classes = NULL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "valid user addresses: [%p, %p] total size: " ZBX_FS_SIZE_T,
 			(void *)((char *)(*info)->lo_bound + SHMEM_SIZE_FIELD),
@@ -663,6 +915,29 @@ void	zbx_shmem_destroy(zbx_shmem_info_t *info)
 	(void)shmdt(info->base);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: enables slab mode for small object allocations                    *
+ *                                                                            *
+ * Parameters: info - [IN] the shared memory                                  *
+ *                                                                            *
+ * Comments: This function must be called right after the shared memory is    *
+ *           created, before any allocations are made. Slab mode is not       *
+ *           enabled for small memory segments, where slabs would waste too   *
+ *           much memory.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_shmem_slab_enable(zbx_shmem_info_t *info)
+{
+	if (SHMEM_SLAB_MIN_TOTAL_SIZE > info->total_size)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "%s size is too small for slab mode", info->mem_descr);
+		return;
+	}
+
+	mem_slab_init(info);
+}
+
 void	*__zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, const void *old, size_t size)
 {
 	void	*chunk;
@@ -681,7 +956,7 @@ void	*__zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, con
 		exit(EXIT_FAILURE);
 	}
 
-	chunk = __mem_malloc(info, size);
+	chunk = mem_malloc(info, size);
 
 	if (NULL == chunk)
 	{
@@ -713,9 +988,9 @@ void	*__zbx_shmem_realloc(const char *file, int line, zbx_shmem_info_t *info, vo
 	}
 
 	if (NULL == old)
-		chunk = __mem_malloc(info, size);
+		chunk = mem_malloc(info, size);
 	else
-		chunk = __mem_realloc(info, old, size);
+		chunk = mem_realloc(info, old, size);
 
 	if (NULL == chunk)
 	{
@@ -743,7 +1018,7 @@ void	__zbx_shmem_free(const char *file, int line, zbx_shmem_info_t *info, void *
 		exit(EXIT_FAILURE);
 	}
 
-	__mem_free(info, ptr);
+	mem_free(info, ptr);
 }
 
 void	zbx_shmem_clear(zbx_shmem_info_t *info)
@@ -761,6 +1036,9 @@ void	zbx_shmem_clear(zbx_shmem_info_t *info)
 	info->used_size = 0;
 	info->free_size = info->total_size;
 
+	if (NULL != info->slab_classes)
+		mem_slab_init(info);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -798,6 +1076,26 @@ void	zbx_shmem_get_stats(const zbx_shmem_info_t *info, zbx_shmem_stats_t *stats)
 	stats->used_chunks = stats->overhead / (2 * SHMEM_SIZE_FIELD) + 1 - stats->free_chunks;
 	stats->free_size = info->free_size;
 	stats->used_size = info->used_size;
+
+	stats->slabs_size = 0;
+	stats->slab_objects_size = 0;
+	stats->slabs_num = 0;
+	stats->slab_objects_num = 0;
+	stats->slab_objects_free = 0;
+
+	if (NULL == info->slab_classes)
+		return;
+
+	for (i = 0; i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+	{
+		const zbx_shmem_slab_class_t	*slab_class = &info->slab_classes[i];
+
+		stats->slabs_size += slab_class->slabs_size;
+		stats->slab_objects_size += slab_class->used_num * (SHMEM_SIZE_FIELD + mem_slab_object_size(i));
+		stats->slabs_num += slab_class->slabs_num;
+		stats->slab_objects_num += slab_class->used_num;
+		stats->slab_objects_free += slab_class->objects_num - slab_class->used_num;
+	}
 }
 
 void	zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info)
@@ -831,6 +1129,39 @@ void	zbx_shmem_dump_stats(int level, zbx_shmem_info_t *info)
 	zabbix_log(level, "of those, %10llu bytes are used by allocation overhead",
 			(unsigned long long)stats.overhead);
 
+	/* external fragmentation - the part of free memory not available for the largest allocation */
+	if (0 != stats.free_size)
+	{
+		zabbix_log(level, "free memory fragmentation: %.2f%%",
+				100.0 - (double)stats.max_chunk_size * 100.0 / (double)stats.free_size);
+	}
+
+	if (NULL != info->slab_classes)
+	{
+		for (i = 0; i < ZBX_SHMEM_SLAB_CLASS_COUNT; i++)
+		{
+			const zbx_shmem_slab_class_t	*slab_class = &info->slab_classes[i];
+
+			if (0 == slab_class->slabs_num)
+				continue;
+
+			zabbix_log(level, "slab objects of size %3d bytes: %8u used, %8u free in %6u slabs",
+					(int)mem_slab_object_size(i), slab_class->used_num,
+					slab_class->objects_num - slab_class->used_num, slab_class->slabs_num);
+		}
+
+		zabbix_log(level, "slabs: %10llu bytes in %8u slabs, %10llu bytes are used by %8u objects",
+				(unsigned long long)stats.slabs_size, stats.slabs_num,
+				(unsigned long long)stats.slab_objects_size, stats.slab_objects_num);
+
+		/* internal fragmentation - slab memory not occupied by used objects */
+		if (0 != stats.slabs_size)
+		{
+			zabbix_log(level, "slab memory fragmentation: %.2f%%",
+					100.0 - (double)stats.slab_objects_size * 100.0 / (double)stats.slabs_size);
+		}
+	}
+
 	zabbix_log(level, "================================");
 }
 
@@ -191,6 +191,20 @@ void	zbx_zabbix_stats_get(struct zbx_json *json, int config_startup_time)
 	zbx_json_adduint64(json, "used", wcache_info.history_total - wcache_info.history_free);
 	zbx_json_addfloat(json, "pused", 100 * (double)(wcache_info.history_total - wcache_info.history_free) /
 			(double)wcache_info.history_total);
+	zbx_json_addfloat(json, "lockwait", wcache_info.lock_wait);
+
+	zbx_json_addarray(json, "shards");
+
+	for (i = 0; i < wcache_info.shards_num; i++)
+	{
+		zbx_json_addobject(json, NULL);
+		zbx_json_adduint64(json, "locks", wcache_info.shards[i].lock_num);
+		zbx_json_addfloat(json, "lockwait", wcache_info.shards[i].lock_wait);
+		zbx_json_addint64(json, "values", wcache_info.shards[i].history_num);
+		zbx_json_close(json);
+	}
+
+	zbx_json_close(json);
 	zbx_json_close(json);
 
 	zbx_json_addobject(json, "index");
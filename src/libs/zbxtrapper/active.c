@@ -722,7 +722,8 @@ int	send_list_of_active_checks_json(zbx_socket_t *sock, zbx_json_parse_t *jp,
 
 	if (0 != (ZBX_TCP_COMPRESS & sock->protocol))
 	{
-		if (SUCCEED != zbx_compress(json.buffer, json.buffer_size, &buffer, &buffer_size))
+		if (SUCCEED != zbx_tcp_compress((unsigned char)sock->protocol, json.buffer, json.buffer_size, &buffer,
+				&buffer_size))
 		{
 			zbx_snprintf(error, MAX_STRING_LEN, "cannot compress data: %s", zbx_compress_strerror());
 			goto error;
@@ -27,7 +27,12 @@ typedef struct
 	int			end;		/* the period end time */
 	zbx_trend_function_t	function;	/* the trends function */
 	zbx_trend_state_t	state;		/* the cached value state */
-	double			value;		/* the cached value */
+	union
+	{
+		double			value;		/* the cached function value */
+		zbx_trend_rollup_t	rollup;		/* the cached day or month rollup of hourly trends */
+	}
+	cached;
 	zbx_uint32_t		prev;		/* index of the previous LRU list or unused entry */
 	zbx_uint32_t		next;		/* index of the next LRU list or unused entry */
 	zbx_uint32_t		prev_value;	/* index of the previous value list */
@@ -55,7 +60,11 @@ typedef struct
 	zbx_uint64_t	hits;
 	zbx_uint64_t	misses;
 	zbx_uint64_t	items_num;
+	zbx_uint64_t	rollups_num;
+	zbx_uint64_t	rollup_hits;
 	zbx_uint64_t	conf_size;
+	zbx_uint64_t	flush_revision;	/* incremented when trend flush is started and finished */
+	int		flushes_num;	/* the number of trend flushes in progress */
 }
 zbx_tfc_t;
 
@@ -258,6 +267,9 @@ static void	tfc_free_data(zbx_tfc_data_t *data)
 	tfc_lru_remove(data);
 	tfc_value_remove(data);
 
+	if (ZBX_TREND_FUNCTION_ROLLUP == data->function)
+		cache->rollups_num--;
+
 	if (data->prev_value == data->next_value)
 	{
 		zbx_hashset_remove_direct(&cache->index, &cache->slots[data->prev_value].data);
@@ -322,6 +334,38 @@ static zbx_tfc_data_t	*tfc_index_add(zbx_tfc_data_t *data_local)
 	return data;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: ensure there is a free slot available for new item data           *
+ *                                                                            *
+ * Parameters: itemid - [IN]                                                  *
+ *                                                                            *
+ * Return value: The item root data, linking all cached data of the item.     *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_tfc_data_t	*tfc_reserve_item_slot(zbx_uint64_t itemid)
+{
+	zbx_tfc_data_t	data_local, *root;
+
+	data_local.itemid = itemid;
+	data_local.start = 0;
+	data_local.end = 0;
+	data_local.function = ZBX_TREND_FUNCTION_UNKNOWN;
+
+	tfc_reserve_slot();
+
+	if (NULL == (root = (zbx_tfc_data_t *)zbx_hashset_search(&cache->index, &data_local)))
+	{
+		root = tfc_index_add(&data_local);
+		root->prev_value = tfc_data_slot_index(root);
+		root->next_value = root->prev_value;
+		cache->items_num++;
+		tfc_reserve_slot();
+	}
+
+	return root;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: return trend function name in readable format                     *
@@ -343,6 +387,8 @@ static const char	*tfc_function_str(zbx_trend_function_t function)
 			return "min";
 		case ZBX_TREND_FUNCTION_SUM:
 			return "sum";
+		case ZBX_TREND_FUNCTION_ROLLUP:
+			return "rollup";
 		default:
 			return "unknown";
 	}
@@ -434,6 +480,10 @@ int	zbx_tfc_init(zbx_uint64_t cache_size, char **error)
 	cache->hits = 0;
 	cache->misses = 0;
 	cache->items_num = 0;
+	cache->rollups_num = 0;
+	cache->rollup_hits = 0;
+	cache->flush_revision = 0;
+	cache->flushes_num = 0;
 
 	ret = SUCCEED;
 out:
@@ -509,7 +559,7 @@ int	zbx_tfc_get_value(zbx_uint64_t itemid, time_t start, time_t end, zbx_trend_f
 		tfc_lru_remove(data);
 		tfc_lru_append(data);
 
-		*value = data->value;
+		*value = data->cached.value;
 		*state = data->state;
 
 		cache->hits++;
@@ -528,7 +578,7 @@ int	zbx_tfc_get_value(zbx_uint64_t itemid, time_t start, time_t end, zbx_trend_f
 			if (data->state == ZBX_TREND_STATE_NODATA)
 				zbx_strlcpy(buf, "none", sizeof(buf));
 			else
-				zbx_print_double(buf, sizeof(buf), data->value);
+				zbx_print_double(buf, sizeof(buf), data->cached.value);
 
 			zabbix_log(LOG_LEVEL_DEBUG, "End of %s() state:%s value:%s", __func__,
 					tfc_state_str(data->state), buf);
@@ -583,24 +633,11 @@ void	zbx_tfc_put_value(zbx_uint64_t itemid, time_t start, time_t end, zbx_trend_
 				tfc_state_str(state));
 	}
 
-	data_local.itemid = itemid;
-	data_local.start = 0;
-	data_local.end = 0;
-	data_local.function = ZBX_TREND_FUNCTION_UNKNOWN;
-
 	LOCK_CACHE;
 
-	tfc_reserve_slot();
-
-	if (NULL == (root = (zbx_tfc_data_t *)zbx_hashset_search(&cache->index, &data_local)))
-	{
-		root = tfc_index_add(&data_local);
-		root->prev_value = tfc_data_slot_index(root);
-		root->next_value = root->prev_value;
-		cache->items_num++;
-		tfc_reserve_slot();
-	}
+	root = tfc_reserve_item_slot(itemid);
 
+	data_local.itemid = itemid;
 	data_local.start = start;
 	data_local.end = end;
 	data_local.function = function;
@@ -614,7 +651,7 @@ void	zbx_tfc_put_value(zbx_uint64_t itemid, time_t start, time_t end, zbx_trend_
 		tfc_value_append(root, data);
 	}
 
-	data->value = value;
+	data->cached.value = value;
 	data->state = state;
 
 	UNLOCK_CACHE;
@@ -622,6 +659,207 @@ void	zbx_tfc_put_value(zbx_uint64_t itemid, time_t start, time_t end, zbx_trend_
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add flushed hourly trend to rollup                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	tfc_rollup_add_trend(zbx_trend_rollup_t *rollup, const ZBX_DC_TREND *trend)
+{
+	if (0 >= trend->num)
+		return;
+
+	if (ITEM_VALUE_TYPE_FLOAT == trend->value_type)
+	{
+		zbx_trend_rollup_add(rollup, trend->value_min.dbl, trend->value_max.dbl,
+				trend->value_avg.dbl * trend->num, (zbx_uint64_t)trend->num);
+	}
+	else
+	{
+		zbx_uint128_t	avg;
+
+		/* the same integer average as stored in trends_uint table */
+		zbx_udiv128_64(&avg, &trend->value_avg.ui64, (zbx_uint64_t)trend->num);
+
+		zbx_trend_rollup_add(rollup, (double)trend->value_min.ui64, (double)trend->value_max.ui64,
+				(double)avg.lo * trend->num, (zbx_uint64_t)trend->num);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: get cached day and month rollups of item hourly trends            *
+ *                                                                            *
+ * Parameters: itemid      - [IN]                                             *
+ *             periods     - [IN/OUT] the periods to get rollups for, the     *
+ *                                    state of cached periods is set to       *
+ *                                    ZBX_TREND_STATE_NORMAL                  *
+ *             periods_num - [IN] the number of periods                       *
+ *             missing_num - [OUT] the number of periods without cached       *
+ *                                 rollups                                    *
+ *             revision    - [OUT] the trend flush revision to pass to        *
+ *                                 zbx_tfc_put_rollups() with rollups         *
+ *                                 calculated from database                   *
+ *                                                                            *
+ * Return value: SUCCEED - the cached rollups were retrieved                  *
+ *               FAIL    - trend function cache is disabled                   *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tfc_get_rollups(zbx_uint64_t itemid, zbx_trend_period_t *periods, int periods_num, int *missing_num,
+		zbx_uint64_t *revision)
+{
+	zbx_tfc_data_t	*data, data_local;
+	int		i;
+
+	if (NULL == cache)
+		return FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " periods_num:%d", __func__, itemid, periods_num);
+
+	*missing_num = 0;
+
+	data_local.itemid = itemid;
+	data_local.function = ZBX_TREND_FUNCTION_ROLLUP;
+
+	LOCK_CACHE;
+
+	for (i = 0; i < periods_num; i++)
+	{
+		data_local.start = periods[i].start;
+		data_local.end = periods[i].end;
+
+		if (NULL != (data = (zbx_tfc_data_t *)zbx_hashset_search(&cache->index, &data_local)))
+		{
+			tfc_lru_remove(data);
+			tfc_lru_append(data);
+
+			periods[i].rollup = data->cached.rollup;
+			periods[i].state = ZBX_TREND_STATE_NORMAL;
+		}
+		else
+		{
+			periods[i].state = ZBX_TREND_STATE_UNKNOWN;
+			(*missing_num)++;
+		}
+	}
+
+	if (0 == *missing_num)
+		cache->rollup_hits++;
+
+	*revision = cache->flush_revision;
+
+	UNLOCK_CACHE;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() missing:%d", __func__, *missing_num);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: put day and month rollups of item hourly trends into cache        *
+ *                                                                            *
+ * Parameters: itemid      - [IN]                                             *
+ *             periods     - [IN] the periods with rollups to cache           *
+ *             periods_num - [IN] the number of periods                       *
+ *             revision    - [IN] the trend flush revision returned by        *
+ *                                zbx_tfc_get_rollups() before rollups were   *
+ *                                calculated                                  *
+ *                                                                            *
+ * Comments: Only periods with ZBX_TREND_STATE_NORMAL state are cached.       *
+ *           Already cached rollups are kept as they might have been updated  *
+ *           with trends flushed after the new rollups were calculated.       *
+ *           Rollups are discarded if trend flush was started or finished     *
+ *           since the revision was retrieved or is still in progress - the   *
+ *           database query might have missed the flushed trends, which are   *
+ *           never merged into rollups cached afterwards.                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tfc_put_rollups(zbx_uint64_t itemid, const zbx_trend_period_t *periods, int periods_num,
+		zbx_uint64_t revision)
+{
+	zbx_tfc_data_t	*data, data_local, *root;
+	int		i;
+
+	if (NULL == cache)
+		return;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " periods_num:%d", __func__, itemid, periods_num);
+
+	data_local.itemid = itemid;
+	data_local.function = ZBX_TREND_FUNCTION_ROLLUP;
+	data_local.state = ZBX_TREND_STATE_NORMAL;
+
+	LOCK_CACHE;
+
+	if (revision != cache->flush_revision || 0 != cache->flushes_num)
+		periods_num = 0;
+
+	for (i = 0; i < periods_num; i++)
+	{
+		if (ZBX_TREND_STATE_NORMAL != periods[i].state)
+			continue;
+
+		data_local.start = periods[i].start;
+		data_local.end = periods[i].end;
+
+		if (NULL != zbx_hashset_search(&cache->index, &data_local))
+			continue;
+
+		root = tfc_reserve_item_slot(itemid);
+
+		data_local.cached.rollup = periods[i].rollup;
+		data = tfc_index_add(&data_local);
+
+		tfc_lru_append(data);
+		tfc_value_append(root, data);
+		cache->rollups_num++;
+	}
+
+	UNLOCK_CACHE;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: add trend values to rollup                                        *
+ *                                                                            *
+ * Parameters: rollup - [IN/OUT]                                              *
+ *             min    - [IN] the minimum value                                *
+ *             max    - [IN] the maximum value                                *
+ *             sum    - [IN] the average value multiplied by number of values *
+ *             num    - [IN] the number of values                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_trend_rollup_add(zbx_trend_rollup_t *rollup, double min, double max, double sum, zbx_uint64_t num)
+{
+	if (0 == num)
+		return;
+
+	if (0 == rollup->num || min < rollup->min)
+		rollup->min = min;
+
+	if (0 == rollup->num || max > rollup->max)
+		rollup->max = max;
+
+	rollup->sum += sum;
+	rollup->num += num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: update cached data with flushed trends                            *
+ *                                                                            *
+ * Parameters: trends     - [IN] the flushed trends                           *
+ *             trends_num - [IN] the number of flushed trends                 *
+ *                                                                            *
+ * Comments: Cached function values including flushed trend clock are         *
+ *           removed, while day and month rollups are updated incrementally.  *
+ *           Must be called before trends are written to database and         *
+ *           followed by zbx_tfc_trends_flushed() after they are committed.   *
+ *                                                                            *
+ ******************************************************************************/
 void	zbx_tfc_invalidate_trends(ZBX_DC_TREND *trends, int trends_num)
 {
 	zbx_tfc_data_t	*root, *data, data_local;
@@ -652,15 +890,43 @@ void	zbx_tfc_invalidate_trends(ZBX_DC_TREND *trends, int trends_num)
 			if (trends[i].clock < data->start || trends[i].clock > data->end)
 				continue;
 
+			if (ZBX_TREND_FUNCTION_ROLLUP == data->function)
+			{
+				tfc_rollup_add_trend(&data->cached.rollup, &trends[i]);
+				continue;
+			}
+
 			tfc_free_data(data);
 		}
 	}
 
+	cache->flush_revision++;
+	cache->flushes_num++;
+
 	UNLOCK_CACHE;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: mark trend flush started by zbx_tfc_invalidate_trends() as        *
+ *          finished                                                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tfc_trends_flushed(void)
+{
+	if (NULL == cache)
+		return;
+
+	LOCK_CACHE;
+
+	cache->flush_revision++;
+	cache->flushes_num--;
+
+	UNLOCK_CACHE;
+}
+
 int	zbx_tfc_get_stats(zbx_tfc_stats_t *stats, char **error)
 {
 	if (NULL == cache)
@@ -676,7 +942,9 @@ int	zbx_tfc_get_stats(zbx_tfc_stats_t *stats, char **error)
 	stats->hits = cache->hits;
 	stats->misses = cache->misses;
 	stats->items_num = cache->items_num;
-	stats->requests_num = cache->index.num_data - cache->items_num;
+	stats->requests_num = cache->index.num_data - cache->items_num - cache->rollups_num;
+	stats->rollups_num = cache->rollups_num;
+	stats->rollup_hits = cache->rollup_hits;
 
 	UNLOCK_CACHE;
 
@@ -584,6 +584,257 @@ static zbx_trend_state_t	trends_eval_sum(const char *table, zbx_uint64_t itemid,
 	return ZBX_TREND_STATE_NORMAL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: split time range into day and month periods                       *
+ *                                                                            *
+ * Parameters: start       - [IN] period start time in seconds since Epoch    *
+ *             end         - [IN] period end time in seconds since Epoch      *
+ *                                (clock of the last hourly trend)            *
+ *             periods     - [OUT] the day and month periods                  *
+ *             periods_num - [OUT] the number of periods                      *
+ *                                                                            *
+ * Return value: SUCCEED - time range was split into periods                  *
+ *               FAIL    - time range is not aligned to day boundaries        *
+ *                                                                            *
+ * Comments: Month periods are used for whole months within time range, the   *
+ *           rest of time range is split into days.                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	trends_rollup_periods(time_t start, time_t end, zbx_trend_period_t **periods, int *periods_num)
+{
+	struct tm	tm, tm_next;
+	time_t		stop, next;
+	int		periods_alloc;
+
+	stop = end + SEC_PER_HOUR;
+
+	if (start >= stop)
+		return FAIL;
+
+	localtime_r(&stop, &tm);
+
+	if (0 != tm.tm_hour || 0 != tm.tm_min || 0 != tm.tm_sec)
+		return FAIL;
+
+	localtime_r(&start, &tm);
+
+	if (0 != tm.tm_hour || 0 != tm.tm_min || 0 != tm.tm_sec)
+		return FAIL;
+
+	/* allow for daylight saving time changes */
+	periods_alloc = (int)((stop - start) / SEC_PER_DAY) + 2;
+	*periods = (zbx_trend_period_t *)zbx_malloc(NULL, sizeof(zbx_trend_period_t) * (size_t)periods_alloc);
+	*periods_num = 0;
+
+	while (start < stop)
+	{
+		tm_next = tm;
+		next = -1;
+
+		if (1 == tm.tm_mday)
+		{
+			zbx_tm_add(&tm_next, 1, ZBX_TIME_UNIT_MONTH);
+
+			if ((next = mktime(&tm_next)) > stop)
+			{
+				tm_next = tm;
+				next = -1;
+			}
+		}
+
+		if (-1 == next)
+		{
+			zbx_tm_add(&tm_next, 1, ZBX_TIME_UNIT_DAY);
+			next = mktime(&tm_next);
+		}
+
+		if (next <= start || *periods_num == periods_alloc)
+		{
+			zbx_free(*periods);
+			return FAIL;
+		}
+
+		(*periods)[*periods_num].start = (int)start;
+		(*periods)[*periods_num].end = (int)next - 1;
+		(*periods)[*periods_num].state = ZBX_TREND_STATE_UNKNOWN;
+		(*periods_num)++;
+
+		start = next;
+		tm = tm_next;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculate rollups of periods without cached rollups from          *
+ *          database                                                          *
+ *                                                                            *
+ * Parameters: table       - [IN] trends table name                           *
+ *             itemid      - [IN]                                             *
+ *             periods     - [IN/OUT] the periods                             *
+ *             periods_num - [IN] the number of periods                       *
+ *             revision    - [IN] the trend flush revision returned with      *
+ *                                cached rollups                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	trends_rollup_load(const char *table, zbx_uint64_t itemid, zbx_trend_period_t *periods,
+		int periods_num, zbx_uint64_t revision)
+{
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+	int		i, first = -1, last = -1, clock, num;
+
+	for (i = 0; i < periods_num; i++)
+	{
+		if (ZBX_TREND_STATE_NORMAL == periods[i].state)
+			continue;
+
+		if (-1 == first)
+			first = i;
+
+		last = i;
+	}
+
+	if (-1 == first)
+		return;
+
+	result = zbx_db_select("select clock,num,value_min,value_avg,value_max from %s"
+			" where itemid=" ZBX_FS_UI64
+				" and clock>=%d"
+				" and clock<=%d",
+			table, itemid, periods[first].start, periods[last].end);
+
+	for (i = first; i <= last; i++)
+	{
+		if (ZBX_TREND_STATE_NORMAL != periods[i].state)
+			memset(&periods[i].rollup, 0, sizeof(zbx_trend_rollup_t));
+	}
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		int	lo = first, hi = last, mid;
+
+		clock = atoi(row[0]);
+
+		/* periods are adjacent and sorted by time */
+		while (lo < hi)
+		{
+			mid = (lo + hi + 1) / 2;
+
+			if (periods[mid].start <= clock)
+				lo = mid;
+			else
+				hi = mid - 1;
+		}
+
+		if (ZBX_TREND_STATE_NORMAL == periods[lo].state || clock < periods[lo].start || clock > periods[lo].end)
+			continue;
+
+		num = atoi(row[1]);
+		zbx_trend_rollup_add(&periods[lo].rollup, atof(row[2]), atof(row[4]), atof(row[3]) * num,
+				(zbx_uint64_t)num);
+	}
+
+	zbx_db_free_result(result);
+
+	for (i = first; i <= last; i++)
+		periods[i].state = ZBX_TREND_STATE_NORMAL;
+
+	zbx_tfc_put_rollups(itemid, periods + first, last - first + 1, revision);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: evaluate trend function from cached day and month rollups         *
+ *                                                                            *
+ * Parameters: table    - [IN] trends table name                              *
+ *             itemid   - [IN]                                                *
+ *             start    - [IN] period start time in seconds since Epoch       *
+ *             end      - [IN] period end time in seconds since Epoch         *
+ *             function - [IN] the trend function                             *
+ *             value    - [OUT] evaluation result                             *
+ *                                                                            *
+ * Return value: Trend value state of the specified period and function or    *
+ *               ZBX_TREND_STATE_UNKNOWN if the function cannot be evaluated  *
+ *               from rollups.                                                *
+ *                                                                            *
+ * Comments: Rollups are used only when trend function cache is enabled and   *
+ *           time range is aligned to day boundaries. Missing rollups are     *
+ *           calculated from database and cached, afterwards they are kept    *
+ *           up to date with flushed trends.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_trend_state_t	trends_eval_rollups(const char *table, zbx_uint64_t itemid, time_t start, time_t end,
+		zbx_trend_function_t function, double *value)
+{
+	zbx_trend_period_t	*periods;
+	zbx_trend_rollup_t	rollup = {0};
+	int			i, periods_num, missing_num;
+	zbx_uint64_t		revision;
+	zbx_trend_state_t	state = ZBX_TREND_STATE_NORMAL;
+
+	zbx_recalc_time_period(&start, ZBX_RECALC_TIME_PERIOD_TRENDS);
+
+	if (SUCCEED != trends_rollup_periods(start, end, &periods, &periods_num))
+		return ZBX_TREND_STATE_UNKNOWN;
+
+	if (SUCCEED != zbx_tfc_get_rollups(itemid, periods, periods_num, &missing_num, &revision))
+	{
+		zbx_free(periods);
+		return ZBX_TREND_STATE_UNKNOWN;
+	}
+
+	if (0 != missing_num)
+		trends_rollup_load(table, itemid, periods, periods_num, revision);
+
+	for (i = 0; i < periods_num; i++)
+	{
+		zbx_trend_rollup_add(&rollup, periods[i].rollup.min, periods[i].rollup.max, periods[i].rollup.sum,
+				periods[i].rollup.num);
+	}
+
+	zbx_free(periods);
+
+	switch (function)
+	{
+		case ZBX_TREND_FUNCTION_AVG:
+			if (0 == rollup.num)
+				return ZBX_TREND_STATE_NODATA;
+
+			*value = rollup.sum / (double)rollup.num;
+			break;
+		case ZBX_TREND_FUNCTION_COUNT:
+			*value = (double)rollup.num;
+			break;
+		case ZBX_TREND_FUNCTION_MAX:
+			if (0 == rollup.num)
+				return ZBX_TREND_STATE_NODATA;
+
+			*value = rollup.max;
+			break;
+		case ZBX_TREND_FUNCTION_MIN:
+			if (0 == rollup.num)
+				return ZBX_TREND_STATE_NODATA;
+
+			*value = rollup.min;
+			break;
+		case ZBX_TREND_FUNCTION_SUM:
+			if (ZBX_INFINITY == rollup.sum)
+				return ZBX_TREND_STATE_OVERFLOW;
+
+			*value = rollup.sum;
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			state = ZBX_TREND_STATE_UNKNOWN;
+	}
+
+	return state;
+}
+
 int	zbx_trends_eval_avg(const char *table, zbx_uint64_t itemid, time_t start, time_t end, double *value,
 		char **error)
 {
@@ -591,7 +842,12 @@ int	zbx_trends_eval_avg(const char *table, zbx_uint64_t itemid, time_t start, ti
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_AVG, value, &state))
 	{
-		state = trends_eval_avg(table, itemid, start, end, value);
+		if (ZBX_TREND_STATE_UNKNOWN == (state = trends_eval_rollups(table, itemid, start, end,
+				ZBX_TREND_FUNCTION_AVG, value)))
+		{
+			state = trends_eval_avg(table, itemid, start, end, value);
+		}
+
 		zbx_tfc_put_value(itemid, start, end, ZBX_TREND_FUNCTION_AVG, *value, state);
 	}
 
@@ -613,8 +869,13 @@ int	zbx_trends_eval_count(const char *table, zbx_uint64_t itemid, time_t start,
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_COUNT, value, &state))
 	{
-		if (ZBX_TREND_STATE_NORMAL != (state = trends_eval(table, itemid, start, end, "num", "sum(num)",
-				value)))
+		if (ZBX_TREND_STATE_UNKNOWN == (state = trends_eval_rollups(table, itemid, start, end,
+				ZBX_TREND_FUNCTION_COUNT, value)))
+		{
+			state = trends_eval(table, itemid, start, end, "num", "sum(num)", value);
+		}
+
+		if (ZBX_TREND_STATE_NORMAL != state)
 		{
 			state = ZBX_TREND_STATE_NORMAL;
 			*value = 0;
@@ -633,7 +894,12 @@ int	zbx_trends_eval_max(const char *table, zbx_uint64_t itemid, time_t start, ti
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_MAX, value, &state))
 	{
-		state = trends_eval(table, itemid, start, end, "value_max", "max(value_max)", value);
+		if (ZBX_TREND_STATE_UNKNOWN == (state = trends_eval_rollups(table, itemid, start, end,
+				ZBX_TREND_FUNCTION_MAX, value)))
+		{
+			state = trends_eval(table, itemid, start, end, "value_max", "max(value_max)", value);
+		}
+
 		zbx_tfc_put_value(itemid, start, end, ZBX_TREND_FUNCTION_MAX, *value, state);
 	}
 
@@ -653,7 +919,12 @@ int	zbx_trends_eval_min(const char *table, zbx_uint64_t itemid, time_t start, ti
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_MIN, value, &state))
 	{
-		state = trends_eval(table, itemid, start, end, "value_min", "min(value_min)", value);
+		if (ZBX_TREND_STATE_UNKNOWN == (state = trends_eval_rollups(table, itemid, start, end,
+				ZBX_TREND_FUNCTION_MIN, value)))
+		{
+			state = trends_eval(table, itemid, start, end, "value_min", "min(value_min)", value);
+		}
+
 		zbx_tfc_put_value(itemid, start, end, ZBX_TREND_FUNCTION_MIN, *value, state);
 	}
 
@@ -673,7 +944,12 @@ int	zbx_trends_eval_sum(const char *table, zbx_uint64_t itemid, time_t start, ti
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_SUM, value, &state))
 	{
-		state = trends_eval_sum(table, itemid, start, end, value);
+		if (ZBX_TREND_STATE_UNKNOWN == (state = trends_eval_rollups(table, itemid, start, end,
+				ZBX_TREND_FUNCTION_SUM, value)))
+		{
+			state = trends_eval_sum(table, itemid, start, end, value);
+		}
+
 		zbx_tfc_put_value(itemid, start, end, ZBX_TREND_FUNCTION_SUM, *value, state);
 	}
 
@@ -693,7 +969,12 @@ zbx_trend_state_t	zbx_trends_get_avg(const char *table, zbx_uint64_t itemid, tim
 
 	if (FAIL == zbx_tfc_get_value(itemid, start, end, ZBX_TREND_FUNCTION_AVG, value, &state))
 	{
-		state = trends_eval_avg(table, itemid, start, end, value);
+		if (ZBX_TREND_STATE_UNKNOWN == (state = trends_eval_rollups(table, itemid, start, end,
+				ZBX_TREND_FUNCTION_AVG, value)))
+		{
+			state = trends_eval_avg(table, itemid, start, end, value);
+		}
+
 		zbx_tfc_put_value(itemid, start, end, ZBX_TREND_FUNCTION_AVG, *value, state);
 	}
 
@@ -25,7 +25,8 @@ typedef enum
 	ZBX_TREND_FUNCTION_DELTA,
 	ZBX_TREND_FUNCTION_MAX,
 	ZBX_TREND_FUNCTION_MIN,
-	ZBX_TREND_FUNCTION_SUM
+	ZBX_TREND_FUNCTION_SUM,
+	ZBX_TREND_FUNCTION_ROLLUP
 }
 zbx_trend_function_t;
 
@@ -39,10 +40,35 @@ typedef enum
 }
 zbx_trend_state_t;
 
+/* aggregated hourly trends of a day or month */
+typedef struct
+{
+	double		min;
+	double		max;
+	double		sum;	/* sum of hourly average values multiplied by hourly value counts */
+	zbx_uint64_t	num;
+}
+zbx_trend_rollup_t;
+
+typedef struct
+{
+	int			start;	/* the period start time */
+	int			end;	/* the period end time (including) */
+	zbx_trend_state_t	state;	/* ZBX_TREND_STATE_NORMAL - rollup is set, ZBX_TREND_STATE_UNKNOWN - otherwise */
+	zbx_trend_rollup_t	rollup;
+}
+zbx_trend_period_t;
+
 int	zbx_tfc_get_value(zbx_uint64_t itemid, time_t start, time_t end, zbx_trend_function_t function, double *value,
 		zbx_trend_state_t *state);
 void	zbx_tfc_put_value(zbx_uint64_t itemid, time_t start, time_t end, zbx_trend_function_t function, double value,
 		zbx_trend_state_t state);
+int	zbx_tfc_get_rollups(zbx_uint64_t itemid, zbx_trend_period_t *periods, int periods_num, int *missing_num,
+		zbx_uint64_t *revision);
+void	zbx_tfc_put_rollups(zbx_uint64_t itemid, const zbx_trend_period_t *periods, int periods_num,
+		zbx_uint64_t revision);
+void	zbx_trend_rollup_add(zbx_trend_rollup_t *rollup, double min, double max, double sum, zbx_uint64_t num);
+
 const char	*zbx_trends_error(zbx_trend_state_t state);
 zbx_trend_state_t	zbx_trends_get_avg(const char *table, zbx_uint64_t itemid, time_t start, time_t end,
 		double *value);
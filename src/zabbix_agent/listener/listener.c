@@ -37,16 +37,20 @@ static int	process_passive_checks_json(zbx_socket_t *s, int config_timeout, stru
 {
 	struct zbx_json_parse	jp_data, jp_row;
 	const char		*p = NULL;
-	size_t			key_alloc = 0;
-	char			tmp[MAX_STRING_LEN], error_tmp[MAX_STRING_LEN], *key = NULL, *error = NULL;
-	int			timeout, ret = SUCCEED;
+	char			tmp[MAX_STRING_LEN], error_tmp[MAX_STRING_LEN], *error = NULL;
+	int			timeout, timeout_sum = 0, ret = SUCCEED;
 	struct zbx_json		j;
-	AGENT_RESULT		result;
-	char			**value;
+	zbx_vector_str_t	keys, timeouts;
+
+	zbx_vector_str_create(&keys);
+	zbx_vector_str_create(&timeouts);
 
 	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
 	zbx_json_addstring(&j, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
 	zbx_json_addint64(&j, ZBX_PROTO_TAG_VARIANT, ZBX_PROGRAM_VARIANT_AGENT);
+	zbx_json_addarray(&j, ZBX_PROTO_TAG_CAPABILITIES);
+	zbx_json_addstring(&j, NULL, ZBX_PROTO_VALUE_CAPABILITY_BATCH, ZBX_JSON_TYPE_STRING);
+	zbx_json_close(&j);
 
 	if (FAIL == zbx_json_value_by_name(jp, ZBX_PROTO_TAG_REQUEST, tmp, sizeof(tmp), NULL))
 	{
@@ -74,58 +78,83 @@ static int	process_passive_checks_json(zbx_socket_t *s, int config_timeout, stru
 		goto fail;
 	}
 
-	if (FAIL == zbx_json_brackets_open(p, &jp_row))
+	do
 	{
-		error = zbx_dsprintf(NULL, "%s", zbx_json_strerror());
-		goto fail;
-	}
+		char	*key = NULL;
+		size_t	key_alloc = 0;
 
-	if (FAIL == zbx_json_value_by_name(&jp_row, ZBX_PROTO_TAG_TIMEOUT, tmp, sizeof(tmp), NULL))
-	{
-		error = zbx_dsprintf(NULL, "cannot find the \"%s\" object in the received JSON object: %s",
-				ZBX_PROTO_TAG_TIMEOUT, zbx_json_strerror());
-		goto fail;
-	}
+		if (FAIL == zbx_json_brackets_open(p, &jp_row))
+		{
+			error = zbx_dsprintf(NULL, "%s", zbx_json_strerror());
+			goto fail;
+		}
 
-	if (FAIL == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_KEY, &key, &key_alloc,
-			NULL))
-	{
-		error = zbx_dsprintf(NULL, "cannot find the \"%s\" object in the received JSON object: %s",
-				ZBX_PROTO_TAG_KEY, zbx_json_strerror());
-		goto fail;
-	}
+		if (FAIL == zbx_json_value_by_name(&jp_row, ZBX_PROTO_TAG_TIMEOUT, tmp, sizeof(tmp), NULL))
+		{
+			error = zbx_dsprintf(NULL, "cannot find the \"%s\" object in the received JSON object: %s",
+					ZBX_PROTO_TAG_TIMEOUT, zbx_json_strerror());
+			goto fail;
+		}
 
-	zbx_init_agent_result(&result);
+		if (FAIL == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_KEY, &key, &key_alloc, NULL))
+		{
+			error = zbx_dsprintf(NULL, "cannot find the \"%s\" object in the received JSON object: %s",
+					ZBX_PROTO_TAG_KEY, zbx_json_strerror());
+			goto fail;
+		}
+
+		zbx_vector_str_append(&keys, key);
+		zbx_vector_str_append(&timeouts, zbx_strdup(NULL, tmp));
+	}
+	while (NULL != (p = zbx_json_next(&jp_data, p)));
 
 	zbx_json_addarray(&j, ZBX_PROTO_TAG_DATA);
-	zbx_json_addobject(&j, NULL);
 
-	if (FAIL == zbx_validate_item_timeout(tmp, &timeout, error_tmp, sizeof(error_tmp)))
+	for (int i = 0; i < keys.values_num; i++)
 	{
-		zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, error_tmp, ZBX_JSON_TYPE_STRING);
-	}
-	else
-	{
-		if (SUCCEED == zbx_execute_agent_check(key, ZBX_PROCESS_WITH_ALIAS, &result, timeout))
+		AGENT_RESULT	result;
+		char		**value;
+
+		zbx_json_addobject(&j, NULL);
+
+		if (FAIL == zbx_validate_item_timeout(timeouts.values[i], &timeout, error_tmp, sizeof(error_tmp)))
 		{
-			if (NULL != (value = ZBX_GET_TEXT_RESULT(&result)))
-				zbx_json_addstring(&j, ZBX_PROTO_TAG_VALUE, *value, ZBX_JSON_TYPE_STRING);
-			else
-				zbx_json_addraw(&j, ZBX_PROTO_TAG_VALUE, "null");
+			zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, error_tmp, ZBX_JSON_TYPE_STRING);
+		}
+		else if (0 != i && ZBX_AGENT_BATCH_TIMEOUT_MAX < timeout_sum + timeout)
+		{
+			/* keys are executed one after another, the rest of keys must be requested again */
+			timeout_sum = ZBX_AGENT_BATCH_TIMEOUT_MAX;
+			zbx_json_addstring(&j, ZBX_PROTO_TAG_DEFERRED, "true", ZBX_JSON_TYPE_INT);
 		}
 		else
 		{
-			if (NULL != (value = ZBX_GET_MSG_RESULT(&result)))
-				zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, *value, ZBX_JSON_TYPE_STRING);
+			timeout_sum += timeout;
+			zbx_init_agent_result(&result);
+
+			if (SUCCEED == zbx_execute_agent_check(keys.values[i], ZBX_PROCESS_WITH_ALIAS, &result,
+					timeout))
+			{
+				if (NULL != (value = ZBX_GET_TEXT_RESULT(&result)))
+					zbx_json_addstring(&j, ZBX_PROTO_TAG_VALUE, *value, ZBX_JSON_TYPE_STRING);
+				else
+					zbx_json_addraw(&j, ZBX_PROTO_TAG_VALUE, "null");
+			}
 			else
-				zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, ZBX_NOTSUPPORTED, ZBX_JSON_TYPE_STRING);
+			{
+				if (NULL != (value = ZBX_GET_MSG_RESULT(&result)))
+					zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, *value, ZBX_JSON_TYPE_STRING);
+				else
+					zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, ZBX_NOTSUPPORTED, ZBX_JSON_TYPE_STRING);
+			}
+
+			zbx_free_agent_result(&result);
 		}
+
+		zbx_json_close(&j);
 	}
 
 	zbx_json_close(&j);
-	zbx_json_close(&j);
-
-	zbx_free_agent_result(&result);
 fail:
 	if (NULL != error)
 		zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, error, ZBX_JSON_TYPE_STRING);
@@ -135,7 +164,10 @@ fail:
 	zabbix_log(LOG_LEVEL_DEBUG, "Sending back [%s]", j.buffer);
 	ret = zbx_tcp_send_bytes_to(s, j.buffer, j.buffer_size, config_timeout);
 
-	zbx_free(key);
+	zbx_vector_str_clear_ext(&timeouts, zbx_str_free);
+	zbx_vector_str_destroy(&timeouts);
+	zbx_vector_str_clear_ext(&keys, zbx_str_free);
+	zbx_vector_str_destroy(&keys);
 	zbx_json_free(&j);
 	zbx_free(error);
 
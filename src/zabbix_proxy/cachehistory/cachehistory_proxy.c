@@ -374,13 +374,9 @@ void	zbx_sync_proxy_history(int *values_num, int *triggers_num, const zbx_events
 	{
 		*more = ZBX_SYNC_DONE;
 
-		zbx_dbcache_lock();
-
 		zbx_hc_pop_items(&history_items);		/* select and take items out of history cache */
 		history_num = history_items.values_num;
 
-		zbx_dbcache_unlock();
-
 		if (0 == history_num)
 			break;
 
@@ -399,30 +395,24 @@ void	zbx_sync_proxy_history(int *values_num, int *triggers_num, const zbx_events
 			while (ZBX_DB_DOWN == (txn_rc = zbx_db_commit()));
 		}
 
-		zbx_dbcache_lock();
-
-		zbx_hc_push_items(&history_items);	/* return items to history cache */
-
 		if (ZBX_DB_FAIL != txn_rc)
 		{
 			if (0 != item_diff.values_num)
 				zbx_dc_config_items_apply_changes(&item_diff);
 
-			zbx_dbcache_set_history_num(zbx_dbcache_get_history_num() - history_num);
+			zbx_hc_push_items(&history_items, history_num);	/* return items to history cache */
 
 			if (0 != zbx_hc_queue_get_size())
 				*more = ZBX_SYNC_MORE;
 
-			zbx_dbcache_unlock();
-
 			*values_num += history_num;
 
 			zbx_hc_free_item_values(history, history_num);
 		}
 		else
 		{
+			zbx_hc_push_items(&history_items, 0);	/* return items to history cache */
 			*more = ZBX_SYNC_MORE;
-			zbx_dbcache_unlock();
 		}
 
 		zbx_vector_hc_item_ptr_clear(&history_items);
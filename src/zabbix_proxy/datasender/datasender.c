@@ -81,7 +81,8 @@ static void	get_hist_upload_state(const char *buffer, int *state)
 static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const zbx_thread_info_t *info,
 		zbx_thread_datasender_args *args)
 {
-	static int		data_timestamp = 0, task_timestamp = 0, upload_state = SUCCEED;
+	static int		data_timestamp = 0, task_timestamp = 0, upload_state = SUCCEED,
+				history_format = ZBX_PB_HISTORY_FORMAT_JSON, server_zstd = FAIL;
 
 	zbx_socket_t		sock;
 	struct zbx_json		j;
@@ -109,7 +110,7 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const z
 		if (SUCCEED == zbx_get_interface_availability_data(&j, &availability_ts))
 			flags |= ZBX_DATASENDER_AVAILABILITY;
 
-		history_records = zbx_pb_history_get_rows(&j, &history_lastid, &more_history);
+		history_records = zbx_pb_history_get_rows(&j, history_format, &history_lastid, &more_history);
 		if (0 != history_lastid)
 			flags |= ZBX_DATASENDER_HISTORY;
 
@@ -154,8 +155,9 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const z
 
 	if (0 != flags)
 	{
-		size_t	buffer_size, reserved;
-		time_t	time_connect;
+		size_t		buffer_size, reserved;
+		time_t		time_connect;
+		unsigned char	compress_flags;
 
 		if (ZBX_PROXY_DATA_MORE == more_history || ZBX_PROXY_DATA_MORE == more_discovery ||
 				ZBX_PROXY_DATA_MORE == more_areg)
@@ -173,7 +175,10 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const z
 		if (0 != (flags & ZBX_DATASENDER_HISTORY) && 0 != (proxy_delay = zbx_proxy_get_delay(history_lastid)))
 			zbx_json_adduint64(&j, ZBX_PROTO_TAG_PROXY_DELAY, proxy_delay);
 
-		if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
+		/* use zstd only if server has advertised it in the last response */
+		compress_flags = zbx_tcp_compress_flags(server_zstd);
+
+		if (SUCCEED != zbx_tcp_compress(compress_flags, j.buffer, j.buffer_size, &buffer, &buffer_size))
 		{
 			zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
 			goto clean;
@@ -198,13 +203,17 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const z
 
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
 
-		upload_state = zbx_put_data_to_server(&sock, &buffer, buffer_size, reserved, &error);
+		upload_state = zbx_put_data_to_server(&sock, &buffer, buffer_size, reserved, compress_flags, &error);
 		get_hist_upload_state(sock.buffer, hist_upload_state);
 
 		if (SUCCEED != upload_state)
 		{
 			zbx_addrs_failover(args->config_server_addrs);
 
+			/* the next server might not support columnar history data or zstd */
+			history_format = ZBX_PB_HISTORY_FORMAT_JSON;
+			server_zstd = FAIL;
+
 			*more = ZBX_PROXY_DATA_DONE;
 			if (ZBX_PROXY_UPLOAD_DISABLED != *hist_upload_state)
 			{
@@ -222,6 +231,14 @@ static int	proxy_data_sender(int *more, int now, int *hist_upload_state, const z
 			{
 				if (SUCCEED == zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_TASKS, &jp_tasks))
 					flags |= ZBX_DATASENDER_TASKS_RECV;
+
+				history_format = zbx_pb_history_get_format(&jp);
+				server_zstd = zbx_tcp_zstd_accepted(&jp);
+			}
+			else
+			{
+				history_format = ZBX_PB_HISTORY_FORMAT_JSON;
+				server_zstd = FAIL;
 			}
 
 			if (0 != (flags & ZBX_DATASENDER_DB_UPDATE))
@@ -26,6 +26,7 @@
 #include "zbxipcservice.h"
 #include "zbxdb.h"
 #include "zbxstr.h"
+#include "zbxproxybuffer.h"
 
 /******************************************************************************
  *                                                                            *
@@ -124,6 +125,7 @@ static int	housekeeping_history(int now, int config_offline_buffer, int config_l
 			config_local_buffer);
 	records += delete_history("proxy_autoreg_host", "autoreg_host_lastid", "clock", now, config_offline_buffer,
 			config_local_buffer);
+	records += zbx_pb_history_housekeep(now);
 
 	return records;
 }
@@ -73,6 +73,7 @@
 #include "zbxstr.h"
 #include "zbxtime.h"
 #include "zbxbincommon.h"
+#include "zbxcompress.h"
 
 #ifdef HAVE_OPENIPMI
 #include "zbxipmi.h"
@@ -110,7 +111,8 @@ static const char	*help_message[] = {
 	"                                   target is not specified",
 	"      " ZBX_SNMP_CACHE_RELOAD "          Reload SNMP cache",
 	"      " ZBX_DIAGINFO "=section           Log internal diagnostic information of the",
-	"                                 section (historycache, preprocessing, locks) or",
+	"                                 section (historycache, preprocessing, locks,",
+	"                                 database) or",
 	"                                 everything if section is not specified",
 	"      " ZBX_PROF_ENABLE "=target         Enable profiling, affects all processes if",
 	"                                   target is not specified",
@@ -186,6 +188,7 @@ ZBX_GET_CONFIG_VAR2(char *, const char *, zbx_config_pid_file, NULL)
 ZBX_GET_CONFIG_VAR2(char *, const char *, zbx_config_tmpdir, NULL)
 ZBX_GET_CONFIG_VAR2(char *, const char *, zbx_config_fping_location, NULL)
 ZBX_GET_CONFIG_VAR2(char *, const char *, zbx_config_fping6_location, NULL)
+ZBX_GET_CONFIG_VAR(int, zbx_config_enable_native_icmp, 0)
 
 static int	config_proxymode		= ZBX_PROXYMODE_ACTIVE;
 static sigset_t	orig_mask;
@@ -268,6 +271,10 @@ static int	config_proxyconfig_frequency	= 0;	/* will be set to default 5 seconds
 static int	config_proxydata_frequency	= 1;
 static int	config_confsyncer_frequency	= 0;
 
+/* zstd compression of requests to server, 0 - use zlib */
+static int	config_zstd_compression_level	= 0;
+static char	*config_zstd_dictionary		= NULL;
+
 static int	config_vmware_frequency		= 60;
 static int	config_vmware_perf_frequency	= 60;
 static int	config_vmware_timeout		= 10;
@@ -275,6 +282,7 @@ static int	config_vmware_timeout		= 10;
 static zbx_uint64_t	config_conf_cache_size		= 8 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_cache_size	= 16 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_index_cache_size	= 4 * ZBX_MEBIBYTE;
+static int		config_history_cache_shards	= 1;
 static zbx_uint64_t	config_trends_cache_size	= 0;
 static zbx_uint64_t	config_vmware_cache_size	= 8 * ZBX_MEBIBYTE;
 
@@ -333,6 +341,9 @@ static char		*config_proxy_buffer_mode_str = NULL;
 static int		config_proxy_buffer_mode	= 0;
 static zbx_uint64_t	config_proxy_memory_buffer_size	= 0;
 static int		config_proxy_memory_buffer_age	= 0;
+static char		*config_proxy_buffer_segment_dir	= NULL;
+static zbx_uint64_t	config_proxy_buffer_segment_size	= 16 * ZBX_MEBIBYTE;
+static zbx_uint64_t	config_proxy_buffer_segment_total_size	= 0;
 
 /* proxy has no any events processing */
 static const zbx_events_funcs_t	events_cbs = {
@@ -808,6 +819,31 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		}
 	}
 
+	if (NULL != config_proxy_buffer_segment_dir && '\0' != *config_proxy_buffer_segment_dir)
+	{
+		if (ZBX_PB_MODE_MEMORY == config_proxy_buffer_mode)
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "ProxyBufferSegmentDir configuration parameter cannot be set when"
+					" ProxyBufferMode is set to \"memory\"");
+			err = 1;
+		}
+
+		if (0 != config_proxy_local_buffer)
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "ProxyBufferSegmentDir configuration parameter cannot be set when"
+					" ProxyLocalBuffer parameter is set");
+			err = 1;
+		}
+
+		if (0 != config_proxy_buffer_segment_total_size &&
+				config_proxy_buffer_segment_total_size < config_proxy_buffer_segment_size)
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "ProxyBufferSegmentTotalSize configuration parameter cannot be less"
+					" than ProxyBufferSegmentSize parameter");
+			err = 1;
+		}
+	}
+
 	if (ZBX_PB_MODE_HYBRID != config_proxy_buffer_mode)
 	{
 		if (0 != config_proxy_memory_buffer_age)
@@ -897,6 +933,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&config_history_index_cache_size,	ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"HistoryCacheShards",		&config_history_cache_shards,		ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	1,			ZBX_HC_SHARDS_MAX},
 		{"HousekeepingFrequency",	&config_housekeeping_frequency,		ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	0,			24},
 		{"ProxyLocalBuffer",		&config_proxy_local_buffer,		ZBX_CFG_TYPE_INT,
@@ -911,12 +949,18 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	1,			SEC_PER_WEEK},
 		{"DataSenderFrequency",		&config_proxydata_frequency,		ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	1,			SEC_PER_HOUR},
+		{"ZstdCompressionLevel",	&config_zstd_compression_level,		ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			19},
+		{"ZstdDictionary",		&config_zstd_dictionary,		ZBX_CFG_TYPE_STRING,
+				ZBX_CONF_PARM_OPT,	0,			0},
 		{"TmpDir",			&zbx_config_tmpdir,			ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"FpingLocation",		&zbx_config_fping_location,		ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"Fping6Location",		&zbx_config_fping6_location,		ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
+		{"EnableNativeICMP",		&zbx_config_enable_native_icmp,		ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
 		{"Timeout",			&zbx_config_timeout,			ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	1,			30},
 		{"TrapperTimeout",		&zbx_config_trapper_timeout,		ZBX_CFG_TYPE_INT,
@@ -1076,6 +1120,13 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	0,			SEC_PER_DAY * 10},
 		{"ProxyBufferMode",		&config_proxy_buffer_mode_str,		ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
+		{"ProxyBufferSegmentDir",	&config_proxy_buffer_segment_dir,	ZBX_CFG_TYPE_STRING,
+				ZBX_CONF_PARM_OPT,	0,			0},
+		{"ProxyBufferSegmentSize",	&config_proxy_buffer_segment_size,	ZBX_CFG_TYPE_UINT64,
+				ZBX_CONF_PARM_OPT,	ZBX_MEBIBYTE,		ZBX_GIBIBYTE},
+		{"ProxyBufferSegmentTotalSize",	&config_proxy_buffer_segment_total_size,
+											ZBX_CFG_TYPE_UINT64,
+				ZBX_CONF_PARM_OPT,	0,			__UINT64_C(1024) * ZBX_GIBIBYTE},
 		{"StartHTTPAgentPollers",	&config_forks[ZBX_PROCESS_TYPE_HTTPAGENT_POLLER],
 											ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	0,			1000},
@@ -1218,7 +1269,8 @@ int	main(int argc, char **argv)
 		get_zbx_config_fping_location,
 		get_zbx_config_fping6_location,
 		get_zbx_config_tmpdir,
-		get_zbx_progname};
+		get_zbx_progname,
+		get_zbx_config_enable_native_icmp};
 
 	ZBX_TASK_EX			t = {ZBX_TASK_START, 0, 0, NULL};
 	char				ch;
@@ -1647,7 +1699,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	zbx_unblock_signals(&orig_mask);
 
 	if (SUCCEED != zbx_init_database_cache(get_zbx_program_type, zbx_sync_proxy_history, config_history_cache_size,
-			config_history_index_cache_size, &config_trends_cache_size, &error))
+			config_history_index_cache_size, config_history_cache_shards, &config_trends_cache_size,
+			&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
@@ -1661,6 +1714,13 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		exit(EXIT_FAILURE);
 	}
 
+	if (SUCCEED != zbx_compress_init(config_zstd_compression_level, config_zstd_dictionary, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize compression: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	if (SUCCEED != zbx_init_configuration_cache(get_zbx_program_type, get_config_forks, config_conf_cache_size,
 			config_hostname, &error))
 	{
@@ -1707,7 +1767,9 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	}
 
 	if (FAIL == zbx_pb_create(config_proxy_buffer_mode, config_proxy_memory_buffer_size,
-			config_proxy_memory_buffer_age, config_proxy_offline_buffer * SEC_PER_HOUR, &error))
+			config_proxy_memory_buffer_age, config_proxy_offline_buffer * SEC_PER_HOUR,
+			config_proxy_buffer_segment_dir, config_proxy_buffer_segment_size,
+			config_proxy_buffer_segment_total_size, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize proxy buffer: %s", error);
 		zbx_free(error);
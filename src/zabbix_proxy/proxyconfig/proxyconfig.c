@@ -64,7 +64,10 @@ static void	process_configuration_sync(size_t *data_size, zbx_synced_new_config_
 	if (0 != hostmap_revision)
 		zbx_json_adduint64(&j, ZBX_PROTO_TAG_HOSTMAP_REVISION, hostmap_revision);
 
-	if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
+	/* server responds with zstd compressed configuration only if it is advertised in request */
+	zbx_tcp_zstd_advertise(&j);
+
+	if (SUCCEED != zbx_tcp_compress(ZBX_TCP_COMPRESS, j.buffer, j.buffer_size, &buffer, &buffer_size))
 	{
 		zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
 		goto out;
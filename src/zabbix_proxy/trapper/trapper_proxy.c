@@ -67,14 +67,15 @@ static void	active_passive_misconfig(zbx_socket_t *sock, int config_timeout)
  *             buffer          - [IN/OUT]                                     *
  *             buffer_size     - [IN]                                         *
  *             reserved        - [IN]                                         *
+ *             compress_flags  - [IN] compression of the buffer               *
  *             config_timeout  - [IN]                                         *
  *             error           - [OUT] error message                          *
  *                                                                            *
  ******************************************************************************/
 static int	send_data_to_server(zbx_socket_t *sock, char **buffer, size_t buffer_size, size_t reserved,
-		int config_timeout, char **error)
+		unsigned char compress_flags, int config_timeout, char **error)
 {
-	if (SUCCEED != zbx_tcp_send_ext(sock, *buffer, buffer_size, reserved, ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS,
+	if (SUCCEED != zbx_tcp_send_ext(sock, *buffer, buffer_size, reserved, ZBX_TCP_PROTOCOL | compress_flags,
 			config_timeout))
 	{
 		*error = zbx_strdup(*error, zbx_socket_strerror());
@@ -94,13 +95,14 @@ static int	send_data_to_server(zbx_socket_t *sock, char **buffer, size_t buffer_
  * Purpose: sends 'proxy data' request to server                              *
  *                                                                            *
  * Parameters: sock                - [IN] connection socket                   *
+ *             jp_request          - [IN] server request                      *
  *             ts                  - [IN] connection timestamp                *
  *             config_comms        - [IN] proxy configuration for             *
  *                                        communication with server           *
  *             get_program_type_cb - [IN] callback to get program type        *
  *                                                                            *
  ******************************************************************************/
-static void	send_proxy_data(zbx_socket_t *sock, const zbx_timespec_t *ts,
+static void	send_proxy_data(zbx_socket_t *sock, const struct zbx_json_parse *jp_request, const zbx_timespec_t *ts,
 		const zbx_config_comms_args_t *config_comms, zbx_get_program_type_f get_program_type_cb)
 {
 	struct zbx_json		j;
@@ -110,6 +112,7 @@ static void	send_proxy_data(zbx_socket_t *sock, const zbx_timespec_t *ts,
 	zbx_vector_tm_task_t	tasks;
 	struct zbx_json_parse	jp, jp_tasks;
 	size_t			buffer_size, reserved;
+	unsigned char		compress_flags;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -127,7 +130,7 @@ static void	send_proxy_data(zbx_socket_t *sock, const zbx_timespec_t *ts,
 
 	zbx_json_addstring(&j, ZBX_PROTO_TAG_SESSION, zbx_dc_get_session_token(), ZBX_JSON_TYPE_STRING);
 	zbx_get_interface_availability_data(&j, &availability_ts);
-	zbx_pb_history_get_rows(&j, &history_lastid, &more_history);
+	zbx_pb_history_get_rows(&j, zbx_pb_history_get_format(jp_request), &history_lastid, &more_history);
 	zbx_pb_discovery_get_rows(&j, &discovery_lastid, &more_discovery);
 	zbx_pb_autoreg_get_rows(&j, &areg_lastid, &more_areg);
 	zbx_proxy_get_host_active_availability(&j);
@@ -154,7 +157,10 @@ static void	send_proxy_data(zbx_socket_t *sock, const zbx_timespec_t *ts,
 	if (0 != history_lastid && 0 != (proxy_delay = zbx_proxy_get_delay(history_lastid)))
 		zbx_json_addint64(&j, ZBX_PROTO_TAG_PROXY_DELAY, proxy_delay);
 
-	if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
+	/* use zstd only if server has advertised it in request */
+	compress_flags = zbx_tcp_compress_flags(zbx_tcp_zstd_accepted(jp_request));
+
+	if (SUCCEED != zbx_tcp_compress(compress_flags, j.buffer, j.buffer_size, &buffer, &buffer_size))
 	{
 		zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
 		goto clean;
@@ -163,8 +169,8 @@ static void	send_proxy_data(zbx_socket_t *sock, const zbx_timespec_t *ts,
 	reserved = j.buffer_size;
 	zbx_json_free(&j);	/* json buffer can be large, free as fast as possible */
 
-	if (SUCCEED == send_data_to_server(sock, &buffer, buffer_size, reserved, config_comms->config_timeout,
-			&error))
+	if (SUCCEED == send_data_to_server(sock, &buffer, buffer_size, reserved, compress_flags,
+			config_comms->config_timeout, &error))
 	{
 		zbx_set_availability_diff_ts(availability_ts);
 
@@ -267,8 +273,8 @@ static void	send_task_data(zbx_socket_t *sock, const zbx_timespec_t *ts,
 	reserved = j.buffer_size;
 	zbx_json_free(&j);	/* json buffer can be large, free as fast as possible */
 
-	if (SUCCEED == send_data_to_server(sock, &buffer, buffer_size, reserved, config_comms->config_timeout,
-			&error))
+	if (SUCCEED == send_data_to_server(sock, &buffer, buffer_size, reserved, ZBX_TCP_COMPRESS,
+			config_comms->config_timeout, &error))
 	{
 		zbx_db_begin();
 
@@ -320,7 +326,6 @@ int	trapper_process_request_proxy(const char *request, zbx_socket_t *sock, const
 		zbx_get_program_type_f get_program_type_cb, const zbx_events_funcs_t *events_cbs,
 		zbx_get_config_forks_f get_config_forks)
 {
-	ZBX_UNUSED(jp);
 	ZBX_UNUSED(ts);
 	ZBX_UNUSED(proxydata_frequency);
 	ZBX_UNUSED(events_cbs);
@@ -351,7 +356,7 @@ int	trapper_process_request_proxy(const char *request, zbx_socket_t *sock, const
 	{
 		if (0 != (get_program_type_cb() & ZBX_PROGRAM_TYPE_PROXY_PASSIVE))
 		{
-			send_proxy_data(sock, ts, config_comms, get_program_type_cb);
+			send_proxy_data(sock, jp, ts, config_comms, get_program_type_cb);
 			return SUCCEED;
 		}
 		return FAIL;
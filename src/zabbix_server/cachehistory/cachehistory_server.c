@@ -850,6 +850,7 @@ static int	DBmass_add_history(zbx_dc_history_t *history, int history_num, int co
 {
 	int				ret, ret_flush = FLUSH_SUCCEED, num;
 	zbx_vector_dc_history_ptr_t	history_values;
+	zbx_history_storage_stats_t	storage_stats;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -872,6 +873,9 @@ static int	DBmass_add_history(zbx_dc_history_t *history, int history_num, int co
 
 	zbx_vps_monitor_add_written((zbx_uint64_t)history_values.values_num);
 
+	if (SUCCEED == zbx_history_get_storage_stats(&storage_stats))
+		zbx_dc_add_history_storage_stats(&storage_stats);
+
 	zbx_vector_dc_history_ptr_destroy(&history_values);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -1317,18 +1321,14 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 
 		*more = ZBX_SYNC_DONE;
 
-		zbx_dbcache_lock();
 		zbx_hc_pop_items(&history_items);		/* select and take items out of history cache */
-		zbx_dbcache_unlock();
 
 		if (0 != history_items.values_num)
 		{
 			if (0 == (history_num = zbx_dc_config_lock_triggers_by_history_items(&history_items,
 					&triggerids)))
 			{
-				zbx_dbcache_lock();
-				zbx_hc_push_items(&history_items);
-				zbx_dbcache_unlock();
+				zbx_hc_push_items(&history_items, 0);
 				zbx_vector_hc_item_ptr_clear(&history_items);
 			}
 		}
@@ -1400,6 +1400,9 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 				}
 				while (ZBX_DB_DOWN == txn_error);
 
+				if (0 != trends_num)
+					zbx_tfc_trends_flushed();
+
 				do
 				{
 					if (0 == item_diff.values_num && 0 == inventory_values.values_num)
@@ -1526,9 +1529,7 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 
 		if (0 != history_num)
 		{
-			zbx_dbcache_lock();
-			zbx_hc_push_items(&history_items);	/* return items to history cache */
-			zbx_dbcache_set_history_num(zbx_dbcache_get_history_num() - history_num);
+			zbx_hc_push_items(&history_items, history_num);	/* return items to history cache */
 
 			if (0 != zbx_hc_queue_get_size())
 			{
@@ -1541,8 +1542,6 @@ void	zbx_sync_server_history(int *values_num, int *triggers_num, const zbx_event
 					*more = ZBX_SYNC_MORE;
 			}
 
-			zbx_dbcache_unlock();
-
 			*values_num += history_num;
 		}
 
@@ -638,6 +638,8 @@ ZBX_THREAD_ENTRY(connector_manager_thread, args)
 		exit(EXIT_FAILURE);
 	}
 
+	zbx_ipc_service_enable_shm(&service, ZBX_IPC_SHM_RING_SIZE_DEFAULT);
+
 	connector_init_manager(&manager, args_in->get_process_forks_cb_arg(ZBX_PROCESS_TYPE_CONNECTORWORKER));
 
 	/* initialize statistics */
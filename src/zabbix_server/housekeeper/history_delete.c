@@ -0,0 +1,209 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "history_delete.h"
+
+#include "zbxdb.h"
+#include "zbxnix.h"
+#include "zbxstr.h"
+#include "zbxthreads.h"
+
+ZBX_PTR_VECTOR_IMPL(hk_delete_batch_ptr, zbx_hk_delete_batch_t *)
+
+/* delete batches shared between delete workers */
+typedef struct
+{
+	const zbx_vector_hk_delete_batch_ptr_t	*batches;
+	int					next;		/* index of the next batch to execute */
+	int					deleted;
+	pthread_mutex_t				lock;
+}
+zbx_hk_delete_jobs_t;
+
+typedef struct
+{
+	zbx_hk_delete_jobs_t	*jobs;
+	pthread_t		thread;
+	int			started;
+}
+zbx_hk_delete_worker_t;
+
+void	hk_delete_batch_free(zbx_hk_delete_batch_t *batch)
+{
+	zbx_vector_uint64_destroy(&batch->itemids);
+	zbx_free(batch);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes history of batch items                                    *
+ *                                                                            *
+ * Parameters: db    - [IN] database connection, NULL for the main connection *
+ *             batch - [IN]                                                   *
+ *                                                                            *
+ * Return value: number of deleted records                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_delete_batch_execute(zbx_dbconn_t *db, const zbx_hk_delete_batch_t *batch)
+{
+	char	*sql = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	rc;
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "delete from %s where clock<%d and", batch->table,
+			batch->min_clock);
+	zbx_db_add_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", batch->itemids.values,
+			batch->itemids.values_num);
+
+	if (NULL != db)
+		rc = zbx_dbconn_execute(db, "%s", sql);
+	else
+		rc = zbx_db_execute("%s", sql);
+
+	zbx_free(sql);
+
+	return ZBX_DB_OK < rc ? rc : 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: executes delete batches until there are none left                 *
+ *                                                                            *
+ * Parameters: jobs - [IN/OUT] shared delete batches                          *
+ *             db   - [IN] database connection, NULL for the main connection  *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_delete_jobs_process(zbx_hk_delete_jobs_t *jobs, zbx_dbconn_t *db)
+{
+	int	deleted = 0;
+
+	while (ZBX_IS_RUNNING())
+	{
+		const zbx_hk_delete_batch_t	*batch;
+
+		pthread_mutex_lock(&jobs->lock);
+
+		if (jobs->next == jobs->batches->values_num)
+		{
+			pthread_mutex_unlock(&jobs->lock);
+			break;
+		}
+
+		batch = jobs->batches->values[jobs->next++];
+		pthread_mutex_unlock(&jobs->lock);
+
+		deleted += hk_delete_batch_execute(db, batch);
+	}
+
+	pthread_mutex_lock(&jobs->lock);
+	jobs->deleted += deleted;
+	pthread_mutex_unlock(&jobs->lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: delete worker thread entry                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	*hk_delete_worker_entry(void *args)
+{
+	zbx_hk_delete_worker_t	*worker = (zbx_hk_delete_worker_t *)args;
+	zbx_dbconn_t		*db;
+	sigset_t		mask;
+	int			err;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGUSR1);
+	sigaddset(&mask, SIGUSR2);
+	sigaddset(&mask, SIGHUP);
+	sigaddset(&mask, SIGQUIT);
+	sigaddset(&mask, SIGINT);
+
+	if (0 != (err = pthread_sigmask(SIG_BLOCK, &mask, NULL)))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot block signals: %s", zbx_strerror(err));
+
+	/* the main connection keeps processing batches if worker cannot connect */
+	db = zbx_dbconn_create();
+	(void)zbx_dbconn_set_connect_options(db, ZBX_DB_CONNECT_ONCE);
+
+	if (ZBX_DB_OK == zbx_dbconn_open(db))
+		hk_delete_jobs_process(worker->jobs, db);
+	else
+		zabbix_log(LOG_LEVEL_WARNING, "housekeeper delete worker cannot connect to the database");
+
+	zbx_dbconn_free(db);
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes history of delete batch items                             *
+ *                                                                            *
+ * Parameters: batches     - [IN] delete batches                              *
+ *             workers_num - [IN] number of concurrent database connections   *
+ *                                                                            *
+ * Return value: number of deleted records                                    *
+ *                                                                            *
+ * Comments: Additional workers are threads with their own database           *
+ *           connection, while the calling process executes batches over its  *
+ *           main connection. Batches are taken in order, so callers should   *
+ *           interleave batches of different tables to avoid concurrent       *
+ *           deletes from the same table.                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	hk_delete_batches_execute(const zbx_vector_hk_delete_batch_ptr_t *batches, int workers_num)
+{
+	zbx_hk_delete_jobs_t	jobs = {.batches = batches};
+	zbx_hk_delete_worker_t	*workers;
+	pthread_attr_t		attr;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() batches:%d workers:%d", __func__, batches->values_num, workers_num);
+
+	workers_num = MIN(workers_num, batches->values_num) - 1;
+	workers = (zbx_hk_delete_worker_t *)zbx_calloc(NULL, (size_t)MAX(workers_num, 1),
+			sizeof(zbx_hk_delete_worker_t));
+
+	pthread_mutex_init(&jobs.lock, NULL);
+	zbx_pthread_init_attr(&attr);
+
+	for (int i = 0; i < workers_num; i++)
+	{
+		int	err;
+
+		workers[i].jobs = &jobs;
+
+		if (0 != (err = pthread_create(&workers[i].thread, &attr, hk_delete_worker_entry, &workers[i])))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot create housekeeper delete worker thread: %s",
+					zbx_strerror(err));
+			break;
+		}
+
+		workers[i].started = 1;
+	}
+
+	hk_delete_jobs_process(&jobs, NULL);
+
+	for (int i = 0; i < workers_num && 0 != workers[i].started; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	pthread_mutex_destroy(&jobs.lock);
+	zbx_free(workers);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, jobs.deleted);
+
+	return jobs.deleted;
+}
@@ -0,0 +1,34 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_HISTORY_DELETE_H
+#define ZABBIX_HISTORY_DELETE_H
+
+#include "zbxalgo.h"
+
+/* batch of items having history older than min_clock removed from the table */
+typedef struct
+{
+	const char		*table;
+	int			min_clock;
+	zbx_vector_uint64_t	itemids;
+}
+zbx_hk_delete_batch_t;
+
+ZBX_PTR_VECTOR_DECL(hk_delete_batch_ptr, zbx_hk_delete_batch_t *)
+
+void	hk_delete_batch_free(zbx_hk_delete_batch_t *batch);
+int	hk_delete_batches_execute(const zbx_vector_hk_delete_batch_ptr_t *batches, int workers_num);
+
+#endif
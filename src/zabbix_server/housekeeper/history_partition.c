@@ -0,0 +1,495 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "history_partition.h"
+
+#include "zbxcommon.h"
+
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+#include "zbxdb.h"
+#include "zbxstr.h"
+#include "zbxalgo.h"
+
+/* unbounded partition range ends (MINVALUE, MAXVALUE) */
+#define HK_PARTITION_BOUND_MIN		INT_MIN
+#define HK_PARTITION_BOUND_MAX		INT_MAX
+
+/* maximum number of partitions created during one housekeeping cycle */
+#define HK_PARTITION_CREATE_MAX		1000
+
+#define HK_PARTITION_NAME_LEN		32
+
+/* table partition covering clock values in range [from, to) */
+typedef struct
+{
+	char	*name;
+	int	from;
+	int	to;
+}
+zbx_hk_partition_t;
+
+ZBX_PTR_VECTOR_DECL(hk_partition_ptr, zbx_hk_partition_t *)
+ZBX_PTR_VECTOR_IMPL(hk_partition_ptr, zbx_hk_partition_t *)
+
+static void	hk_partition_free(zbx_hk_partition_t *partition)
+{
+	zbx_free(partition->name);
+	zbx_free(partition);
+}
+
+static int	hk_partition_compare(const void *d1, const void *d2)
+{
+	const zbx_hk_partition_t	*p1 = *(const zbx_hk_partition_t * const *)d1;
+	const zbx_hk_partition_t	*p2 = *(const zbx_hk_partition_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(p1->from, p2->from);
+
+	return 0;
+}
+
+static void	hk_partition_add(zbx_vector_hk_partition_ptr_t *partitions, char *name, int from, int to)
+{
+	zbx_hk_partition_t	*partition;
+
+	partition = (zbx_hk_partition_t *)zbx_malloc(NULL, sizeof(zbx_hk_partition_t));
+	partition->name = name;
+	partition->from = from;
+	partition->to = to;
+
+	zbx_vector_hk_partition_ptr_append(partitions, partition);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: parses partition range bound                                      *
+ *                                                                            *
+ * Parameters: value - [IN] bound value, optionally quoted                    *
+ *             bound - [OUT]                                                  *
+ *                                                                            *
+ * Return value: SUCCEED - bound was parsed successfully                      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partition_parse_bound(const char *value, int *bound)
+{
+	char	*end;
+	long	num;
+
+	if ('\'' == *value)
+		value++;
+
+	if (0 == zbx_strncasecmp(value, "MINVALUE", ZBX_CONST_STRLEN("MINVALUE")))
+	{
+		*bound = HK_PARTITION_BOUND_MIN;
+		return SUCCEED;
+	}
+
+	if (0 == zbx_strncasecmp(value, "MAXVALUE", ZBX_CONST_STRLEN("MAXVALUE")))
+	{
+		*bound = HK_PARTITION_BOUND_MAX;
+		return SUCCEED;
+	}
+
+	errno = 0;
+	num = strtol(value, &end, 10);
+
+	if (end == value || 0 != errno || HK_PARTITION_BOUND_MIN >= num || HK_PARTITION_BOUND_MAX <= num)
+		return FAIL;
+
+	*bound = (int)num;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: reads range partitions of table partitioned by clock              *
+ *                                                                            *
+ * Parameters: table      - [IN]                                              *
+ *             partitions - [OUT] partitions, sorted by lower bound           *
+ *                                                                            *
+ * Return value: SUCCEED - table is range partitioned by clock                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Partitions with bounds that cannot be parsed (for example        *
+ *           PostgreSQL default partition) are not returned, so they are      *
+ *           never dropped by housekeeper.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partitions_get(const char *table, zbx_vector_hk_partition_ptr_t *partitions)
+{
+	zbx_db_result_t	result;
+	zbx_db_row_t	row;
+	int		ret = FAIL;
+#if defined(HAVE_MYSQL)
+	int		from = HK_PARTITION_BOUND_MIN;
+
+	result = zbx_db_select(
+			"select partition_name,partition_description,partition_method,partition_expression"
+			" from information_schema.partitions"
+			" where table_schema=database()"
+				" and table_name='%s'"
+				" and partition_name is not null"
+			" order by partition_ordinal_position",
+			table);
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		int	to;
+
+		if (0 != strncmp(row[2], "RANGE", ZBX_CONST_STRLEN("RANGE")) ||
+				(0 != strcmp(row[3], "clock") && 0 != strcmp(row[3], "`clock`")))
+		{
+			ret = FAIL;
+			break;
+		}
+
+		ret = SUCCEED;
+
+		if (NULL != strchr(row[0], '`') || SUCCEED != hk_partition_parse_bound(row[1], &to))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "skipping partition '%s' of table '%s'", row[0], table);
+			continue;
+		}
+
+		hk_partition_add(partitions, zbx_strdup(NULL, row[0]), from, to);
+		from = to;
+	}
+#elif defined(HAVE_POSTGRESQL)
+	result = zbx_db_select(
+			"select pg_get_partkeydef(c.oid)"
+			" from pg_class c,pg_namespace n"
+			" where c.relnamespace=n.oid"
+				" and c.relkind='p'"
+				" and c.relname='%s'"
+				" and n.nspname='%s'",
+			table, zbx_db_get_schema_esc());
+
+	if (NULL != (row = zbx_db_fetch(result)) && 0 == strcmp(row[0], "RANGE (clock)"))
+		ret = SUCCEED;
+
+	zbx_db_free_result(result);
+
+	if (SUCCEED != ret)
+		return FAIL;
+
+	result = zbx_db_select(
+			"select cn.nspname,c.relname,pg_get_expr(c.relpartbound,c.oid)"
+			" from pg_inherits i,pg_class c,pg_namespace cn,pg_class p,pg_namespace n"
+			" where i.inhrelid=c.oid"
+				" and c.relnamespace=cn.oid"
+				" and i.inhparent=p.oid"
+				" and p.relnamespace=n.oid"
+				" and p.relname='%s'"
+				" and n.nspname='%s'",
+			table, zbx_db_get_schema_esc());
+
+	while (NULL != (row = zbx_db_fetch(result)))
+	{
+		const char	*ptr;
+		int		from, to;
+
+		if (NULL != strchr(row[0], '"') || NULL != strchr(row[1], '"') || SUCCEED == zbx_db_is_null(row[2]) ||
+				NULL == (ptr = strstr(row[2], "FROM (")) ||
+				SUCCEED != hk_partition_parse_bound(ptr + ZBX_CONST_STRLEN("FROM ("), &from) ||
+				NULL == (ptr = strstr(ptr, "TO (")) ||
+				SUCCEED != hk_partition_parse_bound(ptr + ZBX_CONST_STRLEN("TO ("), &to))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "skipping partition '%s' of table '%s'", row[1], table);
+			continue;
+		}
+
+		hk_partition_add(partitions, zbx_dsprintf(NULL, "\"%s\".\"%s\"", row[0], row[1]), from, to);
+	}
+#endif
+	zbx_db_free_result(result);
+
+	if (SUCCEED != ret)
+		zbx_vector_hk_partition_ptr_clear_ext(partitions, hk_partition_free);
+	else
+		zbx_vector_hk_partition_ptr_sort(partitions, hk_partition_compare);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: formats name for new partition                                    *
+ *                                                                            *
+ * Parameters: from  - [IN] partition lower bound                             *
+ *             width - [IN] partition range width                             *
+ *             name  - [OUT]                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_partition_name(int from, int width, char *name)
+{
+	struct tm	tm;
+	time_t		start = (time_t)from;
+
+	gmtime_r(&start, &tm);
+
+	if (0 == width % SEC_PER_DAY)
+	{
+		zbx_snprintf(name, HK_PARTITION_NAME_LEN, "p%04d%02d%02d", tm.tm_year + 1900, tm.tm_mon + 1,
+				tm.tm_mday);
+	}
+	else
+	{
+		zbx_snprintf(name, HK_PARTITION_NAME_LEN, "p%04d%02d%02d%02d%02d", tm.tm_year + 1900, tm.tm_mon + 1,
+				tm.tm_mday, tm.tm_hour, tm.tm_min);
+	}
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if table is natively range partitioned by clock            *
+ *                                                                            *
+ * Parameters: table - [IN]                                                   *
+ *                                                                            *
+ * Return value: SUCCEED - table is partitioned                               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	hk_partition_table_check(const char *table)
+{
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	zbx_vector_hk_partition_ptr_t	partitions;
+	int				ret;
+
+	zbx_vector_hk_partition_ptr_create(&partitions);
+	ret = hk_partitions_get(table, &partitions);
+	zbx_vector_hk_partition_ptr_clear_ext(&partitions, hk_partition_free);
+	zbx_vector_hk_partition_ptr_destroy(&partitions);
+
+	return ret;
+#else
+	ZBX_UNUSED(table);
+
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: creates partitions for incoming data                              *
+ *                                                                            *
+ * Parameters: table            - [IN] partitioned table                      *
+ *             now              - [IN] current timestamp                      *
+ *             partitions_ahead - [IN] number of partitions to create after   *
+ *                                     the current one                        *
+ *                                                                            *
+ * Comments: New partitions continue after the last bounded partition with    *
+ *           the same range width, or are daily partitions when it cannot be  *
+ *           determined.                                                      *
+ *           On MySQL the partition with MAXVALUE bound is split, while on    *
+ *           PostgreSQL its presence disables partition creation, because     *
+ *           it already receives all the incoming data.                       *
+ *                                                                            *
+ ******************************************************************************/
+void	hk_partition_create_ahead(const char *table, int now, int partitions_ahead)
+{
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	zbx_vector_hk_partition_ptr_t	partitions;
+	const zbx_hk_partition_t	*maxvalue = NULL;
+	int				width = SEC_PER_DAY, from = HK_PARTITION_BOUND_MIN, created = 0;
+	zbx_uint64_t			until;
+	char				name[HK_PARTITION_NAME_LEN];
+#if defined(HAVE_MYSQL)
+	char				*sql = NULL;
+	size_t				sql_alloc = 0, sql_offset = 0;
+#endif
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() table:%s partitions_ahead:%d", __func__, table, partitions_ahead);
+
+	zbx_vector_hk_partition_ptr_create(&partitions);
+
+	if (0 == partitions_ahead || SUCCEED != hk_partitions_get(table, &partitions))
+		goto out;
+
+	for (int i = 0; i < partitions.values_num; i++)
+	{
+		const zbx_hk_partition_t	*partition = partitions.values[i];
+
+		if (HK_PARTITION_BOUND_MAX == partition->to)
+		{
+			maxvalue = partition;
+			continue;
+		}
+
+		if (partition->to > from)
+		{
+			from = partition->to;
+
+			if (HK_PARTITION_BOUND_MIN != partition->from)
+				width = partition->to - partition->from;
+		}
+	}
+
+#if defined(HAVE_POSTGRESQL)
+	if (NULL != maxvalue)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "table '%s' has partition with MAXVALUE bound", table);
+		goto out;
+	}
+#endif
+	if (HK_PARTITION_BOUND_MIN == from)
+		from = now - now % SEC_PER_DAY;
+
+	until = MIN((zbx_uint64_t)now + (zbx_uint64_t)partitions_ahead * (zbx_uint64_t)width + (zbx_uint64_t)width,
+			(zbx_uint64_t)HK_PARTITION_BOUND_MAX - (zbx_uint64_t)width);
+
+	for (; (zbx_uint64_t)from + (zbx_uint64_t)width <= until && HK_PARTITION_CREATE_MAX > created;
+			from += width, created++)
+	{
+		hk_partition_name(from, width, name);
+#if defined(HAVE_MYSQL)
+		if (0 == sql_offset)
+		{
+			if (NULL != maxvalue)
+			{
+				zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "alter table %s reorganize partition"
+						" `%s` into (", table, maxvalue->name);
+			}
+			else
+				zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "alter table %s add partition (", table);
+		}
+		else
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "partition `%s` values less than (%d)", name,
+				from + width);
+#elif defined(HAVE_POSTGRESQL)
+		if (ZBX_DB_OK > zbx_db_execute("create table \"%s_%s\" partition of %s for values from (%d) to (%d)",
+				table, name, table, from, from + width))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot create partition \"%s_%s\" of table '%s'", table, name,
+					table);
+			break;
+		}
+#endif
+	}
+
+#if defined(HAVE_MYSQL)
+	if (0 != sql_offset)
+	{
+		if (NULL != maxvalue)
+		{
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, ",partition `%s` values less than maxvalue",
+					maxvalue->name);
+		}
+
+		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
+
+		if (ZBX_DB_OK > zbx_db_execute("%s", sql))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot create partitions of table '%s'", table);
+			created = 0;
+		}
+	}
+#endif
+out:
+#if defined(HAVE_MYSQL)
+	zbx_free(sql);
+#endif
+	zbx_vector_hk_partition_ptr_clear_ext(&partitions, hk_partition_free);
+	zbx_vector_hk_partition_ptr_destroy(&partitions);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() created:%d", __func__, created);
+#else
+	ZBX_UNUSED(table);
+	ZBX_UNUSED(now);
+	ZBX_UNUSED(partitions_ahead);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: drops partitions containing only expired data                     *
+ *                                                                            *
+ * Parameters: table     - [IN] partitioned table                             *
+ *             keep_from - [IN] data older than this timestamp is expired     *
+ *                                                                            *
+ * Return value: number of dropped partitions                                 *
+ *                                                                            *
+ ******************************************************************************/
+int	hk_partition_drop_expired(const char *table, int keep_from)
+{
+	int	dropped = 0;
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	zbx_vector_hk_partition_ptr_t	partitions;
+#if defined(HAVE_MYSQL)
+	char				*sql = NULL;
+	size_t				sql_alloc = 0, sql_offset = 0;
+#endif
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() table:%s keep_from:%d", __func__, table, keep_from);
+
+	zbx_vector_hk_partition_ptr_create(&partitions);
+
+	if (SUCCEED != hk_partitions_get(table, &partitions))
+		goto out;
+
+	for (int i = 0; i < partitions.values_num; i++)
+	{
+		const zbx_hk_partition_t	*partition = partitions.values[i];
+
+		if (HK_PARTITION_BOUND_MAX == partition->to || partition->to > keep_from)
+			continue;
+#if defined(HAVE_MYSQL)
+		/* MySQL does not allow to drop all partitions of the table */
+		if (i == partitions.values_num - 1)
+			break;
+
+		if (0 == sql_offset)
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "alter table %s drop partition ", table);
+		else
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "`%s`", partition->name);
+		dropped++;
+#elif defined(HAVE_POSTGRESQL)
+		zabbix_log(LOG_LEVEL_TRACE, "%s: table=%s partition=%s", __func__, table, partition->name);
+
+		if (ZBX_DB_OK > zbx_db_execute("drop table %s", partition->name))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot drop partition %s of table '%s'", partition->name, table);
+			break;
+		}
+
+		dropped++;
+#endif
+	}
+
+#if defined(HAVE_MYSQL)
+	if (0 != sql_offset && ZBX_DB_OK > zbx_db_execute("%s", sql))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot drop partitions of table '%s'", table);
+		dropped = 0;
+	}
+#endif
+out:
+#if defined(HAVE_MYSQL)
+	zbx_free(sql);
+#endif
+	zbx_vector_hk_partition_ptr_clear_ext(&partitions, hk_partition_free);
+	zbx_vector_hk_partition_ptr_destroy(&partitions);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() dropped:%d", __func__, dropped);
+#else
+	ZBX_UNUSED(table);
+	ZBX_UNUSED(keep_from);
+#endif
+	return dropped;
+}
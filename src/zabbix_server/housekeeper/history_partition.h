@@ -0,0 +1,22 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#ifndef ZABBIX_HISTORY_PARTITION_H
+#define ZABBIX_HISTORY_PARTITION_H
+
+int	hk_partition_table_check(const char *table);
+void	hk_partition_create_ahead(const char *table, int now, int partitions_ahead);
+int	hk_partition_drop_expired(const char *table, int keep_from);
+
+#endif
@@ -15,6 +15,8 @@
 #include "housekeeper_server.h"
 
 #include "history_compress.h"
+#include "history_partition.h"
+#include "history_delete.h"
 
 #include "zbxtimekeeper.h"
 #include "zbxlog.h"
@@ -140,6 +142,9 @@ typedef struct
 
 	/* the item delete queue */
 	zbx_vector_hk_delete_queue_ptr_t	delete_queue;
+
+	/* 1 if the target table is natively range partitioned by clock */
+	unsigned char				partitioned;
 }
 zbx_hk_history_rule_t;
 
@@ -206,13 +211,14 @@ static zbx_hk_history_rule_t	hk_history_rules[] = {
 
 /******************************************************************************
  *                                                                            *
- * Purpose: compare two delete queue items by their itemid                    *
+ * Purpose: compare two delete queue items by their cutoff time and itemid    *
  *                                                                            *
  * Return value: <0 - the first item is less than the second                  *
  *               >0 - the first item is greater than the second               *
  *               =0 - the items are the same                                  *
  *                                                                            *
- * Comments: this function is used to sort delete queue by itemids            *
+ * Comments: this function is used to sort delete queue, so items with the    *
+ *           same cutoff time can be deleted in batches                       *
  *                                                                            *
  ******************************************************************************/
 static int	hk_item_update_cache_compare(const void *d1, const void *d2)
@@ -220,11 +226,34 @@ static int	hk_item_update_cache_compare(const void *d1, const void *d2)
 	zbx_hk_delete_queue_t	*r1 = *(zbx_hk_delete_queue_t **)d1;
 	zbx_hk_delete_queue_t	*r2 = *(zbx_hk_delete_queue_t **)d2;
 
+	ZBX_RETURN_IF_NOT_EQUAL(r1->min_clock, r2->min_clock);
 	ZBX_RETURN_IF_NOT_EQUAL(r1->itemid, r2->itemid);
 
 	return 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: returns housekeeping mode of history rule                         *
+ *                                                                            *
+ * Parameters: rule - [IN] history housekeeping rule                          *
+ *                                                                            *
+ * Comments: Natively partitioned tables with enabled global period override  *
+ *           are housekeeped by dropping partitions, like TimescaleDB         *
+ *           hypertables.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	hk_history_rule_mode(const zbx_hk_history_rule_t *rule)
+{
+	if (ZBX_HK_MODE_REGULAR == *rule->poption_mode && 0 != rule->partitioned &&
+			ZBX_HK_OPTION_DISABLED != *rule->poption_global)
+	{
+		return ZBX_HK_MODE_PARTITION;
+	}
+
+	return *rule->poption_mode;
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: add item to the delete queue if necessary                         *
@@ -409,7 +438,7 @@ static void	hk_history_update(zbx_hk_history_rule_t *rules, int now)
 		ZBX_STR2UINT64(hostid, row[4]);
 
 		if (value_type <= ITEM_VALUE_TYPE_BIN &&
-				ZBX_HK_MODE_REGULAR == *(rule = rules + value_type)->poption_mode)
+				ZBX_HK_MODE_REGULAR == hk_history_rule_mode(rule = rules + value_type))
 		{
 			int	history;
 
@@ -439,8 +468,11 @@ static void	hk_history_update(zbx_hk_history_rule_t *rules, int now)
 		/* trend rules are shared between all trend types, so we can default to floating type */
 		rule = &rules[HK_UPDATE_CACHE_OFFSET_TREND_FLOAT];
 
-		if (ZBX_HK_MODE_REGULAR != *rule->poption_mode)
+		if (ZBX_HK_MODE_REGULAR != hk_history_rule_mode(rule) &&
+				ZBX_HK_MODE_REGULAR != hk_history_rule_mode(&rules[HK_UPDATE_CACHE_OFFSET_TREND_UINT]))
+		{
 			continue;
+		}
 
 		if (ITEM_VALUE_TYPE_FLOAT == value_type || ITEM_VALUE_TYPE_UINT64 == value_type)
 		{
@@ -508,7 +540,7 @@ static void	hk_history_delete_queue_prepare_all(zbx_hk_history_rule_t *rules, in
 	/* prepare history item cache (hashset containing itemid:min_clock values) */
 	for (zbx_hk_history_rule_t *rule = rules; NULL != rule->table; rule++)
 	{
-		if (ZBX_HK_MODE_REGULAR == *rule->poption_mode)
+		if (ZBX_HK_MODE_REGULAR == hk_history_rule_mode(rule))
 		{
 			if (0 == rule->item_cache.num_slots)
 				hk_history_prepare(rule);
@@ -629,23 +661,75 @@ static void 	hk_update_dbversion_status(void)
 }
 #endif
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: splits history rule delete queue into delete batches              *
+ *                                                                            *
+ * Parameters: rule    - [IN/OUT] history housekeeping rule                   *
+ *             batches - [OUT] delete batches                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_history_delete_batches_prepare(zbx_hk_history_rule_t *rule,
+		zbx_vector_hk_delete_batch_ptr_t *batches)
+{
+	zbx_hk_delete_batch_t	*batch = NULL;
+
+	zbx_vector_hk_delete_queue_ptr_sort(&rule->delete_queue, hk_item_update_cache_compare);
+
+	for (int i = 0; i < rule->delete_queue.values_num; i++)
+	{
+		zbx_hk_delete_queue_t	*item_record = rule->delete_queue.values[i];
+
+		if (NULL == batch || batch->min_clock != item_record->min_clock ||
+				ZBX_DB_LARGE_QUERY_BATCH_SIZE == batch->itemids.values_num)
+		{
+			batch = (zbx_hk_delete_batch_t *)zbx_malloc(NULL, sizeof(zbx_hk_delete_batch_t));
+			batch->table = rule->table;
+			batch->min_clock = item_record->min_clock;
+			zbx_vector_uint64_create(&batch->itemids);
+			zbx_vector_hk_delete_batch_ptr_append(batches, batch);
+		}
+
+		zbx_vector_uint64_append(&batch->itemids, item_record->itemid);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: performs housekeeping for history and trends tables               *
  *                                                                            *
- * Parameters: now - [IN] current timestamp                                   *
+ * Parameters: now              - [IN] current timestamp                      *
+ *             partitions_ahead - [IN] number of partitions to create ahead   *
+ *                                     in natively partitioned tables         *
+ *             delete_workers   - [IN] number of database connections used    *
+ *                                     to delete history of items             *
  *                                                                            *
  ******************************************************************************/
-static int	housekeeping_history_and_trends(int now)
+static int	housekeeping_history_and_trends(int now, int partitions_ahead, int delete_workers)
 {
-	int			deleted = 0;
-	zbx_hk_history_rule_t	*rule;
+#define HK_HISTORY_RULES_NUM	(ARRSIZE(hk_history_rules) - 1)
+	int					deleted = 0;
+	size_t					batches_max = 0;
+	zbx_hk_history_rule_t			*rule;
+	zbx_vector_hk_delete_batch_ptr_t	batches, rule_batches[HK_HISTORY_RULES_NUM];
 #if defined(HAVE_POSTGRESQL)
-	int			ignore_history = 0, ignore_trends = 0;
+	int					ignore_history = 0, ignore_trends = 0;
 #endif
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() now:%d", __func__, now);
 
+	/* detect native partitioning and create partitions for incoming data */
+	for (rule = hk_history_rules; NULL != rule->table; rule++)
+	{
+		if (SUCCEED == hk_partition_table_check(rule->table))
+		{
+			rule->partitioned = 1;
+			hk_partition_create_ahead(rule->table, now, partitions_ahead);
+		}
+		else
+			rule->partitioned = 0;
+	}
+
 	/* prepare delete queues for all history housekeeping rules */
 	hk_history_delete_queue_prepare_all(hk_history_rules, now);
 
@@ -658,6 +742,10 @@ static int	housekeeping_history_and_trends(int now)
 	/* we need to clear records from */
 	for (rule = hk_history_rules; NULL != rule->table; rule++)
 	{
+		zbx_vector_hk_delete_batch_ptr_t	*rule_batch = &rule_batches[rule - hk_history_rules];
+
+		zbx_vector_hk_delete_batch_ptr_create(rule_batch);
+
 		if (ZBX_HK_MODE_DISABLED == *rule->poption_mode)
 			goto skip;
 
@@ -665,9 +753,14 @@ static int	housekeeping_history_and_trends(int now)
 		/* ZBX_HK_MODE_PARTITION is set during configuration sync based on the following: */
 		/* 1. "Override item history (or trend) period" must be on 2. DB must be PostgreSQL */
 		/* 3. config.db.extension must be set to "timescaledb" */
-		if (ZBX_HK_MODE_PARTITION == *rule->poption_mode)
+		/* Natively partitioned tables are switched to partition mode by hk_history_rule_mode(). */
+		if (ZBX_HK_MODE_PARTITION == hk_history_rule_mode(rule))
 		{
-			hk_drop_partition(rule->table, *rule->poption, now);
+			if (0 != rule->partitioned)
+				hk_partition_drop_expired(rule->table, now - MIN(*rule->poption, now));
+			else
+				hk_drop_partition(rule->table, *rule->poption, now);
+
 			goto skip;
 		}
 
@@ -707,26 +800,38 @@ static int	housekeeping_history_and_trends(int now)
 		}
 #endif
 		/* process delete queue for the housekeeping rule */
+		hk_history_delete_batches_prepare(rule, rule_batch);
+		batches_max = MAX(batches_max, (size_t)rule_batch->values_num);
+skip:
+		/* clear history rule delete queue so it's ready for the next housekeeping cycle */
+		hk_history_delete_queue_clear(rule);
+	}
 
-		zbx_vector_hk_delete_queue_ptr_sort(&rule->delete_queue, hk_item_update_cache_compare);
+	/* interleave batches of different tables, so delete workers process them concurrently */
+	zbx_vector_hk_delete_batch_ptr_create(&batches);
 
-		for (int i = 0; i < rule->delete_queue.values_num; i++)
+	for (size_t i = 0; i < batches_max; i++)
+	{
+		for (size_t j = 0; j < HK_HISTORY_RULES_NUM; j++)
 		{
-			zbx_hk_delete_queue_t	*item_record = (zbx_hk_delete_queue_t *)rule->delete_queue.values[i];
-			int	rc = zbx_db_execute("delete from %s where itemid=" ZBX_FS_UI64 " and clock<%d",
-					rule->table, item_record->itemid, item_record->min_clock);
-
-			if (ZBX_DB_OK < rc)
-				deleted += rc;
+			if (i < (size_t)rule_batches[j].values_num)
+				zbx_vector_hk_delete_batch_ptr_append(&batches, rule_batches[j].values[i]);
 		}
-skip:
-		/* clear history rule delete queue so it's ready for the next housekeeping cycle */
-		hk_history_delete_queue_clear(rule);
 	}
 
+	if (0 != batches.values_num)
+		deleted = hk_delete_batches_execute(&batches, delete_workers);
+
+	zbx_vector_hk_delete_batch_ptr_clear_ext(&batches, hk_delete_batch_free);
+	zbx_vector_hk_delete_batch_ptr_destroy(&batches);
+
+	for (size_t j = 0; j < HK_HISTORY_RULES_NUM; j++)
+		zbx_vector_hk_delete_batch_ptr_destroy(&rule_batches[j]);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, deleted);
 
 	return deleted;
+#undef HK_HISTORY_RULES_NUM
 }
 
 /*******************************************************************************************
@@ -1487,7 +1592,9 @@ ZBX_THREAD_ENTRY(housekeeper_thread, args)
 		zbx_setproctitle("%s [removing old history and trends]",
 				get_process_type_string(process_type));
 		sec = zbx_time();
-		int	d_history_and_trends = housekeeping_history_and_trends(now);
+		int	d_history_and_trends = housekeeping_history_and_trends(now,
+				housekeeper_args_in->config_housekeeping_partitions_ahead,
+				housekeeper_args_in->config_housekeeper_delete_workers);
 
 		zbx_setproctitle("%s [removing old problems]", get_process_type_string(process_type));
 		int	d_problems = housekeeping_problems(now, housekeeper_args_in->config_max_housekeeper_delete);
@@ -1068,7 +1068,7 @@ out:
 			for (int j = 0; j < lld_row->overrides.values_num; j++)
 			{
 				zabbix_log(LOG_LEVEL_TRACE, "  lld_overrideid: " ZBX_FS_UI64,
-						*(const zbx_uint64_t *)lld_row->overrides.values[j]);
+						lld_row->overrides.values[j]->overrideid);
 			}
 		}
 	}
@@ -1078,6 +1078,315 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends string that can be NULL to digest                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_md5_append_str(md5_state_t *state, const char *str)
+{
+	md5_byte_t	is_null = (NULL == str ? 1 : 0);
+
+	zbx_md5_append(state, &is_null, (int)sizeof(is_null));
+
+	if (NULL != str)
+		zbx_md5_append(state, (const md5_byte_t *)str, (int)strlen(str) + 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends discovery rule overrides and their operations to digest   *
+ *                                                                            *
+ * Parameters: overrides - [IN]                                               *
+ *             state     - [IN/OUT] digest state                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_overrides_fingerprint(const zbx_vector_lld_override_ptr_t *overrides, md5_state_t *state)
+{
+	for (int i = 0; i < overrides->values_num; i++)
+	{
+		const zbx_lld_override_t	*override = overrides->values[i];
+
+		zbx_md5_append(state, (const md5_byte_t *)&override->overrideid, (int)sizeof(override->overrideid));
+		zbx_md5_append(state, (const md5_byte_t *)&override->step, (int)sizeof(override->step));
+		zbx_md5_append(state, &override->stop, (int)sizeof(override->stop));
+
+		for (int j = 0; j < override->override_operations.values_num; j++)
+		{
+			const zbx_lld_override_operation_t	*op = override->override_operations.values[j];
+			md5_byte_t				props[] = {op->operationtype, op->operator, op->status,
+									op->severity, (md5_byte_t)op->inventory_mode,
+									op->discover};
+
+			zbx_md5_append(state, (const md5_byte_t *)&op->override_operationid,
+					(int)sizeof(op->override_operationid));
+			zbx_md5_append(state, props, (int)sizeof(props));
+			lld_md5_append_str(state, op->value);
+			lld_md5_append_str(state, op->delay);
+			lld_md5_append_str(state, op->history);
+			lld_md5_append_str(state, op->trends);
+
+			for (int k = 0; k < op->tags.values_num; k++)
+			{
+				lld_md5_append_str(state, op->tags.values[k]->tag);
+				lld_md5_append_str(state, op->tags.values[k]->value);
+			}
+
+			zbx_md5_append(state, (const md5_byte_t *)&op->templateids.values_num,
+					(int)sizeof(op->templateids.values_num));
+			zbx_md5_append(state, (const md5_byte_t *)op->templateids.values,
+					op->templateids.values_num * (int)sizeof(zbx_uint64_t));
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: appends configuration of discovery rule prototypes to digest      *
+ *                                                                            *
+ * Parameters: lld_ruleid - [IN]                                              *
+ *             state      - [IN/OUT] digest state                             *
+ *                                                                            *
+ * Comments: Prototype changes, including the ones inherited from templates,  *
+ *           change the digest so that the next value is fully processed.     *
+ *           Changes of user macros used by prototypes are not tracked and    *
+ *           are applied when the fingerprint expires.                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_rule_config_fingerprint(zbx_uint64_t lld_ruleid, md5_state_t *state)
+{
+#define LLD_TRIGGER_PROTOTYPES	"(select f.triggerid from functions f,item_discovery id"			\
+					" where f.itemid=id.itemid and id.parent_itemid=" ZBX_FS_UI64 ")"
+#define LLD_GRAPH_PROTOTYPES	"(select gi.graphid from graphs_items gi,item_discovery id"			\
+					" where gi.itemid=id.itemid and id.parent_itemid=" ZBX_FS_UI64 ")"
+	const char	*sqls[] = {
+		"select i.lifetime_type,i.lifetime,i.enabled_lifetime_type,i.enabled_lifetime"
+		" from items i"
+		" where i.itemid=" ZBX_FS_UI64,
+
+		"select i.itemid,i.name,i.key_,i.type,i.value_type,i.delay,"
+			"i.history,i.trends,i.status,i.trapper_hosts,i.units,i.formula,"
+			"i.logtimefmt,i.valuemapid,i.params,i.ipmi_sensor,i.snmp_oid,i.authtype,"
+			"i.username,i.password,i.publickey,i.privatekey,i.description,i.interfaceid,"
+			"i.jmx_endpoint,i.master_itemid,i.timeout,i.url,i.query_fields,"
+			"i.posts,i.status_codes,i.follow_redirects,i.post_type,i.http_proxy,i.headers,"
+			"i.retrieve_mode,i.request_method,i.output_format,i.ssl_cert_file,i.ssl_key_file,"
+			"i.ssl_key_password,i.verify_peer,i.verify_host,i.allow_traps,i.discover"
+		" from items i,item_discovery id"
+		" where i.itemid=id.itemid"
+			" and id.parent_itemid=" ZBX_FS_UI64
+		" order by i.itemid",
+
+		"select ip.item_preprocid,ip.itemid,ip.step,ip.type,ip.params,ip.error_handler,"
+			"ip.error_handler_params"
+		" from item_preproc ip,item_discovery id"
+		" where ip.itemid=id.itemid"
+			" and id.parent_itemid=" ZBX_FS_UI64
+		" order by ip.item_preprocid",
+
+		"select ip.item_parameterid,ip.itemid,ip.name,ip.value"
+		" from item_parameter ip,item_discovery id"
+		" where ip.itemid=id.itemid"
+			" and id.parent_itemid=" ZBX_FS_UI64
+		" order by ip.item_parameterid",
+
+		"select it.itemtagid,it.itemid,it.tag,it.value"
+		" from item_tag it,item_discovery id"
+		" where it.itemid=id.itemid"
+			" and id.parent_itemid=" ZBX_FS_UI64
+		" order by it.itemtagid",
+
+		"select t.triggerid,t.description,t.expression,t.status,t.type,t.priority,t.comments,"
+			"t.url,t.url_name,t.recovery_expression,t.recovery_mode,t.correlation_mode,"
+			"t.correlation_tag,t.manual_close,t.opdata,t.discover,t.event_name"
+		" from triggers t"
+		" where t.triggerid in " LLD_TRIGGER_PROTOTYPES
+		" order by t.triggerid",
+
+		"select f.functionid,f.triggerid,f.itemid,f.name,f.parameter"
+		" from functions f"
+		" where f.triggerid in " LLD_TRIGGER_PROTOTYPES
+		" order by f.functionid",
+
+		"select tt.triggertagid,tt.triggerid,tt.tag,tt.value"
+		" from trigger_tag tt"
+		" where tt.triggerid in " LLD_TRIGGER_PROTOTYPES
+		" order by tt.triggertagid",
+
+		"select td.triggerdepid,td.triggerid_down,td.triggerid_up"
+		" from trigger_depends td"
+		" where td.triggerid_down in " LLD_TRIGGER_PROTOTYPES
+		" order by td.triggerdepid",
+
+		"select g.graphid,g.name,g.width,g.height,g.yaxismin,g.yaxismax,g.show_work_period,"
+			"g.show_triggers,g.graphtype,g.show_legend,g.show_3d,g.percent_left,g.percent_right,"
+			"g.ymin_type,g.ymin_itemid,g.ymax_type,g.ymax_itemid,g.discover"
+		" from graphs g"
+		" where g.graphid in " LLD_GRAPH_PROTOTYPES
+		" order by g.graphid",
+
+		"select gi.gitemid,gi.graphid,gi.itemid,gi.drawtype,gi.sortorder,gi.color,gi.yaxisside,"
+			"gi.calc_fnc,gi.type"
+		" from graphs_items gi"
+		" where gi.graphid in " LLD_GRAPH_PROTOTYPES
+		" order by gi.gitemid",
+
+		"select h.hostid,h.host,h.name,h.status,h.discover,hi.inventory_mode,h.custom_interfaces"
+		" from hosts h,host_discovery hd"
+			" left join host_inventory hi"
+				" on hd.hostid=hi.hostid"
+		" where h.hostid=hd.hostid"
+			" and hd.parent_itemid=" ZBX_FS_UI64
+		" order by h.hostid",
+
+		"select gp.group_prototypeid,gp.hostid,gp.name,gp.groupid"
+		" from group_prototype gp,host_discovery hd"
+		" where gp.hostid=hd.hostid"
+			" and hd.parent_itemid=" ZBX_FS_UI64
+		" order by gp.group_prototypeid",
+
+		"select hm.hostmacroid,hm.hostid,hm.macro,hm.value,hm.type"
+		" from hostmacro hm,host_discovery hd"
+		" where hm.hostid=hd.hostid"
+			" and hd.parent_itemid=" ZBX_FS_UI64
+		" order by hm.hostmacroid",
+
+		"select ht.hosttagid,ht.hostid,ht.tag,ht.value"
+		" from host_tag ht,host_discovery hd"
+		" where ht.hostid=hd.hostid"
+			" and hd.parent_itemid=" ZBX_FS_UI64
+		" order by ht.hosttagid",
+
+		"select ht.hosttemplateid,ht.hostid,ht.templateid"
+		" from hosts_templates ht,host_discovery hd"
+		" where ht.hostid=hd.hostid"
+			" and hd.parent_itemid=" ZBX_FS_UI64
+		" order by ht.hosttemplateid",
+
+		"select hi.interfaceid,hi.hostid,hi.type,hi.main,hi.useip,hi.ip,hi.dns,hi.port,s.version,s.bulk,"
+			"s.community,s.securityname,s.securitylevel,s.authpassphrase,s.privpassphrase,"
+			"s.authprotocol,s.privprotocol,s.contextname"
+		" from host_discovery hd,interface hi"
+			" left join interface_snmp s"
+				" on hi.interfaceid=s.interfaceid"
+		" where hi.hostid=hd.hostid"
+			" and hd.parent_itemid=" ZBX_FS_UI64
+		" order by hi.interfaceid"
+	};
+	const int	fields_num[] = {4, 45, 7, 4, 4, 17, 5, 4, 3, 18, 9, 7, 4, 5, 4, 3, 18};
+
+	for (size_t i = 0; i < ARRSIZE(sqls); i++)
+	{
+		zbx_db_result_t	result;
+		zbx_db_row_t	row;
+
+		result = zbx_db_select(sqls[i], lld_ruleid);
+
+		while (NULL != (row = zbx_db_fetch(result)))
+		{
+			for (int j = 0; j < fields_num[i]; j++)
+				lld_md5_append_str(state, SUCCEED == zbx_db_is_null(row[j]) ? NULL : row[j]);
+		}
+		zbx_db_free_result(result);
+
+		/* separate results so that rows cannot be shifted between tables */
+		zbx_md5_append(state, (const md5_byte_t *)&i, (int)sizeof(i));
+	}
+#undef LLD_TRIGGER_PROTOTYPES
+#undef LLD_GRAPH_PROTOTYPES
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: calculates digest of discovered rows, their matching overrides,   *
+ *          LLD macro paths used to resolve row macros and configuration of   *
+ *          discovery rule overrides and prototypes                           *
+ *                                                                            *
+ * Parameters: lld_ruleid      - [IN]                                         *
+ *             lld_rows        - [IN] rows passing the discovery rule filter  *
+ *             lld_macro_paths - [IN]                                         *
+ *             overrides       - [IN] discovery rule overrides                *
+ *             digest          - [OUT]                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_rows_fingerprint(zbx_uint64_t lld_ruleid, const zbx_vector_lld_row_ptr_t *lld_rows,
+		const zbx_vector_lld_macro_path_ptr_t *lld_macro_paths, const zbx_vector_lld_override_ptr_t *overrides,
+		md5_byte_t *digest)
+{
+	md5_state_t	state;
+
+	zbx_md5_init(&state);
+
+	for (int i = 0; i < lld_macro_paths->values_num; i++)
+	{
+		const zbx_lld_macro_path_t	*lld_macro_path = lld_macro_paths->values[i];
+
+		zbx_md5_append(&state, (const md5_byte_t *)lld_macro_path->lld_macro,
+				(int)strlen(lld_macro_path->lld_macro) + 1);
+		zbx_md5_append(&state, (const md5_byte_t *)lld_macro_path->path, (int)strlen(lld_macro_path->path) + 1);
+	}
+
+	for (int i = 0; i < lld_rows->values_num; i++)
+	{
+		const zbx_lld_row_t	*lld_row = lld_rows->values[i];
+
+		zbx_md5_append(&state, (const md5_byte_t *)lld_row->jp_row.start,
+				(int)(lld_row->jp_row.end - lld_row->jp_row.start + 1));
+		zbx_md5_append(&state, (const md5_byte_t *)&lld_row->overrides.values_num,
+				(int)sizeof(lld_row->overrides.values_num));
+
+		for (int j = 0; j < lld_row->overrides.values_num; j++)
+		{
+			zbx_md5_append(&state, (const md5_byte_t *)&lld_row->overrides.values[j]->overrideid,
+					(int)sizeof(zbx_uint64_t));
+		}
+	}
+
+	lld_overrides_fingerprint(overrides, &state);
+	lld_rule_config_fingerprint(lld_ruleid, &state);
+
+	zbx_md5_finish(&state, digest);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: checks if discovery rule value with the same fingerprint was      *
+ *          fully processed recently enough to be skipped                     *
+ *                                                                            *
+ * Parameters: fingerprint      - [IN] last fully processed value fingerprint *
+ *             digest           - [IN] digest of the current value            *
+ *             now              - [IN] current time                           *
+ *             lifetime         - [IN] lost resource lifetime                 *
+ *             enabled_lifetime - [IN] lost resource enabled lifetime         *
+ *                                                                            *
+ * Return value: SUCCEED - value is unchanged and can be skipped              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Discovered objects are not marked as checked while values are    *
+ *           skipped, so lost resource timers are processed with a delay. To  *
+ *           keep it small the fingerprint expires after a fraction of lost   *
+ *           resource lifetime.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	lld_fingerprint_match(const zbx_lld_fingerprint_t *fingerprint, const md5_byte_t *digest, int now,
+		const zbx_lld_lifetime_t *lifetime, const zbx_lld_lifetime_t *enabled_lifetime)
+{
+#define LLD_LIFETIME_FRACTION	10
+	int	ttl = ZBX_LLD_FINGERPRINT_TTL;
+
+	if (ZBX_LLD_LIFETIME_TYPE_AFTER == lifetime->type)
+		ttl = MIN(ttl, lifetime->duration / LLD_LIFETIME_FRACTION);
+
+	if (ZBX_LLD_LIFETIME_TYPE_AFTER == enabled_lifetime->type)
+		ttl = MIN(ttl, enabled_lifetime->duration / LLD_LIFETIME_FRACTION);
+
+	if (0 == fingerprint->lastcheck || ttl <= now - fingerprint->lastcheck)
+		return FAIL;
+
+	return 0 == memcmp(fingerprint->digest, digest, ZBX_MD5_DIGEST_SIZE) ? SUCCEED : FAIL;
+#undef LLD_LIFETIME_FRACTION
+}
+
 static void	lld_item_link_free(zbx_lld_item_link_t *item_link)
 {
 	zbx_free(item_link);
@@ -1095,14 +1404,22 @@ static void	lld_row_free(zbx_lld_row_t *lld_row)
  *                                                                            *
  * Purpose: adds or updates items, triggers and graphs for discovery item     *
  *                                                                            *
- * Parameters: lld_ruleid - [IN] discovery rule id from database              *
- *             value      - [IN] received value from agent                    *
- *             error      - [OUT] Error or informational message. Will be set *
- *                               to empty string on successful discovery      *
- *                               without additional information.              *
+ * Parameters: lld_ruleid  - [IN] discovery rule id from database             *
+ *             value       - [IN] received value from agent                   *
+ *             fingerprint - [IN/OUT] fingerprint of the last fully processed *
+ *                                    value, reset if the value could not be  *
+ *                                    fully processed                         *
+ *             error       - [OUT] Error or informational message. Will be    *
+ *                                 set to empty string on successful          *
+ *                                 discovery without additional information.  *
+ *                                                                            *
+ * Comments: Values with the same discovered rows and matching overrides as   *
+ *           the last fully processed value are skipped unless discovery rule *
+ *           configuration has been changed since then.                       *
  *                                                                            *
  ******************************************************************************/
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error)
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, zbx_lld_fingerprint_t *fingerprint,
+		char **error)
 {
 #define LIFETIME_DURATION_GET(lt, lt_str)									\
 	do													\
@@ -1141,9 +1458,14 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 	zbx_dc_um_handle_t		*um_handle;
 	zbx_vector_lld_override_ptr_t	overrides;
 	zbx_vector_lld_row_ptr_t	lld_rows;
+	zbx_lld_fingerprint_t		fingerprint_last = *fingerprint;
+	md5_byte_t			digest[ZBX_MD5_DIGEST_SIZE];
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64, __func__, lld_ruleid);
 
+	/* fingerprint is kept only if the value is fully processed or skipped */
+	fingerprint->lastcheck = 0;
+
 	um_handle = zbx_dc_open_user_macros();
 
 	zbx_vector_lld_row_ptr_create(&lld_rows);
@@ -1213,6 +1535,21 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	now = time(NULL);
 
+	lld_rows_fingerprint(lld_ruleid, &lld_rows, &lld_macro_paths, &overrides, digest);
+
+	if (SUCCEED == lld_fingerprint_match(&fingerprint_last, digest, (int)now, &lifetime, &enabled_lifetime))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "skipped unchanged value of discovery rule \"%s:%s\"",
+				zbx_host_string(hostid), discovery_key);
+
+		*fingerprint = fingerprint_last;
+
+		if (NULL != info)
+			*error = zbx_strdcat(*error, info);
+
+		goto out;
+	}
+
 	zbx_config_get(&cfg, ZBX_CONFIG_FLAGS_AUDITLOG_ENABLED | ZBX_CONFIG_FLAGS_AUDITLOG_MODE);
 	zbx_audit_init(cfg.auditlog_enabled, cfg.auditlog_mode, ZBX_AUDIT_LLD_CONTEXT);
 
@@ -1243,6 +1580,13 @@ int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char
 
 	lld_update_hosts(lld_ruleid, &lld_rows, &lld_macro_paths, error, &lifetime, &enabled_lifetime, now);
 
+	/* values with processing errors are processed again to retry failed objects */
+	if ('\0' == **error)
+	{
+		memcpy(fingerprint->digest, digest, sizeof(digest));
+		fingerprint->lastcheck = (int)now;
+	}
+
 	/* add informative warning to the error message about lack of data for macros used in filter */
 	if (NULL != info)
 		*error = zbx_strdcat(*error, info);
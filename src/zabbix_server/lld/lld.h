@@ -20,6 +20,7 @@
 #include "zbxdbhigh.h"
 #include "zbxcacheconfig.h"
 #include "zbxregexp.h"
+#include "lld_manager.h"
 
 typedef struct zbx_lld_item_full_s zbx_lld_item_full_t;
 typedef struct zbx_lld_dependency_s zbx_lld_dependency_t;
@@ -391,7 +392,8 @@ typedef void	(*object_audit_entry_update_status_f)(int audit_context_mode, zbx_u
 		int status_old, int status_new);
 typedef int	(get_object_status_val)(int status);
 
-int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, char **error);
+int	lld_process_discovery_rule(zbx_uint64_t lld_ruleid, const char *value, zbx_lld_fingerprint_t *fingerprint,
+		char **error);
 
 /* discovered resource tracking (*_discovery tables) */
 typedef struct
@@ -44,6 +44,9 @@ typedef struct
 {
 	zbx_ipc_client_t	*client;
 	zbx_lld_rule_t		*rule;
+
+	/* fingerprint of the rule being processed was reset and must not be stored */
+	unsigned char		fingerprint_reset;
 }
 zbx_lld_worker_t;
 
@@ -73,6 +76,8 @@ typedef struct
 	/* the number of queued LLD rules */
 	zbx_uint64_t			queued_num;
 
+	/* fingerprints of the last fully processed LLD rule values */
+	zbx_hashset_t			fingerprints;
 }
 zbx_lld_manager_t;
 
@@ -145,6 +150,8 @@ static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f
 
 	zbx_binary_heap_create(&manager->rule_queue, rule_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
 
+	zbx_hashset_create(&manager->fingerprints, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
 	manager->next_worker_index = 0;
 
 	for (int i = 0; i < get_config_forks_cb(ZBX_PROCESS_TYPE_LLDWORKER); i++)
@@ -152,6 +159,8 @@ static void	lld_manager_init(zbx_lld_manager_t *manager, zbx_get_config_forks_f
 		worker = (zbx_lld_worker_t *)zbx_malloc(NULL, sizeof(zbx_lld_worker_t));
 
 		worker->client = NULL;
+		worker->rule = NULL;
+		worker->fingerprint_reset = 0;
 
 		zbx_vector_lld_worker_ptr_append(&manager->workers, worker);
 	}
@@ -264,7 +273,7 @@ static void	lld_queue_request(zbx_lld_manager_t *manager, const zbx_ipc_message_
 	data->next = NULL;
 
 	zbx_lld_deserialize_item_value(message->data, &data->itemid, &hostid, &data->value, &data->ts, &data->meta,
-			&data->lastlogsize, &data->mtime, &data->error);
+			&data->lastlogsize, &data->mtime, &data->error, NULL);
 
 	if (NULL == (rule = zbx_hashset_search(&manager->rule_index, &hostid)))
 	{
@@ -326,14 +335,23 @@ static void	lld_process_next_request(zbx_lld_manager_t *manager, zbx_lld_worker_
 	unsigned char		*buf;
 	zbx_uint32_t		buf_len;
 	zbx_lld_data_t		*data;
+	zbx_lld_fingerprint_t	*fingerprint, fingerprint_local = {0};
 
 	elem = zbx_binary_heap_find_min(&manager->rule_queue);
 	worker->rule = elem->data;
+	worker->fingerprint_reset = 0;
 	zbx_binary_heap_remove_min(&manager->rule_queue);
 
 	data = worker->rule->head;
+
+	if (NULL == (fingerprint = (zbx_lld_fingerprint_t *)zbx_hashset_search(&manager->fingerprints,
+			&data->itemid)))
+	{
+		fingerprint = &fingerprint_local;
+	}
+
 	buf_len = zbx_lld_serialize_item_value(&buf, data->itemid, 0, data->value, &data->ts, data->meta,
-			data->lastlogsize, data->mtime, data->error);
+			data->lastlogsize, data->mtime, data->error, fingerprint);
 	zbx_ipc_client_send(worker->client, ZBX_IPC_LLD_TASK, buf, buf_len);
 	zbx_free(buf);
 }
@@ -362,9 +380,11 @@ static void	lld_process_queue(zbx_lld_manager_t *manager)
  *                                                                            *
  * Parameters: manager - [IN]                                                 *
  *             client  - [IN] worker's IPC client connection                  *
+ *             message - [IN] response with optional value fingerprint        *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client)
+static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *client,
+		const zbx_ipc_message_t *message)
 {
 	zbx_lld_worker_t	*worker;
 	zbx_lld_rule_t		*rule;
@@ -376,6 +396,28 @@ static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *cli
 
 	zabbix_log(LOG_LEVEL_DEBUG, "discovery rule:" ZBX_FS_UI64 " has been processed", worker->rule->head->itemid);
 
+	/* response without fingerprint means that the rule value was skipped as unchanged */
+	if (0 != message->size)
+	{
+		zbx_lld_fingerprint_t	fingerprint, *fingerprint_old;
+
+		zbx_lld_deserialize_fingerprint(message->data, &fingerprint);
+
+		if (0 != worker->fingerprint_reset)
+			fingerprint.lastcheck = 0;
+
+		if (NULL != (fingerprint_old = (zbx_lld_fingerprint_t *)zbx_hashset_search(&manager->fingerprints,
+				&fingerprint.itemid)))
+		{
+			if (0 != fingerprint.lastcheck)
+				*fingerprint_old = fingerprint;
+			else
+				zbx_hashset_remove_direct(&manager->fingerprints, fingerprint_old);
+		}
+		else if (0 != fingerprint.lastcheck)
+			zbx_hashset_insert(&manager->fingerprints, &fingerprint, sizeof(fingerprint));
+	}
+
 	rule = worker->rule;
 	worker->rule = NULL;
 
@@ -403,6 +445,66 @@ static void	lld_process_result(zbx_lld_manager_t *manager, zbx_ipc_client_t *cli
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes fingerprints of discovery rules so that their next values *
+ *          are fully processed                                               *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             message - [IN] message with item identifiers                   *
+ *                                                                            *
+ * Comments: Fingerprints of rules being processed at the moment are not      *
+ *           stored when workers report them.                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_reset_fingerprints(zbx_lld_manager_t *manager, const zbx_ipc_message_t *message)
+{
+	const zbx_uint64_t	*itemids = (const zbx_uint64_t *)message->data;
+	int			itemids_num = (int)(message->size / sizeof(zbx_uint64_t));
+
+	for (int i = 0; i < itemids_num; i++)
+	{
+		zbx_lld_fingerprint_t	*fingerprint;
+
+		if (NULL != (fingerprint = (zbx_lld_fingerprint_t *)zbx_hashset_search(&manager->fingerprints,
+				&itemids[i])))
+		{
+			zbx_hashset_remove_direct(&manager->fingerprints, fingerprint);
+		}
+
+		for (int j = 0; j < manager->workers.values_num; j++)
+		{
+			zbx_lld_worker_t	*worker = manager->workers.values[j];
+
+			if (NULL != worker->rule && worker->rule->head->itemid == itemids[i])
+				worker->fingerprint_reset = 1;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: removes expired fingerprints of rules that are not processed      *
+ *          anymore                                                           *
+ *                                                                            *
+ * Parameters: manager - [IN]                                                 *
+ *             now     - [IN] current time                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	lld_remove_expired_fingerprints(zbx_lld_manager_t *manager, int now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_lld_fingerprint_t	*fingerprint;
+
+	zbx_hashset_iter_reset(&manager->fingerprints, &iter);
+
+	while (NULL != (fingerprint = (zbx_lld_fingerprint_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (ZBX_LLD_FINGERPRINT_TTL <= now - fingerprint->lastcheck)
+			zbx_hashset_iter_remove(&iter);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: processes external diagnostic statistics request                  *
@@ -513,7 +615,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 	char			*error = NULL;
 	zbx_ipc_client_t	*client;
 	zbx_ipc_message_t	*message;
-	double			time_stat, time_now, sec, time_idle = 0;
+	double			time_stat, time_now, sec, time_idle = 0, time_fingerprints;
 	zbx_lld_manager_t	manager;
 	zbx_uint64_t		processed_num = 0;
 	zbx_timespec_t		timeout = {1, 0};
@@ -540,6 +642,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 
 	/* initialize statistics */
 	time_stat = zbx_time();
+	time_fingerprints = time_stat;
 
 	zbx_setproctitle("%s #%d started", get_process_type_string(process_type), process_num);
 
@@ -561,6 +664,12 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 			processed_num = 0;
 		}
 
+		if (ZBX_LLD_FINGERPRINT_TTL <= time_now - time_fingerprints)
+		{
+			lld_remove_expired_fingerprints(&manager, (int)time_now);
+			time_fingerprints = time_now;
+		}
+
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_IDLE);
 		ret = zbx_ipc_service_recv(&lld_service, &timeout, &client, &message);
 		zbx_update_selfmon_counter(info, ZBX_PROCESS_STATE_BUSY);
@@ -583,7 +692,7 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 					lld_process_queue(&manager);
 					break;
 				case ZBX_IPC_LLD_DONE:
-					lld_process_result(&manager, client);
+					lld_process_result(&manager, client, message);
 					processed_num++;
 					manager.queued_num--;
 					break;
@@ -597,6 +706,9 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 				case ZBX_IPC_LLD_TOP_ITEMS:
 					lld_process_top_items(&manager, client, message);
 					break;
+				case ZBX_IPC_LLD_RESET_FINGERPRINTS:
+					lld_reset_fingerprints(&manager, message);
+					break;
 			}
 
 			zbx_ipc_message_free(message);
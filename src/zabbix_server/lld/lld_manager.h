@@ -18,6 +18,7 @@
 #include "zbxthreads.h"
 #include "zbxtime.h"
 #include "zbxalgo.h"
+#include "zbxhash.h"
 
 typedef struct zbx_lld_value
 {
@@ -65,6 +66,23 @@ zbx_lld_rule_info_t;
 
 ZBX_PTR_VECTOR_DECL(lld_rule_info_ptr, zbx_lld_rule_info_t*)
 
+/* maximum time an unchanged discovery value can be skipped without full processing */
+#define ZBX_LLD_FINGERPRINT_TTL	(15 * SEC_PER_MIN)
+
+/* fingerprint of the last fully processed LLD rule value, kept by manager and passed to workers */
+typedef struct
+{
+	/* the LLD rule item id */
+	zbx_uint64_t	itemid;
+
+	/* digest of discovered rows with their matching overrides */
+	md5_byte_t	digest[ZBX_MD5_DIGEST_SIZE];
+
+	/* time of the last full processing, 0 if there is no valid fingerprint */
+	int		lastcheck;
+}
+zbx_lld_fingerprint_t;
+
 typedef struct
 {
 	zbx_get_config_forks_f	get_process_forks_cb_arg;
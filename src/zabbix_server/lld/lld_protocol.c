@@ -18,9 +18,17 @@
 #include "zbxipcservice.h"
 #include "zbxsysinfo.h"
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: serializes LLD rule value                                         *
+ *                                                                            *
+ * Comments: The fingerprint is sent only by manager to workers and must be   *
+ *           NULL for values queued to manager.                               *
+ *                                                                            *
+ ******************************************************************************/
 zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, zbx_uint64_t hostid,
 		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
-		const char *error)
+		const char *error, const zbx_lld_fingerprint_t *fingerprint)
 {
 	unsigned char	*ptr;
 	zbx_uint32_t	data_len = 0, value_len, error_len;
@@ -38,6 +46,12 @@ zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t ite
 		zbx_serialize_prepare_value(data_len, mtime);
 	}
 
+	if (NULL != fingerprint)
+	{
+		zbx_serialize_prepare_value(data_len, fingerprint->digest);
+		zbx_serialize_prepare_value(data_len, fingerprint->lastcheck);
+	}
+
 	*data = (unsigned char *)zbx_malloc(NULL, data_len);
 
 	ptr = *data;
@@ -50,7 +64,13 @@ zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t ite
 	if (0 != meta)
 	{
 		ptr += zbx_serialize_value(ptr, lastlogsize);
-		(void)zbx_serialize_value(ptr, mtime);
+		ptr += zbx_serialize_value(ptr, mtime);
+	}
+
+	if (NULL != fingerprint)
+	{
+		ptr += zbx_serialize_value(ptr, fingerprint->digest);
+		(void)zbx_serialize_value(ptr, fingerprint->lastcheck);
 	}
 
 	return data_len;
@@ -58,7 +78,7 @@ zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t ite
 
 void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *itemid, zbx_uint64_t *hostid,
 		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
-		char **error)
+		char **error, zbx_lld_fingerprint_t *fingerprint)
 {
 	zbx_uint32_t	value_len, error_len;
 
@@ -71,10 +91,43 @@ void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *ite
 	if (0 != *meta)
 	{
 		data += zbx_deserialize_value(data, lastlogsize);
-		(void)zbx_deserialize_value(data, mtime);
+		data += zbx_deserialize_value(data, mtime);
+	}
+
+	if (NULL != fingerprint)
+	{
+		fingerprint->itemid = *itemid;
+		data += zbx_deserialize_value(data, &fingerprint->digest);
+		(void)zbx_deserialize_value(data, &fingerprint->lastcheck);
 	}
 }
 
+zbx_uint32_t	zbx_lld_serialize_fingerprint(unsigned char **data, const zbx_lld_fingerprint_t *fingerprint)
+{
+	unsigned char	*ptr;
+	zbx_uint32_t	data_len = 0;
+
+	zbx_serialize_prepare_value(data_len, fingerprint->itemid);
+	zbx_serialize_prepare_value(data_len, fingerprint->digest);
+	zbx_serialize_prepare_value(data_len, fingerprint->lastcheck);
+
+	*data = (unsigned char *)zbx_malloc(NULL, data_len);
+
+	ptr = *data;
+	ptr += zbx_serialize_value(ptr, fingerprint->itemid);
+	ptr += zbx_serialize_value(ptr, fingerprint->digest);
+	(void)zbx_serialize_value(ptr, fingerprint->lastcheck);
+
+	return data_len;
+}
+
+void	zbx_lld_deserialize_fingerprint(const unsigned char *data, zbx_lld_fingerprint_t *fingerprint)
+{
+	data += zbx_deserialize_value(data, &fingerprint->itemid);
+	data += zbx_deserialize_value(data, &fingerprint->digest);
+	(void)zbx_deserialize_value(data, &fingerprint->lastcheck);
+}
+
 zbx_uint32_t	zbx_lld_serialize_diag_stats(unsigned char **data, zbx_uint64_t items_num, zbx_uint64_t values_num)
 {
 	unsigned char	*ptr;
@@ -195,7 +248,8 @@ void	zbx_lld_queue_value(zbx_uint64_t itemid, zbx_uint64_t hostid, const char *v
 		exit(EXIT_FAILURE);
 	}
 
-	data_len = zbx_lld_serialize_item_value(&data, itemid, hostid, value, ts, meta, lastlogsize, mtime, error);
+	data_len = zbx_lld_serialize_item_value(&data, itemid, hostid, value, ts, meta, lastlogsize, mtime, error,
+			NULL);
 
 	if (FAIL == zbx_ipc_socket_write(&socket, ZBX_IPC_LLD_REQUEST, data, data_len))
 	{
@@ -240,6 +294,38 @@ void	zbx_lld_process_agent_result(zbx_uint64_t itemid, zbx_uint64_t hostid, AGEN
 		zbx_lld_queue_value(itemid, hostid, value, ts, meta, lastlogsize, mtime, error);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Purpose: forces full processing of the next values of discovery rules      *
+ *                                                                            *
+ * Parameters: itemids - [IN] identifiers of items to reset, not discovery    *
+ *                            rules are ignored by manager                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_lld_reset_fingerprints(const zbx_vector_uint64_t *itemids)
+{
+	zbx_ipc_socket_t	lld_socket;
+	char			*error = NULL;
+
+	if (0 == itemids->values_num)
+		return;
+
+	if (FAIL == zbx_ipc_socket_open(&lld_socket, ZBX_IPC_SERVICE_LLD, SEC_PER_MIN, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot connect to LLD manager service: %s", error);
+		zbx_free(error);
+		return;
+	}
+
+	if (FAIL == zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_RESET_FINGERPRINTS,
+			(const unsigned char *)itemids->values, (zbx_uint32_t)itemids->values_num * sizeof(zbx_uint64_t)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send fingerprint reset request to LLD manager service");
+	}
+
+	zbx_ipc_socket_close(&lld_socket);
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: gets queue size (enqueued value count) of LLD manager             *
@@ -46,13 +46,20 @@
 /* manager -> process */
 #define ZBX_IPC_LLD_TOP_ITEMS_RESULT	1403
 
+/* process -> manager */
+#define ZBX_IPC_LLD_RESET_FINGERPRINTS	1500
+
 zbx_uint32_t	zbx_lld_serialize_item_value(unsigned char **data, zbx_uint64_t itemid, zbx_uint64_t hostid,
 		const char *value, const zbx_timespec_t *ts, unsigned char meta, zbx_uint64_t lastlogsize, int mtime,
-		const char *error);
+		const char *error, const zbx_lld_fingerprint_t *fingerprint);
 
 void	zbx_lld_deserialize_item_value(const unsigned char *data, zbx_uint64_t *itemid, zbx_uint64_t *hostid,
 		char **value, zbx_timespec_t *ts, unsigned char *meta, zbx_uint64_t *lastlogsize, int *mtime,
-		char **error);
+		char **error, zbx_lld_fingerprint_t *fingerprint);
+
+zbx_uint32_t	zbx_lld_serialize_fingerprint(unsigned char **data, const zbx_lld_fingerprint_t *fingerprint);
+
+void	zbx_lld_deserialize_fingerprint(const unsigned char *data, zbx_lld_fingerprint_t *fingerprint);
 
 zbx_uint32_t	zbx_lld_serialize_diag_stats(unsigned char **data, zbx_uint64_t items_num, zbx_uint64_t values_num);
 
@@ -67,6 +74,8 @@ void	zbx_lld_queue_value(zbx_uint64_t itemid, zbx_uint64_t hostid, const char *v
 void	zbx_lld_process_agent_result(zbx_uint64_t itemid, zbx_uint64_t hostid, AGENT_RESULT *result,
 		zbx_timespec_t *ts, char *error);
 
+void	zbx_lld_reset_fingerprints(const zbx_vector_uint64_t *itemids);
+
 int	zbx_lld_get_queue_size(zbx_uint64_t *size, char **error);
 
 int	zbx_lld_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, char **error);
@@ -51,23 +51,32 @@ static void	lld_register_worker(zbx_ipc_socket_t *socket)
  * Purpose: Processes LLD task and updates rule state/error in configuration  *
  *          cache and database.                                               *
  *                                                                            *
- * Parameters: message - [IN] message with LLD request                        *
+ * Parameters: message     - [IN] message with LLD request                    *
+ *             fingerprint - [OUT] fingerprint of the last fully processed    *
+ *                                 rule value                                 *
+ *                                                                            *
+ * Return value: SUCCEED - fingerprint was changed and must be sent to        *
+ *                         manager                                            *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static void	lld_process_task(const zbx_ipc_message_t *message)
+static int	lld_process_task(const zbx_ipc_message_t *message, zbx_lld_fingerprint_t *fingerprint)
 {
 	zbx_uint64_t		itemid, hostid, lastlogsize;
 	char			*value, *error;
 	zbx_timespec_t		ts;
 	zbx_item_diff_t		diff;
 	zbx_dc_item_t		item;
+	zbx_lld_fingerprint_t	fingerprint_last;
 	int			errcode, mtime;
 	unsigned char		state, meta;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	zbx_lld_deserialize_item_value(message->data, &itemid, &hostid, &value, &ts, &meta, &lastlogsize, &mtime,
-			&error);
+			&error, fingerprint);
+
+	fingerprint_last = *fingerprint;
 
 	zbx_dc_config_get_items_by_itemids(&item, &itemid, &errcode, 1);
 
@@ -80,10 +89,15 @@ static void	lld_process_task(const zbx_ipc_message_t *message)
 
 	if (NULL != error || NULL != value)
 	{
-		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, &error))
+		if (NULL == error && SUCCEED == lld_process_discovery_rule(itemid, value, fingerprint, &error))
+		{
 			state = ITEM_STATE_NORMAL;
+		}
 		else
+		{
 			state = ITEM_STATE_NOTSUPPORTED;
+			fingerprint->lastcheck = 0;
+		}
 
 		if (state != item.state)
 		{
@@ -164,6 +178,14 @@ out:
 	zbx_free(error);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	if (fingerprint_last.lastcheck != fingerprint->lastcheck ||
+			0 != memcmp(fingerprint_last.digest, fingerprint->digest, ZBX_MD5_DIGEST_SIZE))
+	{
+		return SUCCEED;
+	}
+
+	return FAIL;
 }
 
 ZBX_THREAD_ENTRY(lld_worker_thread, args)
@@ -171,6 +193,7 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 	char			*error = NULL;
 	zbx_ipc_socket_t	lld_socket;
 	zbx_ipc_message_t	message;
+	zbx_lld_fingerprint_t	fingerprint;
 	double			time_stat, time_idle = 0, time_now, time_read;
 	zbx_uint64_t		processed_num = 0;
 	zbx_thread_info_t	*info = &((zbx_thread_args_t *)args)->info;
@@ -234,8 +257,18 @@ ZBX_THREAD_ENTRY(lld_worker_thread, args)
 		switch (message.code)
 		{
 			case ZBX_IPC_LLD_TASK:
-				lld_process_task(&message);
-				zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, NULL, 0);
+				if (SUCCEED == lld_process_task(&message, &fingerprint))
+				{
+					unsigned char	*data;
+					zbx_uint32_t	data_len;
+
+					data_len = zbx_lld_serialize_fingerprint(&data, &fingerprint);
+					zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, data, data_len);
+					zbx_free(data);
+				}
+				else
+					zbx_ipc_socket_write(&lld_socket, ZBX_IPC_LLD_DONE, NULL, 0);
+
 				processed_num++;
 				break;
 		}
@@ -19,6 +19,8 @@
 
 #include "zbxcachevalue.h"
 #include "zbxcacheconfig.h"
+#include "zbxcachehistory.h"
+#include "zbxexport.h"
 #include "zbxconnector.h"
 #include "zbxproxybuffer.h"
 #include "zbxpgservice.h"
@@ -223,6 +225,8 @@ int	zbx_get_value_internal_ext_server(const zbx_dc_item_t *item, const char *par
 				SET_UI64_RESULT(result, stats.misses);
 			else if (0 == strcmp(param3, "mode"))
 				SET_UI64_RESULT(result, stats.mode);
+			else if (0 == strcmp(param3, "compression"))
+				SET_DBL_RESULT(result, stats.compression_ratio);
 			else
 			{
 				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
@@ -235,6 +239,76 @@ int	zbx_get_value_internal_ext_server(const zbx_dc_item_t *item, const char *par
 			goto out;
 		}
 	}
+	else if (0 == strcmp(param1, "history_storage"))	/* zabbix["history_storage",<mode>] */
+	{
+		zbx_history_storage_stats_t	stats;
+
+		if (2 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		param2 = get_rparam(request, 1);
+
+		zbx_dc_get_history_storage_stats(&stats);
+
+		if (0 == strcmp(param2, "requests"))
+			SET_UI64_RESULT(result, stats.requests);
+		else if (0 == strcmp(param2, "documents"))
+			SET_UI64_RESULT(result, stats.documents);
+		else if (0 == strcmp(param2, "bytes"))
+			SET_UI64_RESULT(result, stats.bytes);
+		else if (0 == strcmp(param2, "retried"))
+			SET_UI64_RESULT(result, stats.retried);
+		else if (0 == strcmp(param2, "failed"))
+			SET_UI64_RESULT(result, stats.failed);
+		else if (0 == strcmp(param2, "latency"))
+			SET_DBL_RESULT(result, 0 != stats.requests ? stats.time / (double)stats.requests : 0);
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+	}
+	else if (0 == strcmp(param1, "export"))	/* zabbix["export",<mode>] */
+	{
+		zbx_export_stats_t	stats;
+
+		if (2 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		if (SUCCEED != zbx_export_get_stats(&stats))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Background export writer is not enabled."));
+			goto out;
+		}
+
+		param2 = get_rparam(request, 1);
+
+		if (0 == strcmp(param2, "written"))
+			SET_UI64_RESULT(result, stats.written_records);
+		else if (0 == strcmp(param2, "bytes"))
+			SET_UI64_RESULT(result, stats.written_bytes);
+		else if (0 == strcmp(param2, "dropped"))
+			SET_UI64_RESULT(result, stats.dropped_records);
+		else if (0 == strcmp(param2, "dropped_bytes"))
+			SET_UI64_RESULT(result, stats.dropped_bytes);
+		else if (0 == strcmp(param2, "waits"))
+			SET_UI64_RESULT(result, stats.waits);
+		else if (0 == strcmp(param2, "wait_time"))
+			SET_DBL_RESULT(result, stats.wait_time);
+		else if (0 == strcmp(param2, "queue"))
+			SET_UI64_RESULT(result, stats.queued_bytes);
+		else
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+	}
 	else if (0 == strcmp(param1, "lld_queue"))
 	{
 		zbx_uint64_t	value;
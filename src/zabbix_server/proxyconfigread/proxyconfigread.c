@@ -1607,7 +1607,8 @@ void	zbx_send_proxyconfig(zbx_socket_t *sock, const struct zbx_json_parse *jp,
 
 	zbx_update_proxy_data(&proxy, version_str, version_int, time(NULL), ZBX_FLAGS_PROXY_DIFF_UPDATE_CONFIG);
 
-	flags |= ZBX_TCP_COMPRESS;
+	/* use zstd only if proxy has advertised it in request */
+	flags |= zbx_tcp_compress_flags(zbx_tcp_zstd_accepted(jp));
 
 	if (ZBX_PROXY_VERSION_CURRENT != proxy.compatibility)
 	{
@@ -1631,7 +1632,7 @@ void	zbx_send_proxyconfig(zbx_socket_t *sock, const struct zbx_json_parse *jp,
 
 	loglevel = (ZBX_PROXYCONFIG_STATUS_DATA == status ? LOG_LEVEL_WARNING : LOG_LEVEL_DEBUG);
 
-	if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
+	if (SUCCEED != zbx_tcp_compress((unsigned char)flags, j.buffer, j.buffer_size, &buffer, &buffer_size))
 	{
 		zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
 		goto clean;
@@ -176,7 +176,16 @@ static int	get_data_from_proxy(zbx_dc_proxy_t *proxy, const char *request, int c
 
 	zbx_json_addstring(&j, "request", request, ZBX_JSON_TYPE_STRING);
 
-	if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
+	if (0 == strcmp(request, ZBX_PROTO_VALUE_PROXY_DATA))
+	{
+		zbx_json_addstring(&j, ZBX_PROTO_TAG_HISTORY_FORMAT, ZBX_PROTO_VALUE_HISTORY_FORMAT_COLUMNS,
+				ZBX_JSON_TYPE_STRING);
+	}
+
+	/* proxy responds with zstd compressed data only if it is advertised in request */
+	zbx_tcp_zstd_advertise(&j);
+
+	if (SUCCEED != zbx_tcp_compress(flags, j.buffer, j.buffer_size, &buffer, &buffer_size))
 	{
 		zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
 		ret = FAIL;
@@ -203,8 +212,7 @@ static int	get_data_from_proxy(zbx_dc_proxy_t *proxy, const char *request, int c
 				{
 					int	flags_response = ZBX_TCP_PROTOCOL;
 
-					if (0 != (s.protocol & ZBX_TCP_COMPRESS))
-						flags_response |= ZBX_TCP_COMPRESS;
+					flags_response |= (s.protocol & ZBX_TCP_COMPRESS_FLAGS);
 
 					zbx_send_response_ext(&s, FAIL, "Zabbix server shutdown in progress", NULL,
 							flags_response, config_timeout);
@@ -259,7 +267,7 @@ static int	proxy_send_configuration(zbx_dc_proxy_t *proxy, const zbx_config_vaul
 		const char *config_ssl_cert_location, const char *config_ssl_key_location)
 {
 	char				*error = NULL, *buffer = NULL;
-	int				ret, flags = ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS, loglevel;
+	int				ret, flags = ZBX_TCP_PROTOCOL, loglevel;
 	zbx_socket_t			s;
 	struct zbx_json			j;
 	struct zbx_json_parse		jp;
@@ -290,6 +298,9 @@ static int	proxy_send_configuration(zbx_dc_proxy_t *proxy, const zbx_config_vaul
 		goto clean;
 	}
 
+	/* use zstd only if proxy has advertised it in configuration information */
+	flags |= zbx_tcp_compress_flags(zbx_tcp_zstd_accepted(&jp));
+
 	zbx_json_clean(&j);
 
 	if (SUCCEED != (ret = zbx_proxyconfig_get_data(proxy, &jp, &j, &status, config_vault, config_source_ip,
@@ -300,7 +311,7 @@ static int	proxy_send_configuration(zbx_dc_proxy_t *proxy, const zbx_config_vaul
 		goto clean;
 	}
 
-	if (SUCCEED != zbx_compress(j.buffer, j.buffer_size, &buffer, &buffer_size))
+	if (SUCCEED != zbx_tcp_compress(flags, j.buffer, j.buffer_size, &buffer, &buffer_size))
 	{
 		zabbix_log(LOG_LEVEL_ERR,"cannot compress data: %s", zbx_compress_strerror());
 		ret = FAIL;
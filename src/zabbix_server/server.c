@@ -100,6 +100,7 @@
 #include "zbx_ha_constants.h"
 #include "zbxescalations.h"
 #include "zbxbincommon.h"
+#include "zbxcompress.h"
 
 #ifdef HAVE_LIBCURL
 #	include "zbxcurl.h"
@@ -139,8 +140,8 @@ static const char	*help_message[] = {
 	"      " ZBX_SECRETS_RELOAD "                  Reload secrets from Vault",
 	"      " ZBX_DIAGINFO "=section                Log internal diagnostic information of the",
 	"                                        section (historycache, preprocessing, alerting,",
-	"                                        lld, valuecache, locks, connector) or everything if section is",
-	"                                        not specified",
+	"                                        lld, valuecache, locks, connector, database) or everything if",
+	"                                        section is not specified",
 	"      " ZBX_PROF_ENABLE "=target              Enable profiling, affects all processes if",
 	"                                        target is not specified",
 	"      " ZBX_PROF_DISABLE "=target             Disable profiling, affects all processes if",
@@ -295,6 +296,7 @@ ZBX_GET_CONFIG_VAR2(char *, const char *, zbx_config_source_ip, NULL)
 ZBX_GET_CONFIG_VAR2(char *, const char *, zbx_config_tmpdir, NULL)
 ZBX_GET_CONFIG_VAR2(char *, const char *, zbx_config_fping_location, NULL)
 ZBX_GET_CONFIG_VAR2(char *, const char *, zbx_config_fping6_location, NULL)
+ZBX_GET_CONFIG_VAR(int, zbx_config_enable_native_icmp, 0)
 ZBX_GET_CONFIG_VAR2(char *, const char *, zbx_config_alert_scripts_path, NULL)
 ZBX_GET_CONFIG_VAR(int, zbx_config_timeout, 3)
 int	zbx_config_trapper_timeout = 300;
@@ -309,6 +311,8 @@ static char	*config_server		= NULL;		/* not used in zabbix_server, required for
 
 static int	config_housekeeping_frequency	= 1;
 static int	config_max_housekeeper_delete	= 5000;		/* applies for every separate field value */
+static int	config_housekeeping_partitions_ahead	= 0;
+static int	config_housekeeper_delete_workers	= 1;
 static int	config_confsyncer_frequency	= 10;
 
 static int	config_problemhousekeeping_frequency = 60;
@@ -320,6 +324,7 @@ static int	config_vmware_timeout		= 10;
 static zbx_uint64_t	config_conf_cache_size		= 32 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_cache_size	= 16 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_history_index_cache_size	= 4 * ZBX_MEBIBYTE;
+static int		config_history_cache_shards	= 1;
 static zbx_uint64_t	config_trends_cache_size	= 4 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_trend_func_cache_size	= 4 * ZBX_MEBIBYTE;
 static zbx_uint64_t	config_value_cache_size		= 8 * ZBX_MEBIBYTE;
@@ -345,6 +350,10 @@ static char	*config_ssh_key_location	= NULL;
 static int	config_proxyconfig_frequency	= 10;
 static int	config_proxydata_frequency	= 1;	/* 1s */
 
+/* zstd compression of requests to passive proxies, 0 - use zlib */
+static int	config_zstd_compression_level	= 0;
+static char	*config_zstd_dictionary		= NULL;
+
 static char	*CONFIG_LOAD_MODULE_PATH	= NULL;
 static char	**CONFIG_LOAD_MODULE	= NULL;
 
@@ -359,7 +368,7 @@ static char	*config_ssl_key_location = NULL;
 static char	*config_webdriver_url = NULL;
 
 static zbx_config_tls_t		*zbx_config_tls = NULL;
-static zbx_config_export_t	zbx_config_export = {NULL, NULL, ZBX_GIBIBYTE};
+static zbx_config_export_t	zbx_config_export = {NULL, NULL, ZBX_GIBIBYTE, 0, 16 * ZBX_MEBIBYTE, 0};
 static zbx_config_vault_t	zbx_config_vault = {NULL, NULL, NULL, NULL, NULL, NULL, NULL};
 
 static zbx_db_config_t		*zbx_db_config = NULL;
@@ -372,6 +381,8 @@ static char	*CONFIG_SOCKET_PATH	= NULL;
 static char	*config_history_storage_url		= NULL;
 static char	*config_history_storage_opts		= NULL;
 static int	config_history_storage_pipelines	= 0;
+static int	config_history_storage_streams		= 1;
+static int	config_history_storage_compression	= 0;
 static char	*config_stats_allowed_ip		= NULL;
 static int	config_tcp_max_backlog_size		= SOMAXCONN;
 static char	*zbx_config_webservice_url		= NULL;
@@ -763,6 +774,19 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (0 != zbx_config_export.compression && 0 == zbx_config_export.writer)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"ExportCompression\" configuration parameter requires \"ExportWriter\""
+				" to be enabled");
+		err = 1;
+	}
+#ifndef HAVE_ZLIB
+	err |= (FAIL == zbx_check_cfg_feature_int("ExportCompression", zbx_config_export.compression,
+			"zlib library"));
+	err |= (FAIL == zbx_check_cfg_feature_int("HistoryStorageCompression", config_history_storage_compression,
+			"zlib library"));
+#endif
+
 	if (NULL != CONFIG_NODE_ADDRESS &&
 			(FAIL == zbx_parse_serveractive_element(CONFIG_NODE_ADDRESS, &address, &port, 10051) ||
 			(FAIL == zbx_is_supported_ip(address) && FAIL == zbx_validate_hostname(address))))
@@ -784,6 +808,8 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 	err |= (FAIL == zbx_check_cfg_feature_str("HistoryStorageTypes", config_history_storage_opts, "cURL library"));
 	err |= (FAIL == zbx_check_cfg_feature_int("HistoryStorageDateIndex", config_history_storage_pipelines,
 			"cURL library"));
+	err |= (FAIL == zbx_check_cfg_feature_int("HistoryStorageCompression", config_history_storage_compression,
+			"cURL library"));
 	err |= (FAIL == zbx_check_cfg_feature_str("Vault", zbx_config_vault.name, "cURL library"));
 	err |= (FAIL == zbx_check_cfg_feature_str("VaultToken", zbx_config_vault.token, "cURL library"));
 	err |= (FAIL == zbx_check_cfg_feature_str("VaultDBPath", zbx_config_vault.db_path, "cURL library"));
@@ -916,6 +942,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&config_history_index_cache_size,	ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"HistoryCacheShards",		&config_history_cache_shards,		ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	1,			ZBX_HC_SHARDS_MAX},
 		{"TrendCacheSize",		&config_trends_cache_size,		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"TrendFunctionCacheSize",	&config_trend_func_cache_size,		ZBX_CFG_TYPE_UINT64,
@@ -928,12 +956,18 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	0,			24},
 		{"MaxHousekeeperDelete",	&config_max_housekeeper_delete,		ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	0,			1000000},
+		{"HousekeepingPartitionsAhead",	&config_housekeeping_partitions_ahead,	ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			365},
+		{"HousekeeperDeleteWorkers",	&config_housekeeper_delete_workers,	ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	1,			32},
 		{"TmpDir",			&zbx_config_tmpdir,			ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"FpingLocation",		&zbx_config_fping_location,		ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"Fping6Location",		&zbx_config_fping6_location,		ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
+		{"EnableNativeICMP",		&zbx_config_enable_native_icmp,		ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
 		{"Timeout",			&zbx_config_timeout,			ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	1,			30},
 		{"TrapperTimeout",		&zbx_config_trapper_timeout,		ZBX_CFG_TYPE_INT,
@@ -1024,6 +1058,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	1,			SEC_PER_WEEK},
 		{"ProxyDataFrequency",		&config_proxydata_frequency,		ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	1,			SEC_PER_HOUR},
+		{"ZstdCompressionLevel",	&config_zstd_compression_level,		ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			19},
+		{"ZstdDictionary",		&config_zstd_dictionary,		ZBX_CFG_TYPE_STRING,
+				ZBX_CONF_PARM_OPT,	0,			0},
 		{"LoadModulePath",		&CONFIG_LOAD_MODULE_PATH,		ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"LoadModule",			&CONFIG_LOAD_MODULE,			ZBX_CFG_TYPE_MULTISTRING,
@@ -1081,6 +1119,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 		{"HistoryStorageTypes",		&config_history_storage_opts,		ZBX_CFG_TYPE_STRING_LIST,
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"HistoryStorageDateIndex",	&config_history_storage_pipelines,	ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			2},
+		{"HistoryStorageBulkStreams",	&config_history_storage_streams,	ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	1,			32},
+		{"HistoryStorageCompression",	&config_history_storage_compression,	ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	0,			1},
 		{"ExportDir",			&(zbx_config_export.dir),		ZBX_CFG_TYPE_STRING,
 				ZBX_CONF_PARM_OPT,	0,			0},
@@ -1088,6 +1130,12 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 				ZBX_CONF_PARM_OPT,	0,			0},
 		{"ExportFileSize",		&(zbx_config_export.file_size),		ZBX_CFG_TYPE_UINT64,
 				ZBX_CONF_PARM_OPT,	ZBX_MEBIBYTE,		ZBX_GIBIBYTE},
+		{"ExportWriter",		&(zbx_config_export.writer),		ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
+		{"ExportQueueSize",		&(zbx_config_export.queue_size),	ZBX_CFG_TYPE_UINT64,
+				ZBX_CONF_PARM_OPT,	ZBX_MEBIBYTE,		ZBX_GIBIBYTE},
+		{"ExportCompression",		&(zbx_config_export.compression),	ZBX_CFG_TYPE_INT,
+				ZBX_CONF_PARM_OPT,	0,			1},
 		{"StartLLDProcessors",		&config_forks[ZBX_PROCESS_TYPE_LLDWORKER],
 											ZBX_CFG_TYPE_INT,
 				ZBX_CONF_PARM_OPT,	1,			100},
@@ -1276,7 +1324,8 @@ int	main(int argc, char **argv)
 		get_zbx_config_fping_location,
 		get_zbx_config_fping6_location,
 		get_zbx_config_tmpdir,
-		get_zbx_progname};
+		get_zbx_progname,
+		get_zbx_config_enable_native_icmp};
 
 	ZBX_TASK_EX			t = {ZBX_TASK_START, 0, 0, NULL};
 	char				ch;
@@ -1575,7 +1624,9 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 							zbx_config_tls->key_file, zbx_config_source_ip,
 							zbx_config_webservice_url};
 	zbx_thread_housekeeper_args	housekeeper_args = {&db_version_info, zbx_config_timeout,
-							config_housekeeping_frequency, config_max_housekeeper_delete};
+							config_housekeeping_frequency, config_max_housekeeper_delete,
+							config_housekeeping_partitions_ahead,
+							config_housekeeper_delete_workers};
 	zbx_thread_server_trigger_housekeeper_args	trigger_housekeeper_args = {zbx_config_timeout,
 							config_problemhousekeeping_frequency};
 	zbx_thread_taskmanager_args	taskmanager_args = {zbx_config_timeout, config_startup_time};
@@ -1617,7 +1668,8 @@ static int	server_startup(zbx_socket_t *listen_sock, int *ha_stat, int *ha_failo
 								config_service_manager_sync_frequency};
 
 	if (SUCCEED != zbx_init_database_cache(get_zbx_program_type, zbx_sync_server_history, config_history_cache_size,
-			config_history_index_cache_size, &config_trends_cache_size, &error))
+			config_history_index_cache_size, config_history_cache_shards, &config_trends_cache_size,
+			&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
@@ -2283,7 +2335,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 	}
 
 	if (SUCCEED != zbx_init_database_cache(get_zbx_program_type, zbx_sync_server_history, config_history_cache_size,
-			config_history_index_cache_size, &config_trends_cache_size, &error))
+			config_history_index_cache_size, config_history_cache_shards, &config_trends_cache_size,
+			&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize database cache: %s", error);
 		zbx_free(error);
@@ -2314,8 +2367,16 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		exit(EXIT_FAILURE);
 	}
 
+	if (SUCCEED != zbx_compress_init(config_zstd_compression_level, config_zstd_dictionary, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize compression: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	if (SUCCEED != zbx_history_init(config_history_storage_url, config_history_storage_opts,
-			zbx_db_config->log_slow_queries, &error))
+			zbx_db_config->log_slow_queries, config_history_storage_streams, config_history_storage_compression,
+			&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize history storage: %s", error);
 		zbx_free(error);
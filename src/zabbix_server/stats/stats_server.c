@@ -19,6 +19,8 @@
 
 #include "zbxcacheconfig.h"
 #include "zbxcachevalue.h"
+#include "zbxcachehistory.h"
+#include "zbxexport.h"
 #include "zbxtrends.h"
 #include "zbxconnector.h"
 #include "zbxjson.h"
@@ -40,6 +42,8 @@ void	zbx_server_stats_ext_get(struct zbx_json *json, const void *arg)
 	zbx_uint64_t			queue_size, connector_queue_size;
 	char				*value, *error = NULL;
 	zbx_tfc_stats_t			tcache_stats;
+	zbx_history_storage_stats_t	storage_stats;
+	zbx_export_stats_t		export_stats;
 
 	ZBX_UNUSED(arg);
 
@@ -87,11 +91,39 @@ void	zbx_server_stats_ext_get(struct zbx_json *json, const void *arg)
 		zbx_json_adduint64(json, "hits", vc_stats.hits);
 		zbx_json_adduint64(json, "misses", vc_stats.misses);
 		zbx_json_addint64(json, "mode", vc_stats.mode);
+		zbx_json_addfloat(json, "compression", vc_stats.compression_ratio);
 		zbx_json_close(json);
 
 		zbx_json_close(json);
 	}
 
+	/* zabbix[history_storage,<mode>] */
+	zbx_dc_get_history_storage_stats(&storage_stats);
+
+	zbx_json_addobject(json, "history_storage");
+	zbx_json_adduint64(json, "requests", storage_stats.requests);
+	zbx_json_adduint64(json, "documents", storage_stats.documents);
+	zbx_json_adduint64(json, "bytes", storage_stats.bytes);
+	zbx_json_adduint64(json, "retried", storage_stats.retried);
+	zbx_json_adduint64(json, "failed", storage_stats.failed);
+	zbx_json_addfloat(json, "latency", 0 != storage_stats.requests ?
+			storage_stats.time / (double)storage_stats.requests : 0);
+	zbx_json_close(json);
+
+	/* zabbix[export,<mode>] */
+	if (SUCCEED == zbx_export_get_stats(&export_stats))
+	{
+		zbx_json_addobject(json, "export");
+		zbx_json_adduint64(json, "written", export_stats.written_records);
+		zbx_json_adduint64(json, "bytes", export_stats.written_bytes);
+		zbx_json_adduint64(json, "dropped", export_stats.dropped_records);
+		zbx_json_adduint64(json, "dropped_bytes", export_stats.dropped_bytes);
+		zbx_json_adduint64(json, "waits", export_stats.waits);
+		zbx_json_addfloat(json, "wait_time", export_stats.wait_time);
+		zbx_json_adduint64(json, "queue", export_stats.queued_bytes);
+		zbx_json_close(json);
+	}
+
 	/* zabbix[tcache,cache,<parameters>] */
 	if (SUCCEED == zbx_tfc_get_stats(&tcache_stats, NULL))
 	{
@@ -110,6 +142,8 @@ void	zbx_server_stats_ext_get(struct zbx_json *json, const void *arg)
 		zbx_json_adduint64(json, "items", tcache_stats.items_num);
 		zbx_json_adduint64(json, "requests", tcache_stats.requests_num);
 		zbx_json_addfloat(json, "pitems", (0 == total ? 0 : (double)tcache_stats.items_num / total * 100));
+		zbx_json_adduint64(json, "rollups", tcache_stats.rollups_num);
+		zbx_json_adduint64(json, "rollup_hits", tcache_stats.rollup_hits);
 
 		zbx_json_close(json);
 	}
@@ -18,6 +18,7 @@
 #include "../events/events.h"
 #include "../actions/actions.h"
 #include "../audit/audit_server.h"
+#include "../lld/lld_protocol.h"
 
 #include "zbxtimekeeper.h"
 #include "zbxnix.h"
@@ -734,6 +735,9 @@ static int	tm_process_check_now(zbx_vector_uint64_t *taskids)
 		proxyids = (zbx_uint64_t *)zbx_malloc(NULL, tasks.values_num * sizeof(zbx_uint64_t));
 		zbx_dc_reschedule_items(&itemids, time(NULL), proxyids);
 
+		/* discovery rules checked on demand must not skip unchanged values */
+		zbx_lld_reset_fingerprints(&itemids);
+
 		sql_offset = 0;
 
 		for (int i = 0; i < tasks.values_num; i++)
@@ -51,6 +51,13 @@ int	zbx_send_proxy_data_response(const zbx_dc_proxy_t *proxy, zbx_socket_t *sock
 			break;
 	}
 
+	/* let proxy know that columnar history data batches are accepted */
+	zbx_json_addstring(&json, ZBX_PROTO_TAG_HISTORY_FORMAT, ZBX_PROTO_VALUE_HISTORY_FORMAT_COLUMNS,
+			ZBX_JSON_TYPE_STRING);
+
+	/* let proxy know that zstd compressed data is accepted */
+	zbx_tcp_zstd_advertise(&json);
+
 	if (SUCCEED == status)
 	{
 		zbx_json_addstring(&json, ZBX_PROTO_TAG_RESPONSE, ZBX_PROTO_VALUE_SUCCESS, ZBX_JSON_TYPE_STRING);
@@ -65,7 +72,7 @@ int	zbx_send_proxy_data_response(const zbx_dc_proxy_t *proxy, zbx_socket_t *sock
 	if (0 != tasks.values_num)
 		zbx_tm_json_serialize_tasks(&json, &tasks);
 
-	flags |= ZBX_TCP_COMPRESS;
+	flags |= ZBX_TCP_COMPRESS | (sock->protocol & ZBX_TCP_COMPRESS_ZSTD);
 
 	if (SUCCEED == (ret = zbx_tcp_send_ext(sock, json.buffer, strlen(json.buffer), 0, flags, config_timeout)))
 	{
@@ -96,6 +103,9 @@ static int	proxy_data_no_history(const struct zbx_json_parse *jp)
 	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data))
 		return FAIL;
 
+	if (NULL != zbx_json_pair_by_name(jp, ZBX_PROTO_TAG_HISTORY_COLUMNS))
+		return FAIL;
+
 	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_DISCOVERY_DATA, &jp_data))
 		return FAIL;
 
@@ -205,8 +215,7 @@ out:
 	{
 		int	flags = ZBX_TCP_PROTOCOL;
 
-		if (0 != (sock->protocol & ZBX_TCP_COMPRESS))
-			flags |= ZBX_TCP_COMPRESS;
+		flags |= (sock->protocol & ZBX_TCP_COMPRESS_FLAGS);
 
 		zbx_send_response_ext(sock, ret, error, NULL, flags, config_timeout);
 	}
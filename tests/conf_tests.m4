@@ -51,6 +51,7 @@ AC_DEFUN([CONF_TESTS],
 			tests/Makefile
 			tests/libs/Makefile
 			tests/libs/zbxalgo/Makefile
+			tests/libs/zbxagentget/Makefile
 			tests/libs/zbxcommon/Makefile
 			tests/test_zbxcommon/Makefile
 			tests/libs/zbxcomms/Makefile
@@ -60,6 +61,7 @@ AC_DEFUN([CONF_TESTS],
 			tests/libs/zbxcacheconfig/Makefile
 			tests/libs/zbxdb/Makefile
 			tests/libs/zbxdbhigh/Makefile
+			tests/libs/zbxdbwrap/Makefile
 			tests/libs/zbxeval/Makefile
 			tests/libs/zbxexpr/Makefile
 			tests/libs/zbxfile/Makefile
@@ -71,6 +73,7 @@ AC_DEFUN([CONF_TESTS],
 			tests/libs/zbxpoller/Makefile
 			tests/libs/zbxparam/Makefile
 			tests/libs/zbxpreproc/Makefile
+			tests/libs/zbxproxybuffer/Makefile
 			tests/libs/zbxprometheus/Makefile
 			tests/libs/zbxregexp/Makefile
 			tests/libs/zbxexpression/Makefile
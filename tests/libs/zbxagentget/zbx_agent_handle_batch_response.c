@@ -0,0 +1,126 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxagentget.h"
+
+static void	mock_check_result(int index, zbx_mock_handle_t hresult, const AGENT_RESULT *result, int errcode,
+		unsigned char deferred)
+{
+	zbx_mock_handle_t	hmember;
+	const char		*str;
+	char			prefix[64];
+
+	zbx_snprintf(prefix, sizeof(prefix), "result #%d", index + 1);
+
+	zbx_mock_assert_int_eq(prefix, zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hresult,
+			"errcode")), errcode);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hresult, "deferred", &hmember))
+		zbx_mock_assert_int_eq(prefix, zbx_mock_get_object_member_int(hresult, "deferred"), deferred);
+	else
+		zbx_mock_assert_int_eq(prefix, 0, deferred);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hresult, "value", &hmember))
+	{
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hmember, &str))
+			fail_msg("invalid expected value");
+
+		if (0 == ZBX_ISSET_TEXT(result))
+			fail_msg("%s: expected value \"%s\" while got none", prefix, str);
+
+		zbx_mock_assert_str_eq(prefix, str, result->text);
+	}
+	else if (0 != ZBX_ISSET_TEXT(result))
+		fail_msg("%s: expected no value while got \"%s\"", prefix, result->text);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hresult, "error", &hmember))
+	{
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hmember, &str))
+			fail_msg("invalid expected error");
+
+		if (0 == ZBX_ISSET_MSG(result))
+			fail_msg("%s: expected error \"%s\" while got none", prefix, str);
+
+		zbx_mock_assert_str_eq(prefix, str, result->msg);
+	}
+	else if (0 != ZBX_ISSET_MSG(result))
+		fail_msg("%s: expected no error while got \"%s\"", prefix, result->msg);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	AGENT_RESULT		*results, **presults;
+	zbx_mock_handle_t	hresults, hresult;
+	int			*errcodes, num, version, ret, i;
+	unsigned char		*deferred, capabilities;
+	char			*buffer;
+
+	ZBX_UNUSED(state);
+
+	num = zbx_mock_get_parameter_int("in.num");
+	buffer = zbx_strdup(NULL, zbx_mock_get_parameter_string("in.response"));
+	version = zbx_get_agent_protocol_version_int(zbx_mock_get_parameter_string("in.version"));
+
+	results = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT) * (size_t)num);
+	presults = (AGENT_RESULT **)zbx_malloc(NULL, sizeof(AGENT_RESULT *) * (size_t)num);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+	deferred = (unsigned char *)zbx_malloc(NULL, sizeof(unsigned char) * (size_t)num);
+
+	for (i = 0; i < num; i++)
+	{
+		zbx_init_agent_result(&results[i]);
+		presults[i] = &results[i];
+		errcodes[i] = SUCCEED;
+		deferred[i] = 1;
+	}
+
+	ret = zbx_agent_handle_batch_response(buffer, (ssize_t)strlen(buffer), "127.0.0.1", presults, errcodes,
+			deferred, num, &version, &capabilities);
+
+	zbx_mock_assert_result_eq("zbx_agent_handle_batch_response()",
+			zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return")), ret);
+	zbx_mock_assert_int_eq("protocol version",
+			zbx_get_agent_protocol_version_int(zbx_mock_get_parameter_string("out.version")), version);
+	zbx_mock_assert_int_eq("capabilities", zbx_mock_get_parameter_int("out.capabilities"), capabilities);
+
+	if (FAIL != ret)
+	{
+		hresults = zbx_mock_get_parameter_handle("out.results");
+
+		for (i = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hresults, &hresult); i++)
+		{
+			if (i >= num)
+				fail_msg("there are more expected results than requested keys");
+
+			mock_check_result(i, hresult, &results[i], errcodes[i], deferred[i]);
+		}
+
+		if (i != num)
+			fail_msg("expected %d results while %d keys were requested", i, num);
+	}
+
+	for (i = 0; i < num; i++)
+		zbx_free_agent_result(&results[i]);
+
+	zbx_free(deferred);
+	zbx_free(errcodes);
+	zbx_free(presults);
+	zbx_free(results);
+	zbx_free(buffer);
+}
@@ -25,9 +25,10 @@ void	zbx_vc_set_mode(int mode)
 
 int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values)
 {
-	zbx_vc_item_t	*item;
-	int		i;
-	zbx_vc_chunk_t	*chunk;
+	zbx_vc_item_t		*item;
+	int			i;
+	zbx_vc_chunk_t		*chunk;
+	zbx_vc_unpack_buf_t	buf = {NULL, NULL, 0};
 
 	if (NULL == (item = zbx_hashset_search(&vc_cache->items, &itemid)))
 		return FAIL;
@@ -37,10 +38,14 @@ int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_
 
 	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
 	{
+		const zbx_history_record_t	*slots = vch_chunk_get_slots(item, chunk, &buf);
+
 		for (i = chunk->first_value; i <= chunk->last_value; i++)
-			vc_history_record_vector_append(values, value_type, &chunk->slots[i]);
+			vc_history_record_vector_append(values, value_type, &slots[i]);
 	}
 
+	zbx_free(buf.values);
+
 	return SUCCEED;
 }
 
@@ -0,0 +1,218 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxdbwrap/history_columns.c"
+
+static int	mock_get_optional_int(zbx_mock_handle_t hrow, const char *name, int default_value)
+{
+	zbx_mock_handle_t	hmember;
+	const char		*str;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hrow, name, &hmember))
+		return default_value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_string(hmember, &str))
+		fail_msg("invalid row member '%s'", name);
+
+	return atoi(str);
+}
+
+static const char	*mock_get_optional_string(zbx_mock_handle_t hrow, const char *name)
+{
+	zbx_mock_handle_t	hmember;
+	const char		*str;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hrow, name, &hmember))
+		return NULL;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_string(hmember, &str))
+		fail_msg("invalid row member '%s'", name);
+
+	return str;
+}
+
+static void	mock_read_row(zbx_mock_handle_t hrow, zbx_uint64_t *itemid, zbx_agent_value_t *value)
+{
+	zbx_mock_handle_t	hmember;
+
+	memset(value, 0, sizeof(zbx_agent_value_t));
+
+	*itemid = zbx_mock_get_object_member_uint64(hrow, "itemid");
+	value->id = zbx_mock_get_object_member_uint64(hrow, "id");
+	value->ts.sec = zbx_mock_get_object_member_int(hrow, "clock");
+	value->ts.ns = mock_get_optional_int(hrow, "ns", 0);
+	value->state = (unsigned char)mock_get_optional_int(hrow, "state", ITEM_STATE_NORMAL);
+	value->value = (char *)mock_get_optional_string(hrow, "value");
+	value->source = (char *)mock_get_optional_string(hrow, "source");
+	value->timestamp = mock_get_optional_int(hrow, "timestamp", 0);
+	value->severity = mock_get_optional_int(hrow, "severity", 0);
+	value->logeventid = mock_get_optional_int(hrow, "logeventid", 0);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hrow, "lastlogsize", &hmember))
+	{
+		value->meta = 1;
+		value->lastlogsize = zbx_mock_get_object_member_uint64(hrow, "lastlogsize");
+		value->mtime = mock_get_optional_int(hrow, "mtime", 0);
+	}
+}
+
+static char	*mock_encode_rows(void)
+{
+	zbx_mock_handle_t	hrows, hrow;
+	zbx_history_columns_t	*columns;
+	struct zbx_json		j;
+	struct zbx_json_parse	jp;
+	char			*data = NULL;
+	size_t			data_alloc = 0;
+
+	columns = zbx_history_columns_create();
+	hrows = zbx_mock_get_parameter_handle("in.rows");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrows, &hrow))
+	{
+		zbx_uint64_t		itemid;
+		zbx_agent_value_t	value;
+
+		mock_read_row(hrow, &itemid, &value);
+		zbx_history_columns_append(columns, itemid, &value);
+	}
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_history_columns_export(columns, "columns", &j);
+	zbx_history_columns_free(columns);
+
+	if (SUCCEED != zbx_json_open(j.buffer, &jp) ||
+			SUCCEED != zbx_json_value_by_name_dyn(&jp, "columns", &data, &data_alloc, NULL))
+	{
+		fail_msg("cannot export columnar history data");
+	}
+
+	zbx_json_free(&j);
+
+	return data;
+}
+
+static char	*mock_encode_data(void)
+{
+	const char	*raw;
+	char		*data = NULL;
+	size_t		raw_len;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_binary(zbx_mock_get_parameter_handle("in.data"), &raw, &raw_len))
+		fail_msg("invalid binary data");
+
+	if (0 == raw_len)
+		return zbx_strdup(NULL, "");
+
+	zbx_base64_encode_dyn(raw, &data, (int)raw_len);
+
+	return data;
+}
+
+static void	mock_compare_row(int index, zbx_mock_handle_t hrow, zbx_uint64_t itemid, const zbx_agent_value_t *value)
+{
+	zbx_uint64_t		itemid_exp;
+	zbx_agent_value_t	exp;
+	char			prefix[64];
+
+	mock_read_row(hrow, &itemid_exp, &exp);
+	zbx_snprintf(prefix, sizeof(prefix), "row #%d", index + 1);
+
+	zbx_mock_assert_uint64_eq(prefix, itemid_exp, itemid);
+	zbx_mock_assert_uint64_eq(prefix, exp.id, value->id);
+	zbx_mock_assert_int_eq(prefix, exp.ts.sec, value->ts.sec);
+	zbx_mock_assert_int_eq(prefix, exp.ts.ns, value->ts.ns);
+	zbx_mock_assert_int_eq(prefix, exp.state, value->state);
+
+	if (NULL == exp.value)
+		zbx_mock_assert_ptr_eq(prefix, NULL, value->value);
+	else
+		zbx_mock_assert_str_eq(prefix, exp.value, value->value);
+
+	if (NULL == exp.source)
+		zbx_mock_assert_ptr_eq(prefix, NULL, value->source);
+	else
+		zbx_mock_assert_str_eq(prefix, exp.source, value->source);
+
+	zbx_mock_assert_int_eq(prefix, exp.timestamp, value->timestamp);
+	zbx_mock_assert_int_eq(prefix, exp.severity, value->severity);
+	zbx_mock_assert_int_eq(prefix, exp.logeventid, value->logeventid);
+	zbx_mock_assert_int_eq(prefix, exp.meta, value->meta);
+	zbx_mock_assert_uint64_eq(prefix, exp.lastlogsize, value->lastlogsize);
+	zbx_mock_assert_int_eq(prefix, exp.mtime, value->mtime);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_history_columns_reader_t	reader;
+	zbx_mock_handle_t		hrows, hrow;
+	char				*data, *error = NULL;
+	const char			*error_exp;
+	int				ret, i;
+
+	ZBX_UNUSED(state);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.rows"))
+		data = mock_encode_rows();
+	else
+		data = mock_encode_data();
+
+	ret = history_columns_reader_open(&reader, data, &error);
+	zbx_free(data);
+
+	zbx_mock_assert_result_eq("history_columns_reader_open()",
+			zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.open")), ret);
+
+	if (SUCCEED == ret)
+	{
+		hrows = zbx_mock_get_parameter_handle("out.rows");
+
+		for (i = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrows, &hrow); i++)
+		{
+			zbx_uint64_t		itemid;
+			zbx_agent_value_t	value;
+
+			if (SUCCEED != history_columns_reader_next(&reader, &itemid, &value, &error))
+				fail_msg("cannot read row #%d: %s", i + 1, ZBX_NULL2EMPTY_STR(error));
+
+			mock_compare_row(i, hrow, itemid, &value);
+			zbx_free(value.value);
+			zbx_free(value.source);
+		}
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("out.error"))
+		{
+			zbx_uint64_t		itemid;
+			zbx_agent_value_t	value;
+
+			zbx_mock_assert_result_eq("history_columns_reader_next()", FAIL,
+					history_columns_reader_next(&reader, &itemid, &value, &error));
+		}
+
+		zbx_mock_assert_uint64_eq("rows left", 0, reader.rows_left);
+		history_columns_reader_close(&reader);
+	}
+
+	if (NULL != (error_exp = zbx_mock_get_optional_parameter_string("out.error")))
+		zbx_mock_assert_str_eq("error message", error_exp, error);
+	else
+		zbx_mock_assert_ptr_eq("error message", NULL, error);
+
+	zbx_free(error);
+}
@@ -0,0 +1,188 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxicmpping/icmpping_native.c"
+
+static void	mock_resolve(const char *addr, struct sockaddr_storage *sa, socklen_t *sa_len)
+{
+	if (SUCCEED != icmp_addr_resolve(addr, AF_UNSPEC, AI_NUMERICHOST, sa, sa_len))
+		fail_msg("invalid address \"%s\"", addr);
+}
+
+static void	test_icmp_rtt_round(void)
+{
+	zbx_mock_assert_double_eq("icmp_rtt_round()", zbx_mock_get_parameter_float("out.rtt"),
+			icmp_rtt_round(zbx_mock_get_parameter_float("in.rtt")));
+}
+
+static void	test_icmp_checksum(void)
+{
+	const char	*data, *checksum;
+	size_t		data_len, checksum_len;
+	unsigned short	ret;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_binary(zbx_mock_get_parameter_handle("in.data"), &data, &data_len))
+		fail_msg("invalid input data");
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_binary(zbx_mock_get_parameter_handle("out.checksum"), &checksum,
+			&checksum_len) || sizeof(ret) != checksum_len)
+	{
+		fail_msg("invalid expected checksum");
+	}
+
+	/* checksum is returned in network byte order, compare it as it would be written to packet */
+	ret = icmp_checksum((const unsigned char *)data, data_len);
+
+	if (0 != memcmp(checksum, &ret, sizeof(ret)))
+	{
+		fail_msg("expected checksum 0x%02x%02x while got 0x%02x%02x", (unsigned char)checksum[0],
+				(unsigned char)checksum[1], ((unsigned char *)&ret)[0], ((unsigned char *)&ret)[1]);
+	}
+}
+
+static void	test_icmp_reply_process(void)
+{
+	zbx_icmp_engine_t	engine;
+	zbx_icmp_target_t	target;
+	zbx_fping_host_t	host;
+	zbx_icmp_socket_t	*sock;
+	zbx_mock_handle_t	hrequests, hrequest, hreplies, hreply, hresponses, hresponse;
+	const char		*str;
+	double			now;
+	int			i, requests_num = 0;
+
+	memset(&engine, 0, sizeof(engine));
+	memset(&host, 0, sizeof(host));
+	memset(&target, 0, sizeof(target));
+
+	host.addr = (char *)zbx_mock_get_parameter_string("in.target");
+	target.host = &host;
+	mock_resolve(host.addr, &target.addr, &target.addr_len);
+#ifndef HAVE_IPV6
+	if (AF_INET != target.addr.ss_family)
+		return;
+#endif
+
+	engine.targets = &target;
+	engine.targets_num = 1;
+	engine.timeout = zbx_mock_get_parameter_uint64("in.timeout") / 1000.0;
+	engine.allow_redirect = (unsigned char)zbx_mock_get_parameter_uint64("in.allow_redirect");
+	engine.ident = (unsigned short)zbx_mock_get_parameter_uint64("in.ident");
+	engine.slots_num = (int)zbx_mock_get_parameter_uint64("in.slots_num");
+	engine.slots = (zbx_icmp_slot_t *)zbx_malloc(NULL, sizeof(zbx_icmp_slot_t) * (size_t)engine.slots_num);
+
+	for (i = 0; i < engine.slots_num; i++)
+		engine.slots[i].target = -1;
+
+	sock = AF_INET == target.addr.ss_family ? &engine.sock4 : &engine.sock6;
+	str = zbx_mock_get_parameter_string("in.socket");
+
+	if (0 == strcmp(str, "raw"))
+		sock->type = SOCK_RAW;
+	else if (0 == strcmp(str, "dgram"))
+		sock->type = SOCK_DGRAM;
+	else
+		fail_msg("unknown socket type '%s'", str);
+
+	/* requests are sent to the target at the specified number of milliseconds ago */
+	hrequests = zbx_mock_get_parameter_handle("in.requests");
+	now = zbx_time();
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrequests, &hrequest))
+	{
+		zbx_icmp_slot_t	*slot;
+		int		seq = zbx_mock_get_object_member_int(hrequest, "seq");
+
+		if (seq >= engine.slots_num)
+			fail_msg("sequence number %d is out of slot range", seq);
+
+		slot = &engine.slots[seq];
+		slot->target = 0;
+		slot->request = requests_num++;
+		slot->sent = now - zbx_mock_get_object_member_int(hrequest, "age") / 1000.0;
+		engine.pending++;
+	}
+
+	target.rtt = (double *)zbx_malloc(NULL, sizeof(double) * (size_t)MAX(requests_num, 1));
+
+	for (i = 0; i < requests_num; i++)
+		target.rtt[i] = -1;
+
+	hreplies = zbx_mock_get_parameter_handle("in.replies");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hreplies, &hreply))
+	{
+		struct sockaddr_storage	from;
+		socklen_t		from_len;
+		const char		*packet;
+		size_t			packet_len;
+
+		mock_resolve(zbx_mock_get_object_member_string(hreply, "from"), &from, &from_len);
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_binary(zbx_mock_get_object_member_handle(hreply, "packet"), &packet,
+				&packet_len))
+		{
+			fail_msg("invalid reply packet");
+		}
+
+		icmp_reply_process(&engine, sock, (const unsigned char *)packet, packet_len, &from);
+	}
+
+	hresponses = zbx_mock_get_parameter_handle("out.responses");
+
+	for (i = 0; ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hresponses, &hresponse); i++)
+	{
+		zbx_uint64_t	responded;
+
+		if (i >= requests_num)
+			fail_msg("there are more expected responses than requests");
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hresponse, &responded))
+			fail_msg("invalid expected response");
+
+		zbx_mock_assert_int_eq("request responded", (int)responded, 0 <= target.rtt[i] ? 1 : 0);
+	}
+
+	if (i != requests_num)
+		fail_msg("expected %d responses while there are %d requests", i, requests_num);
+
+	zbx_mock_assert_int_eq("pending requests", (int)zbx_mock_get_parameter_uint64("out.pending"),
+			engine.pending);
+
+	zbx_free(target.rtt);
+	zbx_free(engine.slots);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char	*test_type;
+
+	ZBX_UNUSED(state);
+
+	test_type = zbx_mock_get_parameter_string("in.test_type");
+
+	if (0 == strcmp("icmp_rtt_round", test_type))
+		test_icmp_rtt_round();
+	else if (0 == strcmp("icmp_checksum", test_type))
+		test_icmp_checksum();
+	else if (0 == strcmp("icmp_reply_process", test_type))
+		test_icmp_reply_process();
+	else
+		fail_msg("This should never happen: undefined test type.");
+}
@@ -0,0 +1,187 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxpreproc.h"
+#include "zbxpreprocbase.h"
+#include "libs/zbxpreproc/pp_execute.h"
+
+static int	str_to_preproc_type(const char *str)
+{
+	if (0 == strcmp(str, "ZBX_PREPROC_MULTIPLIER"))
+		return ZBX_PREPROC_MULTIPLIER;
+	if (0 == strcmp(str, "ZBX_PREPROC_DELTA_VALUE"))
+		return ZBX_PREPROC_DELTA_VALUE;
+	if (0 == strcmp(str, "ZBX_PREPROC_DELTA_SPEED"))
+		return ZBX_PREPROC_DELTA_SPEED;
+	if (0 == strcmp(str, "ZBX_PREPROC_JSONPATH"))
+		return ZBX_PREPROC_JSONPATH;
+	if (0 == strcmp(str, "ZBX_PREPROC_RTRIM"))
+		return ZBX_PREPROC_RTRIM;
+
+	fail_msg("unknown preprocessing step type: %s", str);
+	return FAIL;
+}
+
+static int	str_to_preproc_error_handler(const char *str)
+{
+	if (0 == strcmp(str, "ZBX_PREPROC_FAIL_DEFAULT"))
+		return ZBX_PREPROC_FAIL_DEFAULT;
+	if (0 == strcmp(str, "ZBX_PREPROC_FAIL_DISCARD_VALUE"))
+		return ZBX_PREPROC_FAIL_DISCARD_VALUE;
+	if (0 == strcmp(str, "ZBX_PREPROC_FAIL_SET_VALUE"))
+		return ZBX_PREPROC_FAIL_SET_VALUE;
+	if (0 == strcmp(str, "ZBX_PREPROC_FAIL_SET_ERROR"))
+		return ZBX_PREPROC_FAIL_SET_ERROR;
+
+	fail_msg("unknown preprocessing error handler: %s", str);
+	return FAIL;
+}
+
+static zbx_pp_item_preproc_t	*read_preproc(void)
+{
+	zbx_pp_item_preproc_t	*preproc;
+	zbx_mock_handle_t	hsteps, hstep, hmember;
+	unsigned char		value_type;
+	int			steps_num = 0;
+
+	value_type = zbx_mock_str_to_value_type(zbx_mock_get_parameter_string("in.value_type"));
+	preproc = zbx_pp_item_preproc_create(0, ITEM_TYPE_TRAPPER, value_type, 0);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+	{
+		zbx_pp_step_t	*step;
+
+		preproc->steps = (zbx_pp_step_t *)zbx_realloc(preproc->steps, sizeof(zbx_pp_step_t) *
+				(size_t)(steps_num + 1));
+		step = preproc->steps + steps_num++;
+
+		step->type = str_to_preproc_type(zbx_mock_get_object_member_string(hstep, "type"));
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "params", &hmember))
+			step->params = zbx_strdup(NULL, zbx_mock_get_object_member_string(hstep, "params"));
+		else
+			step->params = zbx_strdup(NULL, "");
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "error_handler", &hmember))
+		{
+			step->error_handler = str_to_preproc_error_handler(
+					zbx_mock_get_object_member_string(hstep, "error_handler"));
+		}
+		else
+			step->error_handler = ZBX_PREPROC_FAIL_DEFAULT;
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "error_handler_params", &hmember))
+		{
+			step->error_handler_params = zbx_strdup(NULL, zbx_mock_get_object_member_string(hstep,
+					"error_handler_params"));
+		}
+		else
+			step->error_handler_params = zbx_strdup(NULL, "");
+
+		if (SUCCEED == zbx_pp_preproc_has_history(step->type))
+			preproc->history_num++;
+	}
+
+	preproc->steps_num = steps_num;
+
+	if (0 != preproc->history_num)
+		preproc->history_cache = zbx_pp_history_cache_create();
+
+	return preproc;
+}
+
+static void	check_result(zbx_mock_handle_t hresult, const zbx_variant_t *value)
+{
+	zbx_mock_handle_t	hmember;
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hresult, "error", &hmember))
+	{
+		const char	*error = zbx_mock_get_object_member_string(hresult, "error");
+
+		zbx_mock_assert_int_eq("result variant type", ZBX_VARIANT_ERR, value->type);
+
+		if (NULL == strstr(value->data.err, error))
+			fail_msg("error \"%s\" does not contain \"%s\"", value->data.err, error);
+
+		return;
+	}
+
+	zbx_mock_assert_int_eq("result variant type",
+			zbx_mock_str_to_variant(zbx_mock_get_object_member_string(hresult, "variant")), value->type);
+
+	if (ZBX_VARIANT_NONE != value->type)
+	{
+		zbx_mock_assert_str_eq("result value", zbx_mock_get_object_member_string(hresult, "data"),
+				zbx_variant_value_desc(value));
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_pp_item_preproc_t	*preproc, *preproc_compiled;
+	zbx_pp_context_t	ctx;
+	zbx_mock_handle_t	hvalues, hvalue, hresults, hresult;
+
+	ZBX_UNUSED(state);
+
+	pp_context_init(&ctx);
+
+	preproc = read_preproc();
+	preproc_compiled = read_preproc();
+	pp_pipeline_compile(preproc_compiled);
+
+	hvalues = zbx_mock_get_parameter_handle("in.values");
+	hresults = zbx_mock_get_parameter_handle("out.results");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		zbx_variant_t	value_in, value_out, value_out_compiled;
+		zbx_timespec_t	ts;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_vector_element(hresults, &hresult))
+			fail_msg("missing expected result");
+
+		if (ZBX_MOCK_SUCCESS != zbx_strtime_to_timespec(zbx_mock_get_object_member_string(hvalue, "time"), &ts))
+			fail_msg("Invalid 'time' format");
+
+		zbx_variant_set_str(&value_in, zbx_strdup(NULL, zbx_mock_get_object_member_string(hvalue, "data")));
+
+		pp_execute(&ctx, preproc, NULL, NULL, &value_in, ts, NULL, &value_out, NULL, NULL);
+		pp_execute(&ctx, preproc_compiled, NULL, NULL, &value_in, ts, NULL, &value_out_compiled, NULL, NULL);
+
+		/* compiled pipeline must produce exactly the same results as step by step execution */
+		zbx_mock_assert_int_eq("compiled result variant type", value_out.type, value_out_compiled.type);
+		zbx_mock_assert_str_eq("compiled result value", zbx_variant_value_desc(&value_out),
+				zbx_variant_value_desc(&value_out_compiled));
+
+		check_result(hresult, &value_out_compiled);
+
+		zbx_variant_clear(&value_out_compiled);
+		zbx_variant_clear(&value_out);
+		zbx_variant_clear(&value_in);
+	}
+
+	zbx_pp_item_preproc_release(preproc_compiled);
+	zbx_pp_item_preproc_release(preproc);
+
+	pp_context_destroy(&ctx);
+}
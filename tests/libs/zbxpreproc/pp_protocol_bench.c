@@ -0,0 +1,481 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxtime.h"
+#include "zbxserialize.h"
+#include "zbx_item_constants.h"
+#include "libs/zbxpreproc/pp_protocol.h"
+
+/* Preprocessing value request encoding microbenchmark.                               */
+/*                                                                                    */
+/* Compares the compact batch encoding of item values sent to preprocessing manager   */
+/* with the previous encoding, where every value was packed with fixed size fields    */
+/* and all agent result fields. Values are generated for items_num items of the same  */
+/* host in round robin order with timestamps increasing by one second per round, the  */
+/* same way pollers produce them. Decoded values are checked against source values.   */
+
+#define PP_BENCH_VALUE_UINT64	0
+#define PP_BENCH_VALUE_DOUBLE	1
+#define PP_BENCH_VALUE_TEXT	2
+#define PP_BENCH_VALUE_LOG	3
+
+typedef struct
+{
+	int	values_num;
+	int	batch_size;
+	int	items_num;
+	int	rounds;
+	int	value_kind;
+
+	zbx_preproc_item_value_t	*values;
+	zbx_timespec_t			*ts;
+	AGENT_RESULT			*results;
+}
+pp_bench_t;
+
+typedef struct
+{
+	zbx_uint64_t	size;
+	double		encode_sec;
+	double		decode_sec;
+}
+pp_bench_result_t;
+
+static int	pp_bench_value_kind(const char *kind)
+{
+	if (0 == strcmp(kind, "uint64"))
+		return PP_BENCH_VALUE_UINT64;
+	if (0 == strcmp(kind, "double"))
+		return PP_BENCH_VALUE_DOUBLE;
+	if (0 == strcmp(kind, "text"))
+		return PP_BENCH_VALUE_TEXT;
+	if (0 == strcmp(kind, "log"))
+		return PP_BENCH_VALUE_LOG;
+
+	fail_msg("unknown value kind: %s", kind);
+
+	return FAIL;
+}
+
+static void	pp_bench_values_create(pp_bench_t *bench)
+{
+	bench->values = (zbx_preproc_item_value_t *)zbx_calloc(NULL, (size_t)bench->values_num,
+			sizeof(zbx_preproc_item_value_t));
+	bench->ts = (zbx_timespec_t *)zbx_calloc(NULL, (size_t)bench->values_num, sizeof(zbx_timespec_t));
+	bench->results = (AGENT_RESULT *)zbx_calloc(NULL, (size_t)bench->values_num, sizeof(AGENT_RESULT));
+
+	for (int i = 0; i < bench->values_num; i++)
+	{
+		zbx_preproc_item_value_t	*value = &bench->values[i];
+		AGENT_RESULT			*result = &bench->results[i];
+		int				item = i % bench->items_num;
+
+		value->itemid = 100000 + (zbx_uint64_t)item * 3;
+		value->hostid = 10084;
+		value->item_flags = ZBX_FLAG_DISCOVERY_NORMAL;
+		value->state = ITEM_STATE_NORMAL;
+
+		bench->ts[i].sec = 1700000000 + i / bench->items_num;
+		bench->ts[i].ns = (i * 7919) % 1000000000;
+		value->ts = &bench->ts[i];
+		value->result = result;
+
+		zbx_init_agent_result(result);
+
+		switch (bench->value_kind)
+		{
+			case PP_BENCH_VALUE_UINT64:
+				value->item_value_type = ITEM_VALUE_TYPE_UINT64;
+				SET_UI64_RESULT(result, (zbx_uint64_t)(i * 31) % 100000);
+				break;
+			case PP_BENCH_VALUE_DOUBLE:
+				value->item_value_type = ITEM_VALUE_TYPE_FLOAT;
+				SET_DBL_RESULT(result, (double)i / 7);
+				break;
+			case PP_BENCH_VALUE_TEXT:
+				value->item_value_type = ITEM_VALUE_TYPE_TEXT;
+				SET_TEXT_RESULT(result, zbx_dsprintf(NULL, "value of item %d at round %d", item,
+						i / bench->items_num));
+				break;
+			case PP_BENCH_VALUE_LOG:
+				value->item_value_type = ITEM_VALUE_TYPE_LOG;
+				result->log = (zbx_log_t *)zbx_malloc(NULL, sizeof(zbx_log_t));
+				result->log->value = zbx_dsprintf(NULL, "log line %d", i);
+				result->log->source = zbx_strdup(NULL, "application");
+				result->log->timestamp = bench->ts[i].sec;
+				result->log->severity = i % 5;
+				result->log->logeventid = i;
+				result->type |= AR_LOG;
+				result->lastlogsize = (zbx_uint64_t)i * 80;
+				result->mtime = bench->ts[i].sec;
+				result->type |= AR_META;
+				break;
+		}
+	}
+}
+
+static void	pp_bench_values_free(pp_bench_t *bench)
+{
+	for (int i = 0; i < bench->values_num; i++)
+		zbx_free_agent_result(&bench->results[i]);
+
+	zbx_free(bench->results);
+	zbx_free(bench->ts);
+	zbx_free(bench->values);
+}
+
+static void	pp_bench_value_compare(const zbx_preproc_item_value_t *src, const zbx_preproc_item_value_t *dst)
+{
+	zbx_mock_assert_uint64_eq("itemid", src->itemid, dst->itemid);
+	zbx_mock_assert_uint64_eq("hostid", src->hostid, dst->hostid);
+	zbx_mock_assert_int_eq("value type", src->item_value_type, dst->item_value_type);
+	zbx_mock_assert_int_eq("item flags", src->item_flags, dst->item_flags);
+	zbx_mock_assert_int_eq("state", src->state, dst->state);
+	zbx_mock_assert_ptr_ne("timestamp", NULL, dst->ts);
+	zbx_mock_assert_int_eq("timestamp seconds", src->ts->sec, dst->ts->sec);
+	zbx_mock_assert_int_eq("timestamp nanoseconds", src->ts->ns, dst->ts->ns);
+	zbx_mock_assert_ptr_ne("result", NULL, dst->result);
+	zbx_mock_assert_int_eq("result type", src->result->type, dst->result->type);
+
+	if (0 != ZBX_ISSET_UI64(src->result))
+		zbx_mock_assert_uint64_eq("ui64", src->result->ui64, dst->result->ui64);
+
+	if (0 != ZBX_ISSET_DBL(src->result))
+		zbx_mock_assert_double_eq("dbl", src->result->dbl, dst->result->dbl);
+
+	if (0 != ZBX_ISSET_TEXT(src->result))
+		zbx_mock_assert_str_eq("text", src->result->text, dst->result->text);
+
+	if (0 != ZBX_ISSET_LOG(src->result))
+	{
+		zbx_mock_assert_str_eq("log value", src->result->log->value, dst->result->log->value);
+		zbx_mock_assert_str_eq("log source", src->result->log->source, dst->result->log->source);
+		zbx_mock_assert_int_eq("log timestamp", src->result->log->timestamp, dst->result->log->timestamp);
+		zbx_mock_assert_int_eq("log severity", src->result->log->severity, dst->result->log->severity);
+		zbx_mock_assert_int_eq("log eventid", src->result->log->logeventid, dst->result->log->logeventid);
+	}
+
+	if (0 != ZBX_ISSET_META(src->result))
+	{
+		zbx_mock_assert_uint64_eq("lastlogsize", src->result->lastlogsize, dst->result->lastlogsize);
+		zbx_mock_assert_int_eq("mtime", src->result->mtime, dst->result->mtime);
+	}
+}
+
+/* baseline - fixed size field encoding */
+
+static void	pp_bench_legacy_str_reserve(zbx_uint32_t *size, const char *str)
+{
+	*size += (zbx_uint32_t)sizeof(zbx_uint32_t) + (NULL != str ? (zbx_uint32_t)strlen(str) + 1 : 0);
+}
+
+static unsigned char	*pp_bench_legacy_str_pack(unsigned char *ptr, const char *str)
+{
+	zbx_uint32_t	len = (NULL != str ? (zbx_uint32_t)strlen(str) + 1 : 0);
+
+	return ptr + zbx_serialize_str(ptr, str, len);
+}
+
+static void	pp_bench_legacy_pack_value(zbx_ipc_message_t *message, const zbx_preproc_item_value_t *value)
+{
+	zbx_uint32_t	size = 8 + 8 + 3 + 1 + 1;
+	unsigned char	*ptr, ts_marker, result_marker, log_marker = 0;
+	AGENT_RESULT	*result = value->result;
+
+	ts_marker = (NULL != value->ts);
+	result_marker = (NULL != result);
+
+	pp_bench_legacy_str_reserve(&size, value->error);
+
+	if (NULL != value->ts)
+		size += 8;
+
+	if (NULL != result)
+	{
+		size += 8 + 8 + 8 + 4 + 4 + 1;
+		pp_bench_legacy_str_reserve(&size, result->str);
+		pp_bench_legacy_str_reserve(&size, result->text);
+		pp_bench_legacy_str_reserve(&size, result->msg);
+
+		if (NULL != result->log)
+		{
+			log_marker = 1;
+			pp_bench_legacy_str_reserve(&size, result->log->value);
+			pp_bench_legacy_str_reserve(&size, result->log->source);
+			size += 12;
+		}
+	}
+
+	message->data = (unsigned char *)zbx_realloc(message->data, message->size + size);
+	ptr = message->data + message->size;
+	message->size += size;
+
+	ptr += zbx_serialize_uint64(ptr, value->itemid);
+	ptr += zbx_serialize_uint64(ptr, value->hostid);
+	ptr += zbx_serialize_char(ptr, value->item_value_type);
+	ptr += zbx_serialize_char(ptr, value->item_flags);
+	ptr += zbx_serialize_char(ptr, value->state);
+	ptr = pp_bench_legacy_str_pack(ptr, value->error);
+	ptr += zbx_serialize_char(ptr, ts_marker);
+
+	if (NULL != value->ts)
+	{
+		ptr += zbx_serialize_int(ptr, value->ts->sec);
+		ptr += zbx_serialize_int(ptr, value->ts->ns);
+	}
+
+	ptr += zbx_serialize_char(ptr, result_marker);
+
+	if (NULL != result)
+	{
+		ptr += zbx_serialize_uint64(ptr, result->lastlogsize);
+		ptr += zbx_serialize_uint64(ptr, result->ui64);
+		ptr += zbx_serialize_double(ptr, result->dbl);
+		ptr = pp_bench_legacy_str_pack(ptr, result->str);
+		ptr = pp_bench_legacy_str_pack(ptr, result->text);
+		ptr = pp_bench_legacy_str_pack(ptr, result->msg);
+		ptr += zbx_serialize_int(ptr, result->type);
+		ptr += zbx_serialize_int(ptr, result->mtime);
+		ptr += zbx_serialize_char(ptr, log_marker);
+
+		if (0 != log_marker)
+		{
+			ptr = pp_bench_legacy_str_pack(ptr, result->log->value);
+			ptr = pp_bench_legacy_str_pack(ptr, result->log->source);
+			ptr += zbx_serialize_int(ptr, result->log->timestamp);
+			ptr += zbx_serialize_int(ptr, result->log->severity);
+			(void)zbx_serialize_int(ptr, result->log->logeventid);
+		}
+	}
+}
+
+static zbx_uint32_t	pp_bench_legacy_unpack_value(zbx_preproc_item_value_t *value, const unsigned char *data)
+{
+	zbx_uint32_t		value_len;
+	const unsigned char	*offset = data;
+	unsigned char		ts_marker, result_marker, log_marker;
+
+	offset += zbx_deserialize_uint64(offset, &value->itemid);
+	offset += zbx_deserialize_uint64(offset, &value->hostid);
+	offset += zbx_deserialize_char(offset, &value->item_value_type);
+	offset += zbx_deserialize_char(offset, &value->item_flags);
+	offset += zbx_deserialize_char(offset, &value->state);
+	offset += zbx_deserialize_str(offset, &value->error, value_len);
+	offset += zbx_deserialize_char(offset, &ts_marker);
+
+	value->ts = NULL;
+
+	if (0 != ts_marker)
+	{
+		value->ts = (zbx_timespec_t *)zbx_malloc(NULL, sizeof(zbx_timespec_t));
+		offset += zbx_deserialize_int(offset, &value->ts->sec);
+		offset += zbx_deserialize_int(offset, &value->ts->ns);
+	}
+
+	value->result = NULL;
+	offset += zbx_deserialize_char(offset, &result_marker);
+
+	if (0 != result_marker)
+	{
+		AGENT_RESULT	*result;
+
+		result = value->result = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT));
+		zbx_init_agent_result(result);
+
+		offset += zbx_deserialize_uint64(offset, &result->lastlogsize);
+		offset += zbx_deserialize_uint64(offset, &result->ui64);
+		offset += zbx_deserialize_double(offset, &result->dbl);
+		offset += zbx_deserialize_str(offset, &result->str, value_len);
+		offset += zbx_deserialize_str(offset, &result->text, value_len);
+		offset += zbx_deserialize_str(offset, &result->msg, value_len);
+		offset += zbx_deserialize_int(offset, &result->type);
+		offset += zbx_deserialize_int(offset, &result->mtime);
+		offset += zbx_deserialize_char(offset, &log_marker);
+
+		if (0 != log_marker)
+		{
+			result->log = (zbx_log_t *)zbx_malloc(NULL, sizeof(zbx_log_t));
+			offset += zbx_deserialize_str(offset, &result->log->value, value_len);
+			offset += zbx_deserialize_str(offset, &result->log->source, value_len);
+			offset += zbx_deserialize_int(offset, &result->log->timestamp);
+			offset += zbx_deserialize_int(offset, &result->log->severity);
+			offset += zbx_deserialize_int(offset, &result->log->logeventid);
+		}
+	}
+
+	return (zbx_uint32_t)(offset - data);
+}
+
+static void	pp_bench_value_clear(zbx_preproc_item_value_t *value, int free_ptrs)
+{
+	zbx_free(value->error);
+
+	if (NULL != value->result)
+	{
+		zbx_free_agent_result(value->result);
+
+		if (0 != free_ptrs)
+			zbx_free(value->result);
+	}
+
+	if (0 != free_ptrs)
+		zbx_free(value->ts);
+}
+
+static void	pp_bench_run_legacy(pp_bench_t *bench, pp_bench_result_t *res)
+{
+	zbx_ipc_message_t		message;
+	zbx_preproc_item_value_t	value;
+	double				sec;
+
+	memset(res, 0, sizeof(pp_bench_result_t));
+
+	for (int round = 0; round < bench->rounds; round++)
+	{
+		for (int i = 0; i < bench->values_num; i += bench->batch_size)
+		{
+			int	values_num = MIN(bench->batch_size, bench->values_num - i);
+
+			zbx_ipc_message_init(&message);
+
+			sec = zbx_time();
+
+			for (int j = 0; j < values_num; j++)
+				pp_bench_legacy_pack_value(&message, &bench->values[i + j]);
+
+			res->encode_sec += zbx_time() - sec;
+			res->size += message.size;
+
+			sec = zbx_time();
+
+			for (zbx_uint32_t offset = 0, j = 0; offset < message.size; j++)
+			{
+				offset += pp_bench_legacy_unpack_value(&value, message.data + offset);
+
+				if (0 == round)
+					pp_bench_value_compare(&bench->values[i + (int)j], &value);
+
+				pp_bench_value_clear(&value, 1);
+			}
+
+			res->decode_sec += zbx_time() - sec;
+
+			zbx_ipc_message_clean(&message);
+		}
+	}
+}
+
+static void	pp_bench_run(pp_bench_t *bench, pp_bench_result_t *res)
+{
+	zbx_ipc_message_t		message;
+	zbx_uint32_t			message_alloc = 0;
+	zbx_preproc_item_value_t	value;
+	zbx_pp_value_batch_t		batch;
+	double				sec;
+
+	memset(res, 0, sizeof(pp_bench_result_t));
+	zbx_ipc_message_init(&message);
+
+	for (int round = 0; round < bench->rounds; round++)
+	{
+		for (int i = 0; i < bench->values_num; i += bench->batch_size)
+		{
+			int	values_num = MIN(bench->batch_size, bench->values_num - i);
+
+			message.size = 0;
+			zbx_preprocessor_value_batch_init(&batch);
+
+			sec = zbx_time();
+
+			for (int j = 0; j < values_num; j++)
+			{
+				if (0 == zbx_preprocessor_pack_value(&message, &message_alloc, &batch,
+						&bench->values[i + j]))
+				{
+					fail_msg("cannot pack value");
+				}
+			}
+
+			res->encode_sec += zbx_time() - sec;
+			res->size += message.size;
+
+			zbx_preprocessor_value_batch_init(&batch);
+
+			sec = zbx_time();
+
+			for (zbx_uint32_t offset = 0, j = 0; offset < message.size; j++)
+			{
+				offset += zbx_preprocessor_unpack_value(&batch, &value, message.data + offset);
+
+				if (0 == round)
+					pp_bench_value_compare(&bench->values[i + (int)j], &value);
+
+				pp_bench_value_clear(&value, 0);
+			}
+
+			res->decode_sec += zbx_time() - sec;
+		}
+	}
+
+	zbx_ipc_message_clean(&message);
+}
+
+static void	pp_bench_print(const char *name, const pp_bench_t *bench, const pp_bench_result_t *res)
+{
+	double	values_num = (double)bench->values_num * bench->rounds;
+
+	printf("  %-8s %6.1f bytes/value, encode %6.1f ns/value, decode %6.1f ns/value\n", name,
+			(double)res->size / values_num, res->encode_sec * 1e9 / values_num,
+			res->decode_sec * 1e9 / values_num);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	pp_bench_t		bench;
+	pp_bench_result_t	res_legacy, res_compact;
+	const char		*kind;
+
+	ZBX_UNUSED(state);
+
+	kind = zbx_mock_get_parameter_string("in.value");
+	bench.value_kind = pp_bench_value_kind(kind);
+	bench.values_num = zbx_mock_get_parameter_int("in.values");
+	bench.batch_size = zbx_mock_get_parameter_int("in.batch");
+	bench.items_num = zbx_mock_get_parameter_int("in.items");
+	bench.rounds = zbx_mock_get_parameter_int("in.rounds");
+
+	pp_bench_values_create(&bench);
+
+	pp_bench_run_legacy(&bench, &res_legacy);
+	pp_bench_run(&bench, &res_compact);
+
+	printf("value:%s values:%d batch:%d items:%d rounds:%d\n", kind, bench.values_num, bench.batch_size,
+			bench.items_num, bench.rounds);
+	pp_bench_print("fixed", &bench, &res_legacy);
+	pp_bench_print("compact", &bench, &res_compact);
+
+	if (res_compact.size >= res_legacy.size)
+	{
+		fail_msg("compact encoding is not smaller: " ZBX_FS_UI64 " >= " ZBX_FS_UI64 " bytes",
+				res_compact.size, res_legacy.size);
+	}
+
+	pp_bench_values_free(&bench);
+}
@@ -0,0 +1,417 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxcommon.h"
+#include "zbxalgo.h"
+#include "zbxtime.h"
+#include "zbxpreproc.h"
+#include "zbxpreprocbase.h"
+#include "libs/zbxpreproc/pp_queue.h"
+#include "libs/zbxpreproc/pp_task.h"
+
+/* Preprocessing task queue microbenchmark.                                           */
+/*                                                                                    */
+/* Compares the task queue with the previous implementation, where manager and        */
+/* workers pushed and popped tasks with a single mutex locked. Manager is emulated by */
+/* the test thread, workers by threads doing a configurable amount of work per task.  */
+/* Values of the first serial_items items are queued as serial value tasks and their  */
+/* processing order is checked.                                                       */
+
+#define PP_BENCH_FINISHED_BATCH_SIZE	100
+
+typedef struct
+{
+	int		workers_num;
+	int		tasks_num;
+	int		batch_size;
+	int		items_num;
+	int		serial_items_num;
+	int		work;
+
+	zbx_pp_item_preproc_t	*preproc;
+	int			*last_seq;
+}
+pp_bench_t;
+
+/* baseline - mutex protected task queue */
+typedef struct
+{
+	zbx_list_t	pending;
+	zbx_list_t	finished;
+
+	pthread_mutex_t	lock;
+	pthread_cond_t	event;
+
+	zbx_uint64_t	pending_num;
+	int		stop;
+}
+pp_bench_locked_queue_t;
+
+typedef struct
+{
+	int		index;
+	int		stop;
+	int		work;
+	pthread_t	thread;
+
+	zbx_pp_queue_t			*queue;
+	pp_bench_locked_queue_t		*locked;
+}
+pp_bench_worker_t;
+
+static zbx_pp_task_t	*pp_bench_task_create(pp_bench_t *bench, int seq)
+{
+	zbx_pp_task_t		*task;
+	zbx_pp_task_value_t	*d;
+
+	task = (zbx_pp_task_t *)zbx_malloc(NULL, offsetof(zbx_pp_task_t, data) + sizeof(zbx_pp_task_value_t));
+	memset(task, 0, offsetof(zbx_pp_task_t, data) + sizeof(zbx_pp_task_value_t));
+
+	task->itemid = (zbx_uint64_t)(seq % bench->items_num);
+	task->type = ((int)task->itemid < bench->serial_items_num ? ZBX_PP_TASK_VALUE_SEQ : ZBX_PP_TASK_VALUE);
+
+	d = (zbx_pp_task_value_t *)PP_TASK_DATA(task);
+	d->preproc = bench->preproc;
+	d->ts.sec = seq;
+
+	return task;
+}
+
+static void	pp_bench_task_process(zbx_pp_task_t *task, int work)
+{
+	zbx_pp_task_value_t	*d;
+	volatile zbx_uint64_t	value;
+
+	if (ZBX_PP_TASK_SEQUENCE == task->type)
+	{
+		zbx_pp_task_sequence_t	*d_seq = (zbx_pp_task_sequence_t *)PP_TASK_DATA(task);
+
+		if (SUCCEED != zbx_list_peek(&d_seq->tasks, (void **)&task))
+			return;
+	}
+
+	d = (zbx_pp_task_value_t *)PP_TASK_DATA(task);
+	value = (zbx_uint64_t)d->ts.sec;
+
+	for (int i = 0; i < work; i++)
+		value = value * 6364136223846793005 + 1442695040888963407;
+
+	d->result.data.ui64 = value;
+}
+
+/* checks processing order and frees finished value task */
+static void	pp_bench_task_finish(pp_bench_t *bench, zbx_pp_task_t *task)
+{
+	zbx_pp_task_value_t	*d = (zbx_pp_task_value_t *)PP_TASK_DATA(task);
+
+	if (ZBX_PP_TASK_VALUE_SEQ == task->type)
+	{
+		if (bench->last_seq[task->itemid] >= d->ts.sec)
+		{
+			fail_msg("serial task of item " ZBX_FS_UI64 " processed out of order: %d after %d",
+					task->itemid, d->ts.sec, bench->last_seq[task->itemid]);
+		}
+
+		bench->last_seq[task->itemid] = d->ts.sec;
+	}
+
+	zbx_free(task);
+}
+
+static void	pp_bench_idle(void)
+{
+	struct timespec	ts = {0, 10000};
+
+	nanosleep(&ts, NULL);
+}
+
+static void	*pp_bench_locked_worker_entry(void *args)
+{
+	pp_bench_worker_t	*worker = (pp_bench_worker_t *)args;
+	pp_bench_locked_queue_t	*queue = worker->locked;
+	zbx_pp_task_t		*task;
+
+	pthread_mutex_lock(&queue->lock);
+
+	while (0 == queue->stop)
+	{
+		if (SUCCEED == zbx_list_pop(&queue->pending, (void **)&task))
+		{
+			queue->pending_num--;
+			pthread_mutex_unlock(&queue->lock);
+
+			pp_bench_task_process(task, worker->work);
+
+			pthread_mutex_lock(&queue->lock);
+			(void)zbx_list_append(&queue->finished, task, NULL);
+
+			continue;
+		}
+
+		pthread_cond_wait(&queue->event, &queue->lock);
+
+		if (1 < queue->pending_num)
+			pthread_cond_signal(&queue->event);
+	}
+
+	pthread_mutex_unlock(&queue->lock);
+
+	return NULL;
+}
+
+static double	pp_bench_run_locked(pp_bench_t *bench)
+{
+	pp_bench_locked_queue_t	queue;
+	pp_bench_worker_t	*workers;
+	zbx_pp_task_t		*task;
+	int			pushed_num = 0, finished_num = 0;
+	double			time_start;
+
+	zbx_list_create(&queue.pending);
+	zbx_list_create(&queue.finished);
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_cond_init(&queue.event, NULL);
+	queue.pending_num = 0;
+	queue.stop = 0;
+
+	workers = (pp_bench_worker_t *)zbx_calloc(NULL, (size_t)bench->workers_num, sizeof(pp_bench_worker_t));
+
+	for (int i = 0; i < bench->workers_num; i++)
+	{
+		workers[i].locked = &queue;
+		workers[i].work = bench->work;
+		zbx_mock_assert_int_eq("pthread_create()", 0, pthread_create(&workers[i].thread, NULL,
+				pp_bench_locked_worker_entry, &workers[i]));
+	}
+
+	time_start = zbx_time();
+
+	/* serial tasks are not supported by baseline queue, so all tasks are processed as parallel tasks */
+	while (finished_num < bench->tasks_num)
+	{
+		int	popped_num = 0;
+
+		pthread_mutex_lock(&queue.lock);
+
+		for (int i = 0; i < bench->batch_size && pushed_num < bench->tasks_num; i++)
+		{
+			task = pp_bench_task_create(bench, pushed_num++);
+			task->type = ZBX_PP_TASK_VALUE;
+			(void)zbx_list_append(&queue.pending, task, NULL);
+			queue.pending_num++;
+		}
+
+		pthread_cond_signal(&queue.event);
+
+		while (PP_BENCH_FINISHED_BATCH_SIZE > popped_num &&
+				SUCCEED == zbx_list_pop(&queue.finished, (void **)&task))
+		{
+			pp_bench_task_finish(bench, task);
+			finished_num++;
+			popped_num++;
+		}
+
+		pthread_mutex_unlock(&queue.lock);
+
+		if (0 == popped_num && pushed_num == bench->tasks_num)
+			pp_bench_idle();
+	}
+
+	time_start = zbx_time() - time_start;
+
+	pthread_mutex_lock(&queue.lock);
+	queue.stop = 1;
+	pthread_cond_broadcast(&queue.event);
+	pthread_mutex_unlock(&queue.lock);
+
+	for (int i = 0; i < bench->workers_num; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	zbx_free(workers);
+	zbx_list_destroy(&queue.pending);
+	zbx_list_destroy(&queue.finished);
+	pthread_mutex_destroy(&queue.lock);
+	pthread_cond_destroy(&queue.event);
+
+	return time_start;
+}
+
+static void	*pp_bench_worker_entry(void *args)
+{
+	pp_bench_worker_t	*worker = (pp_bench_worker_t *)args;
+	zbx_pp_queue_t		*queue = worker->queue;
+	zbx_pp_task_t		*task;
+	char			*error = NULL;
+
+	while (0 == worker->stop)
+	{
+		if (NULL != (task = pp_task_queue_pop_new(queue)))
+		{
+			pp_bench_task_process(task, worker->work);
+			(void)pp_task_queue_push_finished(queue, worker->index, task);
+
+			continue;
+		}
+
+		pp_task_queue_lock(queue);
+
+		if (0 == worker->stop && SUCCEED != pp_task_queue_wait(queue, &error))
+		{
+			zbx_free(error);
+			worker->stop = 1;
+		}
+
+		pp_task_queue_unlock(queue);
+	}
+
+	return NULL;
+}
+
+/* emulates manager handling of finished sequence task */
+static void	pp_bench_sequence_finish(pp_bench_t *bench, zbx_pp_queue_t *queue, zbx_pp_task_t *task_seq)
+{
+	zbx_pp_task_sequence_t	*d_seq = (zbx_pp_task_sequence_t *)PP_TASK_DATA(task_seq);
+	zbx_pp_task_t		*task;
+
+	if (SUCCEED == zbx_list_pop(&d_seq->tasks, (void **)&task))
+		pp_bench_task_finish(bench, task);
+
+	if (SUCCEED == zbx_list_peek(&d_seq->tasks, (void **)&task))
+	{
+		pp_task_queue_push_immediate(queue, task_seq);
+		pp_task_queue_notify(queue);
+	}
+	else
+	{
+		pp_task_queue_remove_sequence(queue, task_seq->itemid);
+		pp_task_free(task_seq);
+	}
+}
+
+static double	pp_bench_run(pp_bench_t *bench)
+{
+	zbx_pp_queue_t		queue;
+	pp_bench_worker_t	*workers;
+	zbx_pp_task_t		*task;
+	int			pushed_num = 0, finished_num = 0;
+	double			time_start;
+	char			*error = NULL;
+	zbx_uint64_t		pending_num, processing_num, finished_left_num;
+
+	memset(&queue, 0, sizeof(queue));
+
+	if (SUCCEED != pp_task_queue_init(&queue, bench->workers_num, &error))
+		fail_msg("cannot initialize task queue: %s", error);
+
+	workers = (pp_bench_worker_t *)zbx_calloc(NULL, (size_t)bench->workers_num, sizeof(pp_bench_worker_t));
+
+	for (int i = 0; i < bench->workers_num; i++)
+	{
+		workers[i].index = i;
+		workers[i].queue = &queue;
+		workers[i].work = bench->work;
+		zbx_mock_assert_int_eq("pthread_create()", 0, pthread_create(&workers[i].thread, NULL,
+				pp_bench_worker_entry, &workers[i]));
+	}
+
+	time_start = zbx_time();
+
+	while (finished_num < bench->tasks_num)
+	{
+		int	popped_num = 0;
+
+		for (int i = 0; i < bench->batch_size && pushed_num < bench->tasks_num; i++)
+			pp_task_queue_push(&queue, pp_bench_task_create(bench, pushed_num++));
+
+		pp_task_queue_notify(&queue);
+
+		while (PP_BENCH_FINISHED_BATCH_SIZE > popped_num && NULL != (task = pp_task_queue_pop_finished(&queue)))
+		{
+			if (ZBX_PP_TASK_SEQUENCE == task->type)
+				pp_bench_sequence_finish(bench, &queue, task);
+			else
+				pp_bench_task_finish(bench, task);
+
+			finished_num++;
+			popped_num++;
+		}
+
+		if (0 == popped_num && pushed_num == bench->tasks_num)
+			pp_bench_idle();
+	}
+
+	time_start = zbx_time() - time_start;
+
+	pp_task_queue_get_stats(&queue, &pending_num, &processing_num, &finished_left_num);
+	zbx_mock_assert_uint64_eq("pending tasks", 0, pending_num);
+	zbx_mock_assert_uint64_eq("processing tasks", 0, processing_num);
+	zbx_mock_assert_uint64_eq("finished tasks", 0, finished_left_num);
+	zbx_mock_assert_int_eq("task sequences", 0, queue.sequences.num_data);
+
+	pp_task_queue_lock(&queue);
+	for (int i = 0; i < bench->workers_num; i++)
+		workers[i].stop = 1;
+	pp_task_queue_unlock(&queue);
+
+	pp_task_queue_notify_all(&queue);
+
+	for (int i = 0; i < bench->workers_num; i++)
+		pthread_join(workers[i].thread, NULL);
+
+	zbx_free(workers);
+	pp_task_queue_destroy(&queue);
+
+	return time_start;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	pp_bench_t	bench;
+	double		time_locked, time_lockfree;
+
+	ZBX_UNUSED(state);
+
+	bench.workers_num = zbx_mock_get_parameter_int("in.workers");
+	bench.tasks_num = zbx_mock_get_parameter_int("in.tasks");
+	bench.batch_size = zbx_mock_get_parameter_int("in.batch");
+	bench.items_num = zbx_mock_get_parameter_int("in.items");
+	bench.serial_items_num = zbx_mock_get_parameter_int("in.serial_items");
+	bench.work = zbx_mock_get_parameter_int("in.work");
+
+	bench.preproc = zbx_pp_item_preproc_create(0, ITEM_TYPE_TRAPPER, ITEM_VALUE_TYPE_UINT64, 0);
+	bench.last_seq = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)bench.items_num);
+
+	for (int i = 0; i < bench.items_num; i++)
+		bench.last_seq[i] = -1;
+
+	time_locked = pp_bench_run_locked(&bench);
+
+	for (int i = 0; i < bench.items_num; i++)
+		bench.last_seq[i] = -1;
+
+	time_lockfree = pp_bench_run(&bench);
+
+	printf("workers:%d tasks:%d serial items:%d work:%d\n", bench.workers_num, bench.tasks_num,
+			bench.serial_items_num, bench.work);
+	printf("  locked queue:    %.3f sec, %.0f tasks/sec\n", time_locked, bench.tasks_num / time_locked);
+	printf("  lock-free queue: %.3f sec, %.0f tasks/sec\n", time_lockfree, bench.tasks_num / time_lockfree);
+
+	zbx_free(bench.last_seq);
+	zbx_pp_item_preproc_release(bench.preproc);
+}
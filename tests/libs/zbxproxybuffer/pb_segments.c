@@ -0,0 +1,317 @@
+/*
+** Copyright (C) 2001-2025 Zabbix SIA
+**
+** This program is free software: you can redistribute it and/or modify it under the terms of
+** the GNU Affero General Public License as published by the Free Software Foundation, version 3.
+**
+** This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+** without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+** See the GNU Affero General Public License for more details.
+**
+** You should have received a copy of the GNU Affero General Public License along with this program.
+** If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "../../../src/libs/zbxproxybuffer/pb_segment.c"
+
+#define MOCK_ROWS_MAX	100
+
+/* segment metadata is allocated in proxy buffer shared memory, use heap instead */
+void	*pb_malloc(size_t size)
+{
+	return zbx_malloc(NULL, size);
+}
+
+void	pb_free(void *ptr)
+{
+	zbx_free(ptr);
+}
+
+char	*pb_strdup(const char *str)
+{
+	return zbx_strdup(NULL, str);
+}
+
+static zbx_pb_segments_t	*mock_segments_create(const char *dir)
+{
+	zbx_pb_segments_t	*segs;
+	char			*error = NULL;
+
+	if (NULL == (segs = pb_segments_create(dir, zbx_mock_get_parameter_uint64("in.segment_size"),
+			zbx_mock_get_parameter_uint64("in.total_size"), zbx_mock_get_parameter_int("in.offline_buffer"),
+			&error)))
+	{
+		fail_msg("cannot create segment store: %s", error);
+	}
+
+	zbx_list_create(&segs->segments);
+
+	return segs;
+}
+
+static void	mock_segments_free(zbx_pb_segments_t *segs)
+{
+	zbx_pb_segment_t	*seg;
+
+	while (SUCCEED == zbx_list_pop(&segs->segments, (void **)&seg))
+		pb_free(seg);
+
+	zbx_list_destroy(&segs->segments);
+	pb_free(segs->dir);
+	pb_free(segs);
+
+	/* simulate process restart */
+	pb_segment_unmap_stale(UINT64_MAX);
+	memset(&segment_cursor, 0, sizeof(segment_cursor));
+}
+
+static void	mock_remove_dir(const char *path)
+{
+	DIR		*dir;
+	struct dirent	*entry;
+
+	if (NULL == (dir = opendir(path)))
+		return;
+
+	while (NULL != (entry = readdir(dir)))
+	{
+		char	*file;
+
+		if ('.' == *entry->d_name)
+			continue;
+
+		file = zbx_dsprintf(NULL, "%s/%s", path, entry->d_name);
+		(void)unlink(file);
+		zbx_free(file);
+	}
+
+	closedir(dir);
+	(void)rmdir(path);
+}
+
+static int	mock_get_optional_int(zbx_mock_handle_t hobject, const char *name, int default_value)
+{
+	zbx_mock_handle_t	hmember;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hobject, name, &hmember))
+		return default_value;
+
+	return zbx_mock_get_object_member_int(hobject, name);
+}
+
+static void	mock_append(zbx_pb_segments_t *segs, zbx_mock_handle_t hstep, time_t now)
+{
+	zbx_mock_handle_t	hrows, hrow;
+	int			expected;
+
+	expected = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "return"));
+	hrows = zbx_mock_get_object_member_handle(hstep, "rows");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hrows, &hrow))
+	{
+		zbx_pb_history_t	row;
+		int			size;
+
+		memset(&row, 0, sizeof(row));
+		row.id = zbx_mock_get_object_member_uint64(hrow, "id");
+		row.itemid = row.id + 1000;
+		row.ts.sec = (int)row.id;
+		row.ts.ns = (int)row.id;
+		row.write_clock = now - mock_get_optional_int(hrow, "age", 0);
+
+		/* value is generated from record id or with the requested size */
+		if (0 != (size = mock_get_optional_int(hrow, "size", 0)))
+		{
+			row.value = (char *)zbx_malloc(NULL, (size_t)size + 1);
+			memset(row.value, 'x', (size_t)size);
+			row.value[size] = '\0';
+		}
+		else
+			row.value = zbx_dsprintf(NULL, "value " ZBX_FS_UI64, row.id);
+
+		zbx_mock_assert_result_eq("pb_segments_append()", expected, pb_segments_append(segs, &row));
+		zbx_free(row.value);
+	}
+}
+
+static void	mock_read(zbx_pb_segments_t *segs, zbx_mock_handle_t hstep)
+{
+	zbx_vector_pb_segment_t	snapshot;
+	zbx_pb_history_t	rows[MOCK_ROWS_MAX];
+	zbx_vector_uint64_t	ids;
+	zbx_mock_handle_t	hids, hid;
+	int			rows_num, rows_max, i;
+	const char		*str;
+	char			value[64];
+
+	rows_max = zbx_mock_get_object_member_int(hstep, "rows_max");
+
+	if (MOCK_ROWS_MAX < rows_max)
+		fail_msg("too many rows requested");
+
+	zbx_vector_pb_segment_create(&snapshot);
+	pb_segments_snapshot(segs, &snapshot);
+	rows_num = pb_segments_read(segs, &snapshot, zbx_mock_get_object_member_uint64(hstep, "lastid"), rows,
+			rows_max);
+	zbx_vector_pb_segment_destroy(&snapshot);
+
+	zbx_vector_uint64_create(&ids);
+	hids = zbx_mock_get_object_member_handle(hstep, "ids");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hids, &hid))
+	{
+		zbx_uint64_t	id;
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_string(hid, &str) || SUCCEED != zbx_is_uint64(str, &id))
+			fail_msg("invalid record id");
+
+		zbx_vector_uint64_append(&ids, id);
+	}
+
+	zbx_mock_assert_int_eq("number of read records", ids.values_num, rows_num);
+
+	for (i = 0; i < rows_num; i++)
+	{
+		zbx_mock_assert_uint64_eq("record id", ids.values[i], rows[i].id);
+		zbx_mock_assert_uint64_eq("record itemid", rows[i].id + 1000, rows[i].itemid);
+		zbx_mock_assert_int_eq("record clock", (int)rows[i].id, rows[i].ts.sec);
+		zbx_mock_assert_int_eq("record ns", (int)rows[i].id, rows[i].ts.ns);
+		zbx_mock_assert_str_eq("record source", "", rows[i].source);
+
+		/* generated large values are not checked */
+		if ('x' != *rows[i].value)
+		{
+			zbx_snprintf(value, sizeof(value), "value " ZBX_FS_UI64, rows[i].id);
+			zbx_mock_assert_str_eq("record value", value, rows[i].value);
+		}
+	}
+
+	zbx_vector_uint64_destroy(&ids);
+}
+
+static void	mock_corrupt(zbx_pb_segments_t *segs, zbx_mock_handle_t hstep)
+{
+	zbx_uint64_t		seq, offset = sizeof(pb_segment_header_t);
+	int			record, i;
+	pb_segment_map_t	*map;
+	pb_segment_record_t	*rec;
+
+	seq = zbx_mock_get_object_member_uint64(hstep, "seq");
+	record = zbx_mock_get_object_member_int(hstep, "record");
+
+	if (NULL == (map = pb_segment_map(segs->dir, seq)))
+		fail_msg("cannot map segment " ZBX_FS_UI64, seq);
+
+	for (i = 0; i < record; i++)
+		offset += ((pb_segment_record_t *)(map->addr + offset))->size;
+
+	rec = (pb_segment_record_t *)(map->addr + offset);
+
+	if (0 == rec->size)
+		fail_msg("segment " ZBX_FS_UI64 " has no record #%d", seq, record);
+
+	/* damage record value, leaving record header intact */
+	*(char *)(rec + 1) ^= 0x01;
+}
+
+static void	mock_check_segments(zbx_pb_segments_t *segs, zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hsegs, hseg;
+	zbx_list_iterator_t	li;
+	zbx_pb_segment_t	*seg;
+	int			i = 0;
+
+	hsegs = zbx_mock_get_object_member_handle(hstep, "segments");
+	zbx_list_iterator_init(&segs->segments, &li);
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsegs, &hseg))
+	{
+		i++;
+
+		if (SUCCEED != zbx_list_iterator_next(&li))
+			fail_msg("expected segment #%d is missing", i);
+
+		(void)zbx_list_iterator_peek(&li, (void **)&seg);
+
+		zbx_mock_assert_uint64_eq("segment seq", zbx_mock_get_object_member_uint64(hseg, "seq"), seg->seq);
+		zbx_mock_assert_int_eq("segment records", zbx_mock_get_object_member_int(hseg, "records"),
+				seg->records_num);
+		zbx_mock_assert_uint64_eq("segment min id", zbx_mock_get_object_member_uint64(hseg, "min_id"),
+				seg->min_id);
+		zbx_mock_assert_uint64_eq("segment max id", zbx_mock_get_object_member_uint64(hseg, "max_id"),
+				seg->max_id);
+		zbx_mock_assert_int_eq("segment sorted", zbx_mock_get_object_member_int(hseg, "sorted"),
+				seg->sorted);
+	}
+
+	if (SUCCEED == zbx_list_iterator_next(&li))
+		fail_msg("there are more than %d segments", i);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_pb_segments_t	*segs;
+	zbx_mock_handle_t	hsteps, hstep;
+	char			dir[] = "/tmp/zbx_pb_segments_XXXXXX";
+	time_t			now;
+
+	ZBX_UNUSED(state);
+
+	if (NULL == mkdtemp(dir))
+		fail_msg("cannot create temporary directory: %s", zbx_strerror(errno));
+
+	now = time(NULL);
+	segs = mock_segments_create(dir);
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hsteps, &hstep))
+	{
+		const char	*op = zbx_mock_get_object_member_string(hstep, "op");
+
+		if (0 == strcmp(op, "append"))
+		{
+			mock_append(segs, hstep, now);
+		}
+		else if (0 == strcmp(op, "read"))
+		{
+			mock_read(segs, hstep);
+		}
+		else if (0 == strcmp(op, "reclaim"))
+		{
+			int	records_num;
+
+			records_num = pb_segments_reclaim(segs, zbx_mock_get_object_member_uint64(hstep, "lastid"),
+					now - zbx_mock_get_object_member_int(hstep, "expire_age"));
+			zbx_mock_assert_int_eq("pb_segments_reclaim()",
+					zbx_mock_get_object_member_int(hstep, "records"), records_num);
+		}
+		else if (0 == strcmp(op, "restart"))
+		{
+			zbx_uint64_t	maxid;
+
+			mock_segments_free(segs);
+			segs = mock_segments_create(dir);
+			pb_segments_recover(segs, zbx_mock_get_object_member_uint64(hstep, "lastid"), &maxid);
+			zbx_mock_assert_uint64_eq("pb_segments_recover() maxid",
+					zbx_mock_get_object_member_uint64(hstep, "maxid"), maxid);
+		}
+		else if (0 == strcmp(op, "corrupt"))
+		{
+			mock_corrupt(segs, hstep);
+		}
+		else if (0 == strcmp(op, "check"))
+		{
+			mock_check_segments(segs, hstep);
+		}
+		else
+			fail_msg("unknown operation '%s'", op);
+	}
+
+	mock_segments_free(segs);
+	mock_remove_dir(dir);
+}
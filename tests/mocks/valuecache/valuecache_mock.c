@@ -43,6 +43,7 @@ void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex);
 int	__wrap_zbx_shmem_create(zbx_shmem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
 		int allow_oom, char **error);
 void	__wrap_zbx_shmem_destroy(zbx_shmem_info_t *info);
+void	__wrap_zbx_shmem_slab_enable(zbx_shmem_info_t *info);
 void	*__wrap___zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, const void *old, size_t size);
 void	*__wrap___zbx_shmem_realloc(const char *file, int line, zbx_shmem_info_t *info, void *old, size_t size);
 void	__wrap___zbx_shmem_free(const char *file, int line, zbx_shmem_info_t *info, void *ptr);
@@ -54,6 +55,7 @@ void	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_
 int	__wrap_zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, int config_log_slow_queries, char **error);
 void	__wrap_zbx_elastic_version_extract(void);
 int	__wrap_zbx_elastic_version_get(void);
+int	__wrap_zbx_elastic_get_stats(zbx_history_storage_stats_t *stats);
 time_t	__wrap_time(time_t *ptr);
 void	__wrap_zbx_timespec(zbx_timespec_t *ts);
 
@@ -514,6 +516,11 @@ void	__wrap_zbx_shmem_destroy(zbx_shmem_info_t *info)
 	zbx_free(info);
 }
 
+void	__wrap_zbx_shmem_slab_enable(zbx_shmem_info_t *info)
+{
+	ZBX_UNUSED(info);
+}
+
 void	*__wrap___zbx_shmem_malloc(const char *file, int line, zbx_shmem_info_t *info, const void *old, size_t size)
 {
 	size_t	*psize;
@@ -672,6 +679,13 @@ int	__wrap_zbx_elastic_version_get(void)
 	return ZBX_DBVERSION_UNDEFINED;
 }
 
+int	__wrap_zbx_elastic_get_stats(zbx_history_storage_stats_t *stats)
+{
+	ZBX_UNUSED(stats);
+
+	return FAIL;
+}
+
 /*
  * cache allocator size limit handling
  */
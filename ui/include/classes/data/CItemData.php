@@ -362,6 +362,8 @@ final class CItemData {
 			'zabbix[boottime]',
 			'zabbix[connector_queue]',
 			'zabbix[discovery_queue]',
+			'zabbix[export,<mode>]',
+			'zabbix[history_storage,<mode>]',
 			'zabbix[host,,items]',
 			'zabbix[host,,items_unsupported]',
 			'zabbix[host,,maintenance]',
@@ -2787,6 +2789,20 @@ final class CItemData {
 					ITEM_TYPE_INTERNAL => 'config/items/itemtypes/internal#discovery.queue'
 				]
 			],
+			'zabbix[export,<mode>]' => [
+				'description' => _('Background export writer statistics. Valid modes are: written, bytes, dropped, dropped_bytes, waits, wait_time and queue.'),
+				'value_type' => null,
+				'documentation_link' => [
+					ITEM_TYPE_INTERNAL => 'config/items/itemtypes/internal'
+				]
+			],
+			'zabbix[history_storage,<mode>]' => [
+				'description' => _('History storage (Elasticsearch) write statistics. Valid modes are: requests, documents, bytes, retried, failed and latency.'),
+				'value_type' => null,
+				'documentation_link' => [
+					ITEM_TYPE_INTERNAL => 'config/items/itemtypes/internal'
+				]
+			],
 			'zabbix[host,,items]' => [
 				'description' => _('Number of enabled items on the host.'),
 				'value_type' => ITEM_VALUE_TYPE_UINT64,
@@ -2963,7 +2979,7 @@ final class CItemData {
 				]
 			],
 			'zabbix[tcache, cache, <parameter>]' => [
-				'description' => _('Trend function cache statistics. Valid parameters are: all, hits, phits, misses, pmisses, items, pitems and requests.'),
+				'description' => _('Trend function cache statistics. Valid parameters are: all, hits, phits, misses, pmisses, items, pitems, requests, rollups and rollup_hits.'),
 				'value_type' => null,
 				'documentation_link' => [
 					ITEM_TYPE_INTERNAL => 'config/items/itemtypes/internal#tcache'